@@ -276,6 +276,29 @@ GLAPI void GLAPIENTRY
 OSMesaColorClamp(GLboolean enable);
 
 
+
+/**
+ * Return the name, number of calls and time (in CPU cycles where
+ * available) of the index'th section of the current context's profile.
+ * The profile is only collected if the MESA_PROFILE environment variable
+ * is set.  Sections include the vertex pipeline stages, triangle functions
+ * and fragment span stages; some of them contain others.
+ * Return:  GL_FALSE if there's no such section.
+ * New in Mesa 7.3
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetProfileSection(GLint index, const char **name, GLuint *calls,
+                        GLdouble *cycles);
+
+
+/**
+ * Zero the counts of the current context's profile.
+ * New in Mesa 7.3
+ */
+GLAPI void GLAPIENTRY
+OSMesaResetProfile(void);
+
+
 #if defined(__BEOS__) || defined(__QUICKDRAW__)
 #pragma export off
 #endif
@@ -0,0 +1,163 @@
+/*
+ * Compare the FXT1 texture compressors.
+ *
+ * Compresses a few generated images with GL_TEXTURE_COMPRESSION_HINT set
+ * to GL_FASTEST (the default encoder) and GL_NICEST (the high quality one)
+ * and prints the compression speed and the PSNR of the decompressed
+ * texture against the original image (99 dB means no error).
+ *
+ * Usage: osfxt1 [image size]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define WIDTH 64
+#define HEIGHT 64
+
+static GLubyte Buffer[WIDTH * HEIGHT * 4];
+
+static const char *ImageNames[] = { "smooth", "photo", "alpha" };
+
+
+static double
+Seconds(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+static GLubyte
+Clamp(double x)
+{
+   return (GLubyte) (x < 0.0 ? 0.0 : (x > 255.0 ? 255.0 : x));
+}
+
+
+/**
+ * Smooth gradients, a noisy photo-like image, and an image with varying
+ * alpha and some transparent holes.
+ */
+static void
+MakeImage(GLubyte *image, int size, int kind)
+{
+   int x, y;
+
+   srand(1);
+   for (y = 0; y < size; y++) {
+      for (x = 0; x < size; x++) {
+         const double fx = (double) x / size, fy = (double) y / size;
+         const int noise = kind ? rand() % 21 - 10 : 0;
+         GLubyte *p = image + (y * size + x) * 4;
+
+         p[0] = Clamp(128 + 100 * sin(fx * 9) * cos(fy * 5) + noise);
+         p[1] = Clamp(90 + 80 * fy + 40 * sin(fx * fy * 30) + noise);
+         p[2] = Clamp(60 + 150 * fx * fx + noise);
+         p[3] = 255;
+         if (kind == 2) {
+            p[3] = Clamp(255 * (0.5 + 0.5 * cos(fx * 7 + fy * 11)));
+            if ((x / 8 + y / 4) % 11 == 3 && (x & 3) < 2)
+               p[0] = p[1] = p[2] = p[3] = 0;
+         }
+      }
+   }
+}
+
+
+static double
+Psnr(double sumSq, int count)
+{
+   if (sumSq == 0.0)
+      return 99.0;
+   return 10.0 * log10(255.0 * 255.0 * count / sumSq);
+}
+
+
+static void
+Test(const GLubyte *image, GLubyte *result, int size, GLenum format,
+     GLenum hint)
+{
+   const int n = size * size;
+   double start, seconds, rgbErr = 0.0, alphaErr = 0.0;
+   int i, k, reps = 0;
+
+   glHint(GL_TEXTURE_COMPRESSION_HINT, hint);
+
+   start = Seconds();
+   do {
+      glTexImage2D(GL_TEXTURE_2D, 0, format, size, size, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, image);
+      reps++;
+      seconds = Seconds() - start;
+   } while (seconds < 1.0);
+
+   glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, result);
+   for (i = 0; i < n * 4; i += 4) {
+      for (k = 0; k < 3; k++) {
+         const int d = result[i + k] - image[i + k];
+         rgbErr += d * d;
+      }
+      alphaErr += (result[i + 3] - image[i + 3]) * (result[i + 3] - image[i + 3]);
+   }
+
+   printf("  %-4s %-8s %7.1f Mtexels/s   RGB %5.2f dB",
+          format == GL_COMPRESSED_RGB_FXT1_3DFX ? "RGB" : "RGBA",
+          hint == GL_FASTEST ? "fastest" : "nicest",
+          (double) n * reps / seconds * 1e-6, Psnr(rgbErr, n * 3));
+   if (format == GL_COMPRESSED_RGBA_FXT1_3DFX)
+      printf("   alpha %5.2f dB", Psnr(alphaErr, n));
+   printf("\n");
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   static const GLenum formats[2] = {
+      GL_COMPRESSED_RGB_FXT1_3DFX, GL_COMPRESSED_RGBA_FXT1_3DFX
+   };
+   const int size = argc > 1 ? atoi(argv[1]) : 512;
+   OSMesaContext ctx;
+   GLubyte *image, *result;
+   GLuint tex;
+   int kind, f;
+
+   ctx = OSMesaCreateContext(OSMESA_RGBA, NULL);
+   if (!ctx || !OSMesaMakeCurrent(ctx, Buffer, GL_UNSIGNED_BYTE,
+                                  WIDTH, HEIGHT)) {
+      printf("OSMesaCreateContext failed!\n");
+      return 1;
+   }
+
+   image = (GLubyte *) malloc(size * size * 4);
+   result = (GLubyte *) malloc(size * size * 4);
+   if (size <= 0 || !image || !result) {
+      printf("Out of memory!\n");
+      return 1;
+   }
+
+   glGenTextures(1, &tex);
+   glBindTexture(GL_TEXTURE_2D, tex);
+
+   for (kind = 0; kind < 3; kind++) {
+      printf("%s %dx%d:\n", ImageNames[kind], size, size);
+      MakeImage(image, size, kind);
+      for (f = (kind == 2); f < 2; f++) {
+         Test(image, result, size, formats[f], GL_FASTEST);
+         Test(image, result, size, formats[f], GL_NICEST);
+      }
+   }
+
+   glDeleteTextures(1, &tex);
+   free(image);
+   free(result);
+   OSMesaDestroyContext(ctx);
+   return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Measure the cost of looking up GL object names.
+ *
+ * Creates many texture objects and display lists, then times binding
+ * the textures and calling the lists in random order, and deleting them.
+ * This mostly exercises Mesa's object name hash tables.
+ *
+ * Usage: osnames [number of names]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "GL/osmesa.h"
+
+
+#define WIDTH 64
+#define HEIGHT 64
+
+
+static double
+Seconds(clock_t start)
+{
+   return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static void
+TestTextures(GLuint numNames, GLuint numOps)
+{
+   GLuint *names = (GLuint *) malloc(numNames * sizeof(GLuint));
+   clock_t start;
+   GLuint i;
+
+   start = clock();
+   glGenTextures(numNames, names);
+   for (i = 0; i < numNames; i++)
+      glBindTexture(GL_TEXTURE_2D, names[i]);
+   printf("  create %u textures:     %.3f s\n", numNames, Seconds(start));
+
+   start = clock();
+   for (i = 0; i < numOps; i++)
+      glBindTexture(GL_TEXTURE_2D, names[rand() % numNames]);
+   printf("  %u random binds:   %.3f s\n", numOps, Seconds(start));
+
+   start = clock();
+   for (i = 0; i < numOps; i++)
+      (void) glIsTexture(names[rand() % numNames]);
+   printf("  %u glIsTexture:    %.3f s\n", numOps, Seconds(start));
+
+   start = clock();
+   glBindTexture(GL_TEXTURE_2D, 0);
+   glDeleteTextures(numNames, names);
+   printf("  delete textures:          %.3f s\n", Seconds(start));
+
+   free(names);
+}
+
+
+static void
+TestLists(GLuint numNames, GLuint numOps)
+{
+   clock_t start;
+   GLuint base, i;
+
+   start = clock();
+   base = glGenLists(numNames);
+   for (i = 0; i < numNames; i++) {
+      glNewList(base + i, GL_COMPILE);
+      glColor3f(1.0, 0.0, 0.0);
+      glEndList();
+   }
+   printf("  create %u lists:        %.3f s\n", numNames, Seconds(start));
+
+   start = clock();
+   for (i = 0; i < numOps; i++)
+      glCallList(base + rand() % numNames);
+   printf("  %u random calls:   %.3f s\n", numOps, Seconds(start));
+
+   start = clock();
+   glDeleteLists(base, numNames);
+   printf("  delete lists:             %.3f s\n", Seconds(start));
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   GLuint numNames = argc > 1 ? atoi(argv[1]) : 100000;
+   GLuint numOps = 1000000;
+   OSMesaContext ctx;
+   void *buffer;
+
+   if (numNames < 1)
+      numNames = 1;
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 16, 0, 0, NULL);
+   if (!ctx) {
+      printf("OSMesaCreateContext failed!\n");
+      return 0;
+   }
+
+   buffer = malloc(WIDTH * HEIGHT * 4 * sizeof(GLubyte));
+   if (!buffer) {
+      printf("Alloc image buffer failed!\n");
+      return 0;
+   }
+
+   if (!OSMesaMakeCurrent(ctx, buffer, GL_UNSIGNED_BYTE, WIDTH, HEIGHT)) {
+      printf("OSMesaMakeCurrent failed!\n");
+      return 0;
+   }
+
+   printf("Texture objects:\n");
+   TestTextures(numNames, numOps);
+
+   printf("Display lists:\n");
+   TestLists(numNames, numOps);
+
+   free(buffer);
+   OSMesaDestroyContext(ctx);
+
+   return 0;
+}
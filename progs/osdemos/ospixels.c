@@ -0,0 +1,168 @@
+/*
+ * Measure glDrawPixels, glReadPixels and glTexImage2D speed for the
+ * format/type pairs which Mesa converts to and from 8-bit RGBA directly.
+ *
+ * The formats and types are the ones of the ubyte_formats[] and
+ * ubyte_types[] tables in src/mesa/main/image.c.  Every combination is
+ * tried, with and without byte swapping for the packed types.  Pairs
+ * which aren't legal in GL are reported and skipped.
+ *
+ * Usage: ospixels [image size]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define SIZE 512
+#define MIN_SECONDS 0.2
+
+static GLubyte Buffer[SIZE * SIZE * 4];
+
+struct name {
+   GLenum value;
+   const char *name;
+};
+
+static const struct name Formats[] = {
+   { GL_RGB, "RGB" },
+   { GL_BGR, "BGR" },
+   { GL_RGBA, "RGBA" },
+   { GL_BGRA, "BGRA" },
+   { GL_ABGR_EXT, "ABGR" }
+};
+
+static const struct name Types[] = {
+   { GL_UNSIGNED_BYTE, "UNSIGNED_BYTE" },
+   { GL_UNSIGNED_INT_8_8_8_8, "8_8_8_8" },
+   { GL_UNSIGNED_INT_8_8_8_8_REV, "8_8_8_8_REV" },
+   { GL_UNSIGNED_SHORT_5_6_5, "5_6_5" },
+   { GL_UNSIGNED_SHORT_5_6_5_REV, "5_6_5_REV" },
+   { GL_UNSIGNED_SHORT_4_4_4_4, "4_4_4_4" },
+   { GL_UNSIGNED_SHORT_4_4_4_4_REV, "4_4_4_4_REV" },
+   { GL_UNSIGNED_SHORT_5_5_5_1, "5_5_5_1" },
+   { GL_UNSIGNED_SHORT_1_5_5_5_REV, "1_5_5_5_REV" }
+};
+
+
+static double
+Seconds(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+/** Mpixels/s of an operation on size x size images */
+static double
+Rate(int op, GLenum format, GLenum type, int size, GLubyte *image)
+{
+   double start = Seconds(), seconds;
+   int reps = 0;
+
+   do {
+      switch (op) {
+      case 0:
+         glDrawPixels(size, size, format, type, image);
+         break;
+      case 1:
+         glReadPixels(0, 0, size, size, format, type, image);
+         break;
+      default:
+         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0,
+                      format, type, image);
+      }
+      glFinish();
+      reps++;
+      seconds = Seconds() - start;
+   } while (seconds < MIN_SECONDS);
+
+   return (double) size * size * reps / seconds * 1e-6;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   const int size = argc > 1 ? atoi(argv[1]) : SIZE;
+   OSMesaContext ctx;
+   GLubyte *image;
+   GLuint f, t, i, swap, tested = 0, illegal = 0;
+
+   if (size <= 0 || size > SIZE) {
+      printf("The image size must be 1 to %d\n", SIZE);
+      return 1;
+   }
+
+   ctx = OSMesaCreateContext(OSMESA_RGBA, NULL);
+   if (!ctx || !OSMesaMakeCurrent(ctx, Buffer, GL_UNSIGNED_BYTE,
+                                  SIZE, SIZE)) {
+      printf("OSMesaCreateContext failed!\n");
+      return 1;
+   }
+
+   image = (GLubyte *) malloc(size * size * 4);
+   if (!image) {
+      printf("Out of memory!\n");
+      return 1;
+   }
+   for (i = 0; i < (GLuint) (size * size * 4); i++)
+      image[i] = (GLubyte) rand();
+
+   glViewport(0, 0, SIZE, SIZE);
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   glOrtho(0, SIZE, 0, SIZE, -1, 1);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadIdentity();
+   glRasterPos2i(0, 0);
+   glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+   printf("%dx%d images, Mpixels/s:\n", size, size);
+   printf("%-5s %-12s %-4s %9s %9s %9s\n",
+          "", "", "", "drawpix", "readpix", "teximage");
+
+   for (f = 0; f < sizeof(Formats) / sizeof(Formats[0]); f++) {
+      for (t = 0; t < sizeof(Types) / sizeof(Types[0]); t++) {
+         const GLenum format = Formats[f].value, type = Types[t].value;
+
+         /* check that the pair is legal */
+         while (glGetError() != GL_NO_ERROR)
+            ;
+         glReadPixels(0, 0, 1, 1, format, type, image);
+         if (glGetError() != GL_NO_ERROR) {
+            printf("%-5s %-12s      not legal\n",
+                   Formats[f].name, Types[t].name);
+            illegal++;
+            continue;
+         }
+
+         /* byte swapping makes no difference for GL_UNSIGNED_BYTE */
+         for (swap = 0; swap < (type == GL_UNSIGNED_BYTE ? 1u : 2u); swap++) {
+            glPixelStorei(GL_PACK_SWAP_BYTES, swap);
+            glPixelStorei(GL_UNPACK_SWAP_BYTES, swap);
+            printf("%-5s %-12s %-4s", Formats[f].name, Types[t].name,
+                   swap ? "swap" : "");
+            for (i = 0; i < 3; i++)
+               printf(" %9.1f", Rate(i, format, type, size, image));
+            printf("\n");
+            tested++;
+         }
+      }
+   }
+   glPixelStorei(GL_PACK_SWAP_BYTES, GL_FALSE);
+   glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+
+   printf("%u combinations tested, %u format/type pairs not legal\n",
+          tested, illegal);
+
+   free(image);
+   OSMesaDestroyContext(ctx);
+   return 0;
+}
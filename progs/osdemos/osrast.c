@@ -0,0 +1,296 @@
+/*
+ * Compare the half-space triangle rasterizer against the scanline one.
+ *
+ * Two contexts are created, the second one with MESA_SWRAST_HALFSPACE
+ * set.  Both draw the same scenes and the results are compared:
+ *
+ *  - meshes of triangles sharing edges and vertices, drawn with additive
+ *    blending, must cover each pixel inside the mesh exactly once;
+ *  - single random triangles must cover exactly the same pixels: both
+ *    rasterizers use the snapped vertex coords, include the pixels whose
+ *    centers are on a left or bottom edge and exclude those on a right or
+ *    top edge;
+ *  - smooth shaded, textured, fogged and depth tested scenes must match
+ *    to within one color unit, the rounding difference between stepping
+ *    the interpolants along a span and evaluating them at each pixel.
+ *
+ * Usage: osrast [number of random triangles]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "GL/osmesa.h"
+
+
+#define WIDTH 128
+#define HEIGHT 128
+
+static OSMesaContext Ctx[2];
+static GLubyte *Buffer[2];
+static int Failures = 0;
+
+
+static float
+Random(float min, float max)
+{
+   return min + (max - min) * (rand() / (float) RAND_MAX);
+}
+
+
+static void
+MakeCurrent(int i)
+{
+   if (!OSMesaMakeCurrent(Ctx[i], Buffer[i], GL_UNSIGNED_BYTE,
+                          WIDTH, HEIGHT)) {
+      printf("OSMesaMakeCurrent failed!\n");
+      exit(1);
+   }
+   glViewport(0, 0, WIDTH, HEIGHT);
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   glOrtho(0, WIDTH, 0, HEIGHT, -1, 1);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadIdentity();
+}
+
+
+/**
+ * Draw a grid of jittered quads and a triangle fan with additive blending.
+ * Every pixel must be covered at most once, and exactly once inside.
+ */
+static void
+TestWatertight(int i, unsigned seed)
+{
+   static const GLubyte one[4] = { 1, 1, 1, 1 };
+   GLfloat grid[9][9][2];
+   int x, y, holes = 0, overlaps = 0;
+
+   MakeCurrent(i);
+   srand(seed);
+
+   for (y = 0; y < 9; y++) {
+      for (x = 0; x < 9; x++) {
+         grid[y][x][0] = x * 12.0 + 10 + (x > 0 && x < 8 ? Random(-5, 5) : 0);
+         grid[y][x][1] = y * 12.0 + 10 + (y > 0 && y < 8 ? Random(-5, 5) : 0);
+      }
+   }
+
+   glClearColor(0, 0, 0, 0);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_ONE, GL_ONE);
+   glColor4ubv(one);
+
+   for (y = 0; y < 8; y++) {
+      glBegin(GL_TRIANGLE_STRIP);
+      for (x = 0; x < 9; x++) {
+         glVertex2fv(grid[y + 1][x]);
+         glVertex2fv(grid[y][x]);
+      }
+      glEnd();
+   }
+   glFinish();
+
+   /* the border of the grid is straight, between 10 and 106 */
+   for (y = 0; y < HEIGHT; y++) {
+      for (x = 0; x < WIDTH; x++) {
+         const GLubyte c = Buffer[i][(y * WIDTH + x) * 4];
+         const int inside = x >= 10 && x < 106 && y >= 10 && y < 106;
+         if (c > 1 || (c == 1 && !inside))
+            overlaps++;
+         else if (c == 0 && inside)
+            holes++;
+      }
+   }
+
+   /* a fan of thin triangles around a point */
+   glClear(GL_COLOR_BUFFER_BIT);
+   glBegin(GL_TRIANGLE_FAN);
+   glVertex2f(63.3f, 64.7f);
+   for (x = 0; x <= 97; x++) {
+      const float a = x * 2.0f * 3.14159265f / 97;
+      glVertex2f(63.3f + 50.0f * (float) cos(a), 64.7f + 50.0f * (float) sin(a));
+   }
+   glEnd();
+   glFinish();
+   glDisable(GL_BLEND);
+
+   for (y = 0; y < HEIGHT * WIDTH; y++) {
+      if (Buffer[i][y * 4] > 1)
+         overlaps++;
+   }
+
+   printf("  %s: %d overlapping, %d missing pixels\n",
+          i ? "half-space" : "scanline  ", overlaps, holes);
+   if (overlaps || holes)
+      Failures++;
+}
+
+
+static int
+CountDifferences(int tolerance)
+{
+   int j, count = 0;
+
+   for (j = 0; j < WIDTH * HEIGHT * 4; j += 4) {
+      int c;
+      for (c = 0; c < 4; c++) {
+         if (abs(Buffer[0][j + c] - Buffer[1][j + c]) > tolerance) {
+            count++;
+            break;
+         }
+      }
+   }
+   return count;
+}
+
+
+/**
+ * Draw random triangles one at a time and compare the covered pixels.
+ */
+static void
+TestCoverage(int numTris)
+{
+   int t, i, differ = 0, pixels = 0;
+
+   for (t = 0; t < numTris; t++) {
+      GLfloat v[6];
+      int k, d;
+
+      for (k = 0; k < 6; k++) {
+         v[k] = Random(-10, WIDTH + 10);
+         if (t % 3 == 0)
+            v[k] = floor(v[k] * 2) * 0.5;  /* on pixel edges and centers */
+      }
+
+      for (i = 0; i < 2; i++) {
+         MakeCurrent(i);
+         glClear(GL_COLOR_BUFFER_BIT);
+         glColor3f(1, 1, 1);
+         glBegin(GL_TRIANGLES);
+         glVertex2fv(v);
+         glVertex2fv(v + 2);
+         glVertex2fv(v + 4);
+         glEnd();
+         glFinish();
+      }
+
+      d = CountDifferences(0);
+      if (d) {
+         differ++;
+         pixels += d;
+      }
+   }
+
+   printf("  %d of %d triangles differ, by %.2f pixels on average\n",
+          differ, numTris, differ ? (float) pixels / differ : 0.0f);
+   if (differ)
+      Failures++;
+}
+
+
+/**
+ * Draw the same shaded scene in both contexts and compare the images.
+ */
+static void
+TestScene(const char *name, int texture, int fog, int depth)
+{
+   static GLubyte image[16][16][4];
+   int i, t, d;
+
+   for (t = 0; t < 16 * 16; t++) {
+      image[t / 16][t % 16][0] = (t * 37) & 0xff;
+      image[t / 16][t % 16][1] = (t * 91) & 0xff;
+      image[t / 16][t % 16][2] = t & 0xff;
+      image[t / 16][t % 16][3] = 0xff;
+   }
+
+   for (i = 0; i < 2; i++) {
+      MakeCurrent(i);
+      srand(1);
+
+      glClearColor(0.2f, 0.3f, 0.4f, 0);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      glShadeModel(GL_SMOOTH);
+      if (texture) {
+         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0,
+                      GL_RGBA, GL_UNSIGNED_BYTE, image);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+         glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+         glEnable(GL_TEXTURE_2D);
+      }
+      if (fog) {
+         glFogi(GL_FOG_MODE, GL_LINEAR);
+         glFogf(GL_FOG_START, 0.0f);
+         glFogf(GL_FOG_END, 1.0f);
+         glEnable(GL_FOG);
+      }
+      if (depth)
+         glEnable(GL_DEPTH_TEST);
+
+      glBegin(GL_TRIANGLES);
+      for (t = 0; t < 300; t++) {
+         const float cx = Random(0, WIDTH), cy = Random(0, HEIGHT);
+         int k;
+         for (k = 0; k < 3; k++) {
+            glColor3f(Random(0, 1), Random(0, 1), Random(0, 1));
+            glTexCoord4f(Random(0, 2), Random(0, 2), 0, 1);
+            glVertex3f(cx + Random(-20, 20), cy + Random(-20, 20),
+                       Random(-1, 1));
+         }
+      }
+      glEnd();
+      glFinish();
+
+      glDisable(GL_TEXTURE_2D);
+      glDisable(GL_FOG);
+      glDisable(GL_DEPTH_TEST);
+   }
+
+   d = CountDifferences(1);
+   printf("  %-28s %5d of %d pixels differ\n", name, d, WIDTH * HEIGHT);
+   if (d)
+      Failures++;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   int numTris = argc > 1 ? atoi(argv[1]) : 10000;
+   int i;
+
+   for (i = 0; i < 2; i++) {
+      if (i == 1)
+         putenv("MESA_SWRAST_HALFSPACE=1");
+      Ctx[i] = OSMesaCreateContextExt(OSMESA_RGBA, 16, 0, 0, NULL);
+      Buffer[i] = (GLubyte *) malloc(WIDTH * HEIGHT * 4);
+      if (!Ctx[i] || !Buffer[i]) {
+         printf("OSMesaCreateContext failed!\n");
+         return 1;
+      }
+   }
+
+   printf("Shared edges and vertices:\n");
+   TestWatertight(0, 1);
+   TestWatertight(1, 1);
+
+   printf("Coverage of random triangles:\n");
+   TestCoverage(numTris);
+
+   printf("Shaded scenes:\n");
+   TestScene("smooth shading", 0, 0, 0);
+   TestScene("smooth shading, depth test", 0, 0, 1);
+   TestScene("texture, fog, depth test", 1, 1, 1);
+
+   for (i = 0; i < 2; i++) {
+      OSMesaDestroyContext(Ctx[i]);
+      free(Buffer[i]);
+   }
+
+   printf("%s\n", Failures ? "FAILED" : "PASSED");
+   return Failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Check that state changes aren't lost by the state filter.
+ *
+ * Mesa drops a state group's _NEW_* flag at validation time when the
+ * group compares equal to its copy from the last validation.  State
+ * which is outside of the groups but signalled with their flags has to
+ * bypass that filter.  Each case below validates the state with a draw,
+ * changes something and checks the next draw.  Run it with and without
+ * MESA_NO_STATE_FILTER set; the results must be the same.
+ *
+ * Usage: osstate
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define GL_GLEXT_PROTOTYPES
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define WIDTH 64
+#define HEIGHT 64
+
+static GLubyte Buffer[WIDTH * HEIGHT * 4];
+static int Failures = 0;
+
+
+static void
+Check(const char *name, GLuint result, GLuint expected)
+{
+   printf("  %-40s %6u (expected %u)\n", name, result, expected);
+   if (result != expected)
+      Failures++;
+}
+
+
+/** Draw a w x h pixel rectangle at the window's origin */
+static void
+DrawRect(int w, int h)
+{
+   glBegin(GL_QUADS);
+   glVertex2i(0, 0);
+   glVertex2i(w, 0);
+   glVertex2i(w, h);
+   glVertex2i(0, h);
+   glEnd();
+}
+
+
+/**
+ * Occlusion queries: the current query object isn't in ctx->Depth, but
+ * glBeginQuery and glEndQuery signal it with _NEW_DEPTH.
+ */
+static void
+TestOcclusionQuery(void)
+{
+   GLuint query, result;
+
+   glGenQueriesARB(1, &query);
+
+   /* validate the state before the query begins */
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   DrawRect(8, 8);
+   glFinish();
+
+   glBeginQueryARB(GL_SAMPLES_PASSED_ARB, query);
+   DrawRect(40, 52);
+   glEndQueryARB(GL_SAMPLES_PASSED_ARB);
+   glGetQueryObjectuivARB(query, GL_QUERY_RESULT_ARB, &result);
+   Check("samples passed", result, 40 * 52);
+
+   /* the same with depth testing, half of the rectangle is hidden */
+   glEnable(GL_DEPTH_TEST);
+   glClear(GL_DEPTH_BUFFER_BIT);
+   glBegin(GL_QUADS);
+   glVertex3f(0, 0, 0.5f);
+   glVertex3f(20, 0, 0.5f);
+   glVertex3f(20, HEIGHT, 0.5f);
+   glVertex3f(0, HEIGHT, 0.5f);
+   glEnd();
+   glFinish();
+
+   glBeginQueryARB(GL_SAMPLES_PASSED_ARB, query);
+   DrawRect(40, 52);
+   glEndQueryARB(GL_SAMPLES_PASSED_ARB);
+   glGetQueryObjectuivARB(query, GL_QUERY_RESULT_ARB, &result);
+   Check("samples passed, depth tested", result, 20 * 52);
+   glDisable(GL_DEPTH_TEST);
+
+   /* nothing may be counted once the query has ended */
+   DrawRect(WIDTH, HEIGHT);
+   glFinish();
+   glGetQueryObjectuivARB(query, GL_QUERY_RESULT_ARB, &result);
+   Check("samples passed after the query", result, 20 * 52);
+
+   glDeleteQueriesARB(1, &query);
+}
+
+
+/**
+ * Count the pixels of the color buffer which aren't black.
+ */
+static GLuint
+CountPixels(void)
+{
+   GLuint i, count = 0;
+   for (i = 0; i < WIDTH * HEIGHT; i++) {
+      if (Buffer[i * 4] || Buffer[i * 4 + 1] || Buffer[i * 4 + 2])
+         count++;
+   }
+   return count;
+}
+
+
+/**
+ * State changes which are undone before the next draw may be dropped,
+ * changes which aren't undone must not be.
+ */
+static void
+TestToggles(void)
+{
+   glClear(GL_COLOR_BUFFER_BIT);
+   DrawRect(8, 8);
+   glFinish();
+
+   /* undone: the scissor box doesn't apply */
+   glEnable(GL_SCISSOR_TEST);
+   glScissor(0, 0, 4, 4);
+   glScissor(0, 0, WIDTH, HEIGHT);
+   glDisable(GL_SCISSOR_TEST);
+   glClear(GL_COLOR_BUFFER_BIT);
+   DrawRect(30, 30);
+   glFinish();
+   Check("scissor enabled and disabled", CountPixels(), 30 * 30);
+
+   /* not undone */
+   glClear(GL_COLOR_BUFFER_BIT);
+   glEnable(GL_SCISSOR_TEST);
+   glScissor(0, 0, 10, 10);
+   DrawRect(30, 30);
+   glFinish();
+   Check("scissor enabled", CountPixels(), 10 * 10);
+   glDisable(GL_SCISSOR_TEST);
+
+   /* culled, then the cull face changed back and forth */
+   glEnable(GL_CULL_FACE);
+   glCullFace(GL_FRONT);
+   glClear(GL_COLOR_BUFFER_BIT);
+   DrawRect(30, 30);
+   glFinish();
+   Check("front faces culled", CountPixels(), 0);
+
+   glCullFace(GL_BACK);
+   glCullFace(GL_FRONT);
+   glCullFace(GL_BACK);
+   glClear(GL_COLOR_BUFFER_BIT);
+   DrawRect(30, 30);
+   glFinish();
+   Check("back faces culled", CountPixels(), 30 * 30);
+   glDisable(GL_CULL_FACE);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   OSMesaContext ctx;
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 16, 0, 0, NULL);
+   if (!ctx || !OSMesaMakeCurrent(ctx, Buffer, GL_UNSIGNED_BYTE,
+                                  WIDTH, HEIGHT)) {
+      printf("OSMesaCreateContext failed!\n");
+      return 1;
+   }
+
+   glViewport(0, 0, WIDTH, HEIGHT);
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   glOrtho(0, WIDTH, 0, HEIGHT, -1, 1);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadIdentity();
+   glClearColor(0, 0, 0, 0);
+   glColor3f(1, 1, 1);
+
+   printf("Occlusion queries:\n");
+   TestOcclusionQuery();
+
+   printf("Undone and kept state changes:\n");
+   TestToggles();
+
+   OSMesaDestroyContext(ctx);
+
+   printf("%s\n", Failures ? "FAILED" : "PASSED");
+   return Failures ? 1 : 0;
+}
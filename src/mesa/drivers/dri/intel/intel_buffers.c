@@ -37,6 +37,7 @@
 #include "intel_reg.h"
 #include "main/context.h"
 #include "main/framebuffer.h"
+#include "main/state.h"
 #include "swrast/swrast.h"
 #include "utils.h"
 #include "drirenderbuffer.h"
@@ -632,7 +633,7 @@ intel_draw_buffer(GLcontext * ctx, struct gl_framebuffer *fb)
    if (ctx->Driver.FrontFace)
       ctx->Driver.FrontFace(ctx, ctx->Polygon.FrontFace);
    else
-      ctx->NewState |= _NEW_POLYGON;
+      _mesa_invalidate_state(ctx, _NEW_POLYGON);
 
    if (!colorRegions[0]) {
       FALLBACK(intel, INTEL_FALLBACK_DRAW_BUFFER, GL_TRUE);
@@ -676,7 +677,7 @@ intel_draw_buffer(GLcontext * ctx, struct gl_framebuffer *fb)
 	 if (ctx->Driver.Enable != NULL)
 	    ctx->Driver.Enable(ctx, GL_STENCIL_TEST, ctx->Stencil.Enabled);
 	 else
-	    ctx->NewState |= _NEW_STENCIL;
+	    _mesa_invalidate_state(ctx, _NEW_STENCIL);
          if (!depthRegion)
             depthRegion = irbStencil->region;
       }
@@ -691,7 +692,7 @@ intel_draw_buffer(GLcontext * ctx, struct gl_framebuffer *fb)
       if (ctx->Driver.Enable != NULL)
 	 ctx->Driver.Enable(ctx, GL_STENCIL_TEST, ctx->Stencil.Enabled);
       else
-	 ctx->NewState |= _NEW_STENCIL;
+	 _mesa_invalidate_state(ctx, _NEW_STENCIL);
    }
 
    /*
@@ -704,7 +705,7 @@ intel_draw_buffer(GLcontext * ctx, struct gl_framebuffer *fb)
 	 ctx->Driver.Enable(ctx, GL_DEPTH_TEST, GL_FALSE);
       }
    } else {
-      ctx->NewState |= _NEW_DEPTH;
+      _mesa_invalidate_state(ctx, _NEW_DEPTH);
    }
 
    intel->vtbl.set_draw_region(intel, colorRegions, depthRegion, 
@@ -39,11 +39,14 @@
 #include "main/extensions.h"
 #include "main/framebuffer.h"
 #include "main/imports.h"
+#include "main/marshal.h"
 #include "main/mtypes.h"
+#include "main/profile.h"
 #include "main/renderbuffer.h"
 #include "swrast/swrast.h"
 #include "swrast_setup/swrast_setup.h"
 #include "swrast/s_context.h"
+#include "swrast/s_hiz.h"
 #include "swrast/s_lines.h"
 #include "swrast/s_triangle.h"
 #include "tnl/tnl.h"
@@ -145,6 +148,19 @@ osmesa_update_state( GLcontext *ctx, GLuint new_state )
    DST[ACOMP] = SRC[3]
 #include "swrast/s_spantemp.h"
 
+/**
+ * Direct access to 8-bit RGBA pixels, used by glReadPixels.
+ * rowaddr[] takes care of the buffer's row order.
+ */
+static void *
+get_pointer_RGBA8(GLcontext *ctx, struct gl_renderbuffer *rb,
+                  GLint x, GLint y)
+{
+   const OSMesaContext osmesa = OSMESA_CONTEXT(ctx);
+   (void) rb;
+   return (GLubyte *) osmesa->rowaddr[y] + 4 * x;
+}
+
 /* 16-bit RGBA */
 #define NAME(PREFIX) PREFIX##_RGBA16
 #define RB_TYPE GLushort
@@ -687,11 +703,12 @@ static swrast_tri_func
 osmesa_choose_triangle_function( GLcontext *ctx )
 {
    const OSMesaContext osmesa = OSMESA_CONTEXT(ctx);
-   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
    if (osmesa->rb->DataType != GL_UNSIGNED_BYTE)
       return (swrast_tri_func) NULL;
 
+   if (swrast->UseHalfSpace)            return (swrast_tri_func) NULL;
    if (ctx->RenderMode != GL_RENDER)    return (swrast_tri_func) NULL;
    if (ctx->Polygon.SmoothFlag)         return (swrast_tri_func) NULL;
    if (ctx->Polygon.StippleFlag)        return (swrast_tri_func) NULL;
@@ -708,9 +725,11 @@ osmesa_choose_triangle_function( GLcontext *ctx )
        ctx->Depth.Mask == GL_TRUE &&
        ctx->Visual.depthBits == DEFAULT_SOFTWARE_DEPTH_BITS) {
       if (ctx->Light.ShadeModel == GL_SMOOTH) {
+         swrast->_TriangleName = "osmesa smooth_rgba_z_triangle";
          return (swrast_tri_func) smooth_rgba_z_triangle;
       }
       else {
+         swrast->_TriangleName = "osmesa flat_rgba_z_triangle";
          return (swrast_tri_func) flat_rgba_z_triangle;
       }
    }
@@ -744,6 +763,18 @@ osmesa_choose_line( GLcontext *ctx )
 }
 
 
+/**
+ * Called via swrast->Driver.SpanThreadSafe.  All our renderbuffers are
+ * plain memory, so different rows may be written concurrently.
+ */
+static GLboolean
+osmesa_span_thread_safe( GLcontext *ctx )
+{
+   (void) ctx;
+   return GL_TRUE;
+}
+
+
 
 /**
  * Recompute the values of the context's rowaddr array.
@@ -849,6 +880,7 @@ osmesa_renderbuffer_storage(GLcontext *ctx, struct gl_renderbuffer *rb,
 
    if (osmesa->format == OSMESA_RGBA) {
       if (rb->DataType == GL_UNSIGNED_BYTE) {
+         rb->GetPointer = get_pointer_RGBA8;
          rb->GetRow = get_row_RGBA8;
          rb->GetValues = get_values_RGBA8;
          rb->PutRow = put_row_RGBA8;
@@ -1286,6 +1318,16 @@ OSMesaCreateContextExt( GLenum format, GLint depthBits, GLint stencilBits,
          swrast = SWRAST_CONTEXT( ctx );
          swrast->choose_line = osmesa_choose_line;
          swrast->choose_triangle = osmesa_choose_triangle;
+         swrast->Driver.SpanThreadSafe = osmesa_span_thread_safe;
+
+         /* Let swrast clip the triangles which cross the window edges.
+          * The unclipped triangles' pixels can differ slightly, so this
+          * is only done when asked for.
+          */
+         if (_mesa_getenv("MESA_GUARD_BAND")) {
+            _swrast_allow_guard_band( ctx, GL_TRUE );
+            _tnl_allow_guard_band( ctx, SWRAST_GUARD_BAND_SIZE );
+         }
       }
    }
    return osmesa;
@@ -1301,6 +1343,8 @@ GLAPI void GLAPIENTRY
 OSMesaDestroyContext( OSMesaContext osmesa )
 {
    if (osmesa) {
+      _mesa_free_marshal( &osmesa->mesa );
+
       if (osmesa->rb)
          _mesa_reference_renderbuffer(&osmesa->rb, NULL);
 
@@ -1367,6 +1411,8 @@ OSMesaMakeCurrent( OSMesaContext osmesa, void *buffer, GLenum type,
    }
 #endif
 
+   _mesa_finish_marshal( &osmesa->mesa );
+
    osmesa_update_state( &osmesa->mesa, 0 );
 
    /* Call this periodically to detect when the user has begun using
@@ -1424,6 +1470,8 @@ OSMesaPixelStore( GLint pname, GLint value )
 {
    OSMesaContext osmesa = OSMesaGetCurrentContext();
 
+   _mesa_finish_marshal( &osmesa->mesa );
+
    switch (pname) {
       case OSMESA_ROW_LENGTH:
          if (value<0) {
@@ -1578,6 +1626,8 @@ static struct name_function functions[] = {
    { "OSMesaGetColorBuffer", (OSMESAproc) OSMesaGetColorBuffer },
    { "OSMesaGetProcAddress", (OSMESAproc) OSMesaGetProcAddress },
    { "OSMesaColorClamp", (OSMESAproc) OSMesaColorClamp },
+   { "OSMesaGetProfileSection", (OSMESAproc) OSMesaGetProfileSection },
+   { "OSMesaResetProfile", (OSMESAproc) OSMesaResetProfile },
    { NULL, NULL }
 };
 
@@ -1608,3 +1658,35 @@ OSMesaColorClamp(GLboolean enable)
 }
 
 
+
+
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetProfileSection(GLint index, const char **name, GLuint *calls,
+                        GLdouble *cycles)
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+   GLuint64EXT count;
+
+   if (!osmesa || index < 0)
+      return GL_FALSE;
+
+   _mesa_finish_marshal(&osmesa->mesa);
+   if (!_mesa_get_profile_section(osmesa->mesa.Profile, index,
+                                  name, calls, &count))
+      return GL_FALSE;
+
+   *cycles = (GLdouble) (GLint64EXT) count;
+   return GL_TRUE;
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaResetProfile(void)
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+
+   if (osmesa && osmesa->mesa.Profile) {
+      _mesa_finish_marshal(&osmesa->mesa);
+      _mesa_reset_profile(osmesa->mesa.Profile);
+   }
+}
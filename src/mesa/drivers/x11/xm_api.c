@@ -69,6 +69,7 @@
 #include "main/framebuffer.h"
 #include "main/imports.h"
 #include "main/macros.h"
+#include "main/marshal.h"
 #include "main/renderbuffer.h"
 #include "main/teximage.h"
 #include "glapi/glthread.h"
@@ -1635,6 +1636,15 @@ XMesaContext XMesaCreateContext( XMesaVisual v, XMesaContext share_list )
    xmesa_register_swrast_functions( mesaCtx );
    _swsetup_Wakeup(mesaCtx);
 
+   /* Let swrast clip the triangles which cross the window edges.
+    * The unclipped triangles' pixels can differ slightly, so this is
+    * only done when asked for.
+    */
+   if (_mesa_getenv("MESA_GUARD_BAND")) {
+      _swrast_allow_guard_band(mesaCtx, GL_TRUE);
+      _tnl_allow_guard_band(mesaCtx, SWRAST_GUARD_BAND_SIZE);
+   }
+
    return c;
 }
 
@@ -1645,6 +1655,8 @@ void XMesaDestroyContext( XMesaContext c )
 {
    GLcontext *mesaCtx = &c->mesa;
 
+   _mesa_free_marshal( mesaCtx );
+
 #ifdef FX
    FXdestroyContext( XMESA_BUFFER(mesaCtx->DrawBuffer) );
 #endif
@@ -1922,6 +1934,8 @@ GLboolean XMesaMakeCurrent2( XMesaContext c, XMesaBuffer drawBuffer,
        */
       _glapi_check_multithread();
 
+      _mesa_finish_marshal(&c->mesa);
+
       xmesa_check_and_update_buffer_size(c, drawBuffer);
       if (readBuffer != drawBuffer)
          xmesa_check_and_update_buffer_size(c, readBuffer);
@@ -1193,6 +1193,30 @@ xmesa_init_driver_functions( XMesaVisual xmvisual,
                             _SWRAST_NEW_RASTERMASK)
 
 
+/**
+ * Called via swrast->Driver.SpanThreadSafe.
+ * Drawing into an XImage is just memory access, but drawing to a window
+ * or pixmap goes through Xlib with a shared GC and row image.
+ */
+static GLboolean
+xmesa_span_thread_safe( GLcontext *ctx )
+{
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   GLuint buf;
+
+   if (fb->Name)
+      return GL_TRUE;  /* user-created FBO, all renderbuffers in memory */
+
+   for (buf = 0; buf < fb->_NumColorDrawBuffers; buf++) {
+      struct xmesa_renderbuffer *xrb
+         = xmesa_renderbuffer(fb->_ColorDrawBuffers[buf]);
+      if (!xrb->ximage)
+         return GL_FALSE;
+   }
+   return GL_TRUE;
+}
+
+
 /**
  * Extend the software rasterizer with our line/point/triangle
  * functions.
@@ -1205,6 +1229,7 @@ void xmesa_register_swrast_functions( GLcontext *ctx )
    swrast->choose_point = xmesa_choose_point;
    swrast->choose_line = xmesa_choose_line;
    swrast->choose_triangle = xmesa_choose_triangle;
+   swrast->Driver.SpanThreadSafe = xmesa_span_thread_safe;
 
    /* XXX these lines have no net effect.  Remove??? */
    swrast->InvalidatePointMask |= XMESA_NEW_POINT;
@@ -39,6 +39,7 @@
 /* Internal swrast includes:
  */
 #include "swrast/s_depth.h"
+#include "swrast/s_hiz.h"
 #include "swrast/s_points.h"
 #include "swrast/s_lines.h"
 #include "swrast/s_context.h"
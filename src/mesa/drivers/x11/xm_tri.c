@@ -41,6 +41,7 @@
  */
 #include "swrast/s_context.h"
 #include "swrast/s_depth.h"
+#include "swrast/s_hiz.h"
 #include "swrast/s_triangle.h"
 
 
@@ -1462,6 +1463,8 @@ get_triangle_func(GLcontext *ctx)
 #endif
 
    /* trivial fallback tests */
+   if (swrast->UseHalfSpace)
+      return (swrast_tri_func) NULL;
    if ((ctx->DrawBuffer->_ColorDrawBufferIndexes[0] != BUFFER_BIT_FRONT_LEFT) &&
        (ctx->DrawBuffer->_ColorDrawBufferIndexes[0] != BUFFER_BIT_BACK_LEFT))
       return (swrast_tri_func) NULL;
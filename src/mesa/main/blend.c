@@ -189,7 +189,7 @@ _mesa_BlendFuncSeparateEXT( GLenum sfactorRGB, GLenum dfactorRGB,
        ctx->Color.BlendDstRGB == dfactorRGB &&
        ctx->Color.BlendSrcA == sfactorA &&
        ctx->Color.BlendDstA == dfactorA)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
 
@@ -261,7 +261,7 @@ _mesa_BlendEquation( GLenum mode )
 
    if ( (ctx->Color.BlendEquationRGB == mode) &&
 	(ctx->Color.BlendEquationA == mode) )
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    ctx->Color.BlendEquationRGB = mode;
@@ -302,7 +302,7 @@ _mesa_BlendEquationSeparateEXT( GLenum modeRGB, GLenum modeA )
 
    if ( (ctx->Color.BlendEquationRGB == modeRGB) &&
 	(ctx->Color.BlendEquationA == modeA) )
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    ctx->Color.BlendEquationRGB = modeRGB;
@@ -341,7 +341,7 @@ _mesa_BlendColor( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha )
    tmp[3] = CLAMP( alpha, 0.0F, 1.0F );
 
    if (TEST_EQ_4V(tmp, ctx->Color.BlendColor))
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    COPY_4FV( ctx->Color.BlendColor, tmp );
@@ -379,7 +379,7 @@ _mesa_AlphaFunc( GLenum func, GLclampf ref )
       ref = CLAMP(ref, 0.0F, 1.0F);
 
       if (ctx->Color.AlphaFunc == func && ctx->Color.AlphaRef == ref)
-         return; /* no change */
+         RETURN_UNCHANGED(ctx);
 
       FLUSH_VERTICES(ctx, _NEW_COLOR);
       ctx->Color.AlphaFunc = func;
@@ -436,7 +436,7 @@ _mesa_LogicOp( GLenum opcode )
    }
 
    if (ctx->Color.LogicOp == opcode)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    ctx->Color.LogicOp = opcode;
@@ -453,7 +453,7 @@ _mesa_IndexMask( GLuint mask )
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
    if (ctx->Color.IndexMask == mask)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    ctx->Color.IndexMask = mask;
@@ -498,7 +498,7 @@ _mesa_ColorMask( GLboolean red, GLboolean green,
    tmp[ACOMP] = alpha  ? 0xff : 0x0;
 
    if (TEST_EQ_4UBV(tmp, ctx->Color.ColorMask))
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    COPY_4UBV(ctx->Color.ColorMask, tmp);
@@ -553,6 +553,9 @@ _mesa_validate_pbo_access(GLuint dimensions,
 
    ASSERT(pack->BufferObj->Name != 0);
 
+   /* The buffer may be written to (pixel packing) */
+   pack->BufferObj->Stamp = 0;
+
    if (pack->BufferObj->Size == 0)
       /* no buffer! */
       return GL_FALSE;
@@ -952,6 +955,7 @@ _mesa_BufferDataARB(GLenum target, GLsizeiptrARB size,
 
    /* Give the buffer object to the driver!  <data> may be null! */
    ctx->Driver.BufferData( ctx, target, size, data, usage, bufObj );
+   bufObj->Stamp = 0;
 }
 
 
@@ -972,6 +976,7 @@ _mesa_BufferSubDataARB(GLenum target, GLintptrARB offset,
 
    ASSERT(ctx->Driver.BufferSubData);
    ctx->Driver.BufferSubData( ctx, target, offset, size, data, bufObj );
+   bufObj->Stamp = 0;
 }
 
 
@@ -1034,6 +1039,8 @@ _mesa_MapBufferARB(GLenum target, GLenum access)
    }
 
    bufObj->Access = access;
+   if (access != GL_READ_ONLY_ARB)
+      bufObj->Stamp = 0;
 
    return bufObj->Pointer;
 }
@@ -1065,6 +1072,9 @@ _mesa_UnmapBufferARB(GLenum target)
       status = ctx->Driver.UnmapBuffer( ctx, target, bufObj );
    }
 
+   if (bufObj->Access != GL_READ_ONLY_ARB)
+      bufObj->Stamp = 0;
+
    bufObj->Access = GL_READ_WRITE_ARB; /* initial value, OK? */
    bufObj->Pointer = NULL;
 
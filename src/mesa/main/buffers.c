@@ -417,9 +417,12 @@ _mesa_drawbuffers(GLcontext *ctx, GLuint n, const GLenum *buffers,
       for (buf = 0; buf < ctx->Const.MaxDrawBuffers; buf++) {
          ctx->Color.DrawBuffer[buf] = fb->ColorDrawBuffer[buf];
       }
+      ctx->NewState |= _NEW_COLOR;
+   }
+   else {
+      /* only the user framebuffer's state changed */
+      _mesa_invalidate_state(ctx, _NEW_COLOR);
    }
-
-   ctx->NewState |= _NEW_COLOR;
 }
 
 
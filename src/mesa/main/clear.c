@@ -46,7 +46,7 @@ _mesa_ClearIndex( GLfloat c )
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
    if (ctx->Color.ClearIndex == (GLuint) c)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_COLOR);
    ctx->Color.ClearIndex = (GLuint) c;
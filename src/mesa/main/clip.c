@@ -74,7 +74,7 @@ _mesa_ClipPlane( GLenum plane, const GLdouble *eq )
                            ctx->ModelviewMatrixStack.Top->inv );
 
    if (TEST_EQ_4V(ctx->Transform.EyeUserPlane[p], equation))
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
    COPY_4FV(ctx->Transform.EyeUserPlane[p], equation);
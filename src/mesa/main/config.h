@@ -141,9 +141,22 @@
 /** 
  * Maximum viewport/image width. Must accomodate all texture sizes too. 
  */
-#define MAX_WIDTH 4096
+#define MAX_WIDTH 16384
 /** Maximum viewport/image height */
-#define MAX_HEIGHT 4096
+#define MAX_HEIGHT 16384
+
+/**
+ * Maximum number of fragments the software rasterizer processes at once.
+ * Wider spans are broken into pieces so that the per-fragment arrays
+ * stay small enough to remain in the cache.
+ */
+#define MAX_SPAN_WIDTH 256
+
+/**
+ * Width and height of the tiles over which coarse depth bounds are kept
+ * for software depth buffers (see swrast/s_hiz.c).  Must be a power of two.
+ */
+#define DEPTH_TILE_SIZE 8
 
 /** Maxmimum size for CVA.  May be overridden by the drivers.  */
 #define MAX_ARRAY_LOCK_SIZE 3000
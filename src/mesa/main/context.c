@@ -118,12 +118,15 @@
 #include "light.h"
 #include "lines.h"
 #include "macros.h"
+#include "marshal.h"
 #include "matrix.h"
+#include "mipmap.h"
 #include "multisample.h"
 #include "pixel.h"
 #include "pixelstore.h"
 #include "points.h"
 #include "polygon.h"
+#include "profile.h"
 #if FEATURE_ARB_occlusion_query
 #include "queryobj.h"
 #endif
@@ -138,6 +141,7 @@
 #include "teximage.h"
 #include "texobj.h"
 #include "texstate.h"
+#include "texstore.h"
 #include "mtypes.h"
 #include "varray.h"
 #include "version.h"
@@ -188,7 +192,9 @@ GLfloat _mesa_ubyte_to_float_color_tab[256];
 void
 _mesa_notifySwapBuffers(__GLcontext *gc)
 {
+   _mesa_finish_marshal(gc);
    FLUSH_VERTICES( gc, 0 );
+   _mesa_profile_swap_buffers(gc);
 }
 
 
@@ -1045,6 +1051,7 @@ init_attrib_groups(GLcontext *ctx)
 #endif
    _mesa_init_scissor( ctx );
    _mesa_init_shader_state( ctx );
+   _mesa_init_state_filter( ctx );
    _mesa_init_stencil( ctx );
    _mesa_init_transform( ctx );
    _mesa_init_varray( ctx );
@@ -1237,6 +1244,9 @@ _mesa_initialize_context(GLcontext *ctx,
    _mesa_initialize_context_extra(ctx);
 #endif
 
+   _mesa_init_marshal(ctx);
+   _mesa_init_profile(ctx);
+
    ctx->FirstTimeCurrent = GL_TRUE;
 
    return GL_TRUE;
@@ -1293,6 +1303,8 @@ _mesa_create_context(const GLvisual *visual,
 void
 _mesa_free_context_data( GLcontext *ctx )
 {
+   _mesa_free_marshal(ctx);
+
    if (!_mesa_get_current_context()){
       /* No current context, but we may need one in order to delete
        * texture objs, etc.  So temporarily bind the context now.
@@ -1300,6 +1312,17 @@ _mesa_free_context_data( GLcontext *ctx )
       _mesa_make_current(ctx, NULL, NULL);
    }
 
+   if (_mesa_getenv("MESA_STATE_STATS")) {
+      _mesa_printf("Mesa: %u state calls changed nothing\n",
+                   ctx->StateFilter.Unchanged);
+      _mesa_printf("Mesa: %u state validations, %u group flags dropped "
+                   "as unchanged\n",
+                   ctx->StateFilter.Updates, ctx->StateFilter.Dropped);
+   }
+
+   _mesa_free_profile(ctx);
+   _mesa_free_texture_pool(ctx);
+
    /* unreference WinSysDraw/Read buffers */
    _mesa_unreference_framebuffer(&ctx->WinSysDrawBuffer);
    _mesa_unreference_framebuffer(&ctx->WinSysReadBuffer);
@@ -1608,6 +1631,11 @@ _mesa_make_current( GLcontext *newCtx, GLframebuffer *drawBuffer,
       }
    }
 
+   /* Recorded commands have to be executed with the old bindings */
+   _mesa_finish_marshal(_mesa_get_current_context());
+   if (newCtx)
+      _mesa_finish_marshal(newCtx);
+
    /* We used to call _glapi_check_multithread() here.  Now do it in drivers */
    _glapi_set_context((void *) newCtx);
    ASSERT(_mesa_get_current_context() == newCtx);
@@ -1693,6 +1721,8 @@ _mesa_make_current( GLcontext *newCtx, GLframebuffer *drawBuffer,
 	 }
 	 newCtx->FirstTimeCurrent = GL_FALSE;
       }
+
+      _mesa_bind_marshal(newCtx);
    }
 }
 
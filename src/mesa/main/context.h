@@ -191,6 +191,18 @@ do {								\
    ctx->NewState |= newstate;					\
 } while (0)
 
+/**
+ * Return from a state function called with the current state, counting
+ * the call in the state filter statistics.
+ *
+ * \param ctx GL context.
+ */
+#define RETURN_UNCHANGED(ctx)					\
+do {								\
+   (ctx)->StateFilter.Unchanged++;				\
+   return;							\
+} while (0)
+
 /**
  * Flush current state.
  *
@@ -47,7 +47,7 @@ _mesa_ClearDepth( GLclampd depth )
    depth = CLAMP( depth, 0.0, 1.0 );
 
    if (ctx->Depth.Clear == depth)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_DEPTH);
    ctx->Depth.Clear = depth;
@@ -82,7 +82,7 @@ _mesa_DepthFunc( GLenum func )
    }
 
    if (ctx->Depth.Func == func)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_DEPTH);
    ctx->Depth.Func = func;
@@ -107,7 +107,7 @@ _mesa_DepthMask( GLboolean flag )
     * GL_FALSE indicates depth buffer writing is disabled
     */
    if (ctx->Depth.Mask == flag)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_DEPTH);
    ctx->Depth.Mask = flag;
@@ -136,7 +136,7 @@ _mesa_DepthBoundsEXT( GLclampd zmin, GLclampd zmax )
    zmax = CLAMP(zmax, 0.0, 1.0);
 
    if (ctx->Depth.BoundsMin == zmin && ctx->Depth.BoundsMax == zmax)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_DEPTH);
    ctx->Depth.BoundsMin = (GLfloat) zmin;
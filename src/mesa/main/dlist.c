@@ -585,6 +585,8 @@ _mesa_delete_list(GLcontext *ctx, struct mesa_display_list *dlist)
       }
    }
 
+   if (dlist->replay)
+      _mesa_free(dlist->replay);
    _mesa_free(dlist);
 }
 
@@ -5717,6 +5719,717 @@ islist(GLcontext *ctx, GLuint list)
 
 
 
+/**********************************************************************/
+/*                     Compiled display lists                         */
+/**********************************************************************/
+
+/*
+ * When a display list is finished, its nodes are also translated into a
+ * flat array of replay nodes: for each command a handler function
+ * followed by the command's operands, with float vectors packed so that
+ * they can be passed on directly.  Each handler executes its command and
+ * returns the next one, so replaying a list needs neither the opcode
+ * switch nor the OPCODE_CONTINUE links.  Commands without a handler of
+ * their own are executed from their nodes by execute_nodes().
+ *
+ * Redundant state changes are dropped by the translation: a state
+ * command repeated with the same operands, and attribute, material and
+ * enable/disable commands which are overridden by the next command.
+ */
+
+typedef const union replay_node *(*replay_func) (GLcontext *ctx,
+                                                 const union replay_node *op);
+
+union replay_node
+{
+   replay_func func;
+   void (*execute) (GLcontext *ctx, void *data);
+   Node n;
+};
+
+/** Number of replay nodes taken by count packed floats */
+#define FLOAT_NODES(count) \
+   (((count) * sizeof(GLfloat) + sizeof(union replay_node) - 1) / \
+    sizeof(union replay_node))
+
+/** How a command may be dropped, see replay_commit() */
+#define KIND_NONE      0
+#define KIND_STATE     1        /* repeated with the same operands */
+#define KIND_ENABLE    2        /* overridden, key is the capability */
+#define KIND_ATTR_NV   3        /* overridden, key is the attribute */
+#define KIND_ATTR_ARB  4
+#define KIND_MATERIAL  5        /* overridden, key is face and pname */
+
+
+static void execute_list(GLcontext *ctx, GLuint list);
+static void execute_nodes(GLcontext *ctx, Node *n, GLuint count);
+
+
+static const union replay_node *
+replay_nodes(GLcontext *ctx, const union replay_node *op)
+{
+   execute_nodes(ctx, (Node *) op[1].n.data, 1);
+   return op + 2;
+}
+
+static const union replay_node *
+replay_ext(GLcontext *ctx, const union replay_node *op)
+{
+   op[1].execute(ctx, op[2].n.data);
+   return op + 3;
+}
+
+static const union replay_node *
+replay_end_of_list(GLcontext *ctx, const union replay_node *op)
+{
+   (void) ctx;
+   (void) op;
+   return NULL;
+}
+
+static const union replay_node *
+replay_call_list(GLcontext *ctx, const union replay_node *op)
+{
+   /* Generated by glCallList(), don't add ListBase */
+   if (ctx->ListState.CallDepth < MAX_LIST_NESTING) {
+      execute_list(ctx, op[1].n.ui);
+   }
+   return op + 2;
+}
+
+static const union replay_node *
+replay_enable(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_Enable(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_disable(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_Disable(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_begin(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_Begin(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_end(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_End(ctx->Exec, ());
+   return op + 1;
+}
+
+static const union replay_node *
+replay_shade_model(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_ShadeModel(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_matrix_mode(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_MatrixMode(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_depth_func(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_DepthFunc(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_depth_mask(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_DepthMask(ctx->Exec, (op[1].n.b));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_cull_face(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_CullFace(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_front_face(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_FrontFace(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_active_texture(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_ActiveTextureARB(ctx->Exec, (op[1].n.e));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_bind_texture(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_BindTexture(ctx->Exec, (op[1].n.e, op[2].n.ui));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_line_width(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_LineWidth(ctx->Exec, (op[1].n.f));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_line_stipple(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_LineStipple(ctx->Exec, (op[1].n.i, op[2].n.us));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_point_size(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PointSize(ctx->Exec, (op[1].n.f));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_polygon_mode(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PolygonMode(ctx->Exec, (op[1].n.e, op[2].n.e));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_polygon_offset(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PolygonOffset(ctx->Exec, (op[1].n.f, op[2].n.f));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_alpha_func(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_AlphaFunc(ctx->Exec, (op[1].n.e, op[2].n.f));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_blend_func_separate(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_BlendFuncSeparateEXT(ctx->Exec,
+                             (op[1].n.e, op[2].n.e, op[3].n.e, op[4].n.e));
+   return op + 5;
+}
+
+static const union replay_node *
+replay_color_mask(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_ColorMask(ctx->Exec, (op[1].n.b, op[2].n.b, op[3].n.b, op[4].n.b));
+   return op + 5;
+}
+
+static const union replay_node *
+replay_color_material(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_ColorMaterial(ctx->Exec, (op[1].n.e, op[2].n.e));
+   return op + 3;
+}
+
+static const union replay_node *
+replay_push_attrib(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PushAttrib(ctx->Exec, (op[1].n.bf));
+   return op + 2;
+}
+
+static const union replay_node *
+replay_pop_attrib(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PopAttrib(ctx->Exec, ());
+   return op + 1;
+}
+
+static const union replay_node *
+replay_push_matrix(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PushMatrix(ctx->Exec, ());
+   return op + 1;
+}
+
+static const union replay_node *
+replay_pop_matrix(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_PopMatrix(ctx->Exec, ());
+   return op + 1;
+}
+
+static const union replay_node *
+replay_load_identity(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_LoadIdentity(ctx->Exec, ());
+   return op + 1;
+}
+
+static const union replay_node *
+replay_load_matrix(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_LoadMatrixf(ctx->Exec, ((const GLfloat *) (op + 1)));
+   return op + 1 + FLOAT_NODES(16);
+}
+
+static const union replay_node *
+replay_mult_matrix(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_MultMatrixf(ctx->Exec, ((const GLfloat *) (op + 1)));
+   return op + 1 + FLOAT_NODES(16);
+}
+
+static const union replay_node *
+replay_translate(GLcontext *ctx, const union replay_node *op)
+{
+   const GLfloat *f = (const GLfloat *) (op + 1);
+   CALL_Translatef(ctx->Exec, (f[0], f[1], f[2]));
+   return op + 1 + FLOAT_NODES(3);
+}
+
+static const union replay_node *
+replay_scale(GLcontext *ctx, const union replay_node *op)
+{
+   const GLfloat *f = (const GLfloat *) (op + 1);
+   CALL_Scalef(ctx->Exec, (f[0], f[1], f[2]));
+   return op + 1 + FLOAT_NODES(3);
+}
+
+static const union replay_node *
+replay_rotate(GLcontext *ctx, const union replay_node *op)
+{
+   const GLfloat *f = (const GLfloat *) (op + 1);
+   CALL_Rotatef(ctx->Exec, (f[0], f[1], f[2], f[3]));
+   return op + 1 + FLOAT_NODES(4);
+}
+
+static const union replay_node *
+replay_light(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_Lightfv(ctx->Exec, (op[1].n.e, op[2].n.e,
+                            (const GLfloat *) (op + 3)));
+   return op + 3 + FLOAT_NODES(4);
+}
+
+static const union replay_node *
+replay_material(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_Materialfv(ctx->Exec, (op[1].n.e, op[2].n.e,
+                               (const GLfloat *) (op + 3)));
+   return op + 3 + FLOAT_NODES(4);
+}
+
+static const union replay_node *
+replay_attr_1f_nv(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib1fvNV(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(1);
+}
+
+static const union replay_node *
+replay_attr_2f_nv(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib2fvNV(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(2);
+}
+
+static const union replay_node *
+replay_attr_3f_nv(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib3fvNV(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(3);
+}
+
+static const union replay_node *
+replay_attr_4f_nv(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib4fvNV(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(4);
+}
+
+static const union replay_node *
+replay_attr_1f_arb(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib1fvARB(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(1);
+}
+
+static const union replay_node *
+replay_attr_2f_arb(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib2fvARB(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(2);
+}
+
+static const union replay_node *
+replay_attr_3f_arb(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib3fvARB(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(3);
+}
+
+static const union replay_node *
+replay_attr_4f_arb(GLcontext *ctx, const union replay_node *op)
+{
+   CALL_VertexAttrib4fvARB(ctx->Exec, (op[1].n.ui, (const GLfloat *) (op + 2)));
+   return op + 2 + FLOAT_NODES(4);
+}
+
+
+struct replay_builder
+{
+   union replay_node *ops;
+   GLuint count;
+   GLuint last;                 /**< start of the previous command */
+   GLuint last_kind, last_key;
+};
+
+
+/**
+ * Append a command with the given number of operand nodes, which are
+ * zeroed so that commands can be compared with memcmp.
+ */
+static union replay_node *
+replay_alloc(struct replay_builder *b, replay_func func, GLuint operands)
+{
+   union replay_node *op = b->ops + b->count;
+
+   _mesa_bzero(op, (1 + operands) * sizeof(union replay_node));
+   op[0].func = func;
+   b->count += 1 + operands;
+   return op;
+}
+
+
+/**
+ * Drop the command just appended at start, or the one before it, if it
+ * has no effect.
+ */
+static void
+replay_commit(struct replay_builder *b, GLuint start, GLuint kind, GLuint key)
+{
+   const GLuint size = b->count - start;
+
+   if (kind != KIND_NONE && kind == b->last_kind && b->last < start) {
+      if (kind == KIND_STATE) {
+         /* the previous command again */
+         if (start - b->last == size &&
+             _mesa_memcmp(b->ops + b->last, b->ops + start,
+                          size * sizeof(union replay_node)) == 0) {
+            b->count = start;
+            return;
+         }
+      }
+      else if (key == b->last_key) {
+         /* the previous command is overridden by this one */
+         GLuint i;
+         for (i = 0; i < size; i++)
+            b->ops[b->last + i] = b->ops[start + i];
+         b->count = b->last + size;
+         return;
+      }
+   }
+
+   b->last = start;
+   b->last_kind = kind;
+   b->last_key = key;
+}
+
+
+/**
+ * Append a vertex attribute command, with the floats packed.
+ */
+static void
+replay_attr(struct replay_builder *b, replay_func func, GLuint kind,
+            const Node *n, GLuint size)
+{
+   const GLuint start = b->count;
+   union replay_node *op = replay_alloc(b, func, 1 + FLOAT_NODES(size));
+   GLfloat *f = (GLfloat *) (op + 2);
+   GLuint i;
+
+   op[1].n.ui = n[1].ui;
+   for (i = 0; i < size; i++)
+      f[i] = n[2 + i].f;
+
+   /* attribute zero is the vertex position, which emits a vertex */
+   replay_commit(b, start, n[1].ui ? kind : KIND_NONE, n[1].ui);
+}
+
+
+/**
+ * Append a command with the given number of GLenum/GLuint/GLint/GLfloat
+ * operands.
+ */
+static void
+replay_simple(struct replay_builder *b, replay_func func, GLuint kind,
+              const Node *n, GLuint operands)
+{
+   const GLuint start = b->count;
+   union replay_node *op = replay_alloc(b, func, operands);
+   GLuint i;
+
+   for (i = 1; i <= operands; i++)
+      op[i].n.ui = n[i].ui;
+
+   replay_commit(b, start, kind, operands ? n[1].ui : 0);
+}
+
+
+/**
+ * Translate a display list into its replay form, see above.
+ */
+static void
+build_replay(GLcontext *ctx, struct mesa_display_list *dlist)
+{
+   struct replay_builder b;
+   GLuint size = 0;
+   GLboolean done;
+   Node *n;
+
+   /* Each command takes at most two more replay nodes than list nodes:
+    */
+   n = dlist->node;
+   done = GL_FALSE;
+   while (!done) {
+      const OpCode opcode = n[0].opcode;
+      const GLint i = (GLint) opcode - (GLint) OPCODE_EXT_0;
+
+      if (i >= 0 && i < (GLint) ctx->ListExt.NumOpcodes) {
+         size += ctx->ListExt.Opcode[i].Size + 2;
+         n += ctx->ListExt.Opcode[i].Size;
+      }
+      else if (opcode == OPCODE_CONTINUE) {
+         n = (Node *) n[1].next;
+      }
+      else {
+         size += InstSize[opcode] + 2;
+         done = (opcode == OPCODE_END_OF_LIST);
+         n += InstSize[opcode];
+      }
+   }
+
+   _mesa_bzero(&b, sizeof(b));
+   b.ops = (union replay_node *) _mesa_malloc(size * sizeof(union replay_node));
+   if (!b.ops)
+      return;
+
+   n = dlist->node;
+   done = GL_FALSE;
+   while (!done) {
+      const OpCode opcode = n[0].opcode;
+      const GLint i = (GLint) opcode - (GLint) OPCODE_EXT_0;
+      const GLuint start = b.count;
+      union replay_node *op;
+      GLfloat *f;
+      GLuint j;
+
+      if (i >= 0 && i < (GLint) ctx->ListExt.NumOpcodes) {
+         op = replay_alloc(&b, replay_ext, 2);
+         op[1].execute = ctx->ListExt.Opcode[i].Execute;
+         op[2].n.data = &n[1];
+         replay_commit(&b, start, KIND_NONE, 0);
+         n += ctx->ListExt.Opcode[i].Size;
+         continue;
+      }
+
+      switch (opcode) {
+      case OPCODE_CALL_LIST:
+         replay_simple(&b, replay_call_list, KIND_NONE, n, 1);
+         break;
+      case OPCODE_ENABLE:
+         replay_simple(&b, replay_enable, KIND_ENABLE, n, 1);
+         break;
+      case OPCODE_DISABLE:
+         replay_simple(&b, replay_disable, KIND_ENABLE, n, 1);
+         break;
+      case OPCODE_BEGIN:
+         replay_simple(&b, replay_begin, KIND_NONE, n, 1);
+         break;
+      case OPCODE_END:
+         replay_simple(&b, replay_end, KIND_NONE, n, 0);
+         break;
+      case OPCODE_SHADE_MODEL:
+         replay_simple(&b, replay_shade_model, KIND_STATE, n, 1);
+         break;
+      case OPCODE_MATRIX_MODE:
+         replay_simple(&b, replay_matrix_mode, KIND_STATE, n, 1);
+         break;
+      case OPCODE_DEPTH_FUNC:
+         replay_simple(&b, replay_depth_func, KIND_STATE, n, 1);
+         break;
+      case OPCODE_DEPTH_MASK:
+         op = replay_alloc(&b, replay_depth_mask, 1);
+         op[1].n.b = n[1].b;
+         replay_commit(&b, start, KIND_STATE, 0);
+         break;
+      case OPCODE_CULL_FACE:
+         replay_simple(&b, replay_cull_face, KIND_STATE, n, 1);
+         break;
+      case OPCODE_FRONT_FACE:
+         replay_simple(&b, replay_front_face, KIND_STATE, n, 1);
+         break;
+      case OPCODE_ACTIVE_TEXTURE:
+         replay_simple(&b, replay_active_texture, KIND_STATE, n, 1);
+         break;
+      case OPCODE_BIND_TEXTURE:
+         replay_simple(&b, replay_bind_texture, KIND_STATE, n, 2);
+         break;
+      case OPCODE_LINE_WIDTH:
+         replay_simple(&b, replay_line_width, KIND_STATE, n, 1);
+         break;
+      case OPCODE_LINE_STIPPLE:
+         op = replay_alloc(&b, replay_line_stipple, 2);
+         op[1].n.i = n[1].i;
+         op[2].n.us = n[2].us;
+         replay_commit(&b, start, KIND_STATE, 0);
+         break;
+      case OPCODE_POINT_SIZE:
+         replay_simple(&b, replay_point_size, KIND_STATE, n, 1);
+         break;
+      case OPCODE_POLYGON_MODE:
+         replay_simple(&b, replay_polygon_mode, KIND_STATE, n, 2);
+         break;
+      case OPCODE_POLYGON_OFFSET:
+         replay_simple(&b, replay_polygon_offset, KIND_STATE, n, 2);
+         break;
+      case OPCODE_ALPHA_FUNC:
+         replay_simple(&b, replay_alpha_func, KIND_STATE, n, 2);
+         break;
+      case OPCODE_BLEND_FUNC_SEPARATE:
+         replay_simple(&b, replay_blend_func_separate, KIND_STATE, n, 4);
+         break;
+      case OPCODE_COLOR_MASK:
+         op = replay_alloc(&b, replay_color_mask, 4);
+         for (j = 1; j <= 4; j++)
+            op[j].n.b = n[j].b;
+         replay_commit(&b, start, KIND_STATE, 0);
+         break;
+      case OPCODE_COLOR_MATERIAL:
+         replay_simple(&b, replay_color_material, KIND_STATE, n, 2);
+         break;
+      case OPCODE_PUSH_ATTRIB:
+         replay_simple(&b, replay_push_attrib, KIND_NONE, n, 1);
+         break;
+      case OPCODE_POP_ATTRIB:
+         replay_simple(&b, replay_pop_attrib, KIND_NONE, n, 0);
+         break;
+      case OPCODE_PUSH_MATRIX:
+         replay_simple(&b, replay_push_matrix, KIND_NONE, n, 0);
+         break;
+      case OPCODE_POP_MATRIX:
+         replay_simple(&b, replay_pop_matrix, KIND_NONE, n, 0);
+         break;
+      case OPCODE_LOAD_IDENTITY:
+         replay_simple(&b, replay_load_identity, KIND_STATE, n, 0);
+         break;
+      case OPCODE_LOAD_MATRIX:
+      case OPCODE_MULT_MATRIX:
+         op = replay_alloc(&b, opcode == OPCODE_LOAD_MATRIX ?
+                           replay_load_matrix : replay_mult_matrix,
+                           FLOAT_NODES(16));
+         f = (GLfloat *) (op + 1);
+         for (j = 0; j < 16; j++)
+            f[j] = n[1 + j].f;
+         replay_commit(&b, start, opcode == OPCODE_LOAD_MATRIX ?
+                       KIND_STATE : KIND_NONE, 0);
+         break;
+      case OPCODE_TRANSLATE:
+      case OPCODE_SCALE:
+         op = replay_alloc(&b, opcode == OPCODE_TRANSLATE ?
+                           replay_translate : replay_scale,
+                           FLOAT_NODES(3));
+         f = (GLfloat *) (op + 1);
+         for (j = 0; j < 3; j++)
+            f[j] = n[1 + j].f;
+         replay_commit(&b, start, KIND_NONE, 0);
+         break;
+      case OPCODE_ROTATE:
+         op = replay_alloc(&b, replay_rotate, FLOAT_NODES(4));
+         f = (GLfloat *) (op + 1);
+         for (j = 0; j < 4; j++)
+            f[j] = n[1 + j].f;
+         replay_commit(&b, start, KIND_NONE, 0);
+         break;
+      case OPCODE_LIGHT:
+      case OPCODE_MATERIAL:
+         op = replay_alloc(&b, opcode == OPCODE_LIGHT ?
+                           replay_light : replay_material,
+                           2 + FLOAT_NODES(4));
+         op[1].n.e = n[1].e;
+         op[2].n.e = n[2].e;
+         f = (GLfloat *) (op + 3);
+         for (j = 0; j < 4; j++)
+            f[j] = n[3 + j].f;
+         if (opcode == OPCODE_LIGHT)
+            replay_commit(&b, start, KIND_STATE, 0);
+         else
+            replay_commit(&b, start, KIND_MATERIAL,
+                          (n[1].e << 16) ^ n[2].e);
+         break;
+      case OPCODE_ATTR_1F_NV:
+         replay_attr(&b, replay_attr_1f_nv, KIND_ATTR_NV, n, 1);
+         break;
+      case OPCODE_ATTR_2F_NV:
+         replay_attr(&b, replay_attr_2f_nv, KIND_ATTR_NV, n, 2);
+         break;
+      case OPCODE_ATTR_3F_NV:
+         replay_attr(&b, replay_attr_3f_nv, KIND_ATTR_NV, n, 3);
+         break;
+      case OPCODE_ATTR_4F_NV:
+         replay_attr(&b, replay_attr_4f_nv, KIND_ATTR_NV, n, 4);
+         break;
+      case OPCODE_ATTR_1F_ARB:
+         replay_attr(&b, replay_attr_1f_arb, KIND_ATTR_ARB, n, 1);
+         break;
+      case OPCODE_ATTR_2F_ARB:
+         replay_attr(&b, replay_attr_2f_arb, KIND_ATTR_ARB, n, 2);
+         break;
+      case OPCODE_ATTR_3F_ARB:
+         replay_attr(&b, replay_attr_3f_arb, KIND_ATTR_ARB, n, 3);
+         break;
+      case OPCODE_ATTR_4F_ARB:
+         replay_attr(&b, replay_attr_4f_arb, KIND_ATTR_ARB, n, 4);
+         break;
+      case OPCODE_CONTINUE:
+         n = (Node *) n[1].next;
+         continue;
+      case OPCODE_END_OF_LIST:
+         replay_simple(&b, replay_end_of_list, KIND_NONE, n, 0);
+         done = GL_TRUE;
+         break;
+      default:
+         op = replay_alloc(&b, replay_nodes, 1);
+         op[1].n.data = n;
+         replay_commit(&b, start, KIND_NONE, 0);
+         break;
+      }
+
+      n += InstSize[opcode];
+   }
+
+   assert(b.count <= size);
+   dlist->replay = (union replay_node *)
+      _mesa_realloc(b.ops, size * sizeof(union replay_node),
+                    b.count * sizeof(union replay_node));
+}
+
+
 /**********************************************************************/
 /*                     Display list execution                         */
 /**********************************************************************/
@@ -5732,8 +6445,6 @@ static void
 execute_list(GLcontext *ctx, GLuint list)
 {
    struct mesa_display_list *dlist;
-   Node *n;
-   GLboolean done;
 
    if (list == 0 || !islist(ctx, list))
       return;
@@ -5752,7 +6463,31 @@ execute_list(GLcontext *ctx, GLuint list)
    if (ctx->Driver.BeginCallList)
       ctx->Driver.BeginCallList(ctx, dlist);
 
-   n = dlist->node;
+   if (dlist->replay && !ctx->ListState.CurrentListPtr) {
+      /* the compiled form, see build_replay() */
+      const union replay_node *op = dlist->replay;
+      while (op)
+         op = op->func(ctx, op);
+   }
+   else {
+      execute_nodes(ctx, dlist->node, 0);
+   }
+
+   if (ctx->Driver.EndCallList)
+      ctx->Driver.EndCallList(ctx);
+
+   ctx->ListState.CallDepth--;
+}
+
+
+/**
+ * Execute the commands of a display list starting at node n, up to the
+ * end of the list or until count commands (if not zero) have been run.
+ */
+static void
+execute_nodes(GLcontext *ctx, Node *n, GLuint count)
+{
+   GLboolean done;
 
    done = GL_FALSE;
    while (!done) {
@@ -6630,12 +7365,10 @@ execute_list(GLcontext *ctx, GLuint list)
             n += InstSize[opcode];
          }
       }
-   }
 
-   if (ctx->Driver.EndCallList)
-      ctx->Driver.EndCallList(ctx);
-
-   ctx->ListState.CallDepth--;
+      if (count && --count == 0)
+         done = GL_TRUE;
+   }
 }
 
 
@@ -6803,6 +7536,9 @@ _mesa_EndList(void)
 
    (void) ALLOC_INSTRUCTION(ctx, OPCODE_END_OF_LIST, 0);
 
+   if (ctx->ListState.Replay)
+      build_replay(ctx, ctx->ListState.CurrentList);
+
    /* Destroy old list, if any */
    destroy_list(ctx, ctx->ListState.CurrentListNum);
    /* Install the list */
@@ -8588,6 +9324,7 @@ _mesa_init_display_list(GLcontext *ctx)
    ctx->ListState.CurrentBlock = NULL;
    ctx->ListState.CurrentListNum = 0;
    ctx->ListState.CurrentPos = 0;
+   ctx->ListState.Replay = !_mesa_getenv("MESA_NO_LIST_REPLAY");
 
    /* Display List group */
    ctx->List.ListBase = 0;
@@ -133,7 +133,7 @@ client_state(GLcontext *ctx, GLenum cap, GLboolean state)
    }
 
    if (*var == state)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_ARRAY);
    ctx->Array.NewState |= flag;
@@ -265,19 +265,19 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
    switch (cap) {
       case GL_ALPHA_TEST:
          if (ctx->Color.AlphaEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_COLOR);
          ctx->Color.AlphaEnabled = state;
          break;
       case GL_AUTO_NORMAL:
          if (ctx->Eval.AutoNormal == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.AutoNormal = state;
          break;
       case GL_BLEND:
          if (ctx->Color.BlendEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_COLOR);
          ctx->Color.BlendEnabled = state;
          break;
@@ -292,7 +292,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
             const GLuint p = cap - GL_CLIP_PLANE0;
 
             if ((ctx->Transform.ClipPlanesEnabled & (1 << p)) == ((GLuint) state << p))
-               return;
+               RETURN_UNCHANGED(ctx);
 
             FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
 
@@ -318,7 +318,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
 #endif
       case GL_COLOR_MATERIAL:
          if (ctx->Light.ColorMaterialEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_LIGHT);
          FLUSH_CURRENT(ctx, 0);
          ctx->Light.ColorMaterialEnabled = state;
@@ -329,20 +329,20 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
          break;
       case GL_CULL_FACE:
          if (ctx->Polygon.CullFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.CullFlag = state;
          break;
       case GL_CULL_VERTEX_EXT:
          CHECK_EXTENSION(EXT_cull_vertex, cap);
          if (ctx->Transform.CullVertexFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
          ctx->Transform.CullVertexFlag = state;
          break;
       case GL_DEPTH_TEST:
          if (ctx->Depth.Test == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_DEPTH);
          ctx->Depth.Test = state;
          break;
@@ -351,20 +351,20 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
             state = GL_FALSE; /* MESA_NO_DITHER env var */
          }
          if (ctx->Color.DitherFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_COLOR);
          ctx->Color.DitherFlag = state;
          break;
       case GL_FOG:
          if (ctx->Fog.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_FOG);
          ctx->Fog.Enabled = state;
          break;
       case GL_HISTOGRAM:
          CHECK_EXTENSION(EXT_histogram, cap);
          if (ctx->Pixel.HistogramEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.HistogramEnabled = state;
          break;
@@ -377,7 +377,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_LIGHT6:
       case GL_LIGHT7:
          if (ctx->Light.Light[cap-GL_LIGHT0].Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_LIGHT);
          ctx->Light.Light[cap-GL_LIGHT0].Enabled = state;
          if (state) {
@@ -390,7 +390,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
          break;
       case GL_LIGHTING:
          if (ctx->Light.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_LIGHT);
          ctx->Light.Enabled = state;
          if (ctx->Light.Enabled && ctx->Light.Model.TwoSide)
@@ -400,205 +400,205 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
          break;
       case GL_LINE_SMOOTH:
          if (ctx->Line.SmoothFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_LINE);
          ctx->Line.SmoothFlag = state;
          ctx->_TriangleCaps ^= DD_LINE_SMOOTH;
          break;
       case GL_LINE_STIPPLE:
          if (ctx->Line.StippleFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_LINE);
          ctx->Line.StippleFlag = state;
          ctx->_TriangleCaps ^= DD_LINE_STIPPLE;
          break;
       case GL_INDEX_LOGIC_OP:
          if (ctx->Color.IndexLogicOpEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_COLOR);
          ctx->Color.IndexLogicOpEnabled = state;
          break;
       case GL_COLOR_LOGIC_OP:
          if (ctx->Color.ColorLogicOpEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_COLOR);
          ctx->Color.ColorLogicOpEnabled = state;
          break;
       case GL_MAP1_COLOR_4:
          if (ctx->Eval.Map1Color4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1Color4 = state;
          break;
       case GL_MAP1_INDEX:
          if (ctx->Eval.Map1Index == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1Index = state;
          break;
       case GL_MAP1_NORMAL:
          if (ctx->Eval.Map1Normal == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1Normal = state;
          break;
       case GL_MAP1_TEXTURE_COORD_1:
          if (ctx->Eval.Map1TextureCoord1 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1TextureCoord1 = state;
          break;
       case GL_MAP1_TEXTURE_COORD_2:
          if (ctx->Eval.Map1TextureCoord2 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1TextureCoord2 = state;
          break;
       case GL_MAP1_TEXTURE_COORD_3:
          if (ctx->Eval.Map1TextureCoord3 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1TextureCoord3 = state;
          break;
       case GL_MAP1_TEXTURE_COORD_4:
          if (ctx->Eval.Map1TextureCoord4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1TextureCoord4 = state;
          break;
       case GL_MAP1_VERTEX_3:
          if (ctx->Eval.Map1Vertex3 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1Vertex3 = state;
          break;
       case GL_MAP1_VERTEX_4:
          if (ctx->Eval.Map1Vertex4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map1Vertex4 = state;
          break;
       case GL_MAP2_COLOR_4:
          if (ctx->Eval.Map2Color4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2Color4 = state;
          break;
       case GL_MAP2_INDEX:
          if (ctx->Eval.Map2Index == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2Index = state;
          break;
       case GL_MAP2_NORMAL:
          if (ctx->Eval.Map2Normal == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2Normal = state;
          break;
       case GL_MAP2_TEXTURE_COORD_1:
          if (ctx->Eval.Map2TextureCoord1 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2TextureCoord1 = state;
          break;
       case GL_MAP2_TEXTURE_COORD_2:
          if (ctx->Eval.Map2TextureCoord2 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2TextureCoord2 = state;
          break;
       case GL_MAP2_TEXTURE_COORD_3:
          if (ctx->Eval.Map2TextureCoord3 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2TextureCoord3 = state;
          break;
       case GL_MAP2_TEXTURE_COORD_4:
          if (ctx->Eval.Map2TextureCoord4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2TextureCoord4 = state;
          break;
       case GL_MAP2_VERTEX_3:
          if (ctx->Eval.Map2Vertex3 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2Vertex3 = state;
          break;
       case GL_MAP2_VERTEX_4:
          if (ctx->Eval.Map2Vertex4 == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_EVAL);
          ctx->Eval.Map2Vertex4 = state;
          break;
       case GL_MINMAX:
          if (ctx->Pixel.MinMaxEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.MinMaxEnabled = state;
          break;
       case GL_NORMALIZE:
          if (ctx->Transform.Normalize == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
          ctx->Transform.Normalize = state;
          break;
       case GL_POINT_SMOOTH:
          if (ctx->Point.SmoothFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POINT);
          ctx->Point.SmoothFlag = state;
          ctx->_TriangleCaps ^= DD_POINT_SMOOTH;
          break;
       case GL_POLYGON_SMOOTH:
          if (ctx->Polygon.SmoothFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.SmoothFlag = state;
          ctx->_TriangleCaps ^= DD_TRI_SMOOTH;
          break;
       case GL_POLYGON_STIPPLE:
          if (ctx->Polygon.StippleFlag == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.StippleFlag = state;
          ctx->_TriangleCaps ^= DD_TRI_STIPPLE;
          break;
       case GL_POLYGON_OFFSET_POINT:
          if (ctx->Polygon.OffsetPoint == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.OffsetPoint = state;
          break;
       case GL_POLYGON_OFFSET_LINE:
          if (ctx->Polygon.OffsetLine == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.OffsetLine = state;
          break;
       case GL_POLYGON_OFFSET_FILL:
          /*case GL_POLYGON_OFFSET_EXT:*/
          if (ctx->Polygon.OffsetFill == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POLYGON);
          ctx->Polygon.OffsetFill = state;
          break;
       case GL_RESCALE_NORMAL_EXT:
          if (ctx->Transform.RescaleNormals == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
          ctx->Transform.RescaleNormals = state;
          break;
       case GL_SCISSOR_TEST:
          if (ctx->Scissor.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_SCISSOR);
          ctx->Scissor.Enabled = state;
          break;
       case GL_SHARED_TEXTURE_PALETTE_EXT:
          if (ctx->Texture.SharedPalette == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TEXTURE);
          ctx->Texture.SharedPalette = state;
          break;
@@ -609,23 +609,23 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
             return;
          }
          if (ctx->Stencil.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_STENCIL);
          ctx->Stencil.Enabled = state;
          break;
       case GL_TEXTURE_1D:
          if (!enable_texture(ctx, state, TEXTURE_1D_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
       case GL_TEXTURE_2D:
          if (!enable_texture(ctx, state, TEXTURE_2D_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
       case GL_TEXTURE_3D:
          if (!enable_texture(ctx, state, TEXTURE_3D_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
       case GL_TEXTURE_GEN_Q:
@@ -636,7 +636,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
                if (state)
                   newenabled |= Q_BIT;
                if (texUnit->TexGenEnabled == newenabled)
-                  return;
+                  RETURN_UNCHANGED(ctx);
                FLUSH_VERTICES(ctx, _NEW_TEXTURE);
                texUnit->TexGenEnabled = newenabled;
             }
@@ -650,7 +650,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
                if (state)
                   newenabled |= R_BIT;
                if (texUnit->TexGenEnabled == newenabled)
-                  return;
+                  RETURN_UNCHANGED(ctx);
                FLUSH_VERTICES(ctx, _NEW_TEXTURE);
                texUnit->TexGenEnabled = newenabled;
             }
@@ -664,7 +664,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
                if (state)
                   newenabled |= S_BIT;
                if (texUnit->TexGenEnabled == newenabled)
-                  return;
+                  RETURN_UNCHANGED(ctx);
                FLUSH_VERTICES(ctx, _NEW_TEXTURE);
                texUnit->TexGenEnabled = newenabled;
             }
@@ -678,7 +678,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
                if (state)
                   newenabled |= T_BIT;
                if (texUnit->TexGenEnabled == newenabled)
-                  return;
+                  RETURN_UNCHANGED(ctx);
                FLUSH_VERTICES(ctx, _NEW_TEXTURE);
                texUnit->TexGenEnabled = newenabled;
             }
@@ -704,28 +704,28 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_COLOR_TABLE_SGI:
          CHECK_EXTENSION(SGI_color_table, cap);
          if (ctx->Pixel.ColorTableEnabled[COLORTABLE_PRECONVOLUTION] == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.ColorTableEnabled[COLORTABLE_PRECONVOLUTION] = state;
          break;
       case GL_POST_CONVOLUTION_COLOR_TABLE_SGI:
          CHECK_EXTENSION(SGI_color_table, cap);
          if (ctx->Pixel.ColorTableEnabled[COLORTABLE_POSTCONVOLUTION] == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.ColorTableEnabled[COLORTABLE_POSTCONVOLUTION] = state;
          break;
       case GL_POST_COLOR_MATRIX_COLOR_TABLE_SGI:
          CHECK_EXTENSION(SGI_color_table, cap);
          if (ctx->Pixel.ColorTableEnabled[COLORTABLE_POSTCOLORMATRIX] == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.ColorTableEnabled[COLORTABLE_POSTCOLORMATRIX] = state;
          break;
       case GL_TEXTURE_COLOR_TABLE_SGI:
          CHECK_EXTENSION(SGI_texture_color_table, cap);
          if (ctx->Texture.Unit[ctx->Texture.CurrentUnit].ColorTableEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TEXTURE);
          ctx->Texture.Unit[ctx->Texture.CurrentUnit].ColorTableEnabled = state;
          break;
@@ -734,21 +734,21 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_CONVOLUTION_1D:
          CHECK_EXTENSION(EXT_convolution, cap);
          if (ctx->Pixel.Convolution1DEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.Convolution1DEnabled = state;
          break;
       case GL_CONVOLUTION_2D:
          CHECK_EXTENSION(EXT_convolution, cap);
          if (ctx->Pixel.Convolution2DEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.Convolution2DEnabled = state;
          break;
       case GL_SEPARABLE_2D:
          CHECK_EXTENSION(EXT_convolution, cap);
          if (ctx->Pixel.Separable2DEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PIXEL);
          ctx->Pixel.Separable2DEnabled = state;
          break;
@@ -757,7 +757,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_TEXTURE_CUBE_MAP_ARB:
          CHECK_EXTENSION(ARB_texture_cube_map, cap);
          if (!enable_texture(ctx, state, TEXTURE_CUBE_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
 
@@ -765,7 +765,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_COLOR_SUM_EXT:
          CHECK_EXTENSION2(EXT_secondary_color, ARB_vertex_program, cap);
          if (ctx->Fog.ColorSumEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_FOG);
          ctx->Fog.ColorSumEnabled = state;
          break;
@@ -774,35 +774,35 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_MULTISAMPLE_ARB:
          CHECK_EXTENSION(ARB_multisample, cap);
          if (ctx->Multisample.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_MULTISAMPLE);
          ctx->Multisample.Enabled = state;
          break;
       case GL_SAMPLE_ALPHA_TO_COVERAGE_ARB:
          CHECK_EXTENSION(ARB_multisample, cap);
          if (ctx->Multisample.SampleAlphaToCoverage == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_MULTISAMPLE);
          ctx->Multisample.SampleAlphaToCoverage = state;
          break;
       case GL_SAMPLE_ALPHA_TO_ONE_ARB:
          CHECK_EXTENSION(ARB_multisample, cap);
          if (ctx->Multisample.SampleAlphaToOne == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_MULTISAMPLE);
          ctx->Multisample.SampleAlphaToOne = state;
          break;
       case GL_SAMPLE_COVERAGE_ARB:
          CHECK_EXTENSION(ARB_multisample, cap);
          if (ctx->Multisample.SampleCoverage == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_MULTISAMPLE);
          ctx->Multisample.SampleCoverage = state;
          break;
       case GL_SAMPLE_COVERAGE_INVERT_ARB:
          CHECK_EXTENSION(ARB_multisample, cap);
          if (ctx->Multisample.SampleCoverageInvert == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_MULTISAMPLE);
          ctx->Multisample.SampleCoverageInvert = state;
          break;
@@ -811,7 +811,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_RASTER_POSITION_UNCLIPPED_IBM:
          CHECK_EXTENSION(IBM_rasterpos_clip, cap);
          if (ctx->Transform.RasterPositionUnclipped == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
          ctx->Transform.RasterPositionUnclipped = state;
          break;
@@ -820,7 +820,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_POINT_SPRITE_NV:
          CHECK_EXTENSION2(NV_point_sprite, ARB_point_sprite, cap);
          if (ctx->Point.PointSprite == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_POINT);
          ctx->Point.PointSprite = state;
          break;
@@ -829,21 +829,21 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_VERTEX_PROGRAM_ARB:
          CHECK_EXTENSION2(ARB_vertex_program, NV_vertex_program, cap);
          if (ctx->VertexProgram.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PROGRAM); 
          ctx->VertexProgram.Enabled = state;
          break;
       case GL_VERTEX_PROGRAM_POINT_SIZE_ARB:
          CHECK_EXTENSION2(ARB_vertex_program, NV_vertex_program, cap);
          if (ctx->VertexProgram.PointSizeEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PROGRAM);
          ctx->VertexProgram.PointSizeEnabled = state;
          break;
       case GL_VERTEX_PROGRAM_TWO_SIDE_ARB:
          CHECK_EXTENSION2(ARB_vertex_program, NV_vertex_program, cap);
          if (ctx->VertexProgram.TwoSideEnabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PROGRAM); 
          ctx->VertexProgram.TwoSideEnabled = state;
          break;
@@ -901,7 +901,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_FRAGMENT_PROGRAM_NV:
          CHECK_EXTENSION(NV_fragment_program, cap);
          if (ctx->FragmentProgram.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PROGRAM);
          ctx->FragmentProgram.Enabled = state;
          break;
@@ -911,7 +911,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_TEXTURE_RECTANGLE_NV:
          CHECK_EXTENSION(NV_texture_rectangle, cap);
          if (!enable_texture(ctx, state, TEXTURE_RECT_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
 
@@ -919,7 +919,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_STENCIL_TEST_TWO_SIDE_EXT:
          CHECK_EXTENSION(EXT_stencil_two_side, cap);
          if (ctx->Stencil.TestTwoSide == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_STENCIL);
          ctx->Stencil.TestTwoSide = state;
          if (state)
@@ -932,7 +932,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_FRAGMENT_PROGRAM_ARB:
          CHECK_EXTENSION(ARB_fragment_program, cap);
          if (ctx->FragmentProgram.Enabled == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_PROGRAM);
          ctx->FragmentProgram.Enabled = state;
          break;
@@ -947,7 +947,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
             return;
          }
          if (ctx->Depth.BoundsTest == state)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_DEPTH);
          ctx->Depth.BoundsTest = state;
          break;
@@ -966,7 +966,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_FRAGMENT_SHADER_ATI:
         CHECK_EXTENSION(ATI_fragment_shader, cap);
 	if (ctx->ATIFragmentShader.Enabled == state)
-	  return;
+	  RETURN_UNCHANGED(ctx);
 	FLUSH_VERTICES(ctx, _NEW_PROGRAM);
 	ctx->ATIFragmentShader.Enabled = state;
         break;
@@ -976,14 +976,14 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
       case GL_TEXTURE_1D_ARRAY_EXT:
          CHECK_EXTENSION(MESA_texture_array, cap);
          if (!enable_texture(ctx, state, TEXTURE_1D_ARRAY_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
 
       case GL_TEXTURE_2D_ARRAY_EXT:
          CHECK_EXTENSION(MESA_texture_array, cap);
          if (!enable_texture(ctx, state, TEXTURE_2D_ARRAY_BIT)) {
-            return;
+            RETURN_UNCHANGED(ctx);
          }
          break;
 
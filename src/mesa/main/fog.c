@@ -101,7 +101,7 @@ _mesa_Fogfv( GLenum pname, const GLfloat *params )
             return;
 	 }
 	 if (ctx->Fog.Mode == m)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_FOG);
 	 ctx->Fog.Mode = m;
 	 break;
@@ -111,33 +111,33 @@ _mesa_Fogfv( GLenum pname, const GLfloat *params )
             return;
 	 }
 	 if (ctx->Fog.Density == *params)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_FOG);
 	 ctx->Fog.Density = *params;
 	 break;
       case GL_FOG_START:
          if (ctx->Fog.Start == *params)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_FOG);
          ctx->Fog.Start = *params;
          UPDATE_FOG_SCALE(ctx);
          break;
       case GL_FOG_END:
          if (ctx->Fog.End == *params)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_FOG);
          ctx->Fog.End = *params;
          UPDATE_FOG_SCALE(ctx);
          break;
       case GL_FOG_INDEX:
  	 if (ctx->Fog.Index == *params)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_FOG);
  	 ctx->Fog.Index = *params;
 	 break;
       case GL_FOG_COLOR:
 	 if (TEST_EQ_4V(ctx->Fog.Color, params))
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_FOG);
 	 ctx->Fog.Color[0] = CLAMP(params[0], 0.0F, 1.0F);
 	 ctx->Fog.Color[1] = CLAMP(params[1], 0.0F, 1.0F);
@@ -152,7 +152,7 @@ _mesa_Fogfv( GLenum pname, const GLfloat *params )
 	    return;
 	 }
 	 if (ctx->Fog.FogCoordinateSource == p)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_FOG);
 	 ctx->Fog.FogCoordinateSource = p;
 	 break;
@@ -12,9 +12,9 @@
 
 /*
  * Mesa 3-D graphics library
- * Version:  6.5.1
+ * Version:  7.3
  *
- * Copyright (C) 1999-2006  Brian Paul   All Rights Reserved.
+ * Copyright (C) 1999-2009  Brian Paul   All Rights Reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -41,32 +41,260 @@
 #include "hash.h"
 
 
-#define TABLE_SIZE 1023  /**< Size of lookup table/array */
+/**
+ * Keys below this limit may be stored in the dense array (which is
+ * indexed directly by key) rather than in the hash table proper.
+ * glGen* hands out small sequential names so most keys end up there.
+ */
+#define DENSE_MAX_SIZE (1 << 20)
+
+/** Initial sizes (must be powers of two) */
+#define DENSE_MIN_SIZE 256
+#define SPARSE_MIN_SIZE 64
+
+/** Multiplicative (Fibonacci) hashing, spreads sequential keys */
+#define HASH_FUNC(K, MASK)  (((K) * 2654435761u) & (MASK))
 
-#define HASH_FUNC(K)  ((K) % TABLE_SIZE)
+
+/**
+ * Marks a dense slot holding a NULL data pointer (empty dense slots
+ * are NULL) and a removed entry in the sparse table.
+ */
+static char NullData, Removed;
 
 
 /**
- * An entry in the hash table.  
+ * An entry in the hash table.  A zero key marks an unused entry.
  */
 struct HashEntry {
-   GLuint Key;             /**< the entry's key */
-   void *Data;             /**< the entry's data */
-   struct HashEntry *Next; /**< pointer to next entry */
+   volatile GLuint Key;    /**< the entry's key */
+   void * volatile Data;   /**< the entry's data, or &Removed */
+};
+
+
+/**
+ * The dense array, for keys < Size.
+ */
+struct HashDense {
+   struct HashDense *Retired;   /**< previous array, see below */
+   GLuint Size;
+   void * volatile Slots[1];    /**< NULL, &NullData or the data pointer */
+};
+
+
+/**
+ * The open-addressing (linear probing) table, for the other keys.
+ */
+struct HashSparse {
+   GLuint Mask;                 /**< size - 1 */
+   GLuint Used;                 /**< number of entries with nonzero key */
+   struct HashEntry Entries[1];
 };
 
 
 /**
- * The hash table data structure.  
+ * The hash table data structure.
+ *
+ * Lookups of keys in the dense array don't take the mutex.  For that to
+ * work with concurrent inserts (shared contexts) dense arrays are never
+ * freed while the table exists: when the array is replaced by a bigger
+ * one the old one is kept on the Retired list.  As the size doubles each
+ * time, that costs at most as much memory as the current array.
+ *
+ * The sparse table is only accessed with the mutex held, so a sparse
+ * table replaced when growing or when dropping removed entries is freed
+ * right away.
+ *
+ * FreeFirst..FreeLast is a range of unused keys below MaxKey, for
+ * _mesa_HashFindFreeKeyBlock() once the keys above MaxKey run out.
+ * Inserting a key in the range cuts it down to the bigger part, removing
+ * a key next to it extends it.
  */
 struct _mesa_HashTable {
-   struct HashEntry *Table[TABLE_SIZE];  /**< the lookup table */
+   struct HashDense * volatile Dense;
+   struct HashSparse * volatile Sparse;
+   GLuint NumEntries;                    /**< number of keys in the table */
    GLuint MaxKey;                        /**< highest key inserted so far */
+   GLuint FreeFirst, FreeLast;           /**< unused keys, empty if First > Last */
    _glthread_Mutex Mutex;                /**< mutual exclusion lock */
    GLboolean InDeleteAll;                /**< Debug check */
 };
 
 
+static struct HashDense *
+new_dense(GLuint size)
+{
+   struct HashDense *dense = (struct HashDense *)
+      _mesa_calloc(sizeof(struct HashDense) + (size - 1) * sizeof(void *));
+   if (dense)
+      dense->Size = size;
+   return dense;
+}
+
+
+static struct HashSparse *
+new_sparse(GLuint size)
+{
+   struct HashSparse *sparse = (struct HashSparse *)
+      _mesa_calloc(sizeof(struct HashSparse)
+                   + (size - 1) * sizeof(struct HashEntry));
+   if (sparse)
+      sparse->Mask = size - 1;
+   return sparse;
+}
+
+
+/**
+ * Is the sparse table entry in use?  Entries for keys which are covered
+ * by the dense array are left behind when it grows (so that unlocked
+ * lookups using the old array still find them) and are ignored.
+ */
+static INLINE GLboolean
+sparse_live(const struct _mesa_HashTable *table, const struct HashEntry *entry)
+{
+   return entry->Key >= table->Dense->Size && entry->Data != &Removed;
+}
+
+
+/**
+ * Find the sparse table entry for a key.
+ * \return the entry, or NULL if the key isn't in the table
+ */
+static INLINE struct HashEntry *
+find_sparse(struct HashSparse *sparse, GLuint key)
+{
+   GLuint pos = HASH_FUNC(key, sparse->Mask);
+   for (;;) {
+      struct HashEntry *entry = &sparse->Entries[pos];
+      const GLuint k = entry->Key;
+      if (k == key)
+         return entry;
+      if (k == 0)
+         return NULL;
+      pos = (pos + 1) & sparse->Mask;
+   }
+}
+
+
+/**
+ * Put an entry into a sparse table which has room for it and doesn't
+ * contain the key yet.
+ */
+static void
+add_sparse(struct HashSparse *sparse, GLuint key, void *data)
+{
+   GLuint pos = HASH_FUNC(key, sparse->Mask);
+   while (sparse->Entries[pos].Key)
+      pos = (pos + 1) & sparse->Mask;
+   sparse->Entries[pos].Data = data;
+   sparse->Entries[pos].Key = key;
+   sparse->Used++;
+}
+
+
+/**
+ * Replace the sparse table by a new one of the given size holding the
+ * same entries (removed entries and keys covered by the dense array
+ * are dropped).
+ */
+static GLboolean
+rehash_sparse(struct _mesa_HashTable *table, GLuint size)
+{
+   struct HashSparse *old = table->Sparse;
+   struct HashSparse *sparse = new_sparse(size);
+   GLuint i;
+
+   if (!sparse)
+      return GL_FALSE;
+
+   for (i = 0; i <= old->Mask; i++) {
+      const struct HashEntry *entry = &old->Entries[i];
+      if (sparse_live(table, entry))
+         add_sparse(sparse, entry->Key, entry->Data);
+   }
+
+   table->Sparse = sparse;
+   _mesa_free(old);
+   return GL_TRUE;
+}
+
+
+/**
+ * Grow the dense array so that it covers key, copying the entries of
+ * the sparse table which then belong in the dense array.
+ */
+static GLboolean
+grow_dense(struct _mesa_HashTable *table, GLuint key)
+{
+   struct HashDense *old = table->Dense;
+   struct HashSparse *sparse = table->Sparse;
+   struct HashDense *dense;
+   GLuint size = old->Size, i;
+
+   while (size <= key)
+      size *= 2;
+
+   dense = new_dense(size);
+   if (!dense)
+      return GL_FALSE;
+
+   for (i = 0; i < old->Size; i++)
+      dense->Slots[i] = old->Slots[i];
+
+   for (i = 0; i <= sparse->Mask; i++) {
+      const struct HashEntry *entry = &sparse->Entries[i];
+      if (entry->Key < size && sparse_live(table, entry))
+         dense->Slots[entry->Key] = entry->Data ? entry->Data : &NullData;
+   }
+
+   dense->Retired = old;
+   table->Dense = dense;
+   return GL_TRUE;
+}
+
+
+/**
+ * Keep the free key range clear of a key which is being inserted.
+ */
+static INLINE void
+use_free_key(struct _mesa_HashTable *table, GLuint key)
+{
+   if (key >= table->FreeFirst && key <= table->FreeLast) {
+      if (key - table->FreeFirst >= table->FreeLast - key)
+         table->FreeLast = key - 1;
+      else
+         table->FreeFirst = key + 1;
+   }
+}
+
+
+/**
+ * Add a key which has been removed to the free key range, if it's next
+ * to it.
+ */
+static INLINE void
+release_free_key(struct _mesa_HashTable *table, GLuint key)
+{
+   if (table->FreeFirst > table->FreeLast)
+      table->FreeFirst = table->FreeLast = key;
+   else if (key == table->FreeFirst - 1)
+      table->FreeFirst = key;
+   else if (key == table->FreeLast + 1)
+      table->FreeLast = key;
+}
+
+
+/**
+ * Should the dense array be grown to cover the key?  Only if it stays
+ * reasonably well filled.
+ */
+static INLINE GLboolean
+want_dense(const struct _mesa_HashTable *table, GLuint key)
+{
+   return key < DENSE_MAX_SIZE && key / 4 <= table->NumEntries;
+}
+
+
 
 /**
  * Create a new hash table.
@@ -78,6 +306,17 @@ _mesa_NewHashTable(void)
 {
    struct _mesa_HashTable *table = CALLOC_STRUCT(_mesa_HashTable);
    if (table) {
+      table->Dense = new_dense(DENSE_MIN_SIZE);
+      table->Sparse = new_sparse(SPARSE_MIN_SIZE);
+      if (!table->Dense || !table->Sparse) {
+         if (table->Dense)
+            _mesa_free(table->Dense);
+         if (table->Sparse)
+            _mesa_free(table->Sparse);
+         _mesa_free(table);
+         return NULL;
+      }
+      table->FreeFirst = 1;
       _glthread_INIT_MUTEX(table->Mutex);
    }
    return table;
@@ -96,26 +335,71 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   struct HashDense *dense, *nextDense;
    GLuint pos;
    assert(table);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry = table->Table[pos];
-      while (entry) {
-	 struct HashEntry *next = entry->Next;
-         if (entry->Data) {
-            _mesa_problem(NULL,
-                          "In _mesa_DeleteHashTable, found non-freed data");
-         }
-	 _mesa_free(entry);
-	 entry = next;
+   for (pos = 0; pos < table->Dense->Size; pos++) {
+      if (table->Dense->Slots[pos] && table->Dense->Slots[pos] != &NullData) {
+         _mesa_problem(NULL,
+                       "In _mesa_DeleteHashTable, found non-freed data");
+      }
+   }
+   for (pos = 0; pos <= table->Sparse->Mask; pos++) {
+      const struct HashEntry *entry = &table->Sparse->Entries[pos];
+      if (sparse_live(table, entry) && entry->Data) {
+         _mesa_problem(NULL,
+                       "In _mesa_DeleteHashTable, found non-freed data");
       }
    }
+   for (dense = table->Dense; dense; dense = nextDense) {
+      nextDense = dense->Retired;
+      _mesa_free(dense);
+   }
+   _mesa_free(table->Sparse);
    _glthread_DESTROY_MUTEX(table->Mutex);
    _mesa_free(table);
 }
 
 
 
+/**
+ * Look up a key, with the mutex held.
+ */
+static void *
+lookup_locked(const struct _mesa_HashTable *table, GLuint key)
+{
+   const struct HashEntry *entry;
+   void *data;
+
+   if (key < table->Dense->Size) {
+      data = table->Dense->Slots[key];
+      return data == &NullData ? NULL : data;
+   }
+
+   entry = find_sparse(table->Sparse, key);
+   if (!entry)
+      return NULL;
+   data = entry->Data;
+   return data == &Removed ? NULL : data;
+}
+
+
+/**
+ * Lock the mutex for a sparse table access from the lookup functions,
+ * unless _mesa_HashDeleteAll() holds it (its callbacks may look up
+ * other keys).  The sparse table isn't replaced while that runs.
+ * \return GL_TRUE if the mutex was locked
+ */
+static INLINE GLboolean
+lock_for_lookup(struct _mesa_HashTable *table)
+{
+   if (table->InDeleteAll)
+      return GL_FALSE;
+   _glthread_LOCK_MUTEX(table->Mutex);
+   return GL_TRUE;
+}
+
+
 /**
  * Lookup an entry in the hash table.
  * 
@@ -127,21 +411,27 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 void *
 _mesa_HashLookup(const struct _mesa_HashTable *table, GLuint key)
 {
-   GLuint pos;
-   const struct HashEntry *entry;
+   /* cast-away const */
+   struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
+   const struct HashDense *dense;
+   GLboolean locked;
+   void *data;
 
    assert(table);
    assert(key);
 
-   pos = HASH_FUNC(key);
-   entry = table->Table[pos];
-   while (entry) {
-      if (entry->Key == key) {
-	 return entry->Data;
-      }
-      entry = entry->Next;
+   dense = table->Dense;
+   if (key < dense->Size) {
+      data = dense->Slots[key];
+      return data == &NullData ? NULL : data;
    }
-   return NULL;
+
+   /* the dense array may grow to cover the key meanwhile, so start over */
+   locked = lock_for_lookup(table2);
+   data = lookup_locked(table, key);
+   if (locked)
+      _glthread_UNLOCK_MUTEX(table2->Mutex);
+   return data;
 }
 
 
@@ -157,8 +447,7 @@ _mesa_HashLookup(const struct _mesa_HashTable *table, GLuint key)
 void
 _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
 {
-   /* search for existing entry with this key */
-   GLuint pos;
+   struct HashSparse *sparse;
    struct HashEntry *entry;
 
    assert(table);
@@ -168,30 +457,50 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
 
    if (key > table->MaxKey)
       table->MaxKey = key;
+   use_free_key(table, key);
 
-   pos = HASH_FUNC(key);
+   if (key >= table->Dense->Size && want_dense(table, key)) {
+      grow_dense(table, key);
+   }
 
-   /* check if replacing an existing entry with same key */
-   for (entry = table->Table[pos]; entry; entry = entry->Next) {
-      if (entry->Key == key) {
-         /* replace entry's data */
-#if 0 /* not sure this check is always valid */
-         if (entry->Data) {
-            _mesa_problem(NULL, "Memory leak detected in _mesa_HashInsert");
-         }
-#endif
-	 entry->Data = data;
+   if (key < table->Dense->Size) {
+      void * volatile *slot = &table->Dense->Slots[key];
+      if (!*slot)
+         table->NumEntries++;
+      *slot = data ? data : &NullData;
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
+   }
+
+   /* check if replacing an existing (or removed) entry with same key */
+   entry = find_sparse(table->Sparse, key);
+   if (entry) {
+      if (entry->Data == &Removed)
+         table->NumEntries++;
+      entry->Data = data;
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
+   }
+
+   /* keep the load factor at or below 3/4 */
+   sparse = table->Sparse;
+   if ((sparse->Used + 1) * 4 > (sparse->Mask + 1) * 3) {
+      GLuint size = sparse->Mask + 1, live = 0, i;
+      for (i = 0; i <= sparse->Mask; i++) {
+         if (sparse_live(table, &sparse->Entries[i]))
+            live++;
+      }
+      /* double the size unless it's mostly removed entries */
+      if ((live + 1) * 2 > size)
+         size *= 2;
+      if (!rehash_sparse(table, size)) {
          _glthread_UNLOCK_MUTEX(table->Mutex);
-	 return;
+         return;
       }
    }
 
-   /* alloc and insert new table entry */
-   entry = MALLOC_STRUCT(HashEntry);
-   entry->Key = key;
-   entry->Data = data;
-   entry->Next = table->Table[pos];
-   table->Table[pos] = entry;
+   add_sparse(table->Sparse, key, data);
+   table->NumEntries++;
 
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -205,13 +514,12 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
  * \param key key of entry to remove.
  *
  * While holding the hash table's lock, searches the entry with the matching
- * key and unlinks it.
+ * key and marks it as removed.
  */
 void
 _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
 {
-   GLuint pos;
-   struct HashEntry *entry, *prev;
+   struct HashEntry *entry;
 
    assert(table);
    assert(key);
@@ -225,24 +533,24 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
 
    _glthread_LOCK_MUTEX(table->Mutex);
 
-   pos = HASH_FUNC(key);
-   prev = NULL;
-   entry = table->Table[pos];
-   while (entry) {
-      if (entry->Key == key) {
-         /* found it! */
-         if (prev) {
-            prev->Next = entry->Next;
-         }
-         else {
-            table->Table[pos] = entry->Next;
-         }
-         _mesa_free(entry);
-         _glthread_UNLOCK_MUTEX(table->Mutex);
-	 return;
+   if (key < table->Dense->Size) {
+      if (table->Dense->Slots[key]) {
+         table->Dense->Slots[key] = NULL;
+         table->NumEntries--;
+         release_free_key(table, key);
+      }
+   }
+   else {
+      /* The key stays in the entry so that probing continues past it
+       * and walking the table isn't disturbed; the entry is reused if
+       * the key is inserted again and dropped when rehashing.
+       */
+      entry = find_sparse(table->Sparse, key);
+      if (entry && entry->Data != &Removed) {
+         entry->Data = &Removed;
+         table->NumEntries--;
+         release_free_key(table, key);
       }
-      prev = entry;
-      entry = entry->Next;
    }
 
    _glthread_UNLOCK_MUTEX(table->Mutex);
@@ -264,20 +572,32 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void (*callback)(GLuint key, void *data, void *userData),
                     void *userData)
 {
+   struct HashDense *dense;
+   struct HashSparse *sparse;
    GLuint pos;
    ASSERT(table);
    ASSERT(callback);
    _glthread_LOCK_MUTEX(table->Mutex);
    table->InDeleteAll = GL_TRUE;
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry, *next;
-      for (entry = table->Table[pos]; entry; entry = next) {
+   dense = table->Dense;
+   for (pos = 1; pos < dense->Size; pos++) {
+      void *data = dense->Slots[pos];
+      if (data) {
+         callback(pos, data == &NullData ? NULL : data, userData);
+         dense->Slots[pos] = NULL;
+      }
+   }
+   sparse = table->Sparse;
+   for (pos = 0; pos <= sparse->Mask; pos++) {
+      struct HashEntry *entry = &sparse->Entries[pos];
+      if (sparse_live(table, entry)) {
          callback(entry->Key, entry->Data, userData);
-         next = entry->Next;
-         _mesa_free(entry);
+         entry->Data = &Removed;
       }
-      table->Table[pos] = NULL;
    }
+   table->NumEntries = 0;
+   table->FreeFirst = 1;
+   table->FreeLast = table->MaxKey;
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -285,6 +605,12 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
 
 /**
  * Walk over all entries in a hash table, calling callback function for each.
+ *
+ * The mutex is only held while looking for the next entry, not during the
+ * callback, so the callback may look up or remove entries (freeing a
+ * shader program's data may delete shaders in the same table).  It must
+ * not insert entries.
+ *
  * \param table  the hash table to walk
  * \param callback  the callback function
  * \param userData  arbitrary pointer to pass along to the callback
@@ -297,24 +623,69 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
 {
    /* cast-away const */
    struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
-   GLuint pos;
+   GLuint densePos = 1, sparsePos = 0;
    ASSERT(table);
    ASSERT(callback);
-   _glthread_UNLOCK_MUTEX(table2->Mutex);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry;
-      for (entry = table->Table[pos]; entry; entry = entry->Next) {
-         callback(entry->Key, entry->Data, userData);
+   for (;;) {
+      const struct HashDense *dense;
+      const struct HashSparse *sparse;
+      GLuint key = 0;
+      void *data = NULL;
+
+      _glthread_LOCK_MUTEX(table2->Mutex);
+      dense = table->Dense;
+      sparse = table->Sparse;
+      while (!key && densePos < dense->Size) {
+         data = dense->Slots[densePos];
+         if (data)
+            key = densePos;
+         densePos++;
+      }
+      while (!key && sparsePos <= sparse->Mask) {
+         const struct HashEntry *entry = &sparse->Entries[sparsePos];
+         if (sparse_live(table, entry)) {
+            key = entry->Key;
+            data = entry->Data;
+         }
+         sparsePos++;
       }
+      _glthread_UNLOCK_MUTEX(table2->Mutex);
+
+      if (!key)
+         break;
+      callback(key, data == &NullData ? NULL : data, userData);
+   }
+}
+
+
+/**
+ * Return the first key in the dense array at or after densePos, else the
+ * first key in the sparse table at or after sparsePos, else zero.
+ */
+static GLuint
+next_key_from(const struct _mesa_HashTable *table,
+              GLuint densePos, GLuint sparsePos)
+{
+   const struct HashDense *dense = table->Dense;
+   const struct HashSparse *sparse = table->Sparse;
+
+   for ( ; densePos < dense->Size; densePos++) {
+      if (dense->Slots[densePos])
+         return densePos;
    }
-   _glthread_UNLOCK_MUTEX(table2->Mutex);
+   for ( ; sparsePos <= sparse->Mask; sparsePos++) {
+      const struct HashEntry *entry = &sparse->Entries[sparsePos];
+      if (sparse_live(table, entry))
+         return entry->Key;
+   }
+   return 0;
 }
 
 
 /**
  * Return the key of the "first" entry in the hash table.
  * While holding the lock, walks through all table positions until finding
- * the first entry of the first non-empty one.
+ * the first used one.
  * 
  * \param table  the hash table
  * \return key for the "first" entry in the hash table.
@@ -322,17 +693,12 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
 GLuint
 _mesa_HashFirstEntry(struct _mesa_HashTable *table)
 {
-   GLuint pos;
+   GLuint key;
    assert(table);
    _glthread_LOCK_MUTEX(table->Mutex);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      if (table->Table[pos]) {
-         _glthread_UNLOCK_MUTEX(table->Mutex);
-         return table->Table[pos]->Key;
-      }
-   }
+   key = next_key_from(table, 1, 0);
    _glthread_UNLOCK_MUTEX(table->Mutex);
-   return 0;
+   return key;
 }
 
 
@@ -345,40 +711,40 @@ _mesa_HashFirstEntry(struct _mesa_HashTable *table)
 GLuint
 _mesa_HashNextEntry(const struct _mesa_HashTable *table, GLuint key)
 {
+   /* cast-away const */
+   struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
+   const struct HashSparse *sparse;
    const struct HashEntry *entry;
-   GLuint pos;
+   GLboolean locked;
+   GLuint next;
 
    assert(table);
    assert(key);
 
-   /* Find the entry with given key */
-   pos = HASH_FUNC(key);
-   for (entry = table->Table[pos]; entry ; entry = entry->Next) {
-      if (entry->Key == key) {
-         break;
-      }
-   }
-
-   if (!entry) {
-      /* the given key was not found, so we can't find the next entry */
-      return 0;
-   }
+   locked = lock_for_lookup(table2);
 
-   if (entry->Next) {
-      /* return next in linked list */
-      return entry->Next->Key;
+   if (key < table->Dense->Size) {
+      next = next_key_from(table, key + 1, 0);
    }
    else {
-      /* look for next non-empty table slot */
-      pos++;
-      while (pos < TABLE_SIZE) {
-         if (table->Table[pos]) {
-            return table->Table[pos]->Key;
-         }
-         pos++;
+      /* Find the entry with given key.  Note that entries removed while
+       * walking keep their key, so we can carry on from them.
+       */
+      sparse = table->Sparse;
+      entry = find_sparse((struct HashSparse *) sparse, key);
+      if (entry) {
+         next = next_key_from(table, ~0u,
+                              (GLuint) (entry - sparse->Entries) + 1);
+      }
+      else {
+         /* the given key was not found, so we can't find the next entry */
+         next = 0;
       }
-      return 0;
    }
+
+   if (locked)
+      _glthread_UNLOCK_MUTEX(table2->Mutex);
+   return next;
 }
 
 
@@ -392,17 +758,75 @@ _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
    GLuint pos;
    assert(table);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      const struct HashEntry *entry = table->Table[pos];
-      while (entry) {
-	 _mesa_debug(NULL, "%u %p\n", entry->Key, entry->Data);
-	 entry = entry->Next;
-      }
+   for (pos = 1; pos < table->Dense->Size; pos++) {
+      void *data = table->Dense->Slots[pos];
+      if (data)
+         _mesa_debug(NULL, "%u %p\n", pos, data == &NullData ? NULL : data);
+   }
+   for (pos = 0; pos <= table->Sparse->Mask; pos++) {
+      const struct HashEntry *entry = &table->Sparse->Entries[pos];
+      if (sparse_live(table, entry))
+         _mesa_debug(NULL, "%u %p\n", entry->Key, entry->Data);
    }
 }
 
 
 
+static int
+compare_keys(const void *a, const void *b)
+{
+   const GLuint ka = *(const GLuint *) a, kb = *(const GLuint *) b;
+   return ka < kb ? -1 : ka > kb;
+}
+
+
+/**
+ * Make the free key range the largest range of unused keys below MaxKey.
+ * The keys in use are collected and sorted, so this is O(n log n), but the
+ * range it finds serves the following calls to _mesa_HashFindFreeKeyBlock()
+ * until it's used up.
+ * \return GL_FALSE if out of memory
+ */
+static GLboolean
+find_free_range(struct _mesa_HashTable *table)
+{
+   GLuint *keys = (GLuint *) _mesa_malloc((table->NumEntries + 1)
+                                          * sizeof(GLuint));
+   GLuint n = 0, prev = 0, i;
+
+   if (!keys)
+      return GL_FALSE;
+
+   for (i = 1; i < table->Dense->Size; i++) {
+      if (table->Dense->Slots[i])
+         keys[n++] = i;
+   }
+   for (i = 0; i <= table->Sparse->Mask; i++) {
+      const struct HashEntry *entry = &table->Sparse->Entries[i];
+      if (sparse_live(table, entry))
+         keys[n++] = entry->Key;
+   }
+   assert(n == table->NumEntries);
+   qsort(keys, n, sizeof(GLuint), compare_keys);
+
+   table->FreeFirst = 1;
+   table->FreeLast = 0;
+   for (i = 0; i <= n; i++) {
+      /* keys prev + 1 .. next - 1 are free */
+      const GLuint next = i < n ? keys[i] : table->MaxKey + 1;
+      if (next - prev - 1 > table->FreeLast + 1 - table->FreeFirst) {
+         table->FreeFirst = prev + 1;
+         table->FreeLast = next - 1;
+      }
+      if (i < n)
+         prev = keys[i];
+   }
+
+   _mesa_free(keys);
+   return GL_TRUE;
+}
+
+
 /**
  * Find a block of adjacent unused hash keys.
  * 
@@ -413,43 +837,37 @@ _mesa_HashPrint(const struct _mesa_HashTable *table)
  *
  * If there are enough free keys between the maximum key existing in the table
  * (_mesa_HashTable::MaxKey) and the maximum key possible, then simply return
- * the adjacent key. Otherwise do a full search for a free key block in the
- * allowable key range.
+ * the adjacent key.  Otherwise use the free key range below MaxKey, and
+ * if it's too small, look for the largest one.
  */
 GLuint
 _mesa_HashFindFreeKeyBlock(struct _mesa_HashTable *table, GLuint numKeys)
 {
    const GLuint maxKey = ~((GLuint) 0);
+   GLuint key = 0;
+
+   if (numKeys == 0)
+      return 0;
+
    _glthread_LOCK_MUTEX(table->Mutex);
    if (maxKey - numKeys > table->MaxKey) {
       /* the quick solution */
-      _glthread_UNLOCK_MUTEX(table->Mutex);
-      return table->MaxKey + 1;
+      key = table->MaxKey + 1;
    }
    else {
-      /* the slow solution */
-      GLuint freeCount = 0;
-      GLuint freeStart = 1;
-      GLuint key;
-      for (key = 1; key != maxKey; key++) {
-	 if (_mesa_HashLookup(table, key)) {
-	    /* darn, this key is already in use */
-	    freeCount = 0;
-	    freeStart = key+1;
-	 }
-	 else {
-	    /* this key not in use, check if we've found enough */
-	    freeCount++;
-	    if (freeCount == numKeys) {
-               _glthread_UNLOCK_MUTEX(table->Mutex);
-	       return freeStart;
-	    }
-	 }
+      if (table->FreeLast - table->FreeFirst < numKeys - 1
+          || table->FreeFirst > table->FreeLast) {
+         if (!find_free_range(table)) {
+            _glthread_UNLOCK_MUTEX(table->Mutex);
+            return 0;
+         }
       }
-      /* cannot allocate a block of numKeys consecutive keys */
-      _glthread_UNLOCK_MUTEX(table->Mutex);
-      return 0;
+      if (table->FreeFirst <= table->FreeLast
+          && table->FreeLast - table->FreeFirst >= numKeys - 1)
+         key = table->FreeFirst;
    }
+   _glthread_UNLOCK_MUTEX(table->Mutex);
+   return key;
 }
 
 
@@ -50,31 +50,31 @@ _mesa_Hint( GLenum target, GLenum mode )
    switch (target) {
       case GL_FOG_HINT:
          if (ctx->Hint.Fog == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.Fog = mode;
          break;
       case GL_LINE_SMOOTH_HINT:
          if (ctx->Hint.LineSmooth == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.LineSmooth = mode;
          break;
       case GL_PERSPECTIVE_CORRECTION_HINT:
          if (ctx->Hint.PerspectiveCorrection == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.PerspectiveCorrection = mode;
          break;
       case GL_POINT_SMOOTH_HINT:
          if (ctx->Hint.PointSmooth == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.PointSmooth = mode;
          break;
       case GL_POLYGON_SMOOTH_HINT:
          if (ctx->Hint.PolygonSmooth == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.PolygonSmooth = mode;
          break;
@@ -82,7 +82,7 @@ _mesa_Hint( GLenum target, GLenum mode )
       /* GL_EXT_clip_volume_hint */
       case GL_CLIP_VOLUME_CLIPPING_HINT_EXT:
          if (ctx->Hint.ClipVolumeClipping == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.ClipVolumeClipping = mode;
          break;
@@ -94,7 +94,7 @@ _mesa_Hint( GLenum target, GLenum mode )
 	    return;
          }
 	 if (ctx->Hint.TextureCompression == mode)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
 	 ctx->Hint.TextureCompression = mode;
          break;
@@ -106,7 +106,7 @@ _mesa_Hint( GLenum target, GLenum mode )
 	    return;
          }
          if (ctx->Hint.GenerateMipmap == mode)
-            return;
+            RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_HINT);
 	 ctx->Hint.GenerateMipmap = mode;
          break;
@@ -118,7 +118,7 @@ _mesa_Hint( GLenum target, GLenum mode )
             return;
          }
          if (ctx->Hint.FragmentShaderDerivative == mode)
-            return;
+            RETURN_UNCHANGED(ctx);
          FLUSH_VERTICES(ctx, _NEW_HINT);
          ctx->Hint.FragmentShaderDerivative = mode;
          break;
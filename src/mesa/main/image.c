@@ -36,6 +36,7 @@
 #include "imports.h"
 #include "macros.h"
 #include "pixel.h"
+#include "x86-64/x86-64.h"
 
 
 /**
@@ -3316,6 +3317,296 @@ extract_float_rgba(GLuint n, GLfloat rgba[][4],
 }
 
 
+/**
+ * Direct conversions between 8-bit RGBA and the most common client pixel
+ * formats and types, used instead of the float path when no pixel transfer
+ * operations are enabled.  They give the same results as going through
+ * extract_float_rgba() and CLAMPED_FLOAT_TO_UBYTE(), or FLOAT_TO_UBYTE()
+ * and the packing code in _mesa_pack_rgba_span_float().
+ */
+
+/** Client formats, and the RGBA channel of each of their components. */
+static const struct {
+   GLenum format;
+   GLuint comps;
+   GLuint chan[4];
+} ubyte_formats[] = {
+   { GL_RGB,      3, { RCOMP, GCOMP, BCOMP, 0 } },
+   { GL_BGR,      3, { BCOMP, GCOMP, RCOMP, 0 } },
+   { GL_RGBA,     4, { RCOMP, GCOMP, BCOMP, ACOMP } },
+   { GL_BGRA,     4, { BCOMP, GCOMP, RCOMP, ACOMP } },
+   { GL_ABGR_EXT, 4, { ACOMP, BCOMP, GCOMP, RCOMP } }
+};
+
+/**
+ * Client types: pixel size, and position and size of each component.
+ * For the packed types the shifts are within the GLushort or GLuint
+ * pixel, for GL_UNSIGNED_BYTE they're byte offsets times 8.
+ */
+static const struct {
+   GLenum type;
+   GLuint bytes;
+   GLuint shift[4];
+   GLuint bits[4];
+} ubyte_types[] = {
+   { GL_UNSIGNED_BYTE,              0, {  0,  8, 16, 24 }, { 8, 8, 8, 8 } },
+   { GL_UNSIGNED_INT_8_8_8_8,       4, { 24, 16,  8,  0 }, { 8, 8, 8, 8 } },
+   { GL_UNSIGNED_INT_8_8_8_8_REV,   4, {  0,  8, 16, 24 }, { 8, 8, 8, 8 } },
+   { GL_UNSIGNED_SHORT_5_6_5,       2, { 11,  5,  0,  0 }, { 5, 6, 5, 0 } },
+   { GL_UNSIGNED_SHORT_5_6_5_REV,   2, {  0,  5, 11,  0 }, { 5, 6, 5, 0 } },
+   { GL_UNSIGNED_SHORT_4_4_4_4,     2, { 12,  8,  4,  0 }, { 4, 4, 4, 4 } },
+   { GL_UNSIGNED_SHORT_4_4_4_4_REV, 2, {  0,  4,  8, 12 }, { 4, 4, 4, 4 } },
+   { GL_UNSIGNED_SHORT_5_5_5_1,     2, { 11,  6,  1,  0 }, { 5, 5, 5, 1 } },
+   { GL_UNSIGNED_SHORT_1_5_5_5_REV, 2, {  0,  5, 10, 15 }, { 5, 5, 5, 1 } }
+};
+
+
+/**
+ * Layout of a format/type pair, per RGBA channel.  For 3 and 4 byte
+ * pixels shift is the byte offset of the channel times 8, for 2 byte
+ * pixels the bit position in the (byte swapped) GLushort.  A channel
+ * with zero bits isn't stored.
+ */
+struct ubyte_layout {
+   GLuint bytes;
+   GLboolean swap;
+   GLuint shift[4];
+   GLuint bits[4];
+};
+
+
+static GLboolean
+get_ubyte_layout(GLenum format, GLenum type, GLboolean swapBytes,
+                 struct ubyte_layout *layout)
+{
+   GLuint f, t, k;
+
+   for (f = 0; f < Elements(ubyte_formats); f++) {
+      if (ubyte_formats[f].format == format)
+         break;
+   }
+   for (t = 0; t < Elements(ubyte_types); t++) {
+      if (ubyte_types[t].type == type)
+         break;
+   }
+   if (f == Elements(ubyte_formats) || t == Elements(ubyte_types))
+      return GL_FALSE;
+
+   if (ubyte_types[t].bytes == 0) {
+      layout->bytes = ubyte_formats[f].comps;
+   }
+   else {
+      layout->bytes = ubyte_types[t].bytes;
+      if (ubyte_types[t].bits[3] ? ubyte_formats[f].comps != 4
+                                 : ubyte_formats[f].comps != 3)
+         return GL_FALSE;
+   }
+   layout->swap = layout->bytes == 2 && swapBytes;
+
+   layout->shift[ACOMP] = 0;
+   layout->bits[ACOMP] = 0;
+   for (k = 0; k < ubyte_formats[f].comps; k++) {
+      const GLuint c = ubyte_formats[f].chan[k];
+      GLuint shift = ubyte_types[t].shift[k];
+      if (layout->bytes == 4 && ubyte_types[t].bytes == 4) {
+         /* byte offset of the component in memory */
+         if (!_mesa_little_endian() == !swapBytes)
+            shift = 24 - shift;
+      }
+      layout->shift[c] = shift;
+      layout->bits[c] = ubyte_types[t].bits[k];
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * Multiplier, bias and shift which expand an N-bit value v to
+ * round(v * 255 / (2^N - 1)).
+ */
+static const GLushort expand_ubyte[9][3] = {
+   { 0, 0, 0 },
+   { 255, 0, 0 },
+   { 85, 0, 0 },
+   { 73, 0, 1 },
+   { 17, 0, 0 },
+   { 527, 23, 6 },
+   { 259, 33, 6 },
+   { 129, 0, 6 },
+   { 1, 0, 0 }
+};
+
+
+static void
+unpack_ubyte_layout(const struct ubyte_layout *layout, GLuint n,
+                    const GLvoid *source, GLuint dstComps, GLubyte *dst)
+{
+   GLuint i = 0, c;
+
+   if (layout->bytes == 2) {
+      const GLushort *src = (const GLushort *) source;
+      const GLboolean swap = layout->swap;
+      GLuint shift[4], mask[4], mul[4], bias[4], scale[4];
+      /* a channel which isn't stored expands to (0 * 0 + 255) >> 0 */
+      for (c = 0; c < 4; c++) {
+         const GLuint bits = layout->bits[c];
+         shift[c] = layout->shift[c];
+         mask[c] = (1 << bits) - 1;
+         mul[c] = expand_ubyte[bits][0];
+         bias[c] = bits ? expand_ubyte[bits][1] : 255;
+         scale[c] = expand_ubyte[bits][2];
+      }
+#ifdef USE_X86_64_ASM
+      if (dstComps == 4)
+         i = _mesa_sse2_unpack_ushort_rgba(n, src, swap, layout->shift,
+                                           layout->bits, dst);
+#endif
+      for (; i < n; i++) {
+         GLuint p = src[i];
+         if (swap)
+            p = ((p >> 8) | (p << 8)) & 0xffff;
+         for (c = 0; c < dstComps; c++) {
+            const GLuint v = (p >> shift[c]) & mask[c];
+            dst[i * dstComps + c] = (v * mul[c] + bias[c]) >> scale[c];
+         }
+      }
+   }
+   else {
+      const GLubyte *src = (const GLubyte *) source;
+      const GLuint bytes = layout->bytes;
+      const GLboolean alpha = layout->bits[ACOMP] != 0;
+      GLuint offset[4];
+      for (c = 0; c < 4; c++)
+         offset[c] = layout->shift[c] / 8;
+#ifdef USE_X86_64_ASM
+      if (bytes == 4 && dstComps == 4)
+         i = _mesa_sse2_swizzle_ubyte4(n, src, offset, dst);
+#endif
+      src += i * bytes;
+      dst += i * dstComps;
+      for (; i < n; i++) {
+         dst[0] = src[offset[0]];
+         dst[1] = src[offset[1]];
+         dst[2] = src[offset[2]];
+         if (dstComps == 4)
+            dst[3] = alpha ? src[offset[3]] : 255;
+         src += bytes;
+         dst += dstComps;
+      }
+   }
+}
+
+
+static void
+pack_ubyte_layout(const struct ubyte_layout *layout, GLuint n,
+                  CONST GLubyte rgba[][4], GLvoid *dest)
+{
+   GLuint i = 0, c;
+
+   if (layout->bytes == 2) {
+      GLushort *dst = (GLushort *) dest;
+      const GLboolean swap = layout->swap;
+      GLuint shift[4], max[4], start;
+      for (c = 0; c < 4; c++) {
+         shift[c] = layout->shift[c];
+         max[c] = (1 << layout->bits[c]) - 1;
+      }
+#ifdef USE_X86_64_ASM
+      i = _mesa_sse2_pack_ushort_rgba(n, rgba[0], layout->shift, layout->bits,
+                                      swap, dst);
+#endif
+      /* c * max / 255, computed as ((c * max + 1) * 257) >> 16 */
+      start = i;
+      for (; i < n; i++) {
+         dst[i] = ((((rgba[i][0] * max[0] + 1) * 257) >> 16) << shift[0]) |
+                  ((((rgba[i][1] * max[1] + 1) * 257) >> 16) << shift[1]) |
+                  ((((rgba[i][2] * max[2] + 1) * 257) >> 16) << shift[2]) |
+                  ((((rgba[i][3] * max[3] + 1) * 257) >> 16) << shift[3]);
+      }
+      if (swap)
+         _mesa_swap2(dst + start, n - start);
+   }
+   else {
+      GLubyte *dst = (GLubyte *) dest;
+      const GLuint bytes = layout->bytes;
+      GLuint offset[4];
+      for (c = 0; c < 4; c++)
+         offset[c] = layout->shift[c] / 8;
+#ifdef USE_X86_64_ASM
+      if (bytes == 4) {
+         GLuint map[4];
+         for (c = 0; c < 4; c++)
+            map[offset[c]] = c;
+         i = _mesa_sse2_swizzle_ubyte4(n, rgba[0], map, dst);
+      }
+#endif
+      dst += i * bytes;
+      for (; i < n; i++) {
+         dst[offset[0]] = rgba[i][0];
+         dst[offset[1]] = rgba[i][1];
+         dst[offset[2]] = rgba[i][2];
+         if (bytes == 4)
+            dst[offset[3]] = rgba[i][3];
+         dst += bytes;
+      }
+   }
+}
+
+
+/**
+ * Can pixels of the given format and type be converted to and from
+ * GLubyte RGBA with _mesa_unpack_rgba_span_ubyte() and
+ * _mesa_pack_rgba_span_ubyte()?
+ */
+GLboolean
+_mesa_can_convert_rgba_ubyte(GLenum format, GLenum type)
+{
+   struct ubyte_layout layout;
+   return get_ubyte_layout(format, type, GL_FALSE, &layout);
+}
+
+
+/**
+ * Unpack a row of pixels in a format/type accepted by
+ * _mesa_can_convert_rgba_ubyte() to GLubyte RGBA.  No pixel transfer
+ * operations are applied.
+ */
+void
+_mesa_unpack_rgba_span_ubyte(GLuint n, GLubyte rgba[][4],
+                             GLenum srcFormat, GLenum srcType,
+                             const GLvoid *source,
+                             const struct gl_pixelstore_attrib *srcPacking)
+{
+   struct ubyte_layout layout;
+   GLboolean ok;
+
+   ok = get_ubyte_layout(srcFormat, srcType, srcPacking->SwapBytes, &layout);
+   ASSERT(ok);
+   (void) ok;
+   unpack_ubyte_layout(&layout, n, source, 4, rgba[0]);
+}
+
+
+/**
+ * Pack a row of GLubyte RGBA pixels into a format/type accepted by
+ * _mesa_can_convert_rgba_ubyte().  No pixel transfer operations are
+ * applied.
+ */
+void
+_mesa_pack_rgba_span_ubyte(GLuint n, CONST GLubyte rgba[][4],
+                           GLenum dstFormat, GLenum dstType, GLvoid *dest,
+                           const struct gl_pixelstore_attrib *dstPacking)
+{
+   struct ubyte_layout layout;
+   GLboolean ok;
+
+   ok = get_ubyte_layout(dstFormat, dstType, dstPacking->SwapBytes, &layout);
+   ASSERT(ok);
+   (void) ok;
+   pack_ubyte_layout(&layout, n, rgba, dest);
+}
+
+
 /*
  * Unpack a row of color image data from a client buffer according to
  * the pixel unpacking parameters.
@@ -3498,6 +3789,20 @@ _mesa_unpack_color_span_chan( GLcontext *ctx,
             }
          }
       }
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+      /*
+       * Packed, byte swapped and BGR(A) ordered 8-bit RGB(A) images
+       */
+      if (dstFormat == GL_RGBA || dstFormat == GL_RGB) {
+         struct ubyte_layout layout;
+         if (get_ubyte_layout(srcFormat, srcType, srcPacking->SwapBytes,
+                              &layout)) {
+            unpack_ubyte_layout(&layout, n, source,
+                                dstFormat == GL_RGBA ? 4 : 3, dest);
+            return;
+         }
+      }
+#endif
    }
 
 
@@ -181,6 +181,21 @@ _mesa_pack_rgba_span_float( GLcontext *ctx, GLuint n, GLfloat rgba[][4],
                             GLbitfield transferOps );
 
 
+extern GLboolean
+_mesa_can_convert_rgba_ubyte(GLenum format, GLenum type);
+
+extern void
+_mesa_unpack_rgba_span_ubyte(GLuint n, GLubyte rgba[][4],
+                             GLenum srcFormat, GLenum srcType,
+                             const GLvoid *source,
+                             const struct gl_pixelstore_attrib *srcPacking);
+
+extern void
+_mesa_pack_rgba_span_ubyte(GLuint n, CONST GLubyte rgba[][4],
+                           GLenum dstFormat, GLenum dstType, GLvoid *dest,
+                           const struct gl_pixelstore_attrib *dstPacking);
+
+
 extern void
 _mesa_unpack_color_span_chan( GLcontext *ctx,
                               GLuint n, GLenum dstFormat, GLchan dest[],
@@ -49,7 +49,7 @@ _mesa_ShadeModel( GLenum mode )
    }
 
    if (ctx->Light.ShadeModel == mode)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_LIGHT);
    ctx->Light.ShadeModel = mode;
@@ -81,26 +81,26 @@ _mesa_light(GLcontext *ctx, GLuint lnum, GLenum pname, const GLfloat *params)
    switch (pname) {
    case GL_AMBIENT:
       if (TEST_EQ_4V(light->Ambient, params))
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       COPY_4V( light->Ambient, params );
       break;
    case GL_DIFFUSE:
       if (TEST_EQ_4V(light->Diffuse, params))
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       COPY_4V( light->Diffuse, params );
       break;
    case GL_SPECULAR:
       if (TEST_EQ_4V(light->Specular, params))
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       COPY_4V( light->Specular, params );
       break;
    case GL_POSITION:
       /* NOTE: position has already been transformed by ModelView! */
       if (TEST_EQ_4V(light->EyePosition, params))
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       COPY_4V(light->EyePosition, params);
       if (light->EyePosition[3] != 0.0F)
@@ -111,7 +111,7 @@ _mesa_light(GLcontext *ctx, GLuint lnum, GLenum pname, const GLfloat *params)
    case GL_SPOT_DIRECTION:
       /* NOTE: Direction already transformed by inverse ModelView! */
       if (TEST_EQ_3V(light->EyeDirection, params))
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       COPY_3V(light->EyeDirection, params);
       break;
@@ -119,7 +119,7 @@ _mesa_light(GLcontext *ctx, GLuint lnum, GLenum pname, const GLfloat *params)
       ASSERT(params[0] >= 0.0);
       ASSERT(params[0] <= ctx->Const.MaxSpotExponent);
       if (light->SpotExponent == params[0])
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       light->SpotExponent = params[0];
       _mesa_invalidate_spot_exp_table(light);
@@ -127,7 +127,7 @@ _mesa_light(GLcontext *ctx, GLuint lnum, GLenum pname, const GLfloat *params)
    case GL_SPOT_CUTOFF:
       ASSERT(params[0] == 180.0 || (params[0] >= 0.0 && params[0] <= 90.0));
       if (light->SpotCutoff == params[0])
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       light->SpotCutoff = params[0];
       light->_CosCutoffNeg = (GLfloat) (_mesa_cos(light->SpotCutoff * DEG2RAD));
@@ -143,21 +143,21 @@ _mesa_light(GLcontext *ctx, GLuint lnum, GLenum pname, const GLfloat *params)
    case GL_CONSTANT_ATTENUATION:
       ASSERT(params[0] >= 0.0);
       if (light->ConstantAttenuation == params[0])
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       light->ConstantAttenuation = params[0];
       break;
    case GL_LINEAR_ATTENUATION:
       ASSERT(params[0] >= 0.0);
       if (light->LinearAttenuation == params[0])
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       light->LinearAttenuation = params[0];
       break;
    case GL_QUADRATIC_ATTENUATION:
       ASSERT(params[0] >= 0.0);
       if (light->QuadraticAttenuation == params[0])
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_LIGHT);
       light->QuadraticAttenuation = params[0];
       break;
@@ -431,21 +431,21 @@ _mesa_LightModelfv( GLenum pname, const GLfloat *params )
    switch (pname) {
       case GL_LIGHT_MODEL_AMBIENT:
          if (TEST_EQ_4V( ctx->Light.Model.Ambient, params ))
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_LIGHT);
          COPY_4V( ctx->Light.Model.Ambient, params );
          break;
       case GL_LIGHT_MODEL_LOCAL_VIEWER:
          newbool = (params[0]!=0.0);
 	 if (ctx->Light.Model.LocalViewer == newbool)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_LIGHT);
 	 ctx->Light.Model.LocalViewer = newbool;
          break;
       case GL_LIGHT_MODEL_TWO_SIDE:
          newbool = (params[0]!=0.0);
 	 if (ctx->Light.Model.TwoSide == newbool)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_LIGHT);
 	 ctx->Light.Model.TwoSide = newbool;
          if (ctx->Light.Enabled && ctx->Light.Model.TwoSide)
@@ -464,7 +464,7 @@ _mesa_LightModelfv( GLenum pname, const GLfloat *params )
 	    return;
          }
 	 if (ctx->Light.Model.ColorControl == newenum)
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_LIGHT);
 	 ctx->Light.Model.ColorControl = newenum;
          break;
@@ -720,7 +720,7 @@ _mesa_ColorMaterial( GLenum face, GLenum mode )
    if (ctx->Light.ColorMaterialBitmask == bitmask &&
        ctx->Light.ColorMaterialFace == face &&
        ctx->Light.ColorMaterialMode == mode)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_LIGHT);
    ctx->Light.ColorMaterialBitmask = bitmask;
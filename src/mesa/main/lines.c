@@ -51,7 +51,7 @@ _mesa_LineWidth( GLfloat width )
    }
 
    if (ctx->Line.Width == width)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_LINE);
    ctx->Line.Width = width;
@@ -88,7 +88,7 @@ _mesa_LineStipple( GLint factor, GLushort pattern )
 
    if (ctx->Line.StippleFactor == factor &&
        ctx->Line.StipplePattern == pattern)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_LINE);
    ctx->Line.StippleFactor = factor;
@@ -0,0 +1,1656 @@
+/**
+ * \file marshal.c
+ * Asynchronous execution of GL commands in a separate thread.
+ *
+ * If MESA_GLTHREAD is set, each context gets a worker thread the first
+ * time it's made current.  The application thread's dispatch table is
+ * replaced by one which records GL commands into batches, and the worker
+ * thread executes the batches in order with the context's real dispatch
+ * table.  So the application can go on while the commands are executed.
+ *
+ * Only the frequently used commands which don't return any data are
+ * recorded.  The other entry points wait until the worker has executed all
+ * the recorded commands and then call the real function in the application
+ * thread.  That makes glGet*, glReadPixels, glFinish, etc. see the results
+ * of all the commands issued before them, and functions which read client
+ * memory (glTexImage, glBufferData, ...) don't need to copy it.
+ *
+ * The vertex array state is tracked in the application thread too, so that
+ * glDrawArrays/Elements with arrays in client memory can be recorded: the
+ * vertices used by the draw and indices in client memory are copied into
+ * the command and the worker draws from the copies.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include "glheader.h"
+#include "context.h"
+#include "image.h"
+#include "imports.h"
+#include "macros.h"
+#include "marshal.h"
+#include "mtypes.h"
+#include "glapi/dispatch.h"
+#include "glapi/glthread.h"
+
+
+#if defined(PTHREADS) && !defined(IN_DRI_DRIVER)
+
+
+/** Size of a batch of commands, in bytes */
+#define MARSHAL_BATCH_SIZE (16 * 1024)
+
+/** Number of batches, i.e. how far the application thread may get ahead */
+#define MARSHAL_NUM_BATCHES 8
+
+/** Largest draw command, including the copied vertices and indices */
+#define MARSHAL_MAX_DRAW_SIZE (MARSHAL_BATCH_SIZE / 2)
+
+/** \name Vertex arrays tracked by the application thread */
+/*@{*/
+#define ARRAY_TEX0 8
+#define ARRAY_ATTRIB0 (ARRAY_TEX0 + MAX_TEXTURE_COORD_UNITS)
+#define NUM_ARRAYS (ARRAY_ATTRIB0 + VERT_ATTRIB_MAX)
+/*@}*/
+
+#define ALIGN8(x) (((x) + 7) & ~7)
+
+
+typedef void (*marshal_exec_func)(GLcontext *ctx, const void *cmd);
+
+
+/**
+ * Header of a recorded command.  The command's parameters follow.
+ */
+struct marshal_cmd_base
+{
+   marshal_exec_func Exec;
+   GLuint Size;               /**< in bytes, including the header */
+};
+
+
+struct marshal_batch
+{
+   GLuint Used;               /**< bytes of Buffer in use */
+   GLdouble Buffer[MARSHAL_BATCH_SIZE / sizeof(GLdouble)];
+};
+
+
+/**
+ * The application thread's idea of a vertex array.
+ */
+struct marshal_array
+{
+   const GLubyte *Ptr;
+   GLsizei StrideB;
+   GLuint ElementSize;        /**< 0 if size or type are invalid */
+   GLboolean Enabled;
+   GLboolean Client;          /**< in client memory, not in a buffer object */
+};
+
+
+struct gl_marshal_context
+{
+   struct _glapi_table *Dispatch;   /**< recording dispatch table */
+
+   pthread_t Thread;
+   pthread_mutex_t Mutex;     /**< protects the fields below */
+   pthread_cond_t WorkCond;   /**< signalled when a batch is submitted */
+   pthread_cond_t DoneCond;   /**< signalled when a batch was executed */
+   GLuint Submitted;          /**< number of batches submitted */
+   GLuint Executed;           /**< number of batches executed */
+   GLboolean Running;
+   GLboolean Quit;
+
+   struct marshal_batch *Current;   /**< batch being recorded */
+   struct marshal_batch Batches[MARSHAL_NUM_BATCHES];
+
+   /** \name Vertex array state for the application thread */
+   /*@{*/
+   struct marshal_array Arrays[NUM_ARRAYS];
+   GLboolean ArraysValid;     /**< if false, draws aren't recorded */
+   GLuint ClientActiveTexture;
+   GLuint ArrayBuffer;
+   GLuint ElementBuffer;
+   /*@}*/
+
+   /** Array object pointing to copied client arrays, used by the worker */
+   struct gl_array_object DrawArrayObj;
+};
+
+
+/**********************************************************************/
+/** \name Batches                                                     */
+/*@{*/
+
+/**
+ * Hand the batch being recorded over to the worker thread.
+ * Waits if the worker is MARSHAL_NUM_BATCHES batches behind.
+ */
+static void
+submit_batch(struct gl_marshal_context *m)
+{
+   if (!m->Current->Used)
+      return;
+
+   pthread_mutex_lock(&m->Mutex);
+   m->Submitted++;
+   pthread_cond_signal(&m->WorkCond);
+   while (m->Submitted - m->Executed >= MARSHAL_NUM_BATCHES)
+      pthread_cond_wait(&m->DoneCond, &m->Mutex);
+   pthread_mutex_unlock(&m->Mutex);
+
+   m->Current = &m->Batches[m->Submitted % MARSHAL_NUM_BATCHES];
+}
+
+
+/**
+ * Wait until the worker thread has executed all recorded commands.
+ */
+static void
+wait_idle(struct gl_marshal_context *m)
+{
+   submit_batch(m);
+
+   pthread_mutex_lock(&m->Mutex);
+   while (m->Executed != m->Submitted)
+      pthread_cond_wait(&m->DoneCond, &m->Mutex);
+   pthread_mutex_unlock(&m->Mutex);
+}
+
+
+/**
+ * Allocate a command of the given size in the current batch.
+ */
+static INLINE void *
+marshal_alloc(GLcontext *ctx, marshal_exec_func exec, GLuint size)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+   struct marshal_cmd_base *cmd;
+
+   size = ALIGN8(size);
+   if (m->Current->Used + size > MARSHAL_BATCH_SIZE)
+      submit_batch(m);
+
+   cmd = (struct marshal_cmd_base *)
+      ((GLubyte *) m->Current->Buffer + m->Current->Used);
+   m->Current->Used += size;
+   cmd->Exec = exec;
+   cmd->Size = size;
+   return cmd;
+}
+
+
+static void
+execute_batch(GLcontext *ctx, struct marshal_batch *batch)
+{
+   const GLubyte *cmd = (const GLubyte *) batch->Buffer;
+   const GLubyte *end = cmd + batch->Used;
+
+   /* Functions which call other entry points (the neutral vtxfmt, the
+    * loopback functions) use this thread's dispatch table.  It can only
+    * change between batches, as glNewList/glEndList aren't recorded.
+    */
+   if (_glapi_get_dispatch() != ctx->CurrentDispatch)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (cmd < end) {
+      const struct marshal_cmd_base *base =
+         (const struct marshal_cmd_base *) cmd;
+      base->Exec(ctx, base);
+      cmd += base->Size;
+   }
+
+   batch->Used = 0;
+}
+
+
+static void *
+marshal_thread(void *arg)
+{
+   GLcontext *ctx = (GLcontext *) arg;
+   struct gl_marshal_context *m = ctx->Marshal;
+
+   _glapi_check_multithread();
+   _glapi_set_context(ctx);
+
+   pthread_mutex_lock(&m->Mutex);
+   m->Running = GL_TRUE;
+   pthread_cond_broadcast(&m->DoneCond);
+
+   for (;;) {
+      struct marshal_batch *batch;
+
+      while (!m->Quit && m->Executed == m->Submitted)
+         pthread_cond_wait(&m->WorkCond, &m->Mutex);
+      if (m->Executed == m->Submitted)
+         break;
+
+      batch = &m->Batches[m->Executed % MARSHAL_NUM_BATCHES];
+      pthread_mutex_unlock(&m->Mutex);
+      execute_batch(ctx, batch);
+      pthread_mutex_lock(&m->Mutex);
+
+      m->Executed++;
+      pthread_cond_broadcast(&m->DoneCond);
+   }
+   pthread_mutex_unlock(&m->Mutex);
+
+   return NULL;
+}
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Vertex array tracking                                       */
+/*@{*/
+
+static struct gl_client_array *
+get_array(struct gl_array_object *obj, GLuint i)
+{
+   switch (i) {
+   case 0:
+      return &obj->Vertex;
+   case 1:
+      return &obj->Normal;
+   case 2:
+      return &obj->Color;
+   case 3:
+      return &obj->SecondaryColor;
+   case 4:
+      return &obj->FogCoord;
+   case 5:
+      return &obj->Index;
+   case 6:
+      return &obj->EdgeFlag;
+   case 7:
+      return &obj->PointSize;
+   default:
+      if (i < ARRAY_ATTRIB0)
+         return &obj->TexCoord[i - ARRAY_TEX0];
+      return &obj->VertexAttrib[i - ARRAY_ATTRIB0];
+   }
+}
+
+
+/**
+ * Size of an array element in bytes, or 0 if size or type are invalid.
+ */
+static GLuint
+element_size(GLint size, GLenum type)
+{
+   const GLint typeSize = _mesa_sizeof_type(type);
+   if (size < 1 || size > 4 || typeSize <= 0)
+      return 0;
+   return size * typeSize;
+}
+
+
+/**
+ * Fetch the vertex array state from the context.  The worker thread must
+ * be idle.
+ */
+static void
+refresh_arrays(GLcontext *ctx)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+   GLuint i;
+
+   for (i = 0; i < NUM_ARRAYS; i++) {
+      const struct gl_client_array *a = get_array(ctx->Array.ArrayObj, i);
+      struct marshal_array *s = &m->Arrays[i];
+
+      s->Ptr = a->Ptr;
+      s->StrideB = a->StrideB;
+      s->ElementSize = element_size(a->Size, a->Type);
+      s->Enabled = a->Enabled;
+      s->Client = !a->BufferObj || a->BufferObj->Name == 0;
+   }
+
+   m->ClientActiveTexture = ctx->Array.ActiveTexture;
+   m->ArrayBuffer = ctx->Array.ArrayBufferObj->Name;
+   m->ElementBuffer = ctx->Array.ElementArrayBufferObj->Name;
+   m->ArraysValid = GL_TRUE;
+}
+
+
+static void
+set_array(struct gl_marshal_context *m, GLuint i,
+          GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+   struct marshal_array *s = &m->Arrays[i];
+
+   s->Ptr = (const GLubyte *) ptr;
+   s->ElementSize = element_size(size, type);
+   s->StrideB = stride ? stride : (GLsizei) s->ElementSize;
+   s->Client = m->ArrayBuffer == 0;
+
+   /* the real function will raise an error, refetch the state */
+   if (!s->ElementSize || stride < 0)
+      m->ArraysValid = GL_FALSE;
+}
+
+
+/**
+ * Map a glEnableClientState() cap to an array index, or return -1.
+ */
+static GLint
+client_state_array(const struct gl_marshal_context *m, GLenum cap)
+{
+   switch (cap) {
+   case GL_VERTEX_ARRAY:
+      return 0;
+   case GL_NORMAL_ARRAY:
+      return 1;
+   case GL_COLOR_ARRAY:
+      return 2;
+   case GL_SECONDARY_COLOR_ARRAY_EXT:
+      return 3;
+   case GL_FOG_COORDINATE_ARRAY_EXT:
+      return 4;
+   case GL_INDEX_ARRAY:
+      return 5;
+   case GL_EDGE_FLAG_ARRAY:
+      return 6;
+   case GL_POINT_SIZE_ARRAY_OES:
+      return 7;
+   case GL_TEXTURE_COORD_ARRAY:
+      return ARRAY_TEX0 + m->ClientActiveTexture;
+   default:
+      if (cap >= GL_VERTEX_ATTRIB_ARRAY0_NV &&
+          cap <= GL_VERTEX_ATTRIB_ARRAY15_NV)
+         return ARRAY_ATTRIB0 + cap - GL_VERTEX_ATTRIB_ARRAY0_NV;
+      return -1;
+   }
+}
+
+
+static void
+enable_array(GLcontext *ctx, GLenum cap, GLboolean state)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+   const GLint i = client_state_array(m, cap);
+   if (i >= 0)
+      m->Arrays[i].Enabled = state;
+}
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Synchronous entry points                                    */
+/*@{*/
+
+/**
+ * Wait for the worker and install the real dispatch table in this thread
+ * while the real function runs here.
+ */
+static const struct _glapi_table *
+sync_begin(GLcontext *ctx)
+{
+   wait_idle(ctx->Marshal);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+   return ctx->CurrentDispatch;
+}
+
+
+static void
+sync_end(GLcontext *ctx)
+{
+   refresh_arrays(ctx);
+   _glapi_set_dispatch(ctx->Marshal->Dispatch);
+}
+
+
+/**
+ * As above, for the functions returning a value.  None of them calls
+ * other entry points or changes the vertex array state.
+ */
+static const struct _glapi_table *
+sync_query(GLcontext *ctx)
+{
+   wait_idle(ctx->Marshal);
+   return ctx->CurrentDispatch;
+}
+
+
+#define KEYWORD1 static
+#define KEYWORD2 GLAPIENTRY
+#define NAME(func)  sync_##func
+
+#define DISPATCH(func, args, msg)					\
+   GET_CURRENT_CONTEXT(ctx);						\
+   CALL_##func(sync_begin(ctx), args);					\
+   sync_end(ctx)
+
+#define RETURN_DISPATCH(func, args, msg)				\
+   GET_CURRENT_CONTEXT(ctx);						\
+   return CALL_##func(sync_query(ctx), args)
+
+#define DISPATCH_TABLE_NAME sync_table
+#define UNUSED_TABLE_NAME sync_unused_table
+
+#define TABLE_ENTRY(name) (_glapi_proc) sync_##name
+
+static void GLAPIENTRY
+sync_Unused(void)
+{
+}
+
+#include "glapi/glapitemp.h"
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Recorded commands                                           */
+/*@{*/
+
+#define MARSHAL_0(FUNC)							\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   (void) cmd;								\
+   CALL_##FUNC(ctx->CurrentDispatch, ());				\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(void)							\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   marshal_alloc(ctx, exec_##FUNC, sizeof(struct marshal_cmd_base));	\
+}
+
+#define MARSHAL_1(FUNC, T0)						\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->a0));				\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0)							\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+}
+
+#define MARSHAL_2(FUNC, T0, T1)						\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+   T1 a1;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->a0, c->a1));			\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0, T1 a1)						\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+   c->a1 = a1;								\
+}
+
+#define MARSHAL_3(FUNC, T0, T1, T2)					\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+   T1 a1;								\
+   T2 a2;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->a0, c->a1, c->a2));		\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0, T1 a1, T2 a2)					\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+   c->a1 = a1;								\
+   c->a2 = a2;								\
+}
+
+#define MARSHAL_4(FUNC, T0, T1, T2, T3)					\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+   T1 a1;								\
+   T2 a2;								\
+   T3 a3;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->a0, c->a1, c->a2, c->a3));	\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0, T1 a1, T2 a2, T3 a3)				\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+   c->a1 = a1;								\
+   c->a2 = a2;								\
+   c->a3 = a3;								\
+}
+
+#define MARSHAL_5(FUNC, T0, T1, T2, T3, T4)				\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+   T1 a1;								\
+   T2 a2;								\
+   T3 a3;								\
+   T4 a4;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch,					\
+               (c->a0, c->a1, c->a2, c->a3, c->a4));			\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0, T1 a1, T2 a2, T3 a3, T4 a4)			\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+   c->a1 = a1;								\
+   c->a2 = a2;								\
+   c->a3 = a3;								\
+   c->a4 = a4;								\
+}
+
+#define MARSHAL_6(FUNC, T0, T1, T2, T3, T4, T5)				\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T0 a0;								\
+   T1 a1;								\
+   T2 a2;								\
+   T3 a3;								\
+   T4 a4;								\
+   T5 a5;								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch,					\
+               (c->a0, c->a1, c->a2, c->a3, c->a4, c->a5));		\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(T0 a0, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)		\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->a0 = a0;								\
+   c->a1 = a1;								\
+   c->a2 = a2;								\
+   c->a3 = a3;								\
+   c->a4 = a4;								\
+   c->a5 = a5;								\
+}
+
+/** Functions taking a pointer to N values of type T */
+#define MARSHAL_V(FUNC, T, N)						\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   T v[N];								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->v));				\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(const T *v)						\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   MEMCPY(c->v, v, sizeof(c->v));					\
+}
+
+/** Functions taking a pname and a pointer to param_count(pname) values */
+#define MARSHAL_PARAMS(FUNC, T)						\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   GLenum pname;							\
+   T v[4];								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->pname, c->v));		\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(GLenum pname, const T *v)				\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->pname = pname;							\
+   MEMCPY(c->v, v, param_count(pname) * sizeof(T));			\
+}
+
+/** As above, with a target/light/face parameter first */
+#define MARSHAL_TARGET_PARAMS(FUNC, T)					\
+struct cmd_##FUNC {							\
+   struct marshal_cmd_base Base;					\
+   GLenum target;							\
+   GLenum pname;							\
+   T v[4];								\
+};									\
+static void								\
+exec_##FUNC(GLcontext *ctx, const void *cmd)				\
+{									\
+   const struct cmd_##FUNC *c = (const struct cmd_##FUNC *) cmd;	\
+   CALL_##FUNC(ctx->CurrentDispatch, (c->target, c->pname, c->v));	\
+}									\
+static void GLAPIENTRY							\
+marshal_##FUNC(GLenum target, GLenum pname, const T *v)			\
+{									\
+   GET_CURRENT_CONTEXT(ctx);						\
+   struct cmd_##FUNC *c = (struct cmd_##FUNC *)			\
+      marshal_alloc(ctx, exec_##FUNC, sizeof(struct cmd_##FUNC));	\
+   c->target = target;							\
+   c->pname = pname;							\
+   MEMCPY(c->v, v, param_count(pname) * sizeof(T));			\
+}
+
+
+/**
+ * Number of values glLightfv, glMaterialfv, glFogfv, glTexEnvfv, etc.
+ * read for the given pname.
+ */
+static GLuint
+param_count(GLenum pname)
+{
+   switch (pname) {
+   case GL_AMBIENT:
+   case GL_DIFFUSE:
+   case GL_SPECULAR:
+   case GL_POSITION:
+   case GL_EMISSION:
+   case GL_AMBIENT_AND_DIFFUSE:
+   case GL_LIGHT_MODEL_AMBIENT:
+   case GL_FOG_COLOR:
+   case GL_TEXTURE_ENV_COLOR:
+   case GL_TEXTURE_BORDER_COLOR:
+      return 4;
+   case GL_SPOT_DIRECTION:
+   case GL_COLOR_INDEXES:
+      return 3;
+   default:
+      return 1;
+   }
+}
+
+
+/* Vertex attributes */
+MARSHAL_1(Begin, GLenum)
+MARSHAL_0(End)
+MARSHAL_2(Vertex2f, GLfloat, GLfloat)
+MARSHAL_3(Vertex3f, GLfloat, GLfloat, GLfloat)
+MARSHAL_4(Vertex4f, GLfloat, GLfloat, GLfloat, GLfloat)
+MARSHAL_V(Vertex2fv, GLfloat, 2)
+MARSHAL_V(Vertex3fv, GLfloat, 3)
+MARSHAL_V(Vertex4fv, GLfloat, 4)
+MARSHAL_3(Normal3f, GLfloat, GLfloat, GLfloat)
+MARSHAL_V(Normal3fv, GLfloat, 3)
+MARSHAL_3(Color3f, GLfloat, GLfloat, GLfloat)
+MARSHAL_4(Color4f, GLfloat, GLfloat, GLfloat, GLfloat)
+MARSHAL_V(Color3fv, GLfloat, 3)
+MARSHAL_V(Color4fv, GLfloat, 4)
+MARSHAL_3(Color3ub, GLubyte, GLubyte, GLubyte)
+MARSHAL_4(Color4ub, GLubyte, GLubyte, GLubyte, GLubyte)
+MARSHAL_V(Color3ubv, GLubyte, 3)
+MARSHAL_V(Color4ubv, GLubyte, 4)
+MARSHAL_2(TexCoord2f, GLfloat, GLfloat)
+MARSHAL_3(TexCoord3f, GLfloat, GLfloat, GLfloat)
+MARSHAL_4(TexCoord4f, GLfloat, GLfloat, GLfloat, GLfloat)
+MARSHAL_V(TexCoord2fv, GLfloat, 2)
+MARSHAL_V(TexCoord3fv, GLfloat, 3)
+MARSHAL_V(TexCoord4fv, GLfloat, 4)
+MARSHAL_3(MultiTexCoord2fARB, GLenum, GLfloat, GLfloat)
+MARSHAL_TARGET_PARAMS(Materialfv, GLfloat)
+MARSHAL_3(Materialf, GLenum, GLenum, GLfloat)
+
+/* Matrices */
+MARSHAL_1(MatrixMode, GLenum)
+MARSHAL_0(LoadIdentity)
+MARSHAL_0(PushMatrix)
+MARSHAL_0(PopMatrix)
+MARSHAL_V(LoadMatrixf, GLfloat, 16)
+MARSHAL_V(LoadMatrixd, GLdouble, 16)
+MARSHAL_V(MultMatrixf, GLfloat, 16)
+MARSHAL_V(MultMatrixd, GLdouble, 16)
+MARSHAL_3(Translatef, GLfloat, GLfloat, GLfloat)
+MARSHAL_3(Translated, GLdouble, GLdouble, GLdouble)
+MARSHAL_3(Scalef, GLfloat, GLfloat, GLfloat)
+MARSHAL_3(Scaled, GLdouble, GLdouble, GLdouble)
+MARSHAL_4(Rotatef, GLfloat, GLfloat, GLfloat, GLfloat)
+MARSHAL_4(Rotated, GLdouble, GLdouble, GLdouble, GLdouble)
+MARSHAL_6(Ortho, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble)
+MARSHAL_6(Frustum, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble)
+MARSHAL_4(Viewport, GLint, GLint, GLsizei, GLsizei)
+MARSHAL_2(DepthRange, GLclampd, GLclampd)
+
+/* State */
+MARSHAL_1(Enable, GLenum)
+MARSHAL_1(Disable, GLenum)
+MARSHAL_1(PushAttrib, GLbitfield)
+MARSHAL_0(PopAttrib)
+MARSHAL_1(ShadeModel, GLenum)
+MARSHAL_1(CullFace, GLenum)
+MARSHAL_1(FrontFace, GLenum)
+MARSHAL_2(PolygonMode, GLenum, GLenum)
+MARSHAL_2(PolygonOffset, GLfloat, GLfloat)
+MARSHAL_1(LineWidth, GLfloat)
+MARSHAL_2(LineStipple, GLint, GLushort)
+MARSHAL_1(PointSize, GLfloat)
+MARSHAL_2(Hint, GLenum, GLenum)
+MARSHAL_1(DepthFunc, GLenum)
+MARSHAL_1(DepthMask, GLboolean)
+MARSHAL_2(AlphaFunc, GLenum, GLclampf)
+MARSHAL_2(BlendFunc, GLenum, GLenum)
+MARSHAL_4(BlendFuncSeparateEXT, GLenum, GLenum, GLenum, GLenum)
+MARSHAL_1(BlendEquation, GLenum)
+MARSHAL_4(BlendColor, GLclampf, GLclampf, GLclampf, GLclampf)
+MARSHAL_1(LogicOp, GLenum)
+MARSHAL_4(ColorMask, GLboolean, GLboolean, GLboolean, GLboolean)
+MARSHAL_3(StencilFunc, GLenum, GLint, GLuint)
+MARSHAL_3(StencilOp, GLenum, GLenum, GLenum)
+MARSHAL_1(StencilMask, GLuint)
+MARSHAL_4(Scissor, GLint, GLint, GLsizei, GLsizei)
+MARSHAL_2(ColorMaterial, GLenum, GLenum)
+MARSHAL_3(Lightf, GLenum, GLenum, GLfloat)
+MARSHAL_TARGET_PARAMS(Lightfv, GLfloat)
+MARSHAL_2(LightModeli, GLenum, GLint)
+MARSHAL_PARAMS(LightModelfv, GLfloat)
+MARSHAL_2(Fogf, GLenum, GLfloat)
+MARSHAL_2(Fogi, GLenum, GLint)
+MARSHAL_PARAMS(Fogfv, GLfloat)
+MARSHAL_2(PixelStorei, GLenum, GLint)
+
+/* Textures */
+MARSHAL_1(ActiveTextureARB, GLenum)
+MARSHAL_2(BindTexture, GLenum, GLuint)
+MARSHAL_3(TexParameteri, GLenum, GLenum, GLint)
+MARSHAL_3(TexParameterf, GLenum, GLenum, GLfloat)
+MARSHAL_TARGET_PARAMS(TexParameterfv, GLfloat)
+MARSHAL_3(TexEnvi, GLenum, GLenum, GLint)
+MARSHAL_3(TexEnvf, GLenum, GLenum, GLfloat)
+MARSHAL_TARGET_PARAMS(TexEnvfv, GLfloat)
+MARSHAL_3(TexGeni, GLenum, GLenum, GLint)
+
+/* Drawing */
+MARSHAL_4(ClearColor, GLclampf, GLclampf, GLclampf, GLclampf)
+MARSHAL_1(ClearDepth, GLclampd)
+MARSHAL_1(ClearStencil, GLint)
+MARSHAL_1(Clear, GLbitfield)
+MARSHAL_1(CallList, GLuint)
+
+/* Vertex arrays */
+MARSHAL_1(EnableClientState, GLenum)
+MARSHAL_1(DisableClientState, GLenum)
+MARSHAL_1(ClientActiveTextureARB, GLenum)
+MARSHAL_2(BindBufferARB, GLenum, GLuint)
+MARSHAL_4(VertexPointer, GLint, GLenum, GLsizei, const GLvoid *)
+MARSHAL_3(NormalPointer, GLenum, GLsizei, const GLvoid *)
+MARSHAL_4(ColorPointer, GLint, GLenum, GLsizei, const GLvoid *)
+MARSHAL_4(SecondaryColorPointerEXT, GLint, GLenum, GLsizei, const GLvoid *)
+MARSHAL_3(FogCoordPointerEXT, GLenum, GLsizei, const GLvoid *)
+MARSHAL_3(IndexPointer, GLenum, GLsizei, const GLvoid *)
+MARSHAL_2(EdgeFlagPointer, GLsizei, const GLvoid *)
+MARSHAL_4(TexCoordPointer, GLint, GLenum, GLsizei, const GLvoid *)
+MARSHAL_1(EnableVertexAttribArrayARB, GLuint)
+MARSHAL_1(DisableVertexAttribArrayARB, GLuint)
+
+struct cmd_VertexAttribPointerARB {
+   struct marshal_cmd_base Base;
+   GLuint index;
+   GLint size;
+   GLenum type;
+   GLboolean normalized;
+   GLsizei stride;
+   const GLvoid *ptr;
+};
+
+static void
+exec_VertexAttribPointerARB(GLcontext *ctx, const void *cmd)
+{
+   const struct cmd_VertexAttribPointerARB *c =
+      (const struct cmd_VertexAttribPointerARB *) cmd;
+   CALL_VertexAttribPointerARB(ctx->CurrentDispatch,
+                               (c->index, c->size, c->type, c->normalized,
+                                c->stride, c->ptr));
+}
+
+
+static void
+exec_Flush(GLcontext *ctx, const void *cmd)
+{
+   (void) cmd;
+   CALL_Flush(ctx->CurrentDispatch, ());
+}
+
+
+static void GLAPIENTRY
+marshal_Flush(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   marshal_alloc(ctx, exec_Flush, sizeof(struct marshal_cmd_base));
+   /* let the worker start on what was recorded so far */
+   submit_batch(ctx->Marshal);
+}
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Vertex array entry points                                   */
+/*@{*/
+
+static void GLAPIENTRY
+track_Enable(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   enable_array(ctx, cap, GL_TRUE);
+   marshal_Enable(cap);
+}
+
+
+static void GLAPIENTRY
+track_Disable(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   enable_array(ctx, cap, GL_FALSE);
+   marshal_Disable(cap);
+}
+
+
+static void GLAPIENTRY
+track_EnableClientState(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   enable_array(ctx, cap, GL_TRUE);
+   marshal_EnableClientState(cap);
+}
+
+
+static void GLAPIENTRY
+track_DisableClientState(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   enable_array(ctx, cap, GL_FALSE);
+   marshal_DisableClientState(cap);
+}
+
+
+static void GLAPIENTRY
+track_ClientActiveTextureARB(GLenum texture)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const GLuint unit = texture - GL_TEXTURE0;
+
+   if (unit < ctx->Const.MaxTextureCoordUnits)
+      ctx->Marshal->ClientActiveTexture = unit;
+   else
+      ctx->Marshal->ArraysValid = GL_FALSE;
+   marshal_ClientActiveTextureARB(texture);
+}
+
+
+static void GLAPIENTRY
+track_BindBufferARB(GLenum target, GLuint buffer)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (target == GL_ARRAY_BUFFER_ARB)
+      ctx->Marshal->ArrayBuffer = buffer;
+   else if (target == GL_ELEMENT_ARRAY_BUFFER_ARB)
+      ctx->Marshal->ElementBuffer = buffer;
+   marshal_BindBufferARB(target, buffer);
+}
+
+
+static void GLAPIENTRY
+track_VertexPointer(GLint size, GLenum type, GLsizei stride,
+                    const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 0, size, type, stride, ptr);
+   marshal_VertexPointer(size, type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_NormalPointer(GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 1, 3, type, stride, ptr);
+   marshal_NormalPointer(type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_ColorPointer(GLint size, GLenum type, GLsizei stride,
+                   const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 2, size, type, stride, ptr);
+   marshal_ColorPointer(size, type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_SecondaryColorPointerEXT(GLint size, GLenum type, GLsizei stride,
+                               const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 3, size, type, stride, ptr);
+   marshal_SecondaryColorPointerEXT(size, type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_FogCoordPointerEXT(GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 4, 1, type, stride, ptr);
+   marshal_FogCoordPointerEXT(type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_IndexPointer(GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 5, 1, type, stride, ptr);
+   marshal_IndexPointer(type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_EdgeFlagPointer(GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   set_array(ctx->Marshal, 6, 1, GL_UNSIGNED_BYTE, stride, ptr);
+   marshal_EdgeFlagPointer(stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_TexCoordPointer(GLint size, GLenum type, GLsizei stride,
+                      const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_marshal_context *m = ctx->Marshal;
+   set_array(m, ARRAY_TEX0 + m->ClientActiveTexture, size, type, stride, ptr);
+   marshal_TexCoordPointer(size, type, stride, ptr);
+}
+
+
+static void GLAPIENTRY
+track_VertexAttribPointerARB(GLuint index, GLint size, GLenum type,
+                             GLboolean normalized, GLsizei stride,
+                             const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_marshal_context *m = ctx->Marshal;
+   struct cmd_VertexAttribPointerARB *c;
+
+   if (index < VERT_ATTRIB_MAX)
+      set_array(m, ARRAY_ATTRIB0 + index, size, type, stride, ptr);
+   else
+      m->ArraysValid = GL_FALSE;
+
+   c = (struct cmd_VertexAttribPointerARB *)
+      marshal_alloc(ctx, exec_VertexAttribPointerARB, sizeof(*c));
+   c->index = index;
+   c->size = size;
+   c->type = type;
+   c->normalized = normalized;
+   c->stride = stride;
+   c->ptr = ptr;
+}
+
+
+static void GLAPIENTRY
+track_EnableVertexAttribArrayARB(GLuint index)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (index < VERT_ATTRIB_MAX)
+      ctx->Marshal->Arrays[ARRAY_ATTRIB0 + index].Enabled = GL_TRUE;
+   marshal_EnableVertexAttribArrayARB(index);
+}
+
+
+static void GLAPIENTRY
+track_DisableVertexAttribArrayARB(GLuint index)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (index < VERT_ATTRIB_MAX)
+      ctx->Marshal->Arrays[ARRAY_ATTRIB0 + index].Enabled = GL_FALSE;
+   marshal_DisableVertexAttribArrayARB(index);
+}
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Draw calls                                                  */
+/*@{*/
+
+/**
+ * A client memory array copied into a draw command.
+ */
+struct marshal_draw_array
+{
+   GLuint Array;              /**< index into gl_marshal_context::Arrays */
+   GLuint ElementSize;
+   GLuint Offset;             /**< of the copied elements in the command */
+};
+
+
+/**
+ * glDrawArrays/Elements/RangeElements.  Followed by NumArrays
+ * marshal_draw_array structs and the copied data.
+ */
+struct cmd_draw
+{
+   struct marshal_cmd_base Base;
+   GLenum Mode;
+   GLsizei Count;
+   GLenum Type;               /**< index type, 0 for glDrawArrays */
+   GLuint Start, End;         /**< range of the vertices used */
+   GLboolean Range;           /**< call glDrawRangeElements */
+   GLuint NumArrays;
+   GLuint IndexOffset;        /**< of the copied indices, or 0 */
+   const GLvoid *Indices;     /**< indices in the element buffer */
+};
+
+
+static void
+exec_draw(GLcontext *ctx, const void *cmd)
+{
+   const struct cmd_draw *c = (const struct cmd_draw *) cmd;
+   const struct marshal_draw_array *arrays =
+      (const struct marshal_draw_array *) (c + 1);
+   struct gl_array_object *obj = ctx->Array.ArrayObj;
+   const GLvoid *indices = c->Indices;
+   GLuint i;
+
+   if (c->NumArrays) {
+      /* draw from an array object pointing to the copies */
+      struct gl_array_object *copy = &ctx->Marshal->DrawArrayObj;
+
+      *copy = *obj;
+      for (i = 0; i < c->NumArrays; i++) {
+         struct gl_client_array *a = get_array(copy, arrays[i].Array);
+         if (a->Enabled && (!a->BufferObj || a->BufferObj->Name == 0) &&
+             element_size(a->Size, a->Type) == arrays[i].ElementSize) {
+            a->Ptr = (const GLubyte *) c + arrays[i].Offset
+               - c->Start * arrays[i].ElementSize;
+            a->StrideB = arrays[i].ElementSize;
+         }
+      }
+
+      ctx->Array.ArrayObj = copy;
+      ctx->Array.NewState |= _NEW_ARRAY_ALL;
+      ctx->NewState |= _NEW_ARRAY;
+   }
+
+   if (c->IndexOffset)
+      indices = (const GLubyte *) c + c->IndexOffset;
+
+   if (!c->Type)
+      CALL_DrawArrays(ctx->CurrentDispatch, (c->Mode, c->Start, c->Count));
+   else if (c->Range)
+      CALL_DrawRangeElements(ctx->CurrentDispatch,
+                             (c->Mode, c->Start, c->End, c->Count,
+                              c->Type, indices));
+   else
+      CALL_DrawElements(ctx->CurrentDispatch,
+                        (c->Mode, c->Count, c->Type, indices));
+
+   if (c->NumArrays) {
+      ctx->Array.ArrayObj = obj;
+      ctx->Array.NewState |= _NEW_ARRAY_ALL;
+      ctx->NewState |= _NEW_ARRAY;
+   }
+}
+
+
+static void
+index_range(GLenum type, const GLvoid *indices, GLsizei count,
+            GLuint *min, GLuint *max)
+{
+   GLuint lo = ~0u, hi = 0;
+   GLsizei i;
+
+   if (type == GL_UNSIGNED_INT) {
+      const GLuint *ui = (const GLuint *) indices;
+      for (i = 0; i < count; i++) {
+         lo = MIN2(lo, ui[i]);
+         hi = MAX2(hi, ui[i]);
+      }
+   }
+   else if (type == GL_UNSIGNED_SHORT) {
+      const GLushort *us = (const GLushort *) indices;
+      for (i = 0; i < count; i++) {
+         lo = MIN2(lo, us[i]);
+         hi = MAX2(hi, us[i]);
+      }
+   }
+   else {
+      const GLubyte *ub = (const GLubyte *) indices;
+      for (i = 0; i < count; i++) {
+         lo = MIN2(lo, ub[i]);
+         hi = MAX2(hi, ub[i]);
+      }
+   }
+
+   *min = lo;
+   *max = hi;
+}
+
+
+/**
+ * Record a draw call, copying the vertices it uses from client memory
+ * arrays and indices from client memory.
+ * \param start, end  range of the vertices used, for glDrawArrays and
+ *                    glDrawRangeElements
+ * \param type  index type, or 0 for glDrawArrays
+ * \return GL_FALSE if the draw has to be executed synchronously
+ */
+static GLboolean
+marshal_draw(GLcontext *ctx, GLenum mode, GLuint start, GLuint end,
+             GLsizei count, GLenum type, const GLvoid *indices,
+             GLboolean range)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+   struct marshal_draw_array arrays[NUM_ARRAYS];
+   struct marshal_draw_array *dst;
+   struct cmd_draw *cmd;
+   const GLboolean clientIndices = type && !m->ElementBuffer;
+   GLuint numArrays = 0, indexSize = 0, size, i;
+
+   if (!m->ArraysValid || count <= 0)
+      return GL_FALSE;
+
+   for (i = 0; i < NUM_ARRAYS; i++) {
+      const struct marshal_array *s = &m->Arrays[i];
+      if (s->Enabled && s->Client) {
+         if (!s->ElementSize)
+            return GL_FALSE;
+         arrays[numArrays].Array = i;
+         arrays[numArrays].ElementSize = s->ElementSize;
+         numArrays++;
+      }
+   }
+
+   if (type) {
+      switch (type) {
+      case GL_UNSIGNED_BYTE:
+         indexSize = sizeof(GLubyte);
+         break;
+      case GL_UNSIGNED_SHORT:
+         indexSize = sizeof(GLushort);
+         break;
+      case GL_UNSIGNED_INT:
+         indexSize = sizeof(GLuint);
+         break;
+      default:
+         return GL_FALSE;
+      }
+
+      if (clientIndices && count > MARSHAL_MAX_DRAW_SIZE)
+         return GL_FALSE;
+
+      if (numArrays) {
+         /* the indices would have to be read from the buffer object */
+         if (!clientIndices)
+            return GL_FALSE;
+         index_range(type, indices, count, &start, &end);
+      }
+   }
+
+   if (numArrays && (end < start || end - start >= MARSHAL_MAX_DRAW_SIZE))
+      return GL_FALSE;
+
+   size = ALIGN8(sizeof(struct cmd_draw) +
+                 numArrays * sizeof(struct marshal_draw_array));
+   if (clientIndices)
+      size += ALIGN8(count * indexSize);
+   for (i = 0; i < numArrays; i++) {
+      arrays[i].Offset = size;
+      size += ALIGN8((end - start + 1) * arrays[i].ElementSize);
+   }
+   if (size > MARSHAL_MAX_DRAW_SIZE)
+      return GL_FALSE;
+
+   cmd = (struct cmd_draw *) marshal_alloc(ctx, exec_draw, size);
+   cmd->Mode = mode;
+   cmd->Count = count;
+   cmd->Type = type;
+   cmd->Start = start;
+   cmd->End = end;
+   cmd->Range = range;
+   cmd->NumArrays = numArrays;
+   cmd->IndexOffset = 0;
+   cmd->Indices = indices;
+
+   dst = (struct marshal_draw_array *) (cmd + 1);
+   for (i = 0; i < numArrays; i++) {
+      const struct marshal_array *s = &m->Arrays[arrays[i].Array];
+      const GLuint elemSize = arrays[i].ElementSize;
+      const GLubyte *src = s->Ptr + start * s->StrideB;
+      GLubyte *data = (GLubyte *) cmd + arrays[i].Offset;
+
+      if (s->StrideB == (GLsizei) elemSize) {
+         MEMCPY(data, src, (end - start + 1) * elemSize);
+      }
+      else {
+         GLuint j;
+         for (j = start; j <= end; j++) {
+            MEMCPY(data, src, elemSize);
+            data += elemSize;
+            src += s->StrideB;
+         }
+      }
+      dst[i] = arrays[i];
+   }
+
+   if (clientIndices) {
+      cmd->IndexOffset = ALIGN8(sizeof(struct cmd_draw) +
+                                numArrays * sizeof(struct marshal_draw_array));
+      MEMCPY((GLubyte *) cmd + cmd->IndexOffset, indices, count * indexSize);
+   }
+
+   return GL_TRUE;
+}
+
+
+static void GLAPIENTRY
+marshal_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (first < 0 ||
+       !marshal_draw(ctx, mode, first, first + count - 1, count,
+                     0, NULL, GL_FALSE))
+      sync_DrawArrays(mode, first, count);
+}
+
+
+static void GLAPIENTRY
+marshal_DrawElements(GLenum mode, GLsizei count, GLenum type,
+                     const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (!marshal_draw(ctx, mode, 0, 0, count, type, indices, GL_FALSE))
+      sync_DrawElements(mode, count, type, indices);
+}
+
+
+static void GLAPIENTRY
+marshal_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                          GLsizei count, GLenum type, const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (end < start ||
+       !marshal_draw(ctx, mode, start, end, count, type, indices, GL_TRUE))
+      sync_DrawRangeElements(mode, start, end, count, type, indices);
+}
+
+/*@}*/
+
+
+/**
+ * Make the dispatch table for the application thread: everything is
+ * synchronous except the functions above.
+ */
+static struct _glapi_table *
+create_dispatch(GLcontext *ctx)
+{
+   const GLuint numStatic = sizeof(struct _glapi_table) / sizeof(_glapi_proc);
+   const GLuint numEntries = MAX2(_glapi_get_dispatch_table_size(), numStatic);
+   _glapi_proc *entries;
+   struct _glapi_table *t;
+   GLuint i;
+
+   ASSERT(Elements(sync_table) >= numStatic);
+   (void) sync_unused_table;
+
+   entries = (_glapi_proc *) _mesa_malloc(numEntries * sizeof(_glapi_proc));
+   if (!entries)
+      return NULL;
+
+   for (i = 0; i < numStatic; i++)
+      entries[i] = sync_table[i];
+   /* functions added at runtime can't be synchronized */
+   for (; i < numEntries; i++)
+      entries[i] = ((_glapi_proc *) ctx->Exec)[i];
+
+   t = (struct _glapi_table *) entries;
+
+   SET_Begin(t, marshal_Begin);
+   SET_End(t, marshal_End);
+   SET_Vertex2f(t, marshal_Vertex2f);
+   SET_Vertex3f(t, marshal_Vertex3f);
+   SET_Vertex4f(t, marshal_Vertex4f);
+   SET_Vertex2fv(t, marshal_Vertex2fv);
+   SET_Vertex3fv(t, marshal_Vertex3fv);
+   SET_Vertex4fv(t, marshal_Vertex4fv);
+   SET_Normal3f(t, marshal_Normal3f);
+   SET_Normal3fv(t, marshal_Normal3fv);
+   SET_Color3f(t, marshal_Color3f);
+   SET_Color4f(t, marshal_Color4f);
+   SET_Color3fv(t, marshal_Color3fv);
+   SET_Color4fv(t, marshal_Color4fv);
+   SET_Color3ub(t, marshal_Color3ub);
+   SET_Color4ub(t, marshal_Color4ub);
+   SET_Color3ubv(t, marshal_Color3ubv);
+   SET_Color4ubv(t, marshal_Color4ubv);
+   SET_TexCoord2f(t, marshal_TexCoord2f);
+   SET_TexCoord3f(t, marshal_TexCoord3f);
+   SET_TexCoord4f(t, marshal_TexCoord4f);
+   SET_TexCoord2fv(t, marshal_TexCoord2fv);
+   SET_TexCoord3fv(t, marshal_TexCoord3fv);
+   SET_TexCoord4fv(t, marshal_TexCoord4fv);
+   SET_MultiTexCoord2fARB(t, marshal_MultiTexCoord2fARB);
+   SET_Materialfv(t, marshal_Materialfv);
+   SET_Materialf(t, marshal_Materialf);
+
+   SET_MatrixMode(t, marshal_MatrixMode);
+   SET_LoadIdentity(t, marshal_LoadIdentity);
+   SET_PushMatrix(t, marshal_PushMatrix);
+   SET_PopMatrix(t, marshal_PopMatrix);
+   SET_LoadMatrixf(t, marshal_LoadMatrixf);
+   SET_LoadMatrixd(t, marshal_LoadMatrixd);
+   SET_MultMatrixf(t, marshal_MultMatrixf);
+   SET_MultMatrixd(t, marshal_MultMatrixd);
+   SET_Translatef(t, marshal_Translatef);
+   SET_Translated(t, marshal_Translated);
+   SET_Scalef(t, marshal_Scalef);
+   SET_Scaled(t, marshal_Scaled);
+   SET_Rotatef(t, marshal_Rotatef);
+   SET_Rotated(t, marshal_Rotated);
+   SET_Ortho(t, marshal_Ortho);
+   SET_Frustum(t, marshal_Frustum);
+   SET_Viewport(t, marshal_Viewport);
+   SET_DepthRange(t, marshal_DepthRange);
+
+   SET_Enable(t, track_Enable);
+   SET_Disable(t, track_Disable);
+   SET_PushAttrib(t, marshal_PushAttrib);
+   SET_PopAttrib(t, marshal_PopAttrib);
+   SET_ShadeModel(t, marshal_ShadeModel);
+   SET_CullFace(t, marshal_CullFace);
+   SET_FrontFace(t, marshal_FrontFace);
+   SET_PolygonMode(t, marshal_PolygonMode);
+   SET_PolygonOffset(t, marshal_PolygonOffset);
+   SET_LineWidth(t, marshal_LineWidth);
+   SET_LineStipple(t, marshal_LineStipple);
+   SET_PointSize(t, marshal_PointSize);
+   SET_Hint(t, marshal_Hint);
+   SET_DepthFunc(t, marshal_DepthFunc);
+   SET_DepthMask(t, marshal_DepthMask);
+   SET_AlphaFunc(t, marshal_AlphaFunc);
+   SET_BlendFunc(t, marshal_BlendFunc);
+   SET_BlendFuncSeparateEXT(t, marshal_BlendFuncSeparateEXT);
+   SET_BlendEquation(t, marshal_BlendEquation);
+   SET_BlendColor(t, marshal_BlendColor);
+   SET_LogicOp(t, marshal_LogicOp);
+   SET_ColorMask(t, marshal_ColorMask);
+   SET_StencilFunc(t, marshal_StencilFunc);
+   SET_StencilOp(t, marshal_StencilOp);
+   SET_StencilMask(t, marshal_StencilMask);
+   SET_Scissor(t, marshal_Scissor);
+   SET_ColorMaterial(t, marshal_ColorMaterial);
+   SET_Lightf(t, marshal_Lightf);
+   SET_Lightfv(t, marshal_Lightfv);
+   SET_LightModeli(t, marshal_LightModeli);
+   SET_LightModelfv(t, marshal_LightModelfv);
+   SET_Fogf(t, marshal_Fogf);
+   SET_Fogi(t, marshal_Fogi);
+   SET_Fogfv(t, marshal_Fogfv);
+   SET_PixelStorei(t, marshal_PixelStorei);
+
+   SET_ActiveTextureARB(t, marshal_ActiveTextureARB);
+   SET_BindTexture(t, marshal_BindTexture);
+   SET_TexParameteri(t, marshal_TexParameteri);
+   SET_TexParameterf(t, marshal_TexParameterf);
+   SET_TexParameterfv(t, marshal_TexParameterfv);
+   SET_TexEnvi(t, marshal_TexEnvi);
+   SET_TexEnvf(t, marshal_TexEnvf);
+   SET_TexEnvfv(t, marshal_TexEnvfv);
+   SET_TexGeni(t, marshal_TexGeni);
+
+   SET_ClearColor(t, marshal_ClearColor);
+   SET_ClearDepth(t, marshal_ClearDepth);
+   SET_ClearStencil(t, marshal_ClearStencil);
+   SET_Clear(t, marshal_Clear);
+   SET_CallList(t, marshal_CallList);
+   SET_Flush(t, marshal_Flush);
+
+   SET_EnableClientState(t, track_EnableClientState);
+   SET_DisableClientState(t, track_DisableClientState);
+   SET_ClientActiveTextureARB(t, track_ClientActiveTextureARB);
+   SET_BindBufferARB(t, track_BindBufferARB);
+   SET_VertexPointer(t, track_VertexPointer);
+   SET_NormalPointer(t, track_NormalPointer);
+   SET_ColorPointer(t, track_ColorPointer);
+   SET_SecondaryColorPointerEXT(t, track_SecondaryColorPointerEXT);
+   SET_FogCoordPointerEXT(t, track_FogCoordPointerEXT);
+   SET_IndexPointer(t, track_IndexPointer);
+   SET_EdgeFlagPointer(t, track_EdgeFlagPointer);
+   SET_TexCoordPointer(t, track_TexCoordPointer);
+   SET_VertexAttribPointerARB(t, track_VertexAttribPointerARB);
+   SET_EnableVertexAttribArrayARB(t, track_EnableVertexAttribArrayARB);
+   SET_DisableVertexAttribArrayARB(t, track_DisableVertexAttribArrayARB);
+   SET_DrawArrays(t, marshal_DrawArrays);
+   SET_DrawElements(t, marshal_DrawElements);
+   SET_DrawRangeElements(t, marshal_DrawRangeElements);
+
+   return t;
+}
+
+
+/**
+ * Called during context initialization.  Sets up the command queue if
+ * MESA_GLTHREAD is set; the worker thread is started by
+ * _mesa_bind_marshal().
+ */
+void
+_mesa_init_marshal(GLcontext *ctx)
+{
+   struct gl_marshal_context *m;
+
+   if (!_mesa_getenv("MESA_GLTHREAD"))
+      return;
+
+   m = CALLOC_STRUCT(gl_marshal_context);
+   if (!m)
+      return;
+
+   pthread_mutex_init(&m->Mutex, NULL);
+   pthread_cond_init(&m->WorkCond, NULL);
+   pthread_cond_init(&m->DoneCond, NULL);
+   m->Current = &m->Batches[0];
+
+   ctx->Marshal = m;
+}
+
+
+/**
+ * Execute the recorded commands, stop the worker thread and go back to
+ * executing commands synchronously.
+ */
+void
+_mesa_free_marshal(GLcontext *ctx)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+
+   if (!m)
+      return;
+
+   if (m->Running) {
+      wait_idle(m);
+
+      pthread_mutex_lock(&m->Mutex);
+      m->Quit = GL_TRUE;
+      pthread_cond_signal(&m->WorkCond);
+      pthread_mutex_unlock(&m->Mutex);
+
+      pthread_join(m->Thread, NULL);
+   }
+
+   if (m->Dispatch) {
+      if (_glapi_get_dispatch() == m->Dispatch)
+         _glapi_set_dispatch(ctx->CurrentDispatch);
+      _mesa_free(m->Dispatch);
+   }
+
+   pthread_mutex_destroy(&m->Mutex);
+   pthread_cond_destroy(&m->WorkCond);
+   pthread_cond_destroy(&m->DoneCond);
+   _mesa_free(m);
+   ctx->Marshal = NULL;
+}
+
+
+/**
+ * Called by _mesa_make_current() when the context was made current in
+ * the calling thread.  Starts the worker thread the first time and
+ * installs the recording dispatch table.
+ */
+void
+_mesa_bind_marshal(GLcontext *ctx)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+
+   if (!m)
+      return;
+
+   if (!m->Running) {
+      if (!m->Dispatch)
+         m->Dispatch = create_dispatch(ctx);
+
+      /* the worker thread makes the dispatch and context pointers
+       * per-thread; be sure this thread is the one known to glapi
+       */
+      _glapi_check_multithread();
+
+      if (!m->Dispatch ||
+          pthread_create(&m->Thread, NULL, marshal_thread, ctx) != 0) {
+         _mesa_warning(ctx, "Unable to create GL command thread");
+         _mesa_free_marshal(ctx);
+         return;
+      }
+
+      pthread_mutex_lock(&m->Mutex);
+      while (!m->Running)
+         pthread_cond_wait(&m->DoneCond, &m->Mutex);
+      pthread_mutex_unlock(&m->Mutex);
+   }
+
+   refresh_arrays(ctx);
+   _glapi_set_dispatch(m->Dispatch);
+}
+
+
+/**
+ * Wait until all the recorded commands were executed.  Called before the
+ * window system code looks at or changes the context or its buffers.
+ */
+void
+_mesa_finish_marshal(GLcontext *ctx)
+{
+   if (ctx && ctx->Marshal && ctx->Marshal->Running &&
+       !pthread_equal(pthread_self(), ctx->Marshal->Thread))
+      wait_idle(ctx->Marshal);
+}
+
+
+#else /* PTHREADS */
+
+
+void
+_mesa_init_marshal(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+
+void
+_mesa_free_marshal(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+
+void
+_mesa_bind_marshal(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+
+void
+_mesa_finish_marshal(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+
+#endif /* PTHREADS */
@@ -149,7 +149,7 @@ _mesa_MatrixMode( GLenum mode )
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
    if (ctx->Transform.MatrixMode == mode && mode != GL_TEXTURE)
-      return;
+      RETURN_UNCHANGED(ctx);
    FLUSH_VERTICES(ctx, _NEW_TRANSFORM);
 
    switch (mode) {
@@ -583,11 +583,18 @@ _mesa_set_viewport( GLcontext *ctx, GLint x, GLint y,
    width  = CLAMP(width,  1, (GLsizei) ctx->Const.MaxViewportWidth);
    height = CLAMP(height, 1, (GLsizei) ctx->Const.MaxViewportHeight);
 
-   ctx->Viewport.X = x;
-   ctx->Viewport.Width = width;
-   ctx->Viewport.Y = y;
-   ctx->Viewport.Height = height;
-   ctx->NewState |= _NEW_VIEWPORT;
+   if (ctx->Viewport.X != x || ctx->Viewport.Width != width ||
+       ctx->Viewport.Y != y || ctx->Viewport.Height != height) {
+      ctx->Viewport.X = x;
+      ctx->Viewport.Width = width;
+      ctx->Viewport.Y = y;
+      ctx->Viewport.Height = height;
+      ctx->NewState |= _NEW_VIEWPORT;
+   }
+   else {
+      /* still tell the driver, see below */
+      ctx->StateFilter.Unchanged++;
+   }
 
 #if 1
    /* XXX remove this someday.  Currently the DRI drivers rely on
@@ -622,14 +629,20 @@ _mesa_set_viewport( GLcontext *ctx, GLint x, GLint y,
 void GLAPIENTRY
 _mesa_DepthRange( GLclampd nearval, GLclampd farval )
 {
+   GLfloat n, f;
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_BEGIN_END_AND_FLUSH(ctx);
 
    if (MESA_VERBOSE&VERBOSE_API)
       _mesa_debug(ctx, "glDepthRange %f %f\n", nearval, farval);
 
-   ctx->Viewport.Near = (GLfloat) CLAMP( nearval, 0.0, 1.0 );
-   ctx->Viewport.Far = (GLfloat) CLAMP( farval, 0.0, 1.0 );
+   n = (GLfloat) CLAMP( nearval, 0.0, 1.0 );
+   f = (GLfloat) CLAMP( farval, 0.0, 1.0 );
+   if (ctx->Viewport.Near == n && ctx->Viewport.Far == f)
+      RETURN_UNCHANGED(ctx);
+
+   ctx->Viewport.Near = n;
+   ctx->Viewport.Far = f;
    ctx->NewState |= _NEW_VIEWPORT;
 
 #if 1
@@ -28,11 +28,18 @@
  */
 
 #include "imports.h"
+#include "macros.h"
 #include "mipmap.h"
 #include "texcompress.h"
 #include "texformat.h"
 #include "teximage.h"
+#include "texstore.h"
 #include "image.h"
+#include "threadpool.h"
+
+#ifdef USE_X86_64_ASM
+#include "x86-64/x86-64.h"
+#endif
 
 
 
@@ -133,6 +140,28 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
+#ifdef USE_X86_64_ASM
+   if (colStride == 2 &&
+       (datatype == GL_UNSIGNED_BYTE || datatype == GL_FLOAT)) {
+      /* SSE2 for the first texels, C for the rest of the row */
+      const GLint bpt = bytes_per_pixel(datatype, comps);
+      const GLuint done = (datatype == GL_UNSIGNED_BYTE)
+         ? _mesa_sse2_reduce_ubyte_row(comps, (const GLubyte *) srcRowA,
+                                       (const GLubyte *) srcRowB,
+                                       dstWidth, (GLubyte *) dstRow)
+         : _mesa_sse2_reduce_float_row(comps, (const GLfloat *) srcRowA,
+                                       (const GLfloat *) srcRowB,
+                                       dstWidth, (GLfloat *) dstRow);
+      if (done == (GLuint) dstWidth)
+         return;
+      srcRowA = (const GLubyte *) srcRowA + 2 * done * bpt;
+      srcRowB = (const GLubyte *) srcRowB + 2 * done * bpt;
+      dstRow = (GLubyte *) dstRow + done * bpt;
+      srcWidth -= 2 * done;
+      dstWidth -= done;
+   }
+#endif
+
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
@@ -1333,6 +1362,107 @@ _mesa_generate_mipmap_level(GLenum target,
 }
 
 
+/** Smallest 2D level (in texels) which is split up between threads */
+#define MIN_THREADED_TEXELS (256 * 256)
+
+/** Smallest band of destination rows made by one task */
+#define MIN_BAND_ROWS 8
+
+
+/**
+ * A 2D level being made by several threads, see generate_mipmap_level().
+ */
+struct mipmap_band_job
+{
+   GLenum datatype;
+   GLuint comps;
+   const GLubyte *src;
+   GLint srcWidth, srcRowBytes;
+   GLubyte *dst;
+   GLint dstWidth, dstHeight, dstRowBytes;
+   GLint rowsPerTask;
+};
+
+
+/**
+ * Task function: make one band of rows of a 2D level without border.
+ */
+static void
+make_2d_mipmap_band(void *data, GLuint task, GLuint thread)
+{
+   const struct mipmap_band_job *job = (const struct mipmap_band_job *) data;
+   const GLint first = task * job->rowsPerTask;
+   const GLint last = MIN2(first + job->rowsPerTask, job->dstHeight);
+   const GLubyte *srcA = job->src + 2 * first * job->srcRowBytes;
+   GLubyte *dst = job->dst + first * job->dstRowBytes;
+   GLint row;
+
+   (void) thread;
+
+   for (row = first; row < last; row++) {
+      do_row(job->datatype, job->comps, job->srcWidth,
+             srcA, srcA + job->srcRowBytes, job->dstWidth, dst);
+      srcA += 2 * job->srcRowBytes;
+      dst += job->dstRowBytes;
+   }
+}
+
+
+/**
+ * Same as _mesa_generate_mipmap_level(), but large 2D levels without
+ * border are made by several threads, each doing a band of rows.
+ */
+static void
+generate_mipmap_level(GLcontext *ctx, GLenum target,
+                      GLenum datatype, GLuint comps,
+                      GLint border,
+                      GLint srcWidth, GLint srcHeight, GLint srcDepth,
+                      const GLubyte *srcData,
+                      GLint srcRowStride,
+                      GLint dstWidth, GLint dstHeight, GLint dstDepth,
+                      GLubyte *dstData,
+                      GLint dstRowStride)
+{
+   struct _mesa_threadpool *pool = NULL;
+
+   if ((target == GL_TEXTURE_2D ||
+        (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB &&
+         target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_ARB)) &&
+       border == 0 && srcHeight > 1 &&
+       dstWidth * dstHeight >= MIN_THREADED_TEXELS)
+      pool = _mesa_get_texture_pool(ctx);
+
+   if (pool && _mesa_threadpool_num_threads(pool) > 1) {
+      const GLint bpt = bytes_per_pixel(datatype, comps);
+      const GLint numThreads = _mesa_threadpool_num_threads(pool);
+      struct mipmap_band_job job;
+
+      job.datatype = datatype;
+      job.comps = comps;
+      job.src = srcData;
+      job.srcWidth = srcWidth;
+      job.srcRowBytes = srcRowStride * bpt;
+      job.dst = dstData;
+      job.dstWidth = dstWidth;
+      job.dstHeight = dstHeight;
+      job.dstRowBytes = dstRowStride * bpt;
+      /* a few bands per thread, to even out the work */
+      job.rowsPerTask = MAX2(dstHeight / (4 * numThreads), MIN_BAND_ROWS);
+
+      _mesa_threadpool_run(pool,
+                           (dstHeight + job.rowsPerTask - 1) / job.rowsPerTask,
+                           make_2d_mipmap_band, &job);
+   }
+   else {
+      _mesa_generate_mipmap_level(target, datatype, comps, border,
+                                  srcWidth, srcHeight, srcDepth,
+                                  srcData, srcRowStride,
+                                  dstWidth, dstHeight, dstDepth,
+                                  dstData, dstRowStride);
+   }
+}
+
+
 /**
  * compute next (level+1) image size
  * \return GL_FALSE if no smaller size can be generated (eg. src is 1x1x1 size)
@@ -1482,18 +1612,14 @@ _mesa_generate_mipmap(GLcontext *ctx, GLenum target,
                                          &dstWidth, &dstHeight, &dstDepth);
       if (!nextLevel) {
          /* all done */
-         if (srcImage->IsCompressed) {
-            _mesa_free((void *) srcData);
-            _mesa_free(dstData);
-         }
-         return;
+         break;
       }
 
       /* get dest gl_texture_image */
       dstImage = _mesa_get_tex_image(ctx, texObj, target, level + 1);
       if (!dstImage) {
          _mesa_error(ctx, GL_OUT_OF_MEMORY, "generating mipmaps");
-         return;
+         break;
       }
 
       if (dstImage->ImageOffsets)
@@ -1531,7 +1657,7 @@ _mesa_generate_mipmap(GLcontext *ctx, GLenum target,
          dstImage->Data = _mesa_alloc_texmemory(dstImage->CompressedSize);
          if (!dstImage->Data) {
             _mesa_error(ctx, GL_OUT_OF_MEMORY, "generating mipmaps");
-            return;
+            break;
          }
          /* srcData and dstData are already set */
          ASSERT(srcData);
@@ -1550,11 +1676,11 @@ _mesa_generate_mipmap(GLcontext *ctx, GLenum target,
          dstData = (GLubyte *) dstImage->Data;
       }
 
-      _mesa_generate_mipmap_level(target, datatype, comps, border,
-                                  srcWidth, srcHeight, srcDepth, 
-                                  srcData, srcImage->RowStride,
-                                  dstWidth, dstHeight, dstDepth, 
-                                  dstData, dstImage->RowStride);
+      generate_mipmap_level(ctx, target, datatype, comps, border,
+                            srcWidth, srcHeight, srcDepth,
+                            srcData, srcImage->RowStride,
+                            dstWidth, dstHeight, dstDepth,
+                            dstData, dstImage->RowStride);
 
 
       if (dstImage->IsCompressed) {
@@ -1580,6 +1706,12 @@ _mesa_generate_mipmap(GLcontext *ctx, GLenum target,
       }
 
    } /* loop over mipmap levels */
+
+   if (srcImage->IsCompressed) {
+      /* the two scratch images used for all levels */
+      _mesa_free((void *) srcData);
+      _mesa_free(dstData);
+   }
 }
 
 
@@ -1630,6 +1630,8 @@ struct gl_buffer_object
    GLsizeiptrARB Size;       /**< Size of storage in bytes */
    GLubyte *Data;            /**< Location of storage either in RAM or VRAM. */
    GLboolean OnCard;         /**< Is buffer in VRAM? (hardware drivers) */
+   GLuint Stamp;             /**< Zeroed when the contents may change, so
+                                  that data derived from them is redone */
 };
 
 
@@ -2238,6 +2240,24 @@ struct gl_shared_state
 
 
 
+/**
+ * Coarse depth information for a software depth buffer.  The buffer is
+ * divided into DEPTH_TILE_SIZE x DEPTH_TILE_SIZE tiles and every depth
+ * value within a tile lies within [Min, Max] of the tile.  Allocated
+ * along with the buffer storage; the contents are maintained by swrast
+ * (see swrast/s_hiz.c).
+ */
+struct gl_depth_tiles
+{
+   GLuint Cols, Rows;    /**< number of tiles across and down */
+   GLuint *Min;          /**< [Rows * Cols] lower bound of each tile */
+   GLuint *Max;          /**< [Rows * Cols] upper bound of each tile */
+   GLuint *Writes;       /**< values written since a tile's bounds were
+                          *   computed from the depth buffer */
+   GLboolean Valid;      /**< FALSE until the bounds are initialized */
+};
+
+
 /**
  * A renderbuffer stores colors or depth values or stencil values.
  * A framebuffer object will have a collection of these.
@@ -2269,6 +2289,7 @@ struct gl_renderbuffer
    GLubyte DepthBits;
    GLubyte StencilBits;
    GLvoid *Data;        /**< This may not be used by some kinds of RBs */
+   struct gl_depth_tiles *DepthTiles; /**< Only for software depth buffers */
 
    /* Used to wrap one renderbuffer around another: */
    struct gl_renderbuffer *Wrapped;
@@ -2829,6 +2850,16 @@ struct gl_matrix_stack
  */
 union node;
 typedef union node Node;
+union replay_node;
+
+/** Asynchronous command queue, see marshal.c */
+struct gl_marshal_context;
+
+/** Pipeline stage cycle counts, see profile.c */
+struct gl_profile;
+
+/** Worker threads, see threadpool.c */
+struct _mesa_threadpool;
 
 
 /* This has to be included here. */
@@ -2875,6 +2906,7 @@ struct mesa_display_list
    Node *node;
    GLuint id;
    GLbitfield flags;
+   union replay_node *replay;   /**< compiled form of the list, or NULL */
 };
 
 
@@ -2884,6 +2916,7 @@ struct mesa_display_list
 struct gl_dlist_state
 {
    GLuint CallDepth;		/**< Current recursion calling depth */
+   GLboolean Replay;		/**< Compile lists for replay? */
 
    struct mesa_display_list *CurrentList;
    Node *CurrentListPtr;	/**< Head of list being compiled */
@@ -2907,6 +2940,37 @@ struct gl_dlist_state
 };
 
 
+/**
+ * Copies of attribute groups as they were when last validated, used to
+ * drop the _NEW_* flags of groups which were set back to the same state
+ * before the next validation (see _mesa_update_state_locked()).
+ */
+struct gl_state_filter
+{
+   GLboolean Enabled;		/**< MESA_NO_STATE_FILTER not set */
+   GLbitfield Valid;		/**< _NEW_* flags of the valid copies */
+
+   struct gl_colorbuffer_attrib Color;
+   struct gl_depthbuffer_attrib Depth;
+   struct gl_fog_attrib Fog;
+   struct gl_hint_attrib Hint;
+   struct gl_light_attrib Light;
+   struct gl_line_attrib Line;
+   struct gl_polygon_attrib Polygon;
+   GLuint PolygonStipple[32];
+   struct gl_scissor_attrib Scissor;
+   struct gl_stencil_attrib Stencil;
+   struct gl_transform_attrib Transform;
+
+   /* Statistics, printed on context destruction if MESA_STATE_STATS
+    * is set.
+    */
+   GLuint Unchanged;		/**< state calls which changed nothing */
+   GLuint Updates;		/**< state validations */
+   GLuint Dropped;		/**< group flags dropped by validations */
+};
+
+
 /**
  * Mesa rendering context.
  *
@@ -2927,6 +2991,7 @@ struct __GLcontextRec
    struct _glapi_table *Save;	/**< Display list save functions */
    struct _glapi_table *Exec;	/**< Execute functions */
    struct _glapi_table *CurrentDispatch;  /**< == Save or Exec !! */
+   struct gl_marshal_context *Marshal;    /**< for MESA_GLTHREAD or NULL */
    /*@}*/
 
    GLvisual Visual;
@@ -3054,6 +3119,7 @@ struct __GLcontextRec
    GLenum ErrorValue;        /**< Last error code */
    GLenum RenderMode;        /**< either GL_RENDER, GL_SELECT, GL_FEEDBACK */
    GLbitfield NewState;      /**< bitwise-or of _NEW_* flags */
+   struct gl_state_filter StateFilter; /**< drops redundant _NEW_* flags */
 
    /** \name Derived state */
    /*@{*/
@@ -3079,6 +3145,7 @@ struct __GLcontextRec
    /** \name For debugging/development only */
    /*@{*/
    GLboolean FirstTimeCurrent;
+   struct gl_profile *Profile;  /**< stage cycle counts, see profile.c */
    /*@}*/
 
    /** Dither disable via MESA_NO_DITHER env var */
@@ -3087,6 +3154,9 @@ struct __GLcontextRec
    /** software compression/decompression supported or not */
    GLboolean Mesa_DXTn;
 
+   /** Threads for mipmap generation and texture compression, see texstore.c */
+   struct _mesa_threadpool *TexturePool;
+
    /** Core tnl module support */
    struct gl_tnl_module TnlModule;
 
@@ -53,7 +53,7 @@ _mesa_PointSize( GLfloat size )
    }
 
    if (ctx->Point.Size == size)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_POINT);
    ctx->Point.Size = size;
@@ -104,7 +104,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
       case GL_DISTANCE_ATTENUATION_EXT:
          if (ctx->Extensions.EXT_point_parameters) {
             if (TEST_EQ_3V(ctx->Point.Params, params))
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    FLUSH_VERTICES(ctx, _NEW_POINT);
             COPY_3V(ctx->Point.Params, params);
             ctx->Point._Attenuated = (ctx->Point.Params[0] != 1.0 ||
@@ -130,7 +130,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
                return;
             }
             if (ctx->Point.MinSize == params[0])
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.MinSize = params[0];
          }
@@ -148,7 +148,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
                return;
             }
             if (ctx->Point.MaxSize == params[0])
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.MaxSize = params[0];
          }
@@ -166,7 +166,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
                return;
             }
             if (ctx->Point.Threshold == params[0])
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.Threshold = params[0];
          }
@@ -189,7 +189,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
                return;
             }
             if (ctx->Point.SpriteRMode == value)
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.SpriteRMode = value;
          }
@@ -208,7 +208,7 @@ _mesa_PointParameterfv( GLenum pname, const GLfloat *params)
                return;
             }
             if (ctx->Point.SpriteOrigin == value)
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.SpriteOrigin = value;
          }
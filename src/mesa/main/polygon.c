@@ -65,7 +65,7 @@ _mesa_CullFace( GLenum mode )
    }
 
    if (ctx->Polygon.CullFaceMode == mode)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_POLYGON);
    ctx->Polygon.CullFaceMode = mode;
@@ -101,7 +101,7 @@ _mesa_FrontFace( GLenum mode )
    }
 
    if (ctx->Polygon.FrontFace == mode)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_POLYGON);
    ctx->Polygon.FrontFace = mode;
@@ -144,21 +144,21 @@ _mesa_PolygonMode( GLenum face, GLenum mode )
    switch (face) {
    case GL_FRONT:
       if (ctx->Polygon.FrontMode == mode)
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_POLYGON);
       ctx->Polygon.FrontMode = mode;
       break;
    case GL_FRONT_AND_BACK:
       if (ctx->Polygon.FrontMode == mode &&
 	  ctx->Polygon.BackMode == mode)
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_POLYGON);
       ctx->Polygon.FrontMode = mode;
       ctx->Polygon.BackMode = mode;
       break;
    case GL_BACK:
       if (ctx->Polygon.BackMode == mode)
-	 return;
+	 RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_POLYGON);
       ctx->Polygon.BackMode = mode;
       break;
@@ -298,7 +298,7 @@ _mesa_PolygonOffset( GLfloat factor, GLfloat units )
 
    if (ctx->Polygon.OffsetFactor == factor &&
        ctx->Polygon.OffsetUnits == units)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_POLYGON);
    ctx->Polygon.OffsetFactor = factor;
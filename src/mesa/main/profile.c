@@ -0,0 +1,328 @@
+/**
+ * \file profile.c
+ * Cycle counts of the vertex pipeline stages, triangle functions and
+ * fragment span stages of a context.
+ *
+ * Profiling is enabled by setting MESA_PROFILE.  If its value is a
+ * number N > 0, the counts are printed and reset every N SwapBuffers,
+ * and once more when the context is destroyed.  Otherwise they are only
+ * collected, for the driver's query functions (OSMesaGetProfileSection).
+ *
+ * Instrumented code reads the clock with PROFILE_START and charges the
+ * time since the last clock read to a named section with PROFILE_LAP.
+ * Sections nest in the natural way: the "render" pipeline stage includes
+ * the triangle functions, which include the span stages.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include "glheader.h"
+#include "imports.h"
+#include "profile.h"
+
+#ifndef PROFILE_USE_RDTSC
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+
+/** Size of the name lookup table, a power of two */
+#define PROFILE_HASH_SIZE 128
+
+
+struct gl_profile_section
+{
+   const char *Name;
+   GLuint Calls;
+   GLuint64EXT Cycles;
+};
+
+
+struct gl_profile
+{
+   GLuint NumSections;
+   struct gl_profile_section Sections[MAX_PROFILE_SECTIONS];
+
+   /**
+    * Open addressed table mapping name addresses to Sections[] indexes.
+    * The same name string may live at several addresses, if it's used
+    * in several source files.
+    */
+   struct {
+      const char *Name;
+      GLuint Index;
+   } Hash[PROFILE_HASH_SIZE];
+
+   GLuint Frames;       /**< SwapBuffers calls since the last reset */
+   GLuint DumpFrames;   /**< print the counts every this many frames */
+};
+
+
+#ifndef PROFILE_USE_RDTSC
+GLuint64EXT
+_mesa_profile_time(void)
+{
+#if defined(__unix__) || defined(__APPLE__)
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return (GLuint64EXT) tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+   return (GLuint64EXT) clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+#endif
+
+
+/**
+ * Find or add the section called \p name.
+ * \return NULL if there are too many sections
+ */
+static struct gl_profile_section *
+find_section(struct gl_profile *prof, const char *name)
+{
+   GLuint h = (GLuint) ((unsigned long) name >> 3) & (PROFILE_HASH_SIZE - 1);
+   GLuint i, n;
+
+   for (n = 0; n < PROFILE_HASH_SIZE; n++) {
+      if (prof->Hash[h].Name == name)
+         return &prof->Sections[prof->Hash[h].Index];
+      if (!prof->Hash[h].Name)
+         break;
+      h = (h + 1) & (PROFILE_HASH_SIZE - 1);
+   }
+
+   /* first use of this address */
+   for (i = 0; i < prof->NumSections; i++) {
+      if (_mesa_strcmp(prof->Sections[i].Name, name) == 0)
+         break;
+   }
+   if (i == prof->NumSections) {
+      if (i == MAX_PROFILE_SECTIONS)
+         return NULL;
+      prof->Sections[i].Name = name;
+      prof->Sections[i].Calls = 0;
+      prof->Sections[i].Cycles = 0;
+      prof->NumSections++;
+   }
+
+   if (n < PROFILE_HASH_SIZE) {
+      prof->Hash[h].Name = name;
+      prof->Hash[h].Index = i;
+   }
+   return &prof->Sections[i];
+}
+
+
+GLuint64EXT
+_mesa_profile_lap(struct gl_profile *prof, const char *name,
+                  GLuint64EXT start)
+{
+   struct gl_profile_section *sec = find_section(prof, name);
+
+   if (sec) {
+      sec->Cycles += _mesa_profile_clock() - start;
+      sec->Calls++;
+   }
+
+   /* don't charge the bookkeeping to the next stage */
+   return _mesa_profile_clock();
+}
+
+
+struct gl_profile *
+_mesa_new_profile(void)
+{
+   return CALLOC_STRUCT(gl_profile);
+}
+
+
+void
+_mesa_delete_profile(struct gl_profile *prof)
+{
+   _mesa_free(prof);
+}
+
+
+/**
+ * Zero the counts.  The sections are kept, in the same order.
+ */
+void
+_mesa_reset_profile(struct gl_profile *prof)
+{
+   GLuint i;
+
+   for (i = 0; i < prof->NumSections; i++) {
+      prof->Sections[i].Calls = 0;
+      prof->Sections[i].Cycles = 0;
+   }
+   prof->Frames = 0;
+}
+
+
+/**
+ * Add the counts of \p src to \p dst and reset \p src.  Used for the
+ * profiles of rendering threads.
+ */
+void
+_mesa_merge_profile(struct gl_profile *dst, struct gl_profile *src)
+{
+   GLuint i;
+
+   for (i = 0; i < src->NumSections; i++) {
+      const struct gl_profile_section *s = &src->Sections[i];
+      if (s->Calls) {
+         struct gl_profile_section *d = find_section(dst, s->Name);
+         if (d) {
+            d->Calls += s->Calls;
+            d->Cycles += s->Cycles;
+         }
+      }
+   }
+   _mesa_reset_profile(src);
+}
+
+
+/**
+ * Return the name and counts of the index'th section, in order of first
+ * use, or GL_FALSE if there aren't that many sections.
+ */
+GLboolean
+_mesa_get_profile_section(const struct gl_profile *prof, GLuint index,
+                          const char **name, GLuint *calls,
+                          GLuint64EXT *cycles)
+{
+   if (!prof || index >= prof->NumSections)
+      return GL_FALSE;
+
+   *name = prof->Sections[index].Name;
+   *calls = prof->Sections[index].Calls;
+   *cycles = prof->Sections[index].Cycles;
+   return GL_TRUE;
+}
+
+
+/**
+ * Print the sections which were used since the last reset, the most
+ * expensive first.
+ */
+void
+_mesa_print_profile(const struct gl_profile *prof)
+{
+#ifdef PROFILE_USE_RDTSC
+   const char *units = "thousands of cycles";
+#else
+   const char *units = "milliseconds";
+#endif
+   GLuint order[MAX_PROFILE_SECTIONS];
+   GLuint i, j, n = 0;
+
+   for (i = 0; i < prof->NumSections; i++) {
+      const GLuint64EXT cycles = prof->Sections[i].Cycles;
+      if (!prof->Sections[i].Calls)
+         continue;
+      for (j = n; j > 0 && prof->Sections[order[j - 1]].Cycles < cycles; j--)
+         order[j] = order[j - 1];
+      order[j] = i;
+      n++;
+   }
+
+   if (prof->Frames)
+      _mesa_printf("Mesa: profile of %u frames, in %s\n", prof->Frames, units);
+   else
+      _mesa_printf("Mesa: profile, in %s\n", units);
+   _mesa_printf("Mesa: %14s %10s %10s  %s\n",
+                "total", "calls", "per call", "section");
+
+   for (i = 0; i < n; i++) {
+      const struct gl_profile_section *sec = &prof->Sections[order[i]];
+      const GLdouble total = (GLdouble) (GLint64EXT) sec->Cycles / 1000.0;
+      _mesa_printf("Mesa: %14.1f %10u %10.3f  %s\n",
+                   total, sec->Calls, total / sec->Calls, sec->Name);
+   }
+}
+
+
+/**
+ * Enable profiling of \p ctx if MESA_PROFILE is set.
+ */
+void
+_mesa_init_profile(GLcontext *ctx)
+{
+   const char *env = _mesa_getenv("MESA_PROFILE");
+
+   ctx->Profile = NULL;
+   if (env) {
+      ctx->Profile = _mesa_new_profile();
+      if (ctx->Profile) {
+         const GLint frames = _mesa_atoi(env);
+         ctx->Profile->DumpFrames = frames > 0 ? frames : 0;
+      }
+   }
+}
+
+
+void
+_mesa_free_profile(GLcontext *ctx)
+{
+   struct gl_profile *prof = ctx->Profile;
+   GLuint i;
+
+   if (prof) {
+      if (prof->DumpFrames) {
+         for (i = 0; i < prof->NumSections; i++) {
+            if (prof->Sections[i].Calls) {
+               _mesa_print_profile(prof);
+               break;
+            }
+         }
+      }
+      _mesa_delete_profile(prof);
+      ctx->Profile = NULL;
+   }
+}
+
+
+/**
+ * Called by _mesa_notifySwapBuffers() to count frames and print the
+ * counts if MESA_PROFILE asks for it.
+ */
+void
+_mesa_profile_swap_buffers(GLcontext *ctx)
+{
+   struct gl_profile *prof = ctx->Profile;
+
+   if (prof) {
+      prof->Frames++;
+      if (prof->DumpFrames && prof->Frames >= prof->DumpFrames) {
+         _mesa_print_profile(prof);
+         _mesa_reset_profile(prof);
+      }
+   }
+}
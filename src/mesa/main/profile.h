@@ -0,0 +1,131 @@
+/**
+ * \file profile.h
+ * Cycle counts of the vertex pipeline stages, triangle functions and
+ * fragment span stages of a context.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+
+#include "mtypes.h"
+
+
+/** Max number of distinct sections a profile can hold */
+#define MAX_PROFILE_SECTIONS 64
+
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PROFILE_USE_RDTSC
+#else
+extern GLuint64EXT
+_mesa_profile_time(void);
+#endif
+
+
+/**
+ * Read the time stamp counter, or the time in microseconds where there
+ * is none.  Only differences between two values are meaningful.
+ */
+static INLINE GLuint64EXT
+_mesa_profile_clock(void)
+{
+#ifdef PROFILE_USE_RDTSC
+   GLuint lo, hi;
+   __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+   return ((GLuint64EXT) hi << 32) | lo;
+#else
+   return _mesa_profile_time();
+#endif
+}
+
+
+/**
+ * Add the time since \p start to section \p name of \p prof and return
+ * the current time, so that consecutive stages can be measured with one
+ * clock read each.  Sections are looked up by the address of their name,
+ * which should be a string literal.
+ */
+extern GLuint64EXT
+_mesa_profile_lap(struct gl_profile *prof, const char *name,
+                  GLuint64EXT start);
+
+
+/**
+ * Profiling helpers for code which has a (possibly NULL) gl_profile
+ * pointer \p P and a GLuint64EXT variable \p T at hand.  They do nothing
+ * but test the pointer when profiling is off.
+ */
+/*@{*/
+#define PROFILE_START(P, T)						\
+   do {									\
+      if (P)								\
+         (T) = _mesa_profile_clock();					\
+   } while (0)
+
+#define PROFILE_LAP(P, T, NAME)						\
+   do {									\
+      if (P)								\
+         (T) = _mesa_profile_lap(P, NAME, T);				\
+   } while (0)
+/*@}*/
+
+
+extern struct gl_profile *
+_mesa_new_profile(void);
+
+extern void
+_mesa_delete_profile(struct gl_profile *prof);
+
+extern void
+_mesa_reset_profile(struct gl_profile *prof);
+
+extern void
+_mesa_merge_profile(struct gl_profile *dst, struct gl_profile *src);
+
+extern GLboolean
+_mesa_get_profile_section(const struct gl_profile *prof, GLuint index,
+                          const char **name, GLuint *calls,
+                          GLuint64EXT *cycles);
+
+extern void
+_mesa_print_profile(const struct gl_profile *prof);
+
+
+extern void
+_mesa_init_profile(GLcontext *ctx);
+
+extern void
+_mesa_free_profile(GLcontext *ctx);
+
+extern void
+_mesa_profile_swap_buffers(GLcontext *ctx);
+
+
+#endif /* PROFILE_H */
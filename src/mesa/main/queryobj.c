@@ -29,6 +29,7 @@
 #include "imports.h"
 #include "queryobj.h"
 #include "mtypes.h"
+#include "state.h"
 
 
 /**
@@ -197,7 +198,11 @@ _mesa_BeginQueryARB(GLenum target, GLuint id)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
-   FLUSH_VERTICES(ctx, _NEW_DEPTH);
+   /* The current query isn't part of the depth state, so don't let the
+    * state filter drop the flag.
+    */
+   FLUSH_VERTICES(ctx, 0);
+   _mesa_invalidate_state(ctx, _NEW_DEPTH);
 
    switch (target) {
       case GL_SAMPLES_PASSED_ARB:
@@ -276,7 +281,8 @@ _mesa_EndQueryARB(GLenum target)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
-   FLUSH_VERTICES(ctx, _NEW_DEPTH);
+   FLUSH_VERTICES(ctx, 0);
+   _mesa_invalidate_state(ctx, _NEW_DEPTH);  /* see _mesa_BeginQueryARB() */
 
    switch (target) {
       case GL_SAMPLES_PASSED_ARB:
@@ -926,6 +926,46 @@ put_mono_values_ushort4(GLcontext *ctx, struct gl_renderbuffer *rb,
 
 
 
+/**
+ * Allocate the coarse depth tiles of a software depth buffer.
+ * The bounds are left uninitialized (Valid = GL_FALSE).
+ */
+static void
+alloc_depth_tiles(struct gl_renderbuffer *rb, GLuint width, GLuint height)
+{
+   const GLuint cols = (width + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+   const GLuint rows = (height + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+   struct gl_depth_tiles *tiles = CALLOC_STRUCT(gl_depth_tiles);
+
+   if (!tiles)
+      return;
+
+   tiles->Min = (GLuint *) _mesa_malloc(3 * cols * rows * sizeof(GLuint));
+   if (!tiles->Min) {
+      _mesa_free(tiles);
+      return;
+   }
+   tiles->Max = tiles->Min + cols * rows;
+   tiles->Writes = tiles->Max + cols * rows;
+   tiles->Cols = cols;
+   tiles->Rows = rows;
+   tiles->Valid = GL_FALSE;
+
+   rb->DepthTiles = tiles;
+}
+
+
+static void
+free_depth_tiles(struct gl_renderbuffer *rb)
+{
+   if (rb->DepthTiles) {
+      _mesa_free(rb->DepthTiles->Min);
+      _mesa_free(rb->DepthTiles);
+      rb->DepthTiles = NULL;
+   }
+}
+
+
 /**
  * This is a software fallback for the gl_renderbuffer->AllocStorage
  * function.
@@ -1196,6 +1236,7 @@ _mesa_soft_renderbuffer_storage(GLcontext *ctx, struct gl_renderbuffer *rb,
       _mesa_free(rb->Data);
       rb->Data = NULL;
    }
+   free_depth_tiles(rb);
 
    if (width > 0 && height > 0) {
       /* allocate new buffer storage */
@@ -1210,6 +1251,11 @@ _mesa_soft_renderbuffer_storage(GLcontext *ctx, struct gl_renderbuffer *rb,
       }
    }
 
+   if (rb->_BaseFormat == GL_DEPTH_COMPONENT && rb->Data) {
+      /* not fatal if this fails, swrast just can't cull with it */
+      alloc_depth_tiles(rb, width, height);
+   }
+
    rb->Width = width;
    rb->Height = height;
 
@@ -1493,6 +1539,7 @@ _mesa_init_renderbuffer(struct gl_renderbuffer *rb, GLuint name)
    rb->DepthBits = 0;
    rb->StencilBits = 0;
    rb->Data = NULL;
+   rb->DepthTiles = NULL;
 
    /* Point back to ourself so that we don't have to check for Wrapped==NULL
     * all over the drivers.
@@ -1535,6 +1582,7 @@ _mesa_delete_renderbuffer(struct gl_renderbuffer *rb)
    if (rb->Data) {
       _mesa_free(rb->Data);
    }
+   free_depth_tiles(rb);
    _mesa_free(rb);
 }
 
@@ -70,7 +70,7 @@ _mesa_set_scissor(GLcontext *ctx,
        y == ctx->Scissor.Y &&
        width == ctx->Scissor.Width &&
        height == ctx->Scissor.Height)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_SCISSOR);
    ctx->Scissor.X = x;
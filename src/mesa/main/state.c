@@ -408,6 +408,121 @@ update_tricaps(GLcontext *ctx, GLbitfield new_state)
 #endif
 
 
+/**
+ * Attribute groups whose flags may be dropped by filter_state(): all of
+ * the state they stand for is in the group's struct.
+ */
+#define FILTER_FLAGS (_NEW_COLOR | _NEW_DEPTH | _NEW_FOG | _NEW_HINT |	\
+                      _NEW_LIGHT | _NEW_LINE | _NEW_POLYGON |		\
+                      _NEW_POLYGONSTIPPLE | _NEW_SCISSOR |		\
+                      _NEW_STENCIL | _NEW_TRANSFORM)
+
+
+/**
+ * Copy or compare the lighting state which isn't derived from other
+ * state.  The derived fields include the spot exponent tables, which
+ * would make up nearly all of the work.
+ */
+static GLboolean
+light_state(struct gl_light_attrib *dst, const struct gl_light_attrib *src,
+            GLboolean copy)
+{
+   const GLuint lightSize = (GLuint) ((const GLubyte *) &src->Light[0]._Flags -
+                                      (const GLubyte *) &src->Light[0]);
+   const GLuint miscSize = (GLuint) ((const GLubyte *) &src->EnabledList -
+                                     (const GLubyte *) &src->Model);
+   GLuint i;
+
+   if (copy) {
+      for (i = 0; i < MAX_LIGHTS; i++)
+         _mesa_memcpy(&dst->Light[i], &src->Light[i], lightSize);
+      _mesa_memcpy(&dst->Model, &src->Model, miscSize);
+      return GL_TRUE;
+   }
+
+   for (i = 0; i < MAX_LIGHTS; i++) {
+      if (_mesa_memcmp(&dst->Light[i], &src->Light[i], lightSize))
+         return GL_FALSE;
+   }
+   return _mesa_memcmp(&dst->Model, &src->Model, miscSize) == 0;
+}
+
+
+/**
+ * Drop the flags of the attribute groups which are the same as when they
+ * were last validated, e.g. after glEnable(GL_BLEND); glDisable(GL_BLEND)
+ * between two draws.
+ */
+static GLbitfield
+filter_state(GLcontext *ctx, GLbitfield new_state)
+{
+   struct gl_state_filter *filter = &ctx->StateFilter;
+   const GLbitfield check = new_state & filter->Valid;
+
+#define FILTER(FLAG, FIELD)						\
+   if ((check & (FLAG)) &&						\
+       _mesa_memcmp(&ctx->FIELD, &filter->FIELD, sizeof(ctx->FIELD)) == 0) { \
+      new_state &= ~(FLAG);						\
+      filter->Dropped++;						\
+   }
+
+   if (check) {
+      FILTER(_NEW_COLOR, Color);
+      FILTER(_NEW_DEPTH, Depth);
+      FILTER(_NEW_FOG, Fog);
+      FILTER(_NEW_HINT, Hint);
+      FILTER(_NEW_LINE, Line);
+      FILTER(_NEW_POLYGON, Polygon);
+      FILTER(_NEW_POLYGONSTIPPLE, PolygonStipple);
+      FILTER(_NEW_SCISSOR, Scissor);
+      FILTER(_NEW_STENCIL, Stencil);
+      FILTER(_NEW_TRANSFORM, Transform);
+
+      if ((check & _NEW_LIGHT) &&
+          light_state(&filter->Light, &ctx->Light, GL_FALSE)) {
+         new_state &= ~_NEW_LIGHT;
+         filter->Dropped++;
+      }
+   }
+
+#undef FILTER
+
+   return new_state;
+}
+
+
+/**
+ * Keep a copy of the attribute groups just validated for filter_state().
+ */
+static void
+save_filter_state(GLcontext *ctx, GLbitfield new_state)
+{
+   struct gl_state_filter *filter = &ctx->StateFilter;
+
+#define SAVE(FLAG, FIELD)						\
+   if (new_state & (FLAG))						\
+      _mesa_memcpy(&filter->FIELD, &ctx->FIELD, sizeof(ctx->FIELD));
+
+   SAVE(_NEW_COLOR, Color);
+   SAVE(_NEW_DEPTH, Depth);
+   SAVE(_NEW_FOG, Fog);
+   SAVE(_NEW_HINT, Hint);
+   SAVE(_NEW_LINE, Line);
+   SAVE(_NEW_POLYGON, Polygon);
+   SAVE(_NEW_POLYGONSTIPPLE, PolygonStipple);
+   SAVE(_NEW_SCISSOR, Scissor);
+   SAVE(_NEW_STENCIL, Stencil);
+   SAVE(_NEW_TRANSFORM, Transform);
+
+   if (new_state & _NEW_LIGHT)
+      light_state(&filter->Light, &ctx->Light, GL_TRUE);
+
+#undef SAVE
+
+   filter->Valid |= new_state & FILTER_FLAGS;
+}
+
+
 /**
  * Compute derived GL state.
  * If __GLcontextRec::NewState is non-zero then this function \b must
@@ -426,6 +541,12 @@ _mesa_update_state_locked( GLcontext *ctx )
    GLbitfield new_state = ctx->NewState;
    GLbitfield prog_flags = _NEW_PROGRAM;
 
+   ctx->StateFilter.Updates++;
+   if (ctx->StateFilter.Enabled) {
+      new_state = filter_state(ctx, new_state);
+      ctx->NewState = new_state;
+   }
+
    if (MESA_VERBOSE & VERBOSE_STATE)
       _mesa_print_state("_mesa_update_state", new_state);
 
@@ -515,6 +636,9 @@ _mesa_update_state_locked( GLcontext *ctx )
    ctx->NewState = 0;
    ctx->Driver.UpdateState(ctx, new_state);
    ctx->Array.NewState = 0;
+
+   if (ctx->StateFilter.Enabled)
+      save_filter_state(ctx, new_state);
 }
 
 
@@ -527,3 +651,24 @@ _mesa_update_state( GLcontext *ctx )
    _mesa_update_state_locked(ctx);
    _mesa_unlock_context_textures(ctx);
 }
+
+
+/**
+ * Flag state as changed, like ctx->NewState |= new_state, but such that
+ * the flags aren't dropped by the state filter.  For changes of state
+ * outside an attribute group which are signalled with the group's flag.
+ */
+void
+_mesa_invalidate_state(GLcontext *ctx, GLbitfield new_state)
+{
+   ctx->NewState |= new_state;
+   ctx->StateFilter.Valid &= ~new_state;
+}
+
+
+void
+_mesa_init_state_filter(GLcontext *ctx)
+{
+   ctx->StateFilter.Enabled = !_mesa_getenv("MESA_NO_STATE_FILTER");
+   ctx->StateFilter.Valid = 0;
+}
@@ -37,5 +37,11 @@ _mesa_update_state( GLcontext *ctx );
 extern void
 _mesa_update_state_locked( GLcontext *ctx );
 
+extern void
+_mesa_invalidate_state(GLcontext *ctx, GLbitfield new_state);
+
+extern void
+_mesa_init_state_filter(GLcontext *ctx);
+
 
 #endif
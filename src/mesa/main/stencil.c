@@ -113,7 +113,7 @@ _mesa_ClearStencil( GLint s )
    ASSERT_OUTSIDE_BEGIN_END(ctx);
 
    if (ctx->Stencil.Clear == (GLuint) s)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_STENCIL);
    ctx->Stencil.Clear = (GLuint) s;
@@ -213,7 +213,7 @@ _mesa_StencilFunc( GLenum func, GLint ref, GLuint mask )
       if (ctx->Stencil.Function[face] == func &&
           ctx->Stencil.ValueMask[face] == mask &&
           ctx->Stencil.Ref[face] == ref)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.Function[face] = func;
       ctx->Stencil.Ref[face] = ref;
@@ -231,7 +231,7 @@ _mesa_StencilFunc( GLenum func, GLint ref, GLuint mask )
           ctx->Stencil.ValueMask[1] == mask &&
           ctx->Stencil.Ref[0] == ref &&
           ctx->Stencil.Ref[1] == ref)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.Function[0]  = ctx->Stencil.Function[1]  = func;
       ctx->Stencil.Ref[0]       = ctx->Stencil.Ref[1]       = ref;
@@ -265,7 +265,7 @@ _mesa_StencilMask( GLuint mask )
       /* only set active face state */
       const GLint face = ctx->Stencil.ActiveFace;
       if (ctx->Stencil.WriteMask[face] == mask)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.WriteMask[face] = mask;
       if (ctx->Driver.StencilMaskSeparate) {
@@ -276,7 +276,7 @@ _mesa_StencilMask( GLuint mask )
       /* set both front and back state */
       if (ctx->Stencil.WriteMask[0] == mask &&
           ctx->Stencil.WriteMask[1] == mask)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.WriteMask[0] = ctx->Stencil.WriteMask[1] = mask;
       if (ctx->Driver.StencilMaskSeparate) {
@@ -325,7 +325,7 @@ _mesa_StencilOp(GLenum fail, GLenum zfail, GLenum zpass)
       if (ctx->Stencil.ZFailFunc[face] == zfail &&
           ctx->Stencil.ZPassFunc[face] == zpass &&
           ctx->Stencil.FailFunc[face] == fail)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.ZFailFunc[face] = zfail;
       ctx->Stencil.ZPassFunc[face] = zpass;
@@ -343,7 +343,7 @@ _mesa_StencilOp(GLenum fail, GLenum zfail, GLenum zpass)
           ctx->Stencil.ZPassFunc[1] == zpass &&
           ctx->Stencil.FailFunc[0] == fail &&
           ctx->Stencil.FailFunc[1] == fail)
-         return;
+         RETURN_UNCHANGED(ctx);
       FLUSH_VERTICES(ctx, _NEW_STENCIL);
       ctx->Stencil.ZFailFunc[0] = ctx->Stencil.ZFailFunc[1] = zfail;
       ctx->Stencil.ZPassFunc[0] = ctx->Stencil.ZPassFunc[1] = zpass;
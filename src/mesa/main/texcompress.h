@@ -55,6 +55,13 @@ _mesa_compressed_image_address(GLint col, GLint row, GLint img,
 extern void
 _mesa_init_texture_s3tc( GLcontext *ctx );
 
+extern void
+_mesa_invalidate_dxtn_cache(void);
+
+extern void
+_mesa_fetch_dxtn_texels(const struct gl_texture_image *texImage, GLuint n,
+                        const GLint i[], const GLint j[], GLubyte rgba[][4]);
+
 extern void
 _mesa_init_texture_fxt1( GLcontext *ctx );
 
@@ -68,6 +75,7 @@ _mesa_init_texture_fxt1( GLcontext *ctx );
 #define _mesa_compressed_row_stride( f, w) 0
 #define _mesa_compressed_image_address(c, r, i, f, w, i2 ) 0
 #define _mesa_compress_teximage( c, w, h, sF, s, sRS, dF, d, drs ) ((void)0)
+#define _mesa_invalidate_dxtn_cache() ((void)0)
 
 #endif /* _HAVE_FULL_GL */
 
@@ -39,10 +39,12 @@
 #include "texcompress.h"
 #include "texformat.h"
 #include "texstore.h"
+#include "threadpool.h"
+#include "x86-64/x86-64.h"
 
 
 static void
-fxt1_encode (GLuint width, GLuint height, GLint comps,
+fxt1_encode (GLcontext *ctx, GLuint width, GLuint height, GLint comps,
              const void *source, GLint srcRowStride,
              void *dest, GLint destRowStride);
 
@@ -108,7 +110,7 @@ texstore_rgb_fxt1(TEXSTORE_PARAMS)
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
 
-   fxt1_encode(srcWidth, srcHeight, 3, pixels, srcRowStride,
+   fxt1_encode(ctx, srcWidth, srcHeight, 3, pixels, srcRowStride,
                dst, dstRowStride);
 
    if (tempImage)
@@ -165,7 +167,7 @@ texstore_rgba_fxt1(TEXSTORE_PARAMS)
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
 
-   fxt1_encode(srcWidth, srcHeight, 4, pixels, srcRowStride,
+   fxt1_encode(ctx, srcWidth, srcHeight, 4, pixels, srcRowStride,
                dst, dstRowStride);
 
    if (tempImage)
@@ -282,9 +284,15 @@ const struct gl_texture_format _mesa_texformat_rgba_fxt1 = {
  * is merely a proof of concept, since it is highly UNoptimized;
  * moreover, it is sub-optimal due to initial conditions passed
  * to Lloyd's algorithm (the interpolation modes are even worse).
+ * It is used unless the texture compression hint is GL_NICEST, which
+ * sends the blocks to the high quality encoder below the decoder.
 \***************************************************************************/
 
 
+/** Images with fewer texels than this are compressed by one thread */
+#define MIN_THREADED_TEXELS (64 * 64)
+
+
 #define MAX_COMP 4 /* ever needed maximum number of components in texel */
 #define MAX_VECT 4 /* ever needed maximum number of base vectors to find */
 #define N_TEXELS 32 /* number of texels in a block (always 32) */
@@ -419,7 +427,7 @@ fxt1_worst (GLfloat vec[MAX_COMP],
 
 static GLint
 fxt1_variance (GLdouble variance[MAX_COMP],
-               GLubyte input[N_TEXELS][MAX_COMP], GLint nc, GLint n)
+               GLubyte input[][MAX_COMP], GLint nc, GLint n)
 {
    GLint i, k, best = 0;
    GLint sx, sx2;
@@ -1276,7 +1284,15 @@ fxt1_quantize_MIXED0 (GLuint *cc,
 
 
 static void
-fxt1_quantize (GLuint *cc, const GLubyte *lines[], GLint comps)
+fxt1_quantize_hq (GLuint *cc,
+                  GLubyte input[N_TEXELS][MAX_COMP],
+                  GLubyte reord[N_TEXELS][MAX_COMP], GLint n,
+                  GLint trualpha);
+
+
+static void
+fxt1_quantize (GLuint *cc, const GLubyte *lines[], GLint comps,
+               GLboolean highQuality)
 {
    GLint trualpha;
    GLubyte reord[N_TEXELS][MAX_COMP];
@@ -1332,6 +1348,14 @@ fxt1_quantize (GLuint *cc, const GLubyte *lines[], GLint comps)
       }
    }
 
+   if (highQuality) {
+      if (comps == 3) {
+         _mesa_memcpy(reord, input, sizeof(input));
+      }
+      fxt1_quantize_hq(cc, input, reord, l, trualpha);
+      return;
+   }
+
 #if 0
    if (trualpha) {
       fxt1_quantize_ALPHA0(cc, input, reord, l);
@@ -1364,14 +1388,64 @@ fxt1_quantize (GLuint *cc, const GLubyte *lines[], GLint comps)
 }
 
 
+/**
+ * Parameters of an image being compressed.
+ */
+struct fxt1_encode_job
+{
+   GLint comps;               /**< 3 or 4 */
+   GLint width, height;       /**< multiples of 8 and 4 */
+   const GLubyte *data;
+   GLint srcRowStride;        /**< in bytes */
+   GLubyte *dest;
+   GLint destRowStride;       /**< bytes per row of blocks */
+   GLboolean highQuality;
+   GLint rowsPerTask;         /**< rows of blocks */
+};
+
+
+/**
+ * Compress a band of block rows.  Called via _mesa_threadpool_run().
+ */
 static void
-fxt1_encode (GLuint width, GLuint height, GLint comps,
+fxt1_encode_rows (void *data, GLuint task, GLuint thread)
+{
+   const struct fxt1_encode_job *job = (const struct fxt1_encode_job *) data;
+   const GLint first = task * job->rowsPerTask;
+   const GLint last = MIN2(first + job->rowsPerTask, job->height / 4);
+   GLint x, y;
+
+   (void) thread;
+
+   for (y = first * 4; y < last * 4; y += 4) {
+      GLuint *encoded = (GLuint *) (job->dest + (y / 4) * job->destRowStride);
+      GLuint offs = y * job->srcRowStride;
+      for (x = 0; x < job->width; x += 8) {
+         const GLubyte *lines[4];
+         lines[0] = &job->data[offs];
+         lines[1] = lines[0] + job->srcRowStride;
+         lines[2] = lines[1] + job->srcRowStride;
+         lines[3] = lines[2] + job->srcRowStride;
+         offs += 8 * job->comps;
+         fxt1_quantize(encoded, lines, job->comps, job->highQuality);
+         /* 128 bits per 8x4 block */
+         encoded += 4;
+      }
+   }
+}
+
+
+/**
+ * Compress an RGB or RGBA image.  Large images are compressed by the
+ * texture threads, a band of block rows each.
+ */
+static void
+fxt1_encode (GLcontext *ctx, GLuint width, GLuint height, GLint comps,
              const void *source, GLint srcRowStride,
              void *dest, GLint destRowStride)
 {
-   GLuint x, y;
-   const GLubyte *data;
-   GLuint *encoded = (GLuint *)dest;
+   struct _mesa_threadpool *pool = NULL;
+   struct fxt1_encode_job job;
    void *newSource = NULL;
 
    assert(comps == 3 || comps == 4);
@@ -1382,7 +1456,6 @@ fxt1_encode (GLuint width, GLuint height, GLint comps,
       GLint newHeight = (height + 3) & ~3;
       newSource = _mesa_malloc(comps * newWidth * newHeight * sizeof(GLchan));
       if (!newSource) {
-         GET_CURRENT_CONTEXT(ctx);
          _mesa_error(ctx, GL_OUT_OF_MEMORY, "texture compression");
          goto cleanUp;
       }
@@ -1402,7 +1475,6 @@ fxt1_encode (GLuint width, GLuint height, GLint comps,
       GLubyte *dest = (GLubyte *) _mesa_malloc(n * sizeof(GLubyte));
       GLuint i;
       if (!dest) {
-         GET_CURRENT_CONTEXT(ctx);
          _mesa_error(ctx, GL_OUT_OF_MEMORY, "texture compression");
          goto cleanUp;
       }
@@ -1416,22 +1488,30 @@ fxt1_encode (GLuint width, GLuint height, GLint comps,
       source = dest;  /* the new, GLubyte incoming image */
    }
 
-   data = (const GLubyte *) source;
-   destRowStride = (destRowStride - width * 2) / 4;
-   for (y = 0; y < height; y += 4) {
-      GLuint offs = 0 + (y + 0) * srcRowStride;
-      for (x = 0; x < width; x += 8) {
-         const GLubyte *lines[4];
-         lines[0] = &data[offs];
-         lines[1] = lines[0] + srcRowStride;
-         lines[2] = lines[1] + srcRowStride;
-         lines[3] = lines[2] + srcRowStride;
-         offs += 8 * comps;
-         fxt1_quantize(encoded, lines, comps);
-         /* 128 bits per 8x4 block */
-         encoded += 4;
-      }
-      encoded += destRowStride;
+   job.comps = comps;
+   job.width = width;
+   job.height = height;
+   job.data = (const GLubyte *) source;
+   job.srcRowStride = srcRowStride;
+   job.dest = (GLubyte *) dest;
+   job.destRowStride = destRowStride;
+   job.highQuality = ctx->Hint.TextureCompression == GL_NICEST;
+
+   if (height > 4 && width * height >= MIN_THREADED_TEXELS)
+      pool = _mesa_get_texture_pool(ctx);
+
+   if (pool && _mesa_threadpool_num_threads(pool) > 1) {
+      const GLint blockRows = height / 4;
+      const GLint numThreads = _mesa_threadpool_num_threads(pool);
+      /* a few bands per thread, to even out the work */
+      job.rowsPerTask = MAX2(blockRows / (4 * numThreads), 1);
+      _mesa_threadpool_run(pool,
+                           (blockRows + job.rowsPerTask - 1) / job.rowsPerTask,
+                           fxt1_encode_rows, &job);
+   }
+   else {
+      job.rowsPerTask = height / 4;
+      fxt1_encode_rows(&job, 0, 0);
    }
 
  cleanUp:
@@ -1695,21 +1775,22 @@ fxt1_decode_1ALPHA (const GLubyte *code, GLint t, GLchan *rgba)
 }
 
 
+static void (*decode_1[]) (const GLubyte *, GLint, GLchan *) = {
+   fxt1_decode_1HI,     /* cc-high   = "00?" */
+   fxt1_decode_1HI,     /* cc-high   = "00?" */
+   fxt1_decode_1CHROMA, /* cc-chroma = "010" */
+   fxt1_decode_1ALPHA,  /* alpha     = "011" */
+   fxt1_decode_1MIXED,  /* mixed     = "1??" */
+   fxt1_decode_1MIXED,  /* mixed     = "1??" */
+   fxt1_decode_1MIXED,  /* mixed     = "1??" */
+   fxt1_decode_1MIXED   /* mixed     = "1??" */
+};
+
+
 void
 fxt1_decode_1 (const void *texture, GLint stride, /* in pixels */
                GLint i, GLint j, GLchan *rgba)
 {
-   static void (*decode_1[]) (const GLubyte *, GLint, GLchan *) = {
-      fxt1_decode_1HI,     /* cc-high   = "00?" */
-      fxt1_decode_1HI,     /* cc-high   = "00?" */
-      fxt1_decode_1CHROMA, /* cc-chroma = "010" */
-      fxt1_decode_1ALPHA,  /* alpha     = "011" */
-      fxt1_decode_1MIXED,  /* mixed     = "1??" */
-      fxt1_decode_1MIXED,  /* mixed     = "1??" */
-      fxt1_decode_1MIXED,  /* mixed     = "1??" */
-      fxt1_decode_1MIXED   /* mixed     = "1??" */
-   };
-
    const GLubyte *code = (const GLubyte *)texture +
                          ((j / 4) * (stride / 8) + (i / 8)) * 16;
    GLint mode = CC_SEL(code, 125);
@@ -1722,3 +1803,624 @@ fxt1_decode_1 (const void *texture, GLint stride, /* in pixels */
 
    decode_1[mode](code, t, rgba);
 }
+
+
+/***************************************************************************\
+ * FXT1 high quality encoder
+ *
+ * Used when the texture compression hint is GL_NICEST.  The colors
+ * of the MIXED and HI modes are the ends of the texels' principal axis,
+ * refined by least squares, and the texel indices are chosen with the
+ * decoded colors.  Each block is encoded in several modes and the one
+ * with the least squared error is kept; the HI mode is skipped when the
+ * distance of the texels from their principal axis already exceeds the
+ * error of the MIXED mode.
+\***************************************************************************/
+
+
+/* least squared error of the other modes for trying the CHROMA mode */
+#define CHROMA_MIN_ERROR (N_TEXELS * 24)
+
+/* quantize a color component to 5 or 6 bits */
+#define QUANT5(v) ((GLint) (CLAMP(v, 0.0F, 255.0F) * (31.0F / 255.0F) + 0.5F))
+#define QUANT6(v) ((GLint) (CLAMP(v, 0.0F, 255.0F) * (63.0F / 255.0F) + 0.5F))
+
+
+/**
+ * Decode all the texels of a block, in the encoder's texel order.
+ */
+static void
+fxt1_decode_block (const GLuint *cc, GLubyte rgba[N_TEXELS][MAX_COMP])
+{
+   const GLint mode = CC_SEL(cc, 125);
+   GLint t;
+
+   for (t = 0; t < N_TEXELS; t++) {
+      GLchan texel[4];
+      decode_1[mode]((const GLubyte *) cc, t, texel);
+      rgba[t][RCOMP] = CHAN_TO_UBYTE(texel[RCOMP]);
+      rgba[t][GCOMP] = CHAN_TO_UBYTE(texel[GCOMP]);
+      rgba[t][BCOMP] = CHAN_TO_UBYTE(texel[BCOMP]);
+      rgba[t][ACOMP] = CHAN_TO_UBYTE(texel[ACOMP]);
+   }
+}
+
+
+/**
+ * Squared RGBA error of an encoded block.
+ */
+static GLuint
+fxt1_block_error (const GLuint *cc, GLubyte input[N_TEXELS][MAX_COMP])
+{
+   GLubyte rgba[N_TEXELS][MAX_COMP];
+   GLuint err = 0;
+   GLint i, k;
+
+   fxt1_decode_block(cc, rgba);
+   for (k = 0; k < N_TEXELS; k++) {
+      for (i = 0; i < MAX_COMP; i++) {
+         const GLint d = rgba[k][i] - input[k][i];
+         err += d * d;
+      }
+   }
+   return err;
+}
+
+
+/**
+ * Find the nearest of np palette colors to each of n texels (a multiple
+ * of four).  Returns the sum of the squared RGBA distances.
+ */
+static GLuint
+fxt1_nearest (GLubyte texels[][MAX_COMP], GLint n,
+              GLubyte pal[][MAX_COMP], GLint np, GLubyte index[])
+{
+#ifdef USE_X86_64_ASM
+   return _mesa_sse2_nearest_colors(texels[0], n, pal[0], np, index);
+#else
+   GLuint total = 0;
+   GLint i, j, k;
+
+   for (k = 0; k < n; k++) {
+      GLint best = 0x7fffffff;
+      for (j = 0; j < np; j++) {
+         GLint e = 0;
+         for (i = 0; i < MAX_COMP; i++) {
+            const GLint d = texels[k][i] - pal[j][i];
+            e += d * d;
+         }
+         if (e < best) {
+            best = e;
+            index[k] = j;
+         }
+      }
+      total += best;
+   }
+   return total;
+#endif
+}
+
+
+/**
+ * Fit a line to the RGB colors of n texels.  e0 and e1 receive the ends
+ * of the texels along their principal axis.  Returns the sum of the
+ * squared distances of the texels from the axis, which no line can beat.
+ */
+static GLfloat
+fxt1_fit_line (GLubyte texels[][MAX_COMP], GLint n,
+               GLfloat e0[3], GLfloat e1[3])
+{
+   GLfloat mean[3], axis[3], cov[6], cv[3];
+   GLfloat trace, len2, lambda;
+   GLfloat tmin = 0.0F, tmax = 0.0F;
+   GLint sum[3];
+   GLint i, k;
+
+   sum[0] = sum[1] = sum[2] = 0;
+   for (k = 0; k < n; k++) {
+      for (i = 0; i < 3; i++) {
+         sum[i] += texels[k][i];
+      }
+   }
+   for (i = 0; i < 3; i++) {
+      e0[i] = e1[i] = mean[i] = (GLfloat) sum[i] / n;
+   }
+
+   for (i = 0; i < 6; i++) {
+      cov[i] = 0.0F;
+   }
+   for (k = 0; k < n; k++) {
+      const GLfloat r = texels[k][RCOMP] - mean[0];
+      const GLfloat g = texels[k][GCOMP] - mean[1];
+      const GLfloat b = texels[k][BCOMP] - mean[2];
+      cov[0] += r * r;
+      cov[1] += r * g;
+      cov[2] += r * b;
+      cov[3] += g * g;
+      cov[4] += g * b;
+      cov[5] += b * b;
+   }
+   trace = cov[0] + cov[3] + cov[5];
+   if (trace <= 0.0F) {
+      /* all the same color */
+      return 0.0F;
+   }
+
+   /* power iteration, from the covariances of the widest channel */
+   if (cov[0] >= cov[3] && cov[0] >= cov[5]) {
+      ASSIGN_3V(axis, cov[0], cov[1], cov[2]);
+   } else if (cov[3] >= cov[5]) {
+      ASSIGN_3V(axis, cov[1], cov[3], cov[4]);
+   } else {
+      ASSIGN_3V(axis, cov[2], cov[4], cov[5]);
+   }
+   for (k = 0; k < 8; k++) {
+      GLfloat m;
+      cv[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+      cv[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+      cv[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+      m = MAX2(FABSF(cv[0]), MAX2(FABSF(cv[1]), FABSF(cv[2])));
+      if (m == 0.0F) {
+         break;
+      }
+      for (i = 0; i < 3; i++) {
+         axis[i] = cv[i] / m;
+      }
+   }
+   cv[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+   cv[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+   cv[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+   len2 = DOT3(axis, axis);
+   lambda = DOT3(axis, cv) / len2;
+
+   /* extent of the texels along the axis */
+   for (k = 0; k < n; k++) {
+      const GLfloat t = (texels[k][RCOMP] - mean[0]) * axis[0]
+                      + (texels[k][GCOMP] - mean[1]) * axis[1]
+                      + (texels[k][BCOMP] - mean[2]) * axis[2];
+      if (tmin > t) {
+         tmin = t;
+      }
+      if (tmax < t) {
+         tmax = t;
+      }
+   }
+   for (i = 0; i < 3; i++) {
+      e0[i] = mean[i] + tmin * axis[i] / len2;
+      e1[i] = mean[i] + tmax * axis[i] / len2;
+   }
+
+   return MAX2(trace - lambda, 0.0F);
+}
+
+
+/**
+ * Least squares fit of the ends of a line of nv + 1 evenly spaced
+ * colors to texels with known indices.  Texels with larger indices
+ * (transparent black) are ignored.  Returns GL_FALSE if the texels
+ * don't determine both ends.
+ */
+static GLboolean
+fxt1_refit_line (GLubyte texels[][MAX_COMP], GLint n, const GLubyte index[],
+                 GLint nv, GLfloat e0[3], GLfloat e1[3])
+{
+   GLfloat aa = 0.0F, ab = 0.0F, bb = 0.0F, det;
+   GLfloat ax[3], bx[3];
+   GLint i, k;
+
+   ax[0] = ax[1] = ax[2] = 0.0F;
+   bx[0] = bx[1] = bx[2] = 0.0F;
+   for (k = 0; k < n; k++) {
+      if (index[k] <= nv) {
+         const GLfloat b = (GLfloat) index[k] / nv;
+         const GLfloat a = 1.0F - b;
+         aa += a * a;
+         ab += a * b;
+         bb += b * b;
+         for (i = 0; i < 3; i++) {
+            ax[i] += a * texels[k][i];
+            bx[i] += b * texels[k][i];
+         }
+      }
+   }
+
+   det = aa * bb - ab * ab;
+   if (det < 1e-3F) {
+      return GL_FALSE;
+   }
+   for (i = 0; i < 3; i++) {
+      e0[i] = (bb * ax[i] - ab * bx[i]) / det;
+      e1[i] = (aa * bx[i] - ab * ax[i]) / det;
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * Quantize the colors of a MIXED mode microtile: 5 bit red and blue,
+ * 6 bit green.  With alpha, the first color only has 5 bits of green
+ * (kept shifted left by one).
+ */
+static void
+fxt1_quantize_mixed_colors (GLfloat e[2][3], GLboolean alpha, GLint q[2][3])
+{
+   GLint j;
+
+   for (j = 0; j < 2; j++) {
+      q[j][RCOMP] = QUANT5(e[j][RCOMP]);
+      q[j][GCOMP] = QUANT6(e[j][GCOMP]);
+      q[j][BCOMP] = QUANT5(e[j][BCOMP]);
+   }
+   if (alpha) {
+      q[0][GCOMP] = QUANT5(e[0][GCOMP]) << 1;
+   }
+}
+
+
+/**
+ * Decoded colors of a MIXED mode microtile.  Without alpha the colors
+ * are interpolated in thirds; with alpha there is a midpoint and index 3
+ * is transparent black.
+ */
+static void
+fxt1_mixed_palette (GLint q[2][3], GLboolean alpha, GLubyte pal[4][MAX_COMP])
+{
+   GLubyte col[2][3];
+   GLint i, t;
+
+   for (t = 0; t < 2; t++) {
+      col[t][RCOMP] = UP5(q[t][RCOMP]);
+      col[t][GCOMP] = _rgb_scale_6[q[t][GCOMP]];
+      col[t][BCOMP] = UP5(q[t][BCOMP]);
+   }
+
+   if (alpha) {
+      col[0][GCOMP] = UP5(q[0][GCOMP] >> 1);
+      for (i = 0; i < 3; i++) {
+         pal[0][i] = col[0][i];
+         pal[1][i] = (col[0][i] + col[1][i]) / 2;
+         pal[2][i] = col[1][i];
+         pal[3][i] = 0;
+      }
+      pal[0][ACOMP] = pal[1][ACOMP] = pal[2][ACOMP] = 255;
+      pal[3][ACOMP] = 0;
+   } else {
+      for (t = 0; t < 4; t++) {
+         for (i = 0; i < 3; i++) {
+            pal[t][i] = LERP(3, t, col[0][i], col[1][i]);
+         }
+         pal[t][ACOMP] = 255;
+      }
+   }
+}
+
+
+/**
+ * Encode a microtile of 16 texels in a MIXED mode.  q receives the
+ * colors and bits the indices.  Returns the squared error.
+ */
+static GLuint
+fxt1_mixed_microtile (GLubyte texels[N_TEXELS / 2][MAX_COMP], GLboolean alpha,
+                      GLint q[2][3], GLuint *bits)
+{
+   GLubyte opaque[N_TEXELS / 2][MAX_COMP];
+   GLubyte index[N_TEXELS / 2], index2[N_TEXELS / 2];
+   GLubyte pal[4][MAX_COMP];
+   GLfloat e[2][3];
+   GLint q2[2][3];
+   GLuint err, err2;
+   GLint k, n, pass;
+
+   n = 0;
+   for (k = 0; k < N_TEXELS / 2; k++) {
+      if (!alpha || !ISTBLACK(texels[k])) {
+         COPY_4UBV(opaque[n], texels[k]);
+         n++;
+      }
+   }
+   if (n == 0) {
+      /* all transparent black */
+      _mesa_memset(q, 0, 2 * sizeof(q[0]));
+      *bits = ~0u;
+      return 0;
+   }
+
+   fxt1_fit_line(opaque, n, e[0], e[1]);
+   fxt1_quantize_mixed_colors(e, alpha, q);
+   fxt1_mixed_palette(q, alpha, pal);
+   err = fxt1_nearest(texels, N_TEXELS / 2, pal, 4, index);
+
+   for (pass = 0; pass < 2 && err > 0; pass++) {
+      if (!fxt1_refit_line(texels, N_TEXELS / 2, index, alpha ? 2 : 3,
+                           e[0], e[1])) {
+         break;
+      }
+      fxt1_quantize_mixed_colors(e, alpha, q2);
+      fxt1_mixed_palette(q2, alpha, pal);
+      err2 = fxt1_nearest(texels, N_TEXELS / 2, pal, 4, index2);
+      if (err2 >= err) {
+         break;
+      }
+      err = err2;
+      _mesa_memcpy(q, q2, sizeof(q2));
+      _mesa_memcpy(index, index2, sizeof(index2));
+   }
+
+   *bits = 0;
+   for (k = N_TEXELS / 2 - 1; k >= 0; k--) {
+      *bits = (*bits << 2) | index[k];
+   }
+   return err;
+}
+
+
+/**
+ * Encode a block in the MIXED mode, with transparent black texels if
+ * alpha is set.  q receives the colors of the two microtiles.  Returns
+ * the squared error.
+ */
+static GLuint
+fxt1_encode_MIXED (GLuint *cc, GLubyte input[N_TEXELS][MAX_COMP],
+                   GLboolean alpha, GLint q[2 * 2][3])
+{
+   GLuint bits[2], err = 0;
+   Fx64 hi;
+   GLint i, j, m;
+
+   for (m = 0; m < 2; m++) {
+      GLint (*qm)[3] = q + 2 * m;
+      err += fxt1_mixed_microtile(input + m * N_TEXELS / 2, alpha,
+                                  qm, &bits[m]);
+
+      /* the green LSB of the first color depends on the high index bit
+       * of the first texel: swap the colors if it doesn't fit
+       */
+      if (!alpha &&
+          (GLint) ((bits[m] >> 1) & 1) != ((qm[0][GCOMP] ^ qm[1][GCOMP]) & 1)) {
+         for (i = 0; i < 3; i++) {
+            const GLint t = qm[0][i];
+            qm[0][i] = qm[1][i];
+            qm[1][i] = t;
+         }
+         bits[m] = ~bits[m];
+      }
+   }
+
+   /* mixed = "1" + glsb of col 3 and col 1 + alpha */
+   FX64_MOV32(hi, 8 | ((q[3][GCOMP] & 1) << 2) | ((q[1][GCOMP] & 1) << 1) |
+                  (alpha ? 1 : 0));
+   for (j = 2 * 2 - 1; j >= 0; j--) {
+      for (i = 0; i < 3; i++) {
+         /* add in colors */
+         FX64_SHL(hi, 5);
+         FX64_OR32(hi, (GLuint) (i == GCOMP ? q[j][i] >> 1 : q[j][i]));
+      }
+   }
+   cc[0] = bits[0];
+   cc[1] = bits[1];
+   ((Fx64 *)cc)[1] = hi;
+
+   return err;
+}
+
+
+/**
+ * Decoded colors of the HI mode: seven colors interpolated between the
+ * two 5 bit colors in q, and transparent black.
+ */
+static void
+fxt1_hi_palette (GLint q[2][3], GLubyte pal[8][MAX_COMP])
+{
+   GLint i, t;
+
+   for (t = 0; t < 7; t++) {
+      for (i = 0; i < 3; i++) {
+         pal[t][i] = LERP(6, t, UP5(q[0][i]), UP5(q[1][i]));
+      }
+      pal[t][ACOMP] = 255;
+   }
+   pal[7][RCOMP] = pal[7][GCOMP] = pal[7][BCOMP] = pal[7][ACOMP] = 0;
+}
+
+
+/**
+ * Encode a block in the HI mode, unless the texels are too far from
+ * their principal axis to get an error below maxErr.  Returns the
+ * squared error, or ~0 if the mode was rejected.
+ */
+static GLuint
+fxt1_encode_HI (GLuint *cc, GLubyte input[N_TEXELS][MAX_COMP],
+                GLubyte reord[N_TEXELS][MAX_COMP], GLint n, GLuint maxErr)
+{
+   GLubyte index[N_TEXELS], index2[N_TEXELS];
+   GLubyte pal[8][MAX_COMP];
+   GLfloat e[2][3];
+   GLint q[2][3], q2[2][3];
+   GLuint err, err2;
+   GLint i, k, pass;
+
+   if (fxt1_fit_line(reord, n, e[0], e[1]) >= (GLfloat) maxErr) {
+      return ~0u;
+   }
+   for (k = 0; k < 2; k++) {
+      for (i = 0; i < 3; i++) {
+         q[k][i] = QUANT5(e[k][i]);
+      }
+   }
+   fxt1_hi_palette(q, pal);
+   err = fxt1_nearest(input, N_TEXELS, pal, 8, index);
+
+   for (pass = 0; pass < 2 && err > 0; pass++) {
+      if (!fxt1_refit_line(input, N_TEXELS, index, 6, e[0], e[1])) {
+         break;
+      }
+      for (k = 0; k < 2; k++) {
+         for (i = 0; i < 3; i++) {
+            q2[k][i] = QUANT5(e[k][i]);
+         }
+      }
+      fxt1_hi_palette(q2, pal);
+      err2 = fxt1_nearest(input, N_TEXELS, pal, 8, index2);
+      if (err2 >= err) {
+         break;
+      }
+      err = err2;
+      _mesa_memcpy(q, q2, sizeof(q2));
+      _mesa_memcpy(index, index2, sizeof(index2));
+   }
+
+   /* 3 bit indices in the low 96 bits */
+   cc[0] = cc[1] = cc[2] = 0;
+   for (k = 0; k < N_TEXELS; k++) {
+      const GLint t = k * 3;
+      cc[t / 32] |= (GLuint) index[k] << (t & 31);
+      if ((t & 31) > 29) {
+         cc[t / 32 + 1] |= (GLuint) index[k] >> (32 - (t & 31));
+      }
+   }
+   /* cc-high = "00" + colors */
+   cc[3] = 0;
+   for (k = 1; k >= 0; k--) {
+      for (i = 0; i < 3; i++) {
+         cc[3] = (cc[3] << 5) | q[k][i];
+      }
+   }
+
+   return err;
+}
+
+
+/**
+ * Encode an opaque block in the CHROMA mode: four 5 bit colors for the
+ * whole block, found with a few iterations of Lloyd's algorithm from the
+ * colors of the MIXED mode.  Returns the squared error.
+ */
+static GLuint
+fxt1_encode_CHROMA (GLuint *cc, GLubyte input[N_TEXELS][MAX_COMP],
+                    GLint mixed[2 * 2][3])
+{
+   GLubyte index[N_TEXELS], bestIndex[N_TEXELS];
+   GLubyte pal[4][MAX_COMP];
+   GLfloat vec[4][3];
+   GLint q[4][3], bestQ[4][3];
+   GLuint err, best = ~0u;
+   GLint i, j, k, rep;
+   Fx64 hi;
+
+   for (j = 0; j < 4; j++) {
+      vec[j][RCOMP] = UP5(mixed[j][RCOMP]);
+      vec[j][GCOMP] = _rgb_scale_6[mixed[j][GCOMP]];
+      vec[j][BCOMP] = UP5(mixed[j][BCOMP]);
+   }
+
+   for (rep = 0; rep < 4; rep++) {
+      GLint sum[4][3], cnt[4];
+
+      for (j = 0; j < 4; j++) {
+         for (i = 0; i < 3; i++) {
+            q[j][i] = QUANT5(vec[j][i]);
+            pal[j][i] = UP5(q[j][i]);
+         }
+         pal[j][ACOMP] = 255;
+      }
+      err = fxt1_nearest(input, N_TEXELS, pal, 4, index);
+      if (err >= best) {
+         break;
+      }
+      best = err;
+      _mesa_memcpy(bestQ, q, sizeof(q));
+      _mesa_memcpy(bestIndex, index, sizeof(index));
+      if (err == 0) {
+         break;
+      }
+
+      /* move each vector to the barycenter of its closest colors */
+      _mesa_memset(sum, 0, sizeof(sum));
+      _mesa_memset(cnt, 0, sizeof(cnt));
+      for (k = 0; k < N_TEXELS; k++) {
+         for (i = 0; i < 3; i++) {
+            sum[index[k]][i] += input[k][i];
+         }
+         cnt[index[k]]++;
+      }
+      for (j = 0; j < 4; j++) {
+         if (cnt[j]) {
+            for (i = 0; i < 3; i++) {
+               vec[j][i] = (GLfloat) sum[j][i] / cnt[j];
+            }
+         }
+      }
+   }
+
+   cc[0] = cc[1] = 0;
+   for (k = N_TEXELS / 2 - 1; k >= 0; k--) {
+      cc[0] = (cc[0] << 2) | bestIndex[k];
+      cc[1] = (cc[1] << 2) | bestIndex[k + N_TEXELS / 2];
+   }
+   FX64_MOV32(hi, 4); /* cc-chroma = "010" + unused bit */
+   for (j = 3; j >= 0; j--) {
+      for (i = 0; i < 3; i++) {
+         /* add in colors */
+         FX64_SHL(hi, 5);
+         FX64_OR32(hi, (GLuint) bestQ[j][i]);
+      }
+   }
+   ((Fx64 *)cc)[1] = hi;
+
+   return best;
+}
+
+
+/**
+ * Quantize a block with the high quality encoder.  input holds all the
+ * texels of the block and the first n texels of reord are those which
+ * aren't transparent black.
+ */
+static void
+fxt1_quantize_hq (GLuint *cc,
+                  GLubyte input[N_TEXELS][MAX_COMP],
+                  GLubyte reord[N_TEXELS][MAX_COMP], GLint n,
+                  GLint trualpha)
+{
+   GLint q[2 * 2][3];
+   GLuint tmp[4];
+   GLuint best, err;
+
+   if (trualpha) {
+      fxt1_quantize_ALPHA1(cc, input);
+      best = fxt1_block_error(cc, input);
+      fxt1_quantize_ALPHA0(tmp, input, reord, n);
+      err = fxt1_block_error(tmp, input);
+      if (err < best) {
+         COPY_4V(cc, tmp);
+      }
+      return;
+   }
+
+   if (n == 0) {
+      cc[0] = cc[1] = cc[2] = ~0u;
+      cc[3] = 0;
+      return;
+   }
+
+   best = fxt1_encode_MIXED(cc, input, n < N_TEXELS, q);
+   if (best == 0) {
+      return;
+   }
+
+   err = fxt1_encode_HI(tmp, input, reord, n, best);
+   if (err < best) {
+      best = err;
+      COPY_4V(cc, tmp);
+   }
+
+   /* four colors for the whole block rarely beat the MIXED mode when
+    * its texels are close to its lines
+    */
+   if (n == N_TEXELS && best > CHROMA_MIN_ERROR) {
+      err = fxt1_encode_CHROMA(tmp, input, q);
+      if (err < best) {
+         COPY_4V(cc, tmp);
+      }
+   }
+}
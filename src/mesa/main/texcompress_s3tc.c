@@ -26,100 +26,1012 @@
 /**
  * \file texcompress_s3tc.c
  * GL_EXT_texture_compression_s3tc support.
+ *
+ * Textures are compressed with the DXT1/3/5 block encoder below and
+ * decoded a whole 4x4 block at a time into a small per-thread cache, so
+ * that texture filtering only decodes each block once.
  */
 
-#ifndef USE_EXTERNAL_DXTN_LIB
-#define USE_EXTERNAL_DXTN_LIB 1
-#endif
-
 #include "glheader.h"
 #include "imports.h"
 #include "colormac.h"
 #include "context.h"
 #include "convolve.h"
-#include "dlopen.h"
 #include "image.h"
+#include "macros.h"
 #include "texcompress.h"
 #include "texformat.h"
 #include "texstore.h"
+#include "threadpool.h"
+
+#ifdef PTHREADS
+#include <pthread.h>
+#endif
+
+
+#define DXT1_BLOCK_SIZE 8
+#define DXT35_BLOCK_SIZE 16
+
+/** Images with fewer texels than this are compressed by one thread */
+#define MIN_THREADED_TEXELS (64 * 64)
+
+/** Expand the fields of a 565 color to 8 bits */
+#define EXP5TO8R(c)  ((((c) >> 8) & 0xf8) | (((c) >> 13) & 0x7))
+#define EXP6TO8G(c)  ((((c) >> 3) & 0xfc) | (((c) >>  9) & 0x3))
+#define EXP5TO8B(c)  ((((c) << 3) & 0xf8) | (((c) >>  2) & 0x7))
+
+
+/**
+ * Decodes a compressed block into 16 texels, row by row.  Each texel is
+ * four RGBA GLubytes, kept in a GLuint so that it can be copied at once.
+ */
+typedef void (*dxt_decode_func)(const GLubyte *block, GLuint texels[16]);
+
+
+/**
+ * Compute the four colors a DXT color block can select.
+ * \param fourColor  DXT3/5 block, or DXT1 block with color0 > color1
+ * \param dxt1Alpha  the last color of three color blocks is transparent
+ *                   black instead of opaque black
+ */
+static void
+dxt_color_palette(GLuint c0, GLuint c1, GLboolean fourColor,
+                  GLboolean dxt1Alpha, GLubyte pal[4][4])
+{
+   GLuint k;
+
+   pal[0][RCOMP] = EXP5TO8R(c0);
+   pal[0][GCOMP] = EXP6TO8G(c0);
+   pal[0][BCOMP] = EXP5TO8B(c0);
+   pal[1][RCOMP] = EXP5TO8R(c1);
+   pal[1][GCOMP] = EXP6TO8G(c1);
+   pal[1][BCOMP] = EXP5TO8B(c1);
+
+   if (fourColor) {
+      for (k = 0; k < 3; k++) {
+         pal[2][k] = (2 * pal[0][k] + pal[1][k]) / 3;
+         pal[3][k] = (pal[0][k] + 2 * pal[1][k]) / 3;
+      }
+      pal[3][ACOMP] = 255;
+   }
+   else {
+      for (k = 0; k < 3; k++) {
+         pal[2][k] = (pal[0][k] + pal[1][k]) / 2;
+         pal[3][k] = 0;
+      }
+      pal[3][ACOMP] = dxt1Alpha ? 0 : 255;
+   }
+   pal[0][ACOMP] = pal[1][ACOMP] = pal[2][ACOMP] = 255;
+}
+
+
+/**
+ * Compute the eight alpha values a DXT5 alpha block can select.
+ */
+static void
+dxt5_alpha_palette(GLuint a0, GLuint a1, GLubyte pal[8])
+{
+   GLuint k;
+
+   pal[0] = a0;
+   pal[1] = a1;
+   if (a0 > a1) {
+      for (k = 2; k < 8; k++)
+         pal[k] = (a0 * (8 - k) + a1 * (k - 1)) / 7;
+   }
+   else {
+      for (k = 2; k < 6; k++)
+         pal[k] = (a0 * (6 - k) + a1 * (k - 1)) / 5;
+      pal[6] = 0;
+      pal[7] = 255;
+   }
+}
+
+
+/**
+ * Decode the color half of a block.
+ * \param dxt1  DXT1 block, which has a three color mode
+ */
+static void
+decode_color_block(const GLubyte *block, GLboolean dxt1, GLboolean dxt1Alpha,
+                   GLuint texels[16])
+{
+   const GLuint c0 = block[0] | (block[1] << 8);
+   const GLuint c1 = block[2] | (block[3] << 8);
+   GLuint bits = block[4] | (block[5] << 8) | (block[6] << 16) |
+      ((GLuint) block[7] << 24);
+   GLubyte pal[4][4];
+   GLuint words[4], i;
+
+   dxt_color_palette(c0, c1, !dxt1 || c0 > c1, dxt1Alpha, pal);
+   MEMCPY(words, pal, sizeof(words));
+
+   for (i = 0; i < 16; i++, bits >>= 2) {
+      texels[i] = words[bits & 3];
+   }
+}
+
+
+static void
+decode_rgb_dxt1(const GLubyte *block, GLuint texels[16])
+{
+   decode_color_block(block, GL_TRUE, GL_FALSE, texels);
+}
+
+
+static void
+decode_rgba_dxt1(const GLubyte *block, GLuint texels[16])
+{
+   decode_color_block(block, GL_TRUE, GL_TRUE, texels);
+}
 
-#ifdef __MINGW32__
-#define DXTN_LIBNAME "dxtn.dll"
-#define RTLD_LAZY 0
-#define RTLD_GLOBAL 0
-#elif defined(__DJGPP__)
-#define DXTN_LIBNAME "dxtn.dxe"
+
+static void
+decode_rgba_dxt3(const GLubyte *block, GLuint texels[16])
+{
+   GLuint i;
+
+   decode_color_block(block + 8, GL_FALSE, GL_FALSE, texels);
+
+   for (i = 0; i < 16; i++) {
+      const GLuint a = (block[i / 2] >> (4 * (i & 1))) & 0xf;
+      ((GLubyte *) &texels[i])[ACOMP] = a | (a << 4);
+   }
+}
+
+
+static void
+decode_rgba_dxt5(const GLubyte *block, GLuint texels[16])
+{
+   /* 16 three bit alpha codes, 8 in each word */
+   GLuint codes[2];
+   GLubyte pal[8];
+   GLuint i;
+
+   decode_color_block(block + 8, GL_FALSE, GL_FALSE, texels);
+
+   dxt5_alpha_palette(block[0], block[1], pal);
+   codes[0] = block[2] | (block[3] << 8) | (block[4] << 16);
+   codes[1] = block[5] | (block[6] << 8) | (block[7] << 16);
+
+   for (i = 0; i < 16; i++) {
+      ((GLubyte *) &texels[i])[ACOMP] =
+         pal[(codes[i / 8] >> (3 * (i & 7))) & 7];
+   }
+}
+
+
+
+/**********************************************************************/
+/*****                    Decoded block cache                     *****/
+/**********************************************************************/
+
+/*
+ * Each thread which samples DXT textures keeps the most recently decoded
+ * blocks.  A block is found by its position in the image, so that the
+ * blocks along a span use different sets: the 256 sets cover 256 blocks
+ * of a row, and rows of blocks are offset by 16 sets.  With four ways,
+ * the blocks a span crosses are still cached when the next few spans
+ * cross them, even for 1024 texel wide images.
+ */
+
+#define DXT_CACHE_SETS 256
+#define DXT_CACHE_WAYS 4
+
+struct dxt_tile
+{
+   const GLubyte *Block;     /**< the compressed block, or NULL if unused */
+   dxt_decode_func Decode;   /**< how Block was decoded */
+   GLuint Texels[16];
+};
+
+struct dxt_cache
+{
+   GLuint Stamp;             /**< DxtCacheStamp when the tiles were decoded */
+   struct dxt_tile *Sets[DXT_CACHE_SETS][DXT_CACHE_WAYS]; /**< MRU first */
+   struct dxt_tile Tiles[DXT_CACHE_SETS * DXT_CACHE_WAYS];
+};
+
+
+/**
+ * Incremented whenever DXT image data is written, to flush all caches.
+ */
+static volatile GLuint DxtCacheStamp = 0;
+
+#if defined(PTHREADS)
+static pthread_once_t DxtCacheOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t DxtCacheKey;
+
+static void
+free_dxt_cache(void *cache)
+{
+   _mesa_free(cache);
+}
+
+static void
+create_dxt_cache_key(void)
+{
+   pthread_key_create(&DxtCacheKey, free_dxt_cache);
+}
+#elif !defined(THREADS)
+static struct dxt_cache *DxtCache = NULL;
+#endif
+
+
+/**
+ * Return the calling thread's cache of decoded blocks, or NULL if
+ * there's none.  Without POSIX threads there's no way to free a
+ * thread's cache when it exits, so multithreaded builds on other thread
+ * APIs decode the block again for each texel.
+ */
+static struct dxt_cache *
+get_dxt_cache(void)
+{
+#if defined(PTHREADS) || !defined(THREADS)
+   struct dxt_cache *cache;
+   GLuint i, w;
+
+#if defined(PTHREADS)
+   cache = (struct dxt_cache *) pthread_getspecific(DxtCacheKey);
 #else
-#define DXTN_LIBNAME "libtxc_dxtn.so"
+   cache = DxtCache;
 #endif
 
+   if (cache && cache->Stamp == DxtCacheStamp)
+      return cache;
 
-typedef void (*dxtFetchTexelFuncExt)( GLint srcRowstride, GLubyte *pixdata, GLint col, GLint row, GLvoid *texelOut );
+   if (!cache) {
+      cache = (struct dxt_cache *) _mesa_malloc(sizeof(struct dxt_cache));
+      if (!cache)
+         return NULL;
+#if defined(PTHREADS)
+      pthread_setspecific(DxtCacheKey, cache);
+#else
+      DxtCache = cache;
+#endif
+   }
 
-dxtFetchTexelFuncExt fetch_ext_rgb_dxt1 = NULL;
-dxtFetchTexelFuncExt fetch_ext_rgba_dxt1 = NULL;
-dxtFetchTexelFuncExt fetch_ext_rgba_dxt3 = NULL;
-dxtFetchTexelFuncExt fetch_ext_rgba_dxt5 = NULL;
+   /* (re)initialize */
+   cache->Stamp = DxtCacheStamp;
+   for (i = 0; i < DXT_CACHE_SETS; i++) {
+      for (w = 0; w < DXT_CACHE_WAYS; w++) {
+         struct dxt_tile *tile = &cache->Tiles[i * DXT_CACHE_WAYS + w];
+         tile->Block = NULL;
+         cache->Sets[i][w] = tile;
+      }
+   }
+   return cache;
+#else
+   return NULL;
+#endif
+}
 
-typedef void (*dxtCompressTexFuncExt)(GLint srccomps, GLint width,
-                                      GLint height, const GLchan *srcPixData,
-                                      GLenum destformat, GLubyte *dest,
-                                      GLint dstRowStride);
 
-static dxtCompressTexFuncExt ext_tx_compress_dxtn = NULL;
+/**
+ * Discard all decoded blocks.  Must be called after DXT compressed
+ * image data is modified.
+ */
+void
+_mesa_invalidate_dxtn_cache(void)
+{
+   DxtCacheStamp++;
+}
 
-static void *dxtlibhandle = NULL;
 
+/**
+ * Find the decoded texels of a block in the cache, decoding the block
+ * if it isn't there.
+ * \param bi, bj  block column and row
+ */
+static INLINE const struct dxt_tile *
+lookup_dxt_tile(struct dxt_cache *cache, const GLubyte *block,
+                GLint bi, GLint bj, dxt_decode_func decode)
+{
+   struct dxt_tile **ways = cache->Sets[(bi + (bj << 4)) & (DXT_CACHE_SETS - 1)];
+   struct dxt_tile *tile = ways[0];
+   GLuint w;
 
+   if (tile->Block == block && tile->Decode == decode)
+      return tile;
+
+   for (w = 1; w < DXT_CACHE_WAYS; w++) {
+      tile = ways[w];
+      if (tile->Block == block && tile->Decode == decode)
+         break;
+   }
+
+   if (w == DXT_CACHE_WAYS) {
+      /* replace the least recently used tile */
+      w = DXT_CACHE_WAYS - 1;
+      tile = ways[w];
+      decode(block, tile->Texels);
+      tile->Block = block;
+      tile->Decode = decode;
+   }
+
+   /* make it the most recently used */
+   for (; w > 0; w--)
+      ways[w] = ways[w - 1];
+   ways[0] = tile;
+
+   return tile;
+}
+
+
+/**
+ * Fetch texel (i, j) of a DXT image.
+ */
+static void
+fetch_dxt_texel(const struct gl_texture_image *texImage, GLint i, GLint j,
+                GLuint blockSize, dxt_decode_func decode, GLubyte rgba[4])
+{
+   const GLint bi = i >> 2, bj = j >> 2;
+   const GLubyte *block = (const GLubyte *) texImage->Data
+      + ((texImage->RowStride + 3) / 4 * bj + bi) * blockSize;
+   const GLuint texel = (j & 3) * 4 + (i & 3);
+   struct dxt_cache *cache = get_dxt_cache();
+
+   if (cache) {
+      const struct dxt_tile *tile =
+         lookup_dxt_tile(cache, block, bi, bj, decode);
+      MEMCPY(rgba, &tile->Texels[texel], 4);
+   }
+   else {
+      GLuint texels[16];
+      decode(block, texels);
+      MEMCPY(rgba, &texels[texel], 4);
+   }
+}
+
+
+/**
+ * Fetch the texels (i[k], j[k]) of a DXT image at once, for samplers
+ * which work on spans.
+ */
 void
-_mesa_init_texture_s3tc( GLcontext *ctx )
+_mesa_fetch_dxtn_texels(const struct gl_texture_image *texImage, GLuint n,
+                        const GLint i[], const GLint j[], GLubyte rgba[][4])
 {
-   /* called during context initialization */
-   ctx->Mesa_DXTn = GL_FALSE;
-#if USE_EXTERNAL_DXTN_LIB
-   if (!dxtlibhandle) {
-      dxtlibhandle = _mesa_dlopen(DXTN_LIBNAME, 0);
-      if (!dxtlibhandle) {
-	 _mesa_warning(ctx, "couldn't open " DXTN_LIBNAME ", software DXTn "
-	    "compression/decompression unavailable");
+   const GLubyte *data = (const GLubyte *) texImage->Data;
+   const GLint blocksPerRow = (texImage->RowStride + 3) / 4;
+   struct dxt_cache *cache = get_dxt_cache();
+   const struct dxt_tile *tile = NULL;
+   const GLubyte *lastBlock = NULL;
+   dxt_decode_func decode;
+   GLuint blockSize, k;
+
+   switch (texImage->TexFormat->MesaFormat) {
+   case MESA_FORMAT_RGB_DXT1:
+      decode = decode_rgb_dxt1;
+      blockSize = DXT1_BLOCK_SIZE;
+      break;
+   case MESA_FORMAT_RGBA_DXT1:
+      decode = decode_rgba_dxt1;
+      blockSize = DXT1_BLOCK_SIZE;
+      break;
+   case MESA_FORMAT_RGBA_DXT3:
+      decode = decode_rgba_dxt3;
+      blockSize = DXT35_BLOCK_SIZE;
+      break;
+   default:
+      ASSERT(texImage->TexFormat->MesaFormat == MESA_FORMAT_RGBA_DXT5);
+      decode = decode_rgba_dxt5;
+      blockSize = DXT35_BLOCK_SIZE;
+   }
+
+   if (!cache) {
+      for (k = 0; k < n; k++) {
+         GLuint texels[16];
+         decode(data + (blocksPerRow * (j[k] >> 2) + (i[k] >> 2)) * blockSize,
+                texels);
+         MEMCPY(rgba[k], &texels[(j[k] & 3) * 4 + (i[k] & 3)], 4);
       }
-      else {
-         /* the fetch functions are not per context! Might be problematic... */
-         fetch_ext_rgb_dxt1 = (dxtFetchTexelFuncExt)
-            _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgb_dxt1");
-         fetch_ext_rgba_dxt1 = (dxtFetchTexelFuncExt)
-            _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgba_dxt1");
-         fetch_ext_rgba_dxt3 = (dxtFetchTexelFuncExt)
-            _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgba_dxt3");
-         fetch_ext_rgba_dxt5 = (dxtFetchTexelFuncExt)
-            _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgba_dxt5");
-         ext_tx_compress_dxtn = (dxtCompressTexFuncExt)
-            _mesa_dlsym(dxtlibhandle, "tx_compress_dxtn");
-
-         if (!fetch_ext_rgb_dxt1 ||
-             !fetch_ext_rgba_dxt1 ||
-             !fetch_ext_rgba_dxt3 ||
-             !fetch_ext_rgba_dxt5 ||
-             !ext_tx_compress_dxtn) {
-	    _mesa_warning(ctx, "couldn't reference all symbols in "
-	       DXTN_LIBNAME ", software DXTn compression/decompression "
-	       "unavailable");
-            fetch_ext_rgb_dxt1 = NULL;
-            fetch_ext_rgba_dxt1 = NULL;
-            fetch_ext_rgba_dxt3 = NULL;
-            fetch_ext_rgba_dxt5 = NULL;
-            ext_tx_compress_dxtn = NULL;
-            _mesa_dlclose(dxtlibhandle);
-            dxtlibhandle = NULL;
+      return;
+   }
+
+   for (k = 0; k < n; k++) {
+      const GLint bi = i[k] >> 2, bj = j[k] >> 2;
+      const GLubyte *block = data + (blocksPerRow * bj + bi) * blockSize;
+      /* neighbouring samples are often in the same block */
+      if (block != lastBlock) {
+         tile = lookup_dxt_tile(cache, block, bi, bj, decode);
+         lastBlock = block;
+      }
+      MEMCPY(rgba[k], &tile->Texels[(j[k] & 3) * 4 + (i[k] & 3)], 4);
+   }
+}
+
+
+
+/**********************************************************************/
+/*****                      Block encoder                         *****/
+/**********************************************************************/
+
+/*
+ * The fast encoder takes the color endpoints from the bounding box of
+ * the block's colors.  The high quality encoder fits a line through the
+ * colors (their principal axis) and then refines the endpoints with a
+ * least squares fit to the chosen palette entries.  GL_FASTEST for
+ * GL_TEXTURE_COMPRESSION_HINT selects the fast encoder.
+ */
+
+/**
+ * Squared RGB distance.
+ */
+static INLINE GLuint
+color_dist(const GLubyte a[4], const GLubyte b[4])
+{
+   const GLint dr = a[RCOMP] - b[RCOMP];
+   const GLint dg = a[GCOMP] - b[GCOMP];
+   const GLint db = a[BCOMP] - b[BCOMP];
+   return dr * dr + dg * dg + db * db;
+}
+
+
+/**
+ * Quantize a color to 565.
+ */
+static GLuint
+pack_565(const GLfloat c[3])
+{
+   const GLint r = IROUND(CLAMP(c[0], 0.0F, 255.0F) * (31.0F / 255.0F));
+   const GLint g = IROUND(CLAMP(c[1], 0.0F, 255.0F) * (63.0F / 255.0F));
+   const GLint b = IROUND(CLAMP(c[2], 0.0F, 255.0F) * (31.0F / 255.0F));
+   return (r << 11) | (g << 5) | b;
+}
+
+
+/**
+ * Choose the nearest palette color for each texel.
+ * \param transparent  texels to encode as transparent (RGBA DXT1 only)
+ * \param bits  returns the 32 bits of color indices
+ * \return  sum of squared errors
+ */
+static GLuint
+choose_color_indices(GLubyte rgba[16][4], GLuint transparent,
+                     GLuint c0, GLuint c1, GLboolean dxt1, GLboolean dxt1Alpha,
+                     GLuint *bits)
+{
+   const GLboolean fourColor = !dxt1 || c0 > c1;
+   /* the transparent entry can't be used for opaque texels */
+   const GLuint numColors = (dxt1Alpha && !fourColor) ? 3 : 4;
+   GLubyte pal[4][4];
+   GLuint i, k, error = 0;
+
+   dxt_color_palette(c0, c1, fourColor, dxt1Alpha, pal);
+
+   *bits = 0;
+   for (i = 0; i < 16; i++) {
+      GLuint best = 0, bestDist;
+      if (transparent & (1 << i)) {
+         *bits |= 3 << (2 * i);
+         continue;
+      }
+      bestDist = color_dist(rgba[i], pal[0]);
+      for (k = 1; k < numColors; k++) {
+         const GLuint dist = color_dist(rgba[i], pal[k]);
+         if (dist < bestDist) {
+            bestDist = dist;
+            best = k;
+         }
+      }
+      *bits |= best << (2 * i);
+      error += bestDist;
+   }
+   return error;
+}
+
+
+/**
+ * Endpoints spanning the bounding box of the colors, inset by 1/16 of
+ * its size.  The box diagonal is flipped for red or blue channels which
+ * decrease as green increases.
+ */
+static void
+bbox_endpoints(GLubyte rgba[16][4], GLuint used, GLfloat ep[2][3])
+{
+   GLint lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+   GLfloat center[3], covRG = 0.0F, covBG = 0.0F;
+   GLuint i, k;
+
+   for (i = 0; i < 16; i++) {
+      if (used & (1 << i)) {
+         for (k = 0; k < 3; k++) {
+            lo[k] = MIN2(lo[k], rgba[i][k]);
+            hi[k] = MAX2(hi[k], rgba[i][k]);
+         }
+      }
+   }
+
+   for (k = 0; k < 3; k++)
+      center[k] = 0.5F * (lo[k] + hi[k]);
+
+   for (i = 0; i < 16; i++) {
+      if (used & (1 << i)) {
+         const GLfloat g = rgba[i][GCOMP] - center[GCOMP];
+         covRG += (rgba[i][RCOMP] - center[RCOMP]) * g;
+         covBG += (rgba[i][BCOMP] - center[BCOMP]) * g;
+      }
+   }
+
+   for (k = 0; k < 3; k++) {
+      const GLfloat inset = (hi[k] - lo[k]) * (1.0F / 16.0F);
+      ep[0][k] = hi[k] - inset;
+      ep[1][k] = lo[k] + inset;
+   }
+   if (covRG < 0.0F) {
+      const GLfloat t = ep[0][RCOMP];
+      ep[0][RCOMP] = ep[1][RCOMP];
+      ep[1][RCOMP] = t;
+   }
+   if (covBG < 0.0F) {
+      const GLfloat t = ep[0][BCOMP];
+      ep[0][BCOMP] = ep[1][BCOMP];
+      ep[1][BCOMP] = t;
+   }
+}
+
+
+/**
+ * Endpoints at the extremes of the colors along their principal axis.
+ */
+static void
+pca_endpoints(GLubyte rgba[16][4], GLuint used, GLfloat ep[2][3])
+{
+   GLfloat mean[3] = { 0.0F, 0.0F, 0.0F };
+   GLfloat cov[3][3], axis[3];
+   GLfloat tmin = 0.0F, tmax = 0.0F;
+   GLuint i, k, l, n = 0, iter;
+
+   for (i = 0; i < 16; i++) {
+      if (used & (1 << i)) {
+         for (k = 0; k < 3; k++)
+            mean[k] += rgba[i][k];
+         n++;
+      }
+   }
+   for (k = 0; k < 3; k++)
+      mean[k] /= (GLfloat) n;
+
+   for (k = 0; k < 3; k++)
+      for (l = 0; l < 3; l++)
+         cov[k][l] = 0.0F;
+   for (i = 0; i < 16; i++) {
+      if (used & (1 << i)) {
+         GLfloat d[3];
+         for (k = 0; k < 3; k++)
+            d[k] = rgba[i][k] - mean[k];
+         for (k = 0; k < 3; k++)
+            for (l = 0; l < 3; l++)
+               cov[k][l] += d[k] * d[l];
+      }
+   }
+
+   /* power iteration, starting from the channel with the largest spread */
+   k = 0;
+   if (cov[1][1] > cov[k][k])
+      k = 1;
+   if (cov[2][2] > cov[k][k])
+      k = 2;
+   axis[0] = cov[k][0];
+   axis[1] = cov[k][1];
+   axis[2] = cov[k][2];
+   for (iter = 0; iter < 8; iter++) {
+      GLfloat v[3], len;
+      for (k = 0; k < 3; k++)
+         v[k] = cov[k][0] * axis[0] + cov[k][1] * axis[1] + cov[k][2] * axis[2];
+      len = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+      if (len < 1e-6F)
+         break;
+      len = 1.0F / SQRTF(len);
+      axis[0] = v[0] * len;
+      axis[1] = v[1] * len;
+      axis[2] = v[2] * len;
+   }
+   if (iter == 0) {
+      /* all colors the same */
+      COPY_3V(ep[0], mean);
+      COPY_3V(ep[1], mean);
+      return;
+   }
+
+   for (i = 0; i < 16; i++) {
+      if (used & (1 << i)) {
+         const GLfloat t = (rgba[i][0] - mean[0]) * axis[0] +
+                           (rgba[i][1] - mean[1]) * axis[1] +
+                           (rgba[i][2] - mean[2]) * axis[2];
+         tmin = MIN2(tmin, t);
+         tmax = MAX2(tmax, t);
+      }
+   }
+
+   for (k = 0; k < 3; k++) {
+      ep[0][k] = mean[k] + tmax * axis[k];
+      ep[1][k] = mean[k] + tmin * axis[k];
+   }
+}
+
+
+/**
+ * Least squares fit of the endpoints to the colors, given the palette
+ * entry chosen for each texel.
+ * \return GL_FALSE if the system is singular (only one entry used)
+ */
+static GLboolean
+refine_endpoints(GLubyte rgba[16][4], GLuint transparent, GLuint bits,
+                 GLboolean fourColor, GLfloat ep[2][3])
+{
+   static const GLfloat weights4[4] = { 1.0F, 0.0F, 2.0F / 3.0F, 1.0F / 3.0F };
+   static const GLfloat weights3[4] = { 1.0F, 0.0F, 0.5F, 0.0F };
+   const GLfloat *weights = fourColor ? weights4 : weights3;
+   GLfloat aa = 0.0F, bb = 0.0F, ab = 0.0F, det;
+   GLfloat ax[3] = { 0.0F, 0.0F, 0.0F }, bx[3] = { 0.0F, 0.0F, 0.0F };
+   GLuint i, k;
+
+   for (i = 0; i < 16; i++) {
+      const GLuint index = (bits >> (2 * i)) & 3;
+      GLfloat wa, wb;
+      if ((transparent & (1 << i)) || (!fourColor && index == 3))
+         continue;
+      wa = weights[index];
+      wb = 1.0F - wa;
+      aa += wa * wa;
+      bb += wb * wb;
+      ab += wa * wb;
+      for (k = 0; k < 3; k++) {
+         ax[k] += wa * rgba[i][k];
+         bx[k] += wb * rgba[i][k];
+      }
+   }
+
+   det = aa * bb - ab * ab;
+   if (FABSF(det) < 1e-6F)
+      return GL_FALSE;
+   det = 1.0F / det;
+
+   for (k = 0; k < 3; k++) {
+      ep[0][k] = (ax[k] * bb - bx[k] * ab) * det;
+      ep[1][k] = (bx[k] * aa - ax[k] * ab) * det;
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * Quantize the endpoints, put them in the order that selects four
+ * colors (or three colors with transparency) and choose the indices.
+ * \return  sum of squared errors
+ */
+static GLuint
+encode_endpoints(GLubyte rgba[16][4], GLuint transparent,
+                 GLboolean dxt1, GLboolean dxt1Alpha,
+                 GLfloat ep[2][3], GLuint *c0, GLuint *c1, GLuint *bits)
+{
+   GLuint a = pack_565(ep[0]), b = pack_565(ep[1]);
+
+   if ((transparent != 0) == (a > b)) {
+      const GLuint t = a;
+      a = b;
+      b = t;
+   }
+   *c0 = a;
+   *c1 = b;
+   return choose_color_indices(rgba, transparent, a, b, dxt1, dxt1Alpha,
+                               bits);
+}
+
+
+/**
+ * Encode the color half of a block.
+ * \param dxt1Alpha  texels with alpha < 128 are encoded as transparent
+ */
+static void
+encode_color_block(GLubyte rgba[16][4], GLboolean dxt1,
+                   GLboolean dxt1Alpha, GLboolean highQuality,
+                   GLubyte *block)
+{
+   GLuint transparent = 0, c0, c1, bits, error;
+   GLfloat ep[2][3];
+   GLuint i;
+
+   if (dxt1Alpha) {
+      for (i = 0; i < 16; i++) {
+         if (rgba[i][ACOMP] < 128)
+            transparent |= 1 << i;
+      }
+   }
+
+   if (transparent == 0xffff) {
+      c0 = c1 = 0;
+      bits = ~0u;
+   }
+   else if (!highQuality) {
+      bbox_endpoints(rgba, ~transparent, ep);
+      encode_endpoints(rgba, transparent, dxt1, dxt1Alpha, ep,
+                       &c0, &c1, &bits);
+   }
+   else {
+      GLuint iter;
+
+      pca_endpoints(rgba, ~transparent, ep);
+      error = encode_endpoints(rgba, transparent, dxt1, dxt1Alpha, ep,
+                               &c0, &c1, &bits);
+
+      for (iter = 0; iter < 2 && error > 0; iter++) {
+         GLuint c0New, c1New, bitsNew, errorNew;
+         if (!refine_endpoints(rgba, transparent, bits,
+                               !dxt1 || c0 > c1, ep))
+            break;
+         errorNew = encode_endpoints(rgba, transparent, dxt1, dxt1Alpha, ep,
+                                     &c0New, &c1New, &bitsNew);
+         if (errorNew >= error)
+            break;
+         c0 = c0New;
+         c1 = c1New;
+         bits = bitsNew;
+         error = errorNew;
+      }
+   }
+
+   block[0] = c0 & 0xff;
+   block[1] = c0 >> 8;
+   block[2] = c1 & 0xff;
+   block[3] = c1 >> 8;
+   block[4] = bits & 0xff;
+   block[5] = (bits >> 8) & 0xff;
+   block[6] = (bits >> 16) & 0xff;
+   block[7] = bits >> 24;
+}
+
+
+/**
+ * Encode the explicit 4-bit alpha values of a DXT3 block.
+ */
+static void
+encode_dxt3_alpha(GLubyte rgba[16][4], GLubyte *block)
+{
+   GLuint i;
+
+   for (i = 0; i < 8; i++) {
+      const GLuint a0 = (rgba[2 * i][ACOMP] + 8) / 17;
+      const GLuint a1 = (rgba[2 * i + 1][ACOMP] + 8) / 17;
+      block[i] = a0 | (a1 << 4);
+   }
+}
+
+
+/**
+ * Choose the nearest palette entry for each texel's alpha.
+ * \return  sum of squared errors
+ */
+static GLuint
+choose_alpha_codes(GLubyte rgba[16][4], GLuint a0, GLuint a1,
+                   GLuint codes[2])
+{
+   GLubyte pal[8];
+   GLuint i, k, error = 0;
+
+   dxt5_alpha_palette(a0, a1, pal);
+
+   codes[0] = codes[1] = 0;
+   for (i = 0; i < 16; i++) {
+      GLuint best = 0, bestDist = 256 * 256;
+      for (k = 0; k < 8; k++) {
+         const GLint d = rgba[i][ACOMP] - pal[k];
+         const GLuint dist = d * d;
+         if (dist < bestDist) {
+            bestDist = dist;
+            best = k;
          }
       }
+      codes[i / 8] |= best << (3 * (i & 7));
+      error += bestDist;
+   }
+   return error;
+}
+
+
+/**
+ * Encode the interpolated alpha values of a DXT5 block.  The high
+ * quality encoder also tries the six value mode, which has exact 0 and
+ * 255, over the range of the other alpha values.
+ */
+static void
+encode_dxt5_alpha(GLubyte rgba[16][4], GLboolean highQuality,
+                  GLubyte *block)
+{
+   GLuint amin = 255, amax = 0, a0, a1, codes[2], error;
+   GLuint i;
+
+   for (i = 0; i < 16; i++) {
+      amin = MIN2(amin, rgba[i][ACOMP]);
+      amax = MAX2(amax, rgba[i][ACOMP]);
    }
-   if (dxtlibhandle) {
-      ctx->Mesa_DXTn = GL_TRUE;
-      _mesa_warning(ctx, "software DXTn compression/decompression available");
+
+   a0 = amax;
+   a1 = amin;
+   error = choose_alpha_codes(rgba, a0, a1, codes);
+
+   if (highQuality && error > 0) {
+      GLuint lo = 255, hi = 0, codes6[2], error6;
+      for (i = 0; i < 16; i++) {
+         const GLuint a = rgba[i][ACOMP];
+         if (a != 0 && a != 255) {
+            lo = MIN2(lo, a);
+            hi = MAX2(hi, a);
+         }
+      }
+      if (lo > hi)
+         lo = hi = 0;
+      error6 = choose_alpha_codes(rgba, lo, hi, codes6);
+      if (error6 < error) {
+         a0 = lo;
+         a1 = hi;
+         codes[0] = codes6[0];
+         codes[1] = codes6[1];
+      }
    }
+
+   block[0] = a0;
+   block[1] = a1;
+   block[2] = codes[0] & 0xff;
+   block[3] = (codes[0] >> 8) & 0xff;
+   block[4] = codes[0] >> 16;
+   block[5] = codes[1] & 0xff;
+   block[6] = (codes[1] >> 8) & 0xff;
+   block[7] = codes[1] >> 16;
+}
+
+
+/**
+ * Parameters of an image being compressed.
+ */
+struct dxt_encode_job
+{
+   GLint srcComps;            /**< 3 or 4 */
+   GLint width, height;
+   const GLubyte *pixels;
+   GLint srcRowStride;        /**< in bytes */
+   GLenum format;             /**< GL_COMPRESSED_x_S3TC_DXTn_EXT */
+   GLubyte *dst;
+   GLint dstRowStride;        /**< bytes per row of blocks */
+   GLboolean highQuality;
+   GLint rowsPerTask;         /**< rows of blocks */
+};
+
+
+/**
+ * Get a 4x4 block of texels as RGBA.  Blocks which extend past the image
+ * edges repeat the last row and column.
+ */
+static void
+get_block_texels(const struct dxt_encode_job *job, GLint x, GLint y,
+                 GLubyte rgba[16][4])
+{
+   GLint i, j;
+
+   for (j = 0; j < 4; j++) {
+      const GLubyte *row = job->pixels
+         + MIN2(y + j, job->height - 1) * job->srcRowStride;
+      for (i = 0; i < 4; i++) {
+         const GLubyte *p = row + MIN2(x + i, job->width - 1) * job->srcComps;
+         GLubyte *t = rgba[j * 4 + i];
+         t[RCOMP] = p[0];
+         t[GCOMP] = p[1];
+         t[BCOMP] = p[2];
+         t[ACOMP] = (job->srcComps == 4) ? p[3] : 255;
+      }
+   }
+}
+
+
+/**
+ * Compress a band of block rows.  Called via _mesa_threadpool_run().
+ */
+static void
+encode_block_rows(void *data, GLuint task, GLuint thread)
+{
+   const struct dxt_encode_job *job = (const struct dxt_encode_job *) data;
+   const GLint blockSize = (job->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+                            job->format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+      ? DXT1_BLOCK_SIZE : DXT35_BLOCK_SIZE;
+   const GLint first = task * job->rowsPerTask;
+   const GLint last = MIN2(first + job->rowsPerTask, (job->height + 3) / 4);
+   GLint bx, by;
+
+   (void) thread;
+
+   for (by = first; by < last; by++) {
+      GLubyte *block = job->dst + by * job->dstRowStride;
+      for (bx = 0; bx < job->width; bx += 4, block += blockSize) {
+         GLubyte rgba[16][4];
+
+         get_block_texels(job, bx, by * 4, rgba);
+
+         switch (job->format) {
+         case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            encode_color_block(rgba, GL_TRUE, GL_FALSE, job->highQuality,
+                               block);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            encode_color_block(rgba, GL_TRUE, GL_TRUE, job->highQuality,
+                               block);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+            encode_dxt3_alpha(rgba, block);
+            encode_color_block(rgba, GL_FALSE, GL_FALSE, job->highQuality,
+                               block + 8);
+            break;
+         default:
+            ASSERT(job->format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+            encode_dxt5_alpha(rgba, job->highQuality, block);
+            encode_color_block(rgba, GL_FALSE, GL_FALSE, job->highQuality,
+                               block + 8);
+         }
+      }
+   }
+}
+
+
+/**
+ * Compress an RGB or RGBA image.  Large images are compressed by the
+ * texture threads, a band of block rows each.
+ * \param srcRowStride  source row stride in GLchans
+ * \param dstRowStride  bytes per row of blocks
+ */
+static void
+compress_dxtn(GLcontext *ctx, GLint srcComps, GLint width, GLint height,
+              const GLchan *pixels, GLint srcRowStride,
+              GLenum destFormat, GLubyte *dst, GLint dstRowStride)
+{
+   const GLint blockRows = (height + 3) / 4;
+   struct _mesa_threadpool *pool = NULL;
+   struct dxt_encode_job job;
+
+   ASSERT(sizeof(GLchan) == sizeof(GLubyte));
+
+   job.srcComps = srcComps;
+   job.width = width;
+   job.height = height;
+   job.pixels = (const GLubyte *) pixels;
+   job.srcRowStride = srcRowStride;
+   job.format = destFormat;
+   job.dst = dst;
+   job.dstRowStride = dstRowStride;
+   job.highQuality = ctx->Hint.TextureCompression != GL_FASTEST;
+
+   if (blockRows > 1 && width * height >= MIN_THREADED_TEXELS)
+      pool = _mesa_get_texture_pool(ctx);
+
+   if (pool && _mesa_threadpool_num_threads(pool) > 1) {
+      const GLint numThreads = _mesa_threadpool_num_threads(pool);
+      /* a few bands per thread, to even out the work */
+      job.rowsPerTask = MAX2(blockRows / (4 * numThreads), 1);
+      _mesa_threadpool_run(pool,
+                           (blockRows + job.rowsPerTask - 1) / job.rowsPerTask,
+                           encode_block_rows, &job);
+   }
+   else {
+      job.rowsPerTask = blockRows;
+      encode_block_rows(&job, 0, 0);
+   }
+
+   _mesa_invalidate_dxtn_cache();
+}
+
+
+void
+_mesa_init_texture_s3tc( GLcontext *ctx )
+{
+   /* called during context initialization */
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+   ctx->Mesa_DXTn = GL_TRUE;
 #else
-   (void) ctx;
+   /* the encoder and decoder only handle 8-bit channels */
+   ctx->Mesa_DXTn = GL_FALSE;
+#endif
+#if defined(PTHREADS)
+   pthread_once(&DxtCacheOnce, create_dxt_cache_key);
 #endif
 }
 
@@ -170,14 +1082,8 @@ texstore_rgb_dxt1(TEXSTORE_PARAMS)
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
 
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(3, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available");
-   }
+   compress_dxtn(ctx, 3, srcWidth, srcHeight, pixels, srcRowStride,
+                 GL_COMPRESSED_RGB_S3TC_DXT1_EXT, dst, dstRowStride);
 
    if (tempImage)
       _mesa_free((void *) tempImage);
@@ -232,14 +1138,8 @@ texstore_rgba_dxt1(TEXSTORE_PARAMS)
    dst = _mesa_compressed_image_address(dstXoffset, dstYoffset, 0,
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available");
-   }
+   compress_dxtn(ctx, 4, srcWidth, srcHeight, pixels, srcRowStride,
+                 GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, dst, dstRowStride);
 
    if (tempImage)
       _mesa_free((void*) tempImage);
@@ -293,14 +1193,8 @@ texstore_rgba_dxt3(TEXSTORE_PARAMS)
    dst = _mesa_compressed_image_address(dstXoffset, dstYoffset, 0,
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available");
-   }
+   compress_dxtn(ctx, 4, srcWidth, srcHeight, pixels, srcRowStride,
+                 GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, dst, dstRowStride);
 
    if (tempImage)
       _mesa_free((void *) tempImage);
@@ -354,14 +1248,8 @@ texstore_rgba_dxt5(TEXSTORE_PARAMS)
    dst = _mesa_compressed_image_address(dstXoffset, dstYoffset, 0,
                                         dstFormat->MesaFormat,
                                         texWidth, (GLubyte *) dstAddr);
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available");
-   }
+   compress_dxtn(ctx, 4, srcWidth, srcHeight, pixels, srcRowStride,
+                 GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, dst, dstRowStride);
 
    if (tempImage)
       _mesa_free((void *) tempImage);
@@ -374,14 +1262,13 @@ static void
 fetch_texel_2d_rgb_dxt1( const struct gl_texture_image *texImage,
                          GLint i, GLint j, GLint k, GLchan *texel )
 {
+   GLubyte rgba[4];
    (void) k;
-   if (fetch_ext_rgb_dxt1) {
-      ASSERT (sizeof(GLchan) == sizeof(GLubyte));
-      fetch_ext_rgb_dxt1(texImage->RowStride,
-                         (GLubyte *)(texImage)->Data, i, j, texel);
-   }
-   else
-      _mesa_debug(NULL, "attempted to decode s3tc texture without library available\n");
+   fetch_dxt_texel(texImage, i, j, DXT1_BLOCK_SIZE, decode_rgb_dxt1, rgba);
+   texel[RCOMP] = UBYTE_TO_CHAN(rgba[RCOMP]);
+   texel[GCOMP] = UBYTE_TO_CHAN(rgba[GCOMP]);
+   texel[BCOMP] = UBYTE_TO_CHAN(rgba[BCOMP]);
+   texel[ACOMP] = UBYTE_TO_CHAN(rgba[ACOMP]);
 }
 
 
@@ -403,13 +1290,13 @@ static void
 fetch_texel_2d_rgba_dxt1( const struct gl_texture_image *texImage,
                           GLint i, GLint j, GLint k, GLchan *texel )
 {
+   GLubyte rgba[4];
    (void) k;
-   if (fetch_ext_rgba_dxt1) {
-      fetch_ext_rgba_dxt1(texImage->RowStride,
-                          (GLubyte *)(texImage)->Data, i, j, texel);
-   }
-   else
-      _mesa_debug(NULL, "attempted to decode s3tc texture without library available\n");
+   fetch_dxt_texel(texImage, i, j, DXT1_BLOCK_SIZE, decode_rgba_dxt1, rgba);
+   texel[RCOMP] = UBYTE_TO_CHAN(rgba[RCOMP]);
+   texel[GCOMP] = UBYTE_TO_CHAN(rgba[GCOMP]);
+   texel[BCOMP] = UBYTE_TO_CHAN(rgba[BCOMP]);
+   texel[ACOMP] = UBYTE_TO_CHAN(rgba[ACOMP]);
 }
 
 
@@ -431,14 +1318,13 @@ static void
 fetch_texel_2d_rgba_dxt3( const struct gl_texture_image *texImage,
                           GLint i, GLint j, GLint k, GLchan *texel )
 {
+   GLubyte rgba[4];
    (void) k;
-   if (fetch_ext_rgba_dxt3) {
-      ASSERT (sizeof(GLchan) == sizeof(GLubyte));
-      fetch_ext_rgba_dxt3(texImage->RowStride, (GLubyte *)(texImage)->Data,
-                          i, j, texel);
-   }
-   else
-      _mesa_debug(NULL, "attempted to decode s3tc texture without library available\n");
+   fetch_dxt_texel(texImage, i, j, DXT35_BLOCK_SIZE, decode_rgba_dxt3, rgba);
+   texel[RCOMP] = UBYTE_TO_CHAN(rgba[RCOMP]);
+   texel[GCOMP] = UBYTE_TO_CHAN(rgba[GCOMP]);
+   texel[BCOMP] = UBYTE_TO_CHAN(rgba[BCOMP]);
+   texel[ACOMP] = UBYTE_TO_CHAN(rgba[ACOMP]);
 }
 
 
@@ -460,13 +1346,13 @@ static void
 fetch_texel_2d_rgba_dxt5( const struct gl_texture_image *texImage,
                           GLint i, GLint j, GLint k, GLchan *texel )
 {
+   GLubyte rgba[4];
    (void) k;
-   if (fetch_ext_rgba_dxt5) {
-      fetch_ext_rgba_dxt5(texImage->RowStride, (GLubyte *)(texImage)->Data,
-                          i, j, texel);
-   }
-   else
-      _mesa_debug(NULL, "attempted to decode s3tc texture without library available\n");
+   fetch_dxt_texel(texImage, i, j, DXT35_BLOCK_SIZE, decode_rgba_dxt5, rgba);
+   texel[RCOMP] = UBYTE_TO_CHAN(rgba[RCOMP]);
+   texel[GCOMP] = UBYTE_TO_CHAN(rgba[GCOMP]);
+   texel[BCOMP] = UBYTE_TO_CHAN(rgba[BCOMP]);
+   texel[ACOMP] = UBYTE_TO_CHAN(rgba[ACOMP]);
 }
 
 
@@ -66,7 +66,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
             if (mode == GL_REPLACE_EXT)
                mode = GL_REPLACE;
 	    if (texUnit->EnvMode == mode)
-	       return;
+	       RETURN_UNCHANGED(ctx);
             if (mode == GL_MODULATE ||
                 mode == GL_BLEND ||
                 mode == GL_DECAL ||
@@ -93,7 +93,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
             tmp[2] = CLAMP( param[2], 0.0F, 1.0F );
             tmp[3] = CLAMP( param[3], 0.0F, 1.0F );
             if (TEST_EQ_4V(tmp, texUnit->EnvColor))
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_TEXTURE);
             COPY_4FV(texUnit->EnvColor, tmp);
          }
@@ -103,7 +103,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
              ctx->Extensions.ARB_texture_env_combine) {
 	    const GLenum mode = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.ModeRGB == mode)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    switch (mode) {
 	    case GL_REPLACE:
 	    case GL_MODULATE:
@@ -157,7 +157,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
              ctx->Extensions.ARB_texture_env_combine) {
 	    const GLenum mode = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.ModeA == mode)
-	       return;
+	       RETURN_UNCHANGED(ctx);
             switch (mode) {
 	    case GL_REPLACE:
 	    case GL_MODULATE:
@@ -200,7 +200,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	    const GLenum source = (GLenum) (GLint) *param;
 	    const GLuint s = pname - GL_SOURCE0_RGB;
 	    if (texUnit->Combine.SourceRGB[s] == source)
-	       return;
+	       RETURN_UNCHANGED(ctx);
             if (source == GL_TEXTURE ||
                 source == GL_CONSTANT ||
                 source == GL_PRIMARY_COLOR ||
@@ -232,7 +232,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	    const GLenum source = (GLenum) (GLint) *param;
 	    const GLuint s = pname - GL_SOURCE0_ALPHA;
 	    if (texUnit->Combine.SourceA[s] == source)
-	       return;
+	       RETURN_UNCHANGED(ctx);
             if (source == GL_TEXTURE ||
                 source == GL_CONSTANT ||
                 source == GL_PRIMARY_COLOR ||
@@ -263,7 +263,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    const GLuint s = pname - GL_OPERAND0_RGB;
 	    if (texUnit->Combine.OperandRGB[s] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    switch (operand) {
 	    case GL_SRC_COLOR:
 	    case GL_ONE_MINUS_SRC_COLOR:
@@ -288,7 +288,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
              ctx->Extensions.ARB_texture_env_combine) {
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.OperandA[pname-GL_OPERAND0_ALPHA] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    switch (operand) {
 	    case GL_SRC_ALPHA:
 	    case GL_ONE_MINUS_SRC_ALPHA:
@@ -309,7 +309,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	 if (ctx->Extensions.ARB_texture_env_combine) {
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.OperandRGB[2] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    switch (operand) {
 	    case GL_SRC_COLOR:           /* ARB combine only */
 	    case GL_ONE_MINUS_SRC_COLOR: /* ARB combine only */
@@ -326,7 +326,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	 else if (ctx->Extensions.EXT_texture_env_combine) {
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.OperandRGB[2] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    /* operand must be GL_SRC_ALPHA which is the initial value - thus
 	       don't need to actually compare the operand to the possible value */
 	    else {
@@ -343,7 +343,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	 if (ctx->Extensions.ARB_texture_env_combine) {
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.OperandA[2] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    switch (operand) {
 	    case GL_SRC_ALPHA:
 	    case GL_ONE_MINUS_SRC_ALPHA: /* ARB combine only */
@@ -358,7 +358,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	 else if (ctx->Extensions.EXT_texture_env_combine) {
 	    const GLenum operand = (GLenum) (GLint) *param;
 	    if (texUnit->Combine.OperandA[2] == operand)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    /* operand must be GL_SRC_ALPHA which is the initial value - thus
 	       don't need to actually compare the operand to the possible value */
 	    else {
@@ -390,7 +390,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	       return;
 	    }
 	    if (texUnit->Combine.ScaleShiftRGB == newshift)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    FLUSH_VERTICES(ctx, _NEW_TEXTURE);
 	    texUnit->Combine.ScaleShiftRGB = newshift;
 	 }
@@ -418,7 +418,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
 	       return;
 	    }
 	    if (texUnit->Combine.ScaleShiftA == newshift)
-	       return;
+	       RETURN_UNCHANGED(ctx);
 	    FLUSH_VERTICES(ctx, _NEW_TEXTURE);
 	    texUnit->Combine.ScaleShiftA = newshift;
 	 }
@@ -440,7 +440,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
       }
       if (pname == GL_TEXTURE_LOD_BIAS_EXT) {
 	 if (texUnit->LodBias == param[0])
-	    return;
+	    RETURN_UNCHANGED(ctx);
 	 FLUSH_VERTICES(ctx, _NEW_TEXTURE);
          texUnit->LodBias = param[0];
       }
@@ -464,7 +464,7 @@ _mesa_TexEnvfv( GLenum target, GLenum pname, const GLfloat *param )
              */
             const GLboolean state = (GLboolean) value;
             if (ctx->Point.CoordReplace[ctx->Texture.CurrentUnit] == state)
-               return;
+               RETURN_UNCHANGED(ctx);
             FLUSH_VERTICES(ctx, _NEW_POINT);
             ctx->Point.CoordReplace[ctx->Texture.CurrentUnit] = state;
          }
@@ -943,6 +943,9 @@ _mesa_BindTexture( GLenum target, GLuint texName )
 
    assert(valid_texture_object(newTexObj));
 
+   if (_mesa_select_tex_object(ctx, texUnit, target) == newTexObj)
+      RETURN_UNCHANGED(ctx);
+
    /* flush before changing binding */
    FLUSH_VERTICES(ctx, _NEW_TEXTURE);
 
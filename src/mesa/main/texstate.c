@@ -313,7 +313,7 @@ _mesa_ActiveTextureARB(GLenum texture)
    }
 
    if (ctx->Texture.CurrentUnit == texUnit)
-      return;
+      RETURN_UNCHANGED(ctx);
 
    FLUSH_VERTICES(ctx, _NEW_TEXTURE);
 
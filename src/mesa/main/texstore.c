@@ -66,6 +66,7 @@
 #include "texformat.h"
 #include "teximage.h"
 #include "texstore.h"
+#include "threadpool.h"
 #include "enums.h"
 
 
@@ -3530,6 +3531,7 @@ _mesa_store_compressed_teximage2d(GLcontext *ctx, GLenum target, GLint level,
    /* copy the data */
    ASSERT(texImage->CompressedSize == (GLuint) imageSize);
    MEMCPY(texImage->Data, data, imageSize);
+   _mesa_invalidate_dxtn_cache();
 
    /* GL_SGIS_generate_mipmap */
    if (level == texObj->BaseLevel && texObj->GenerateMipmap) {
@@ -3640,6 +3642,7 @@ _mesa_store_compressed_texsubimage2d(GLcontext *ctx, GLenum target,
       dest += destRowStride;
       src += srcRowStride;
    }
+   _mesa_invalidate_dxtn_cache();
 
    /* GL_SGIS_generate_mipmap */
    if (level == texObj->BaseLevel && texObj->GenerateMipmap) {
@@ -3922,3 +3925,34 @@ _mesa_get_compressed_teximage(GLcontext *ctx, GLenum target, GLint level,
                               ctx->Pack.BufferObj);
    }
 }
+
+
+/**
+ * Return the context's threads for mipmap generation and texture
+ * compression, or NULL if MESA_TEXTURE_THREADS doesn't ask for more
+ * than one thread.
+ */
+struct _mesa_threadpool *
+_mesa_get_texture_pool(GLcontext *ctx)
+{
+   if (!ctx->TexturePool) {
+      const GLuint numThreads = _mesa_get_thread_count("MESA_TEXTURE_THREADS");
+      if (numThreads < 2)
+         return NULL;
+      ctx->TexturePool = _mesa_threadpool_create(numThreads);
+   }
+   return ctx->TexturePool;
+}
+
+
+/**
+ * Free the texture threads.  Called when the context is destroyed.
+ */
+void
+_mesa_free_texture_pool(GLcontext *ctx)
+{
+   if (ctx->TexturePool) {
+      _mesa_threadpool_destroy(ctx->TexturePool);
+      ctx->TexturePool = NULL;
+   }
+}
@@ -237,5 +237,11 @@ extern void
 _mesa_unmap_teximage_pbo(GLcontext *ctx,
                          const struct gl_pixelstore_attrib *unpack);
 
+extern struct _mesa_threadpool *
+_mesa_get_texture_pool(GLcontext *ctx);
+
+extern void
+_mesa_free_texture_pool(GLcontext *ctx);
+
 
 #endif
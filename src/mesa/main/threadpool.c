@@ -0,0 +1,277 @@
+/**
+ * \file threadpool.c
+ * Simple pool of worker threads for splitting up CPU-bound work.
+ *
+ * A job is a number of independent tasks.  _mesa_threadpool_run() hands
+ * the tasks out to the worker threads and the calling thread, one at a
+ * time, and returns when all of them are done.  Only one job runs at a
+ * time; concurrent callers are serialized.  Tasks may not start another
+ * job on the same pool.
+ *
+ * Without thread support everything runs in the calling thread.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "glheader.h"
+#include "imports.h"
+#include "macros.h"
+#include "glapi/glthread.h"
+#include "threadpool.h"
+
+
+/**
+ * Per-thread bookkeeping for the worker threads.
+ */
+struct pool_thread {
+   struct _mesa_threadpool *Pool;
+   GLuint Index;              /**< thread number, 1..NumThreads-1 */
+#ifdef PTHREADS
+   pthread_t Thread;
+#endif
+};
+
+
+/**
+ * The thread pool data structure.
+ */
+struct _mesa_threadpool {
+   GLuint NumThreads;         /**< including the calling thread */
+#ifdef PTHREADS
+   struct pool_thread *Workers;
+   pthread_mutex_t RunMutex;  /**< serializes _mesa_threadpool_run() */
+   pthread_mutex_t Mutex;     /**< protects the fields below */
+   pthread_cond_t WorkCond;   /**< signalled when a job is posted */
+   pthread_cond_t DoneCond;   /**< signalled when a job completes */
+   GLuint JobSerial;          /**< incremented for each job */
+   GLboolean Quit;
+
+   /* the current job */
+   mesa_task_func Func;
+   void *Data;
+   GLuint NumTasks;
+   GLuint NextTask;           /**< next task to hand out */
+   GLuint TasksDone;
+#endif
+};
+
+
+#ifdef PTHREADS
+
+/**
+ * Run tasks of the current job until there are none left.
+ * Called with the pool mutex held and returns with it held.
+ */
+static void
+run_tasks(struct _mesa_threadpool *pool, GLuint thread)
+{
+   while (pool->NextTask < pool->NumTasks) {
+      const GLuint task = pool->NextTask++;
+      mesa_task_func func = pool->Func;
+      void *data = pool->Data;
+
+      pthread_mutex_unlock(&pool->Mutex);
+      func(data, task, thread);
+      pthread_mutex_lock(&pool->Mutex);
+
+      if (++pool->TasksDone == pool->NumTasks)
+         pthread_cond_broadcast(&pool->DoneCond);
+   }
+}
+
+
+static void *
+worker_main(void *arg)
+{
+   struct pool_thread *self = (struct pool_thread *) arg;
+   struct _mesa_threadpool *pool = self->Pool;
+   GLuint serial = 0;
+
+   pthread_mutex_lock(&pool->Mutex);
+   for (;;) {
+      while (!pool->Quit && pool->JobSerial == serial)
+         pthread_cond_wait(&pool->WorkCond, &pool->Mutex);
+      if (pool->Quit)
+         break;
+      serial = pool->JobSerial;
+      run_tasks(pool, self->Index);
+   }
+   pthread_mutex_unlock(&pool->Mutex);
+
+   return NULL;
+}
+
+#endif /* PTHREADS */
+
+
+/**
+ * Create a thread pool.
+ * \param numThreads  total number of threads which will run tasks,
+ *                    including the thread calling _mesa_threadpool_run().
+ * \return new pool or NULL if out of memory
+ */
+struct _mesa_threadpool *
+_mesa_threadpool_create(GLuint numThreads)
+{
+   struct _mesa_threadpool *pool = CALLOC_STRUCT(_mesa_threadpool);
+   if (!pool)
+      return NULL;
+
+   numThreads = CLAMP(numThreads, 1, MAX_POOL_THREADS);
+   pool->NumThreads = 1;
+
+#ifdef PTHREADS
+   pthread_mutex_init(&pool->RunMutex, NULL);
+   pthread_mutex_init(&pool->Mutex, NULL);
+   pthread_cond_init(&pool->WorkCond, NULL);
+   pthread_cond_init(&pool->DoneCond, NULL);
+
+   if (numThreads > 1) {
+      GLuint i;
+
+      pool->Workers = (struct pool_thread *)
+         _mesa_calloc(numThreads * sizeof(struct pool_thread));
+      if (!pool->Workers)
+         return pool;
+
+      for (i = 1; i < numThreads; i++) {
+         pool->Workers[i].Pool = pool;
+         pool->Workers[i].Index = i;
+         if (pthread_create(&pool->Workers[i].Thread, NULL,
+                            worker_main, &pool->Workers[i]) != 0) {
+            _mesa_warning(NULL, "Unable to create worker thread %u", i);
+            break;
+         }
+         pool->NumThreads++;
+      }
+   }
+#endif
+
+   return pool;
+}
+
+
+/**
+ * Stop the worker threads and free the pool.
+ */
+void
+_mesa_threadpool_destroy(struct _mesa_threadpool *pool)
+{
+   if (!pool)
+      return;
+
+#ifdef PTHREADS
+   {
+      GLuint i;
+
+      pthread_mutex_lock(&pool->Mutex);
+      pool->Quit = GL_TRUE;
+      pthread_cond_broadcast(&pool->WorkCond);
+      pthread_mutex_unlock(&pool->Mutex);
+
+      for (i = 1; i < pool->NumThreads; i++)
+         pthread_join(pool->Workers[i].Thread, NULL);
+
+      if (pool->Workers)
+         _mesa_free(pool->Workers);
+
+      pthread_cond_destroy(&pool->DoneCond);
+      pthread_cond_destroy(&pool->WorkCond);
+      pthread_mutex_destroy(&pool->Mutex);
+      pthread_mutex_destroy(&pool->RunMutex);
+   }
+#endif
+
+   _mesa_free(pool);
+}
+
+
+/**
+ * \return number of threads which may run tasks (at least one)
+ */
+GLuint
+_mesa_threadpool_num_threads(const struct _mesa_threadpool *pool)
+{
+   return pool ? pool->NumThreads : 1;
+}
+
+
+/**
+ * Run func(data, task, thread) for each task in [0, numTasks) and wait
+ * for all of them to finish.  The order in which tasks are started is
+ * not defined.  A NULL pool runs all the tasks in the calling thread.
+ */
+void
+_mesa_threadpool_run(struct _mesa_threadpool *pool, GLuint numTasks,
+                     mesa_task_func func, void *data)
+{
+   GLuint i;
+
+#ifdef PTHREADS
+   if (pool && pool->NumThreads > 1 && numTasks > 1) {
+      pthread_mutex_lock(&pool->RunMutex);
+      pthread_mutex_lock(&pool->Mutex);
+
+      pool->Func = func;
+      pool->Data = data;
+      pool->NumTasks = numTasks;
+      pool->NextTask = 0;
+      pool->TasksDone = 0;
+      pool->JobSerial++;
+      pthread_cond_broadcast(&pool->WorkCond);
+
+      run_tasks(pool, 0);
+
+      while (pool->TasksDone < pool->NumTasks)
+         pthread_cond_wait(&pool->DoneCond, &pool->Mutex);
+
+      pthread_mutex_unlock(&pool->Mutex);
+      pthread_mutex_unlock(&pool->RunMutex);
+      return;
+   }
+#endif
+
+   (void) pool;
+   for (i = 0; i < numTasks; i++)
+      func(data, i, 0);
+}
+
+
+/**
+ * Parse a thread count from the named environment variable.
+ * \return value in [1, MAX_POOL_THREADS]; 1 if the variable isn't set
+ */
+GLuint
+_mesa_get_thread_count(const char *envVar)
+{
+   const char *s = _mesa_getenv(envVar);
+   GLint n;
+
+   if (!s)
+      return 1;
+   n = _mesa_atoi(s);
+   return (GLuint) CLAMP(n, 1, MAX_POOL_THREADS);
+}
@@ -0,0 +1,73 @@
+/**
+ * \file threadpool.h
+ * Simple pool of worker threads for splitting up CPU-bound work.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+
+#include "glheader.h"
+
+
+/** Upper limit on the number of threads in a pool */
+#define MAX_POOL_THREADS 32
+
+
+/**
+ * Task callback.
+ * \param data  the pointer passed to _mesa_threadpool_run()
+ * \param task  task number in [0, numTasks)
+ * \param thread  number of the thread running the task, in
+ *                [0, _mesa_threadpool_num_threads()).  The calling
+ *                thread is always thread 0.
+ */
+typedef void (*mesa_task_func)(void *data, GLuint task, GLuint thread);
+
+
+struct _mesa_threadpool;
+
+
+extern struct _mesa_threadpool *
+_mesa_threadpool_create(GLuint numThreads);
+
+extern void
+_mesa_threadpool_destroy(struct _mesa_threadpool *pool);
+
+extern GLuint
+_mesa_threadpool_num_threads(const struct _mesa_threadpool *pool);
+
+extern void
+_mesa_threadpool_run(struct _mesa_threadpool *pool, GLuint numTasks,
+                     mesa_task_func func, void *data);
+
+extern GLuint
+_mesa_get_thread_count(const char *envVar);
+
+
+#endif /* THREADPOOL_H */
@@ -231,6 +231,140 @@ static GLvector4f * _XFORMAPI TAG(cliptest_points2)( GLvector4f *clip_vec,
 }
 
 
+/*
+ * Guard band versions of the above: the x and y clip flags are only set
+ * for coordinates beyond guard[0] * w and guard[1] * w.  The projected
+ * coordinates of the vertices inside the guard band may lie outside the
+ * [-1, 1] range.
+ *
+ * \param guard  x and y guard band size, relative to the viewport (>= 1)
+ */
+static GLvector4f * _XFORMAPI TAG(cliptest_gb_points4)( GLvector4f *clip_vec,
+                                                        GLvector4f *proj_vec,
+                                                        GLubyte clipMask[],
+                                                        GLubyte *orMask,
+                                                        GLubyte *andMask,
+                                                        const GLfloat guard[2] )
+{
+   const GLuint stride = clip_vec->stride;
+   const GLfloat *from = (GLfloat *)clip_vec->start;
+   const GLuint count = clip_vec->count;
+   const GLfloat gx = guard[0], gy = guard[1];
+   GLuint c = 0;
+   GLfloat (*vProj)[4] = (GLfloat (*)[4])proj_vec->start;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   GLuint i;
+   STRIDE_LOOP {
+      const GLfloat cx = from[0];
+      const GLfloat cy = from[1];
+      const GLfloat cz = from[2];
+      const GLfloat cw = from[3];
+      const GLfloat cwx = gx * cw, cwy = gy * cw;
+      GLubyte mask = 0;
+      if (-cx + cwx < 0) mask |= CLIP_RIGHT_BIT;
+      if ( cx + cwx < 0) mask |= CLIP_LEFT_BIT;
+      if (-cy + cwy < 0) mask |= CLIP_TOP_BIT;
+      if ( cy + cwy < 0) mask |= CLIP_BOTTOM_BIT;
+      if (-cz + cw < 0)  mask |= CLIP_FAR_BIT;
+      if ( cz + cw < 0)  mask |= CLIP_NEAR_BIT;
+
+      clipMask[i] = mask;
+      if (mask) {
+	 c++;
+	 tmpAndMask &= mask;
+	 tmpOrMask |= mask;
+	 vProj[i][0] = 0;
+	 vProj[i][1] = 0;
+	 vProj[i][2] = 0;
+	 vProj[i][3] = 1;
+      } else {
+	 GLfloat oow = 1.0F / cw;
+	 vProj[i][0] = cx * oow;
+	 vProj[i][1] = cy * oow;
+	 vProj[i][2] = cz * oow;
+	 vProj[i][3] = oow;
+      }
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = (GLubyte) (c < count ? 0 : tmpAndMask);
+
+   proj_vec->flags |= VEC_SIZE_4;
+   proj_vec->size = 4;
+   proj_vec->count = clip_vec->count;
+   return proj_vec;
+}
+
+
+static GLvector4f * _XFORMAPI TAG(cliptest_gb_points3)( GLvector4f *clip_vec,
+                                                        GLvector4f *proj_vec,
+                                                        GLubyte clipMask[],
+                                                        GLubyte *orMask,
+                                                        GLubyte *andMask,
+                                                        const GLfloat guard[2] )
+{
+   const GLuint stride = clip_vec->stride;
+   const GLuint count = clip_vec->count;
+   const GLfloat *from = (GLfloat *)clip_vec->start;
+   const GLfloat gx = guard[0], gy = guard[1];
+   GLubyte tmpOrMask = *orMask;
+   GLubyte tmpAndMask = *andMask;
+   GLuint i;
+   (void) proj_vec;
+   STRIDE_LOOP {
+      const GLfloat cx = from[0], cy = from[1], cz = from[2];
+      GLubyte mask = 0;
+      if (cx >  gx)        mask |= CLIP_RIGHT_BIT;
+      else if (cx < -gx)   mask |= CLIP_LEFT_BIT;
+      if (cy >  gy)        mask |= CLIP_TOP_BIT;
+      else if (cy < -gy)   mask |= CLIP_BOTTOM_BIT;
+      if (cz >  1.0)       mask |= CLIP_FAR_BIT;
+      else if (cz < -1.0)  mask |= CLIP_NEAR_BIT;
+      clipMask[i] = mask;
+      tmpOrMask |= mask;
+      tmpAndMask &= mask;
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+   return clip_vec;
+}
+
+
+static GLvector4f * _XFORMAPI TAG(cliptest_gb_points2)( GLvector4f *clip_vec,
+                                                        GLvector4f *proj_vec,
+                                                        GLubyte clipMask[],
+                                                        GLubyte *orMask,
+                                                        GLubyte *andMask,
+                                                        const GLfloat guard[2] )
+{
+   const GLuint stride = clip_vec->stride;
+   const GLuint count = clip_vec->count;
+   const GLfloat *from = (GLfloat *)clip_vec->start;
+   const GLfloat gx = guard[0], gy = guard[1];
+   GLubyte tmpOrMask = *orMask;
+   GLubyte tmpAndMask = *andMask;
+   GLuint i;
+   (void) proj_vec;
+   STRIDE_LOOP {
+      const GLfloat cx = from[0], cy = from[1];
+      GLubyte mask = 0;
+      if (cx >  gx)        mask |= CLIP_RIGHT_BIT;
+      else if (cx < -gx)   mask |= CLIP_LEFT_BIT;
+      if (cy >  gy)        mask |= CLIP_TOP_BIT;
+      else if (cy < -gy)   mask |= CLIP_BOTTOM_BIT;
+      clipMask[i] = mask;
+      tmpOrMask |= mask;
+      tmpAndMask &= mask;
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+   return clip_vec;
+}
+
+
 static void TAG(init_c_cliptest)( void )
 {
    _mesa_clip_tab[4] = TAG(cliptest_points4);
@@ -240,4 +374,8 @@ static void TAG(init_c_cliptest)( void )
    _mesa_clip_np_tab[4] = TAG(cliptest_np_points4);
    _mesa_clip_np_tab[3] = TAG(cliptest_points3);
    _mesa_clip_np_tab[2] = TAG(cliptest_points2);
+
+   _mesa_clip_gb_tab[4] = TAG(cliptest_gb_points4);
+   _mesa_clip_gb_tab[3] = TAG(cliptest_gb_points3);
+   _mesa_clip_gb_tab[2] = TAG(cliptest_gb_points2);
 }
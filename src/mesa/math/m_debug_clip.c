@@ -198,12 +198,21 @@ ALIGN16(static GLfloat, d[TEST_COUNT][4]);
 ALIGN16(static GLfloat, r[TEST_COUNT][4]);
 
 
-static int test_cliptest_function( clip_func func, int np,
-				   int psize, long *cycles )
+/**
+ * With packed set, the input vertices are tightly packed and there is
+ * an odd number of them, to test the end of the vertex arrays.
+ * If gb_func is given it is tested instead of func, with a guard band
+ * of 1 so that the results must match the regular cliptests.
+ */
+static int test_cliptest_function( clip_func func, clip_gb_func gb_func,
+				   int np, int psize, int packed, long *cycles )
 {
+   static const GLfloat unit_guard[2] = { 1.0, 1.0 };
    GLvector4f source[1], dest[1], ref[1];
    GLubyte dm[TEST_COUNT], dco, dca;
    GLubyte rm[TEST_COUNT], rco, rca;
+   const int count = packed ? TEST_COUNT - 1 : TEST_COUNT;
+   const int stride = packed ? psize * sizeof(GLfloat) : sizeof(s[0]);
    int i, j;
 #ifdef  RUN_DEBUG_BENCHMARK
    int cycle_i;                /* the counter for the benchmarks we run */
@@ -218,16 +227,21 @@ static int test_cliptest_function( clip_func func, int np,
 
    for ( i = 0 ; i < TEST_COUNT ; i++) {
       ASSIGN_4V( d[i], 0.0, 0.0, 0.0, 1.0 );
+      ASSIGN_4V( r[i], 0.0, 0.0, 0.0, 1.0 );
       ASSIGN_4V( s[i], 0.0, 0.0, 0.0, 1.0 );
+      dm[i] = rm[i] = 0;
+   }
+   for ( i = 0 ; i < count ; i++ ) {
+      GLfloat *v = (GLfloat *)((char *)s + i * stride);
       for ( j = 0 ; j < psize ; j++ )
-         s[i][j] = rnd();
+         v[j] = rnd();
    }
 
    source->data = (GLfloat(*)[4])s;
    source->start = (GLfloat *)s;
-   source->count = TEST_COUNT;
-   source->stride = sizeof(s[0]);
-   source->size = 4;
+   source->count = count;
+   source->stride = stride;
+   source->size = psize;
    source->flags = 0;
 
    dest->data = (GLfloat(*)[4])d;
@@ -249,7 +263,10 @@ static int test_cliptest_function( clip_func func, int np,
 
    ref_cliptest[psize]( source, ref, rm, &rco, &rca );
 
-   if ( mesa_profile ) {
+   if ( gb_func ) {
+      gb_func( source, dest, dm, &dco, &dca, unit_guard );
+   }
+   else if ( mesa_profile && !packed ) {
       BEGIN_RACE( *cycles );
       func( source, dest, dm, &dco, &dca );
       END_RACE( *cycles );
@@ -345,7 +362,8 @@ void _math_test_all_cliptest_functions( char *description )
 	 clip_func func = clip_tab[np][psize];
 	 long *cycles = &(benchmark_tab[np][psize-1]);
 
-	 if ( test_cliptest_function( func, np, psize, cycles ) == 0 ) {
+	 if ( test_cliptest_function( func, NULL, np, psize, 0, cycles ) == 0 ||
+	      test_cliptest_function( func, NULL, np, psize, 1, cycles ) == 0 ) {
 	    char buf[100];
 	    _mesa_sprintf( buf, "%s[%d] failed test (%s)",
 		     cnames[np], psize, description );
@@ -365,6 +383,18 @@ void _math_test_all_cliptest_functions( char *description )
    if ( mesa_profile )
       _mesa_printf( "\n" );
 #endif
+
+   for ( psize = 2 ; psize <= 4 ; psize++ ) {
+      clip_gb_func func = _mesa_clip_gb_tab[psize];
+
+      if ( test_cliptest_function( NULL, func, 0, psize, 0, NULL ) == 0 ||
+	   test_cliptest_function( NULL, func, 0, psize, 1, NULL ) == 0 ) {
+	 char buf[100];
+	 _mesa_sprintf( buf, "_mesa_clip_gb_tab[%d] failed test (%s)",
+		  psize, description );
+	 _mesa_problem( NULL, buf );
+      }
+   }
 }
 
 
@@ -193,7 +193,12 @@ static void init_matrix( GLfloat *m )
 }
 
 
-static int test_norm_function( normal_func func, int mtype, long *cycles )
+/**
+ * With packed set, the input normals are tightly packed and there is
+ * an odd number of them, to test the end of the normal arrays.
+ */
+static int test_norm_function( normal_func func, int mtype, int packed,
+			       long *cycles )
 {
    GLvector4f source[1], dest[1], dest2[1], ref[1], ref2[1];
    GLmatrix mat[1];
@@ -201,6 +206,8 @@ static int test_norm_function( normal_func func, int mtype, long *cycles )
    GLfloat d2[TEST_COUNT][4], r2[TEST_COUNT][4], length[TEST_COUNT];
    GLfloat scale;
    GLfloat *m;
+   const int count = packed ? TEST_COUNT - 1 : TEST_COUNT;
+   const int stride = packed ? 3 * sizeof(GLfloat) : sizeof(s[0]);
    int i, j;
 #ifdef  RUN_DEBUG_BENCHMARK
    int cycle_i;		/* the counter for the benchmarks we run */
@@ -239,15 +246,20 @@ static int test_norm_function( normal_func func, int mtype, long *cycles )
       ASSIGN_3V( d[i],  0.0, 0.0, 0.0 );
       ASSIGN_3V( s[i],  0.0, 0.0, 0.0 );
       ASSIGN_3V( d2[i], 0.0, 0.0, 0.0 );
+      ASSIGN_3V( r[i],  0.0, 0.0, 0.0 );
+      ASSIGN_3V( r2[i], 0.0, 0.0, 0.0 );
+   }
+   for ( i = 0 ; i < count ; i++ ) {
+      GLfloat *v = (GLfloat *)((char *)s + i * stride);
       for ( j = 0 ; j < 3 ; j++ )
-         s[i][j] = rnd();
-      length[i] = 1 / SQRTF( LEN_SQUARED_3FV( s[i] ) );
+         v[j] = rnd();
+      length[i] = 1 / SQRTF( LEN_SQUARED_3FV( v ) );
    }
 
    source->data = (GLfloat(*)[4]) s;
    source->start = (GLfloat *) s;
-   source->count = TEST_COUNT;
-   source->stride = sizeof(s[0]);
+   source->count = count;
+   source->stride = stride;
    source->flags = 0;
 
    dest->data = d;
@@ -281,7 +293,7 @@ static int test_norm_function( normal_func func, int mtype, long *cycles )
       ref_norm_transform_normalize( mat, scale, source, length, ref2 );
    }
 
-   if ( mesa_profile ) {
+   if ( mesa_profile && !packed ) {
       BEGIN_RACE( *cycles );
       func( mat, scale, source, NULL, dest );
       END_RACE( *cycles );
@@ -358,7 +370,8 @@ void _math_test_all_normal_transform_functions( char *description )
       normal_func func = _mesa_normal_tab[norm_types[mtype]];
       long *cycles = &benchmark_tab[mtype];
 
-      if ( test_norm_function( func, mtype, cycles ) == 0 ) {
+      if ( test_norm_function( func, mtype, 0, cycles ) == 0 ||
+	   test_norm_function( func, mtype, 1, cycles ) == 0 ) {
 	 char buf[100];
 	 _mesa_sprintf( buf, "_mesa_normal_tab[0][%s] failed test (%s)",
 		  norm_strings[mtype], description );
@@ -143,7 +143,10 @@ static void ref_transform( GLvector4f *dst,
    const GLfloat *m = mat->m;
 
    for ( i = 0 ; i < src->count ; i++ ) {
-      TRANSFORM_POINT( d[i], m, s );
+      GLfloat v[4];
+      ASSIGN_4V( v, 0.0, 0.0, 0.0, 1.0 );
+      COPY_SZ_4V( v, src->size, s );
+      TRANSFORM_POINT( d[i], m, v );
       s = (GLfloat *)((char *)s + src->stride);
    }
 }
@@ -165,12 +168,19 @@ ALIGN16(static GLfloat, s[TEST_COUNT][4]);
 ALIGN16(static GLfloat, d[TEST_COUNT][4]);
 ALIGN16(static GLfloat, r[TEST_COUNT][4]);
 
+/**
+ * With packed set, the input vertices are tightly packed and there is
+ * an odd number of them, to test the end of the vertex arrays.
+ */
 static int test_transform_function( transform_func func, int psize,
-				    int mtype, unsigned long *cycles )
+				    int mtype, int packed,
+				    unsigned long *cycles )
 {
    GLvector4f source[1], dest[1], ref[1];
    GLmatrix mat[1];
    GLfloat *m;
+   const int count = packed ? TEST_COUNT - 1 : TEST_COUNT;
+   const int stride = packed ? psize * sizeof(GLfloat) : sizeof(s[0]);
    int i, j;
 #ifdef  RUN_DEBUG_BENCHMARK
    int cycle_i;                /* the counter for the benchmarks we run */
@@ -213,16 +223,20 @@ static int test_transform_function( transform_func func, int psize,
 
    for ( i = 0 ; i < TEST_COUNT ; i++) {
       ASSIGN_4V( d[i], 0.0, 0.0, 0.0, 1.0 );
+      ASSIGN_4V( r[i], 0.0, 0.0, 0.0, 1.0 );
       ASSIGN_4V( s[i], 0.0, 0.0, 0.0, 1.0 );
+   }
+   for ( i = 0 ; i < count ; i++ ) {
+      GLfloat *v = (GLfloat *)((char *)s + i * stride);
       for ( j = 0 ; j < psize ; j++ )
-         s[i][j] = rnd();
+         v[j] = rnd();
    }
 
    source->data = (GLfloat(*)[4])s;
    source->start = (GLfloat *)s;
-   source->count = TEST_COUNT;
-   source->stride = sizeof(s[0]);
-   source->size = 4;
+   source->count = count;
+   source->stride = stride;
+   source->size = psize;
    source->flags = 0;
 
    dest->data = (GLfloat(*)[4])d;
@@ -241,7 +255,7 @@ static int test_transform_function( transform_func func, int psize,
 
    ref_transform( ref, mat, source );
 
-   if ( mesa_profile ) {
+   if ( mesa_profile && !packed ) {
       BEGIN_RACE( *cycles );
       func( dest, mat->m, source );
       END_RACE( *cycles );
@@ -250,6 +264,14 @@ static int test_transform_function( transform_func func, int psize,
       func( dest, mat->m, source );
    }
 
+   if ( dest->count != source->count ) {
+      _mesa_printf("-----------------------------\n" );
+      _mesa_printf("dest count = %u, expected %u\n",
+		   dest->count, source->count );
+      return 0;
+   }
+
+   /* this also checks that nothing is written past the last vertex */
    for ( i = 0 ; i < TEST_COUNT ; i++ ) {
       for ( j = 0 ; j < 4 ; j++ ) {
          if ( significand_match( d[i][j], r[i][j] ) < REQUIRED_PRECISION ) {
@@ -312,7 +334,8 @@ void _math_test_all_transform_functions( char *description )
 	 transform_func func = _mesa_transform_tab[psize][mtypes[mtype]];
 	 unsigned long *cycles = &(benchmark_tab[psize-1][mtype]);
 
-	 if ( test_transform_function( func, psize, mtype, cycles ) == 0 ) {
+	 if ( test_transform_function( func, psize, mtype, 0, cycles ) == 0 ||
+	      test_transform_function( func, psize, mtype, 1, cycles ) == 0 ) {
 	    char buf[100];
 	    _mesa_sprintf(buf, "_mesa_transform_tab[0][%d][%s] failed test (%s)",
 		     psize, mstrings[mtype], description );
@@ -65,6 +65,7 @@
 
 clip_func _mesa_clip_tab[5];
 clip_func _mesa_clip_np_tab[5];
+clip_gb_func _mesa_clip_gb_tab[5];
 dotprod_func _mesa_dotprod_tab[5];
 vec_copy_func _mesa_copy_tab[0x10];
 normal_func _mesa_normal_tab[0xf];
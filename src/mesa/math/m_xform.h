@@ -108,6 +108,17 @@ typedef GLvector4f * (_XFORMAPIP clip_func)( GLvector4f *vClip,
 					     GLubyte *orMask,
 					     GLubyte *andMask );
 
+/* Like clip_func, but the x and y clip flags are set for coordinates
+ * beyond guard[0] * w and guard[1] * w instead of w (see
+ * _tnl_allow_guard_band()).
+ */
+typedef GLvector4f * (_XFORMAPIP clip_gb_func)( GLvector4f *vClip,
+						GLvector4f *vProj,
+						GLubyte clipMask[],
+						GLubyte *orMask,
+						GLubyte *andMask,
+						const GLfloat guard[2] );
+
 typedef void (*dotprod_func)( GLfloat *out,
 			      GLuint out_stride,
 			      CONST GLvector4f *coord_vec,
@@ -165,6 +176,7 @@ extern vec_copy_func _mesa_copy_tab[0x10];
 extern vec_copy_func _mesa_copy_clean_tab[5];
 extern clip_func     _mesa_clip_tab[5];
 extern clip_func     _mesa_clip_np_tab[5];
+extern clip_gb_func  _mesa_clip_gb_tab[5];
 extern normal_func   _mesa_normal_tab[0xf];
 
 /* Use of 2 layers of linked 1-dimensional arrays to reduce
@@ -100,7 +100,7 @@ NAME(plot)(GLcontext *ctx, struct LineInfo *line, int ix, int iy)
    ATTRIB_LOOP_END
 #endif
 
-   if (line->span.end == MAX_WIDTH) {
+   if (line->span.end == MAX_SPAN_WIDTH) {
 #if defined(DO_RGBA)
       _swrast_write_rgba_span(ctx, &(line->span));
 #else
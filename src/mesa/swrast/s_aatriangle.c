@@ -404,14 +404,17 @@ _swrast_set_aa_triangle_function(GLcontext *ctx)
        || ctx->FragmentProgram._Current
        || swrast->_FogEnabled
        || NEED_SECONDARY_COLOR(ctx)) {
-      SWRAST_CONTEXT(ctx)->Triangle = general_aa_tri;
+      swrast->_TriangleName = "general_aa_tri";
+      swrast->Triangle = general_aa_tri;
    }
    else if (ctx->Visual.rgbMode) {
-      SWRAST_CONTEXT(ctx)->Triangle = rgba_aa_tri;
+      swrast->_TriangleName = "rgba_aa_tri";
+      swrast->Triangle = rgba_aa_tri;
    }
    else {
-      SWRAST_CONTEXT(ctx)->Triangle = index_aa_tri;
+      swrast->_TriangleName = "index_aa_tri";
+      swrast->Triangle = index_aa_tri;
    }
 
-   ASSERT(SWRAST_CONTEXT(ctx)->Triangle);
+   ASSERT(swrast->Triangle);
 }
@@ -217,18 +217,6 @@
 
          /* enter interior of triangle */
          ix = startX;
-
-#if defined(DO_ATTRIBS)
-         /* compute attributes at left-most fragment */
-         span.attrStart[FRAG_ATTRIB_WPOS][3] = solve_plane(ix + 0.5, iy + 0.5, wPlane);
-         ATTRIB_LOOP_BEGIN
-            GLuint c;
-            for (c = 0; c < 4; c++) {
-               span.attrStart[attr][c] = solve_plane(ix + 0.5, iy + 0.5, attrPlane[attr][c]);
-            }
-         ATTRIB_LOOP_END
-#endif
-
          count = 0;
          while (coverage > 0.0F) {
             /* (cx,cy) = center of fragment */
@@ -254,19 +242,31 @@
             ix++;
             count++;
             coverage = compute_coveragef(pMin, pMid, pMax, ix, iy);
-         }
-         
-         if (ix <= startX)
-            continue;
-         
-         span.x = startX;
-         span.y = iy;
-         span.end = (GLuint) ix - (GLuint) startX;
+
+            if (coverage <= 0.0F || count == MAX_SPAN_WIDTH) {
+               /* end of the run, or span arrays are full: draw fragments */
+               const GLint left = ix - (GLint) count;
+#if defined(DO_ATTRIBS)
+               /* compute attributes at left-most fragment */
+               span.attrStart[FRAG_ATTRIB_WPOS][3] = solve_plane(left + 0.5, iy + 0.5, wPlane);
+               ATTRIB_LOOP_BEGIN
+                  GLuint c;
+                  for (c = 0; c < 4; c++) {
+                     span.attrStart[attr][c] = solve_plane(left + 0.5, iy + 0.5, attrPlane[attr][c]);
+                  }
+               ATTRIB_LOOP_END
+#endif
+               span.x = left;
+               span.y = iy;
+               span.end = count;
 #if defined(DO_RGBA)
-         _swrast_write_rgba_span(ctx, &span);
+               _swrast_write_rgba_span(ctx, &span);
 #else
-         _swrast_write_index_span(ctx, &span);
+               _swrast_write_index_span(ctx, &span);
 #endif
+               count = 0;
+            }
+         }
       }
    }
    else {
@@ -279,8 +279,8 @@
       GLfloat x = pMin[0] - (yMin - iyMin) * dxdy;
       GLint iy;
       for (iy = iyMin; iy < iyMax; iy++, x += dxdy) {
-         GLint ix, left, startX = (GLint) (x + xAdj);
-         GLuint count, n;
+         GLint ix, startX = (GLint) (x + xAdj);
+         GLuint count;
          GLfloat coverage = 0.0F;
          
          /* make sure we're not past the window edge */
@@ -303,74 +303,71 @@
             /* (cx,cy) = center of fragment */
             const GLfloat cx = ix + 0.5F, cy = iy + 0.5F;
             SWspanarrays *array = span.array;
+            /* fill the arrays from the right end */
+            const GLuint j = MAX_SPAN_WIDTH - 1 - count;
             ASSERT(ix >= 0);
 #ifdef DO_INDEX
-            array->coverage[ix] = (GLfloat) compute_coveragei(pMin, pMax, pMid, ix, iy);
+            array->coverage[j] = (GLfloat) compute_coveragei(pMin, pMax, pMid, ix, iy);
 #else
-            array->coverage[ix] = coverage;
+            array->coverage[j] = coverage;
 #endif
 #ifdef DO_Z
-            array->z[ix] = (GLuint) solve_plane(cx, cy, zPlane);
+            array->z[j] = (GLuint) solve_plane(cx, cy, zPlane);
 #endif
 #ifdef DO_RGBA
-            array->rgba[ix][RCOMP] = solve_plane_chan(cx, cy, rPlane);
-            array->rgba[ix][GCOMP] = solve_plane_chan(cx, cy, gPlane);
-            array->rgba[ix][BCOMP] = solve_plane_chan(cx, cy, bPlane);
-            array->rgba[ix][ACOMP] = solve_plane_chan(cx, cy, aPlane);
+            array->rgba[j][RCOMP] = solve_plane_chan(cx, cy, rPlane);
+            array->rgba[j][GCOMP] = solve_plane_chan(cx, cy, gPlane);
+            array->rgba[j][BCOMP] = solve_plane_chan(cx, cy, bPlane);
+            array->rgba[j][ACOMP] = solve_plane_chan(cx, cy, aPlane);
 #endif
 #ifdef DO_INDEX
-            array->index[ix] = (GLint) solve_plane(cx, cy, iPlane);
+            array->index[j] = (GLint) solve_plane(cx, cy, iPlane);
 #endif
             ix--;
             count++;
             coverage = compute_coveragef(pMin, pMax, pMid, ix, iy);
-         }
-         
+
+            if (coverage <= 0.0F || count == MAX_SPAN_WIDTH) {
+               /* end of the run, or span arrays are full: draw fragments */
+               const GLint left = ix + 1;
+               const GLuint skip = MAX_SPAN_WIDTH - count;
 #if defined(DO_ATTRIBS)
-         /* compute attributes at left-most fragment */
-         span.attrStart[FRAG_ATTRIB_WPOS][3] = solve_plane(ix + 1.5, iy + 0.5, wPlane);
-         ATTRIB_LOOP_BEGIN
-            GLuint c;
-            for (c = 0; c < 4; c++) {
-               span.attrStart[attr][c] = solve_plane(ix + 1.5, iy + 0.5, attrPlane[attr][c]);
-            }
-         ATTRIB_LOOP_END
+               /* compute attributes at left-most fragment */
+               span.attrStart[FRAG_ATTRIB_WPOS][3] = solve_plane(left + 0.5, iy + 0.5, wPlane);
+               ATTRIB_LOOP_BEGIN
+                  GLuint c;
+                  for (c = 0; c < 4; c++) {
+                     span.attrStart[attr][c] = solve_plane(left + 0.5, iy + 0.5, attrPlane[attr][c]);
+                  }
+               ATTRIB_LOOP_END
 #endif
-
-         if (startX <= ix)
-            continue;
-
-         n = (GLuint) startX - (GLuint) ix;
-
-         left = ix + 1;
-
-         /* shift all values to the left */
-         /* XXX this is temporary */
-         {
-            SWspanarrays *array = span.array;
-            GLint j;
-            for (j = 0; j < (GLint) n; j++) {
-               array->coverage[j] = array->coverage[j + left];
+               /* shift all values to the left */
+               if (skip > 0) {
+                  GLuint k;
+                  for (k = 0; k < count; k++) {
+                     array->coverage[k] = array->coverage[k + skip];
 #ifdef DO_RGBA
-               COPY_CHAN4(array->rgba[j], array->rgba[j + left]);
+                     COPY_CHAN4(array->rgba[k], array->rgba[k + skip]);
 #endif
 #ifdef DO_INDEX
-               array->index[j] = array->index[j + left];
+                     array->index[k] = array->index[k + skip];
 #endif
 #ifdef DO_Z
-               array->z[j] = array->z[j + left];
+                     array->z[k] = array->z[k + skip];
 #endif
-            }
-         }
-
-         span.x = left;
-         span.y = iy;
-         span.end = n;
+                  }
+               }
+               span.x = left;
+               span.y = iy;
+               span.end = count;
 #if defined(DO_RGBA)
-         _swrast_write_rgba_span(ctx, &span);
+               _swrast_write_rgba_span(ctx, &span);
 #else
-         _swrast_write_index_span(ctx, &span);
+               _swrast_write_index_span(ctx, &span);
 #endif
+               count = 0;
+            }
+         }
       }
    }
 }
@@ -470,67 +470,74 @@ accum_return(GLcontext *ctx, GLfloat value,
       /* XXX maybe transpose the 'i' and 'buffer' loops??? */
       for (i = 0; i < height; i++) {
          GLshort accumRow[4 * MAX_WIDTH];
-         GLshort *acc;
-         SWspan span;
-
-         /* init color span */
-         INIT_SPAN(span, GL_BITMAP);
-         span.end = width;
-         span.arrayMask = SPAN_RGBA;
-         span.x = xpos;
-         span.y = ypos + i;
+         GLshort *accRow;
+         GLint skip;
 
          if (directAccess) {
-            acc = (GLshort *) accumRb->GetPointer(ctx, accumRb, xpos, ypos +i);
+            accRow = (GLshort *) accumRb->GetPointer(ctx, accumRb, xpos, ypos +i);
          }
          else {
             accumRb->GetRow(ctx, accumRb, width, xpos, ypos + i, accumRow);
-            acc = accumRow;
+            accRow = accumRow;
          }
 
-         /* get the colors to return */
-         if (swrast->_IntegerAccumMode) {
-            GLint j;
-            for (j = 0; j < width; j++) {
-               ASSERT(acc[j * 4 + 0] < max);
-               ASSERT(acc[j * 4 + 1] < max);
-               ASSERT(acc[j * 4 + 2] < max);
-               ASSERT(acc[j * 4 + 3] < max);
-               span.array->rgba[j][RCOMP] = multTable[acc[j * 4 + 0]];
-               span.array->rgba[j][GCOMP] = multTable[acc[j * 4 + 1]];
-               span.array->rgba[j][BCOMP] = multTable[acc[j * 4 + 2]];
-               span.array->rgba[j][ACOMP] = multTable[acc[j * 4 + 3]];
+         /* rows wider than MAX_SPAN_WIDTH are done in pieces */
+         for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+            const GLshort *acc = accRow + 4 * skip;
+            SWspan span;
+
+            /* init color span */
+            INIT_SPAN(span, GL_BITMAP);
+            span.end = MIN2(width - skip, MAX_SPAN_WIDTH);
+            span.arrayMask = SPAN_RGBA;
+            span.x = xpos + skip;
+            span.y = ypos + i;
+
+            /* get the colors to return */
+            if (swrast->_IntegerAccumMode) {
+               GLuint j;
+               for (j = 0; j < span.end; j++) {
+                  ASSERT(acc[j * 4 + 0] < max);
+                  ASSERT(acc[j * 4 + 1] < max);
+                  ASSERT(acc[j * 4 + 2] < max);
+                  ASSERT(acc[j * 4 + 3] < max);
+                  span.array->rgba[j][RCOMP] = multTable[acc[j * 4 + 0]];
+                  span.array->rgba[j][GCOMP] = multTable[acc[j * 4 + 1]];
+                  span.array->rgba[j][BCOMP] = multTable[acc[j * 4 + 2]];
+                  span.array->rgba[j][ACOMP] = multTable[acc[j * 4 + 3]];
+               }
             }
-         }
-         else {
-            /* scaled integer (or float) accum buffer */
-            GLint j;
-            for (j = 0; j < width; j++) {
+            else {
+               /* scaled integer (or float) accum buffer */
+               GLuint j;
+               for (j = 0; j < span.end; j++) {
 #if CHAN_BITS==32
-               GLchan r = acc[j * 4 + 0] * scale;
-               GLchan g = acc[j * 4 + 1] * scale;
-               GLchan b = acc[j * 4 + 2] * scale;
-               GLchan a = acc[j * 4 + 3] * scale;
+                  GLchan r = acc[j * 4 + 0] * scale;
+                  GLchan g = acc[j * 4 + 1] * scale;
+                  GLchan b = acc[j * 4 + 2] * scale;
+                  GLchan a = acc[j * 4 + 3] * scale;
 #else
-               GLint r = IROUND( (GLfloat) (acc[j * 4 + 0]) * scale );
-               GLint g = IROUND( (GLfloat) (acc[j * 4 + 1]) * scale );
-               GLint b = IROUND( (GLfloat) (acc[j * 4 + 2]) * scale );
-               GLint a = IROUND( (GLfloat) (acc[j * 4 + 3]) * scale );
+                  GLint r = IROUND( (GLfloat) (acc[j * 4 + 0]) * scale );
+                  GLint g = IROUND( (GLfloat) (acc[j * 4 + 1]) * scale );
+                  GLint b = IROUND( (GLfloat) (acc[j * 4 + 2]) * scale );
+                  GLint a = IROUND( (GLfloat) (acc[j * 4 + 3]) * scale );
 #endif
-               span.array->rgba[j][RCOMP] = CLAMP( r, 0, CHAN_MAX );
-               span.array->rgba[j][GCOMP] = CLAMP( g, 0, CHAN_MAX );
-               span.array->rgba[j][BCOMP] = CLAMP( b, 0, CHAN_MAX );
-               span.array->rgba[j][ACOMP] = CLAMP( a, 0, CHAN_MAX );
+                  span.array->rgba[j][RCOMP] = CLAMP( r, 0, CHAN_MAX );
+                  span.array->rgba[j][GCOMP] = CLAMP( g, 0, CHAN_MAX );
+                  span.array->rgba[j][BCOMP] = CLAMP( b, 0, CHAN_MAX );
+                  span.array->rgba[j][ACOMP] = CLAMP( a, 0, CHAN_MAX );
+               }
             }
-         }
 
-         /* store colors */
-         for (buffer = 0; buffer < fb->_NumColorDrawBuffers; buffer++) {
-            struct gl_renderbuffer *rb = fb->_ColorDrawBuffers[buffer];
-            if (masking) {
-               _swrast_mask_rgba_span(ctx, rb, &span);
+            /* store colors */
+            for (buffer = 0; buffer < fb->_NumColorDrawBuffers; buffer++) {
+               struct gl_renderbuffer *rb = fb->_ColorDrawBuffers[buffer];
+               if (masking) {
+                  _swrast_mask_rgba_span(ctx, rb, &span);
+               }
+               rb->PutRow(ctx, rb, span.end, span.x, span.y,
+                          span.array->rgba, NULL);
             }
-            rb->PutRow(ctx, rb, width, xpos, ypos + i, span.array->rgba, NULL);
          }
       }
    }
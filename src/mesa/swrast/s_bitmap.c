@@ -39,6 +39,21 @@
 
 
 
+/**
+ * Write the first 'count' fragments of the bitmap span.
+ */
+static void
+flush_bitmap_span(GLcontext *ctx, SWspan *span, GLuint count)
+{
+   span->end = count;
+   if (ctx->Visual.rgbMode)
+      _swrast_write_rgba_span(ctx, span);
+   else
+      _swrast_write_index_span(ctx, span);
+   span->end = 0;
+}
+
+
 /**
  * Render a bitmap.
  * Called via ctx->Driver.Bitmap()
@@ -82,7 +97,10 @@ _swrast_Bitmap( GLcontext *ctx, GLint px, GLint py,
             if (*src & mask) {
                span.array->x[count] = px + col;
                span.array->y[count] = py + row;
-               count++;
+               if (++count == MAX_SPAN_WIDTH) {
+                  flush_bitmap_span(ctx, &span, count);
+                  count = 0;
+               }
             }
             if (mask == 128U) {
                src++;
@@ -104,7 +122,10 @@ _swrast_Bitmap( GLcontext *ctx, GLint px, GLint py,
             if (*src & mask) {
                span.array->x[count] = px + col;
                span.array->y[count] = py + row;
-               count++;
+               if (++count == MAX_SPAN_WIDTH) {
+                  flush_bitmap_span(ctx, &span, count);
+                  count = 0;
+               }
             }
             if (mask == 1U) {
                src++;
@@ -120,16 +141,11 @@ _swrast_Bitmap( GLcontext *ctx, GLint px, GLint py,
             src++;
       }
 
-      if (count + width >= MAX_WIDTH || row + 1 == height) {
-         /* flush the span */
-         span.end = count;
-         if (ctx->Visual.rgbMode)
-            _swrast_write_rgba_span(ctx, &span);
-         else
-            _swrast_write_index_span(ctx, &span);
-         span.end = 0;
-         count = 0;
-      }
+   }
+
+   if (count > 0) {
+      /* flush the span */
+      flush_bitmap_span(ctx, &span, count);
    }
 
    RENDER_FINISH(swrast,ctx);
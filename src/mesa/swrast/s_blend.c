@@ -54,15 +54,6 @@
 #endif
 
 
-/**
- * Integer divide by 255
- * Declare "int divtemp" before using.
- * This satisfies Glean and should be reasonably fast.
- * Contributed by Nathan Hand.
- */
-#define DIV255(X)  (divtemp = (X), ((divtemp << 8) + divtemp + 256) >> 16)
-
-
 
 /**
  * Special case for glBlendFunc(GL_ZERO, GL_ONE).
@@ -819,7 +810,7 @@ static void
 blend_general(GLcontext *ctx, GLuint n, const GLubyte mask[],
               void *src, const void *dst, GLenum chanType)
 {
-   GLfloat rgbaF[MAX_WIDTH][4], destF[MAX_WIDTH][4];
+   GLfloat rgbaF[MAX_SPAN_WIDTH][4], destF[MAX_SPAN_WIDTH][4];
 
    if (chanType == GL_UNSIGNED_BYTE) {
       GLubyte (*rgba)[4] = (GLubyte (*)[4]) src;
@@ -990,7 +981,7 @@ _swrast_blend_span(GLcontext *ctx, struct gl_renderbuffer *rb, SWspan *span)
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    void *rbPixels;
 
-   ASSERT(span->end <= MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
    ASSERT(span->arrayMask & SPAN_RGBA);
    ASSERT(rb->DataType == span->array->ChanType);
    ASSERT(!ctx->Color._LogicOpEnabled);
@@ -30,6 +30,15 @@
 #include "s_context.h"
 
 
+/**
+ * Integer divide by 255
+ * Declare "int divtemp" before using.
+ * This satisfies Glean and should be reasonably fast.
+ * Contributed by Nathan Hand.
+ */
+#define DIV255(X)  (divtemp = (X), ((divtemp << 8) + divtemp + 256) >> 16)
+
+
 extern void
 _swrast_blend_span(GLcontext *ctx, struct gl_renderbuffer *rb, SWspan *span);
 
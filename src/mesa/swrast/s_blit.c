@@ -26,6 +26,7 @@
 #include "main/glheader.h"
 #include "main/macros.h"
 #include "s_context.h"
+#include "s_hiz.h"
 
 
 #define ABS(X)   ((X) < 0 ? -(X) : (X))
@@ -789,5 +790,8 @@ _swrast_BlitFramebuffer(GLcontext *ctx,
       }
    }
 
+   if (mask & GL_DEPTH_BUFFER_BIT)
+      _swrast_hiz_invalidate(ctx->DrawBuffer->_DepthBuffer);
+
    RENDER_FINISH(swrast, ctx);
 }
@@ -47,8 +47,9 @@ clear_rgba_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
    const GLint y = ctx->DrawBuffer->_Ymin;
    const GLint height = ctx->DrawBuffer->_Ymax - ctx->DrawBuffer->_Ymin;
    const GLint width  = ctx->DrawBuffer->_Xmax - ctx->DrawBuffer->_Xmin;
+   const GLint spanWidth = MIN2(width, MAX_SPAN_WIDTH);
    SWspan span;
-   GLint i;
+   GLint i, skip;
 
    ASSERT(ctx->Visual.rgbMode);
    ASSERT(rb->PutRow);
@@ -56,7 +57,7 @@ clear_rgba_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
    /* Initialize color span with clear color */
    /* XXX optimize for clearcolor == black/zero (bzero) */
    INIT_SPAN(span, GL_BITMAP);
-   span.end = width;
+   span.end = spanWidth;
    span.arrayMask = SPAN_RGBA;
    span.array->ChanType = rb->DataType;
    if (span.array->ChanType == GL_UNSIGNED_BYTE) {
@@ -65,7 +66,7 @@ clear_rgba_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
       UNCLAMPED_FLOAT_TO_UBYTE(clearColor[GCOMP], ctx->Color.ClearColor[1]);
       UNCLAMPED_FLOAT_TO_UBYTE(clearColor[BCOMP], ctx->Color.ClearColor[2]);
       UNCLAMPED_FLOAT_TO_UBYTE(clearColor[ACOMP], ctx->Color.ClearColor[3]);
-      for (i = 0; i < width; i++) {
+      for (i = 0; i < spanWidth; i++) {
          COPY_4UBV(span.array->rgba[i], clearColor);
       }
    }
@@ -75,13 +76,13 @@ clear_rgba_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
       UNCLAMPED_FLOAT_TO_USHORT(clearColor[GCOMP], ctx->Color.ClearColor[1]);
       UNCLAMPED_FLOAT_TO_USHORT(clearColor[BCOMP], ctx->Color.ClearColor[2]);
       UNCLAMPED_FLOAT_TO_USHORT(clearColor[ACOMP], ctx->Color.ClearColor[3]);
-      for (i = 0; i < width; i++) {
+      for (i = 0; i < spanWidth; i++) {
          COPY_4V(span.array->rgba[i], clearColor);
       }
    }
    else {
       ASSERT(span.array->ChanType == GL_FLOAT);
-      for (i = 0; i < width; i++) {
+      for (i = 0; i < spanWidth; i++) {
          CLAMPED_FLOAT_TO_CHAN(span.array->rgba[i][0], ctx->Color.ClearColor[0]);
          CLAMPED_FLOAT_TO_CHAN(span.array->rgba[i][1], ctx->Color.ClearColor[1]);
          CLAMPED_FLOAT_TO_CHAN(span.array->rgba[i][2], ctx->Color.ClearColor[2]);
@@ -92,13 +93,18 @@ clear_rgba_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
    /* Note that masking will change the color values, but only the
     * channels for which the write mask is GL_FALSE.  The channels
     * which which are write-enabled won't get modified.
+    * Rows wider than MAX_SPAN_WIDTH are done in pieces.
     */
    for (i = 0; i < height; i++) {
-      span.x = x;
-      span.y = y + i;
-      _swrast_mask_rgba_span(ctx, rb, &span);
-      /* write masked row */
-      rb->PutRow(ctx, rb, width, x, y + i, span.array->rgba, NULL);
+      for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+         span.x = x + skip;
+         span.y = y + i;
+         span.end = MIN2(width - skip, MAX_SPAN_WIDTH);
+         _swrast_mask_rgba_span(ctx, rb, &span);
+         /* write masked row */
+         rb->PutRow(ctx, rb, span.end, span.x, span.y,
+                    span.array->rgba, NULL);
+      }
    }
 }
 
@@ -113,8 +119,9 @@ clear_ci_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
    const GLint y = ctx->DrawBuffer->_Ymin;
    const GLint height = ctx->DrawBuffer->_Ymax - ctx->DrawBuffer->_Ymin;
    const GLint width  = ctx->DrawBuffer->_Xmax - ctx->DrawBuffer->_Xmin;
+   const GLint spanWidth = MIN2(width, MAX_SPAN_WIDTH);
    SWspan span;
-   GLint i;
+   GLint i, skip;
 
    ASSERT(!ctx->Visual.rgbMode);
    ASSERT(rb->PutRow);
@@ -122,9 +129,9 @@ clear_ci_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
 
    /* Initialize index span with clear index */
    INIT_SPAN(span, GL_BITMAP);
-   span.end = width;
+   span.end = spanWidth;
    span.arrayMask = SPAN_INDEX;
-   for (i = 0; i < width;i++) {
+   for (i = 0; i < spanWidth; i++) {
       span.array->index[i] = ctx->Color.ClearIndex;
    }
 
@@ -132,12 +139,16 @@ clear_ci_buffer_with_masking(GLcontext *ctx, struct gl_renderbuffer *rb)
     * bits for which the write mask is GL_FALSE.  The bits
     * which are write-enabled won't get modified.
     */
-   for (i = 0; i < height;i++) {
-      span.x = x;
-      span.y = y + i;
-      _swrast_mask_ci_span(ctx, rb, &span);
-      /* write masked row */
-      rb->PutRow(ctx, rb, width, x, y + i, span.array->index, NULL);
+   for (i = 0; i < height; i++) {
+      for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+         span.x = x + skip;
+         span.y = y + i;
+         span.end = MIN2(width - skip, MAX_SPAN_WIDTH);
+         _swrast_mask_ci_span(ctx, rb, &span);
+         /* write masked row */
+         rb->PutRow(ctx, rb, span.end, span.x, span.y,
+                    span.array->index, NULL);
+      }
    }
 }
 
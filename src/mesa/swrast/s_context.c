@@ -31,17 +31,21 @@
 #include "main/context.h"
 #include "main/colormac.h"
 #include "main/mtypes.h"
+#include "main/profile.h"
 #include "main/teximage.h"
 #include "shader/prog_parameter.h"
 #include "shader/prog_statevars.h"
 #include "swrast.h"
 #include "s_blend.h"
 #include "s_context.h"
+#include "s_fpcompile.h"
+#include "s_hiz.h"
 #include "s_lines.h"
 #include "s_points.h"
 #include "s_span.h"
 #include "s_triangle.h"
 #include "s_texfilter.h"
+#include "s_tile.h"
 
 
 /**
@@ -323,9 +327,30 @@ _swrast_validate_triangle( GLcontext *ctx,
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
    _swrast_validate_derived( ctx );
+   swrast->_TriangleName = "driver triangle";  /* unless swrast's is used */
    swrast->choose_triangle( ctx );
    ASSERT(swrast->Triangle);
 
+   if (swrast->AllowGuardBand && !(swrast->_RasterMask & CLIP_BIT)) {
+      /* See which function would be used if the window had to be
+       * clipped, for triangles crossing the window edges.
+       */
+      const swrast_tri_func tri = swrast->Triangle;
+      const char *name = swrast->_TriangleName;
+      swrast->_RasterMask |= CLIP_BIT;
+      swrast->choose_triangle( ctx );
+      swrast->_RasterMask &= ~CLIP_BIT;
+      if (swrast->Triangle != tri) {
+         swrast->ClipTriangle = swrast->Triangle;
+         swrast->UnclippedTriangle = tri;
+         swrast->Triangle = _swrast_guard_band_triangle;
+      }
+      else {
+         swrast->Triangle = tri;
+      }
+      swrast->_TriangleName = name;
+   }
+
    if (ctx->Texture._EnabledUnits == 0
        && NEED_SECONDARY_COLOR(ctx)
        && !ctx->FragmentProgram._Current) {
@@ -334,6 +359,18 @@ _swrast_validate_triangle( GLcontext *ctx,
       swrast->Triangle = _swrast_add_spec_terms_triangle;
    }
 
+   if (_swrast_use_tiler(ctx)) {
+      /* queue triangles for the rendering threads */
+      if (swrast->Triangle == _swrast_add_spec_terms_triangle) {
+         swrast->TileTriangle = swrast->SpecTriangle;
+         swrast->SpecTriangle = _swrast_tile_triangle;
+      }
+      else {
+         swrast->TileTriangle = swrast->Triangle;
+         swrast->Triangle = _swrast_tile_triangle;
+      }
+   }
+
    swrast->Triangle( ctx, v0, v1, v2 );
 }
 
@@ -653,6 +690,12 @@ _swrast_validate_derived( GLcontext *ctx )
                               _NEW_TEXTURE))
          _swrast_update_active_attribs(ctx);
 
+      _swrast_update_compiled_fp(ctx);
+
+      _swrast_choose_span_writer(ctx);
+
+      _swrast_update_hiz(ctx);
+
       swrast->NewState = 0;
       swrast->StateChanges = 0;
       swrast->InvalidateState = _swrast_invalidate_state;
@@ -661,6 +704,35 @@ _swrast_validate_derived( GLcontext *ctx )
 
 #define SWRAST_DEBUG 0
 
+
+/**
+ * Call swrast->Triangle, and charge the time to the chosen triangle
+ * function when profiling.  When the tiler is in use, this only measures
+ * the binning; the rendering threads profile the triangle function.
+ */
+static INLINE void
+draw_triangle( GLcontext *ctx, const SWvertex *v0,
+               const SWvertex *v1, const SWvertex *v2 )
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (ctx->Profile) {
+      const GLuint64EXT t = _mesa_profile_clock();
+      const char *name;
+      swrast->Triangle( ctx, v0, v1, v2 );
+      if (swrast->Triangle == _swrast_tile_triangle ||
+          (swrast->Triangle == _swrast_add_spec_terms_triangle &&
+           swrast->SpecTriangle == _swrast_tile_triangle))
+         name = "swrast triangle binning";
+      else
+         name = swrast->_TriangleName;
+      _mesa_profile_lap(ctx->Profile, name, t);
+   }
+   else {
+      swrast->Triangle( ctx, v0, v1, v2 );
+   }
+}
+
 /* Public entrypoints:  See also s_accum.c, s_bitmap.c, etc.
  */
 void
@@ -675,8 +747,8 @@ _swrast_Quad( GLcontext *ctx,
       _swrast_print_vertex( ctx, v2 );
       _swrast_print_vertex( ctx, v3 );
    }
-   SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v3 );
-   SWRAST_CONTEXT(ctx)->Triangle( ctx, v1, v2, v3 );
+   draw_triangle( ctx, v0, v1, v3 );
+   draw_triangle( ctx, v1, v2, v3 );
 }
 
 void
@@ -689,7 +761,7 @@ _swrast_Triangle( GLcontext *ctx, const SWvertex *v0,
       _swrast_print_vertex( ctx, v1 );
       _swrast_print_vertex( ctx, v2 );
    }
-   SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v2 );
+   draw_triangle( ctx, v0, v1, v2 );
 }
 
 void
@@ -700,6 +772,7 @@ _swrast_Line( GLcontext *ctx, const SWvertex *v0, const SWvertex *v1 )
       _swrast_print_vertex( ctx, v0 );
       _swrast_print_vertex( ctx, v1 );
    }
+   _swrast_flush_tiles( ctx );
    SWRAST_CONTEXT(ctx)->Line( ctx, v0, v1 );
 }
 
@@ -710,6 +783,7 @@ _swrast_Point( GLcontext *ctx, const SWvertex *v0 )
       _mesa_debug(ctx, "_swrast_Point\n");
       _swrast_print_vertex( ctx, v0 );
    }
+   _swrast_flush_tiles( ctx );
    SWRAST_CONTEXT(ctx)->Point( ctx, v0 );
 }
 
@@ -757,6 +831,42 @@ _swrast_allow_pixel_fog( GLcontext *ctx, GLboolean value )
    SWRAST_CONTEXT(ctx)->AllowPixelFog = value;
 }
 
+/**
+ * Tell swrast that polygons may extend past the window, so that their
+ * spans must always be clipped.  See _tnl_allow_guard_band().
+ */
+void
+_swrast_allow_guard_band( GLcontext *ctx, GLboolean value )
+{
+   if (SWRAST_DEBUG) {
+      _mesa_debug(ctx, "_swrast_allow_guard_band %d\n", value);
+   }
+   SWRAST_CONTEXT(ctx)->InvalidateState( ctx, _NEW_POLYGON );
+   SWRAST_CONTEXT(ctx)->AllowGuardBand = value;
+}
+
+
+/**
+ * Allocate the span arrays used by the triangle/line/point functions.
+ */
+SWspanarrays *
+_swrast_new_span_arrays(void)
+{
+   SWspanarrays *arrays = MALLOC_STRUCT(sw_span_arrays);
+   if (!arrays)
+      return NULL;
+
+   arrays->ChanType = CHAN_TYPE;
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+   arrays->rgba = arrays->rgba8;
+#elif CHAN_TYPE == GL_UNSIGNED_SHORT
+   arrays->rgba = arrays->rgba16;
+#else
+   arrays->rgba = arrays->attribs[FRAG_ATTRIB_COL0];
+#endif
+   return arrays;
+}
+
 
 GLboolean
 _swrast_CreateContext( GLcontext *ctx )
@@ -797,19 +907,11 @@ _swrast_CreateContext( GLcontext *ctx )
    for (i = 0; i < MAX_TEXTURE_IMAGE_UNITS; i++)
       swrast->TextureSample[i] = NULL;
 
-   swrast->SpanArrays = MALLOC_STRUCT(sw_span_arrays);
+   swrast->SpanArrays = _swrast_new_span_arrays();
    if (!swrast->SpanArrays) {
       FREE(swrast);
       return GL_FALSE;
    }
-   swrast->SpanArrays->ChanType = CHAN_TYPE;
-#if CHAN_TYPE == GL_UNSIGNED_BYTE
-   swrast->SpanArrays->rgba = swrast->SpanArrays->rgba8;
-#elif CHAN_TYPE == GL_UNSIGNED_SHORT
-   swrast->SpanArrays->rgba = swrast->SpanArrays->rgba16;
-#else
-   swrast->SpanArrays->rgba = swrast->SpanArrays->attribs[FRAG_ATTRIB_COL0];
-#endif
 
    /* init point span buffer */
    swrast->PointSpan.primitive = GL_POINT;
@@ -818,15 +920,22 @@ _swrast_CreateContext( GLcontext *ctx )
    swrast->PointSpan.array = swrast->SpanArrays;
 
    swrast->TexelBuffer = (GLchan *) MALLOC(ctx->Const.MaxTextureImageUnits *
-                                           MAX_WIDTH * 4 * sizeof(GLchan));
+                                           MAX_SPAN_WIDTH * 4 * sizeof(GLchan));
    if (!swrast->TexelBuffer) {
       FREE(swrast->SpanArrays);
       FREE(swrast);
       return GL_FALSE;
    }
 
+   swrast->UseSpanWriters = !_mesa_getenv("MESA_NO_FAST_SPANS");
+   swrast->UseHiZ = !_mesa_getenv("MESA_NO_HIZ");
+   swrast->UseHalfSpace = _mesa_getenv("MESA_SWRAST_HALFSPACE") != NULL;
+
    ctx->swrast_context = swrast;
 
+   _swrast_create_tiler(ctx);
+   _swrast_create_fp_cache(ctx);
+
    return GL_TRUE;
 }
 
@@ -839,6 +948,9 @@ _swrast_DestroyContext( GLcontext *ctx )
       _mesa_debug(ctx, "_swrast_DestroyContext\n");
    }
 
+   _swrast_destroy_tiler( ctx );
+   _swrast_destroy_fp_cache( ctx );
+
    FREE( swrast->SpanArrays );
    if (swrast->ZoomedArrays)
       FREE( swrast->ZoomedArrays );
@@ -860,6 +972,8 @@ void
 _swrast_flush( GLcontext *ctx )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   /* draw any binned triangles */
+   _swrast_flush_tiles(ctx);
    /* flush any pending fragments from rendering points */
    if (swrast->PointSpan.end > 0) {
       if (ctx->Visual.rgbMode) {
@@ -896,6 +1010,10 @@ void
 _swrast_render_finish( GLcontext *ctx )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   /* binned triangles must be drawn before the driver finishes up */
+   _swrast_flush_tiles(ctx);
+
    if (swrast->Driver.SpanRenderFinish)
       swrast->Driver.SpanRenderFinish( ctx );
 
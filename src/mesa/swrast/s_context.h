@@ -67,6 +67,8 @@ typedef void (*swrast_line_func)( GLcontext *ctx,
 typedef void (*swrast_tri_func)( GLcontext *ctx, const SWvertex *,
                                  const SWvertex *, const SWvertex *);
 
+typedef GLboolean (*swrast_span_writer_func)(GLcontext *ctx, SWspan *span);
+
 
 typedef void (*validate_texture_image_func)(GLcontext *ctx,
                                             struct gl_texture_object *texObj,
@@ -108,6 +110,23 @@ typedef void (*validate_texture_image_func)(GLcontext *ctx,
 			        _NEW_DEPTH)
 
 
+/**
+ * \struct SWthread
+ * \brief  Rasterization scratch state owned by one rendering thread.
+ *
+ * While the tiled renderer (s_tile.c) runs, these are used instead of
+ * the SWcontext fields of the same names.
+ */
+typedef struct
+{
+   SWspanarrays *SpanArrays;
+   GLchan *TexelBuffer;
+   struct gl_program_machine FragProgMachine;
+   GLint TileYmin, TileYmax;   /**< scanlines to draw, [TileYmin, TileYmax) */
+   struct gl_profile *Profile; /**< merged into ctx->Profile, or NULL */
+} SWthread;
+
+
 /**
  * \struct SWcontext
  * \brief  Per-context state that's private to the software rasterizer module.
@@ -123,6 +142,7 @@ typedef struct
     */
    GLboolean AllowVertexFog;
    GLboolean AllowPixelFog;
+   GLboolean AllowGuardBand;  /**< polygons may extend past the window */
 
    /** Derived values, invalidated on statechanges, updated from
     * _swrast_validate_derived():
@@ -189,6 +209,9 @@ typedef struct
    swrast_tri_func Triangle;
    /*@}*/
 
+   /** Name of the chosen triangle function, for the profiler */
+   const char *_TriangleName;
+
    /**
     * Placeholders for when separate specular (or secondary color) is
     * enabled but texturing is not.
@@ -199,6 +222,16 @@ typedef struct
    swrast_tri_func SpecTriangle;
    /*@}*/
 
+   /**
+    * Triangle functions for triangles which cross the window edges and
+    * for the others, when the guard band is allowed but the chosen
+    * triangle function doesn't clip (see _swrast_guard_band_triangle()).
+    */
+   /*@{*/
+   swrast_tri_func ClipTriangle;
+   swrast_tri_func UnclippedTriangle;
+   /*@}*/
+
    /**
     * Typically, we'll allocate a sw_span structure as a local variable
     * and set its 'array' pointer to point to this object.  The reason is
@@ -228,6 +261,49 @@ typedef struct
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
 
+   /**
+    * Fragment programs translated for span-at-a-time execution
+    * (see s_fpcompile.c).  FragProgCache is NULL if disabled.
+    */
+   /*@{*/
+   struct swrast_fp_cache *FragProgCache;
+   struct fp_code *_FragProgCode;  /**< for FragmentProgram._Current */
+   /*@}*/
+
+   /**
+    * Span writer specialized for the current per-fragment state, used by
+    * _swrast_write_rgba_span() (see _swrast_choose_span_writer()).
+    * NULL if the generic path must be taken.
+    */
+   /*@{*/
+   GLboolean UseSpanWriters;   /**< FALSE if MESA_NO_FAST_SPANS is set */
+   swrast_span_writer_func _SpanWriter;
+   /*@}*/
+
+   /**
+    * Coarse depth culling of triangle spans (see s_hiz.c).
+    */
+   /*@{*/
+   GLboolean UseHiZ;    /**< FALSE if MESA_NO_HIZ is set */
+   GLenum _HiZFunc;     /**< depth func to cull spans with, or GL_NONE */
+   /*@}*/
+
+   /**
+    * Draw RGBA triangles with the half-space rasterizer (s_halfspace.c)
+    * instead of the scanline ones.  Set if MESA_SWRAST_HALFSPACE is set.
+    */
+   GLboolean UseHalfSpace;
+
+   /**
+    * Binned, multithreaded triangle rendering (see s_tile.c).
+    * Tiler is NULL unless enabled with MESA_SWRAST_THREADS.
+    */
+   /*@{*/
+   struct swrast_tiler *Tiler;
+   swrast_tri_func TileTriangle;  /**< draws the binned triangles */
+   GLboolean _TileActive;         /**< set while the bins are drawn */
+   /*@}*/
+
 } SWcontext;
 
 
@@ -237,9 +313,37 @@ _swrast_validate_derived( GLcontext *ctx );
 extern void
 _swrast_update_texture_samplers(GLcontext *ctx);
 
+extern SWspanarrays *
+_swrast_new_span_arrays(void);
+
+extern SWthread *
+_swrast_tile_thread(void);
+
 
 #define SWRAST_CONTEXT(ctx) ((SWcontext *)ctx->swrast_context)
 
+/**
+ * Span arrays, texel buffer, fragment program machine and profile to use
+ * in the calling thread.
+ */
+/*@{*/
+#define SWRAST_SPAN_ARRAYS(SWctx)				\
+   ((SWctx)->_TileActive ? _swrast_tile_thread()->SpanArrays	\
+                         : (SWctx)->SpanArrays)
+
+#define SWRAST_TEXEL_BUFFER(SWctx)				\
+   ((SWctx)->_TileActive ? _swrast_tile_thread()->TexelBuffer	\
+                         : (SWctx)->TexelBuffer)
+
+#define SWRAST_FRAGPROG_MACHINE(SWctx)				\
+   ((SWctx)->_TileActive ? &_swrast_tile_thread()->FragProgMachine \
+                         : &(SWctx)->FragProgMachine)
+
+#define SWRAST_PROFILE(SWctx, GLctx)				\
+   ((GLctx)->Profile && (SWctx)->_TileActive			\
+    ? _swrast_tile_thread()->Profile : (GLctx)->Profile)
+/*@}*/
+
 #define RENDER_START(SWctx, GLctx)			\
    do {							\
       if ((SWctx)->Driver.SpanRenderStart) {		\
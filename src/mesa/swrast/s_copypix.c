@@ -35,6 +35,7 @@
 
 #include "s_context.h"
 #include "s_depth.h"
+#include "s_hiz.h"
 #include "s_span.h"
 #include "s_stencil.h"
 #include "s_zoom.h"
@@ -164,22 +165,27 @@ copy_conv_rgba_pixels(GLcontext *ctx, GLint srcx, GLint srcy,
    if (!sink) {
       /* write the new image */
       for (row = 0; row < height; row++) {
-         const GLfloat *src = convImage + row * width * 4;
          GLfloat *rgba = (GLfloat *) span.array->attribs[FRAG_ATTRIB_COL0];
-
-         /* copy convolved colors into span array */
-         _mesa_memcpy(rgba, src, width * 4 * sizeof(GLfloat));
-
-         /* write span */
-         span.x = destx;
-         span.y = desty + row;
-         span.end = width;
-         span.array->ChanType = GL_FLOAT;
-         if (zoom) {
-            _swrast_write_zoomed_rgba_span(ctx, destx, desty, &span, rgba);
-         }
-         else {
-            _swrast_write_rgba_span(ctx, &span);
+         GLint skip;
+
+         for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+            const GLint n = MIN2(width - skip, MAX_SPAN_WIDTH);
+            const GLfloat *src = convImage + (row * width + skip) * 4;
+
+            /* copy convolved colors into span array */
+            _mesa_memcpy(rgba, src, n * 4 * sizeof(GLfloat));
+
+            /* write span */
+            span.x = destx + skip;
+            span.y = desty + row;
+            span.end = n;
+            span.array->ChanType = GL_FLOAT;
+            if (zoom) {
+               _swrast_write_zoomed_rgba_span(ctx, destx, desty, &span, rgba);
+            }
+            else {
+               _swrast_write_rgba_span(ctx, &span);
+            }
          }
       }
       /* restore this */
@@ -266,39 +272,45 @@ copy_rgba_pixels(GLcontext *ctx, GLint srcx, GLint srcy,
       p = NULL;
    }
 
-   ASSERT(width < MAX_WIDTH);
-
    for (row = 0; row < height; row++, sy += stepy, dy += stepy) {
       GLvoid *rgba = span.array->attribs[FRAG_ATTRIB_COL0];
+      GLint skip;
 
-      /* Get row/span of source pixels */
-      if (overlapping) {
-         /* get from buffered image */
-         _mesa_memcpy(rgba, p, width * sizeof(GLfloat) * 4);
-         p += width * 4;
-      }
-      else {
-         /* get from framebuffer */
-         _swrast_read_rgba_span( ctx, ctx->ReadBuffer->_ColorReadBuffer,
-                                 width, srcx, sy, GL_FLOAT, rgba );
-      }
+      /* rows wider than MAX_SPAN_WIDTH are copied in pieces */
+      for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+         const GLint n = MIN2(width - skip, MAX_SPAN_WIDTH);
 
-      if (transferOps) {
-         _mesa_apply_rgba_transfer_ops(ctx, transferOps, width,
-                                       (GLfloat (*)[4]) rgba);
-      }
+         /* Get row/span of source pixels */
+         if (overlapping) {
+            /* get from buffered image */
+            _mesa_memcpy(rgba, p + skip * 4, n * sizeof(GLfloat) * 4);
+         }
+         else {
+            /* get from framebuffer */
+            _swrast_read_rgba_span( ctx, ctx->ReadBuffer->_ColorReadBuffer,
+                                    n, srcx + skip, sy, GL_FLOAT, rgba );
+         }
 
-      /* Write color span */
-      span.x = destx;
-      span.y = dy;
-      span.end = width;
-      span.array->ChanType = GL_FLOAT;
-      if (zoom) {
-         _swrast_write_zoomed_rgba_span(ctx, destx, desty, &span, rgba);
-      }
-      else {
-         _swrast_write_rgba_span(ctx, &span);
+         if (transferOps) {
+            _mesa_apply_rgba_transfer_ops(ctx, transferOps, n,
+                                          (GLfloat (*)[4]) rgba);
+         }
+
+         /* Write color span */
+         span.x = destx + skip;
+         span.y = dy;
+         span.end = n;
+         span.array->ChanType = GL_FLOAT;
+         if (zoom) {
+            _swrast_write_zoomed_rgba_span(ctx, destx, desty, &span, rgba);
+         }
+         else {
+            _swrast_write_rgba_span(ctx, &span);
+         }
       }
+
+      if (overlapping)
+         p += width * 4;
    }
 
    span.array->ChanType = CHAN_TYPE; /* restore */
@@ -373,28 +385,37 @@ copy_ci_pixels( GLcontext *ctx, GLint srcx, GLint srcy,
    }
 
    for (j = 0; j < height; j++, sy += stepy, dy += stepy) {
-      /* Get color indexes */
-      if (overlapping) {
-         _mesa_memcpy(span.array->index, p, width * sizeof(GLuint));
-         p += width;
-      }
-      else {
-         _swrast_read_index_span( ctx, ctx->ReadBuffer->_ColorReadBuffer,
-                                  width, srcx, sy, span.array->index );
-      }
+      GLint skip;
 
-      if (ctx->_ImageTransferState)
-         _mesa_apply_ci_transfer_ops(ctx, ctx->_ImageTransferState,
-                                     width, span.array->index);
+      /* rows wider than MAX_SPAN_WIDTH are copied in pieces */
+      for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+         const GLint n = MIN2(width - skip, MAX_SPAN_WIDTH);
 
-      /* write color indexes */
-      span.x = destx;
-      span.y = dy;
-      span.end = width;
-      if (zoom)
-         _swrast_write_zoomed_index_span(ctx, destx, desty, &span);
-      else
-         _swrast_write_index_span(ctx, &span);
+         /* Get color indexes */
+         if (overlapping) {
+            _mesa_memcpy(span.array->index, p + skip, n * sizeof(GLuint));
+         }
+         else {
+            _swrast_read_index_span( ctx, ctx->ReadBuffer->_ColorReadBuffer,
+                                     n, srcx + skip, sy, span.array->index );
+         }
+
+         if (ctx->_ImageTransferState)
+            _mesa_apply_ci_transfer_ops(ctx, ctx->_ImageTransferState,
+                                        n, span.array->index);
+
+         /* write color indexes */
+         span.x = destx + skip;
+         span.y = dy;
+         span.end = n;
+         if (zoom)
+            _swrast_write_zoomed_index_span(ctx, destx, desty, &span);
+         else
+            _swrast_write_index_span(ctx, &span);
+      }
+
+      if (overlapping)
+         p += width;
    }
 
    if (overlapping)
@@ -507,6 +528,8 @@ copy_depth_pixels( GLcontext *ctx, GLint srcx, GLint srcy,
 
    for (j = 0; j < height; j++, sy += stepy, dy += stepy) {
       GLfloat depth[MAX_WIDTH];
+      GLint skip;
+
       /* get depth values */
       if (overlapping) {
          _mesa_memcpy(depth, p, width * sizeof(GLfloat));
@@ -516,24 +539,29 @@ copy_depth_pixels( GLcontext *ctx, GLint srcx, GLint srcy,
          _swrast_read_depth_span_float(ctx, readRb, width, srcx, sy, depth);
       }
 
-      /* apply scale and bias */
-      scale_and_bias_z(ctx, width, depth, span.array->z);
+      /* rows wider than MAX_SPAN_WIDTH are written in pieces */
+      for (skip = 0; skip < width; skip += MAX_SPAN_WIDTH) {
+         const GLint n = MIN2(width - skip, MAX_SPAN_WIDTH);
 
-      /* write depth values */
-      span.x = destx;
-      span.y = dy;
-      span.end = width;
-      if (fb->Visual.rgbMode) {
-         if (zoom)
-            _swrast_write_zoomed_depth_span(ctx, destx, desty, &span);
-         else
-            _swrast_write_rgba_span(ctx, &span);
-      }
-      else {
-         if (zoom)
-            _swrast_write_zoomed_depth_span(ctx, destx, desty, &span);
-         else
-            _swrast_write_index_span(ctx, &span);
+         /* apply scale and bias */
+         scale_and_bias_z(ctx, n, depth + skip, span.array->z);
+
+         /* write depth values */
+         span.x = destx + skip;
+         span.y = dy;
+         span.end = n;
+         if (fb->Visual.rgbMode) {
+            if (zoom)
+               _swrast_write_zoomed_depth_span(ctx, destx, desty, &span);
+            else
+               _swrast_write_rgba_span(ctx, &span);
+         }
+         else {
+            if (zoom)
+               _swrast_write_zoomed_depth_span(ctx, destx, desty, &span);
+            else
+               _swrast_write_index_span(ctx, &span);
+         }
       }
    }
 
@@ -885,6 +913,9 @@ fast_copy_pixels(GLcontext *ctx,
       dstY += yStep;
    }
 
+   if (type == GL_DEPTH)
+      _swrast_hiz_invalidate(dstRb);
+
    return GL_TRUE;
 }
 
@@ -31,6 +31,7 @@
 
 #include "s_depth.h"
 #include "s_context.h"
+#include "s_hiz.h"
 #include "s_span.h"
 
 
@@ -532,13 +533,13 @@ depth_test_span( GLcontext *ctx, SWspan *span)
    else {
       /* read depth values from buffer, test, write back */
       if (rb->DataType == GL_UNSIGNED_SHORT) {
-         GLushort zbuffer[MAX_WIDTH];
+         GLushort zbuffer[MAX_SPAN_WIDTH];
          rb->GetRow(ctx, rb, count, x, y, zbuffer);
          passed = depth_test_span16(ctx, count, zbuffer, zValues, mask);
          rb->PutRow(ctx, rb, count, x, y, zbuffer, mask);
       }
       else {
-         GLuint zbuffer[MAX_WIDTH];
+         GLuint zbuffer[MAX_SPAN_WIDTH];
          ASSERT(rb->DataType == GL_UNSIGNED_INT);
          rb->GetRow(ctx, rb, count, x, y, zbuffer);
          passed = depth_test_span32(ctx, count, zbuffer, zValues, mask);
@@ -546,6 +547,10 @@ depth_test_span( GLcontext *ctx, SWspan *span)
       }
    }
 
+   if (passed && ctx->Depth.Mask && rb->DepthTiles) {
+      _swrast_hiz_values_written(rb, x, y, count, zValues, mask);
+   }
+
    if (passed < count) {
       span->writeAll = GL_FALSE;
    }
@@ -1078,13 +1083,13 @@ depth_test_pixels( GLcontext *ctx, SWspan *span )
    else {
       /* read depth values from buffer, test, write back */
       if (rb->DataType == GL_UNSIGNED_SHORT) {
-         GLushort zbuffer[MAX_WIDTH];
+         GLushort zbuffer[MAX_SPAN_WIDTH];
          _swrast_get_values(ctx, rb, count, x, y, zbuffer, sizeof(GLushort));
          depth_test_span16(ctx, count, zbuffer, z, mask);
          rb->PutValues(ctx, rb, count, x, y, zbuffer, mask);
       }
       else {
-         GLuint zbuffer[MAX_WIDTH];
+         GLuint zbuffer[MAX_SPAN_WIDTH];
          ASSERT(rb->DataType == GL_UNSIGNED_INT);
          _swrast_get_values(ctx, rb, count, x, y, zbuffer, sizeof(GLuint));
          depth_test_span32(ctx, count, zbuffer, z, mask);
@@ -1092,6 +1097,10 @@ depth_test_pixels( GLcontext *ctx, SWspan *span )
       }
    }
 
+   if (ctx->Depth.Mask && rb->DepthTiles) {
+      _swrast_hiz_pixels_written(rb, count, x, y, z, mask);
+   }
+
    return count; /* not really correct, but OK */
 }
 
@@ -1131,7 +1140,7 @@ _swrast_depth_bounds_test( GLcontext *ctx, SWspan *span )
 
    if (rb->DataType == GL_UNSIGNED_SHORT) {
       /* get 16-bit values */
-      GLushort zbuffer16[MAX_WIDTH], *zbuffer;
+      GLushort zbuffer16[MAX_SPAN_WIDTH], *zbuffer;
       if (span->arrayMask & SPAN_XY) {
          _swrast_get_values(ctx, rb, count, span->array->x, span->array->y,
                             zbuffer16, sizeof(GLushort));
@@ -1158,7 +1167,7 @@ _swrast_depth_bounds_test( GLcontext *ctx, SWspan *span )
    }
    else {
       /* get 32-bit values */
-      GLuint zbuffer32[MAX_WIDTH], *zbuffer;
+      GLuint zbuffer32[MAX_SPAN_WIDTH], *zbuffer;
       ASSERT(rb->DataType == GL_UNSIGNED_INT);
       if (span->arrayMask & SPAN_XY) {
          _swrast_get_values(ctx, rb, count, span->array->x, span->array->y,
@@ -1426,4 +1435,8 @@ _swrast_clear_depth_buffer( GLcontext *ctx, struct gl_renderbuffer *rb )
          _mesa_problem(ctx, "bad depth renderbuffer DataType");
       }
    }
+
+   if (rb->DepthTiles) {
+      _swrast_hiz_clear(rb, x, y, width, height, clearValue);
+   }
 }
@@ -34,6 +34,7 @@
 #include "main/state.h"
 
 #include "s_context.h"
+#include "s_hiz.h"
 #include "s_span.h"
 #include "s_stencil.h"
 #include "s_zoom.h"
@@ -54,6 +55,7 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
    const GLint imgX = x, imgY = y;
    struct gl_renderbuffer *rb = ctx->DrawBuffer->_ColorDrawBuffers[0];
    GLenum rbType;
+   GLboolean ubyteRGBA;
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    SWspan span;
    GLboolean simpleZoom;
@@ -66,9 +68,13 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
 
    rbType = rb->DataType;
 
+   /* BGRA, packed and byte swapped 8-bit images are converted directly */
+   ubyteRGBA = rbType == GL_UNSIGNED_BYTE &&
+               _mesa_can_convert_rgba_ubyte(format, type);
+
    if ((swrast->_RasterMask & ~CLIP_BIT) ||
        ctx->Texture._EnabledCoordUnits ||
-       userUnpack->SwapBytes ||
+       (userUnpack->SwapBytes && !ubyteRGBA) ||
        ctx->_ImageTransferState) {
       /* can't handle any of those conditions */
       return GL_FALSE;
@@ -171,6 +177,37 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
       return GL_TRUE;
    }
 
+   if (ubyteRGBA) {
+      const GLubyte *src
+         = (const GLubyte *) _mesa_image_address2d(&unpack, pixels, width,
+                                                   height, format, type, 0, 0);
+      const GLint srcStride = _mesa_image_row_stride(&unpack, width,
+                                                     format, type);
+      GLint row;
+      ASSERT(drawWidth <= MAX_WIDTH);
+      for (row = 0; row < drawHeight; row++) {
+         GLubyte rgba8[MAX_WIDTH][4];
+         _mesa_unpack_rgba_span_ubyte(drawWidth, rgba8, format, type, src,
+                                      &unpack);
+         if (simpleZoom) {
+            rb->PutRow(ctx, rb, drawWidth, destX, destY, rgba8, NULL);
+            destY += yStep;
+         }
+         else {
+            /* with zooming */
+            span.x = destX;
+            span.y = destY;
+            span.end = drawWidth;
+            span.array->ChanType = GL_UNSIGNED_BYTE;
+            _swrast_write_zoomed_rgba_span(ctx, imgX, imgY, &span, rgba8);
+            destY++;
+         }
+         src += srcStride;
+      }
+      span.array->ChanType = CHAN_TYPE;
+      return GL_TRUE;
+   }
+
    /* Remaining cases haven't been tested with alignment != 1 */
    if (userUnpack->Alignment != 1)
       return GL_FALSE;
@@ -225,16 +262,16 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
          GLint row;
          ASSERT(drawWidth <= MAX_WIDTH);
          for (row = 0; row < drawHeight; row++) {
+            GLchan rgba[MAX_WIDTH][4];
             GLint i;
             const GLchan *ptr = src;
             for (i = 0;i<drawWidth;i++) {
-               span.array->rgba[i][0] = *ptr;
-               span.array->rgba[i][1] = *ptr;
-               span.array->rgba[i][2] = *ptr++;
-               span.array->rgba[i][3] = *ptr++;
+               rgba[i][0] = *ptr;
+               rgba[i][1] = *ptr;
+               rgba[i][2] = *ptr++;
+               rgba[i][3] = *ptr++;
             }
-            rb->PutRow(ctx, rb, drawWidth, destX, destY,
-                       span.array->rgba, NULL);
+            rb->PutRow(ctx, rb, drawWidth, destX, destY, rgba, NULL);
             src += unpack.RowLength*2;
             destY += yStep;
          }
@@ -244,19 +281,19 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
          GLint row;
          ASSERT(drawWidth <= MAX_WIDTH);
          for (row = 0; row < drawHeight; row++) {
+            GLchan rgba[MAX_WIDTH][4];
             const GLchan *ptr = src;
             GLint i;
             for (i = 0;i<drawWidth;i++) {
-               span.array->rgba[i][0] = *ptr;
-               span.array->rgba[i][1] = *ptr;
-               span.array->rgba[i][2] = *ptr++;
-               span.array->rgba[i][3] = *ptr++;
+               rgba[i][0] = *ptr;
+               rgba[i][1] = *ptr;
+               rgba[i][2] = *ptr++;
+               rgba[i][3] = *ptr++;
             }
             span.x = destX;
             span.y = destY;
             span.end = drawWidth;
-            _swrast_write_zoomed_rgba_span(ctx, imgX, imgY, &span,
-                                           span.array->rgba);
+            _swrast_write_zoomed_rgba_span(ctx, imgX, imgY, &span, rgba);
             src += unpack.RowLength*2;
             destY++;
          }
@@ -272,11 +309,10 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
          if (simpleZoom) {
             GLint row;
             for (row = 0; row < drawHeight; row++) {
+               GLubyte rgba8[MAX_WIDTH][4];
                ASSERT(drawWidth <= MAX_WIDTH);
-               _mesa_map_ci8_to_rgba8(ctx, drawWidth, src,
-                                      span.array->rgba8);
-               rb->PutRow(ctx, rb, drawWidth, destX, destY,
-                          span.array->rgba8, NULL);
+               _mesa_map_ci8_to_rgba8(ctx, drawWidth, src, rgba8);
+               rb->PutRow(ctx, rb, drawWidth, destX, destY, rgba8, NULL);
                src += unpack.RowLength;
                destY += yStep;
             }
@@ -285,14 +321,13 @@ fast_draw_rgba_pixels(GLcontext *ctx, GLint x, GLint y,
             /* ubyte/CI to ubyte/RGBA with zooming */
             GLint row;
             for (row = 0; row < drawHeight; row++) {
+               GLubyte rgba8[MAX_WIDTH][4];
                ASSERT(drawWidth <= MAX_WIDTH);
-               _mesa_map_ci8_to_rgba8(ctx, drawWidth, src,
-                                      span.array->rgba8);
+               _mesa_map_ci8_to_rgba8(ctx, drawWidth, src, rgba8);
                span.x = destX;
                span.y = destY;
                span.end = drawWidth;
-               _swrast_write_zoomed_rgba_span(ctx, imgX, imgY, &span,
-                                              span.array->rgba8);
+               _swrast_write_zoomed_rgba_span(ctx, imgX, imgY, &span, rgba8);
                src += unpack.RowLength;
                destY++;
             }
@@ -347,8 +382,8 @@ draw_index_pixels( GLcontext *ctx, GLint x, GLint y,
     */
    skipPixels = 0;
    while (skipPixels < width) {
-      const GLint spanWidth = MIN2(width - skipPixels, MAX_WIDTH);
-      ASSERT(spanWidth <= MAX_WIDTH);
+      const GLint spanWidth = MIN2(width - skipPixels, MAX_SPAN_WIDTH);
+      ASSERT(spanWidth <= MAX_SPAN_WIDTH);
       for (row = 0; row < height; row++) {
          const GLvoid *source = _mesa_image_address2d(unpack, pixels,
                                                       width, height,
@@ -442,7 +477,6 @@ draw_depth_pixels( GLcontext *ctx, GLint x, GLint y,
        && !scaleOrBias
        && !zoom
        && ctx->Visual.rgbMode
-       && width <= MAX_WIDTH
        && !unpack->SwapBytes) {
       /* Special case: directly write 16-bit depth values */
       GLint row;
@@ -450,20 +484,24 @@ draw_depth_pixels( GLcontext *ctx, GLint x, GLint y,
          const GLushort *zSrc = (const GLushort *)
             _mesa_image_address2d(unpack, pixels, width, height,
                                   GL_DEPTH_COMPONENT, type, row, 0);
-         GLint i;
-         for (i = 0; i < width; i++)
-            span.array->z[i] = zSrc[i];
-         span.x = x;
-         span.y = y + row;
-         span.end = width;
-         _swrast_write_rgba_span(ctx, &span);
+         GLint skipPixels;
+         for (skipPixels = 0; skipPixels < width;
+              skipPixels += MAX_SPAN_WIDTH) {
+            const GLint spanWidth = MIN2(width - skipPixels, MAX_SPAN_WIDTH);
+            GLint i;
+            for (i = 0; i < spanWidth; i++)
+               span.array->z[i] = zSrc[skipPixels + i];
+            span.x = x + skipPixels;
+            span.y = y + row;
+            span.end = spanWidth;
+            _swrast_write_rgba_span(ctx, &span);
+         }
       }
    }
    else if (type == GL_UNSIGNED_INT
             && !scaleOrBias
             && !zoom
             && ctx->Visual.rgbMode
-            && width <= MAX_WIDTH
             && !unpack->SwapBytes) {
       /* Special case: shift 32-bit values down to Visual.depthBits */
       const GLint shift = 32 - ctx->DrawBuffer->Visual.depthBits;
@@ -472,18 +510,24 @@ draw_depth_pixels( GLcontext *ctx, GLint x, GLint y,
          const GLuint *zSrc = (const GLuint *)
             _mesa_image_address2d(unpack, pixels, width, height,
                                   GL_DEPTH_COMPONENT, type, row, 0);
-         if (shift == 0) {
-            _mesa_memcpy(span.array->z, zSrc, width * sizeof(GLuint));
-         }
-         else {
-            GLint col;
-            for (col = 0; col < width; col++)
-               span.array->z[col] = zSrc[col] >> shift;
+         GLint skipPixels;
+         for (skipPixels = 0; skipPixels < width;
+              skipPixels += MAX_SPAN_WIDTH) {
+            const GLint spanWidth = MIN2(width - skipPixels, MAX_SPAN_WIDTH);
+            if (shift == 0) {
+               _mesa_memcpy(span.array->z, zSrc + skipPixels,
+                            spanWidth * sizeof(GLuint));
+            }
+            else {
+               GLint col;
+               for (col = 0; col < spanWidth; col++)
+                  span.array->z[col] = zSrc[skipPixels + col] >> shift;
+            }
+            span.x = x + skipPixels;
+            span.y = y + row;
+            span.end = spanWidth;
+            _swrast_write_rgba_span(ctx, &span);
          }
-         span.x = x;
-         span.y = y + row;
-         span.end = width;
-         _swrast_write_rgba_span(ctx, &span);
       }
    }
    else {
@@ -491,11 +535,11 @@ draw_depth_pixels( GLcontext *ctx, GLint x, GLint y,
       const GLuint depthMax = ctx->DrawBuffer->_DepthMax;
       GLint skipPixels = 0;
 
-      /* in case width > MAX_WIDTH do the copy in chunks */
+      /* in case width > MAX_SPAN_WIDTH do the copy in chunks */
       while (skipPixels < width) {
-         const GLint spanWidth = MIN2(width - skipPixels, MAX_WIDTH);
+         const GLint spanWidth = MIN2(width - skipPixels, MAX_SPAN_WIDTH);
          GLint row;
-         ASSERT(span.end <= MAX_WIDTH);
+         ASSERT(span.end <= MAX_SPAN_WIDTH);
          for (row = 0; row < height; row++) {
             const GLvoid *zSrc = _mesa_image_address2d(unpack,
                                                       pixels, width, height,
@@ -633,9 +677,9 @@ draw_rgba_pixels( GLcontext *ctx, GLint x, GLint y,
       /* use span array for temp color storage */
       GLfloat *rgba = (GLfloat *) span.array->attribs[FRAG_ATTRIB_COL0];
 
-      /* if the span is wider than MAX_WIDTH we have to do it in chunks */
+      /* if the span is wider than MAX_SPAN_WIDTH we have to do it in chunks */
       while (skipPixels < width) {
-         const GLint spanWidth = MIN2(width - skipPixels, MAX_WIDTH);
+         const GLint spanWidth = MIN2(width - skipPixels, MAX_SPAN_WIDTH);
          const GLubyte *source
             = (const GLubyte *) _mesa_image_address2d(unpack, pixels,
                                                       width, height, format,
@@ -813,6 +857,9 @@ draw_depth_stencil_pixels(GLcontext *ctx, GLint x, GLint y,
          }
       }
    }
+
+   if (ctx->Depth.Mask)
+      _swrast_hiz_invalidate(ctx->DrawBuffer->_DepthBuffer);
 }
 
 
@@ -0,0 +1,1376 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Span-at-a-time execution of fragment programs.
+ *
+ * The interpreter in shader/prog_execute.c runs a program one fragment
+ * at a time and decodes every instruction and operand for each fragment.
+ * Here a gl_fragment_program is translated once into a compact list of
+ * pre-decoded instructions whose registers live in structure-of-arrays
+ * form: each register component holds FP_LANES fragments.  Each
+ * instruction is then executed for a whole group of fragments with
+ * simple loops which the compiler can turn into SIMD code, and texture
+ * lookups are done for runs of fragments with a single TextureSample
+ * call.
+ *
+ * The translated programs are kept in a small cache keyed by program.
+ * Programs using features we don't handle (flow control, condition
+ * codes, relative addressing, packing, noise, etc) are left to the
+ * interpreter.  Setting MESA_NO_FP_COMPILE disables this path.
+ *
+ * The arithmetic matches the interpreter operation for operation so the
+ * results are the same either way.
+ */
+
+
+#include "main/glheader.h"
+#include "main/colormac.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "shader/prog_instruction.h"
+#include "shader/prog_parameter.h"
+
+#include "s_context.h"
+#include "s_fpcompile.h"
+#include "s_span.h"
+#include "s_texfilter.h"
+
+
+/** Number of fragments processed together */
+#define FP_LANES 32
+
+/** Max number of temporary and output registers in a translated program */
+#define FP_MAX_SLOTS 64
+
+/** Number of translated programs kept around */
+#define FP_CACHE_SIZE 16
+
+
+/** Kinds of instruction operands */
+enum fp_src_kind {
+   FP_SRC_REG,       /**< temporary or output register slot */
+   FP_SRC_INPUT,     /**< fragment attribute from the span */
+   FP_SRC_CONST      /**< program/env/local parameter */
+};
+
+
+struct fp_src {
+   enum fp_src_kind Kind;
+   GLuint Slot;                     /**< for FP_SRC_REG */
+   GLboolean Plain;                 /**< no negation or absolute value */
+   struct prog_src_register Reg;    /**< the original operand */
+};
+
+
+struct fp_inst {
+   gl_inst_opcode Opcode;
+   struct fp_src Src[3];
+   GLint DstSlot;                   /**< -1 if the result is discarded */
+   GLuint WriteMask;
+   GLboolean Saturate;
+   GLuint TexSrcUnit;
+   GLuint TexSrcTarget;
+   GLboolean TexDeriv;              /**< compute lambda from derivatives */
+};
+
+
+/**
+ * A translated fragment program.
+ */
+struct fp_code {
+   const struct gl_fragment_program *Program;
+   GLenum Target;
+   GLuint LastUse;
+
+   /** Copy of the source instructions, to detect redefinition */
+   struct prog_instruction *Source;
+   GLuint NumSource;
+
+   struct fp_inst *Inst;            /**< NULL if it couldn't be translated */
+   GLuint NumInst;
+
+   GLuint NumSlots;
+   GLuint NumOutputSlots;           /**< temporaries follow the outputs */
+   GLint OutputSlot[MAX_PROGRAM_OUTPUTS];
+};
+
+
+struct swrast_fp_cache {
+   struct fp_code *Entries[FP_CACHE_SIZE];
+   GLuint Clock;
+};
+
+
+/**
+ * Per-call execution state.
+ */
+struct fp_exec {
+   GLcontext *ctx;
+   const struct gl_fragment_program *program;
+   const SWspan *span;
+   GLuint base;                     /**< first fragment of current group */
+   GLuint n;                        /**< fragments in current group */
+   GLfloat (*regs)[4][FP_LANES];
+   GLubyte live[FP_LANES];          /**< not masked and not killed */
+};
+
+
+static const GLfloat ZeroVec[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+
+
+/**********************************************************************
+ * Translation
+ */
+
+static GLboolean
+supported_opcode(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_ABS:
+   case OPCODE_ADD:
+   case OPCODE_CMP:
+   case OPCODE_COS:
+   case OPCODE_DDX:
+   case OPCODE_DDY:
+   case OPCODE_DP2:
+   case OPCODE_DP3:
+   case OPCODE_DP4:
+   case OPCODE_DPH:
+   case OPCODE_DST:
+   case OPCODE_EX2:
+   case OPCODE_FLR:
+   case OPCODE_FRC:
+   case OPCODE_KIL:
+   case OPCODE_LG2:
+   case OPCODE_LIT:
+   case OPCODE_LRP:
+   case OPCODE_MAD:
+   case OPCODE_MAX:
+   case OPCODE_MIN:
+   case OPCODE_MOV:
+   case OPCODE_MUL:
+   case OPCODE_NRM3:
+   case OPCODE_NRM4:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SCS:
+   case OPCODE_SEQ:
+   case OPCODE_SFL:
+   case OPCODE_SGE:
+   case OPCODE_SGT:
+   case OPCODE_SIN:
+   case OPCODE_SLE:
+   case OPCODE_SLT:
+   case OPCODE_SNE:
+   case OPCODE_SSG:
+   case OPCODE_STR:
+   case OPCODE_SUB:
+   case OPCODE_SWZ:
+   case OPCODE_TEX:
+   case OPCODE_TXB:
+   case OPCODE_TXP:
+   case OPCODE_TXP_NV:
+   case OPCODE_TRUNC:
+   case OPCODE_XPD:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Do these opcodes only use the first component of their operands?
+ */
+static GLboolean
+scalar_opcode(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_COS:
+   case OPCODE_EX2:
+   case OPCODE_LG2:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SCS:
+   case OPCODE_SIN:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Allocate register slots for the output registers used by the program.
+ */
+static GLboolean
+alloc_output_slots(struct fp_code *code,
+                   const struct gl_fragment_program *program)
+{
+   GLbitfield outputs = program->Base.OutputsWritten;
+   GLuint pc, i;
+
+   for (pc = 0; pc < program->Base.NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Base.Instructions + pc;
+      if (inst->DstReg.File == PROGRAM_OUTPUT) {
+         if (inst->DstReg.Index >= MAX_PROGRAM_OUTPUTS)
+            return GL_FALSE;
+         outputs |= 1 << inst->DstReg.Index;
+      }
+      for (i = 0; i < 3; i++) {
+         if (inst->SrcReg[i].File == PROGRAM_OUTPUT) {
+            if (inst->SrcReg[i].Index >= MAX_PROGRAM_OUTPUTS)
+               return GL_FALSE;
+            outputs |= 1 << inst->SrcReg[i].Index;
+         }
+      }
+   }
+
+   for (i = 0; i < MAX_PROGRAM_OUTPUTS; i++) {
+      if (outputs & (1 << i))
+         code->OutputSlot[i] = code->NumSlots++;
+      else
+         code->OutputSlot[i] = -1;
+   }
+   code->NumOutputSlots = code->NumSlots;
+
+   return code->NumSlots <= FP_MAX_SLOTS;
+}
+
+
+/**
+ * Return the register slot for a temporary or output register.
+ * \return -1 if out of slots
+ */
+static GLint
+register_slot(struct fp_code *code, GLint tempSlot[], GLuint file, GLint index)
+{
+   if (file == PROGRAM_OUTPUT)
+      return code->OutputSlot[index];
+
+   ASSERT(file == PROGRAM_TEMPORARY);
+   if (tempSlot[index] < 0) {
+      if (code->NumSlots == FP_MAX_SLOTS)
+         return -1;
+      tempSlot[index] = code->NumSlots++;
+   }
+   return tempSlot[index];
+}
+
+
+static GLboolean
+translate_src(struct fp_code *code, GLint tempSlot[],
+              const struct prog_instruction *inst, GLuint i,
+              struct fp_src *src)
+{
+   const struct prog_src_register *reg = &inst->SrcReg[i];
+   const GLuint numComps = scalar_opcode(inst->Opcode) ? 1 : 4;
+   const GLuint maxSwz = inst->Opcode == OPCODE_SWZ ? SWIZZLE_ONE : SWIZZLE_W;
+   GLuint c;
+
+   if (reg->RelAddr)
+      return GL_FALSE;
+
+   for (c = 0; c < numComps; c++) {
+      if (GET_SWZ(reg->Swizzle, c) > maxSwz)
+         return GL_FALSE;
+   }
+
+   src->Reg = *reg;
+   src->Plain = !reg->NegateBase && !reg->Abs && !reg->NegateAbs;
+   src->Slot = 0;
+
+   switch (reg->File) {
+   case PROGRAM_TEMPORARY:
+   case PROGRAM_OUTPUT:
+      {
+         GLint slot;
+         if (reg->Index < 0 ||
+             reg->Index >= (reg->File == PROGRAM_TEMPORARY
+                            ? MAX_PROGRAM_TEMPS : MAX_PROGRAM_OUTPUTS))
+            return GL_FALSE;
+         slot = register_slot(code, tempSlot, reg->File, reg->Index);
+         if (slot < 0)
+            return GL_FALSE;
+         src->Kind = FP_SRC_REG;
+         src->Slot = slot;
+      }
+      return GL_TRUE;
+   case PROGRAM_INPUT:
+      if (reg->Index < 0 || reg->Index >= FRAG_ATTRIB_MAX)
+         return GL_FALSE;
+      src->Kind = FP_SRC_INPUT;
+      return GL_TRUE;
+   case PROGRAM_LOCAL_PARAM:
+   case PROGRAM_ENV_PARAM:
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+   case PROGRAM_NAMED_PARAM:
+      src->Kind = FP_SRC_CONST;
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Translate the program's instructions into code->Inst.
+ * \return GL_FALSE if the program has to be run by the interpreter
+ */
+static GLboolean
+translate_program(struct fp_code *code,
+                  const struct gl_fragment_program *program)
+{
+   GLint tempSlot[MAX_PROGRAM_TEMPS];
+   GLuint pc, i;
+
+   if (!alloc_output_slots(code, program))
+      return GL_FALSE;
+
+   for (i = 0; i < MAX_PROGRAM_TEMPS; i++)
+      tempSlot[i] = -1;
+
+   code->Inst = (struct fp_inst *)
+      _mesa_calloc(MAX2(program->Base.NumInstructions, 1)
+                   * sizeof(struct fp_inst));
+   if (!code->Inst)
+      return GL_FALSE;
+
+   for (pc = 0; pc < program->Base.NumInstructions; pc++) {
+      const struct prog_instruction *src = program->Base.Instructions + pc;
+      const struct prog_dst_register *dstReg = &src->DstReg;
+      struct fp_inst *inst = code->Inst + code->NumInst;
+
+      if (src->Opcode == OPCODE_END)
+         break;
+      if (src->Opcode == OPCODE_NOP)
+         continue;
+
+      if (!supported_opcode(src->Opcode) ||
+          src->CondUpdate ||
+          dstReg->CondMask != COND_TR ||
+          dstReg->RelAddr)
+         return GL_FALSE;
+
+      inst->Opcode = src->Opcode;
+      for (i = 0; i < _mesa_num_inst_src_regs(src->Opcode); i++) {
+         if (!translate_src(code, tempSlot, src, i, &inst->Src[i]))
+            return GL_FALSE;
+      }
+
+      inst->DstSlot = -1;
+      if (_mesa_num_inst_dst_regs(src->Opcode)) {
+         switch (dstReg->File) {
+         case PROGRAM_TEMPORARY:
+         case PROGRAM_OUTPUT:
+            if (dstReg->Index >= (dstReg->File == PROGRAM_TEMPORARY
+                                  ? MAX_PROGRAM_TEMPS : MAX_PROGRAM_OUTPUTS))
+               break;  /* written to a dummy register */
+            inst->DstSlot = register_slot(code, tempSlot,
+                                          dstReg->File, dstReg->Index);
+            if (inst->DstSlot < 0)
+               return GL_FALSE;
+            break;
+         case PROGRAM_WRITE_ONLY:
+            break;
+         default:
+            return GL_FALSE;
+         }
+      }
+      inst->WriteMask = dstReg->WriteMask;
+      inst->Saturate = src->SaturateMode == SATURATE_ZERO_ONE;
+
+      inst->TexSrcUnit = src->TexSrcUnit;
+      inst->TexSrcTarget = src->TexSrcTarget;
+      /* same test as fetch_texel() in the interpreter */
+      inst->TexDeriv = (src->SrcReg[0].File == PROGRAM_INPUT &&
+                        src->SrcReg[0].Index ==
+                        FRAG_ATTRIB_TEX0 + (GLint) src->TexSrcUnit);
+
+      code->NumInst++;
+   }
+
+   return GL_TRUE;
+}
+
+
+static void
+free_code(struct fp_code *code)
+{
+   if (code->Source)
+      _mesa_free(code->Source);
+   if (code->Inst)
+      _mesa_free(code->Inst);
+   _mesa_free(code);
+}
+
+
+/**
+ * Translate a program.  The result is cached even if the program can't
+ * be translated so we don't try again.
+ */
+static struct fp_code *
+compile_program(const struct gl_fragment_program *program)
+{
+   const GLuint numInst = program->Base.NumInstructions;
+   struct fp_code *code = CALLOC_STRUCT(fp_code);
+   if (!code)
+      return NULL;
+
+   code->Program = program;
+   code->Target = program->Base.Target;
+   code->NumSource = numInst;
+   code->Source = (struct prog_instruction *)
+      _mesa_malloc(MAX2(numInst, 1) * sizeof(struct prog_instruction));
+   if (!code->Source) {
+      free_code(code);
+      return NULL;
+   }
+   _mesa_memcpy(code->Source, program->Base.Instructions,
+                numInst * sizeof(struct prog_instruction));
+
+   if (!translate_program(code, program) && code->Inst) {
+      _mesa_free(code->Inst);
+      code->Inst = NULL;
+   }
+
+   return code;
+}
+
+
+/**
+ * Does the cached code still match the program?
+ */
+static GLboolean
+code_matches(const struct fp_code *code,
+             const struct gl_fragment_program *program)
+{
+   return code->Program == program &&
+          code->Target == program->Base.Target &&
+          code->NumSource == program->Base.NumInstructions &&
+          _mesa_memcmp(code->Source, program->Base.Instructions,
+                       code->NumSource * sizeof(struct prog_instruction)) == 0;
+}
+
+
+void
+_swrast_create_fp_cache(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   swrast->_FragProgCode = NULL;
+   if (_mesa_getenv("MESA_NO_FP_COMPILE"))
+      swrast->FragProgCache = NULL;
+   else
+      swrast->FragProgCache = CALLOC_STRUCT(swrast_fp_cache);
+}
+
+
+void
+_swrast_destroy_fp_cache(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_fp_cache *cache = swrast->FragProgCache;
+   GLuint i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < FP_CACHE_SIZE; i++) {
+      if (cache->Entries[i])
+         free_code(cache->Entries[i]);
+   }
+   _mesa_free(cache);
+   swrast->FragProgCache = NULL;
+   swrast->_FragProgCode = NULL;
+}
+
+
+/**
+ * Find or make the translated code for the current fragment program.
+ * Called from _swrast_validate_derived().
+ */
+void
+_swrast_update_compiled_fp(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_fp_cache *cache = swrast->FragProgCache;
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   struct fp_code *code;
+   GLuint i, victim = 0;
+
+   if (!cache || !program) {
+      swrast->_FragProgCode = NULL;
+      return;
+   }
+
+   /* The program object can only be redefined when _NEW_PROGRAM is set */
+   code = swrast->_FragProgCode;
+   if (code && code->Program == program &&
+       !(swrast->NewState & _NEW_PROGRAM))
+      return;
+
+   for (i = 0; i < FP_CACHE_SIZE; i++) {
+      code = cache->Entries[i];
+      if (!code) {
+         victim = i;
+         break;
+      }
+      if (code->Program == program) {
+         if (code_matches(code, program)) {
+            code->LastUse = ++cache->Clock;
+            swrast->_FragProgCode = code;
+            return;
+         }
+         /* redefined, replace it */
+         victim = i;
+         break;
+      }
+      if (code->LastUse < cache->Entries[victim]->LastUse)
+         victim = i;
+   }
+
+   if (cache->Entries[victim])
+      free_code(cache->Entries[victim]);
+
+   code = compile_program(program);
+   cache->Entries[victim] = code;
+   if (code)
+      code->LastUse = ++cache->Clock;
+   swrast->_FragProgCode = code;
+}
+
+
+/**********************************************************************
+ * Execution
+ */
+
+/**
+ * Return pointer to a program parameter.
+ * As in get_src_register_pointer().
+ */
+static const GLfloat *
+const_pointer(const struct fp_exec *ex, const struct prog_src_register *reg)
+{
+   const struct gl_program *prog = &ex->program->Base;
+   const GLint index = reg->Index;
+
+   switch (reg->File) {
+   case PROGRAM_LOCAL_PARAM:
+      if (index >= MAX_PROGRAM_LOCAL_PARAMS)
+         return ZeroVec;
+      return prog->LocalParams[index];
+   case PROGRAM_ENV_PARAM:
+      if (index >= MAX_PROGRAM_ENV_PARAMS)
+         return ZeroVec;
+      return ex->ctx->FragmentProgram.Parameters[index];
+   default:
+      if (index >= (GLint) prog->Parameters->NumParameters)
+         return ZeroVec;
+      return prog->Parameters->ParameterValues[index];
+   }
+}
+
+
+/**
+ * Apply the operand's negation and absolute value, in the same order as
+ * fetch_vector4() does.
+ */
+static INLINE GLfloat
+modify(const struct prog_src_register *reg, GLfloat x)
+{
+   if (reg->NegateBase)
+      x = -x;
+   if (reg->Abs)
+      x = FABSF(x);
+   if (reg->NegateAbs)
+      x = -x;
+   return x;
+}
+
+
+/**
+ * Get one (unswizzled, unmodified) component of an operand for all the
+ * fragments of the group.
+ * \param tmp  storage which may be used for the values
+ */
+static const GLfloat *
+fetch_component(const struct fp_exec *ex, const struct fp_src *src,
+                GLuint comp, GLfloat tmp[FP_LANES])
+{
+   const GLuint n = ex->n;
+   GLuint i;
+
+   switch (src->Kind) {
+   case FP_SRC_REG:
+      return ex->regs[src->Slot][comp];
+   case FP_SRC_INPUT:
+      {
+         const GLfloat (*attr)[4] =
+            (const GLfloat (*)[4]) ex->span->array->attribs[src->Reg.Index]
+            + ex->base;
+         for (i = 0; i < n; i++)
+            tmp[i] = attr[i][comp];
+      }
+      return tmp;
+   default:
+      {
+         const GLfloat value = const_pointer(ex, &src->Reg)[comp];
+         for (i = 0; i < n; i++)
+            tmp[i] = value;
+      }
+      return tmp;
+   }
+}
+
+
+/**
+ * Fetch the first numComps components of an operand, with swizzling,
+ * negation and absolute value applied.
+ */
+static void
+fetch_src(const struct fp_exec *ex, const struct fp_src *src,
+          GLuint numComps, GLfloat tmp[4][FP_LANES], const GLfloat *val[4])
+{
+   const GLuint n = ex->n;
+   GLuint c, i;
+
+   for (c = 0; c < numComps; c++) {
+      const GLfloat *p = fetch_component(ex, src,
+                                         GET_SWZ(src->Reg.Swizzle, c), tmp[c]);
+      if (src->Plain) {
+         val[c] = p;
+      }
+      else {
+         for (i = 0; i < n; i++)
+            tmp[c][i] = modify(&src->Reg, p[i]);
+         val[c] = tmp[c];
+      }
+   }
+}
+
+
+/**
+ * Write an instruction's result to its destination register.
+ * \param scalar  replicate component 0 to all components
+ */
+static void
+store_result(const struct fp_exec *ex, const struct fp_inst *inst,
+             GLfloat result[4][FP_LANES], GLboolean scalar)
+{
+   const GLuint n = ex->n;
+   GLuint c, i;
+
+   if (inst->DstSlot < 0)
+      return;
+
+   for (c = 0; c < 4; c++) {
+      if (inst->WriteMask & (1 << c)) {
+         const GLfloat *res = result[scalar ? 0 : c];
+         GLfloat *dst = ex->regs[inst->DstSlot][c];
+         if (inst->Saturate) {
+            for (i = 0; i < n; i++)
+               dst[i] = CLAMP(res[i], 0.0F, 1.0F);
+         }
+         else {
+            for (i = 0; i < n; i++)
+               dst[i] = res[i];
+         }
+      }
+   }
+}
+
+
+/**
+ * Texture lookup for the group.  Lambda is computed as in
+ * fetch_texel_lod() / fetch_texel_deriv() in s_fragprog.c.
+ */
+static void
+texture_lookup(struct fp_exec *ex, const struct fp_inst *inst,
+               GLfloat texcoord[FP_LANES][4], const GLfloat lodBias[FP_LANES],
+               GLfloat result[4][FP_LANES])
+{
+   GLcontext *ctx = ex->ctx;
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLuint unit = ex->program->Base.SamplerUnits[inst->TexSrcUnit];
+   const struct gl_texture_object *texObj = ctx->Texture.Unit[unit]._Current;
+   const GLuint n = ex->n;
+   GLfloat lambda[FP_LANES];
+   GLchan rgba[FP_LANES][4];
+   GLfloat minMagThresh = 0.0F;
+   GLboolean useRanges = GL_FALSE;
+   GLuint i, start;
+
+   if (texObj) {
+      if (inst->TexDeriv) {
+         const GLuint attr = inst->Src[0].Reg.Index;
+         const GLfloat *texdx = ex->span->attrStepX[attr];
+         const GLfloat *texdy = ex->span->attrStepY[attr];
+         const struct gl_texture_image *texImg
+            = texObj->Image[0][texObj->BaseLevel];
+         const GLfloat texW = (GLfloat) texImg->WidthScale;
+         const GLfloat texH = (GLfloat) texImg->HeightScale;
+         for (i = 0; i < n; i++) {
+            if (ex->live[i]) {
+               lambda[i] = _swrast_compute_lambda(texdx[0], texdy[0],
+                                                  texdx[1], texdy[1],
+                                                  texdx[3], texdy[2],
+                                                  texW, texH,
+                                                  texcoord[i][0],
+                                                  texcoord[i][1],
+                                                  texcoord[i][3],
+                                                  1.0F / texcoord[i][3])
+                  + lodBias[i];
+               lambda[i] = CLAMP(lambda[i], texObj->MinLod, texObj->MaxLod);
+            }
+         }
+      }
+      else {
+         for (i = 0; i < n; i++)
+            lambda[i] = CLAMP(lodBias[i], texObj->MinLod, texObj->MaxLod);
+      }
+
+      /* The samplers assume lambda is monotonic along the span when
+       * splitting it into minified and magnified parts (see
+       * compute_min_mag_ranges()).  Only hand them runs of fragments
+       * which are all minified or all magnified.
+       */
+      if (texObj->MinFilter != texObj->MagFilter) {
+         useRanges = GL_TRUE;
+         minMagThresh = _swrast_min_mag_threshold(texObj);
+      }
+   }
+   else {
+      for (i = 0; i < n; i++)
+         lambda[i] = lodBias[i];
+   }
+
+   /* sample each run of live fragments */
+   i = 0;
+   while (i < n) {
+      if (!ex->live[i]) {
+         i++;
+         continue;
+      }
+      start = i++;
+      if (useRanges) {
+         const GLboolean minified = lambda[start] > minMagThresh;
+         while (i < n && ex->live[i] && (lambda[i] > minMagThresh) == minified)
+            i++;
+      }
+      else {
+         while (i < n && ex->live[i])
+            i++;
+      }
+      swrast->TextureSample[unit](ctx, texObj, i - start,
+                                  (const GLfloat (*)[4]) (texcoord + start),
+                                  lambda + start, rgba + start);
+   }
+
+   for (i = 0; i < n; i++) {
+      result[0][i] = CHAN_TO_FLOAT(rgba[i][0]);
+      result[1][i] = CHAN_TO_FLOAT(rgba[i][1]);
+      result[2][i] = CHAN_TO_FLOAT(rgba[i][2]);
+      result[3][i] = CHAN_TO_FLOAT(rgba[i][3]);
+   }
+}
+
+
+/**
+ * Execute the translated instructions for the current group of fragments.
+ */
+static void
+execute_code(struct fp_exec *ex, const struct fp_code *code)
+{
+   GLcontext *ctx = ex->ctx;
+   const GLuint n = ex->n;
+   GLfloat ta[4][FP_LANES], tb[4][FP_LANES], tc[4][FP_LANES];
+   GLfloat result[4][FP_LANES];
+   const GLfloat *a[4], *b[4], *c[4];
+   GLuint pc, i, k;
+
+   for (pc = 0; pc < code->NumInst; pc++) {
+      const struct fp_inst *inst = code->Inst + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = FABSF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_ADD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] + b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_CMP:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] < 0.0F ? b[k][i] : c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_COS:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_cos(a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+         /* as in fetch_vector4_deriv() */
+         {
+            const struct prog_src_register *reg = &inst->Src[0].Reg;
+            if (reg->File == PROGRAM_INPUT) {
+               const GLfloat *d = (inst->Opcode == OPCODE_DDX)
+                  ? ex->span->attrStepX[reg->Index]
+                  : ex->span->attrStepY[reg->Index];
+               const GLfloat (*wpos)[4] = (const GLfloat (*)[4])
+                  ex->span->array->attribs[FRAG_ATTRIB_WPOS] + ex->base;
+               for (i = 0; i < n; i++) {
+                  const GLfloat invQ = 1.0f / wpos[i][3];
+                  GLfloat deriv[4];
+                  deriv[0] = d[0] * invQ;
+                  deriv[1] = d[1] * invQ;
+                  deriv[2] = d[2] * invQ;
+                  deriv[3] = d[3] * invQ;
+                  for (k = 0; k < 4; k++)
+                     result[k][i] = modify(reg, deriv[GET_SWZ(reg->Swizzle, k)]);
+               }
+            }
+            else {
+               for (k = 0; k < 4; k++)
+                  for (i = 0; i < n; i++)
+                     result[k][i] = 0.0F;
+            }
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_DP2:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DP3:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DP4:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DPH:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i] + b[3][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DST:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++) {
+            result[0][i] = 1.0F;
+            result[1][i] = a[1][i] * b[1][i];
+            result[2][i] = a[2][i];
+            result[3][i] = b[3][i];
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_EX2:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_pow(2.0, a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_FLR:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = FLOORF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_FRC:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] - FLOORF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_KIL:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            if (a[0][i] < 0.0F || a[1][i] < 0.0F ||
+                a[2][i] < 0.0F || a[3][i] < 0.0F)
+               ex->live[i] = GL_FALSE;
+         }
+         break;
+      case OPCODE_LG2:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) (log(a[0][i]) * 1.442695F);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_LIT:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            const GLfloat epsilon = 1.0F / 256.0F;
+            GLfloat x = MAX2(a[0][i], 0.0F);
+            GLfloat y = MAX2(a[1][i], 0.0F);
+            GLfloat w = CLAMP(a[3][i], -(128.0F - epsilon), (128.0F - epsilon));
+            result[0][i] = 1.0F;
+            result[1][i] = x;
+            if (x > 0.0F) {
+               if (y == 0.0 && w == 0.0)
+                  result[2][i] = 1.0;
+               else
+                  result[2][i] = EXPF(w * LOGF(y));
+            }
+            else {
+               result[2][i] = 0.0;
+            }
+            result[3][i] = 1.0F;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_LRP:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i] + (1.0F - a[k][i]) * c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MAD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i] + c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MAX:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = MAX2(a[k][i], b[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MIN:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = MIN2(a[k][i], b[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MOV:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MUL:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_NRM3:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            GLfloat tmp = a[0][i] * a[0][i] + a[1][i] * a[1][i]
+               + a[2][i] * a[2][i];
+            if (tmp != 0.0F)
+               tmp = INV_SQRTF(tmp);
+            result[0][i] = tmp * a[0][i];
+            result[1][i] = tmp * a[1][i];
+            result[2][i] = tmp * a[2][i];
+            result[3][i] = 0.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_NRM4:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            GLfloat tmp = a[0][i] * a[0][i] + a[1][i] * a[1][i]
+               + a[2][i] * a[2][i] + a[3][i] * a[3][i];
+            if (tmp != 0.0F)
+               tmp = INV_SQRTF(tmp);
+            result[0][i] = tmp * a[0][i];
+            result[1][i] = tmp * a[1][i];
+            result[2][i] = tmp * a[2][i];
+            result[3][i] = tmp * a[3][i];
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_POW:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         fetch_src(ex, &inst->Src[1], 1, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_pow(a[0][i], b[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_RCP:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = 1.0F / a[0][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_RSQ:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = INV_SQRTF(FABSF(a[0][i]));
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SCS:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++) {
+            result[0][i] = (GLfloat) _mesa_cos(a[0][i]);
+            result[1][i] = (GLfloat) _mesa_sin(a[0][i]);
+            result[2][i] = 0.0;
+            result[3][i] = 0.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SEQ:
+      case OPCODE_SGE:
+      case OPCODE_SGT:
+      case OPCODE_SLE:
+      case OPCODE_SLT:
+      case OPCODE_SNE:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++) {
+            const GLfloat *x = a[k], *y = b[k];
+            GLfloat *r = result[k];
+            switch (inst->Opcode) {
+            case OPCODE_SEQ:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] == y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SGE:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] >= y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SGT:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] > y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SLE:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] <= y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SLT:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] < y[i]) ? 1.0F : 0.0F;
+               break;
+            default:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] != y[i]) ? 1.0F : 0.0F;
+               break;
+            }
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SFL:
+      case OPCODE_STR:
+         {
+            const GLfloat value = (inst->Opcode == OPCODE_STR) ? 1.0F : 0.0F;
+            for (i = 0; i < n; i++)
+               result[0][i] = value;
+         }
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SIN:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_sin(a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SSG:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = (GLfloat) ((a[k][i] > 0.0F) - (a[k][i] < 0.0F));
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SUB:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] - b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SWZ:
+         /* extended swizzle, per-component negation only */
+         {
+            const struct fp_src *src = &inst->Src[0];
+            for (k = 0; k < 4; k++) {
+               const GLuint swz = GET_SWZ(src->Reg.Swizzle, k);
+               const GLboolean neg = (src->Reg.NegateBase & (1 << k)) != 0;
+               if (swz == SWIZZLE_ZERO || swz == SWIZZLE_ONE) {
+                  GLfloat value = (swz == SWIZZLE_ONE) ? 1.0F : 0.0F;
+                  if (neg)
+                     value = -value;
+                  for (i = 0; i < n; i++)
+                     result[k][i] = value;
+               }
+               else {
+                  const GLfloat *p = fetch_component(ex, src, swz, ta[k]);
+                  for (i = 0; i < n; i++)
+                     result[k][i] = neg ? -p[i] : p[i];
+               }
+            }
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXP:
+      case OPCODE_TXP_NV:
+         {
+            GLfloat texcoord[FP_LANES][4], lodBias[FP_LANES];
+
+            fetch_src(ex, &inst->Src[0], 4, ta, a);
+            for (i = 0; i < n; i++) {
+               texcoord[i][0] = a[0][i];
+               texcoord[i][1] = a[1][i];
+               texcoord[i][2] = a[2][i];
+               texcoord[i][3] = a[3][i];
+               lodBias[i] = 0.0F;
+            }
+
+            if (inst->Opcode == OPCODE_TXB) {
+               const struct gl_texture_unit *texUnit
+                  = &ctx->Texture.Unit[inst->TexSrcUnit];
+               for (i = 0; i < n; i++) {
+                  lodBias[i] = texUnit->LodBias + texcoord[i][3];
+                  if (texUnit->_Current)
+                     lodBias[i] += texUnit->_Current->LodBias;
+               }
+            }
+            else if (inst->Opcode == OPCODE_TXP ||
+                     (inst->Opcode == OPCODE_TXP_NV &&
+                      inst->TexSrcTarget != TEXTURE_CUBE_INDEX)) {
+               for (i = 0; i < n; i++) {
+                  if (texcoord[i][3] != 0.0) {
+                     texcoord[i][0] /= texcoord[i][3];
+                     texcoord[i][1] /= texcoord[i][3];
+                     texcoord[i][2] /= texcoord[i][3];
+                  }
+               }
+            }
+
+            texture_lookup(ex, inst, texcoord, lodBias, result);
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_TRUNC:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = (GLfloat) (GLint) a[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_XPD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++) {
+            result[0][i] = a[1][i] * b[2][i] - a[2][i] * b[1][i];
+            result[1][i] = a[2][i] * b[0][i] - a[0][i] * b[2][i];
+            result[2][i] = a[0][i] * b[1][i] - a[1][i] * b[0][i];
+            result[3][i] = 1.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      default:
+         _mesa_problem(ctx, "Bad opcode %d in execute_code", inst->Opcode);
+         return;
+      }
+   }
+}
+
+
+/**
+ * Copy one output register to a span attribute for the live fragments.
+ */
+static void
+copy_output(const struct fp_exec *ex, const struct fp_code *code,
+            GLuint output, GLfloat (*dst)[4])
+{
+   const GLfloat (*reg)[FP_LANES] =
+      (const GLfloat (*)[FP_LANES]) ex->regs[code->OutputSlot[output]];
+   GLuint i;
+
+   ASSERT(code->OutputSlot[output] >= 0);
+
+   for (i = 0; i < ex->n; i++) {
+      if (ex->live[i]) {
+         dst[i][0] = reg[0][i];
+         dst[i][1] = reg[1][i];
+         dst[i][2] = reg[2][i];
+         dst[i][3] = reg[3][i];
+      }
+   }
+}
+
+
+/**
+ * Run the translated version of the current fragment program on all the
+ * fragments in the span.  Does the same things as run_program() in
+ * s_fragprog.c.
+ * \return GL_FALSE if the program has to be interpreted instead
+ */
+GLboolean
+_swrast_run_compiled_fp(GLcontext *ctx, SWspan *span)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   const struct fp_code *code = swrast->_FragProgCode;
+   const GLbitfield outputsWritten = program->Base.OutputsWritten;
+   GLfloat regs[FP_MAX_SLOTS][4][FP_LANES];
+   GLubyte *mask = span->array->mask;
+   struct fp_exec ex;
+   GLuint i;
+
+   if (!code || !code->Inst || code->Program != program)
+      return GL_FALSE;
+
+#if FEATURE_MESA_program_debug
+   if (ctx->FragmentProgram.CallbackEnabled)
+      return GL_FALSE;
+#endif
+
+   ex.ctx = ctx;
+   ex.program = program;
+   ex.span = span;
+   ex.regs = regs;
+
+   _mesa_bzero(regs, code->NumSlots * sizeof(regs[0]));
+
+   for (ex.base = 0; ex.base < span->end; ex.base += FP_LANES) {
+      GLuint numLive = 0;
+
+      ex.n = MIN2(FP_LANES, span->end - ex.base);
+      for (i = 0; i < ex.n; i++) {
+         ex.live[i] = mask[ex.base + i];
+         numLive += ex.live[i] != 0;
+      }
+      if (!numLive)
+         continue;
+
+      if (program->Base.Target == GL_FRAGMENT_PROGRAM_NV) {
+         /* Clear temporary registers (undefined for ARB_f_p) */
+         _mesa_bzero(regs[code->NumOutputSlots],
+                     (code->NumSlots - code->NumOutputSlots) * sizeof(regs[0]));
+      }
+
+      /* if running a GLSL program (not ARB_fragment_program) */
+      if (ctx->Shader.CurrentProgram) {
+         /* Store front/back facing value in register FOGC.Y */
+         GLfloat (*fogc)[4] = span->array->attribs[FRAG_ATTRIB_FOGC] + ex.base;
+         for (i = 0; i < ex.n; i++) {
+            if (ex.live[i])
+               fogc[i][1] = 1.0 - span->facing;
+         }
+      }
+
+      execute_code(&ex, code);
+
+      /* killed fragments */
+      for (i = 0; i < ex.n; i++) {
+         if (mask[ex.base + i] && !ex.live[i]) {
+            mask[ex.base + i] = GL_FALSE;
+            span->writeAll = GL_FALSE;
+         }
+      }
+
+      /* Store result color */
+      if (outputsWritten & (1 << FRAG_RESULT_COLR)) {
+         copy_output(&ex, code, FRAG_RESULT_COLR,
+                     span->array->attribs[FRAG_ATTRIB_COL0] + ex.base);
+      }
+      else {
+         /* Multiple drawbuffers / render targets */
+         GLuint buf;
+         for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
+            if (outputsWritten & (1 << (FRAG_RESULT_DATA0 + buf))) {
+               copy_output(&ex, code, FRAG_RESULT_DATA0 + buf,
+                     span->array->attribs[FRAG_ATTRIB_COL0 + buf] + ex.base);
+            }
+         }
+      }
+
+      /* Store result depth/z */
+      if (outputsWritten & (1 << FRAG_RESULT_DEPR)) {
+         const GLfloat *depth = regs[code->OutputSlot[FRAG_RESULT_DEPR]][2];
+         GLuint *z = span->array->z + ex.base;
+         for (i = 0; i < ex.n; i++) {
+            if (ex.live[i]) {
+               if (depth[i] <= 0.0)
+                  z[i] = 0;
+               else if (depth[i] >= 1.0)
+                  z[i] = ctx->DrawBuffer->_DepthMax;
+               else
+                  z[i] = IROUND(depth[i] * ctx->DrawBuffer->_DepthMaxF);
+            }
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
@@ -28,6 +28,7 @@
 #include "main/texstate.h"
 #include "shader/prog_instruction.h"
 
+#include "s_fpcompile.h"
 #include "s_fragprog.h"
 #include "s_span.h"
 
@@ -157,7 +158,7 @@ run_program(GLcontext *ctx, SWspan *span, GLuint start, GLuint end)
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
    const GLbitfield outputsWritten = program->Base.OutputsWritten;
-   struct gl_program_machine *machine = &swrast->FragProgMachine;
+   struct gl_program_machine *machine = SWRAST_FRAGPROG_MACHINE(swrast);
    GLuint i;
 
    for (i = start; i < end; i++) {
@@ -222,7 +223,8 @@ _swrast_exec_fragment_program( GLcontext *ctx, SWspan *span )
 
    ctx->_CurrentProgram = GL_FRAGMENT_PROGRAM_ARB; /* or NV, doesn't matter */
 
-   run_program(ctx, span, 0, span->end);
+   if (!_swrast_run_compiled_fp(ctx, span))
+      run_program(ctx, span, 0, span->end);
 
    if (program->Base.OutputsWritten & (1 << FRAG_RESULT_COLR)) {
       span->interpMask &= ~SPAN_RGBA;
@@ -0,0 +1,515 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Half-space (edge function) triangle rasterizer.
+ *
+ * s_tritemp.h walks the edges of a triangle from one scanline to the
+ * next.  This rasterizer instead visits the BLOCK_SIZE x BLOCK_SIZE
+ * screen blocks of the triangle's bounding box and tests each one against
+ * the triangle's three edge functions:  blocks outside of an edge are
+ * skipped, blocks inside of all edges are covered completely and only
+ * blocks which an edge passes through have their pixels tested.  Those
+ * tests don't depend on each other, so the compiler is free to do a row
+ * of them at a time with SIMD instructions.
+ *
+ * The vertices are snapped to 1/16 pixel as in s_tritemp.h and the edge
+ * functions are evaluated exactly, so triangles which share an edge never
+ * overlap or leave gaps.  Pixels whose centers are exactly on a left or
+ * bottom edge are inside the triangle, those on a right or top edge are
+ * not, which is the rule s_tritemp.h follows as well.
+ *
+ * A triangle covers a contiguous run of pixels in each scanline, so each
+ * row of blocks yields at most one span per scanline.  The span's
+ * attributes are computed from the triangle's plane equations and it is
+ * written with _swrast_write_rgba_span(), like general_triangle() does.
+ *
+ * Used instead of the scanline rasterizers for RGBA rendering when
+ * MESA_SWRAST_HALFSPACE is set at context creation.
+ */
+
+
+#include "main/glheader.h"
+#include "main/colormac.h"
+#include "main/imports.h"
+#include "main/macros.h"
+
+#include "s_context.h"
+#include "s_halfspace.h"
+#include "s_hiz.h"
+#include "s_span.h"
+
+
+/** Width and height of the screen blocks */
+#define BLOCK_SIZE 8
+
+#define SUB_PIXEL_SCALE (1 << SUB_PIXEL_BITS)
+
+
+/**
+ * An edge function E(x,y) = stepX * x + stepY * y + c of the pixel
+ * coordinates.  Pixels with E >= 0 are on the inner side of the edge.
+ * Vertex coordinates go up to MAX_WIDTH * SUB_PIXEL_SCALE so c needs
+ * more than 32 bits; a double holds it exactly.
+ */
+struct edge
+{
+   GLint stepX, stepY;
+   GLdouble c;
+   GLint blockMin, blockMax;  /**< range of E in a block, from its corner */
+};
+
+
+/**
+ * Triangle setup needed to compute the attributes of a span.
+ */
+struct tri_setup
+{
+   GLfloat e1x, e1y, e2x, e2y;  /**< v1 - v0 and v2 - v0 */
+   GLfloat oneOverArea;
+   GLfloat x0, y0;              /**< position of v0 in pixel coordinates */
+   GLfloat z0, w0;              /**< Z and 1/W of v0 */
+   GLfloat color0[4];           /**< color of v0 (or v2 if flat shaded) */
+   GLfloat attrib0[FRAG_ATTRIB_MAX][4];  /**< attribs of v0, times 1/W */
+};
+
+
+/**
+ * Set up the function of the edge going from vertex a to vertex b, with
+ * the triangle's interior on its left.  Coordinates are in sub-pixels
+ * and offset by half a pixel like in s_tritemp.h, which puts the center
+ * of pixel (x,y) at ((x + 1) * SUB_PIXEL_SCALE, y * SUB_PIXEL_SCALE).
+ */
+static void
+setup_edge(struct edge *e, GLint ax, GLint ay, GLint bx, GLint by)
+{
+   const GLint dx = bx - ax, dy = by - ay;
+   /* left edges point down and bottom edges point right */
+   const GLint bias = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+
+   e->stepX = -dy * SUB_PIXEL_SCALE;
+   e->stepY = dx * SUB_PIXEL_SCALE;
+   e->c = (GLdouble) dy * (ax - SUB_PIXEL_SCALE) - (GLdouble) dx * ay + bias;
+   e->blockMin = (BLOCK_SIZE - 1) * (MIN2(e->stepX, 0) + MIN2(e->stepY, 0));
+   e->blockMax = (BLOCK_SIZE - 1) * (MAX2(e->stepX, 0) + MAX2(e->stepY, 0));
+}
+
+
+/**
+ * Compute the X and Y derivatives of an attribute, given its values at
+ * the three vertices.
+ */
+static INLINE void
+compute_gradients(const struct tri_setup *tri,
+                  GLfloat a0, GLfloat a1, GLfloat a2,
+                  GLfloat *dadx, GLfloat *dady)
+{
+   const GLfloat da1 = a1 - a0, da2 = a2 - a0;
+   *dadx = tri->oneOverArea * (da1 * tri->e2y - da2 * tri->e1y);
+   *dady = tri->oneOverArea * (da2 * tri->e1x - da1 * tri->e2x);
+}
+
+
+/**
+ * Test the pixels of a block which edges pass through and widen the
+ * [left, right) ranges of covered pixels of the block's rows.
+ * \param e  edge function values at the block's first pixel
+ * \param stepX  edge function steps; zero for edges the block is inside of
+ * \return GL_TRUE if any pixel of the block is covered
+ */
+static GLboolean
+cover_block(const GLint e[3], const GLint stepX[3], const GLint stepY[3],
+            GLint bx, GLint left[BLOCK_SIZE], GLint right[BLOCK_SIZE])
+{
+   GLint e0 = e[0], e1 = e[1], e2 = e[2];
+   GLboolean covered = GL_FALSE;
+   GLint i, j;
+
+   for (j = 0; j < BLOCK_SIZE; j++) {
+      GLubyte inside[BLOCK_SIZE];
+      GLint first, last;
+
+      for (i = 0; i < BLOCK_SIZE; i++) {
+         inside[i] = ((e0 + i * stepX[0]) |
+                      (e1 + i * stepX[1]) |
+                      (e2 + i * stepX[2])) >= 0;
+      }
+
+      for (first = 0; first < BLOCK_SIZE && !inside[first]; first++)
+         ;
+      if (first < BLOCK_SIZE) {
+         for (last = BLOCK_SIZE - 1; !inside[last]; last--)
+            ;
+         left[j] = MIN2(left[j], bx + first);
+         right[j] = MAX2(right[j], bx + last + 1);
+         covered = GL_TRUE;
+      }
+
+      e0 += stepY[0];
+      e1 += stepY[1];
+      e2 += stepY[2];
+   }
+
+   return covered;
+}
+
+
+/**
+ * Compute a color channel at the start of a span, preventing negative
+ * interpolated colors like s_tritemp.h does.
+ */
+#define CHAN_START(CHANNEL, STEP, C)					\
+do {									\
+   const GLfloat v = tri->color0[C]					\
+                   + span->attrStepX[FRAG_ATTRIB_COL0][C] * dx		\
+                   + span->attrStepY[FRAG_ATTRIB_COL0][C] * dy;		\
+   GLfixed endVal;							\
+   span->CHANNEL = (GLfixed) (v * FIXED_SCALE) + FIXED_HALF;		\
+   endVal = span->CHANNEL + (n - 1) * span->STEP;			\
+   if (endVal < 0)							\
+      span->CHANNEL -= endVal;						\
+   if (span->CHANNEL < 0)						\
+      span->CHANNEL = 0;						\
+} while (0)
+
+
+/**
+ * Evaluate the plane equations at the start of a span and write it.
+ * The span's attribute derivatives were set up by the caller.
+ */
+static void
+render_span(GLcontext *ctx, SWspan *span, const struct tri_setup *tri,
+            GLint x, GLint y, GLint n)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLfloat dx = (GLfloat) x - tri->x0;
+   const GLfloat dy = (GLfloat) y - tri->y0;
+   GLfloat z, w;
+
+   span->x = x;
+   span->y = y;
+   span->end = n;
+
+   z = tri->z0 + span->attrStepX[FRAG_ATTRIB_WPOS][2] * dx
+               + span->attrStepY[FRAG_ATTRIB_WPOS][2] * dy;
+   if (ctx->DrawBuffer->Visual.depthBits <= 16) {
+      const GLfloat tmp = z * FIXED_SCALE + FIXED_HALF;
+      span->z = (tmp < MAX_GLUINT / 2) ? (GLfixed) tmp : MAX_GLUINT / 2;
+   }
+   else {
+      if (z <= 0.0F)
+         span->z = 0;
+      else if (z < 4294967296.0F)
+         span->z = (GLuint) z;
+      else
+         span->z = MAX_GLUINT;
+   }
+
+   if (swrast->_HiZFunc != GL_NONE && _swrast_hiz_cull_span(ctx, span))
+      return;
+
+   if (span->interpMask & SPAN_FLAT) {
+      span->red = ChanToFixed((GLchan) tri->color0[RCOMP]);
+      span->green = ChanToFixed((GLchan) tri->color0[GCOMP]);
+      span->blue = ChanToFixed((GLchan) tri->color0[BCOMP]);
+      span->alpha = ChanToFixed((GLchan) tri->color0[ACOMP]);
+   }
+   else {
+      CHAN_START(red, redStep, RCOMP);
+      CHAN_START(green, greenStep, GCOMP);
+      CHAN_START(blue, blueStep, BCOMP);
+      CHAN_START(alpha, alphaStep, ACOMP);
+   }
+
+   w = tri->w0 + span->attrStepX[FRAG_ATTRIB_WPOS][3] * dx
+               + span->attrStepY[FRAG_ATTRIB_WPOS][3] * dy;
+   span->attrStart[FRAG_ATTRIB_WPOS][3] = w;
+   ATTRIB_LOOP_BEGIN
+      if (attr != FRAG_ATTRIB_WPOS) {
+         GLuint c;
+         if (swrast->_InterpMode[attr] == GL_FLAT) {
+            for (c = 0; c < 4; c++)
+               span->attrStart[attr][c] = tri->attrib0[attr][c] * w;
+         }
+         else {
+            for (c = 0; c < 4; c++)
+               span->attrStart[attr][c] = tri->attrib0[attr][c]
+                  + span->attrStepX[attr][c] * dx
+                  + span->attrStepY[attr][c] * dy;
+         }
+      }
+   ATTRIB_LOOP_END
+
+   while (span->end > MAX_SPAN_WIDTH) {
+      SWspan rest = *span;
+      span->end = MAX_SPAN_WIDTH;
+      _swrast_write_rgba_span(ctx, span);
+      _swrast_span_advance(ctx, &rest, MAX_SPAN_WIDTH);
+      rest.end -= MAX_SPAN_WIDTH;
+      *span = rest;
+   }
+   _swrast_write_rgba_span(ctx, span);
+}
+
+
+/**
+ * Draw an RGBA triangle with arbitrary attributes.
+ */
+void
+_swrast_halfspace_triangle(GLcontext *ctx, const SWvertex *v0,
+                           const SWvertex *v1, const SWvertex *v2)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   const GLint snapMask = ~((FIXED_ONE / SUB_PIXEL_SCALE) - 1);
+   const GLint snapShift = FIXED_SHIFT - SUB_PIXEL_BITS;
+   const SWvertex *vert[3];
+   GLint vx[3], vy[3];
+   struct edge edge[3];
+   struct tri_setup tri;
+   GLdouble area;
+   GLint xmin, xmax, ymin, ymax, bx, by, k;
+   SWspan span;
+
+   INIT_SPAN(span, GL_POLYGON);
+
+   vert[0] = v0;
+   vert[1] = v1;
+   vert[2] = v2;
+   for (k = 0; k < 3; k++) {
+      const GLfloat *wpos = vert[k]->attrib[FRAG_ATTRIB_WPOS];
+      if (IS_INF_OR_NAN(wpos[0]) || IS_INF_OR_NAN(wpos[1]))
+         return;
+      vx[k] = (FloatToFixed(wpos[0] + 0.5F) & snapMask) >> snapShift;
+      vy[k] = (FloatToFixed(wpos[1] - 0.5F) & snapMask) >> snapShift;
+   }
+
+   /* twice the signed area, in sub-pixels; exact */
+   area = (GLdouble) (vx[1] - vx[0]) * (vy[2] - vy[0])
+        - (GLdouble) (vx[2] - vx[0]) * (vy[1] - vy[0]);
+   if (area == 0.0)
+      return;
+
+   /* s_tritemp.h's area has the opposite sign */
+   {
+      const GLfloat bf = swrast->_BackfaceSign;
+      if (area * bf * swrast->_BackfaceCullSign > 0.0)
+         return;
+      /* 0 = front, 1 = back */
+      span.facing = area * bf < 0.0;
+   }
+
+   /* orient the edges counter-clockwise */
+   if (area > 0.0) {
+      setup_edge(&edge[0], vx[0], vy[0], vx[1], vy[1]);
+      setup_edge(&edge[1], vx[1], vy[1], vx[2], vy[2]);
+      setup_edge(&edge[2], vx[2], vy[2], vx[0], vy[0]);
+   }
+   else {
+      setup_edge(&edge[0], vx[0], vy[0], vx[2], vy[2]);
+      setup_edge(&edge[1], vx[2], vy[2], vx[1], vy[1]);
+      setup_edge(&edge[2], vx[1], vy[1], vx[0], vy[0]);
+   }
+
+   /* pixels which may be covered, within the scissor box */
+   xmin = (MIN2(vx[0], MIN2(vx[1], vx[2])) >> SUB_PIXEL_BITS) - 1;
+   xmax = MAX2(vx[0], MAX2(vx[1], vx[2])) >> SUB_PIXEL_BITS;
+   ymin = MIN2(vy[0], MIN2(vy[1], vy[2])) >> SUB_PIXEL_BITS;
+   ymax = (MAX2(vy[0], MAX2(vy[1], vy[2])) >> SUB_PIXEL_BITS) + 1;
+   xmin = MAX2(xmin, fb->_Xmin);
+   xmax = MIN2(xmax, fb->_Xmax);
+   ymin = MAX2(ymin, fb->_Ymin);
+   ymax = MIN2(ymax, fb->_Ymax);
+   if (swrast->_TileActive) {
+      /* only draw this thread's screen band (see s_tile.c) */
+      const SWthread *thread = _swrast_tile_thread();
+      ymin = MAX2(ymin, thread->TileYmin);
+      ymax = MIN2(ymax, thread->TileYmax);
+   }
+   if (xmin >= xmax || ymin >= ymax)
+      return;
+
+   /* plane equations */
+   tri.e1x = (GLfloat) (vx[1] - vx[0]) * (1.0F / SUB_PIXEL_SCALE);
+   tri.e1y = (GLfloat) (vy[1] - vy[0]) * (1.0F / SUB_PIXEL_SCALE);
+   tri.e2x = (GLfloat) (vx[2] - vx[0]) * (1.0F / SUB_PIXEL_SCALE);
+   tri.e2y = (GLfloat) (vy[2] - vy[0]) * (1.0F / SUB_PIXEL_SCALE);
+   tri.oneOverArea = 1.0F / (tri.e1x * tri.e2y - tri.e2x * tri.e1y);
+   tri.x0 = (GLfloat) vx[0] * (1.0F / SUB_PIXEL_SCALE) - 1.0F;
+   tri.y0 = (GLfloat) vy[0] * (1.0F / SUB_PIXEL_SCALE);
+
+   span.interpMask |= SPAN_Z;
+   tri.z0 = v0->attrib[FRAG_ATTRIB_WPOS][2];
+   compute_gradients(&tri, tri.z0,
+                     v1->attrib[FRAG_ATTRIB_WPOS][2],
+                     v2->attrib[FRAG_ATTRIB_WPOS][2],
+                     &span.attrStepX[FRAG_ATTRIB_WPOS][2],
+                     &span.attrStepY[FRAG_ATTRIB_WPOS][2]);
+   if (span.attrStepX[FRAG_ATTRIB_WPOS][2] > fb->_DepthMaxF ||
+       span.attrStepX[FRAG_ATTRIB_WPOS][2] < -fb->_DepthMaxF) {
+      /* probably a sliver triangle */
+      span.attrStepX[FRAG_ATTRIB_WPOS][2] = 0.0;
+      span.attrStepY[FRAG_ATTRIB_WPOS][2] = 0.0;
+   }
+   if (fb->Visual.depthBits <= 16)
+      span.zStep = SignedFloatToFixed(span.attrStepX[FRAG_ATTRIB_WPOS][2]);
+   else
+      span.zStep = (GLint) span.attrStepX[FRAG_ATTRIB_WPOS][2];
+
+   span.interpMask |= SPAN_RGBA;
+   if (ctx->Light.ShadeModel == GL_SMOOTH) {
+      for (k = 0; k < 4; k++) {
+         tri.color0[k] = (GLfloat) v0->color[k];
+         compute_gradients(&tri, tri.color0[k],
+                           (GLfloat) v1->color[k], (GLfloat) v2->color[k],
+                           &span.attrStepX[FRAG_ATTRIB_COL0][k],
+                           &span.attrStepY[FRAG_ATTRIB_COL0][k]);
+      }
+      span.redStep = SignedFloatToFixed(span.attrStepX[FRAG_ATTRIB_COL0][0]);
+      span.greenStep = SignedFloatToFixed(span.attrStepX[FRAG_ATTRIB_COL0][1]);
+      span.blueStep = SignedFloatToFixed(span.attrStepX[FRAG_ATTRIB_COL0][2]);
+      span.alphaStep = SignedFloatToFixed(span.attrStepX[FRAG_ATTRIB_COL0][3]);
+   }
+   else {
+      ASSERT(ctx->Light.ShadeModel == GL_FLAT);
+      span.interpMask |= SPAN_FLAT;
+      for (k = 0; k < 4; k++) {
+         tri.color0[k] = (GLfloat) v2->color[k];
+         span.attrStepX[FRAG_ATTRIB_COL0][k] = 0.0F;
+         span.attrStepY[FRAG_ATTRIB_COL0][k] = 0.0F;
+      }
+      span.redStep = span.greenStep = span.blueStep = span.alphaStep = 0;
+   }
+
+   /* attrib[FRAG_ATTRIB_WPOS][3] is 1/W */
+   tri.w0 = v0->attrib[FRAG_ATTRIB_WPOS][3];
+   compute_gradients(&tri, tri.w0,
+                     v1->attrib[FRAG_ATTRIB_WPOS][3],
+                     v2->attrib[FRAG_ATTRIB_WPOS][3],
+                     &span.attrStepX[FRAG_ATTRIB_WPOS][3],
+                     &span.attrStepY[FRAG_ATTRIB_WPOS][3]);
+   ATTRIB_LOOP_BEGIN
+      if (attr != FRAG_ATTRIB_WPOS) {
+         GLuint c;
+         if (swrast->_InterpMode[attr] == GL_FLAT) {
+            for (c = 0; c < 4; c++) {
+               tri.attrib0[attr][c] = v2->attrib[attr][c];
+               span.attrStepX[attr][c] = span.attrStepY[attr][c] = 0.0F;
+            }
+         }
+         else {
+            const GLfloat w1 = v1->attrib[FRAG_ATTRIB_WPOS][3];
+            const GLfloat w2 = v2->attrib[FRAG_ATTRIB_WPOS][3];
+            for (c = 0; c < 4; c++) {
+               tri.attrib0[attr][c] = v0->attrib[attr][c] * tri.w0;
+               compute_gradients(&tri, tri.attrib0[attr][c],
+                                 v1->attrib[attr][c] * w1,
+                                 v2->attrib[attr][c] * w2,
+                                 &span.attrStepX[attr][c],
+                                 &span.attrStepY[attr][c]);
+            }
+         }
+      }
+   ATTRIB_LOOP_END
+
+   /* Visit the blocks row by row.  The edge functions are stepped from
+    * block to block in doubles, which is exact for these integers.
+    */
+   for (by = ymin & ~(BLOCK_SIZE - 1); by < ymax; by += BLOCK_SIZE) {
+      const GLint bxStart = xmin & ~(BLOCK_SIZE - 1);
+      GLint left[BLOCK_SIZE], right[BLOCK_SIZE];
+      GLdouble rowE[3];
+      GLboolean covered = GL_FALSE;
+      GLint j;
+
+      for (j = 0; j < BLOCK_SIZE; j++) {
+         left[j] = xmax;
+         right[j] = xmin;
+      }
+      for (k = 0; k < 3; k++) {
+         rowE[k] = edge[k].c + (GLdouble) edge[k].stepX * bxStart
+                             + (GLdouble) edge[k].stepY * by;
+      }
+
+      for (bx = bxStart; bx < xmax; bx += BLOCK_SIZE) {
+         GLint e[3], stepX[3], stepY[3];
+         GLboolean outside = GL_FALSE, partial = GL_FALSE;
+
+         for (k = 0; k < 3; k++) {
+            const GLdouble ek = rowE[k];
+            rowE[k] += (GLdouble) edge[k].stepX * BLOCK_SIZE;
+            if (ek + edge[k].blockMax < 0.0) {
+               /* the block is skipped, but keep e[] etc. defined */
+               e[k] = stepX[k] = stepY[k] = 0;
+               outside = GL_TRUE;
+            }
+            else if (ek + edge[k].blockMin >= 0.0) {
+               /* the whole block is inside of this edge */
+               e[k] = stepX[k] = stepY[k] = 0;
+            }
+            else {
+               /* |ek| <= blockMax - blockMin here */
+               e[k] = (GLint) ek;
+               stepX[k] = edge[k].stepX;
+               stepY[k] = edge[k].stepY;
+               partial = GL_TRUE;
+            }
+         }
+
+         if (outside) {
+            /* The blocks touching the triangle within a block row are
+             * contiguous, so the rest of the row is outside, too.
+             */
+            if (covered)
+               break;
+         }
+         else if (partial) {
+            /* slivers may miss all pixels of a block between two
+             * covered ones, so keep going
+             */
+            if (cover_block(e, stepX, stepY, bx, left, right))
+               covered = GL_TRUE;
+         }
+         else {
+            for (j = 0; j < BLOCK_SIZE; j++) {
+               left[j] = MIN2(left[j], bx);
+               right[j] = MAX2(right[j], bx + BLOCK_SIZE);
+            }
+            covered = GL_TRUE;
+         }
+      }
+
+      if (!covered)
+         continue;
+
+      for (j = 0; j < BLOCK_SIZE; j++) {
+         const GLint y = by + j;
+         const GLint x0 = MAX2(left[j], xmin);
+         const GLint x1 = MIN2(right[j], xmax);
+         if (y >= ymin && y < ymax && x0 < x1)
+            render_span(ctx, &span, &tri, x0, y, x1 - x0);
+      }
+   }
+}
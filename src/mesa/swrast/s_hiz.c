@@ -0,0 +1,467 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * Coarse (hierarchical) Z culling.
+ *
+ * Software depth buffers carry a gl_depth_tiles object which keeps
+ * conservative bounds of the depth values in each DEPTH_TILE_SIZE x
+ * DEPTH_TILE_SIZE tile of the buffer.  Before a triangle span is
+ * generated, s_tritemp.h calls _swrast_hiz_cull_span() to find out if
+ * any of its fragments could pass the depth test.  If none can, the
+ * span is dropped before it is textured and shaded.
+ *
+ * Depth buffer writes only widen the bounds, which is cheap but lets
+ * them get loose.  Each tile therefore counts the values written since
+ * its bounds were last computed from the depth buffer.  When a tile
+ * fails to cull a span and at least a tile's worth of values has been
+ * written to it, the tile is rescanned.  That costs at most one depth
+ * buffer read per value written.  Clears set the bounds exactly.
+ *
+ * The tiled renderer (s_tile.c) draws screen bands in parallel.  Since
+ * the depth tiles nest within the bands, each tile is only ever looked
+ * at by one thread.
+ */
+
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+
+#include "s_context.h"
+#include "s_hiz.h"
+#include "s_tile.h"
+
+
+#if SWRAST_TILE_ROWS % DEPTH_TILE_SIZE != 0
+#error "depth tiles must not straddle the screen bands of s_tile.c"
+#endif
+
+
+#define TILE_AREA (DEPTH_TILE_SIZE * DEPTH_TILE_SIZE)
+
+
+/**
+ * Set the bounds of all tiles to "unknown".
+ */
+static void
+reset_tiles(struct gl_depth_tiles *tiles)
+{
+   const GLuint n = tiles->Cols * tiles->Rows;
+   GLuint i;
+
+   for (i = 0; i < n; i++) {
+      tiles->Min[i] = 0;
+      tiles->Max[i] = ~0u;
+      tiles->Writes[i] = TILE_AREA;  /* rescan before use */
+   }
+   tiles->Valid = GL_TRUE;
+}
+
+
+/**
+ * Widen the bounds of tile i to include [zMin, zMax].
+ */
+static INLINE void
+update_tile(struct gl_depth_tiles *tiles, GLuint i,
+            GLuint zMin, GLuint zMax, GLuint count)
+{
+   if (zMin < tiles->Min[i])
+      tiles->Min[i] = zMin;
+   if (zMax > tiles->Max[i])
+      tiles->Max[i] = zMax;
+   if (tiles->Writes[i] < TILE_AREA)
+      tiles->Writes[i] += count;
+}
+
+
+/**
+ * Recompute the bounds of a tile from the depth buffer.
+ */
+static void
+scan_tile(GLcontext *ctx, struct gl_renderbuffer *rb, GLuint col, GLuint row)
+{
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   const GLuint x0 = col * DEPTH_TILE_SIZE;
+   const GLuint y0 = row * DEPTH_TILE_SIZE;
+   const GLuint width = MIN2(DEPTH_TILE_SIZE, rb->Width - x0);
+   const GLuint height = MIN2(DEPTH_TILE_SIZE, rb->Height - y0);
+   const GLuint i = row * tiles->Cols + col;
+   GLuint zMin = ~0u, zMax = 0;
+   GLuint x, y;
+
+   if (rb->DataType == GL_UNSIGNED_SHORT) {
+      for (y = 0; y < height; y++) {
+         const GLushort *z
+            = (const GLushort *) rb->GetPointer(ctx, rb, x0, y0 + y);
+         for (x = 0; x < width; x++) {
+            if (z[x] < zMin)
+               zMin = z[x];
+            if (z[x] > zMax)
+               zMax = z[x];
+         }
+      }
+   }
+   else {
+      ASSERT(rb->DataType == GL_UNSIGNED_INT);
+      for (y = 0; y < height; y++) {
+         const GLuint *z
+            = (const GLuint *) rb->GetPointer(ctx, rb, x0, y0 + y);
+         for (x = 0; x < width; x++) {
+            if (z[x] < zMin)
+               zMin = z[x];
+            if (z[x] > zMax)
+               zMax = z[x];
+         }
+      }
+   }
+
+   tiles->Min[i] = zMin;
+   tiles->Max[i] = zMax;
+   tiles->Writes[i] = 0;
+}
+
+
+/**
+ * Can no fragment with a Z value in [zMin, zMax] pass the depth test
+ * against a tile whose values are within [tileMin, tileMax]?
+ */
+static INLINE GLboolean
+tile_culls(GLenum func, GLuint zMin, GLuint zMax,
+           GLuint tileMin, GLuint tileMax)
+{
+   switch (func) {
+   case GL_NEVER:
+      return GL_TRUE;
+   case GL_LESS:
+      return zMin >= tileMax;
+   case GL_LEQUAL:
+      return zMin > tileMax;
+   case GL_EQUAL:
+      return zMax < tileMin || zMin > tileMax;
+   case GL_GEQUAL:
+      return zMax < tileMin;
+   case GL_GREATER:
+      return zMax <= tileMin;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Compute the range of a span's interpolated Z values, exactly as
+ * _swrast_span_interpolate_z() would produce them.
+ * \return GL_FALSE if the values wrap around
+ */
+static GLboolean
+span_z_range(const GLcontext *ctx, const SWspan *span,
+             GLuint *zMin, GLuint *zMax)
+{
+   const GLuint n = span->end;
+
+   ASSERT(n > 0);
+
+   if (ctx->DrawBuffer->Visual.depthBits <= 16) {
+      const GLint z0 = FixedToInt(span->z);
+      const GLint z1 = FixedToInt(span->z + (GLint) (n - 1) * span->zStep);
+      if (z0 < 0 || z1 < 0)
+         return GL_FALSE;
+      *zMin = MIN2(z0, z1);
+      *zMax = MAX2(z0, z1);
+   }
+   else {
+      const GLuint z0 = (GLuint) span->z;
+      const GLuint z1 = z0 + (n - 1) * (GLuint) span->zStep;
+      if (span->zStep >= 0 ? z1 < z0 : z1 > z0)
+         return GL_FALSE;
+      *zMin = MIN2(z0, z1);
+      *zMax = MAX2(z0, z1);
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * Decide whether triangle spans may be culled against the depth tiles.
+ * Culled fragments must not have any effect other than failing the depth
+ * test and the test must be done with the interpolated Z values.
+ * Called from _swrast_validate_derived().
+ */
+void
+_swrast_update_hiz(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct gl_renderbuffer *rb = ctx->DrawBuffer->_DepthBuffer;
+   const struct gl_fragment_program *fprog = ctx->FragmentProgram._Current;
+
+   swrast->_HiZFunc = GL_NONE;
+
+   if (!swrast->UseHiZ ||
+       !ctx->Depth.Test ||
+       ctx->DrawBuffer->Visual.depthBits == 0 ||
+       !rb || !rb->DepthTiles)
+      return;
+
+   if (ctx->Stencil.Enabled &&
+       (ctx->Stencil.ZFailFunc[0] != GL_KEEP ||
+        ctx->Stencil.ZFailFunc[1] != GL_KEEP))
+      return;
+
+   if (fprog && (fprog->Base.OutputsWritten & (1 << FRAG_RESULT_DEPR)))
+      return;
+
+   switch (ctx->Depth.Func) {
+   case GL_NEVER:
+   case GL_LESS:
+   case GL_LEQUAL:
+   case GL_EQUAL:
+   case GL_GEQUAL:
+   case GL_GREATER:
+      if (!rb->DepthTiles->Valid)
+         reset_tiles(rb->DepthTiles);
+      swrast->_HiZFunc = ctx->Depth.Func;
+      break;
+   default:
+      ;
+   }
+}
+
+
+/**
+ * Check a span of interpolated Z values against the depth tiles.
+ * \return GL_TRUE if none of the span's fragments can pass the depth test
+ */
+GLboolean
+_swrast_hiz_cull_span(GLcontext *ctx, const SWspan *span)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLenum func = swrast->_HiZFunc;
+   struct gl_renderbuffer *rb = ctx->DrawBuffer->_DepthBuffer;
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   GLint x0 = span->x, x1 = span->x + (GLint) span->end;
+   GLuint zMin, zMax, row, col, lastCol, i;
+
+   if (!tiles || !tiles->Valid ||
+       span->y < 0 || span->y >= (GLint) rb->Height ||
+       !span_z_range(ctx, span, &zMin, &zMax))
+      return GL_FALSE;
+
+   /* fragments outside the buffer will be clipped anyway */
+   if (x0 < 0)
+      x0 = 0;
+   if (x1 > (GLint) rb->Width)
+      x1 = rb->Width;
+   if (x0 >= x1)
+      return GL_FALSE;
+
+   row = span->y / DEPTH_TILE_SIZE;
+   lastCol = (x1 - 1) / DEPTH_TILE_SIZE;
+   for (col = x0 / DEPTH_TILE_SIZE; col <= lastCol; col++) {
+      i = row * tiles->Cols + col;
+      if (!tile_culls(func, zMin, zMax, tiles->Min[i], tiles->Max[i])) {
+         if (tiles->Writes[i] < TILE_AREA)
+            return GL_FALSE;
+         scan_tile(ctx, rb, col, row);
+         if (!tile_culls(func, zMin, zMax, tiles->Min[i], tiles->Max[i]))
+            return GL_FALSE;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Note that some of a span's interpolated Z values may have been written
+ * to the depth buffer (used by triangle functions which address the depth
+ * buffer directly).
+ */
+void
+_swrast_hiz_span_written(GLcontext *ctx, struct gl_renderbuffer *rb,
+                         const SWspan *span)
+{
+   GLuint zMin, zMax;
+
+   if (!span_z_range(ctx, span, &zMin, &zMax)) {
+      zMin = 0;
+      zMax = ~0u;
+   }
+   _swrast_hiz_rect_written(rb, span->x, span->y, span->end, 1, zMin, zMax);
+}
+
+
+/**
+ * Note that the z[i] values for which mask[i] is set were written to a
+ * row of the depth buffer.  The span must be inside the buffer.
+ */
+void
+_swrast_hiz_values_written(struct gl_renderbuffer *rb, GLint x, GLint y,
+                           GLuint n, const GLuint z[], const GLubyte mask[])
+{
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   GLuint row, i = 0;
+
+   if (!tiles->Valid)
+      return;
+
+   ASSERT(x >= 0);
+   ASSERT(y >= 0);
+   ASSERT(x + n <= rb->Width);
+   ASSERT(y < (GLint) rb->Height);
+
+   row = (y / DEPTH_TILE_SIZE) * tiles->Cols;
+   while (i < n) {
+      const GLuint col = (x + i) / DEPTH_TILE_SIZE;
+      const GLuint end = MIN2(n, (col + 1) * DEPTH_TILE_SIZE - x);
+      GLuint zMin = ~0u, zMax = 0, count = 0;
+      for (; i < end; i++) {
+         if (mask[i]) {
+            if (z[i] < zMin)
+               zMin = z[i];
+            if (z[i] > zMax)
+               zMax = z[i];
+            count++;
+         }
+      }
+      if (count)
+         update_tile(tiles, row + col, zMin, zMax, count);
+   }
+}
+
+
+/**
+ * Note that the z[i] values for which mask[i] is set were written to
+ * the depth buffer at (x[i], y[i]).  The pixels must be inside the buffer.
+ */
+void
+_swrast_hiz_pixels_written(struct gl_renderbuffer *rb, GLuint n,
+                           const GLint x[], const GLint y[],
+                           const GLuint z[], const GLubyte mask[])
+{
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   GLuint i;
+
+   if (!tiles->Valid)
+      return;
+
+   for (i = 0; i < n; i++) {
+      if (mask[i]) {
+         const GLuint t = (y[i] / DEPTH_TILE_SIZE) * tiles->Cols
+                        + x[i] / DEPTH_TILE_SIZE;
+         update_tile(tiles, t, z[i], z[i], 1);
+      }
+   }
+}
+
+
+/**
+ * Note that values within [zMin, zMax] may have been written anywhere
+ * in the given rectangle of the depth buffer.
+ */
+void
+_swrast_hiz_rect_written(struct gl_renderbuffer *rb, GLint x, GLint y,
+                         GLint width, GLint height,
+                         GLuint zMin, GLuint zMax)
+{
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   GLint x1 = x + width, y1 = y + height;
+   GLint tx, ty;
+
+   if (!tiles->Valid)
+      return;
+
+   x = MAX2(x, 0);
+   y = MAX2(y, 0);
+   x1 = MIN2(x1, (GLint) rb->Width);
+   y1 = MIN2(y1, (GLint) rb->Height);
+
+   for (ty = y / DEPTH_TILE_SIZE * DEPTH_TILE_SIZE; ty < y1;
+        ty += DEPTH_TILE_SIZE) {
+      const GLint h = MIN2(y1, ty + DEPTH_TILE_SIZE) - MAX2(y, ty);
+      const GLuint row = (ty / DEPTH_TILE_SIZE) * tiles->Cols;
+      for (tx = x / DEPTH_TILE_SIZE * DEPTH_TILE_SIZE; tx < x1;
+           tx += DEPTH_TILE_SIZE) {
+         const GLint w = MIN2(x1, tx + DEPTH_TILE_SIZE) - MAX2(x, tx);
+         update_tile(tiles, row + tx / DEPTH_TILE_SIZE, zMin, zMax, w * h);
+      }
+   }
+}
+
+
+/**
+ * Note that a rectangle of the depth buffer was cleared.  Tiles which
+ * are entirely inside the rectangle get exact bounds.
+ */
+void
+_swrast_hiz_clear(struct gl_renderbuffer *rb, GLint x, GLint y,
+                  GLint width, GLint height, GLuint clearValue)
+{
+   struct gl_depth_tiles *tiles = rb->DepthTiles;
+   GLint x1 = x + width, y1 = y + height;
+   GLint tx, ty;
+
+   if (!tiles->Valid)
+      return;
+
+   x = MAX2(x, 0);
+   y = MAX2(y, 0);
+   x1 = MIN2(x1, (GLint) rb->Width);
+   y1 = MIN2(y1, (GLint) rb->Height);
+
+   for (ty = y / DEPTH_TILE_SIZE * DEPTH_TILE_SIZE; ty < y1;
+        ty += DEPTH_TILE_SIZE) {
+      const GLint tileH = MIN2(DEPTH_TILE_SIZE, (GLint) rb->Height - ty);
+      const GLint h = MIN2(y1, ty + DEPTH_TILE_SIZE) - MAX2(y, ty);
+      const GLuint row = (ty / DEPTH_TILE_SIZE) * tiles->Cols;
+      for (tx = x / DEPTH_TILE_SIZE * DEPTH_TILE_SIZE; tx < x1;
+           tx += DEPTH_TILE_SIZE) {
+         const GLint tileW = MIN2(DEPTH_TILE_SIZE, (GLint) rb->Width - tx);
+         const GLint w = MIN2(x1, tx + DEPTH_TILE_SIZE) - MAX2(x, tx);
+         const GLuint i = row + tx / DEPTH_TILE_SIZE;
+         if (w == tileW && h == tileH) {
+            tiles->Min[i] = tiles->Max[i] = clearValue;
+            tiles->Writes[i] = 0;
+         }
+         else {
+            update_tile(tiles, i, clearValue, clearValue, w * h);
+         }
+      }
+   }
+}
+
+
+/**
+ * Forget the bounds of all tiles, after the depth buffer was written
+ * in some way that isn't tracked.
+ */
+void
+_swrast_hiz_invalidate(struct gl_renderbuffer *rb)
+{
+   if (rb && rb->DepthTiles && rb->DepthTiles->Valid)
+      reset_tiles(rb->DepthTiles);
+}
@@ -0,0 +1,67 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef S_HIZ_H
+#define S_HIZ_H
+
+
+#include "main/mtypes.h"
+#include "s_span.h"
+
+
+extern void
+_swrast_update_hiz(GLcontext *ctx);
+
+extern GLboolean
+_swrast_hiz_cull_span(GLcontext *ctx, const SWspan *span);
+
+extern void
+_swrast_hiz_span_written(GLcontext *ctx, struct gl_renderbuffer *rb,
+                         const SWspan *span);
+
+extern void
+_swrast_hiz_values_written(struct gl_renderbuffer *rb, GLint x, GLint y,
+                           GLuint n, const GLuint z[], const GLubyte mask[]);
+
+extern void
+_swrast_hiz_pixels_written(struct gl_renderbuffer *rb, GLuint n,
+                           const GLint x[], const GLint y[],
+                           const GLuint z[], const GLubyte mask[]);
+
+extern void
+_swrast_hiz_rect_written(struct gl_renderbuffer *rb, GLint x, GLint y,
+                         GLint width, GLint height,
+                         GLuint zMin, GLuint zMax);
+
+extern void
+_swrast_hiz_clear(struct gl_renderbuffer *rb, GLint x, GLint y,
+                  GLint width, GLint height, GLuint clearValue);
+
+extern void
+_swrast_hiz_invalidate(struct gl_renderbuffer *rb);
+
+
+#endif /* S_HIZ_H */
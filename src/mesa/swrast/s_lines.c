@@ -68,7 +68,7 @@ draw_wide_line( GLcontext *ctx, SWspan *span, GLboolean xMajor )
                                      ctx->Const.MaxLineWidth);
    GLint start;
 
-   ASSERT(span->end < MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
 
    if (width & 1)
       start = width / 2;
@@ -46,6 +46,8 @@
  * Similarly, for direct depth buffer access, this type is used for depth
  * buffer addressing:
  *    DEPTH_TYPE          - either GLushort or GLuint
+ * The depth tiles (see s_hiz.c) then forget what they knew about the
+ * line's bounding box.
  *
  * Optionally, one may provide one-time setup code
  *    SETUP_CODE    - code which is to be executed once per line
@@ -59,6 +61,11 @@
  *                   put_pixel( X, Y, color );
  *                }
  *
+ * Otherwise the pixel coordinates are put into the span arrays and
+ * this macro is used to draw them:
+ *    RENDER_SPAN(span) - code to write a span of up to MAX_SPAN_WIDTH
+ *                        pixels.  Long lines are drawn in several pieces.
+ *
  * This code was designed for the origin to be in the lower-left corner.
  *
  */
@@ -77,6 +84,9 @@ NAME( GLcontext *ctx, const SWvertex *vert0, const SWvertex *vert1 )
    GLint dx, dy;
    GLint numPixels;
    GLint xstep, ystep;
+#ifndef PLOT
+   GLuint count = 0;  /* number of fragments put into the span arrays */
+#endif
 #if defined(DEPTH_TYPE)
    const GLint depthBits = ctx->DrawBuffer->Visual.depthBits;
    const GLint fixedToDepthShift = depthBits <= 16 ? FIXED_SHIFT : 0;
@@ -310,6 +320,13 @@ NAME( GLcontext *ctx, const SWvertex *vert0, const SWvertex *vert1 )
 
    span.facing = swrast->PointLineFacing;
 
+#ifdef DEPTH_TYPE
+   if (zrb->DepthTiles) {
+      _swrast_hiz_rect_written(zrb, MIN2(x0, x1), MIN2(y0, y1),
+                               dx + 1, dy + 1, 0, ~0u);
+   }
+#endif
+
 
    /*
     * Draw
@@ -329,8 +346,17 @@ NAME( GLcontext *ctx, const SWvertex *vert0, const SWvertex *vert1 )
 #ifdef PLOT
          PLOT( x0, y0 );
 #else
-         span.array->x[i] = x0;
-         span.array->y[i] = y0;
+         span.array->x[count] = x0;
+         span.array->y[count] = y0;
+         if (++count == MAX_SPAN_WIDTH) {
+            /* span arrays are full, draw this piece of the line */
+            span.end = count;
+#ifdef RENDER_SPAN
+            RENDER_SPAN( span );
+#endif
+            _swrast_span_advance(ctx, &span, count);
+            count = 0;
+         }
 #endif
          x0 += xstep;
 #ifdef DEPTH_TYPE
@@ -369,8 +395,17 @@ NAME( GLcontext *ctx, const SWvertex *vert0, const SWvertex *vert1 )
 #ifdef PLOT
          PLOT( x0, y0 );
 #else
-         span.array->x[i] = x0;
-         span.array->y[i] = y0;
+         span.array->x[count] = x0;
+         span.array->y[count] = y0;
+         if (++count == MAX_SPAN_WIDTH) {
+            /* span arrays are full, draw this piece of the line */
+            span.end = count;
+#ifdef RENDER_SPAN
+            RENDER_SPAN( span );
+#endif
+            _swrast_span_advance(ctx, &span, count);
+            count = 0;
+         }
 #endif
          y0 += ystep;
 #ifdef DEPTH_TYPE
@@ -396,8 +431,13 @@ NAME( GLcontext *ctx, const SWvertex *vert0, const SWvertex *vert1 )
       }
    }
 
+#ifndef PLOT
+   span.end = count;
 #ifdef RENDER_SPAN
-   RENDER_SPAN( span );
+   if (count > 0) {
+      RENDER_SPAN( span );
+   }
+#endif
 #endif
 
    (void)span;
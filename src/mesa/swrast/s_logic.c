@@ -190,10 +190,10 @@ void
 _swrast_logicop_ci_span(GLcontext *ctx, struct gl_renderbuffer *rb,
                         SWspan *span)
 {
-   GLuint dest[MAX_WIDTH];
+   GLuint dest[MAX_SPAN_WIDTH];
    GLuint *index = span->array->index;
 
-   ASSERT(span->end < MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
    ASSERT(rb->DataType == GL_UNSIGNED_INT);
 
    /* Read dest values from frame buffer */
@@ -220,7 +220,7 @@ _swrast_logicop_rgba_span(GLcontext *ctx, struct gl_renderbuffer *rb,
 {
    void *rbPixels;
 
-   ASSERT(span->end < MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
    ASSERT(span->arrayMask & SPAN_RGBA);
    ASSERT(rb->DataType == span->array->ChanType);
 
@@ -46,7 +46,7 @@ _swrast_mask_rgba_span(GLcontext *ctx, struct gl_renderbuffer *rb,
    const GLuint n = span->end;
    void *rbPixels;
 
-   ASSERT(n < MAX_WIDTH);
+   ASSERT(n <= MAX_SPAN_WIDTH);
    ASSERT(span->arrayMask & SPAN_RGBA);
    ASSERT(rb->DataType == span->array->ChanType);
 
@@ -113,11 +113,11 @@ _swrast_mask_ci_span(GLcontext *ctx, struct gl_renderbuffer *rb,
    const GLuint srcMask = ctx->Color.IndexMask;
    const GLuint dstMask = ~srcMask;
    GLuint *index = span->array->index;
-   GLuint dest[MAX_WIDTH];
+   GLuint dest[MAX_SPAN_WIDTH];
    GLuint i;
 
    ASSERT(span->arrayMask & SPAN_INDEX);
-   ASSERT(span->end <= MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
    ASSERT(rb->DataType == GL_UNSIGNED_INT);
 
    if (span->arrayMask & SPAN_XY) {
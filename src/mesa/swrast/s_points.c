@@ -454,10 +454,16 @@ large_point(GLcontext *ctx, const SWvertex *vert)
             span.array->x[span.end] = ix;
             span.array->y[span.end] = iy;
             span.end++;
+            if (span.end == MAX_SPAN_WIDTH) {
+               /* span arrays are full, draw what we have so far */
+               _swrast_write_rgba_span(ctx, &span);
+               span.end = 0;
+            }
          }
       }
-      assert(span.end <= MAX_WIDTH);
-      _swrast_write_rgba_span(ctx, &span);
+      if (span.end > 0) {
+         _swrast_write_rgba_span(ctx, &span);
+      }
    }
 }
 
@@ -496,7 +502,7 @@ pixel_point(GLcontext *ctx, const SWvertex *vert)
    span->attrStepY[FRAG_ATTRIB_WPOS][3] = 0.0F;
 
    /* check if we need to flush */
-   if (span->end >= MAX_WIDTH ||
+   if (span->end >= MAX_SPAN_WIDTH ||
        (swrast->_RasterMask & (BLEND_BIT | LOGIC_OP_BIT | MASKING_BIT)) ||
        span->facing != swrast->PointLineFacing) {
       if (span->end > 0) {
@@ -532,7 +538,7 @@ pixel_point(GLcontext *ctx, const SWvertex *vert)
    span->array->z[count] = (GLint) (vert->attrib[FRAG_ATTRIB_WPOS][2] + 0.5F);
 
    span->end = count + 1;
-   ASSERT(span->end <= MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
 }
 
 
@@ -34,11 +34,13 @@
 #include "main/imports.h"
 #include "main/pixel.h"
 #include "main/state.h"
+#include "main/threadpool.h"
 
 #include "s_context.h"
 #include "s_depth.h"
 #include "s_span.h"
 #include "s_stencil.h"
+#include "s_tile.h"
 
 
 /*
@@ -196,6 +198,117 @@ read_stencil_pixels( GLcontext *ctx,
 
 
 
+/** Smallest readback, in pixels, which is split across threads */
+#define MIN_THREADED_PIXELS (256 * 256)
+
+
+/**
+ * Rows of an 8-bit RGBA color buffer to be copied straight from the
+ * renderbuffer storage into the client's (or the PBO's) memory.
+ */
+struct direct_read_job {
+   GLcontext *ctx;
+   struct gl_renderbuffer *rb;
+   GLint x, y, width, height;
+   GLenum format, type;
+   const struct gl_pixelstore_attrib *packing;
+   GLubyte *dest;            /**< first (bottom) destination row */
+   GLint dstStride;
+   GLint rowsPerTask;
+};
+
+
+/**
+ * Copy or convert one band of rows.  Each source row is looked up with
+ * GetPointer, so buffers stored top to bottom are flipped while copying.
+ */
+static void
+direct_read_rows(void *data, GLuint task, GLuint thread)
+{
+   const struct direct_read_job *job = (const struct direct_read_job *) data;
+   struct gl_renderbuffer *rb = job->rb;
+   const GLint start = task * job->rowsPerTask;
+   const GLint end = MIN2(start + job->rowsPerTask, job->height);
+   GLubyte *dest = job->dest + start * job->dstStride;
+   GLint row;
+
+   (void) thread;
+
+   for (row = start; row < end; row++) {
+      const GLubyte (*src)[4] = (const GLubyte (*)[4])
+         rb->GetPointer(job->ctx, rb, job->x, job->y + row);
+      if (job->format == GL_RGBA && job->type == GL_UNSIGNED_BYTE)
+         _mesa_memcpy(dest, src, 4 * job->width);
+      else
+         _mesa_pack_rgba_span_ubyte(job->width, src, job->format, job->type,
+                                    dest, job->packing);
+      dest += job->dstStride;
+   }
+}
+
+
+/**
+ * glReadPixels of a whole rectangle of an 8-bit RGBA color buffer whose
+ * storage can be addressed directly, without going through GetRow and a
+ * temporary row.  Large rectangles are split into bands of rows done by
+ * the swrast threads.
+ * \return GL_TRUE if the pixels were read
+ */
+static GLboolean
+direct_read_rgba_pixels(GLcontext *ctx,
+                        GLint x, GLint y,
+                        GLsizei width, GLsizei height,
+                        GLenum format, GLenum type,
+                        GLvoid *pixels,
+                        const struct gl_pixelstore_attrib *packing)
+{
+   struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
+   struct _mesa_threadpool *pool;
+   struct direct_read_job job;
+
+   /* GetPointer must address R, G, B, A bytes (not the 1-byte storage of
+    * an alpha wrapper, for instance)
+    */
+   if (rb->_BaseFormat != GL_RGBA ||
+       (rb->_ActualFormat != GL_RGBA8 && rb->_ActualFormat != GL_RGBA) ||
+       rb->DataType != GL_UNSIGNED_BYTE ||
+       ctx->ReadBuffer->Visual.redBits < 8 ||
+       ctx->ReadBuffer->Visual.greenBits < 8 ||
+       ctx->ReadBuffer->Visual.blueBits < 8 ||
+       !_mesa_can_convert_rgba_ubyte(format, type) ||
+       !rb->GetPointer(ctx, rb, x, y))
+      return GL_FALSE;
+
+   job.ctx = ctx;
+   job.rb = rb;
+   job.x = x;
+   job.y = y;
+   job.width = width;
+   job.height = height;
+   job.format = format;
+   job.type = type;
+   job.packing = packing;
+   job.dest = (GLubyte *) _mesa_image_address2d(packing, pixels, width, height,
+                                                format, type, 0, 0);
+   job.dstStride = _mesa_image_row_stride(packing, width, format, type);
+
+   pool = _swrast_get_thread_pool(ctx);
+   if (pool && width * height >= MIN_THREADED_PIXELS) {
+      const GLint numThreads = _mesa_threadpool_num_threads(pool);
+      job.rowsPerTask = MAX2(height / (4 * numThreads), 1);
+      _mesa_threadpool_run(pool,
+                           (height + job.rowsPerTask - 1) / job.rowsPerTask,
+                           direct_read_rows, &job);
+   }
+   else {
+      job.rowsPerTask = height;
+      direct_read_rows(&job, 0, 0);
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Optimized glReadPixels for particular pixel formats when pixel
  * scaling, biasing, mapping, etc. are disabled.
@@ -223,12 +336,15 @@ fast_read_rgba_pixels( GLcontext *ctx,
 
    /* check for things we can't handle here */
    if (transferOps ||
-       packing->SwapBytes ||
        packing->LsbFirst) {
       return GL_FALSE;
    }
 
-   if (format == GL_RGBA && rb->DataType == type) {
+   if (direct_read_rgba_pixels(ctx, x, y, width, height,
+                               format, type, pixels, packing))
+      return GL_TRUE;
+
+   if (format == GL_RGBA && rb->DataType == type && !packing->SwapBytes) {
       const GLint dstStride = _mesa_image_row_stride(packing, width,
                                                      format, type);
       GLubyte *dest
@@ -245,7 +361,8 @@ fast_read_rgba_pixels( GLcontext *ctx,
 
    if (format == GL_RGB &&
        rb->DataType == GL_UNSIGNED_BYTE &&
-       type == GL_UNSIGNED_BYTE) {
+       type == GL_UNSIGNED_BYTE &&
+       !packing->SwapBytes) {
       const GLint dstStride = _mesa_image_row_stride(packing, width,
                                                      format, type);
       GLubyte *dest
@@ -268,6 +385,29 @@ fast_read_rgba_pixels( GLcontext *ctx,
       return GL_TRUE;
    }
 
+   if (rb->DataType == GL_UNSIGNED_BYTE &&
+       ctx->ReadBuffer->Visual.redBits >= 8 &&
+       ctx->ReadBuffer->Visual.greenBits >= 8 &&
+       ctx->ReadBuffer->Visual.blueBits >= 8 &&
+       _mesa_can_convert_rgba_ubyte(format, type)) {
+      /* BGRA, packed or byte swapped pixels */
+      const GLint dstStride = _mesa_image_row_stride(packing, width,
+                                                     format, type);
+      GLubyte *dest
+         = (GLubyte *) _mesa_image_address2d(packing, pixels, width, height,
+                                             format, type, 0, 0);
+      GLint row;
+      ASSERT(rb->GetRow);
+      for (row = 0; row < height; row++) {
+         GLubyte tempRow[MAX_WIDTH][4];
+         rb->GetRow(ctx, rb, width, x, y + row, tempRow);
+         _mesa_pack_rgba_span_ubyte(width, (CONST GLubyte (*)[4]) tempRow,
+                                    format, type, dest, packing);
+         dest += dstStride;
+      }
+      return GL_TRUE;
+   }
+
    /* not handled */
    return GL_FALSE;
 }
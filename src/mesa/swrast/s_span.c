@@ -36,6 +36,7 @@
 #include "main/macros.h"
 #include "main/imports.h"
 #include "main/image.h"
+#include "main/profile.h"
 
 #include "s_atifragshader.h"
 #include "s_alpha.h"
@@ -46,6 +47,7 @@
 #include "s_logic.h"
 #include "s_masking.h"
 #include "s_fragprog.h"
+#include "s_hiz.h"
 #include "s_span.h"
 #include "s_stencil.h"
 #include "s_texcombine.h"
@@ -242,23 +244,25 @@ interpolate_int_colors(GLcontext *ctx, SWspan *span)
             }
          }
          else {
-            GLfixed r = span->red;
-            GLfixed g = span->green;
-            GLfixed b = span->blue;
-            GLfixed a = span->alpha;
-            GLint dr = span->redStep;
-            GLint dg = span->greenStep;
-            GLint db = span->blueStep;
-            GLint da = span->alphaStep;
+            const GLfixed r = span->red;
+            const GLfixed g = span->green;
+            const GLfixed b = span->blue;
+            const GLfixed a = span->alpha;
+            const GLint dr = span->redStep;
+            const GLint dg = span->greenStep;
+            const GLint db = span->blueStep;
+            const GLint da = span->alphaStep;
+            /* Compute each fragment's color from i instead of stepping
+             * r, g, b and a.  The result is the same, but GCC 12 at -O3
+             * vectorizes the stepping loop wrongly and stores the red and
+             * green values into the blue and alpha channels.
+             */
             for (i = 0; i < n; i++) {
-               rgba[i][RCOMP] = FixedToChan(r);
-               rgba[i][GCOMP] = FixedToChan(g);
-               rgba[i][BCOMP] = FixedToChan(b);
-               rgba[i][ACOMP] = FixedToChan(a);
-               r += dr;
-               g += dg;
-               b += db;
-               a += da;
+               const GLint k = (GLint) i;
+               rgba[i][RCOMP] = FixedToChan(r + k * dr);
+               rgba[i][GCOMP] = FixedToChan(g + k * dg);
+               rgba[i][BCOMP] = FixedToChan(b + k * db);
+               rgba[i][ACOMP] = FixedToChan(a + k * da);
             }
          }
       }
@@ -438,6 +442,64 @@ _swrast_span_interpolate_z( const GLcontext *ctx, SWspan *span )
 }
 
 
+/**
+ * Step the span's interpolants and x position ahead by n fragments.
+ * Used to break spans wider than MAX_SPAN_WIDTH into pieces.  The
+ * floating point attributes are stepped one fragment at a time, the
+ * same way they're interpolated, so the pieces produce exactly the same
+ * fragments as one long span would.  span->end is not changed.
+ */
+void
+_swrast_span_advance(const GLcontext *ctx, SWspan *span, GLuint n)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   /* The sums go through a volatile so that the compiler can't
+    * reassociate them: with -ffast-math it vectorizes the loops, which
+    * changes the rounding, so the result would depend on where the span
+    * is split.  The interpolation loops aren't vectorized.
+    */
+   volatile GLfloat v;
+   GLuint i;
+
+   span->x += n;
+
+   if (span->interpMask & SPAN_RGBA) {
+      span->red += n * span->redStep;
+      span->green += n * span->greenStep;
+      span->blue += n * span->blueStep;
+      span->alpha += n * span->alphaStep;
+   }
+   if (span->interpMask & SPAN_INDEX) {
+      span->index += n * span->indexStep;
+   }
+   if (span->interpMask & SPAN_Z) {
+      span->z = (GLfixed) ((GLuint) span->z + n * (GLuint) span->zStep);
+   }
+   /* the integer texcoords have no interpMask bit */
+   span->intTex[0] = (GLfixed) ((GLuint) span->intTex[0]
+                                + n * (GLuint) span->intTexStep[0]);
+   span->intTex[1] = (GLfixed) ((GLuint) span->intTex[1]
+                                + n * (GLuint) span->intTexStep[1]);
+
+   v = span->attrStart[FRAG_ATTRIB_WPOS][3];
+   for (i = 0; i < n; i++)
+      v += span->attrStepX[FRAG_ATTRIB_WPOS][3];
+   span->attrStart[FRAG_ATTRIB_WPOS][3] = v;
+   ATTRIB_LOOP_BEGIN
+      if (attr != FRAG_ATTRIB_WPOS) {
+         GLuint c;
+         for (c = 0; c < 4; c++) {
+            const GLfloat step = span->attrStepX[attr][c];
+            v = span->attrStart[attr][c];
+            for (i = 0; i < n; i++)
+               v += step;
+            span->attrStart[attr][c] = v;
+         }
+      }
+   ATTRIB_LOOP_END
+}
+
+
 /**
  * Compute mipmap LOD from partial derivatives.
  * This the ideal solution, as given in the OpenGL spec.
@@ -794,7 +856,7 @@ _swrast_write_index_span( GLcontext *ctx, SWspan *span)
    const GLbitfield origArrayMask = span->arrayMask;
    struct gl_framebuffer *fb = ctx->DrawBuffer;
 
-   ASSERT(span->end <= MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
    ASSERT(span->primitive == GL_POINT  ||  span->primitive == GL_LINE ||
 	  span->primitive == GL_POLYGON  ||  span->primitive == GL_BITMAP);
    ASSERT((span->interpMask | span->arrayMask) & SPAN_INDEX);
@@ -812,7 +874,8 @@ _swrast_write_index_span( GLcontext *ctx, SWspan *span)
    }
 
    /* Clipping */
-   if ((swrast->_RasterMask & CLIP_BIT) || (span->primitive != GL_POLYGON)) {
+   if ((swrast->_RasterMask & CLIP_BIT) || swrast->AllowGuardBand ||
+       (span->primitive != GL_POLYGON)) {
       if (!clip_span(ctx, span)) {
          return;
       }
@@ -918,7 +981,7 @@ _swrast_write_index_span( GLcontext *ctx, SWspan *span)
 
       for (buf = 0; buf < numBuffers; buf++) {
          struct gl_renderbuffer *rb = fb->_ColorDrawBuffers[buf];
-         GLuint indexSave[MAX_WIDTH];
+         GLuint indexSave[MAX_SPAN_WIDTH];
 
          ASSERT(rb->_BaseFormat == GL_COLOR_INDEX);
 
@@ -968,8 +1031,8 @@ _swrast_write_index_span( GLcontext *ctx, SWspan *span)
          }
          else {
             /* each fragment is a different color */
-            GLubyte index8[MAX_WIDTH];
-            GLushort index16[MAX_WIDTH];
+            GLubyte index8[MAX_SPAN_WIDTH];
+            GLushort index16[MAX_SPAN_WIDTH];
             void *values;
 
             if (rb->DataType == GL_UNSIGNED_BYTE) {
@@ -1231,6 +1294,156 @@ shade_texture_span(GLcontext *ctx, SWspan *span)
 
 
 
+/*
+ * Span writers specialized for common per-fragment state combinations.
+ */
+#if CHAN_BITS == 8
+
+#define NAME write_span_rgba8
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_rgba8_blend
+#define BLEND_TRANSPARENCY
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z16_less
+#define DEPTH_TYPE GLushort
+#define DEPTH_TEST(Z, ZBUF) ((Z) < (ZBUF))
+#define DEPTH_SHIFT
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z16_less_blend
+#define DEPTH_TYPE GLushort
+#define DEPTH_TEST(Z, ZBUF) ((Z) < (ZBUF))
+#define DEPTH_SHIFT
+#define BLEND_TRANSPARENCY
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z16_lequal
+#define DEPTH_TYPE GLushort
+#define DEPTH_TEST(Z, ZBUF) ((Z) <= (ZBUF))
+#define DEPTH_SHIFT
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z16_lequal_blend
+#define DEPTH_TYPE GLushort
+#define DEPTH_TEST(Z, ZBUF) ((Z) <= (ZBUF))
+#define DEPTH_SHIFT
+#define BLEND_TRANSPARENCY
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z32_less
+#define DEPTH_TYPE GLuint
+#define DEPTH_TEST(Z, ZBUF) ((Z) < (ZBUF))
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z32_less_blend
+#define DEPTH_TYPE GLuint
+#define DEPTH_TEST(Z, ZBUF) ((Z) < (ZBUF))
+#define BLEND_TRANSPARENCY
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z32_lequal
+#define DEPTH_TYPE GLuint
+#define DEPTH_TEST(Z, ZBUF) ((Z) <= (ZBUF))
+#include "s_spanwritetemp.h"
+
+#define NAME write_span_z32_lequal_blend
+#define DEPTH_TYPE GLuint
+#define DEPTH_TEST(Z, ZBUF) ((Z) <= (ZBUF))
+#define BLEND_TRANSPARENCY
+#include "s_spanwritetemp.h"
+
+
+/**
+ * The specialized writers, indexed by [depth mode][blend].
+ * Depth modes: 0 = no depth test, 1/2 = 16-bit LESS/LEQUAL,
+ * 3/4 = 32-bit LESS/LEQUAL.
+ */
+static const swrast_span_writer_func span_writers[5][2] = {
+   { write_span_rgba8, write_span_rgba8_blend },
+   { write_span_z16_less, write_span_z16_less_blend },
+   { write_span_z16_lequal, write_span_z16_lequal_blend },
+   { write_span_z32_less, write_span_z32_less_blend },
+   { write_span_z32_lequal, write_span_z32_lequal_blend }
+};
+
+#endif /* CHAN_BITS == 8 */
+
+
+/**
+ * Pick the specialized span writer matching the current state, if any.
+ * Called from _swrast_validate_derived(), after _RasterMask and
+ * _DeferredTexture are up to date.  Anything beyond depth testing,
+ * transparency blending and conventional texturing into a single 8-bit
+ * RGBA color buffer takes the generic path in _swrast_write_rgba_span().
+ */
+void
+_swrast_choose_span_writer(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+#if CHAN_BITS == 8
+   const GLbitfield unsupported = (ALPHATEST_BIT | STENCIL_BIT | FOG_BIT |
+                                   MASKING_BIT | LOGIC_OP_BIT |
+                                   MULTI_DRAW_BIT | OCCLUSION_BIT |
+                                   FRAGPROG_BIT | ATIFRAGSHADER_BIT);
+   struct gl_framebuffer *fb = ctx->DrawBuffer;
+   struct gl_renderbuffer *rb;
+   GLuint depthMode = 0, blend = 0;
+
+   swrast->_SpanWriter = NULL;
+
+   if (!swrast->UseSpanWriters ||
+       !ctx->Visual.rgbMode ||
+       (swrast->_RasterMask & unsupported) ||
+       ctx->Polygon.StippleFlag ||
+       ctx->Depth.BoundsTest ||
+       ctx->Fog.ColorSumEnabled ||
+       (ctx->Light.Enabled &&
+        ctx->Light.Model.ColorControl == GL_SEPARATE_SPECULAR_COLOR) ||
+       (ctx->Texture._EnabledUnits && !swrast->_DeferredTexture))
+      return;
+
+   rb = fb->_ColorDrawBuffers[0];
+   if (!rb || rb->DataType != GL_UNSIGNED_BYTE || rb->_BaseFormat != GL_RGBA)
+      return;
+
+   if (ctx->Color.BlendEnabled) {
+      if (ctx->Color.BlendEquationRGB != GL_FUNC_ADD ||
+          ctx->Color.BlendEquationA != GL_FUNC_ADD ||
+          ctx->Color.BlendSrcRGB != GL_SRC_ALPHA ||
+          ctx->Color.BlendSrcA != GL_SRC_ALPHA ||
+          ctx->Color.BlendDstRGB != GL_ONE_MINUS_SRC_ALPHA ||
+          ctx->Color.BlendDstA != GL_ONE_MINUS_SRC_ALPHA)
+         return;
+      blend = 1;
+   }
+
+   if (ctx->Depth.Test) {
+      struct gl_renderbuffer *zrb = fb->_DepthBuffer;
+      if (!zrb || fb->Visual.depthBits == 0)
+         return;
+      if (ctx->Depth.Func == GL_LESS)
+         depthMode = 1;
+      else if (ctx->Depth.Func == GL_LEQUAL)
+         depthMode = 2;
+      else
+         return;
+      /* the writers interpolate Z the way _swrast_span_interpolate_z does */
+      if (zrb->DataType == GL_UNSIGNED_INT && fb->Visual.depthBits > 16)
+         depthMode += 2;
+      else if (zrb->DataType != GL_UNSIGNED_SHORT || fb->Visual.depthBits > 16)
+         return;
+   }
+
+   swrast->_SpanWriter = span_writers[depthMode][blend];
+#else
+   swrast->_SpanWriter = NULL;
+#endif
+}
+
+
+
 /**
  * Apply all the per-fragment operations to a span.
  * This now includes texturing (_swrast_write_texture_span() is history).
@@ -1250,8 +1463,11 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
    void * const origRgba = span->array->rgba;
    const GLboolean shader = (ctx->FragmentProgram._Current
                              || ctx->ATIFragmentShader._Enabled);
-   const GLboolean shaderOrTexture = shader || ctx->Texture._EnabledUnits;
+   const GLboolean shaderOrTexture = shader ||
+      (ctx->Texture._EnabledUnits && !(span->arrayMask & SPAN_TEXTURED));
    struct gl_framebuffer *fb = ctx->DrawBuffer;
+   struct gl_profile *prof = SWRAST_PROFILE(swrast, ctx);
+   GLuint64EXT t = 0;
 
    /*
    printf("%s()  interp 0x%x  array 0x%x\n", __FUNCTION__,
@@ -1262,7 +1478,9 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
           span->primitive == GL_LINE ||
 	  span->primitive == GL_POLYGON ||
           span->primitive == GL_BITMAP);
-   ASSERT(span->end <= MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
+
+   PROFILE_START(prof, t);
 
    /* Fragment write masks */
    if (span->arrayMask & SPAN_MASK) {
@@ -1275,12 +1493,15 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
    }
 
    /* Clip to window/scissor box */
-   if ((swrast->_RasterMask & CLIP_BIT) || (span->primitive != GL_POLYGON)) {
+   if ((swrast->_RasterMask & CLIP_BIT) || swrast->AllowGuardBand ||
+       (span->primitive != GL_POLYGON)) {
       if (!clip_span(ctx, span)) {
 	 return;
       }
    }
 
+   PROFILE_LAP(prof, t, "span clip");
+
 #ifdef DEBUG
    /* Make sure all fragments are within window bounds */
    if (span->arrayMask & SPAN_XY) {
@@ -1296,9 +1517,20 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
    }
 #endif
 
+   /* Common state combinations are handled by a specialized writer */
+   if (swrast->_SpanWriter &&
+       span->primitive == GL_POLYGON &&
+       span->array->ChanType == GL_UNSIGNED_BYTE &&
+       (span->arrayMask & (SPAN_XY | SPAN_Z | SPAN_COVERAGE)) == 0 &&
+       swrast->_SpanWriter(ctx, span)) {
+      PROFILE_LAP(prof, t, "span specialized writer");
+      goto end;
+   }
+
    /* Polygon Stippling */
    if (ctx->Polygon.StippleFlag && span->primitive == GL_POLYGON) {
       stipple_polygon_span(ctx, span);
+      PROFILE_LAP(prof, t, "span stipple");
    }
 
    /* This is the normal place to compute the fragment color/Z
@@ -1306,11 +1538,14 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
     */
    if (shaderOrTexture && !swrast->_DeferredTexture) {
       shade_texture_span(ctx, span);
+      PROFILE_LAP(prof, t, shader ? "span fragment program" : "span texture");
    }
 
    /* Do the alpha test */
    if (ctx->Color.AlphaEnabled) {
-      if (!_swrast_alpha_test(ctx, span)) {
+      const GLboolean pass = _swrast_alpha_test(ctx, span);
+      PROFILE_LAP(prof, t, "span alpha test");
+      if (!pass) {
          goto end;
       }
    }
@@ -1323,6 +1558,7 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
       if (ctx->Stencil.Enabled && fb->Visual.stencilBits > 0) {
          /* Combined Z/stencil tests */
          if (!_swrast_stencil_and_ztest_span(ctx, span)) {
+            PROFILE_LAP(prof, t, "span depth/stencil test");
             goto end;
          }
       }
@@ -1331,9 +1567,11 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
          ASSERT(ctx->Depth.Test);
          ASSERT(span->arrayMask & SPAN_Z);
          if (!_swrast_depth_test_span(ctx, span)) {
+            PROFILE_LAP(prof, t, "span depth/stencil test");
             goto end;
          }
       }
+      PROFILE_LAP(prof, t, "span depth/stencil test");
    }
 
 #if FEATURE_ARB_occlusion_query
@@ -1359,6 +1597,7 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
     */
    if (shaderOrTexture && swrast->_DeferredTexture) {
       shade_texture_span(ctx, span);
+      PROFILE_LAP(prof, t, shader ? "span fragment program" : "span texture");
    }
 
 #if CHAN_BITS == 32
@@ -1398,6 +1637,8 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
       clamp_colors(span);
    }
 
+   PROFILE_LAP(prof, t, "span color/fog");
+
    /*
     * Write to renderbuffers
     */
@@ -1412,7 +1653,7 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
          /* color[fragOutput] will be written to buffer[buf] */
 
          if (rb) {
-            GLchan rgbaSave[MAX_WIDTH][4];
+            GLchan rgbaSave[MAX_SPAN_WIDTH][4];
             const GLuint fragOutput = multiFragOutputs ? buf : 0;
 
             if (rb->DataType != span->array->ChanType || fragOutput > 0) {
@@ -1429,9 +1670,11 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
 
             if (ctx->Color._LogicOpEnabled) {
                _swrast_logicop_rgba_span(ctx, rb, span);
+               PROFILE_LAP(prof, t, "span blend/logicop");
             }
             else if (ctx->Color.BlendEnabled) {
                _swrast_blend_span(ctx, rb, span);
+               PROFILE_LAP(prof, t, "span blend/logicop");
             }
 
             if (colorMask != 0xffffffff) {
@@ -1459,6 +1702,7 @@ _swrast_write_rgba_span( GLcontext *ctx, SWspan *span)
                             4 * span->end * sizeof(GLchan));
             }
 
+            PROFILE_LAP(prof, t, "span write");
          } /* if rb */
       } /* for buf */
    }
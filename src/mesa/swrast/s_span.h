@@ -47,6 +47,7 @@
 #define SPAN_MASK       0x20  /**< was array.mask[] filled in by caller? */
 #define SPAN_LAMBDA     0x40  /**< array.lambda[] valid? */
 #define SPAN_COVERAGE   0x80  /**< array.coverage[] valid? */
+#define SPAN_TEXTURED   0x100 /**< arrayMask: rgba[] already textured */
 /*@}*/
 
 
@@ -57,6 +58,8 @@
  * These will either be computed from the span x/xStep values or
  * filled in by glDraw/CopyPixels, etc.
  * These arrays are separated out of sw_span to conserve memory.
+ * They only hold MAX_SPAN_WIDTH fragments; longer spans are processed
+ * in pieces (see _swrast_span_advance()).
  */
 typedef struct sw_span_arrays
 {
@@ -64,24 +67,24 @@ typedef struct sw_span_arrays
    /* XXX someday look at transposing first two indexes for better memory
     * access pattern.
     */
-   GLfloat attribs[FRAG_ATTRIB_MAX][MAX_WIDTH][4];
+   GLfloat attribs[FRAG_ATTRIB_MAX][MAX_SPAN_WIDTH][4];
 
    /** This mask indicates which fragments are alive or culled */
-   GLubyte mask[MAX_WIDTH];
+   GLubyte mask[MAX_SPAN_WIDTH];
 
    GLenum ChanType; /**< Color channel type, GL_UNSIGNED_BYTE, GL_FLOAT */
 
    /** Attribute arrays that don't fit into attribs[] array above */
    /*@{*/
-   GLubyte rgba8[MAX_WIDTH][4];
-   GLushort rgba16[MAX_WIDTH][4];
+   GLubyte rgba8[MAX_SPAN_WIDTH][4];
+   GLushort rgba16[MAX_SPAN_WIDTH][4];
    GLchan (*rgba)[4];  /** either == rgba8 or rgba16 */
-   GLint   x[MAX_WIDTH];  /**< fragment X coords */
-   GLint   y[MAX_WIDTH];  /**< fragment Y coords */
-   GLuint  z[MAX_WIDTH];  /**< fragment Z coords */
-   GLuint  index[MAX_WIDTH];  /**< Color indexes */
-   GLfloat lambda[MAX_TEXTURE_COORD_UNITS][MAX_WIDTH]; /**< Texture LOD */
-   GLfloat coverage[MAX_WIDTH];  /**< Fragment coverage for AA/smoothing */
+   GLint   x[MAX_SPAN_WIDTH];  /**< fragment X coords */
+   GLint   y[MAX_SPAN_WIDTH];  /**< fragment Y coords */
+   GLuint  z[MAX_SPAN_WIDTH];  /**< fragment Z coords */
+   GLuint  index[MAX_SPAN_WIDTH];  /**< Color indexes */
+   GLfloat lambda[MAX_TEXTURE_COORD_UNITS][MAX_SPAN_WIDTH]; /**< Texture LOD */
+   GLfloat coverage[MAX_SPAN_WIDTH];  /**< Fragment coverage for AA/smoothing */
    /*@}*/
 } SWspanarrays;
 
@@ -150,8 +153,8 @@ typedef struct sw_span
    /**
     * We store the arrays of fragment values in a separate struct so
     * that we can allocate sw_span structs on the stack without using
-    * a lot of memory.  The span_arrays struct is about 1.4MB while the
-    * sw_span struct is only about 512 bytes.
+    * a lot of memory.  The span_arrays struct is about 100KB while the
+    * sw_span struct is only about 1KB.
     */
    SWspanarrays *array;
 } SWspan;
@@ -166,7 +169,7 @@ do {						\
    (S).arrayAttribs = 0x0;			\
    (S).end = 0;					\
    (S).facing = 0;				\
-   (S).array = SWRAST_CONTEXT(ctx)->SpanArrays;	\
+   (S).array = SWRAST_SPAN_ARRAYS(SWRAST_CONTEXT(ctx));	\
 } while (0)
 
 
@@ -177,6 +180,9 @@ _swrast_span_default_attribs(GLcontext *ctx, SWspan *span);
 extern void
 _swrast_span_interpolate_z( const GLcontext *ctx, SWspan *span );
 
+extern void
+_swrast_span_advance(const GLcontext *ctx, SWspan *span, GLuint n);
+
 extern GLfloat
 _swrast_compute_lambda(GLfloat dsdx, GLfloat dsdy, GLfloat dtdx, GLfloat dtdy,
                        GLfloat dqdx, GLfloat dqdy, GLfloat texW, GLfloat texH,
@@ -186,6 +192,9 @@ extern void
 _swrast_write_index_span( GLcontext *ctx, SWspan *span);
 
 
+extern void
+_swrast_choose_span_writer(GLcontext *ctx);
+
 extern void
 _swrast_write_rgba_span( GLcontext *ctx, SWspan *span);
 
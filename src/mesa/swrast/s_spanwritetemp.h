@@ -0,0 +1,211 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Specialized span writer template.
+ *
+ * This file is #include'd by s_span.c to generate span writers for
+ * the most common combinations of per-fragment state.  Each generated
+ * function does the work of _swrast_write_rgba_span() after clipping,
+ * for 8-bit RGBA colors, without re-examining the GL state.  See
+ * _swrast_choose_span_writer() for the conditions under which they
+ * may be used.
+ *
+ * The following macros may be defined:
+ *    NAME          - REQUIRED: name of the generated function
+ *    DEPTH_TYPE    - GLushort or GLuint; if defined, do depth testing
+ *                    against a directly addressable depth buffer
+ *    DEPTH_TEST(Z, ZBUF) - the depth comparison (only with DEPTH_TYPE)
+ *    DEPTH_SHIFT   - if defined, the span's Z values are fixed point
+ *                    and need to be shifted (16-bit depth buffers)
+ *    BLEND_TRANSPARENCY - if defined, do glBlendFunc(GL_SRC_ALPHA,
+ *                    GL_ONE_MINUS_SRC_ALPHA) blending
+ *
+ * The generated function returns GL_FALSE, without touching the span,
+ * if the depth buffer can't be addressed directly.  The caller then
+ * takes the generic path.
+ */
+
+
+static GLboolean
+NAME(GLcontext *ctx, SWspan *span)
+{
+   struct gl_framebuffer *fb = ctx->DrawBuffer;
+   struct gl_renderbuffer *rb = fb->_ColorDrawBuffers[0];
+   const GLint x = span->x;
+   const GLint y = span->y;
+   GLubyte *mask = span->array->mask;
+   GLubyte (*rgba)[4];
+   GLubyte (*dst)[4];
+   GLuint n, i;
+
+#ifdef DEPTH_TYPE
+   {
+      struct gl_renderbuffer *zrb = fb->_DepthBuffer;
+      DEPTH_TYPE *zbuffer = (DEPTH_TYPE *) zrb->GetPointer(ctx, zrb, x, y);
+      const GLint zStep = span->zStep;
+#ifdef DEPTH_SHIFT
+      GLfixed zval = span->z;
+#else
+      GLuint zval = span->z;
+#endif
+      GLuint passed = 0;
+      GLuint zLow = ~0u;   /* lowest value written */
+
+      if (!zbuffer)
+         return GL_FALSE;
+
+      /* Interpolate and test Z in one pass */
+      n = span->end;
+      if (ctx->Depth.Mask) {
+         for (i = 0; i < n; i++) {
+#ifdef DEPTH_SHIFT
+            const GLuint z = FixedToInt(zval);
+#else
+            const GLuint z = zval;
+#endif
+            if (mask[i]) {
+               if (DEPTH_TEST(z, zbuffer[i])) {
+                  zbuffer[i] = (DEPTH_TYPE) z;
+                  if (z < zLow)
+                     zLow = z;
+                  passed++;
+               }
+               else {
+                  mask[i] = 0;
+               }
+            }
+            zval += zStep;
+         }
+         /* The LESS/LEQUAL tests only lower the depth values, so the
+          * upper bounds of the depth tiles remain valid.
+          */
+         if (zrb->DepthTiles && passed)
+            _swrast_hiz_rect_written(zrb, x, y, n, 1, zLow, zLow);
+      }
+      else {
+         for (i = 0; i < n; i++) {
+#ifdef DEPTH_SHIFT
+            const GLuint z = FixedToInt(zval);
+#else
+            const GLuint z = zval;
+#endif
+            if (mask[i]) {
+               if (DEPTH_TEST(z, zbuffer[i]))
+                  passed++;
+               else
+                  mask[i] = 0;
+            }
+            zval += zStep;
+         }
+      }
+
+      if (passed == 0)
+         return GL_TRUE;
+      if (passed < n)
+         span->writeAll = GL_FALSE;
+   }
+#endif
+
+   /* Texturing was deferred until after the depth test */
+   if (ctx->Texture._EnabledUnits && !(span->arrayMask & SPAN_TEXTURED))
+      shade_texture_span(ctx, span);
+
+   if ((span->arrayMask & SPAN_RGBA) == 0)
+      interpolate_int_colors(ctx, span);
+
+   ASSERT(span->array->ChanType == GL_UNSIGNED_BYTE);
+   ASSERT(rb->DataType == GL_UNSIGNED_BYTE);
+
+   n = span->end;
+   rgba = (GLubyte (*)[4]) span->array->rgba;
+   dst = (GLubyte (*)[4]) rb->GetPointer(ctx, rb, x, y);
+
+   if (dst) {
+      /* Blend and store straight into the color buffer */
+#ifdef BLEND_TRANSPARENCY
+      for (i = 0; i < n; i++) {
+         if (mask[i]) {
+            const GLint t = rgba[i][ACOMP];
+            if (t == 255) {
+               COPY_4UBV(dst[i], rgba[i]);
+            }
+            else if (t != 0) {
+               GLint divtemp;
+               dst[i][RCOMP] = (GLubyte) (DIV255((rgba[i][RCOMP] - dst[i][RCOMP]) * t) + dst[i][RCOMP]);
+               dst[i][GCOMP] = (GLubyte) (DIV255((rgba[i][GCOMP] - dst[i][GCOMP]) * t) + dst[i][GCOMP]);
+               dst[i][BCOMP] = (GLubyte) (DIV255((rgba[i][BCOMP] - dst[i][BCOMP]) * t) + dst[i][BCOMP]);
+               dst[i][ACOMP] = (GLubyte) (DIV255((rgba[i][ACOMP] - dst[i][ACOMP]) * t) + dst[i][ACOMP]);
+            }
+         }
+      }
+#else
+      if (span->writeAll) {
+         _mesa_memcpy(dst, rgba, 4 * n * sizeof(GLubyte));
+      }
+      else {
+         for (i = 0; i < n; i++) {
+            if (mask[i]) {
+               COPY_4UBV(dst[i], rgba[i]);
+            }
+         }
+      }
+#endif
+   }
+   else {
+#ifdef BLEND_TRANSPARENCY
+      /* use the specular color array for the destination colors, as
+       * _swrast_get_dest_rgba() does
+       */
+      GLubyte (*dest)[4] = (GLubyte (*)[4]) span->array->attribs[FRAG_ATTRIB_COL1];
+      rb->GetRow(ctx, rb, n, x, y, dest);
+      for (i = 0; i < n; i++) {
+         if (mask[i]) {
+            const GLint t = rgba[i][ACOMP];
+            if (t == 0) {
+               COPY_4UBV(rgba[i], dest[i]);
+            }
+            else if (t != 255) {
+               GLint divtemp;
+               rgba[i][RCOMP] = (GLubyte) (DIV255((rgba[i][RCOMP] - dest[i][RCOMP]) * t) + dest[i][RCOMP]);
+               rgba[i][GCOMP] = (GLubyte) (DIV255((rgba[i][GCOMP] - dest[i][GCOMP]) * t) + dest[i][GCOMP]);
+               rgba[i][BCOMP] = (GLubyte) (DIV255((rgba[i][BCOMP] - dest[i][BCOMP]) * t) + dest[i][BCOMP]);
+               rgba[i][ACOMP] = (GLubyte) (DIV255((rgba[i][ACOMP] - dest[i][ACOMP]) * t) + dest[i][ACOMP]);
+            }
+         }
+      }
+#endif
+      rb->PutRow(ctx, rb, n, x, y, rgba, span->writeAll ? NULL : mask);
+   }
+
+   return GL_TRUE;
+}
+
+
+#undef NAME
+#undef DEPTH_TYPE
+#undef DEPTH_TEST
+#undef DEPTH_SHIFT
+#undef BLEND_TRANSPARENCY
@@ -228,13 +228,13 @@ static GLboolean
 do_stencil_test( GLcontext *ctx, GLuint face, GLuint n, GLstencil stencil[],
                  GLubyte mask[] )
 {
-   GLubyte fail[MAX_WIDTH];
+   GLubyte fail[MAX_SPAN_WIDTH];
    GLboolean allfail = GL_FALSE;
    GLuint i;
    GLstencil r, s;
    const GLuint valueMask = ctx->Stencil.ValueMask[face];
 
-   ASSERT(n <= MAX_WIDTH);
+   ASSERT(n <= MAX_SPAN_WIDTH);
 
    /*
     * Perform stencil test.  The results of this operation are stored
@@ -427,7 +427,7 @@ stencil_and_ztest_span(GLcontext *ctx, SWspan *span, GLuint face)
 {
    struct gl_framebuffer *fb = ctx->DrawBuffer;
    struct gl_renderbuffer *rb = fb->_StencilBuffer;
-   GLstencil stencilRow[MAX_WIDTH];
+   GLstencil stencilRow[MAX_SPAN_WIDTH];
    GLstencil *stencil;
    const GLuint n = span->end;
    const GLint x = span->x;
@@ -436,7 +436,7 @@ stencil_and_ztest_span(GLcontext *ctx, SWspan *span, GLuint face)
 
    ASSERT((span->arrayMask & SPAN_XY) == 0);
    ASSERT(ctx->Stencil.Enabled);
-   ASSERT(n <= MAX_WIDTH);
+   ASSERT(n <= MAX_SPAN_WIDTH);
 #ifdef DEBUG
    if (ctx->Depth.Test) {
       ASSERT(span->arrayMask & SPAN_Z);
@@ -477,7 +477,7 @@ stencil_and_ztest_span(GLcontext *ctx, SWspan *span, GLuint face)
       /*
        * Perform depth buffering, then apply zpass or zfail stencil function.
        */
-      GLubyte passMask[MAX_WIDTH], failMask[MAX_WIDTH], origMask[MAX_WIDTH];
+      GLubyte passMask[MAX_SPAN_WIDTH], failMask[MAX_SPAN_WIDTH], origMask[MAX_SPAN_WIDTH];
 
       /* save the current mask bits */
       _mesa_memcpy(origMask, mask, n * sizeof(GLubyte));
@@ -708,7 +708,7 @@ stencil_test_pixels( GLcontext *ctx, GLuint face, GLuint n,
 {
    const struct gl_framebuffer *fb = ctx->DrawBuffer;
    struct gl_renderbuffer *rb = fb->_StencilBuffer;
-   GLubyte fail[MAX_WIDTH];
+   GLubyte fail[MAX_SPAN_WIDTH];
    GLstencil r, s;
    GLuint i;
    GLboolean allfail = GL_FALSE;
@@ -904,7 +904,7 @@ stencil_test_pixels( GLcontext *ctx, GLuint face, GLuint n,
 static GLboolean
 stencil_and_ztest_pixels( GLcontext *ctx, SWspan *span, GLuint face )
 {
-   GLubyte passMask[MAX_WIDTH], failMask[MAX_WIDTH], origMask[MAX_WIDTH];
+   GLubyte passMask[MAX_SPAN_WIDTH], failMask[MAX_SPAN_WIDTH], origMask[MAX_SPAN_WIDTH];
    struct gl_framebuffer *fb = ctx->DrawBuffer;
    struct gl_renderbuffer *rb = fb->_StencilBuffer;
    const GLuint n = span->end;
@@ -914,11 +914,11 @@ stencil_and_ztest_pixels( GLcontext *ctx, SWspan *span, GLuint face )
 
    ASSERT(span->arrayMask & SPAN_XY);
    ASSERT(ctx->Stencil.Enabled);
-   ASSERT(n <= MAX_WIDTH);
+   ASSERT(n <= MAX_SPAN_WIDTH);
 
    if (!rb->GetPointer(ctx, rb, 0, 0)) {
       /* No direct access */
-      GLstencil stencil[MAX_WIDTH];
+      GLstencil stencil[MAX_SPAN_WIDTH];
 
       ASSERT(rb->DataType == GL_UNSIGNED_BYTE);
       _swrast_get_values(ctx, rb, n, x, y, stencil, sizeof(GLubyte));
@@ -932,7 +932,7 @@ stencil_and_ztest_pixels( GLcontext *ctx, SWspan *span, GLuint face )
                           n, stencil, mask);
       }
       else {
-         GLubyte tmpMask[MAX_WIDTH]; 
+         GLubyte tmpMask[MAX_SPAN_WIDTH]; 
          _mesa_memcpy(tmpMask, mask, n * sizeof(GLubyte));
 
          _swrast_depth_test_span(ctx, span);
@@ -33,6 +33,7 @@
 
 #include "s_context.h"
 #include "s_texcombine.h"
+#include "s_texfilter.h"
 
 
 #define PROD(A,B)   ( (GLuint)(A) * ((GLuint)(B)+1) )
@@ -80,7 +81,7 @@ texture_combine( const GLcontext *ctx, GLuint unit, GLuint n,
    static const GLchan zero[4] = { 0, 0, 0, 0 };
    const GLuint numColorArgs = textureUnit->_CurrentCombine->_NumArgsRGB;
    const GLuint numAlphaArgs = textureUnit->_CurrentCombine->_NumArgsA;
-   GLchan ccolor[3][MAX_WIDTH][4];
+   GLchan ccolor[3][MAX_SPAN_WIDTH][4];
    GLuint i, j;
 
    ASSERT(ctx->Extensions.EXT_texture_env_combine ||
@@ -1077,10 +1078,11 @@ void
 _swrast_texture_span( GLcontext *ctx, SWspan *span )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
-   GLchan primary_rgba[MAX_WIDTH][4];
+   GLchan *texelBuffer = SWRAST_TEXEL_BUFFER(swrast);
+   GLchan primary_rgba[MAX_SPAN_WIDTH][4];
    GLuint unit;
 
-   ASSERT(span->end < MAX_WIDTH);
+   ASSERT(span->end <= MAX_SPAN_WIDTH);
 
    /*
     * Save copy of the incoming fragment colors (the GL_PRIMARY_COLOR)
@@ -1101,7 +1103,7 @@ _swrast_texture_span( GLcontext *ctx, SWspan *span )
          const struct gl_texture_object *curObj = texUnit->_Current;
          GLfloat *lambda = span->array->lambda[unit];
          GLchan (*texels)[4] = (GLchan (*)[4])
-            (swrast->TexelBuffer + unit * (span->end * 4 * sizeof(GLchan)));
+            (texelBuffer + unit * (span->end * 4 * sizeof(GLchan)));
 
          /* adjust texture lod (lambda) */
          if (span->arrayMask & SPAN_LAMBDA) {
@@ -1129,8 +1131,31 @@ _swrast_texture_span( GLcontext *ctx, SWspan *span )
          }
 
          /* Sample the texture (span->end = number of fragments) */
-         swrast->TextureSample[unit]( ctx, texUnit->_Current, span->end,
-                                      texcoords, lambda, texels );
+         if ((span->arrayMask & SPAN_LAMBDA) &&
+             curObj->MinFilter != curObj->MagFilter) {
+            /* Lambda isn't always monotonic along the span, so choose
+             * between the min and mag filters per fragment by sampling
+             * runs which are all minified or all magnified.  Otherwise
+             * the result would depend on where spans are split.
+             */
+            const GLfloat minMagThresh = _swrast_min_mag_threshold(curObj);
+            GLuint start = 0, i;
+            while (start < span->end) {
+               const GLboolean minified = lambda[start] > minMagThresh;
+               for (i = start + 1; i < span->end; i++) {
+                  if ((lambda[i] > minMagThresh) != minified)
+                     break;
+               }
+               swrast->TextureSample[unit]( ctx, curObj, i - start,
+                                            texcoords + start, lambda + start,
+                                            texels + start );
+               start = i;
+            }
+         }
+         else {
+            swrast->TextureSample[unit]( ctx, texUnit->_Current, span->end,
+                                         texcoords, lambda, texels );
+         }
 
          /* GL_SGI_texture_color_table */
          if (texUnit->ColorTableEnabled) {
@@ -1155,13 +1180,13 @@ _swrast_texture_span( GLcontext *ctx, SWspan *span )
          if (texUnit->_CurrentCombine != &texUnit->_EnvMode ) {
             texture_combine( ctx, unit, span->end,
                              (CONST GLchan (*)[4]) primary_rgba,
-                             swrast->TexelBuffer,
+                             texelBuffer,
                              span->array->rgba );
          }
          else {
             /* conventional texture blend */
             const GLchan (*texels)[4] = (const GLchan (*)[4])
-               (swrast->TexelBuffer + unit *
+               (texelBuffer + unit *
                 (span->end * 4 * sizeof(GLchan)));
             texture_apply( ctx, texUnit, span->end,
                            (CONST GLchan (*)[4]) primary_rgba, texels,
@@ -27,6 +27,7 @@
 #include "main/context.h"
 #include "main/colormac.h"
 #include "main/imports.h"
+#include "main/texcompress.h"
 #include "main/texformat.h"
 
 #include "s_context.h"
@@ -551,10 +552,31 @@ nearest_mipmap_level(const struct gl_texture_object *tObj, GLfloat lambda)
 
 
 
+/**
+ * Return the lambda value at or below which the texture is magnified.
+ */
+GLfloat
+_swrast_min_mag_threshold(const struct gl_texture_object *tObj)
+{
+   /* This bit comes from the OpenGL spec: */
+   if (tObj->MagFilter == GL_LINEAR
+       && (tObj->MinFilter == GL_NEAREST_MIPMAP_NEAREST ||
+           tObj->MinFilter == GL_NEAREST_MIPMAP_LINEAR)) {
+      return 0.5F;
+   }
+   else {
+      return 0.0F;
+   }
+}
+
+
 /**
  * The lambda[] array values are always monotonic.  Either the whole span
  * will be minified, magnified, or split between the two.  This function
  * determines the subranges in [0, n-1] that are to be minified or magnified.
+ * Callers which can't rely on that (lambda has a minimum inside spans of
+ * some perspective triangles) only pass runs which are all minified or all
+ * magnified, see _swrast_texture_span().
  */
 static INLINE void
 compute_min_mag_ranges(const struct gl_texture_object *tObj,
@@ -562,21 +584,11 @@ compute_min_mag_ranges(const struct gl_texture_object *tObj,
                        GLuint *minStart, GLuint *minEnd,
                        GLuint *magStart, GLuint *magEnd)
 {
-   GLfloat minMagThresh;
+   const GLfloat minMagThresh = _swrast_min_mag_threshold(tObj);
 
    /* we shouldn't be here if minfilter == magfilter */
    ASSERT(tObj->MinFilter != tObj->MagFilter);
 
-   /* This bit comes from the OpenGL spec: */
-   if (tObj->MagFilter == GL_LINEAR
-       && (tObj->MinFilter == GL_NEAREST_MIPMAP_NEAREST ||
-           tObj->MinFilter == GL_NEAREST_MIPMAP_LINEAR)) {
-      minMagThresh = 0.5F;
-   }
-   else {
-      minMagThresh = 0.0F;
-   }
-
 #if 0
    /* DEBUG CODE: Verify that lambda[] is monotonic.
     * We can't really use this because the inaccuracy in the LOG2 function
@@ -1162,6 +1174,304 @@ sample_2d_linear_mipmap_linear_repeat(GLcontext *ctx,
 }
 
 
+/**
+ * Number of samples computed together by the linear span samplers below.
+ */
+#define LINEAR_BATCH 8
+
+
+/**
+ * Can the texture image be sampled with the linear span samplers?
+ * They handle 8-bit RGBA, RGB565 and DXT images without border, wrapped
+ * with GL_REPEAT or GL_CLAMP_TO_EDGE.
+ */
+static GLboolean
+linear_span_supported(const struct gl_texture_object *tObj,
+                      const struct gl_texture_image *img)
+{
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+   if (img->Border != 0)
+      return GL_FALSE;
+   if (tObj->WrapS != GL_REPEAT && tObj->WrapS != GL_CLAMP_TO_EDGE)
+      return GL_FALSE;
+   if (tObj->WrapT != GL_REPEAT && tObj->WrapT != GL_CLAMP_TO_EDGE)
+      return GL_FALSE;
+   switch (img->TexFormat->MesaFormat) {
+   case MESA_FORMAT_RGBA:
+   case MESA_FORMAT_RGBA8888:
+   case MESA_FORMAT_RGB565:
+      return GL_TRUE;
+#if FEATURE_texture_s3tc
+   case MESA_FORMAT_RGB_DXT1:
+   case MESA_FORMAT_RGBA_DXT1:
+   case MESA_FORMAT_RGBA_DXT3:
+   case MESA_FORMAT_RGBA_DXT5:
+      return GL_TRUE;
+#endif
+   default:
+      return GL_FALSE;
+   }
+#else
+   /* the span samplers do lerp_rgba_2d()'s 8-bit fixed point math */
+   return GL_FALSE;
+#endif
+}
+
+
+/**
+ * Compute texel locations and fixed point weights for linear sampling of
+ * n texcoords (component comp) at once.  Same results as
+ * linear_texel_locations() for GL_REPEAT and GL_CLAMP_TO_EDGE.
+ */
+static INLINE void
+linear_span_locations(GLenum wrapMode, GLint size, GLuint n,
+                      const GLfloat texcoords[][4], GLuint comp,
+                      GLint i0[], GLint i1[], GLint weight[])
+{
+   GLuint k;
+
+   if (wrapMode == GL_REPEAT) {
+      if ((size & (size - 1)) == 0) {
+         for (k = 0; k < n; k++) {
+            const GLfloat u = texcoords[k][comp] * size - 0.5F;
+            const GLint flr = IFLOOR(u);
+            i0[k] = flr & (size - 1);
+            i1[k] = (i0[k] + 1) & (size - 1);
+            weight[k] = IROUND_POS((u - flr) * ILERP_SCALE);
+         }
+      }
+      else {
+         for (k = 0; k < n; k++) {
+            const GLfloat u = texcoords[k][comp] * size - 0.5F;
+            const GLint flr = IFLOOR(u);
+            i0[k] = REMAINDER(flr, size);
+            i1[k] = REMAINDER(i0[k] + 1, size);
+            weight[k] = IROUND_POS((u - flr) * ILERP_SCALE);
+         }
+      }
+   }
+   else {
+      ASSERT(wrapMode == GL_CLAMP_TO_EDGE);
+      for (k = 0; k < n; k++) {
+         const GLfloat s = texcoords[k][comp];
+         GLfloat u;
+         GLint flr;
+         if (s <= 0.0F)
+            u = 0.0F;
+         else if (s >= 1.0F)
+            u = (GLfloat) size;
+         else
+            u = s * size;
+         u -= 0.5F;
+         flr = IFLOOR(u);
+         i0[k] = MAX2(flr, 0);
+         i1[k] = MIN2(flr + 1, size - 1);
+         weight[k] = IROUND_POS((u - flr) * ILERP_SCALE);
+      }
+   }
+}
+
+
+/**
+ * Load the texels at (i[k], j[k]) and unpack them to one array per
+ * color component.
+ */
+static INLINE void
+fetch_span_texels(const struct gl_texture_image *img, GLuint n,
+                  const GLint i[], const GLint j[],
+                  GLint texel[4][LINEAR_BATCH])
+{
+   const GLint rowStride = img->RowStride;
+   GLuint k;
+
+   switch (img->TexFormat->MesaFormat) {
+   case MESA_FORMAT_RGBA8888:
+      {
+         const GLuint *data = (const GLuint *) img->Data;
+         for (k = 0; k < n; k++) {
+            const GLuint s = data[j[k] * rowStride + i[k]];
+            texel[RCOMP][k] = (s >> 24);
+            texel[GCOMP][k] = (s >> 16) & 0xff;
+            texel[BCOMP][k] = (s >>  8) & 0xff;
+            texel[ACOMP][k] = (s      ) & 0xff;
+         }
+      }
+      break;
+   case MESA_FORMAT_RGB565:
+      {
+         const GLushort *data = (const GLushort *) img->Data;
+         for (k = 0; k < n; k++) {
+            const GLushort s = data[j[k] * rowStride + i[k]];
+            texel[RCOMP][k] = ((s >> 8) & 0xf8) | ((s >> 13) & 0x7);
+            texel[GCOMP][k] = ((s >> 3) & 0xfc) | ((s >>  9) & 0x3);
+            texel[BCOMP][k] = ((s << 3) & 0xf8) | ((s >>  2) & 0x7);
+            texel[ACOMP][k] = CHAN_MAX;
+         }
+      }
+      break;
+#if FEATURE_texture_s3tc
+   case MESA_FORMAT_RGB_DXT1:
+   case MESA_FORMAT_RGBA_DXT1:
+   case MESA_FORMAT_RGBA_DXT3:
+   case MESA_FORMAT_RGBA_DXT5:
+      {
+         /* whole blocks are decoded into a cache, see texcompress_s3tc.c */
+         GLubyte s[LINEAR_BATCH][4];
+         _mesa_fetch_dxtn_texels(img, n, i, j, s);
+         for (k = 0; k < n; k++) {
+            texel[RCOMP][k] = s[k][RCOMP];
+            texel[GCOMP][k] = s[k][GCOMP];
+            texel[BCOMP][k] = s[k][BCOMP];
+            texel[ACOMP][k] = s[k][ACOMP];
+         }
+      }
+      break;
+#endif
+   default:
+      {
+         const GLchan *data = (const GLchan *) img->Data;
+         ASSERT(img->TexFormat->MesaFormat == MESA_FORMAT_RGBA);
+         for (k = 0; k < n; k++) {
+            const GLchan *s = data + 4 * (j[k] * rowStride + i[k]);
+            texel[0][k] = s[0];
+            texel[1][k] = s[1];
+            texel[2][k] = s[2];
+            texel[3][k] = s[3];
+         }
+      }
+   }
+}
+
+
+/**
+ * Bilinear sampling of a span of texcoords from one image, see
+ * linear_span_supported().  The texel addresses, fetches and the
+ * interpolation are each done for LINEAR_BATCH samples at a time in
+ * simple loops which the compiler can vectorize.  The results match
+ * sample_2d_linear() exactly.
+ */
+static void
+sample_2d_linear_span(const struct gl_texture_object *tObj,
+                      const struct gl_texture_image *img,
+                      GLuint n, const GLfloat texcoords[][4],
+                      GLchan rgba[][4])
+{
+   const GLint width = img->Width2;
+   const GLint height = img->Height2;
+   GLint i0[LINEAR_BATCH], i1[LINEAR_BATCH], ia[LINEAR_BATCH];
+   GLint j0[LINEAR_BATCH], j1[LINEAR_BATCH], ib[LINEAR_BATCH];
+   GLint t00[4][LINEAR_BATCH], t10[4][LINEAR_BATCH];
+   GLint t01[4][LINEAR_BATCH], t11[4][LINEAR_BATCH];
+   GLuint start, c, k;
+
+   ASSERT(linear_span_supported(tObj, img));
+
+   for (start = 0; start < n; start += LINEAR_BATCH) {
+      const GLuint m = MIN2(n - start, LINEAR_BATCH);
+
+      linear_span_locations(tObj->WrapS, width, m, texcoords + start, 0,
+                            i0, i1, ia);
+      linear_span_locations(tObj->WrapT, height, m, texcoords + start, 1,
+                            j0, j1, ib);
+
+      fetch_span_texels(img, m, i0, j0, t00);
+      fetch_span_texels(img, m, i1, j0, t10);
+      fetch_span_texels(img, m, i0, j1, t01);
+      fetch_span_texels(img, m, i1, j1, t11);
+
+      for (c = 0; c < 4; c++) {
+         for (k = 0; k < m; k++) {
+            rgba[start + k][c] = (GLchan) ilerp_2d(ia[k], ib[k],
+                                                   t00[c][k], t10[c][k],
+                                                   t01[c][k], t11[c][k]);
+         }
+      }
+   }
+}
+
+
+/**
+ * Bilinear sampling of a span from one image, using the span sampler
+ * if possible.
+ */
+static void
+sample_2d_linear_image(GLcontext *ctx,
+                       const struct gl_texture_object *tObj,
+                       const struct gl_texture_image *img,
+                       GLuint n, const GLfloat texcoords[][4],
+                       GLchan rgba[][4])
+{
+   if (linear_span_supported(tObj, img)) {
+      sample_2d_linear_span(tObj, img, n, texcoords, rgba);
+   }
+   else {
+      GLuint i;
+      for (i = 0; i < n; i++)
+         sample_2d_linear(ctx, tObj, img, texcoords[i], rgba[i]);
+   }
+}
+
+
+/**
+ * Optimized 2-D texture sampling:
+ *    GL_LINEAR min/mag filter
+ *    S and T wrap mode == GL_REPEAT or GL_CLAMP_TO_EDGE
+ *    No border
+ *    Format = RGBA8888, RGB565 or 8-bit GL_RGBA
+ */
+static void
+opt_sample_linear_2d(GLcontext *ctx,
+                     const struct gl_texture_object *tObj,
+                     GLuint n, const GLfloat texcoords[][4],
+                     const GLfloat lambda[], GLchan rgba[][4])
+{
+   (void) ctx;
+   (void) lambda;
+   sample_2d_linear_span(tObj, tObj->Image[0][tObj->BaseLevel],
+                         n, texcoords, rgba);
+}
+
+
+/**
+ * GL_LINEAR_MIPMAP_LINEAR sampling using the linear span samplers.
+ * Runs of samples which use the same pair of mipmap levels are sampled
+ * together.  Same results as sample_2d_linear_mipmap_linear().
+ */
+static void
+opt_sample_2d_linear_mipmap_linear(GLcontext *ctx,
+                                   const struct gl_texture_object *tObj,
+                                   GLuint n, const GLfloat texcoord[][4],
+                                   const GLfloat lambda[], GLchan rgba[][4])
+{
+   GLchan t0[LINEAR_BATCH][4], t1[LINEAR_BATCH][4];  /* texels */
+   GLuint i = 0, k;
+   ASSERT(lambda != NULL);
+
+   while (i < n) {
+      const GLint level = linear_mipmap_level(tObj, lambda[i]);
+      GLuint m = 1;
+      while (m < LINEAR_BATCH && i + m < n &&
+             linear_mipmap_level(tObj, lambda[i + m]) == level)
+         m++;
+
+      if (level >= tObj->_MaxLevel) {
+         sample_2d_linear_image(ctx, tObj, tObj->Image[0][tObj->_MaxLevel],
+                                m, texcoord + i, rgba + i);
+      }
+      else {
+         sample_2d_linear_image(ctx, tObj, tObj->Image[0][level],
+                                m, texcoord + i, t0);
+         sample_2d_linear_image(ctx, tObj, tObj->Image[0][level + 1],
+                                m, texcoord + i, t1);
+         for (k = 0; k < m; k++)
+            lerp_rgba(rgba[i + k], FRAC(lambda[i + k]), t0[k], t1[k]);
+      }
+
+      i += m;
+   }
+}
+
+
 /** Sample 2D texture, nearest filtering for both min/magnification */
 static void
 sample_nearest_2d(GLcontext *ctx,
@@ -1188,10 +1498,13 @@ sample_linear_2d(GLcontext *ctx,
    GLuint i;
    struct gl_texture_image *image = tObj->Image[0][tObj->BaseLevel];
    (void) lambda;
-   if (tObj->WrapS == GL_REPEAT &&
-       tObj->WrapT == GL_REPEAT &&
-       image->_IsPowerOfTwo &&
-       image->Border == 0) {
+   if (linear_span_supported(tObj, image)) {
+      sample_2d_linear_span(tObj, image, n, texcoords, rgba);
+   }
+   else if (tObj->WrapS == GL_REPEAT &&
+            tObj->WrapT == GL_REPEAT &&
+            image->_IsPowerOfTwo &&
+            image->Border == 0) {
       for (i = 0; i < n; i++) {
          sample_2d_linear_repeat(ctx, tObj, image, texcoords[i], rgba[i]);
       }
@@ -1348,7 +1661,10 @@ sample_lambda_2d(GLcontext *ctx,
                                          lambda + minStart, rgba + minStart);
          break;
       case GL_LINEAR_MIPMAP_LINEAR:
-         if (repeatNoBorderPOT)
+         if (linear_span_supported(tObj, tImg))
+            opt_sample_2d_linear_mipmap_linear(ctx, tObj, m,
+                  texcoords + minStart, lambda + minStart, rgba + minStart);
+         else if (repeatNoBorderPOT)
             sample_2d_linear_mipmap_linear_repeat(ctx, tObj, m,
                   texcoords + minStart, lambda + minStart, rgba + minStart);
          else
@@ -3316,6 +3632,8 @@ _swrast_choose_texture_sample_func( GLcontext *ctx,
             return &sample_lambda_2d;
          }
          else if (t->MinFilter == GL_LINEAR) {
+            if (linear_span_supported(t, t->Image[0][t->BaseLevel]))
+               return &opt_sample_linear_2d;
             return &sample_linear_2d;
          }
          else {
@@ -34,5 +34,8 @@ extern texture_sample_func
 _swrast_choose_texture_sample_func( GLcontext *ctx,
 				    const struct gl_texture_object *tObj );
 
+extern GLfloat
+_swrast_min_mag_threshold(const struct gl_texture_object *tObj);
+
 
 #endif
@@ -0,0 +1,424 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Binned, multithreaded triangle rasterization.
+ *
+ * When enabled with MESA_SWRAST_THREADS=n (n > 1), triangles aren't drawn
+ * right away.  Their vertices are queued and each triangle is put into
+ * the bins of the horizontal screen bands (SWRAST_TILE_ROWS scanlines
+ * high) that it touches.  When the queue is flushed the bands are handed
+ * out to a pool of threads.  Each thread draws the triangles of a band,
+ * in submission order, with the regular triangle function which only
+ * emits the spans that fall inside the band (see s_tritemp.h).  Since
+ * each span is drawn entirely by one thread the results are identical to
+ * single-threaded rendering.
+ *
+ * The queue is flushed at the end of each rendering batch
+ * (_swrast_render_finish), before any point or line is drawn, and
+ * whenever it fills up.
+ */
+
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/profile.h"
+#include "main/threadpool.h"
+#include "glapi/glthread.h"
+
+#include "s_blend.h"
+#include "s_context.h"
+#include "s_tile.h"
+
+
+/** Max number of triangles queued before the bins are flushed */
+#define TILE_MAX_TRIS 1024
+
+
+/**
+ * List of the queued triangles which touch one screen band.
+ */
+struct tile_bin {
+   GLuint *Tris;        /**< triangle indexes, in submission order */
+   GLuint Count;
+   GLuint Size;         /**< allocated size of Tris */
+};
+
+
+struct swrast_tiler {
+   struct _mesa_threadpool *Pool;
+   GLuint NumThreads;
+   SWthread *Threads;          /**< per-thread state, [NumThreads] */
+
+   swrast_tri_func Func;       /**< draws the queued triangles */
+   const char *FuncName;       /**< its name, for the profiler */
+   SWvertex *Verts;            /**< three per queued triangle */
+   GLuint NumTris;
+
+   struct tile_bin Bins[SWRAST_MAX_TILES];
+   GLuint Tasks[SWRAST_MAX_TILES];  /**< non-empty bins, while flushing */
+};
+
+
+/** Identifies the SWthread of the calling thread */
+static _glthread_TSD ThreadTSD;
+
+
+/**
+ * Return the per-thread rasterization state of the calling thread.
+ * Only valid while swrast->_TileActive is set.
+ */
+SWthread *
+_swrast_tile_thread(void)
+{
+   return (SWthread *) _glthread_GetTSD(&ThreadTSD);
+}
+
+
+static void
+free_tiler(struct swrast_tiler *tiler)
+{
+   GLuint i;
+
+   _mesa_threadpool_destroy(tiler->Pool);
+
+   if (tiler->Threads) {
+      for (i = 0; i < tiler->NumThreads; i++) {
+         if (tiler->Threads[i].SpanArrays)
+            FREE(tiler->Threads[i].SpanArrays);
+         if (tiler->Threads[i].TexelBuffer)
+            FREE(tiler->Threads[i].TexelBuffer);
+         if (tiler->Threads[i].Profile)
+            _mesa_delete_profile(tiler->Threads[i].Profile);
+      }
+      FREE(tiler->Threads);
+   }
+
+   for (i = 0; i < SWRAST_MAX_TILES; i++) {
+      if (tiler->Bins[i].Tris)
+         FREE(tiler->Bins[i].Tris);
+   }
+
+   if (tiler->Verts)
+      _mesa_align_free(tiler->Verts);
+
+   FREE(tiler);
+}
+
+
+/**
+ * Set up binned rendering if MESA_SWRAST_THREADS asks for more than
+ * one thread.  Otherwise, swrast->Tiler stays NULL.
+ */
+void
+_swrast_create_tiler(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLuint numThreads = _mesa_get_thread_count("MESA_SWRAST_THREADS");
+   struct swrast_tiler *tiler;
+   GLuint i;
+
+   if (numThreads < 2)
+      return;
+
+   tiler = CALLOC_STRUCT(swrast_tiler);
+   if (!tiler)
+      return;
+
+   tiler->Pool = _mesa_threadpool_create(numThreads);
+   tiler->NumThreads = _mesa_threadpool_num_threads(tiler->Pool);
+   if (tiler->NumThreads < 2) {
+      /* no thread support */
+      free_tiler(tiler);
+      return;
+   }
+
+   tiler->Verts = (SWvertex *)
+      _mesa_align_malloc(TILE_MAX_TRIS * 3 * sizeof(SWvertex), 16);
+   tiler->Threads = (SWthread *)
+      CALLOC(tiler->NumThreads * sizeof(SWthread));
+   if (!tiler->Verts || !tiler->Threads) {
+      free_tiler(tiler);
+      return;
+   }
+
+   for (i = 0; i < tiler->NumThreads; i++) {
+      SWthread *thread = &tiler->Threads[i];
+      thread->SpanArrays = _swrast_new_span_arrays();
+      thread->TexelBuffer = (GLchan *)
+         MALLOC(ctx->Const.MaxTextureImageUnits * MAX_SPAN_WIDTH * 4 * sizeof(GLchan));
+      if (!thread->SpanArrays || !thread->TexelBuffer) {
+         free_tiler(tiler);
+         return;
+      }
+      if (ctx->Profile) {
+         thread->Profile = _mesa_new_profile();
+         if (!thread->Profile) {
+            free_tiler(tiler);
+            return;
+         }
+      }
+   }
+
+   /* make sure the TSD key gets created here, not racily in a worker */
+   _glthread_SetTSD(&ThreadTSD, NULL);
+
+   swrast->Tiler = tiler;
+}
+
+
+void
+_swrast_destroy_tiler(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (swrast->Tiler) {
+      free_tiler(swrast->Tiler);
+      swrast->Tiler = NULL;
+   }
+}
+
+
+/**
+ * Return the rasterization threads, so that other large operations such
+ * as glReadPixels can split their work into bands of rows too, or NULL
+ * if MESA_SWRAST_THREADS doesn't ask for more than one thread.
+ * Only to be used while no triangles are queued.
+ */
+struct _mesa_threadpool *
+_swrast_get_thread_pool(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_tiler *tiler = swrast->Tiler;
+
+   ASSERT(!tiler || tiler->NumTris == 0);
+   return tiler ? tiler->Pool : NULL;
+}
+
+
+/**
+ * Check if the current state allows triangles to be drawn by the tiler.
+ * Called from _swrast_validate_triangle() after the triangle function
+ * has been chosen.
+ */
+GLboolean
+_swrast_use_tiler(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (!swrast->Tiler)
+      return GL_FALSE;
+
+   /* Anything which accumulates per-fragment results in shared state or
+    * which doesn't go through s_tritemp.h must stay on the calling thread.
+    */
+   if (ctx->RenderMode != GL_RENDER ||
+       ctx->Polygon.SmoothFlag ||
+       ctx->Query.CurrentOcclusionObject)
+      return GL_FALSE;
+
+#if FEATURE_MESA_program_debug
+   if (ctx->FragmentProgram.CallbackEnabled)
+      return GL_FALSE;
+#endif
+
+   if (!swrast->Driver.SpanThreadSafe || !swrast->Driver.SpanThreadSafe(ctx))
+      return GL_FALSE;
+
+   if (ctx->Color.BlendEnabled) {
+      /* The blend function is normally chosen on first use, according to
+       * the renderbuffer's datatype.  Choose it now, before the threads
+       * can race to do it.
+       */
+      const struct gl_framebuffer *fb = ctx->DrawBuffer;
+      GLuint buf;
+      for (buf = 0; buf < fb->_NumColorDrawBuffers; buf++) {
+         if (fb->_ColorDrawBuffers[buf]->DataType != CHAN_TYPE)
+            return GL_FALSE;
+      }
+      _swrast_choose_blend_func(ctx, CHAN_TYPE);
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Draw the triangles of one band.  Called by the thread pool.
+ */
+static void
+render_tile(void *data, GLuint task, GLuint threadIndex)
+{
+   GLcontext *ctx = (GLcontext *) data;
+   struct swrast_tiler *tiler = SWRAST_CONTEXT(ctx)->Tiler;
+   SWthread *thread = &tiler->Threads[threadIndex];
+   const GLuint tile = tiler->Tasks[task];
+   const struct tile_bin *bin = &tiler->Bins[tile];
+   const swrast_tri_func func = tiler->Func;
+   struct gl_profile *prof = thread->Profile;
+   GLuint64EXT t = 0;
+   GLuint i;
+
+   thread->TileYmin = tile * SWRAST_TILE_ROWS;
+   if (tile == SWRAST_MAX_TILES - 1)
+      thread->TileYmax = 0x7fffffff;  /* also catches rows past MAX_HEIGHT */
+   else
+      thread->TileYmax = thread->TileYmin + SWRAST_TILE_ROWS;
+
+   _glthread_SetTSD(&ThreadTSD, thread);
+
+   PROFILE_START(prof, t);
+
+   for (i = 0; i < bin->Count; i++) {
+      const SWvertex *v = tiler->Verts + 3 * bin->Tris[i];
+      func(ctx, v, v + 1, v + 2);
+      PROFILE_LAP(prof, t, tiler->FuncName);
+   }
+}
+
+
+/**
+ * Draw all queued triangles and empty the bins.
+ */
+void
+_swrast_flush_tiles(GLcontext *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_tiler *tiler = swrast->Tiler;
+   struct gl_profile *prof = ctx->Profile;
+   GLuint64EXT t = 0;
+   GLuint numTasks = 0, i;
+
+   if (!tiler || tiler->NumTris == 0)
+      return;
+
+   PROFILE_START(prof, t);
+
+   for (i = 0; i < SWRAST_MAX_TILES; i++) {
+      if (tiler->Bins[i].Count > 0)
+         tiler->Tasks[numTasks++] = i;
+   }
+
+   swrast->_TileActive = GL_TRUE;
+   _mesa_threadpool_run(tiler->Pool, numTasks, render_tile, ctx);
+   swrast->_TileActive = GL_FALSE;
+
+   for (i = 0; i < numTasks; i++)
+      tiler->Bins[tiler->Tasks[i]].Count = 0;
+   tiler->NumTris = 0;
+
+   if (prof) {
+      /* the threads' counts add up to more than the elapsed time */
+      PROFILE_LAP(prof, t, "swrast tile rendering (elapsed)");
+      for (i = 0; i < tiler->NumThreads; i++)
+         _mesa_merge_profile(prof, tiler->Threads[i].Profile);
+   }
+}
+
+
+/**
+ * Add a triangle index to a bin, growing the bin as needed.
+ */
+static GLboolean
+bin_triangle(struct tile_bin *bin, GLuint tri)
+{
+   if (bin->Count == bin->Size) {
+      const GLuint newSize = bin->Size ? bin->Size * 2 : 64;
+      GLuint *tris = (GLuint *)
+         _mesa_realloc(bin->Tris, bin->Size * sizeof(GLuint),
+                       newSize * sizeof(GLuint));
+      if (!tris)
+         return GL_FALSE;
+      bin->Tris = tris;
+      bin->Size = newSize;
+   }
+   bin->Tris[bin->Count++] = tri;
+   return GL_TRUE;
+}
+
+
+/**
+ * Queue a triangle for binned rendering.  Installed as swrast->Triangle
+ * (or swrast->SpecTriangle) by _swrast_validate_triangle(), with the real
+ * triangle function saved in swrast->TileTriangle.
+ */
+void
+_swrast_tile_triangle(GLcontext *ctx, const SWvertex *v0,
+                      const SWvertex *v1, const SWvertex *v2)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_tiler *tiler = swrast->Tiler;
+   GLfloat yMin, yMax;
+   GLint tile0, tile1, tile;
+   GLuint tri;
+   SWvertex *v;
+
+   if (tiler->NumTris == TILE_MAX_TRIS ||
+       (tiler->NumTris > 0 && tiler->Func != swrast->TileTriangle)) {
+      _swrast_flush_tiles(ctx);
+   }
+
+   /* Conservative range of scanlines the triangle may touch */
+   yMin = MIN2(v0->attrib[FRAG_ATTRIB_WPOS][1],
+               v1->attrib[FRAG_ATTRIB_WPOS][1]);
+   yMin = MIN2(yMin, v2->attrib[FRAG_ATTRIB_WPOS][1]);
+   yMax = MAX2(v0->attrib[FRAG_ATTRIB_WPOS][1],
+               v1->attrib[FRAG_ATTRIB_WPOS][1]);
+   yMax = MAX2(yMax, v2->attrib[FRAG_ATTRIB_WPOS][1]);
+
+   if (yMax < 0.0F)
+      return;  /* nothing would be drawn anyway */
+
+   yMin = MAX2(yMin, 0.0F);
+   yMax = MIN2(yMax, (GLfloat) MAX_HEIGHT);
+   tile0 = (IFLOOR(yMin) - 1) / SWRAST_TILE_ROWS;
+   tile1 = (IFLOOR(yMax) + 1) / SWRAST_TILE_ROWS;
+   tile0 = CLAMP(tile0, 0, SWRAST_MAX_TILES - 1);
+   tile1 = CLAMP(tile1, 0, SWRAST_MAX_TILES - 1);
+
+   tri = tiler->NumTris;
+   v = tiler->Verts + 3 * tri;
+   v[0] = *v0;
+   v[1] = *v1;
+   v[2] = *v2;
+
+   for (tile = tile0; tile <= tile1; tile++) {
+      if (!bin_triangle(&tiler->Bins[tile], tri)) {
+         /* out of memory: draw what we have, then this one directly */
+         GLint t;
+         for (t = tile0; t < tile; t++)
+            tiler->Bins[t].Count--;
+         _swrast_flush_tiles(ctx);
+         swrast->TileTriangle(ctx, v0, v1, v2);
+         return;
+      }
+   }
+
+   tiler->Func = swrast->TileTriangle;
+   tiler->FuncName = swrast->_TriangleName;
+   tiler->NumTris++;
+}
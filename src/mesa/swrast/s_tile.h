@@ -0,0 +1,63 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef S_TILE_H
+#define S_TILE_H
+
+
+#include "swrast.h"
+
+
+struct _mesa_threadpool;
+
+
+/** Height of a screen band, in scanlines */
+#define SWRAST_TILE_ROWS 16
+
+/** Number of bands covering MAX_HEIGHT scanlines */
+#define SWRAST_MAX_TILES ((MAX_HEIGHT + SWRAST_TILE_ROWS - 1) / SWRAST_TILE_ROWS)
+
+
+extern void
+_swrast_create_tiler(GLcontext *ctx);
+
+extern void
+_swrast_destroy_tiler(GLcontext *ctx);
+
+extern struct _mesa_threadpool *
+_swrast_get_thread_pool(GLcontext *ctx);
+
+extern GLboolean
+_swrast_use_tiler(GLcontext *ctx);
+
+extern void
+_swrast_tile_triangle(GLcontext *ctx, const SWvertex *v0,
+                      const SWvertex *v1, const SWvertex *v2);
+
+extern void
+_swrast_flush_tiles(GLcontext *ctx);
+
+
+#endif /* S_TILE_H */
@@ -39,6 +39,8 @@
 #include "s_aatriangle.h"
 #include "s_context.h"
 #include "s_feedback.h"
+#include "s_halfspace.h"
+#include "s_hiz.h"
 #include "s_span.h"
 #include "s_triangle.h"
 
@@ -73,6 +75,7 @@ _swrast_culltriangle( GLcontext *ctx,
 #define INTERP_Z 1
 #define INTERP_ATTRIBS 1  /* just for fog */
 #define INTERP_INDEX 1
+#define SPLIT_SPANS 1
 #define RENDER_SPAN( span )  _swrast_write_index_span(ctx, &span);
 #include "s_tritemp.h"
 
@@ -95,6 +98,7 @@ _swrast_culltriangle( GLcontext *ctx,
    span.greenStep = 0;				\
    span.blueStep = 0;				\
    span.alphaStep = 0;
+#define SPLIT_SPANS 1
 #define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
@@ -113,6 +117,7 @@ _swrast_culltriangle( GLcontext *ctx,
       ASSERT(ctx->Texture._EnabledCoordUnits == 0);	\
       ASSERT(ctx->Light.ShadeModel==GL_SMOOTH);	\
    }
+#define SPLIT_SPANS 1
 #define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
@@ -197,6 +202,7 @@ _swrast_culltriangle( GLcontext *ctx,
 #define RENDER_SPAN( span )						\
    GLuint i;				    				\
    GLchan rgb[MAX_WIDTH][3];						\
+   GLubyte mask[MAX_WIDTH];						\
    span.intTex[0] -= FIXED_HALF; /* off-by-one error? */		\
    span.intTex[1] -= FIXED_HALF;					\
    for (i = 0; i < span.end; i++) {					\
@@ -210,16 +216,16 @@ _swrast_culltriangle( GLcontext *ctx,
          rgb[i][GCOMP] = texture[pos+1];				\
          rgb[i][BCOMP] = texture[pos+2];				\
          zRow[i] = z;							\
-         span.array->mask[i] = 1;					\
+         mask[i] = 1;							\
       }									\
       else {								\
-         span.array->mask[i] = 0;					\
+         mask[i] = 0;							\
       }									\
       span.intTex[0] += span.intTexStep[0];				\
       span.intTex[1] += span.intTexStep[1];				\
       span.z += span.zStep;						\
    }									\
-   rb->PutRowRGB(ctx, rb, span.end, span.x, span.y, rgb, span.array->mask);
+   rb->PutRowRGB(ctx, rb, span.end, span.x, span.y, rgb, mask);
 
 #include "s_tritemp.h"
 
@@ -561,6 +567,7 @@ affine_span(GLcontext *ctx, SWspan *span,
    }									\
    info.tsize = obj->Image[0][b]->Height * info.tbytesline;
 
+#define SPLIT_SPANS 1
 #define RENDER_SPAN( span )   affine_span(ctx, &span, &info);
 
 #include "s_tritemp.h"
@@ -648,12 +655,9 @@ fast_persp_span(GLcontext *ctx, SWspan *span,
            dest += 4;							\
 	}
 
-   GLuint i;
+   GLuint i, n, remaining = span->end;
    GLfloat tex_coord[3], tex_step[3];
-   GLchan *dest = span->array->rgba[0];
-
-   const GLuint savedTexEnable = ctx->Texture._EnabledUnits;
-   ctx->Texture._EnabledUnits = 0;
+   GLchan *dest;
 
    tex_coord[0] = span->attrStart[FRAG_ATTRIB_TEX0][0]  * (info->smask + 1);
    tex_step[0] = span->attrStepX[FRAG_ATTRIB_TEX0][0] * (info->smask + 1);
@@ -663,110 +667,127 @@ fast_persp_span(GLcontext *ctx, SWspan *span,
    tex_coord[2] = span->attrStart[FRAG_ATTRIB_TEX0][3];
    tex_step[2] = span->attrStepX[FRAG_ATTRIB_TEX0][3];
 
-   switch (info->filter) {
-   case GL_NEAREST:
-      switch (info->format) {
-      case GL_RGB:
-         switch (info->envmode) {
-         case GL_MODULATE:
-            SPAN_NEAREST(NEAREST_RGB;MODULATE,3);
-            break;
-         case GL_DECAL:
-         case GL_REPLACE:
-            SPAN_NEAREST(NEAREST_RGB_REPLACE,3);
-            break;
-         case GL_BLEND:
-            SPAN_NEAREST(NEAREST_RGB;BLEND,3);
-            break;
-         case GL_ADD:
-            SPAN_NEAREST(NEAREST_RGB;ADD,3);
-            break;
-         default:
-            _mesa_problem(ctx, "bad tex env mode (5) in SPAN_LINEAR");
-            return;
-         }
-         break;
-      case GL_RGBA:
-         switch(info->envmode) {
-         case GL_MODULATE:
-            SPAN_NEAREST(NEAREST_RGBA;MODULATE,4);
-            break;
-         case GL_DECAL:
-            SPAN_NEAREST(NEAREST_RGBA;DECAL,4);
-            break;
-         case GL_BLEND:
-            SPAN_NEAREST(NEAREST_RGBA;BLEND,4);
-            break;
-         case GL_ADD:
-            SPAN_NEAREST(NEAREST_RGBA;ADD,4);
+   /* The span arrays only hold MAX_SPAN_WIDTH fragments.  Long spans are
+    * done in pieces here rather than in the triangle template so that
+    * tex_coord keeps stepping exactly as it would across the whole span.
+    */
+   do {
+      n = MIN2(remaining, MAX_SPAN_WIDTH);
+      span->end = n;
+      dest = span->array->rgba[0];
+
+      switch (info->filter) {
+      case GL_NEAREST:
+         switch (info->format) {
+         case GL_RGB:
+            switch (info->envmode) {
+            case GL_MODULATE:
+               SPAN_NEAREST(NEAREST_RGB;MODULATE,3);
+               break;
+            case GL_DECAL:
+            case GL_REPLACE:
+               SPAN_NEAREST(NEAREST_RGB_REPLACE,3);
+               break;
+            case GL_BLEND:
+               SPAN_NEAREST(NEAREST_RGB;BLEND,3);
+               break;
+            case GL_ADD:
+               SPAN_NEAREST(NEAREST_RGB;ADD,3);
+               break;
+            default:
+               _mesa_problem(ctx, "bad tex env mode (5) in SPAN_LINEAR");
+               return;
+            }
             break;
-         case GL_REPLACE:
-            SPAN_NEAREST(NEAREST_RGBA_REPLACE,4);
+         case GL_RGBA:
+            switch(info->envmode) {
+            case GL_MODULATE:
+               SPAN_NEAREST(NEAREST_RGBA;MODULATE,4);
+               break;
+            case GL_DECAL:
+               SPAN_NEAREST(NEAREST_RGBA;DECAL,4);
+               break;
+            case GL_BLEND:
+               SPAN_NEAREST(NEAREST_RGBA;BLEND,4);
+               break;
+            case GL_ADD:
+               SPAN_NEAREST(NEAREST_RGBA;ADD,4);
+               break;
+            case GL_REPLACE:
+               SPAN_NEAREST(NEAREST_RGBA_REPLACE,4);
+               break;
+            default:
+               _mesa_problem(ctx, "bad tex env mode (6) in SPAN_LINEAR");
+               return;
+            }
             break;
-         default:
-            _mesa_problem(ctx, "bad tex env mode (6) in SPAN_LINEAR");
-            return;
          }
          break;
-      }
-      break;
 
-   case GL_LINEAR:
-      switch (info->format) {
-      case GL_RGB:
-         switch (info->envmode) {
-         case GL_MODULATE:
-            SPAN_LINEAR(LINEAR_RGB;MODULATE,3);
-            break;
-         case GL_DECAL:
-         case GL_REPLACE:
-            SPAN_LINEAR(LINEAR_RGB;REPLACE,3);
-            break;
-         case GL_BLEND:
-            SPAN_LINEAR(LINEAR_RGB;BLEND,3);
-            break;
-         case GL_ADD:
-            SPAN_LINEAR(LINEAR_RGB;ADD,3);
-            break;
-         default:
-            _mesa_problem(ctx, "bad tex env mode (7) in SPAN_LINEAR");
-            return;
-         }
-         break;
-      case GL_RGBA:
-         switch (info->envmode) {
-         case GL_MODULATE:
-            SPAN_LINEAR(LINEAR_RGBA;MODULATE,4);
-            break;
-         case GL_DECAL:
-            SPAN_LINEAR(LINEAR_RGBA;DECAL,4);
-            break;
-         case GL_BLEND:
-            SPAN_LINEAR(LINEAR_RGBA;BLEND,4);
-            break;
-         case GL_ADD:
-            SPAN_LINEAR(LINEAR_RGBA;ADD,4);
+      case GL_LINEAR:
+         switch (info->format) {
+         case GL_RGB:
+            switch (info->envmode) {
+            case GL_MODULATE:
+               SPAN_LINEAR(LINEAR_RGB;MODULATE,3);
+               break;
+            case GL_DECAL:
+            case GL_REPLACE:
+               SPAN_LINEAR(LINEAR_RGB;REPLACE,3);
+               break;
+            case GL_BLEND:
+               SPAN_LINEAR(LINEAR_RGB;BLEND,3);
+               break;
+            case GL_ADD:
+               SPAN_LINEAR(LINEAR_RGB;ADD,3);
+               break;
+            default:
+               _mesa_problem(ctx, "bad tex env mode (7) in SPAN_LINEAR");
+               return;
+            }
             break;
-         case GL_REPLACE:
-            SPAN_LINEAR(LINEAR_RGBA;REPLACE,4);
+         case GL_RGBA:
+            switch (info->envmode) {
+            case GL_MODULATE:
+               SPAN_LINEAR(LINEAR_RGBA;MODULATE,4);
+               break;
+            case GL_DECAL:
+               SPAN_LINEAR(LINEAR_RGBA;DECAL,4);
+               break;
+            case GL_BLEND:
+               SPAN_LINEAR(LINEAR_RGBA;BLEND,4);
+               break;
+            case GL_ADD:
+               SPAN_LINEAR(LINEAR_RGBA;ADD,4);
+               break;
+            case GL_REPLACE:
+               SPAN_LINEAR(LINEAR_RGBA;REPLACE,4);
+               break;
+            default:
+               _mesa_problem(ctx, "bad tex env mode (8) in SPAN_LINEAR");
+               return;
+            }
             break;
-         default:
-            _mesa_problem(ctx, "bad tex env mode (8) in SPAN_LINEAR");
-            return;
          }
          break;
       }
-      break;
-   }
    
-   ASSERT(span->arrayMask & SPAN_RGBA);
-   _swrast_write_rgba_span(ctx, span);
+      ASSERT(span->arrayMask & SPAN_RGBA);
+      remaining -= n;
+      if (remaining > 0) {
+         /* the colors were already stepped by the loops above */
+         SWspan rest = *span;
+         _swrast_write_rgba_span(ctx, span);
+         _swrast_span_advance(ctx, &rest, n);
+         *span = rest;
+      }
+      else {
+         _swrast_write_rgba_span(ctx, span);
+      }
+   } while (remaining > 0);
 
 #undef SPAN_NEAREST
 #undef SPAN_LINEAR
-
-   /* restore state */
-   ctx->Texture._EnabledUnits = savedTexEnable;
 }
 
 
@@ -830,7 +851,7 @@ fast_persp_span(GLcontext *ctx, SWspan *span,
 
 #define RENDER_SPAN( span )			\
    span.interpMask &= ~SPAN_RGBA;		\
-   span.arrayMask |= SPAN_RGBA;			\
+   span.arrayMask |= SPAN_RGBA | SPAN_TEXTURED;	\
    fast_persp_span(ctx, &span, &info);
 
 #include "s_tritemp.h"
@@ -847,6 +868,7 @@ fast_persp_span(GLcontext *ctx, SWspan *span,
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
 #define INTERP_ATTRIBS 1
+#define SPLIT_SPANS 1
 #define RENDER_SPAN( span )   _swrast_write_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
@@ -955,6 +977,34 @@ _swrast_add_spec_terms_triangle(GLcontext *ctx, const SWvertex *v0,
 }
 
 
+/**
+ * Used when the guard band is allowed and the chosen triangle function
+ * doesn't clip its spans to the window (driver triangle functions and
+ * the simple textured ones write straight to the buffers).  T&L may then
+ * emit triangles which cross the window edges; they are drawn with the
+ * function which would be chosen with window clipping enabled.
+ */
+void
+_swrast_guard_band_triangle(GLcontext *ctx, const SWvertex *v0,
+                            const SWvertex *v1, const SWvertex *v2)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   const GLfloat xmin = (GLfloat) fb->_Xmin, xmax = (GLfloat) fb->_Xmax;
+   const GLfloat ymin = (GLfloat) fb->_Ymin, ymax = (GLfloat) fb->_Ymax;
+   const GLfloat *p0 = v0->attrib[FRAG_ATTRIB_WPOS];
+   const GLfloat *p1 = v1->attrib[FRAG_ATTRIB_WPOS];
+   const GLfloat *p2 = v2->attrib[FRAG_ATTRIB_WPOS];
+
+   if (p0[0] >= xmin && p0[0] <= xmax && p0[1] >= ymin && p0[1] <= ymax &&
+       p1[0] >= xmin && p1[0] <= xmax && p1[1] >= ymin && p1[1] <= ymax &&
+       p2[0] >= xmin && p2[0] <= xmax && p2[1] >= ymin && p2[1] <= ymax)
+      swrast->UnclippedTriangle(ctx, v0, v1, v2);
+   else
+      swrast->ClipTriangle(ctx, v0, v1, v2);
+}
+
+
 
 #ifdef DEBUG
 
@@ -965,12 +1015,17 @@ const char *_mesa_triFuncName = NULL;
 do {						\
     _mesa_triFuncName = #triFunc;		\
     /*printf("%s\n", _mesa_triFuncName);*/	\
+    swrast->_TriangleName = #triFunc;		\
     swrast->Triangle = triFunc;			\
 } while (0)
 
 #else
 
-#define USE(triFunc)  swrast->Triangle = triFunc;
+#define USE(triFunc)				\
+do {						\
+    swrast->_TriangleName = #triFunc;		\
+    swrast->Triangle = triFunc;			\
+} while (0)
 
 #endif
 
@@ -1027,6 +1082,11 @@ _swrast_choose_triangle( GLcontext *ctx )
          return;
       }
 
+      if (swrast->UseHalfSpace) {
+         USE(_swrast_halfspace_triangle);
+         return;
+      }
+
       /*
        * XXX should examine swrast->_ActiveAttribMask to determine what
        * needs to be interpolated.
@@ -46,5 +46,11 @@ _swrast_add_spec_terms_triangle( GLcontext *ctx,
 				 const SWvertex *v1,
 				 const SWvertex *v2 );
 
+extern void
+_swrast_guard_band_triangle( GLcontext *ctx,
+			     const SWvertex *v0,
+			     const SWvertex *v1,
+			     const SWvertex *v2 );
+
 
 #endif
@@ -52,9 +52,18 @@
  * buffer addressing (see zRow):
  *    DEPTH_TYPE          - either GLushort or GLuint
  *
+ * With INTERP_Z, spans which can't pass the depth test are dropped
+ * before RENDER_SPAN when coarse depth culling is active (see s_hiz.c).
+ * With DEPTH_TYPE, the depth tiles are told about the span's Z values
+ * since RENDER_SPAN may write them to the depth buffer directly.
+ *
  * Optionally, one may provide one-time setup code per triangle:
  *    SETUP_CODE    - code which is to be executed once per triangle
  *
+ * If RENDER_SPAN uses the span's fragment arrays, define SPLIT_SPANS so
+ * that spans wider than MAX_SPAN_WIDTH are broken into pieces first.
+ * Pieces are only correct if RENDER_SPAN doesn't rely on pRow or zRow.
+ *
  * The following macro MUST be defined:
  *    RENDER_SPAN(span) - code to write a span of pixels.
  *
@@ -73,23 +82,73 @@
  *
  * If SUB_PIXEL_BITS=4 then we'll snap the vertices to the nearest
  * 1/16 of a pixel.  If we're walking up a long, nearly vertical edge
- * (dx=1/16, dy=1024) we'll need 4 + 10 = 14 fractional bits in
- * GLfixed to walk the edge without error.  If the maximum viewport
- * height is 4K pixels, then we'll need 4 + 12 = 16 fractional bits.
+ * (dx=1/16, dy=1024) we'd need 4 + 10 = 14 fractional bits in
+ * GLfixed to step the edge by a fixed point dx/dy without error, and
+ * 4 + 14 = 18 bits for a 16K pixel high viewport.
  *
- * Historically, Mesa has used 11 fractional bits in GLfixed, snaps
- * vertices to 1/16 pixel and allowed a maximum viewport height of 2K
- * pixels.  11 fractional bits is actually insufficient for accurately
- * rasterizing some triangles.  More recently, the maximum viewport
- * height was increased to 4K pixels.  Thus, Mesa should be using 16
- * fractional bits in GLfixed.  Unfortunately, there may be some issues
- * with setting FIXED_FRAC_BITS=16, such as multiplication overflow.
- * This will have to be examined in some detail...
- *
- * For now, if you find rasterization errors, particularly with tall,
- * sliver triangles, try increasing FIXED_FRAC_BITS and/or decreasing
- * SUB_PIXEL_BITS.
+ * Mesa uses 11 fractional bits in GLfixed, so the edges are instead
+ * walked with an integer remainder like Bresenham's algorithm (see
+ * STEP_EDGE below), which is exact for any viewport height.  The 11 bits
+ * only limit the accuracy of the interpolated values.
+ */
+
+
+/*
+ * The edges are walked exactly: an edge's x coord at a scanline is kept
+ * as a fixed point value, rounded down, and the remainder of the division
+ * by the edge's dy, which is an integer in sub-pixels.  The pixels whose
+ * centers are on or right of the left edge, and left of the right edge,
+ * are inside the triangle, the same as for the half-space rasterizer
+ * (s_halfspace.c).
  */
+#ifndef SETUP_EDGE_WALK
+
+/* Q = floor(N / D), R = N - Q * D, for D > 0 */
+#define EDGE_DIVMOD(N, D, Q, R)						\
+do {									\
+   if ((N) >= 0)							\
+      Q = (N) / (D);							\
+   else									\
+      Q = -((-(N) + (D) - 1) / (D));					\
+   R = (N) - (Q) * (D);							\
+} while (0)
+
+/*
+ * Set up edge E from snapped (FX0, FY0) to (FX1, FY1); E.fsy must be set.
+ * The clipped coords are less than 32K pixels apart, so den < 2^19 and
+ * the products below fit in 31 bits.
+ */
+#define SETUP_EDGE_WALK(E, FX0, FY0, FX1, FY1)				\
+do {									\
+   const GLint subShift = FIXED_SHIFT - SUB_PIXEL_BITS;			\
+   const GLint dxSub = ((FX1) - (FX0)) >> subShift;			\
+   const GLfixed adj = (E).fsy - (FY0);					\
+   GLint q, r, q2, r2;							\
+   (E).den = ((FY1) - (FY0)) >> subShift;				\
+   EDGE_DIVMOD(dxSub, (E).den, q, r);					\
+   EDGE_DIVMOD(FIXED_ONE * r, (E).den, q2, r2);				\
+   (E).fdxdy = q * FIXED_ONE + q2;					\
+   (E).fdxdyRem = r2;							\
+   EDGE_DIVMOD(adj * r, (E).den, q2, r2);				\
+   (E).fsx = (FX0) + adj * q + q2;					\
+   (E).fsxRem = r2;							\
+} while (0)
+
+/* The first pixel whose center is on or right of x = FX + REM / den */
+#define EDGE_PIXEL(FX, REM)  FixedToInt((FX) - ((REM) == 0))
+
+/* Step an edge's x coord to the next scanline */
+#define STEP_EDGE(FX, REM, FDX, FDXREM, DEN)				\
+do {									\
+   FX += FDX;								\
+   REM += FDXREM;							\
+   if (REM >= DEN) {							\
+      REM -= DEN;							\
+      FX++;								\
+   }									\
+} while (0)
+
+#endif
 
 
 /*
@@ -117,10 +176,12 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
       const SWvertex *v0, *v1;   /* Y(v0) < Y(v1) */
       GLfloat dx;	/* X(v1) - X(v0) */
       GLfloat dy;	/* Y(v1) - Y(v0) */
-      GLfloat dxdy;	/* dx/dy */
-      GLfixed fdxdy;	/* dx/dy in fixed-point */
+      GLfixed fdxdy;	/* dx/dy in fixed-point, rounded down */
+      GLint fdxdyRem;	/* dx/dy = fdxdy + fdxdyRem / den exactly */
       GLfloat adjy;	/* adjust from v[0]->fy to fsy, scaled */
-      GLfixed fsx;	/* first sample point x coord */
+      GLfixed fsx;	/* first sample point x coord, rounded down */
+      GLint fsxRem;	/* x = fsx + fsxRem / den exactly */
+      GLint den;	/* dy in sub-pixels */
       GLfixed fsy;
       GLfixed fx0;	/* fixed pt X of lower endpoint */
       GLint lines;	/* number of lines to be sampled on this edge */
@@ -139,6 +200,10 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
    GLfloat bf = SWRAST_CONTEXT(ctx)->_BackfaceSign;
    const GLint snapMask = ~((FIXED_ONE / (1 << SUB_PIXEL_BITS)) - 1); /* for x/y coord snapping */
    GLfixed vMin_fx, vMin_fy, vMid_fx, vMid_fy, vMax_fx, vMax_fy;
+   /* Scanlines to draw.  Narrowed to one screen band when the triangle
+    * is drawn by the tiled renderer (see s_tile.c).
+    */
+   GLint spanYmin = 0, spanYmax = 0x7fffffff;
 
    SWspan span;
 
@@ -147,6 +212,12 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
    INIT_SPAN(span, GL_POLYGON);
    span.y = 0; /* silence warnings */
 
+   if (swrast->_TileActive) {
+      const SWthread *thread = _swrast_tile_thread();
+      spanYmin = thread->TileYmin;
+      spanYmax = thread->TileYmax;
+   }
+
 #ifdef INTERP_Z
    (void) fixedToDepthShift;
 #endif
@@ -252,11 +323,9 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
       eMaj.fsy = FixedCeil(vMin_fy);
       eMaj.lines = FixedToInt(FixedCeil(vMax_fy - eMaj.fsy));
       if (eMaj.lines > 0) {
-         eMaj.dxdy = eMaj.dx / eMaj.dy;
-         eMaj.fdxdy = SignedFloatToFixed(eMaj.dxdy);
          eMaj.adjy = (GLfloat) (eMaj.fsy - vMin_fy);  /* SCALED! */
          eMaj.fx0 = vMin_fx;
-         eMaj.fsx = eMaj.fx0 + (GLfixed) (eMaj.adjy * eMaj.dxdy);
+         SETUP_EDGE_WALK(eMaj, vMin_fx, vMin_fy, vMax_fx, vMax_fy);
       }
       else {
          return;  /*CULLED*/
@@ -265,21 +334,17 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
       eTop.fsy = FixedCeil(vMid_fy);
       eTop.lines = FixedToInt(FixedCeil(vMax_fy - eTop.fsy));
       if (eTop.lines > 0) {
-         eTop.dxdy = eTop.dx / eTop.dy;
-         eTop.fdxdy = SignedFloatToFixed(eTop.dxdy);
          eTop.adjy = (GLfloat) (eTop.fsy - vMid_fy); /* SCALED! */
          eTop.fx0 = vMid_fx;
-         eTop.fsx = eTop.fx0 + (GLfixed) (eTop.adjy * eTop.dxdy);
+         SETUP_EDGE_WALK(eTop, vMid_fx, vMid_fy, vMax_fx, vMax_fy);
       }
 
       eBot.fsy = FixedCeil(vMin_fy);
       eBot.lines = FixedToInt(FixedCeil(vMid_fy - eBot.fsy));
       if (eBot.lines > 0) {
-         eBot.dxdy = eBot.dx / eBot.dy;
-         eBot.fdxdy = SignedFloatToFixed(eBot.dxdy);
          eBot.adjy = (GLfloat) (eBot.fsy - vMin_fy);  /* SCALED! */
          eBot.fx0 = vMin_fx;
-         eBot.fsx = eBot.fx0 + (GLfixed) (eBot.adjy * eBot.dxdy);
+         SETUP_EDGE_WALK(eBot, vMin_fx, vMin_fy, vMid_fx, vMid_fy);
       }
    }
 
@@ -508,7 +573,10 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
          GLint subTriangle;
          GLfixed fxLeftEdge = 0, fxRightEdge = 0;
          GLfixed fdxLeftEdge = 0, fdxRightEdge = 0;
-         GLfixed fError = 0, fdError = 0;
+         GLint leftRem = 0, rightRem = 0;
+         GLint fdxLeftRem = 0, fdxRightRem = 0;
+         GLint leftDen = 1, rightDen = 1;
+         GLint idxOuter = 0;
 #ifdef PIXEL_ADDRESS
          PIXEL_TYPE *pRow = NULL;
          GLint dPRowOuter = 0, dPRowInner;  /* offset in bytes */
@@ -589,20 +657,22 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
             if (setupLeft && eLeft->lines > 0) {
                const SWvertex *vLower = eLeft->v0;
                const GLfixed fsy = eLeft->fsy;
-               const GLfixed fsx = eLeft->fsx;  /* no fractional part */
-               const GLfixed fx = FixedCeil(fsx);  /* no fractional part */
+               /* x coord of the first pixel center inside the triangle */
+               const GLfixed fx = (EDGE_PIXEL(eLeft->fsx, eLeft->fsxRem) + 1)
+                                  << FIXED_SHIFT;
                const GLfixed adjx = (GLfixed) (fx - eLeft->fx0); /* SCALED! */
                const GLfixed adjy = (GLfixed) eLeft->adjy;      /* SCALED! */
-               GLint idxOuter;
                GLfloat dxOuter;
-               GLfixed fdxOuter;
 
-               fError = fx - fsx - FIXED_ONE;
-               fxLeftEdge = fsx - FIXED_EPSILON;
+               fxLeftEdge = eLeft->fsx;
+               leftRem = eLeft->fsxRem;
                fdxLeftEdge = eLeft->fdxdy;
-               fdxOuter = FixedFloor(fdxLeftEdge - FIXED_EPSILON);
-               fdError = fdxOuter - fdxLeftEdge + FIXED_ONE;
-               idxOuter = FixedToInt(fdxOuter);
+               fdxLeftRem = eLeft->fdxdyRem;
+               leftDen = eLeft->den;
+               /* the first pixel moves by idxOuter or idxOuter + 1 pixels
+                * from one scanline to the next
+                */
+               idxOuter = EDGE_PIXEL(fdxLeftEdge, fdxLeftRem);
                dxOuter = (GLfloat) idxOuter;
                span.y = FixedToInt(fsy);
 
@@ -614,7 +684,7 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
 
 #ifdef PIXEL_ADDRESS
                {
-                  pRow = (PIXEL_TYPE *) PIXEL_ADDRESS(FixedToInt(fxLeftEdge), span.y);
+                  pRow = (PIXEL_TYPE *) PIXEL_ADDRESS(EDGE_PIXEL(fxLeftEdge, leftRem), span.y);
                   dPRowOuter = -((int)BYTES_PER_ROW) + idxOuter * sizeof(PIXEL_TYPE);
                   /* negative because Y=0 at bottom and increases upward */
                }
@@ -653,7 +723,7 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
                   }
 #  ifdef DEPTH_TYPE
                   zRow = (DEPTH_TYPE *)
-                    zrb->GetPointer(ctx, zrb, FixedToInt(fxLeftEdge), span.y);
+                    zrb->GetPointer(ctx, zrb, EDGE_PIXEL(fxLeftEdge, leftRem), span.y);
                   dZRowOuter = (ctx->DrawBuffer->Width + idxOuter) * sizeof(DEPTH_TYPE);
 #  endif
                }
@@ -757,8 +827,11 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
 
 
             if (setupRight && eRight->lines>0) {
-               fxRightEdge = eRight->fsx - FIXED_EPSILON;
+               fxRightEdge = eRight->fsx;
+               rightRem = eRight->fsxRem;
                fdxRightEdge = eRight->fdxdy;
+               fdxRightRem = eRight->fdxdyRem;
+               rightDen = eRight->den;
             }
 
             if (lines==0) {
@@ -801,11 +874,13 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
             ATTRIB_LOOP_END
 #endif
 
-            while (lines > 0) {
+            /* scanlines increase monotonically, stop past spanYmax */
+            while (lines > 0 && span.y < spanYmax) {
                /* initialize the span interpolants to the leftmost value */
                /* ff = fixed-pt fragment */
-               const GLint right = FixedToInt(fxRightEdge);
-               span.x = FixedToInt(fxLeftEdge);
+               const GLint left = EDGE_PIXEL(fxLeftEdge, leftRem);
+               const GLint right = EDGE_PIXEL(fxRightEdge, rightRem);
+               span.x = left;
                if (right <= span.x)
                   span.end = 0;
                else
@@ -844,9 +919,18 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
                /* XXX the test for span.y > 0 _shouldn't_ be needed but
                 * it fixes a problem on 64-bit Opterons (bug 4842).
                 */
-               if (span.end > 0 && span.y >= 0) {
+               if (span.end > 0 && span.y >= spanYmin && span.y < spanYmax
+#ifdef INTERP_Z
+                   && !(swrast->_HiZFunc != GL_NONE &&
+                        _swrast_hiz_cull_span(ctx, &span))
+#endif
+                   ) {
                   const GLint len = span.end - 1;
                   (void) len;
+#ifdef DEPTH_TYPE
+                  if (zrb->DepthTiles)
+                     _swrast_hiz_span_written(ctx, zrb, &span);
+#endif
 #ifdef INTERP_RGB
                   CLAMP_INTERPOLANT(red, redStep, len);
                   CLAMP_INTERPOLANT(green, greenStep, len);
@@ -857,6 +941,18 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
 #endif
 #ifdef INTERP_INDEX
                   CLAMP_INTERPOLANT(index, indexStep, len);
+#endif
+#ifdef SPLIT_SPANS
+                  while (span.end > MAX_SPAN_WIDTH) {
+                     SWspan rest = span;
+                     span.end = MAX_SPAN_WIDTH;
+                     {
+                        RENDER_SPAN( span );
+                     }
+                     _swrast_span_advance(ctx, &rest, MAX_SPAN_WIDTH);
+                     rest.end -= MAX_SPAN_WIDTH;
+                     span = rest;
+                  }
 #endif
                   {
                      RENDER_SPAN( span );
@@ -872,12 +968,11 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
                span.y++;
                lines--;
 
-               fxLeftEdge += fdxLeftEdge;
-               fxRightEdge += fdxRightEdge;
+               STEP_EDGE(fxLeftEdge, leftRem, fdxLeftEdge, fdxLeftRem, leftDen);
+               STEP_EDGE(fxRightEdge, rightRem, fdxRightEdge, fdxRightRem,
+                         rightDen);
 
-               fError += fdError;
-               if (fError >= 0) {
-                  fError -= FIXED_ONE;
+               if (EDGE_PIXEL(fxLeftEdge, leftRem) - left == idxOuter) {
 
 #ifdef PIXEL_ADDRESS
                   pRow = (PIXEL_TYPE *) ((GLubyte *) pRow + dPRowOuter);
@@ -958,6 +1053,7 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
 
 #undef SETUP_CODE
 #undef RENDER_SPAN
+#undef SPLIT_SPANS
 
 #undef PIXEL_TYPE
 #undef BYTES_PER_ROW
@@ -132,8 +132,7 @@ zoom_span( GLcontext *ctx, GLint imgX, GLint imgY, const SWspan *span,
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    SWspan zoomed;
-   GLint x0, x1, y0, y1;
-   GLint zoomedWidth;
+   GLint x0, x1, y0, y1, start;
 
    if (!compute_zoomed_bounds(ctx, imgX, imgY, span->x, span->y, span->end,
                               &x0, &x1, &y0, &y1)) {
@@ -147,17 +146,13 @@ zoom_span( GLcontext *ctx, GLint imgX, GLint imgY, const SWspan *span,
          return;
    }
 
-   zoomedWidth = x1 - x0;
-   ASSERT(zoomedWidth > 0);
-   ASSERT(zoomedWidth <= MAX_WIDTH);
+   ASSERT(x1 - x0 > 0);
 
    /* no pixel arrays! must be horizontal spans. */
    ASSERT((span->arrayMask & SPAN_XY) == 0);
    ASSERT(span->primitive == GL_BITMAP);
 
    INIT_SPAN(zoomed, GL_BITMAP);
-   zoomed.x = x0;
-   zoomed.end = zoomedWidth;
    zoomed.array = swrast->ZoomedArrays;
    zoomed.array->ChanType = span->array->ChanType;
    if (zoomed.array->ChanType == GL_UNSIGNED_BYTE)
@@ -214,140 +209,160 @@ zoom_span( GLcontext *ctx, GLint imgX, GLint imgY, const SWspan *span,
       return;
    }
 
-   /* zoom the span horizontally */
-   if (format == GL_RGBA) {
-      if (zoomed.array->ChanType == GL_UNSIGNED_BYTE) {
-         const GLubyte (*rgba)[4] = (const GLubyte (*)[4]) src;
-         GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-            ASSERT(j >= 0);
-            ASSERT(j < (GLint) span->end);
-            COPY_4UBV(zoomed.array->rgba8[i], rgba[j]);
+   /* The zoomed span may be wider than the span arrays so it's done in
+    * pieces of at most MAX_SPAN_WIDTH pixels.  The interpolated values
+    * (Z, color, fog) are constant across a pixel rectangle.
+    */
+   for (start = x0; start < x1; start += MAX_SPAN_WIDTH) {
+      GLenum writeFormat = format;
+
+      zoomed.x = start;
+      zoomed.end = MIN2(x1 - start, MAX_SPAN_WIDTH);
+
+      /* zoom the span horizontally */
+      if (format == GL_RGBA) {
+         if (zoomed.array->ChanType == GL_UNSIGNED_BYTE) {
+            const GLubyte (*rgba)[4] = (const GLubyte (*)[4]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < (GLint) span->end);
+               COPY_4UBV(zoomed.array->rgba8[i], rgba[j]);
+            }
          }
-      }
-      else if (zoomed.array->ChanType == GL_UNSIGNED_SHORT) {
-         const GLushort (*rgba)[4] = (const GLushort (*)[4]) src;
-         GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-            ASSERT(j >= 0);
-            ASSERT(j < (GLint) span->end);
-            COPY_4V(zoomed.array->rgba16[i], rgba[j]);
+         else if (zoomed.array->ChanType == GL_UNSIGNED_SHORT) {
+            const GLushort (*rgba)[4] = (const GLushort (*)[4]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < (GLint) span->end);
+               COPY_4V(zoomed.array->rgba16[i], rgba[j]);
+            }
          }
-      }
-      else {
-         const GLfloat (*rgba)[4] = (const GLfloat (*)[4]) src;
-         GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-            ASSERT(j >= 0);
-            ASSERT(j < span->end);
-            COPY_4V(zoomed.array->attribs[FRAG_ATTRIB_COL0][i], rgba[j]);
+         else {
+            const GLfloat (*rgba)[4] = (const GLfloat (*)[4]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < span->end);
+               COPY_4V(zoomed.array->attribs[FRAG_ATTRIB_COL0][i], rgba[j]);
+            }
          }
       }
-   }
-   else if (format == GL_RGB) {
-      if (zoomed.array->ChanType == GL_UNSIGNED_BYTE) {
-         const GLubyte (*rgb)[3] = (const GLubyte (*)[3]) src;
-         GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-            ASSERT(j >= 0);
-            ASSERT(j < (GLint) span->end);
-            zoomed.array->rgba8[i][0] = rgb[j][0];
-            zoomed.array->rgba8[i][1] = rgb[j][1];
-            zoomed.array->rgba8[i][2] = rgb[j][2];
-            zoomed.array->rgba8[i][3] = 0xff;
+      else if (format == GL_RGB) {
+         if (zoomed.array->ChanType == GL_UNSIGNED_BYTE) {
+            const GLubyte (*rgb)[3] = (const GLubyte (*)[3]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < (GLint) span->end);
+               zoomed.array->rgba8[i][0] = rgb[j][0];
+               zoomed.array->rgba8[i][1] = rgb[j][1];
+               zoomed.array->rgba8[i][2] = rgb[j][2];
+               zoomed.array->rgba8[i][3] = 0xff;
+            }
+         }
+         else if (zoomed.array->ChanType == GL_UNSIGNED_SHORT) {
+            const GLushort (*rgb)[3] = (const GLushort (*)[3]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < (GLint) span->end);
+               zoomed.array->rgba16[i][0] = rgb[j][0];
+               zoomed.array->rgba16[i][1] = rgb[j][1];
+               zoomed.array->rgba16[i][2] = rgb[j][2];
+               zoomed.array->rgba16[i][3] = 0xffff;
+            }
+         }
+         else {
+            const GLfloat (*rgb)[3] = (const GLfloat (*)[3]) src;
+            GLint i;
+            for (i = 0; i < (GLint) zoomed.end; i++) {
+               GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+                  - span->x;
+               ASSERT(j >= 0);
+               ASSERT(j < span->end);
+               zoomed.array->attribs[FRAG_ATTRIB_COL0][i][0] = rgb[j][0];
+               zoomed.array->attribs[FRAG_ATTRIB_COL0][i][1] = rgb[j][1];
+               zoomed.array->attribs[FRAG_ATTRIB_COL0][i][2] = rgb[j][2];
+               zoomed.array->attribs[FRAG_ATTRIB_COL0][i][3] = 1.0F;
+            }
          }
       }
-      else if (zoomed.array->ChanType == GL_UNSIGNED_SHORT) {
-         const GLushort (*rgb)[3] = (const GLushort (*)[3]) src;
+      else if (format == GL_COLOR_INDEX) {
+         const GLuint *indexes = (const GLuint *) src;
          GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
+         for (i = 0; i < (GLint) zoomed.end; i++) {
+            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+               - span->x;
             ASSERT(j >= 0);
             ASSERT(j < (GLint) span->end);
-            zoomed.array->rgba16[i][0] = rgb[j][0];
-            zoomed.array->rgba16[i][1] = rgb[j][1];
-            zoomed.array->rgba16[i][2] = rgb[j][2];
-            zoomed.array->rgba16[i][3] = 0xffff;
+            zoomed.array->index[i] = indexes[j];
          }
       }
-      else {
-         const GLfloat (*rgb)[3] = (const GLfloat (*)[3]) src;
+      else if (format == GL_DEPTH_COMPONENT) {
+         const GLuint *zValues = (const GLuint *) src;
          GLint i;
-         for (i = 0; i < zoomedWidth; i++) {
-            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
+         for (i = 0; i < (GLint) zoomed.end; i++) {
+            GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, zoomed.x + i)
+               - span->x;
             ASSERT(j >= 0);
-            ASSERT(j < span->end);
-            zoomed.array->attribs[FRAG_ATTRIB_COL0][i][0] = rgb[j][0];
-            zoomed.array->attribs[FRAG_ATTRIB_COL0][i][1] = rgb[j][1];
-            zoomed.array->attribs[FRAG_ATTRIB_COL0][i][2] = rgb[j][2];
-            zoomed.array->attribs[FRAG_ATTRIB_COL0][i][3] = 1.0F;
+            ASSERT(j < (GLint) span->end);
+            zoomed.array->z[i] = zValues[j];
          }
+         /* Now, fall into either the RGB or COLOR_INDEX path below */
+         writeFormat = ctx->Visual.rgbMode ? GL_RGBA : GL_COLOR_INDEX;
       }
-   }
-   else if (format == GL_COLOR_INDEX) {
-      const GLuint *indexes = (const GLuint *) src;
-      GLint i;
-      for (i = 0; i < zoomedWidth; i++) {
-         GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-         ASSERT(j >= 0);
-         ASSERT(j < (GLint) span->end);
-         zoomed.array->index[i] = indexes[j];
-      }
-   }
-   else if (format == GL_DEPTH_COMPONENT) {
-      const GLuint *zValues = (const GLuint *) src;
-      GLint i;
-      for (i = 0; i < zoomedWidth; i++) {
-         GLint j = unzoom_x(ctx->Pixel.ZoomX, imgX, x0 + i) - span->x;
-         ASSERT(j >= 0);
-         ASSERT(j < (GLint) span->end);
-         zoomed.array->z[i] = zValues[j];
-      }
-      /* Now, fall into either the RGB or COLOR_INDEX path below */
-      format = ctx->Visual.rgbMode ? GL_RGBA : GL_COLOR_INDEX;
-   }
 
-   /* write the span in rows [r0, r1) */
-   if (format == GL_RGBA || format == GL_RGB) {
-      /* Writing the span may modify the colors, so make a backup now if we're
-       * going to call _swrast_write_zoomed_span() more than once.
-       * Also, clipping may change the span end value, so store it as well.
-       */
-      const GLint end = zoomed.end; /* save */
-      GLuint rgbaSave[MAX_WIDTH][4];
-      const GLint pixelSize =
-         (zoomed.array->ChanType == GL_UNSIGNED_BYTE) ? 4 * sizeof(GLubyte) :
-         ((zoomed.array->ChanType == GL_UNSIGNED_SHORT) ? 4 * sizeof(GLushort)
-          : 4 * sizeof(GLfloat));
-      if (y1 - y0 > 1) {
-         MEMCPY(rgbaSave, zoomed.array->rgba, zoomed.end * pixelSize);
-      }
-      for (zoomed.y = y0; zoomed.y < y1; zoomed.y++) {
-         _swrast_write_rgba_span(ctx, &zoomed);
-         zoomed.end = end;  /* restore */
+      /* write the span in rows [r0, r1) */
+      if (writeFormat == GL_RGBA || writeFormat == GL_RGB) {
+         /* Writing the span may modify the colors, so make a backup now
+          * if we're going to call _swrast_write_zoomed_span() more than
+          * once.  Also, clipping may change the span end value, so store
+          * it as well.
+          */
+         const GLint end = zoomed.end; /* save */
+         GLuint rgbaSave[MAX_SPAN_WIDTH][4];
+         const GLint pixelSize =
+            (zoomed.array->ChanType == GL_UNSIGNED_BYTE) ? 4 * sizeof(GLubyte) :
+            ((zoomed.array->ChanType == GL_UNSIGNED_SHORT) ? 4 * sizeof(GLushort)
+             : 4 * sizeof(GLfloat));
          if (y1 - y0 > 1) {
-            /* restore the colors */
-            MEMCPY(zoomed.array->rgba, rgbaSave, zoomed.end * pixelSize);
+            MEMCPY(rgbaSave, zoomed.array->rgba, zoomed.end * pixelSize);
+         }
+         for (zoomed.y = y0; zoomed.y < y1; zoomed.y++) {
+            _swrast_write_rgba_span(ctx, &zoomed);
+            zoomed.end = end;  /* restore */
+            if (y1 - y0 > 1) {
+               /* restore the colors */
+               MEMCPY(zoomed.array->rgba, rgbaSave, zoomed.end * pixelSize);
+            }
          }
       }
-   }
-   else if (format == GL_COLOR_INDEX) {
-      /* use specular color array for temp storage */
-      GLuint *indexSave = (GLuint *) zoomed.array->attribs[FRAG_ATTRIB_FOGC];
-      const GLint end = zoomed.end; /* save */
-      if (y1 - y0 > 1) {
-         MEMCPY(indexSave, zoomed.array->index, zoomed.end * sizeof(GLuint));
-      }
-      for (zoomed.y = y0; zoomed.y < y1; zoomed.y++) {
-         _swrast_write_index_span(ctx, &zoomed);
-         zoomed.end = end;  /* restore */
+      else if (writeFormat == GL_COLOR_INDEX) {
+         /* use specular color array for temp storage */
+         GLuint *indexSave = (GLuint *) zoomed.array->attribs[FRAG_ATTRIB_FOGC];
+         const GLint end = zoomed.end; /* save */
          if (y1 - y0 > 1) {
-            /* restore the colors */
-            MEMCPY(zoomed.array->index, indexSave, zoomed.end * sizeof(GLuint));
+            MEMCPY(indexSave, zoomed.array->index, zoomed.end * sizeof(GLuint));
+         }
+         for (zoomed.y = y0; zoomed.y < y1; zoomed.y++) {
+            _swrast_write_index_span(ctx, &zoomed);
+            zoomed.end = end;  /* restore */
+            if (y1 - y0 > 1) {
+               /* restore the colors */
+               MEMCPY(zoomed.array->index, indexSave, zoomed.end * sizeof(GLuint));
+            }
          }
       }
    }
@@ -195,6 +195,17 @@ _swrast_allow_vertex_fog( GLcontext *ctx, GLboolean value );
 extern void
 _swrast_allow_pixel_fog( GLcontext *ctx, GLboolean value );
 
+extern void
+_swrast_allow_guard_band( GLcontext *ctx, GLboolean value );
+
+/**
+ * Guard band size drivers pass to _tnl_allow_guard_band() along with
+ * _swrast_allow_guard_band().  Bigger triangles are still clipped by
+ * T&L, which is cheaper than stepping through thousands of scanlines
+ * outside the window.
+ */
+#define SWRAST_GUARD_BAND_SIZE 4096.0F
+
 /* Debug:
  */
 extern void
@@ -285,6 +296,15 @@ struct swrast_device_driver {
     */
    void (*SpanRenderStart)(GLcontext *ctx);
    void (*SpanRenderFinish)(GLcontext *ctx);
+
+   /*
+    * Optional.  Return GL_TRUE if the span functions of the current
+    * draw buffer's renderbuffers may be called from several threads at
+    * once, as long as no two threads access the same row.  If not
+    * provided (or GL_FALSE is returned), triangles are always rendered
+    * by the calling thread.  See MESA_SWRAST_THREADS.
+    */
+   GLboolean (*SpanThreadSafe)(GLcontext *ctx);
 };
 
 
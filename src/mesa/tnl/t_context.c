@@ -36,6 +36,7 @@
 #include "tnl.h"
 #include "t_context.h"
 #include "t_pipeline.h"
+#include "t_vb_threads.h"
 #include "t_vp_build.h"
 
 #include "vbo/vbo.h"
@@ -78,6 +79,10 @@ _tnl_CreateContext( GLcontext *ctx )
 
    tnl->nr_blocks = 0;
 
+   tnl->vcache.Enabled = !_mesa_getenv("MESA_NO_VCACHE");
+
+   _tnl_create_vertex_threads( ctx );
+
    return GL_TRUE;
 }
 
@@ -86,9 +91,39 @@ void
 _tnl_DestroyContext( GLcontext *ctx )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
+   GLuint i;
 
+   _tnl_destroy_vertex_threads( ctx );
    _tnl_destroy_pipeline( ctx );
 
+   if (_mesa_getenv("MESA_VCACHE_STATS")) {
+      const struct tnl_vertex_cache *cache = &tnl->vcache;
+      _mesa_printf("Mesa: %u indexed draws, %u with compacted vertices\n",
+                   cache->Draws, cache->Compacted);
+      if (cache->Indices)
+         _mesa_printf("Mesa: %u indices, %u vertices transformed "
+                      "(%.1f%% hits, %u vertices in index ranges)\n",
+                      cache->Indices, cache->Misses,
+                      100.0 * (cache->Indices - cache->Misses) / cache->Indices,
+                      cache->RangeVerts);
+   }
+
+   if (_mesa_getenv("MESA_CLIP_STATS")) {
+      const struct tnl_clip_stats *stats = &tnl->clipstats;
+      _mesa_printf("Mesa: %u vertex buffers, %u guard band cliptested, "
+                   "%u without clipped vertices\n",
+                   stats->Buffers, stats->GuardBand, stats->Unclipped);
+      _mesa_printf("Mesa: %u primitives passed, %u clipped, %u rejected\n",
+                   stats->Passed, stats->Clipped, stats->Rejected);
+   }
+
+   _mesa_free(tnl->vcache.tag);
+   _mesa_free(tnl->vcache.slot);
+   _mesa_free(tnl->vcache.verts);
+
+   for (i = 0; i < TNL_MAX_CONVERTED_ARRAYS; i++)
+      _mesa_free(tnl->converted[i].data);
+
    FREE(tnl);
    ctx->swtnl_context = NULL;
 }
@@ -220,3 +255,18 @@ _tnl_allow_pixel_fog( GLcontext *ctx, GLboolean value )
       || !tnl->AllowPixelFog) && !ctx->FragmentProgram._Current;
 }
 
+/**
+ * Drivers whose rasterizer clips triangles to the window call this to
+ * allow guard band clipping.  Vertices are then only flagged as outside
+ * the left/right/top/bottom planes when their window coordinates are
+ * more than size/2 pixels away from the center of the viewport, so that
+ * triangles crossing the viewport edges are rasterized without being
+ * clipped.  A size of zero disables guard band clipping.
+ */
+void
+_tnl_allow_guard_band( GLcontext *ctx, GLfloat size )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   tnl->GuardBandSize = size;
+}
+
@@ -502,6 +502,74 @@ struct tnl_device_driver
 #define RENDERINPUTS_CLEAR_RANGE BITSET64_CLEAR_RANGE
 
 
+/**
+ * Used by _tnl_draw_prims() to transform only the vertices an indexed
+ * draw actually references.  Each index between min_index and max_index
+ * has a tag and a slot: the tag matches the current stamp once the
+ * vertex has been copied to slot in the compacted vertex buffer, so later
+ * references to the same index reuse the transformed vertex.
+ */
+struct tnl_vertex_cache
+{
+   GLboolean Enabled;   /**< FALSE if MESA_NO_VCACHE is set */
+   GLuint *tag;
+   GLuint *slot;
+   GLuint size;         /**< number of tags and slots */
+   GLuint stamp;
+   GLuint *verts;       /**< original index of each compacted vertex */
+
+   /* Statistics, printed on context destruction if MESA_VCACHE_STATS
+    * is set.
+    */
+   GLuint Draws;        /**< indexed draws looked at */
+   GLuint Compacted;    /**< ... which had their vertices compacted */
+   GLuint Indices;      /**< indices of the compacted draws */
+   GLuint Misses;       /**< vertices transformed for those indices */
+   GLuint RangeVerts;   /**< vertices between min_index and max_index */
+};
+
+
+/**
+ * Clipping statistics, printed on context destruction if MESA_CLIP_STATS
+ * is set.  The primitives are only counted in vertex buffers which have
+ * vertices outside the clip volume.
+ */
+struct tnl_clip_stats
+{
+   GLuint Buffers;      /**< vertex buffers rendered */
+   GLuint GuardBand;    /**< ... which were cliptested against the guard band */
+   GLuint Unclipped;    /**< ... with all vertices inside the clip volume */
+   GLuint Passed;       /**< primitives drawn without clipping */
+   GLuint Clipped;      /**< primitives clipped */
+   GLuint Rejected;     /**< primitives outside one of the clip planes */
+};
+
+
+/**
+ * Vertex arrays in buffer objects converted to floats by t_draw.c, reused
+ * until the buffer object's Stamp changes.
+ */
+struct tnl_converted_array
+{
+   const struct gl_buffer_object *obj;  /**< NULL if unused */
+   GLuint stamp;
+   const GLubyte *ptr;  /**< offset of the array in obj */
+   GLsizei stride;
+   GLenum type;
+   GLint size;
+   GLboolean normalized;
+   GLuint count;        /**< number of converted elements */
+   GLuint last_used;
+   GLfloat *data;
+   GLuint max_count;    /**< number of floats data has room for */
+};
+
+#define TNL_MAX_CONVERTED_ARRAYS 16
+
+
+struct tnl_vertex_threads;
+
+
 /**
  * Context state for T&L context.
  */
@@ -527,15 +595,33 @@ typedef struct
    GLboolean AllowPixelFog;
    GLboolean _DoVertexFog;  /* eval fog function at each vertex? */
 
+   /* Guard band clipping, see _tnl_allow_guard_band():
+    */
+   GLfloat GuardBandSize;   /**< in pixels, 0 if not allowed */
+   GLboolean _UseGuardBand; /**< cliptest the current VB with _GuardBand? */
+   GLfloat _GuardBand[2];   /**< guard band size relative to the viewport */
+
+   struct tnl_clip_stats clipstats;
+
    DECLARE_RENDERINPUTS(render_inputs_bitset);
 
    GLvector4f tmp_inputs[VERT_ATTRIB_MAX];
 
    /* Temp storage for t_draw.c: 
     */
-   GLubyte *block[VERT_ATTRIB_MAX];
+   GLubyte *block[VERT_ATTRIB_MAX + 3];
    GLuint nr_blocks;
 
+   struct tnl_vertex_cache vcache;
+
+   struct tnl_converted_array converted[TNL_MAX_CONVERTED_ARRAYS];
+   GLuint convert_count;  /**< for least recently used replacement */
+
+   /* Per-vertex stages run on several threads (t_vb_threads.c), or NULL
+    */
+   struct tnl_vertex_threads *Threads;
+   GLboolean _ThreadsActive;   /**< set while the threads run the stages */
+
 } TNLcontext;
 
 
@@ -543,6 +629,17 @@ typedef struct
 #define TNL_CONTEXT(ctx) ((TNLcontext *)((ctx)->swtnl_context))
 
 
+extern struct vertex_buffer *
+_tnl_thread_vb(void);
+
+/**
+ * The vertex buffer a pipeline stage works on.  While the vertex threads
+ * are running this is the calling thread's part of tnl->vb.
+ */
+#define TNL_VB(tnl)						\
+   ((tnl)->_ThreadsActive ? _tnl_thread_vb() : &(tnl)->vb)
+
+
 #define TYPE_IDX(t) ((t) & 0xf)
 #define MAX_TYPES TYPE_IDX(GL_DOUBLE)+1      /* 0xa + 1 */
 
@@ -32,6 +32,8 @@
 #include "main/mtypes.h"
 #include "main/macros.h"
 #include "main/enums.h"
+#include "main/bufferobj.h"
+#include "glapi/glthread.h"
 
 #include "t_context.h"
 #include "t_pipeline.h"
@@ -39,6 +41,10 @@
 #include "t_vertex.h"
 #include "tnl.h"
 
+#ifdef USE_X86_64_ASM
+#include "x86-64/x86-64.h"
+#endif
+
 
 
 static GLubyte *get_space(GLcontext *ctx, GLuint bytes)
@@ -63,48 +69,97 @@ static void free_space(GLcontext *ctx)
 
 /* Convert the incoming array to GLfloats.  Understands the
  * array->Normalized flag and selects the correct conversion method.
+ * If verts is non-null, only the listed elements are converted.
  */
+#define ELEMENT(i) (ptr + (verts ? verts[i] : (i)) * input->StrideB)
+
 #define CONVERT( TYPE, MACRO ) do {		\
    GLuint i, j;					\
    if (input->Normalized) {			\
       for (i = 0; i < count; i++) {		\
-	 const TYPE *in = (TYPE *)ptr;		\
+	 const TYPE *in = (TYPE *)ELEMENT(i);	\
 	 for (j = 0; j < sz; j++) {		\
 	    *fptr++ = MACRO(*in);		\
 	    in++;				\
 	 }					\
-	 ptr += input->StrideB;			\
       }						\
    } else {					\
       for (i = 0; i < count; i++) {		\
-	 const TYPE *in = (TYPE *)ptr;		\
+	 const TYPE *in = (TYPE *)ELEMENT(i);	\
 	 for (j = 0; j < sz; j++) {		\
 	    *fptr++ = (GLfloat)(*in);		\
 	    in++;				\
 	 }					\
-	 ptr += input->StrideB;			\
       }						\
    }						\
 } while (0)
 
 
 
+/* Populate VB->AttribPtr[] with an array of floats.
+ */
+static void set_attrib_array( GLcontext *ctx,
+			      GLuint attrib,
+			      GLuint count,
+			      GLint size,
+			      const GLubyte *ptr,
+			      GLuint stride )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct vertex_buffer *VB = &tnl->vb;
+
+   VB->AttribPtr[attrib] = &tnl->tmp_inputs[attrib];
+   VB->AttribPtr[attrib]->data = (GLfloat (*)[4])ptr;
+   VB->AttribPtr[attrib]->start = (GLfloat *)ptr;
+   VB->AttribPtr[attrib]->count = count;
+   VB->AttribPtr[attrib]->stride = stride;
+   VB->AttribPtr[attrib]->size = size;
+
+   /* This should die, but so should the whole GLvector4f concept: 
+    */
+   VB->AttribPtr[attrib]->flags = (((1<<size)-1) | 
+				   VEC_NOT_WRITEABLE |
+				   (stride == 4*sizeof(GLfloat) ? 0 : VEC_BAD_STRIDE));
+   
+   VB->AttribPtr[attrib]->storage = NULL;
+}
+
+
 /* Adjust pointer to point at first requested element, convert to
- * floating point, populate VB->AttribPtr[].
+ * floating point, populate VB->AttribPtr[].  If verts is non-null, the
+ * listed elements are gathered into temporary storage.  Non-float arrays
+ * are converted into dest if it's non-null.
  */
 static void _tnl_import_array( GLcontext *ctx,
 			       GLuint attrib,
 			       GLuint count,
+			       const GLuint *verts,
 			       const struct gl_client_array *input,
-			       const GLubyte *ptr )
+			       const GLubyte *ptr,
+			       GLfloat *dest )
 {
-   TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
    GLuint stride = input->StrideB;
 
-   if (input->Type != GL_FLOAT) {
+   if (input->Type == GL_FLOAT) {
+      if (verts && stride) {
+	 const GLuint sz = input->Size;
+	 GLfloat *fptr = (GLfloat *)get_space(ctx, count * sz * sizeof(GLfloat));
+	 GLuint i, j;
+
+	 for (i = 0; i < count; i++) {
+	    const GLfloat *in = (const GLfloat *)ELEMENT(i);
+	    for (j = 0; j < sz; j++)
+	       fptr[i * sz + j] = in[j];
+	 }
+
+	 ptr = (const GLubyte *)fptr;
+	 stride = sz * sizeof(GLfloat);
+      }
+   }
+   else {
       const GLuint sz = input->Size;
-      GLubyte *buf = get_space(ctx, count * sz * sizeof(GLfloat));
+      GLubyte *buf = dest ? (GLubyte *)dest
+	 : get_space(ctx, count * sz * sizeof(GLfloat));
       GLfloat *fptr = (GLfloat *)buf;
 
       switch (input->Type) {
@@ -112,9 +167,22 @@ static void _tnl_import_array( GLcontext *ctx,
 	 CONVERT(GLbyte, BYTE_TO_FLOAT); 
 	 break;
       case GL_UNSIGNED_BYTE: 
+#ifdef USE_X86_64_ASM
+	 if (!verts && input->Normalized && sz >= 3 && count > 1) {
+	    _mesa_sse2_convert_ubyte_norm(fptr, ptr, stride, sz, count);
+	    break;
+	 }
+#endif
 	 CONVERT(GLubyte, UBYTE_TO_FLOAT); 
 	 break;
       case GL_SHORT: 
+#ifdef USE_X86_64_ASM
+	 if (!verts && sz >= 2 && count > 1) {
+	    _mesa_sse2_convert_short(fptr, ptr, stride, sz, count,
+				     input->Normalized);
+	    break;
+	 }
+#endif
 	 CONVERT(GLshort, SHORT_TO_FLOAT); 
 	 break;
       case GL_UNSIGNED_SHORT: 
@@ -138,20 +206,102 @@ static void _tnl_import_array( GLcontext *ctx,
       stride = sz * sizeof(GLfloat);
    }
 
-   VB->AttribPtr[attrib] = &tnl->tmp_inputs[attrib];
-   VB->AttribPtr[attrib]->data = (GLfloat (*)[4])ptr;
-   VB->AttribPtr[attrib]->start = (GLfloat *)ptr;
-   VB->AttribPtr[attrib]->count = count;
-   VB->AttribPtr[attrib]->stride = stride;
-   VB->AttribPtr[attrib]->size = input->Size;
+   set_attrib_array(ctx, attrib, count, input->Size, ptr, stride);
+}
 
-   /* This should die, but so should the whole GLvector4f concept: 
-    */
-   VB->AttribPtr[attrib]->flags = (((1<<input->Size)-1) | 
-				   VEC_NOT_WRITEABLE |
-				   (stride == 4*sizeof(GLfloat) ? 0 : VEC_BAD_STRIDE));
-   
-   VB->AttribPtr[attrib]->storage = NULL;
+
+_glthread_DECLARE_STATIC_MUTEX(StampMutex);
+static GLuint StampCounter = 0;
+
+static GLuint new_stamp( void )
+{
+   GLuint stamp;
+
+   _glthread_LOCK_MUTEX(StampMutex);
+   if (++StampCounter == 0)
+      StampCounter = 1;
+   stamp = StampCounter;
+   _glthread_UNLOCK_MUTEX(StampMutex);
+
+   return stamp;
+}
+
+
+/* Vertex arrays in buffer objects usually don't change between draws, so
+ * non-float arrays are converted once and reused until the buffer
+ * object's stamp changes.  The converted arrays are identified by buffer
+ * object, offset, stride and type.
+ *
+ * Returns the cache entry for the first count elements of the array, or
+ * NULL if the array can't be cached.  If the entry's count is zero, the
+ * array needs to be converted into entry->data.
+ */
+static struct tnl_converted_array *
+lookup_converted_array( GLcontext *ctx,
+			const struct gl_client_array *input,
+			GLuint count )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct gl_buffer_object *obj = input->BufferObj;
+   struct tnl_converted_array *entry = NULL;
+   GLboolean found = GL_FALSE;
+   GLuint i;
+
+   if (!obj->Stamp) {
+      /* Only the application's buffer objects have their stamp zeroed
+       * when they are written; the vbo module's buffers aren't.
+       */
+      if (obj->Pointer || _mesa_lookup_bufferobj(ctx, obj->Name) != obj)
+	 return NULL;
+      obj->Stamp = new_stamp();
+   }
+
+   for (i = 0; i < TNL_MAX_CONVERTED_ARRAYS; i++) {
+      struct tnl_converted_array *c = &tnl->converted[i];
+
+      if (c->obj == obj &&
+	  c->ptr == input->Ptr &&
+	  c->stride == input->StrideB &&
+	  c->type == input->Type &&
+	  c->size == input->Size &&
+	  c->normalized == input->Normalized) {
+	 if (c->stamp != obj->Stamp || c->count < count)
+	    c->count = 0;
+	 entry = c;
+	 found = GL_TRUE;
+	 break;
+      }
+
+      if (!entry || c->last_used < entry->last_used)
+	 entry = c;
+   }
+
+   if (!found) {
+      /* replace the least recently used array */
+      entry->obj = obj;
+      entry->ptr = input->Ptr;
+      entry->stride = input->StrideB;
+      entry->type = input->Type;
+      entry->size = input->Size;
+      entry->normalized = input->Normalized;
+      entry->count = 0;
+   }
+
+   if (!entry->count && entry->max_count < count * input->Size) {
+      _mesa_free(entry->data);
+      entry->data = (GLfloat *)
+	 _mesa_malloc(count * input->Size * sizeof(GLfloat));
+      entry->max_count = count * input->Size;
+      if (!entry->data) {
+	 entry->obj = NULL;
+	 entry->max_count = 0;
+	 return NULL;
+      }
+   }
+
+   entry->stamp = obj->Stamp;
+   entry->last_used = ++tnl->convert_count;
+   return entry;
 }
 
 #define CLIPVERTS  ((6 + MAX_CLIP_PLANES) * 2)
@@ -179,6 +329,7 @@ static GLboolean *_tnl_import_edgeflag( GLcontext *ctx,
 static void bind_inputs( GLcontext *ctx, 
 			 const struct gl_client_array *inputs[],
 			 GLint count,
+			 const GLuint *verts,
 			 struct gl_buffer_object **bo,
 			 GLuint *nr_bo )
 {
@@ -189,9 +340,20 @@ static void bind_inputs( GLcontext *ctx,
    /* Map all the VBOs
     */
    for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      struct tnl_converted_array *converted = NULL;
       const void *ptr;
 
       if (inputs[i]->BufferObj->Name) { 
+	 if (!verts && inputs[i]->Type != GL_FLOAT) {
+	    converted = lookup_converted_array(ctx, inputs[i], count);
+	    if (converted && converted->count) {
+	       set_attrib_array(ctx, i, count, inputs[i]->Size,
+				(const GLubyte *)converted->data,
+				inputs[i]->Size * sizeof(GLfloat));
+	       continue;
+	    }
+	 }
+
 	 if (!inputs[i]->BufferObj->Pointer) {
 	    bo[*nr_bo] = inputs[i]->BufferObj;
 	    (*nr_bo)++;
@@ -215,10 +377,14 @@ static void bind_inputs( GLcontext *ctx,
        * XXX: remove the GLvector4f type at some stage and just use
        * client arrays.
        */
-      _tnl_import_array(ctx, i, count, inputs[i], ptr);
+      _tnl_import_array(ctx, i, count, verts, inputs[i], ptr,
+			converted ? converted->data : NULL);
+      if (converted)
+	 converted->count = count;
    }
 
-   /* We process only the vertices between min & max index:
+   /* We process only the vertices between min & max index, or the
+    * ones listed in verts:
     */
    VB->Count = count;
 
@@ -307,6 +473,90 @@ static void bind_indices( GLcontext *ctx,
    }
 }
 
+/* Indexed draws often reference just a few of the vertices between
+ * min_index and max_index.  Look each index up in the vertex cache so that
+ * every referenced vertex is copied and transformed only once, and point
+ * VB->Elts at indices into the compacted vertices.
+ *
+ * Returns the number of compacted vertices, or zero if compacting isn't
+ * worthwhile or there are more than max_verts of them.
+ */
+static GLuint compact_indices( GLcontext *ctx,
+			       const struct _mesa_prim *prim,
+			       GLuint nr_prims,
+			       const struct _mesa_index_buffer *ib,
+			       GLuint min_index,
+			       GLuint max_index,
+			       GLuint max_verts )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct vertex_buffer *VB = &tnl->vb;
+   struct tnl_vertex_cache *cache = &tnl->vcache;
+   const GLuint range = max_index - min_index + 1;
+   const GLuint *elts = VB->Elts;
+   GLuint *out, nr_verts = 0, nr_indices = 0, i, j;
+
+   if (range > cache->size) {
+      _mesa_free(cache->tag);
+      _mesa_free(cache->slot);
+      cache->tag = (GLuint *) _mesa_calloc(range * sizeof(GLuint));
+      cache->slot = (GLuint *) _mesa_malloc(range * sizeof(GLuint));
+      cache->size = range;
+      cache->stamp = 0;
+      if (!cache->tag || !cache->slot) {
+	 cache->size = 0;
+	 return 0;
+      }
+   }
+
+   if (!cache->verts) {
+      cache->verts = (GLuint *) _mesa_malloc(max_verts * sizeof(GLuint));
+      if (!cache->verts)
+	 return 0;
+   }
+
+   if (++cache->stamp == 0) {
+      _mesa_bzero(cache->tag, cache->size * sizeof(GLuint));
+      cache->stamp = 1;
+   }
+
+   out = (GLuint *) get_space(ctx, ib->count * sizeof(GLuint));
+
+   for (i = 0; i < nr_prims; i++) {
+      for (j = prim[i].start; j < prim[i].start + prim[i].count; j++) {
+	 const GLuint e = elts[j] - min_index;
+
+	 if (e >= range)
+	    return 0;
+
+	 if (cache->tag[e] != cache->stamp) {
+	    if (nr_verts == max_verts)
+	       return 0;
+	    cache->tag[e] = cache->stamp;
+	    cache->slot[e] = nr_verts;
+	    cache->verts[nr_verts++] = elts[j];
+	 }
+
+	 out[j] = cache->slot[e];
+      }
+      nr_indices += prim[i].count;
+   }
+
+   /* Gathering the vertices costs something too.
+    */
+   if (range <= max_verts && nr_verts > range - range / 8)
+      return 0;
+
+   cache->Compacted++;
+   cache->Indices += nr_indices;
+   cache->Misses += nr_verts;
+   cache->RangeVerts += range;
+
+   VB->Elts = out;
+   return nr_verts;
+}
+
+
 static void bind_prims( GLcontext *ctx,
 			const struct _mesa_prim *prim,
 			GLuint nr_prims )
@@ -359,6 +609,41 @@ void _tnl_draw_prims( GLcontext *ctx,
 		      prim[i].count);
    }
 
+   if (ib && tnl->vcache.Enabled) {
+      /* Transform only the vertices referenced by the indices, if there
+       * are fewer indices than vertices in the range, or if that avoids
+       * splitting the draw.
+       */
+      GLuint nr_indices = 0, i;
+
+      for (i = 0; i < nr_prims; i++)
+	 nr_indices += prim[i].count;
+
+      tnl->vcache.Draws++;
+
+      if (nr_indices < max_index - min_index + 1 ||
+	  max_index - min_index > (GLuint) max) {
+	 struct gl_buffer_object *bo[VERT_ATTRIB_MAX + 1];
+	 GLuint nr_bo = 0, nr_verts;
+
+	 bind_indices(ctx, ib, bo, &nr_bo);
+	 nr_verts = compact_indices(ctx, prim, nr_prims, ib,
+				    min_index, max_index, max);
+	 if (nr_verts) {
+	    bind_inputs(ctx, arrays, nr_verts, tnl->vcache.verts, bo, &nr_bo);
+	    bind_prims(ctx, prim, nr_prims);
+
+	    TNL_CONTEXT(ctx)->Driver.RunPipeline(ctx);
+	 }
+
+	 unmap_vbos(ctx, bo, nr_bo);
+	 free_space(ctx);
+
+	 if (nr_verts)
+	    return;
+      }
+   }
+
    if (min_index) {
       /* We always translate away calls with min_index != 0. 
        */
@@ -395,7 +680,7 @@ void _tnl_draw_prims( GLcontext *ctx,
       /* Binding inputs may imply mapping some vertex buffer objects.
        * They will need to be unmapped below.
        */
-      bind_inputs(ctx, arrays, max_index+1, bo, &nr_bo);
+      bind_inputs(ctx, arrays, max_index+1, NULL, bo, &nr_bo);
       bind_indices(ctx, ib, bo, &nr_bo);
       bind_prims(ctx, prim, nr_prims );
 
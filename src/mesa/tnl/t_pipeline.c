@@ -28,11 +28,14 @@
 #include "main/glheader.h"
 #include "main/context.h"
 #include "main/imports.h"
+#include "main/macros.h"
 #include "main/state.h"
 #include "main/mtypes.h"
+#include "main/profile.h"
 
 #include "t_context.h"
 #include "t_pipeline.h"
+#include "t_vb_threads.h"
 #include "t_vp_build.h"
 #include "t_vertex.h"
 
@@ -44,6 +47,8 @@ void _tnl_install_pipeline( GLcontext *ctx,
 
    tnl->pipeline.new_state = ~0;
 
+   _tnl_free_vertex_thread_stages( ctx );
+
    /* Create a writeable copy of each stage.
     */
    for (i = 0 ; i < MAX_PIPELINE_STAGES && stages[i] ; i++) {
@@ -61,6 +66,8 @@ void _tnl_destroy_pipeline( GLcontext *ctx )
    TNLcontext *tnl = TNL_CONTEXT(ctx);
    GLuint i;
 
+   _tnl_free_vertex_thread_stages( ctx );
+
    for (i = 0 ; i < tnl->pipeline.nr_stages ; i++) {
       struct tnl_pipeline_stage *s = &tnl->pipeline.stages[i];
       if (s->destroy)
@@ -118,9 +125,50 @@ static GLuint check_output_changes( GLcontext *ctx )
 }
 
 
+/**
+ * Decide whether the vertices of the current VB are cliptested against
+ * the guard band.  The rasterizer only clips to the drawing rectangle,
+ * so that must lie within the viewport, and only filled triangles may be
+ * drawn: points and lines are discarded or clipped at the viewport edges.
+ */
+static void update_guard_band( GLcontext *ctx )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   const struct gl_viewport_attrib *vp = &ctx->Viewport;
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   GLuint i;
+
+   tnl->_UseGuardBand = GL_FALSE;
+
+   if (tnl->GuardBandSize <= 0.0F ||
+       !tnl->NeedNdcCoords ||
+       ctx->RenderMode != GL_RENDER ||
+       ctx->Polygon.FrontMode != GL_FILL ||
+       ctx->Polygon.BackMode != GL_FILL ||
+       vp->Width <= 0 || vp->Height <= 0)
+      return;
+
+   if (fb->_Xmin < vp->X || fb->_Xmax > vp->X + vp->Width ||
+       fb->_Ymin < vp->Y || fb->_Ymax > vp->Y + vp->Height)
+      return;
+
+   for (i = 0; i < tnl->vb.PrimitiveCount; i++) {
+      if (tnl->vb.Primitive[i].mode < GL_TRIANGLES)
+         return;
+   }
+
+   tnl->_GuardBand[0] = MAX2(tnl->GuardBandSize / vp->Width, 1.0F);
+   tnl->_GuardBand[1] = MAX2(tnl->GuardBandSize / vp->Height, 1.0F);
+   tnl->_UseGuardBand = (tnl->_GuardBand[0] > 1.0F ||
+                         tnl->_GuardBand[1] > 1.0F);
+}
+
+
 void _tnl_run_pipeline( GLcontext *ctx )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct gl_profile *prof = ctx->Profile;
+   GLuint64EXT t = 0;
    unsigned short __tmp;
    GLuint i;
 
@@ -139,6 +187,7 @@ void _tnl_run_pipeline( GLcontext *ctx )
 	 if (s->validate)
 	    s->validate( ctx, s );
       }
+      _tnl_invalidate_vertex_threads( ctx );
       
       tnl->pipeline.new_state = 0;
       tnl->pipeline.input_changes = 0;
@@ -151,11 +200,24 @@ void _tnl_run_pipeline( GLcontext *ctx )
 	 _tnl_notify_pipeline_output_change( ctx );
    }
 
+   update_guard_band( ctx );
+
    START_FAST_MATH(__tmp);
 
-   for (i = 0; i < tnl->pipeline.nr_stages ; i++) {
+   PROFILE_START(prof, t);
+
+   /* Large vertex buffers may go through the per-vertex stages on
+    * several threads.  The remaining stages are run here.
+    */
+   i = _tnl_run_vertex_threads( ctx );
+   if (i)
+      PROFILE_LAP(prof, t, "tnl vertex threads");
+
+   for ( ; i < tnl->pipeline.nr_stages ; i++) {
       struct tnl_pipeline_stage *s = &tnl->pipeline.stages[i];
-      if (!s->run( ctx, s ))
+      const GLboolean more = s->run( ctx, s );
+      PROFILE_LAP(prof, t, s->name);
+      if (!more)
 	 break;
    }
 
@@ -54,6 +54,8 @@ extern const struct tnl_pipeline_stage _tnl_point_attenuation_stage;
 extern const struct tnl_pipeline_stage _tnl_vertex_program_stage;
 extern const struct tnl_pipeline_stage _tnl_render_stage;
 
+extern void _tnl_load_vp_parameters( GLcontext *ctx );
+
 /* Shorthand to plug in the default pipeline:
  */
 extern const struct tnl_pipeline_stage *_tnl_default_pipeline[];
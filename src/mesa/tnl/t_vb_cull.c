@@ -47,7 +47,7 @@ static GLboolean run_cull_stage( GLcontext *ctx,
 				 struct tnl_pipeline_stage *stage )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
 
    const GLfloat a = ctx->Transform.CullObjPos[0];
    const GLfloat b = ctx->Transform.CullObjPos[1];
@@ -144,7 +144,7 @@ static GLboolean
 run_fog_stage(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
    struct fog_stage_data *store = FOG_STAGE_DATA(stage);
    GLvector4f *input;
 
@@ -245,7 +245,7 @@ alloc_fog_data(GLcontext *ctx, struct tnl_pipeline_stage *stage)
    if (!store)
       return GL_FALSE;
 
-   _mesa_vector4f_alloc( &store->fogcoord, 0, tnl->vb.Size, 32 );
+   _mesa_vector4f_alloc( &store->fogcoord, 0, TNL_VB(tnl)->Size, 32 );
 
    if (!inited)
       init_static_data();
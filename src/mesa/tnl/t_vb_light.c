@@ -37,6 +37,10 @@
 #include "t_context.h"
 #include "t_pipeline.h"
 
+#ifdef USE_X86_64_ASM
+#include "x86-64/x86-64.h"
+#endif
+
 #define LIGHT_TWOSIDE       0x1
 #define LIGHT_MATERIAL      0x2
 #define MAX_LIGHT_FUNC      0x4
@@ -149,8 +153,14 @@ prepare_materials(GLcontext *ctx,
 
    /* FIXME: Is this already done?
     */
-   _mesa_update_material( ctx, ~0 );
-   _mesa_validate_all_lighting_tables( ctx );
+   /* Both calls write shared context state, so the vertex threads can't
+    * make them concurrently.  While they run, _tnl_run_vertex_threads()
+    * has already made them on the calling thread before starting them.
+    */
+   if (!TNL_CONTEXT(ctx)->_ThreadsActive) {
+      _mesa_update_material( ctx, ~0 );
+      _mesa_validate_all_lighting_tables( ctx );
+   }
 
    return store->mat_count;
 }
@@ -180,6 +190,101 @@ static light_func _tnl_light_ci_tab[MAX_LIGHT_FUNC];
 #include "t_vb_lighttmp.h"
 
 
+#ifdef USE_X86_64_ASM
+
+/* The tables above, with the SoA functions below in place of the ones
+ * without per-vertex materials.
+ */
+static light_func _tnl_light_soa_tab[MAX_LIGHT_FUNC];
+static light_func _tnl_light_fast_soa_tab[MAX_LIGHT_FUNC];
+static light_func _tnl_light_spec_soa_tab[MAX_LIGHT_FUNC];
+
+/**
+ * Light the vertices with _mesa_x86_64_light_rgba(), which works on
+ * several vertices at once.  The flags select which of light_rgba(),
+ * light_rgba_spec() or light_fast_rgba() it stands in for.
+ */
+static void light_soa( GLcontext *ctx,
+		       struct vertex_buffer *VB,
+		       struct tnl_pipeline_stage *stage,
+		       GLvector4f *input,
+		       GLuint flags )
+{
+   struct light_stage_data *store = LIGHT_STAGE_DATA(stage);
+   const GLvector4f *normal = VB->AttribPtr[_TNL_ATTRIB_NORMAL];
+   GLfloat (*color[2])[4], (*secondary[2])[4];
+   GLuint nr = VB->Count;
+   GLuint side;
+
+   if (ctx->Light.Model.TwoSide)
+      flags |= X86_64_LIGHT_TWOSIDE;
+
+   for (side = 0; side < 2; side++) {
+      color[side] = (GLfloat (*)[4]) store->LitColor[side].data;
+      secondary[side] = (GLfloat (*)[4]) store->LitSecondary[side].data;
+      store->LitColor[side].stride = 16;
+   }
+
+   VB->ColorPtr[0] = &store->LitColor[0];
+   if (flags & X86_64_LIGHT_TWOSIDE)
+      VB->ColorPtr[1] = &store->LitColor[1];
+
+   if (flags & X86_64_LIGHT_SPEC) {
+      VB->SecondaryColorPtr[0] = &store->LitSecondary[0];
+      if (flags & X86_64_LIGHT_TWOSIDE)
+	 VB->SecondaryColorPtr[1] = &store->LitSecondary[1];
+   }
+
+   if (flags & X86_64_LIGHT_INFINITE) {
+      nr = normal->count;
+      if (nr <= 1) {
+	 store->LitColor[0].stride = 0;
+	 store->LitColor[1].stride = 0;
+      }
+   }
+
+   _mesa_x86_64_light_rgba( ctx,
+			    (const GLfloat *) input->data, input->stride,
+			    (const GLfloat *) normal->data, normal->stride,
+			    nr, color, secondary, flags );
+}
+
+static void light_rgba_soa( GLcontext *ctx,
+			    struct vertex_buffer *VB,
+			    struct tnl_pipeline_stage *stage,
+			    GLvector4f *input )
+{
+   light_soa( ctx, VB, stage, input, 0 );
+}
+
+static void light_rgba_spec_soa( GLcontext *ctx,
+				 struct vertex_buffer *VB,
+				 struct tnl_pipeline_stage *stage,
+				 GLvector4f *input )
+{
+   light_soa( ctx, VB, stage, input, X86_64_LIGHT_SPEC );
+}
+
+static void light_fast_rgba_soa( GLcontext *ctx,
+				 struct vertex_buffer *VB,
+				 struct tnl_pipeline_stage *stage,
+				 GLvector4f *input )
+{
+   light_soa( ctx, VB, stage, input, X86_64_LIGHT_INFINITE );
+}
+
+static void init_soa_tab( light_func *soa_tab, const light_func *tab,
+			  light_func func )
+{
+   soa_tab[0] = func;
+   soa_tab[LIGHT_TWOSIDE] = func;
+   soa_tab[LIGHT_MATERIAL] = tab[LIGHT_MATERIAL];
+   soa_tab[LIGHT_TWOSIDE|LIGHT_MATERIAL] = tab[LIGHT_TWOSIDE|LIGHT_MATERIAL];
+}
+
+#endif /* USE_X86_64_ASM */
+
+
 static void init_lighting_tables( void )
 {
    static int done;
@@ -189,6 +294,13 @@ static void init_lighting_tables( void )
       init_light_tab_twoside();
       init_light_tab_material();
       init_light_tab_twoside_material();
+#ifdef USE_X86_64_ASM
+      init_soa_tab(_tnl_light_soa_tab, _tnl_light_tab, light_rgba_soa);
+      init_soa_tab(_tnl_light_spec_soa_tab, _tnl_light_spec_tab,
+		   light_rgba_spec_soa);
+      init_soa_tab(_tnl_light_fast_soa_tab, _tnl_light_fast_tab,
+		   light_fast_rgba_soa);
+#endif
       done = 1;
    }
 }
@@ -199,7 +311,7 @@ static GLboolean run_lighting( GLcontext *ctx,
 {
    struct light_stage_data *store = LIGHT_STAGE_DATA(stage);
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
    GLvector4f *input = ctx->_NeedEyeCoords ? VB->EyePtr : VB->ObjPtr;
    GLuint idx;
 
@@ -277,6 +389,18 @@ static void validate_lighting( GLcontext *ctx,
 	 else
 	    tab = _tnl_light_fast_tab;
       }
+
+#ifdef USE_X86_64_ASM
+      /* Use the SoA functions if the CPU has SSE2 or AVX2 */
+      if (_mesa_x86_64_light_rgba) {
+	 if (tab == _tnl_light_tab)
+	    tab = _tnl_light_soa_tab;
+	 else if (tab == _tnl_light_spec_tab)
+	    tab = _tnl_light_spec_soa_tab;
+	 else if (tab == _tnl_light_fast_tab)
+	    tab = _tnl_light_fast_soa_tab;
+      }
+#endif
    }
    else
       tab = _tnl_light_ci_tab;
@@ -299,7 +423,7 @@ static GLboolean init_lighting( GLcontext *ctx,
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
    struct light_stage_data *store;
-   GLuint size = tnl->vb.Size;
+   GLuint size = TNL_VB(tnl)->Size;
 
    stage->privatePtr = MALLOC(sizeof(*store));
    store = LIGHT_STAGE_DATA(stage);
@@ -51,7 +51,7 @@ static GLboolean
 run_normal_stage(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
    struct normal_stage_data *store = NORMAL_STAGE_DATA(stage);
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    const GLfloat *lengths;
 
    if (!store->NormalTransform)
@@ -158,7 +158,7 @@ alloc_normal_data(GLcontext *ctx, struct tnl_pipeline_stage *stage)
    if (!store)
       return GL_FALSE;
 
-   _mesa_vector4f_alloc( &store->normal, 0, tnl->vb.Size, 32 );
+   _mesa_vector4f_alloc( &store->normal, 0, TNL_VB(tnl)->Size, 32 );
    return GL_TRUE;
 }
 
@@ -49,7 +49,7 @@ run_point_stage(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
    if (ctx->Point._Attenuated && !ctx->VertexProgram._Current) {
       struct point_stage_data *store = POINT_STAGE_DATA(stage);
-      struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+      struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
       const GLfloat *eyeCoord = (GLfloat *) VB->EyePtr->data + 2;
       const GLint eyeCoordStride = VB->EyePtr->stride / sizeof(GLfloat);
       const GLfloat p0 = ctx->Point.Params[0];
@@ -77,7 +77,7 @@ run_point_stage(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 static GLboolean
 alloc_point_data(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    struct point_stage_data *store;
    stage->privatePtr = _mesa_malloc(sizeof(*store));
    store = POINT_STAGE_DATA(stage);
@@ -44,6 +44,7 @@
 #include "tnl/tnl.h"
 #include "tnl/t_context.h"
 #include "tnl/t_pipeline.h"
+#include "tnl/t_vp_soa.h"
 
 
 
@@ -57,6 +58,9 @@ struct vp_stage_data {
    GLvector4f ndcCoords;              /**< normalized device coords */
    GLubyte *clipmask;                 /**< clip flags */
    GLubyte ormask, andmask;           /**< for clipping */
+
+   struct tnl_vp_cache *cache;        /**< translated vertex programs */
+   struct tnl_vp_code *code;          /**< translation of current program */
 };
 
 
@@ -113,14 +117,23 @@ static GLboolean
 do_ndc_cliptest(GLcontext *ctx, struct vp_stage_data *store)
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
    /* Cliptest and perspective divide.  Clip functions must clear
     * the clipmask.
     */
    store->ormask = 0;
    store->andmask = CLIP_FRUSTUM_BITS;
 
-   if (tnl->NeedNdcCoords) {
+   if (tnl->_UseGuardBand) {
+      VB->NdcPtr =
+         _mesa_clip_gb_tab[VB->ClipPtr->size]( VB->ClipPtr,
+                                               &store->ndcCoords,
+                                               store->clipmask,
+                                               &store->ormask,
+                                               &store->andmask,
+                                               tnl->_GuardBand );
+   }
+   else if (tnl->NeedNdcCoords) {
       VB->NdcPtr =
          _mesa_clip_tab[VB->ClipPtr->size]( VB->ClipPtr,
                                             &store->ndcCoords,
@@ -291,6 +304,24 @@ unmap_textures(GLcontext *ctx, const struct gl_vertex_program *vp)
 }
 
 
+/**
+ * Update the state-tracked parameters of the current vertex program.
+ */
+void
+_tnl_load_vp_parameters(GLcontext *ctx)
+{
+   struct gl_vertex_program *program = ctx->VertexProgram._Current;
+
+   if (program->IsNVProgram) {
+      _mesa_load_tracked_matrices(ctx);
+   }
+   else {
+      /* ARB program or vertex shader */
+      _mesa_load_state_parameters(ctx, program->Base.Parameters);
+   }
+}
+
+
 /**
  * This function executes vertex programs
  */
@@ -299,7 +330,7 @@ run_vp( GLcontext *ctx, struct tnl_pipeline_stage *stage )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
    struct vp_stage_data *store = VP_STAGE_DATA(stage);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
    struct gl_vertex_program *program = ctx->VertexProgram._Current;
    struct gl_program_machine machine;
    GLuint outputs[VERT_RESULT_MAX], numOutputs;
@@ -308,13 +339,11 @@ run_vp( GLcontext *ctx, struct tnl_pipeline_stage *stage )
    if (!program)
       return GL_TRUE;
 
-   if (program->IsNVProgram) {
-      _mesa_load_tracked_matrices(ctx);
-   }
-   else {
-      /* ARB program or vertex shader */
-      _mesa_load_state_parameters(ctx, program->Base.Parameters);
-   }
+   /* The vertex threads share the parameters, which are loaded once
+    * before they start.
+    */
+   if (!tnl->_ThreadsActive)
+      _tnl_load_vp_parameters(ctx);
 
    /* make list of outputs to save some time below */
    numOutputs = 0;
@@ -326,7 +355,16 @@ run_vp( GLcontext *ctx, struct tnl_pipeline_stage *stage )
 
    map_textures(ctx, program);
 
-   for (i = 0; i < VB->Count; i++) {
+   /* Run the whole vertex buffer through the translated program if
+    * possible, else interpret the program one vertex at a time.
+    */
+   if (store->code &&
+       _tnl_run_vp_code(ctx, store->cache, store->code, VB, store->results))
+      i = VB->Count;
+   else
+      i = 0;
+
+   for ( ; i < VB->Count; i++) {
       GLuint attr;
 
       init_machine(ctx, &machine);
@@ -469,7 +507,7 @@ static GLboolean
 init_vp(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &(tnl->vb);
+   struct vertex_buffer *VB = TNL_VB(tnl);
    struct vp_stage_data *store;
    const GLuint size = VB->Size;
    GLuint i;
@@ -489,6 +527,12 @@ init_vp(GLcontext *ctx, struct tnl_pipeline_stage *stage)
    _mesa_vector4f_alloc( &store->ndcCoords, 0, size, 32 );
    store->clipmask = (GLubyte *) ALIGN_MALLOC(sizeof(GLubyte)*size, 32 );
 
+   store->code = NULL;
+   if (_mesa_getenv("MESA_NO_VP_COMPILE"))
+      store->cache = NULL;
+   else
+      store->cache = _tnl_create_vp_cache();
+
    return GL_TRUE;
 }
 
@@ -512,6 +556,8 @@ dtr(struct tnl_pipeline_stage *stage)
       _mesa_vector4f_free( &store->ndcCoords );
       ALIGN_FREE( store->clipmask );
 
+      _tnl_destroy_vp_cache( store->cache );
+
       FREE( store );
       stage->privatePtr = NULL;
    }
@@ -521,9 +567,19 @@ dtr(struct tnl_pipeline_stage *stage)
 static void
 validate_vp_stage(GLcontext *ctx, struct tnl_pipeline_stage *stage)
 {
+   struct vp_stage_data *store = VP_STAGE_DATA(stage);
+
    if (ctx->VertexProgram._Current) {
       _swrast_update_texture_samplers(ctx);
    }
+
+   if (store && store->cache && ctx->VertexProgram._Current) {
+      store->code = _tnl_lookup_vp_code(store->cache,
+                                        ctx->VertexProgram._Current);
+   }
+   else if (store) {
+      store->code = NULL;
+   }
 }
 
 
@@ -86,20 +86,32 @@
 do {						\
    GLubyte c1 = mask[v1], c2 = mask[v2];	\
    GLubyte ormask = c1|c2;			\
-   if (!ormask)					\
+   if (!ormask) {				\
       LineFunc( ctx, v1, v2 );			\
-   else if (!(c1 & c2 & CLIPMASK))			\
+      stats->Passed++;				\
+   }						\
+   else if (!(c1 & c2 & CLIPMASK)) {		\
       clip_line_4( ctx, v1, v2, ormask );	\
+      stats->Clipped++;				\
+   }						\
+   else						\
+      stats->Rejected++;			\
 } while (0)
 
 #define RENDER_TRI( v1, v2, v3 )			\
 do {							\
    GLubyte c1 = mask[v1], c2 = mask[v2], c3 = mask[v3];	\
    GLubyte ormask = c1|c2|c3;				\
-   if (!ormask)						\
+   if (!ormask) {					\
       TriangleFunc( ctx, v1, v2, v3 );			\
-   else if (!(c1 & c2 & c3 & CLIPMASK)) 			\
+      stats->Passed++;					\
+   }							\
+   else if (!(c1 & c2 & c3 & CLIPMASK)) {		\
       clip_tri_4( ctx, v1, v2, v3, ormask );    	\
+      stats->Clipped++;					\
+   }							\
+   else							\
+      stats->Rejected++;				\
 } while (0)
 
 #define RENDER_QUAD( v1, v2, v3, v4 )			\
@@ -107,10 +119,16 @@ do {							\
    GLubyte c1 = mask[v1], c2 = mask[v2];		\
    GLubyte c3 = mask[v3], c4 = mask[v4];		\
    GLubyte ormask = c1|c2|c3|c4;			\
-   if (!ormask)						\
+   if (!ormask) {					\
       QuadFunc( ctx, v1, v2, v3, v4 );			\
-   else if (!(c1 & c2 & c3 & c4 & CLIPMASK)) 		\
+      stats->Passed++;					\
+   }							\
+   else if (!(c1 & c2 & c3 & c4 & CLIPMASK)) {		\
       clip_quad_4( ctx, v1, v2, v3, v4, ormask );	\
+      stats->Clipped++;					\
+   }							\
+   else							\
+      stats->Rejected++;				\
 } while (0)
 
 
@@ -124,8 +142,9 @@ do {							\
    const tnl_triangle_func TriangleFunc = tnl->Driver.Render.Triangle;	\
    const tnl_quad_func QuadFunc = tnl->Driver.Render.Quad;		\
    const GLboolean stipple = ctx->Line.StippleFlag;		\
+   struct tnl_clip_stats *stats = &tnl->clipstats;		\
    (void) (LineFunc && TriangleFunc && QuadFunc);		\
-   (void) elt; (void) mask; (void) sz; (void) stipple;
+   (void) elt; (void) mask; (void) sz; (void) stipple; (void) stats;
 
 #define TAG(x) clip_##x##_verts
 #define INIT(x) tnl->Driver.Render.PrimitiveNotify( ctx, x )
@@ -155,6 +174,7 @@ static void clip_elt_triangles( GLcontext *ctx,
    struct vertex_buffer *VB = &tnl->vb;
    const GLuint * const elt = VB->Elts;
    GLubyte *mask = VB->ClipMask;
+   struct tnl_clip_stats *stats = &tnl->clipstats;
    GLuint last = count-2;
    GLuint j;
    (void) flags;
@@ -167,16 +187,24 @@ static void clip_elt_triangles( GLcontext *ctx,
       GLubyte c3 = mask[elt[j+2]];
       GLubyte ormask = c1|c2|c3;
       if (ormask) {
-	 if (start < j)
+	 if (start < j) {
 	    render_tris( ctx, start, j, 0 );
-	 if (!(c1&c2&c3&CLIPMASK))
+	    stats->Passed += (j - start) / 3;
+	 }
+	 if (!(c1&c2&c3&CLIPMASK)) {
 	    clip_tri_4( ctx, elt[j], elt[j+1], elt[j+2], ormask );
+	    stats->Clipped++;
+	 }
+	 else
+	    stats->Rejected++;
 	 start = j+3;
       }
    }
 
-   if (start < j)
+   if (start < j) {
       render_tris( ctx, start, j, 0 );
+      stats->Passed += (j - start) / 3;
+   }
 }
 
 /**********************************************************************/
@@ -289,6 +317,12 @@ static GLboolean run_render( GLcontext *ctx,
 
    tnl->Driver.Render.BuildVertices( ctx, 0, VB->Count, ~0 );
 
+   tnl->clipstats.Buffers++;
+   if (tnl->_UseGuardBand)
+      tnl->clipstats.GuardBand++;
+   if (!VB->ClipOrMask)
+      tnl->clipstats.Unclipped++;
+
    if (VB->ClipOrMask) {
       tab = VB->Elts ? clip_render_tab_elts : clip_render_tab_verts;
       clip_render_tab_elts[GL_TRIANGLES] = clip_elt_triangles;
@@ -253,7 +253,7 @@ static void texgen_reflection_map_nv( GLcontext *ctx,
 				      struct texgen_stage_data *store,
 				      GLuint unit )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    GLvector4f *in = VB->AttribPtr[VERT_ATTRIB_TEX0 + unit];
    GLvector4f *out = &store->texcoord[unit];
 
@@ -275,7 +275,7 @@ static void texgen_normal_map_nv( GLcontext *ctx,
 				  struct texgen_stage_data *store,
 				  GLuint unit )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    GLvector4f *in = VB->AttribPtr[VERT_ATTRIB_TEX0 + unit];
    GLvector4f *out = &store->texcoord[unit];
    GLvector4f *normal = VB->AttribPtr[_TNL_ATTRIB_NORMAL];
@@ -303,7 +303,7 @@ static void texgen_sphere_map( GLcontext *ctx,
 			       struct texgen_stage_data *store,
 			       GLuint unit )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    GLvector4f *in = VB->AttribPtr[VERT_ATTRIB_TEX0 + unit];
    GLvector4f *out = &store->texcoord[unit];
    GLfloat (*texcoord)[4] = (GLfloat (*)[4]) out->start;
@@ -337,7 +337,7 @@ static void texgen( GLcontext *ctx,
 		    GLuint unit )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
    GLvector4f *in = VB->AttribPtr[VERT_ATTRIB_TEX0 + unit];
    GLvector4f *out = &store->texcoord[unit];
    const struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
@@ -484,7 +484,7 @@ static void texgen( GLcontext *ctx,
 static GLboolean run_texgen_stage( GLcontext *ctx,
 				   struct tnl_pipeline_stage *stage )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    struct texgen_stage_data *store = TEXGEN_STAGE_DATA(stage);
    GLuint i;
 
@@ -560,7 +560,7 @@ static void validate_texgen_stage( GLcontext *ctx,
 static GLboolean alloc_texgen_data( GLcontext *ctx,
 				    struct tnl_pipeline_stage *stage )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    struct texgen_stage_data *store;
    GLuint i;
 
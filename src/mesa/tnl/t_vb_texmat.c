@@ -58,7 +58,7 @@ static GLboolean run_texmat_stage( GLcontext *ctx,
 				   struct tnl_pipeline_stage *stage )
 {
    struct texmat_stage_data *store = TEXMAT_STAGE_DATA(stage);
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    GLuint i;
 
    if (!ctx->Texture._TexMatEnabled || ctx->VertexProgram._Current) 
@@ -87,7 +87,7 @@ static GLboolean run_texmat_stage( GLcontext *ctx,
 static GLboolean alloc_texmat_data( GLcontext *ctx,
 				    struct tnl_pipeline_stage *stage )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    struct texmat_stage_data *store;
    GLuint i;
 
@@ -0,0 +1,712 @@
+/**
+ * \file tnl/t_vb_threads.c
+ * \brief Run the per-vertex pipeline stages on several threads.
+ *
+ * When enabled with MESA_TNL_THREADS=n (n > 1), large vertex buffers are
+ * split into up to n slices of consecutive vertices.  Each slice has its
+ * own vertex_buffer and its own copies of the per-vertex stages at the
+ * head of the pipeline (transformation, lighting, texgen, fog, vertex
+ * programs, ...), and the slices are run by a pool of threads.  The
+ * stages find their vertex buffer with TNL_VB(), which returns the slice
+ * of the calling thread while tnl->_ThreadsActive is set.
+ *
+ * Afterwards the vectors written by the stages are copied from the
+ * slices into full-size vectors, tnl->vb is pointed at those and the
+ * remaining stages (clipping and rendering) run in order on the calling
+ * thread.  The stages do exactly the same arithmetic on each vertex as
+ * when the whole buffer is processed at once.
+ *
+ * Whatever can't be split this way -- materials changing per vertex,
+ * vertex programs fetching texels, a stage ending the pipeline early for
+ * one of the slices -- is left to the normal single-threaded pipeline.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/light.h"
+#include "main/macros.h"
+#include "main/threadpool.h"
+#include "glapi/glthread.h"
+#include "math/m_vector.h"
+
+#include "t_context.h"
+#include "t_pipeline.h"
+#include "t_vb_threads.h"
+
+
+/** Fewest vertices worth handing to a thread */
+#define MIN_SLICE_VERTS 256
+
+/**
+ * Number of vector pointers in a vertex_buffer, see get_slots().  The
+ * first STAGE_SLOTS of them are only set by the stages.
+ */
+#define STAGE_SLOTS 3
+#define MAX_SLOTS (STAGE_SLOTS + 9 + MAX_TEXTURE_COORD_UNITS + _TNL_ATTRIB_MAX)
+
+/** Slot map values other than input numbers */
+#define SLOT_NULL    0x100   /**< pointer is NULL */
+#define SLOT_KEEP    0x101   /**< not touched by the stages */
+#define SLOT_OUTPUT  0x200   /**< SLOT_OUTPUT + n: n-th output vector */
+
+
+/**
+ * A range of consecutive vertices and the stages processing it.
+ */
+struct tnl_vertex_slice {
+   struct vertex_buffer vb;
+   struct tnl_pipeline_stage stages[MAX_PIPELINE_STAGES];
+   GLvector4f Inputs[MAX_SLOTS];   /**< parts of the tnl->vb inputs */
+   GLvector4f Unset;               /**< initial value of the stage slots */
+   GLuint Start;                   /**< index of the first vertex in tnl->vb */
+   GLboolean Finished;             /**< a stage ended the pipeline */
+
+   /* What the stages left in each slot of vb, see run_slice() */
+   GLuint Map[MAX_SLOTS];
+   GLvector4f *Outputs[MAX_SLOTS];
+   GLuint NumOutputs;
+};
+
+
+struct tnl_vertex_threads {
+   struct _mesa_threadpool *Pool;
+   GLuint NumThreads;
+   struct tnl_vertex_slice *Slices;  /**< [NumThreads] */
+
+   GLuint NumStages;        /**< per-vertex stages copied into the slices */
+   GLboolean HaveStages;    /**< have the copies been created? */
+   GLboolean NeedValidate;  /**< validate the copies before next use */
+
+   GLvector4f *Inputs[MAX_SLOTS];  /**< distinct vectors in tnl->vb */
+   GLuint NumInputs;
+   GLuint InputMap[MAX_SLOTS];     /**< input number of each tnl->vb slot */
+
+   GLvector4f Outputs[MAX_SLOTS];  /**< the slices' outputs, put together */
+   GLubyte *ClipMask;
+};
+
+
+/**
+ * The stages which may be run on slices.  They only look at the vertices
+ * of the buffer one at a time.
+ */
+static const struct tnl_pipeline_stage *vertex_stages[] = {
+   &_tnl_vertex_transform_stage,
+   &_tnl_vertex_cull_stage,
+   &_tnl_normal_transform_stage,
+   &_tnl_lighting_stage,
+   &_tnl_fog_coordinate_stage,
+   &_tnl_texgen_stage,
+   &_tnl_texture_transform_stage,
+   &_tnl_point_attenuation_stage,
+   &_tnl_vertex_program_stage,
+   NULL
+};
+
+
+/** Identifies the slice of the calling thread */
+static _glthread_TSD SliceTSD;
+
+
+/**
+ * Return the vertex buffer of the calling thread's slice.
+ * Only valid while tnl->_ThreadsActive is set.
+ */
+struct vertex_buffer *
+_tnl_thread_vb(void)
+{
+   struct tnl_vertex_slice *slice =
+      (struct tnl_vertex_slice *) _glthread_GetTSD(&SliceTSD);
+   return &slice->vb;
+}
+
+
+/**
+ * Get the addresses of all the vector pointers in a vertex buffer.
+ * \return number of pointers, MAX_SLOTS
+ */
+static GLuint
+get_slots(struct vertex_buffer *VB, GLvector4f **slots[MAX_SLOTS])
+{
+   GLuint n = 0, i;
+
+   slots[n++] = &VB->EyePtr;
+   slots[n++] = &VB->ClipPtr;
+   slots[n++] = &VB->NdcPtr;
+
+   slots[n++] = &VB->ObjPtr;
+   slots[n++] = &VB->NormalPtr;
+   slots[n++] = &VB->FogCoordPtr;
+   for (i = 0; i < 2; i++) {
+      slots[n++] = &VB->IndexPtr[i];
+      slots[n++] = &VB->ColorPtr[i];
+      slots[n++] = &VB->SecondaryColorPtr[i];
+   }
+   for (i = 0; i < MAX_TEXTURE_COORD_UNITS; i++)
+      slots[n++] = &VB->TexCoordPtr[i];
+   for (i = 0; i < _TNL_ATTRIB_MAX; i++)
+      slots[n++] = &VB->AttribPtr[i];
+
+   ASSERT(n == MAX_SLOTS);
+   return n;
+}
+
+
+static GLboolean
+is_vertex_stage(const struct tnl_pipeline_stage *stage)
+{
+   GLuint i;
+
+   for (i = 0; vertex_stages[i]; i++) {
+      if (stage->run == vertex_stages[i]->run)
+         return GL_TRUE;
+   }
+   return GL_FALSE;
+}
+
+
+/**
+ * Free the slices' copies of the pipeline stages.  Called when the
+ * pipeline is destroyed or replaced.
+ */
+void
+_tnl_free_vertex_thread_stages(GLcontext *ctx)
+{
+   struct tnl_vertex_threads *threads = TNL_CONTEXT(ctx)->Threads;
+   GLuint i, j;
+
+   if (!threads)
+      return;
+
+   for (i = 0; i < threads->NumThreads; i++) {
+      for (j = 0; j < threads->NumStages; j++) {
+         struct tnl_pipeline_stage *s = &threads->Slices[i].stages[j];
+         if (s->destroy)
+            s->destroy(s);
+         _mesa_bzero(s, sizeof(*s));
+      }
+   }
+
+   threads->NumStages = 0;
+   threads->HaveStages = GL_FALSE;
+}
+
+
+/**
+ * Copy the per-vertex stages at the head of the pipeline into each
+ * slice.  The copies allocate their storage for the slice's size.
+ */
+static void
+create_stages(GLcontext *ctx)
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct tnl_vertex_threads *threads = tnl->Threads;
+   GLuint numStages = 0, i, j;
+
+   while (numStages < tnl->pipeline.nr_stages &&
+          is_vertex_stage(&tnl->pipeline.stages[numStages]))
+      numStages++;
+
+   tnl->_ThreadsActive = GL_TRUE;
+
+   for (i = 0; i < threads->NumThreads; i++) {
+      struct tnl_vertex_slice *slice = &threads->Slices[i];
+
+      _glthread_SetTSD(&SliceTSD, slice);
+
+      for (j = 0; j < numStages; j++) {
+         struct tnl_pipeline_stage *s = &slice->stages[j];
+         MEMCPY(s, &tnl->pipeline.stages[j], sizeof(*s));
+         s->privatePtr = NULL;
+         if (s->create && !s->create(ctx, s)) {
+            /* out of memory: keep everything on the calling thread */
+            threads->NumStages = j + 1;
+            tnl->_ThreadsActive = GL_FALSE;
+            _tnl_free_vertex_thread_stages(ctx);
+            threads->HaveStages = GL_TRUE;
+            return;
+         }
+      }
+   }
+
+   tnl->_ThreadsActive = GL_FALSE;
+
+   threads->NumStages = numStages;
+   threads->HaveStages = GL_TRUE;
+   threads->NeedValidate = GL_TRUE;
+}
+
+
+/**
+ * Set up a slice's vertex buffer to cover vertices [start, start+count)
+ * of tnl->vb.
+ */
+static void
+setup_slice(GLcontext *ctx, struct tnl_vertex_slice *slice,
+            GLuint start, GLuint count)
+{
+   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct tnl_vertex_threads *threads = TNL_CONTEXT(ctx)->Threads;
+   struct vertex_buffer *sliceVB = &slice->vb;
+   GLvector4f **slots[MAX_SLOTS];
+   GLuint numSlots, i;
+
+   for (i = 0; i < threads->NumInputs; i++) {
+      const GLvector4f *in = threads->Inputs[i];
+      GLvector4f *view = &slice->Inputs[i];
+
+      *view = *in;
+      view->flags &= ~VEC_MALLOC;
+      view->storage = NULL;
+      if (in->stride) {
+         view->data = (GLfloat (*)[4]) ((GLubyte *) in->data
+                                        + start * in->stride);
+         view->start = (GLfloat *) ((GLubyte *) in->start
+                                    + start * in->stride);
+         view->count = count;
+      }
+   }
+
+   numSlots = get_slots(sliceVB, slots);
+   for (i = 0; i < numSlots; i++) {
+      const GLuint input = threads->InputMap[i];
+      if (i < STAGE_SLOTS)
+         *slots[i] = &slice->Unset;
+      else if (input == SLOT_NULL)
+         *slots[i] = NULL;
+      else
+         *slots[i] = &slice->Inputs[input];
+   }
+
+   sliceVB->Count = count;
+   sliceVB->Elts = NULL;
+   sliceVB->ClipOrMask = 0;
+   sliceVB->ClipAndMask = 0;
+   sliceVB->ClipMask = NULL;
+   sliceVB->NormalLengthPtr = NULL;
+   sliceVB->EdgeFlag = VB->EdgeFlag ? VB->EdgeFlag + start : NULL;
+   sliceVB->Primitive = NULL;
+   sliceVB->PrimitiveCount = 0;
+
+   slice->Start = start;
+}
+
+
+/**
+ * Run the stages on one slice.  Called by the thread pool.
+ */
+static void
+run_slice(void *data, GLuint task, GLuint thread)
+{
+   GLcontext *ctx = (GLcontext *) data;
+   struct tnl_vertex_threads *threads = TNL_CONTEXT(ctx)->Threads;
+   struct tnl_vertex_slice *slice = &threads->Slices[task];
+   GLvector4f **slots[MAX_SLOTS];
+   unsigned short __tmp;
+   GLuint numSlots, i, j;
+
+   (void) thread;
+
+   _glthread_SetTSD(&SliceTSD, slice);
+
+   START_FAST_MATH(__tmp);
+
+   slice->Finished = GL_FALSE;
+   for (i = 0; i < threads->NumStages; i++) {
+      struct tnl_pipeline_stage *s = &slice->stages[i];
+      if (!s->run(ctx, s)) {
+         slice->Finished = GL_TRUE;
+         break;
+      }
+   }
+
+   END_FAST_MATH(__tmp);
+
+   if (slice->Finished)
+      return;
+
+   /* Note where each vector pointer now points to.  Pointers sharing a
+    * vector map to the same output.
+    */
+   numSlots = get_slots(&slice->vb, slots);
+   slice->NumOutputs = 0;
+   for (i = 0; i < numSlots; i++) {
+      GLvector4f *v = *slots[i];
+
+      if (!v) {
+         slice->Map[i] = SLOT_NULL;
+      }
+      else if (v == &slice->Unset) {
+         slice->Map[i] = SLOT_KEEP;
+      }
+      else if (v >= slice->Inputs && v < slice->Inputs + threads->NumInputs) {
+         slice->Map[i] = (GLuint) (v - slice->Inputs);
+      }
+      else {
+         for (j = 0; j < slice->NumOutputs; j++) {
+            if (slice->Outputs[j] == v)
+               break;
+         }
+         if (j == slice->NumOutputs)
+            slice->Outputs[slice->NumOutputs++] = v;
+         slice->Map[i] = SLOT_OUTPUT + j;
+      }
+   }
+}
+
+
+/**
+ * Copy the outputs of one slice into the full-size vectors.  Called by
+ * the thread pool.
+ */
+static void
+copy_slice(void *data, GLuint task, GLuint thread)
+{
+   GLcontext *ctx = (GLcontext *) data;
+   struct tnl_vertex_threads *threads = TNL_CONTEXT(ctx)->Threads;
+   const struct tnl_vertex_slice *slice = &threads->Slices[task];
+   const GLuint count = slice->vb.Count;
+   GLuint i;
+
+   (void) thread;
+
+   for (i = 0; i < slice->NumOutputs; i++) {
+      const GLvector4f *src = slice->Outputs[i];
+      GLvector4f *dst = &threads->Outputs[i];
+
+      if (src->stride)
+         MEMCPY((GLubyte *) dst->start + slice->Start * src->stride,
+                src->start, count * src->stride);
+      else if (task == 0)
+         COPY_4V(dst->start, src->start);
+   }
+
+   MEMCPY(threads->ClipMask + slice->Start, slice->vb.ClipMask, count);
+}
+
+
+/**
+ * Check that all slices went through the stages in the same way.
+ */
+static GLboolean
+slices_match(const struct tnl_vertex_threads *threads, GLuint numSlices)
+{
+   const struct tnl_vertex_slice *first = &threads->Slices[0];
+   GLuint i, j;
+
+   for (i = 0; i < numSlices; i++) {
+      const struct tnl_vertex_slice *slice = &threads->Slices[i];
+
+      if (slice->Finished || !slice->vb.ClipMask)
+         return GL_FALSE;
+
+      if (slice->NumOutputs != first->NumOutputs ||
+          _mesa_memcmp(slice->Map, first->Map, sizeof(slice->Map)) != 0)
+         return GL_FALSE;
+
+      for (j = 0; j < slice->NumOutputs; j++) {
+         if (slice->Outputs[j]->stride != first->Outputs[j]->stride ||
+             slice->Outputs[j]->stride > 4 * sizeof(GLfloat))
+            return GL_FALSE;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Check if the current state allows the stages to be run on slices.
+ */
+static GLboolean
+use_threads(GLcontext *ctx)
+{
+   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   const struct gl_vertex_program *vp = ctx->VertexProgram._Current;
+   GLuint i;
+
+   if (vp) {
+      /* texel fetches go through swrast's per-context state */
+      for (i = 0; i < ctx->Const.MaxVertexTextureImageUnits; i++) {
+         if (vp->Base.TexturesUsed[i])
+            return GL_FALSE;
+      }
+   }
+   else if (ctx->Light.Enabled) {
+      /* material changes are written to the context for each vertex */
+      if (ctx->Light.ColorMaterialEnabled)
+         return GL_FALSE;
+      for (i = _TNL_FIRST_MAT; i <= _TNL_LAST_MAT; i++) {
+         if (VB->AttribPtr[i]->stride)
+            return GL_FALSE;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Run the per-vertex stages at the head of the pipeline on several
+ * threads, if the vertex buffer is large enough and the state allows it.
+ * \return number of stages run, which the caller skips
+ */
+GLuint
+_tnl_run_vertex_threads(GLcontext *ctx)
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct tnl_vertex_threads *threads = tnl->Threads;
+   struct vertex_buffer *VB = &tnl->vb;
+   const struct tnl_vertex_slice *first;
+   GLvector4f **slots[MAX_SLOTS];
+   GLuint numSlots, numSlices, sliceCount, i, j;
+
+   if (!threads)
+      return 0;
+
+   numSlices = MIN2(threads->NumThreads, VB->Count / MIN_SLICE_VERTS);
+   if (numSlices < 2 || !use_threads(ctx))
+      return 0;
+
+   if (!threads->HaveStages)
+      create_stages(ctx);
+   if (threads->NumStages == 0)
+      return 0;
+
+   /* Find the distinct input vectors */
+   numSlots = get_slots(VB, slots);
+   threads->NumInputs = 0;
+   for (i = 0; i < numSlots; i++) {
+      GLvector4f *v = *slots[i];
+
+      threads->InputMap[i] = SLOT_NULL;
+      if (i < STAGE_SLOTS || !v)
+         continue;
+
+      for (j = 0; j < threads->NumInputs; j++) {
+         if (threads->Inputs[j] == v)
+            break;
+      }
+      if (j == threads->NumInputs)
+         threads->Inputs[threads->NumInputs++] = v;
+      threads->InputMap[i] = j;
+   }
+
+   /* Split the vertices.  The slices not used for this buffer are set
+    * up too, in case they have to be validated.
+    */
+   sliceCount = (VB->Count + numSlices - 1) / numSlices;
+   for (i = 0; i < threads->NumThreads; i++) {
+      if (i < numSlices)
+         setup_slice(ctx, &threads->Slices[i], i * sliceCount,
+                     MIN2(sliceCount, VB->Count - i * sliceCount));
+      else
+         setup_slice(ctx, &threads->Slices[i], 0, 0);
+   }
+
+   tnl->_ThreadsActive = GL_TRUE;
+
+   if (threads->NeedValidate) {
+      for (i = 0; i < threads->NumThreads; i++) {
+         _glthread_SetTSD(&SliceTSD, &threads->Slices[i]);
+         for (j = 0; j < threads->NumStages; j++) {
+            struct tnl_pipeline_stage *s = &threads->Slices[i].stages[j];
+            if (s->validate)
+               s->validate(ctx, s);
+         }
+      }
+      threads->NeedValidate = GL_FALSE;
+   }
+
+   /* Do the updates of shared state which the stages skip while the
+    * threads are running.
+    */
+   if (ctx->VertexProgram._Current) {
+      _tnl_load_vp_parameters(ctx);
+   }
+   else if (ctx->Light.Enabled) {
+      _mesa_update_material(ctx, ~0);
+      _mesa_validate_all_lighting_tables(ctx);
+   }
+
+   _mesa_threadpool_run(threads->Pool, numSlices, run_slice, ctx);
+
+   tnl->_ThreadsActive = GL_FALSE;
+
+   if (!slices_match(threads, numSlices))
+      return 0;
+
+   /* Set up the full-size output vectors like the first slice's */
+   first = &threads->Slices[0];
+   for (i = 0; i < first->NumOutputs; i++) {
+      const GLvector4f *src = first->Outputs[i];
+      GLvector4f *dst = &threads->Outputs[i];
+
+      if (!dst->storage) {
+         _mesa_vector4f_alloc(dst, 0, VB->Size, 32);
+         if (!dst->storage)
+            return 0;
+      }
+
+      dst->stride = src->stride;
+      dst->size = src->size;
+      dst->flags = src->flags | VEC_MALLOC;
+      dst->count = src->stride ? VB->Count : src->count;
+   }
+
+   _mesa_threadpool_run(threads->Pool, numSlices, copy_slice, ctx);
+
+   /* Point tnl->vb at the results */
+   for (i = 0; i < numSlots; i++) {
+      const GLuint m = first->Map[i];
+
+      if (m < SLOT_NULL)
+         *slots[i] = threads->Inputs[m];
+      else if (m == SLOT_NULL)
+         *slots[i] = NULL;
+      else if (m >= SLOT_OUTPUT)
+         *slots[i] = &threads->Outputs[m - SLOT_OUTPUT];
+   }
+
+   /* The fog stage sets the count of constant fog coordinates */
+   for (i = 0; i < threads->NumInputs; i++) {
+      const GLvector4f *in = threads->Inputs[i];
+      if (first->Inputs[i].count != (in->stride ? first->vb.Count : in->count))
+         threads->Inputs[i]->count = VB->Count;
+   }
+
+   VB->ClipMask = threads->ClipMask;
+   VB->ClipOrMask = 0;
+   VB->ClipAndMask = 0xff;
+   for (i = 0; i < numSlices; i++) {
+      VB->ClipOrMask |= threads->Slices[i].vb.ClipOrMask;
+      VB->ClipAndMask &= threads->Slices[i].vb.ClipAndMask;
+   }
+
+   return threads->NumStages;
+}
+
+
+/**
+ * Mark the slices' stages for validation.  Called whenever the pipeline
+ * is validated.
+ */
+void
+_tnl_invalidate_vertex_threads(GLcontext *ctx)
+{
+   struct tnl_vertex_threads *threads = TNL_CONTEXT(ctx)->Threads;
+
+   if (threads)
+      threads->NeedValidate = GL_TRUE;
+}
+
+
+static void
+free_threads(struct tnl_vertex_threads *threads)
+{
+   GLuint i;
+
+   _mesa_threadpool_destroy(threads->Pool);
+
+   for (i = 0; i < MAX_SLOTS; i++) {
+      if (threads->Outputs[i].storage)
+         _mesa_vector4f_free(&threads->Outputs[i]);
+   }
+
+   if (threads->ClipMask)
+      ALIGN_FREE(threads->ClipMask);
+   if (threads->Slices)
+      FREE(threads->Slices);
+   FREE(threads);
+}
+
+
+/**
+ * Set up the vertex threads if MESA_TNL_THREADS asks for more than one
+ * thread.  Otherwise, tnl->Threads stays NULL.
+ */
+void
+_tnl_create_vertex_threads(GLcontext *ctx)
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   const GLuint numThreads = _mesa_get_thread_count("MESA_TNL_THREADS");
+   struct tnl_vertex_threads *threads;
+   GLuint sliceSize, i;
+
+   if (numThreads < 2)
+      return;
+
+   threads = CALLOC_STRUCT(tnl_vertex_threads);
+   if (!threads)
+      return;
+
+   threads->Pool = _mesa_threadpool_create(numThreads);
+   threads->NumThreads = _mesa_threadpool_num_threads(threads->Pool);
+   if (threads->NumThreads < 2) {
+      /* no thread support */
+      free_threads(threads);
+      return;
+   }
+
+   threads->Slices = (struct tnl_vertex_slice *)
+      CALLOC(threads->NumThreads * sizeof(struct tnl_vertex_slice));
+   threads->ClipMask = (GLubyte *) ALIGN_MALLOC(tnl->vb.Size, 32);
+   if (!threads->Slices || !threads->ClipMask) {
+      free_threads(threads);
+      return;
+   }
+
+   /* Big enough for the largest slice _tnl_run_vertex_threads() makes:
+    * either a NumThreads'th of the buffer or less than two
+    * MIN_SLICE_VERTS.
+    */
+   sliceSize = (tnl->vb.Size + threads->NumThreads - 1) / threads->NumThreads;
+   sliceSize = MAX2(sliceSize, 2 * MIN_SLICE_VERTS);
+   for (i = 0; i < threads->NumThreads; i++)
+      threads->Slices[i].vb.Size = sliceSize;
+
+   /* make sure the TSD key gets created here, not racily in a worker */
+   _glthread_SetTSD(&SliceTSD, NULL);
+
+   tnl->Threads = threads;
+}
+
+
+void
+_tnl_destroy_vertex_threads(GLcontext *ctx)
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+
+   if (tnl->Threads) {
+      _tnl_free_vertex_thread_stages(ctx);
+      free_threads(tnl->Threads);
+      tnl->Threads = NULL;
+   }
+}
@@ -124,7 +124,7 @@ static GLboolean run_vertex_stage( GLcontext *ctx,
 {
    struct vertex_stage_data *store = (struct vertex_stage_data *)stage->privatePtr;
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   struct vertex_buffer *VB = &tnl->vb;
+   struct vertex_buffer *VB = TNL_VB(tnl);
 
    if (ctx->VertexProgram._Current) 
       return GL_TRUE;
@@ -167,7 +167,16 @@ static GLboolean run_vertex_stage( GLcontext *ctx,
    store->ormask = 0;
    store->andmask = CLIP_FRUSTUM_BITS;
 
-   if (tnl->NeedNdcCoords) {
+   if (tnl->_UseGuardBand) {
+      VB->NdcPtr =
+	 _mesa_clip_gb_tab[VB->ClipPtr->size]( VB->ClipPtr,
+					       &store->proj,
+					       store->clipmask,
+					       &store->ormask,
+					       &store->andmask,
+					       tnl->_GuardBand );
+   }
+   else if (tnl->NeedNdcCoords) {
       VB->NdcPtr =
 	 _mesa_clip_tab[VB->ClipPtr->size]( VB->ClipPtr,
 					    &store->proj,
@@ -213,7 +222,7 @@ static GLboolean run_vertex_stage( GLcontext *ctx,
 static GLboolean init_vertex_stage( GLcontext *ctx,
 				    struct tnl_pipeline_stage *stage )
 {
-   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   struct vertex_buffer *VB = TNL_VB(TNL_CONTEXT(ctx));
    struct vertex_stage_data *store;
    GLuint size = VB->Size;
 
@@ -0,0 +1,1248 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file tnl/t_vp_soa.c
+ * \brief Execute vertex programs on groups of vertices at once.
+ *
+ * The interpreter in shader/prog_execute.c runs a vertex program one
+ * vertex at a time, decoding each instruction again for every vertex.
+ * Here a program is translated once into a list of pre-decoded
+ * instructions operating on registers stored in structure-of-arrays
+ * form (each register component holds VP_LANES vertices).  Every
+ * instruction is then executed for a whole group of vertices with short
+ * loops which the compiler turns into SSE/AVX code.
+ *
+ * Programs with flow control, condition codes, texture fetches or
+ * anything else not handled here are left to the interpreter.  The
+ * arithmetic is the same as the interpreter's, operation by operation.
+ */
+
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "shader/prog_instruction.h"
+#include "shader/prog_parameter.h"
+
+#include "t_context.h"
+#include "t_vp_soa.h"
+
+
+/** Number of vertices processed together */
+#define VP_LANES 32
+
+/** Max number of input, output and temporary register slots */
+#define VP_MAX_SLOTS 128
+
+/** Number of translated programs kept around */
+#define VP_CACHE_SIZE 16
+
+
+/**
+ * Set x to positive or negative infinity (as in prog_execute.c).
+ */
+#if defined(USE_IEEE) || defined(_WIN32)
+#define SET_POS_INFINITY(x)  ( *((GLuint *) (void *)&x) = 0x7F800000 )
+#define SET_NEG_INFINITY(x)  ( *((GLuint *) (void *)&x) = 0xFF800000 )
+#elif defined(VMS)
+#define SET_POS_INFINITY(x)  x = __MAXFLOAT
+#define SET_NEG_INFINITY(x)  x = -__MAXFLOAT
+#else
+#define SET_POS_INFINITY(x)  x = (GLfloat) HUGE_VAL
+#define SET_NEG_INFINITY(x)  x = (GLfloat) -HUGE_VAL
+#endif
+
+
+/** Kinds of instruction operands */
+enum vp_src_kind {
+   VP_SRC_REG,          /**< input, output or temporary register slot */
+   VP_SRC_CURRENT,      /**< input not in InputsRead: current attrib value */
+   VP_SRC_CONST,        /**< program/env/local parameter */
+   VP_SRC_CONST_REL     /**< parameter array indexed by address register */
+};
+
+
+struct vp_src {
+   enum vp_src_kind Kind;
+   GLuint Slot;                     /**< for VP_SRC_REG */
+   GLboolean Plain;                 /**< no negation or absolute value */
+   struct prog_src_register Reg;    /**< the original operand */
+};
+
+
+struct vp_inst {
+   gl_inst_opcode Opcode;
+   struct vp_src Src[3];
+   GLint DstSlot;                   /**< -1 if the result is discarded */
+   GLuint WriteMask;
+   GLboolean Saturate;
+};
+
+
+/**
+ * A translated vertex program.
+ */
+struct tnl_vp_code {
+   const struct gl_vertex_program *Program;
+   GLuint LastUse;
+
+   /** Copy of the source instructions, to detect redefinition */
+   struct prog_instruction *Source;
+   GLuint NumSource;
+
+   struct vp_inst *Inst;            /**< NULL if it couldn't be translated */
+   GLuint NumInst;
+
+   GLuint NumSlots;
+   GLint InputSlot[VERT_ATTRIB_MAX];
+   GLint OutputSlot[MAX_PROGRAM_OUTPUTS];
+   GLuint FirstTempSlot;            /**< temporaries come last */
+};
+
+
+struct tnl_vp_cache {
+   struct tnl_vp_code *Entries[VP_CACHE_SIZE];
+   GLuint Clock;
+   GLfloat (*Regs)[4][VP_LANES];    /**< register file, [VP_MAX_SLOTS] */
+};
+
+
+/**
+ * Per-call execution state.
+ */
+struct vp_exec {
+   GLcontext *ctx;
+   const struct gl_vertex_program *program;
+   GLuint n;                        /**< vertices in current group */
+   GLfloat (*regs)[4][VP_LANES];
+   GLint addr[VP_LANES];            /**< address register A0.x */
+};
+
+
+static const GLfloat ZeroVec[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+
+
+/**********************************************************************
+ * Translation
+ */
+
+static GLboolean
+supported_opcode(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_ABS:
+   case OPCODE_ADD:
+   case OPCODE_ARL:
+   case OPCODE_CMP:
+   case OPCODE_COS:
+   case OPCODE_DP2:
+   case OPCODE_DP3:
+   case OPCODE_DP4:
+   case OPCODE_DPH:
+   case OPCODE_DST:
+   case OPCODE_EX2:
+   case OPCODE_EXP:
+   case OPCODE_FLR:
+   case OPCODE_FRC:
+   case OPCODE_LG2:
+   case OPCODE_LIT:
+   case OPCODE_LOG:
+   case OPCODE_LRP:
+   case OPCODE_MAD:
+   case OPCODE_MAX:
+   case OPCODE_MIN:
+   case OPCODE_MOV:
+   case OPCODE_MUL:
+   case OPCODE_NRM3:
+   case OPCODE_NRM4:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SCS:
+   case OPCODE_SEQ:
+   case OPCODE_SFL:
+   case OPCODE_SGE:
+   case OPCODE_SGT:
+   case OPCODE_SIN:
+   case OPCODE_SLE:
+   case OPCODE_SLT:
+   case OPCODE_SNE:
+   case OPCODE_SSG:
+   case OPCODE_STR:
+   case OPCODE_SUB:
+   case OPCODE_SWZ:
+   case OPCODE_TRUNC:
+   case OPCODE_XPD:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Do these opcodes only use the first component of their operands?
+ */
+static GLboolean
+scalar_opcode(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_COS:
+   case OPCODE_EX2:
+   case OPCODE_EXP:
+   case OPCODE_LG2:
+   case OPCODE_LOG:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SCS:
+   case OPCODE_SIN:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+static GLboolean
+is_param_file(GLuint file)
+{
+   switch (file) {
+   case PROGRAM_LOCAL_PARAM:
+   case PROGRAM_ENV_PARAM:
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+   case PROGRAM_NAMED_PARAM:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Allocate register slots for the inputs and outputs.  The inputs read
+ * by the program are loaded from the vertex arrays for each group.
+ */
+static GLboolean
+alloc_io_slots(struct tnl_vp_code *code,
+               const struct gl_vertex_program *program)
+{
+   GLbitfield outputs = program->Base.OutputsWritten;
+   GLuint pc, i;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (program->Base.InputsRead & (1 << i))
+         code->InputSlot[i] = code->NumSlots++;
+      else
+         code->InputSlot[i] = -1;
+   }
+
+   for (pc = 0; pc < program->Base.NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Base.Instructions + pc;
+      if (inst->DstReg.File == PROGRAM_OUTPUT) {
+         if (inst->DstReg.Index >= MAX_PROGRAM_OUTPUTS)
+            return GL_FALSE;
+         outputs |= 1 << inst->DstReg.Index;
+      }
+      for (i = 0; i < 3; i++) {
+         if (inst->SrcReg[i].File == PROGRAM_OUTPUT) {
+            if (inst->SrcReg[i].Index >= MAX_PROGRAM_OUTPUTS)
+               return GL_FALSE;
+            outputs |= 1 << inst->SrcReg[i].Index;
+         }
+      }
+   }
+
+   for (i = 0; i < MAX_PROGRAM_OUTPUTS; i++) {
+      if (outputs & (1 << i))
+         code->OutputSlot[i] = code->NumSlots++;
+      else
+         code->OutputSlot[i] = -1;
+   }
+
+   code->FirstTempSlot = code->NumSlots;
+   return code->NumSlots <= VP_MAX_SLOTS;
+}
+
+
+/**
+ * Return the slot for a temporary register, allocating it if needed.
+ * \return -1 if out of slots
+ */
+static GLint
+temp_slot(struct tnl_vp_code *code, GLint tempSlot[], GLint index)
+{
+   if (tempSlot[index] < 0) {
+      if (code->NumSlots == VP_MAX_SLOTS)
+         return -1;
+      tempSlot[index] = code->NumSlots++;
+   }
+   return tempSlot[index];
+}
+
+
+static GLboolean
+translate_src(struct tnl_vp_code *code, GLint tempSlot[],
+              const struct prog_instruction *inst, GLuint i,
+              struct vp_src *src)
+{
+   const struct prog_src_register *reg = &inst->SrcReg[i];
+   const GLuint numComps = scalar_opcode(inst->Opcode) ? 1 : 4;
+   const GLuint maxSwz = inst->Opcode == OPCODE_SWZ ? SWIZZLE_ONE : SWIZZLE_W;
+   GLuint c;
+
+   for (c = 0; c < numComps; c++) {
+      if (GET_SWZ(reg->Swizzle, c) > maxSwz)
+         return GL_FALSE;
+   }
+
+   src->Reg = *reg;
+   src->Plain = !reg->NegateBase && !reg->Abs && !reg->NegateAbs;
+   src->Slot = 0;
+
+   if (reg->RelAddr) {
+      /* only parameter arrays may be indexed */
+      if (!is_param_file(reg->File))
+         return GL_FALSE;
+      src->Kind = VP_SRC_CONST_REL;
+      return GL_TRUE;
+   }
+
+   switch (reg->File) {
+   case PROGRAM_TEMPORARY:
+      {
+         GLint slot;
+         if (reg->Index < 0 || reg->Index >= MAX_PROGRAM_TEMPS)
+            return GL_FALSE;
+         slot = temp_slot(code, tempSlot, reg->Index);
+         if (slot < 0)
+            return GL_FALSE;
+         src->Kind = VP_SRC_REG;
+         src->Slot = slot;
+      }
+      return GL_TRUE;
+   case PROGRAM_INPUT:
+      if (reg->Index < 0 || reg->Index >= VERT_ATTRIB_MAX)
+         return GL_FALSE;
+      if (code->InputSlot[reg->Index] >= 0) {
+         src->Kind = VP_SRC_REG;
+         src->Slot = code->InputSlot[reg->Index];
+      }
+      else if (reg->Index < MAX_VERTEX_PROGRAM_ATTRIBS) {
+         src->Kind = VP_SRC_CURRENT;
+      }
+      else {
+         return GL_FALSE;
+      }
+      return GL_TRUE;
+   case PROGRAM_OUTPUT:
+      src->Kind = VP_SRC_REG;
+      src->Slot = code->OutputSlot[reg->Index];
+      return GL_TRUE;
+   default:
+      if (!is_param_file(reg->File))
+         return GL_FALSE;
+      src->Kind = VP_SRC_CONST;
+      return GL_TRUE;
+   }
+}
+
+
+/**
+ * Translate the program's instructions into code->Inst.
+ * \return GL_FALSE if the program has to be run by the interpreter
+ */
+static GLboolean
+translate_program(struct tnl_vp_code *code,
+                  const struct gl_vertex_program *program)
+{
+   GLint tempSlot[MAX_PROGRAM_TEMPS];
+   GLuint pc, i;
+
+   if (!alloc_io_slots(code, program))
+      return GL_FALSE;
+
+   for (i = 0; i < MAX_PROGRAM_TEMPS; i++)
+      tempSlot[i] = -1;
+
+   code->Inst = (struct vp_inst *)
+      _mesa_calloc(MAX2(program->Base.NumInstructions, 1)
+                   * sizeof(struct vp_inst));
+   if (!code->Inst)
+      return GL_FALSE;
+
+   for (pc = 0; pc < program->Base.NumInstructions; pc++) {
+      const struct prog_instruction *src = program->Base.Instructions + pc;
+      const struct prog_dst_register *dstReg = &src->DstReg;
+      struct vp_inst *inst = code->Inst + code->NumInst;
+
+      if (src->Opcode == OPCODE_END)
+         break;
+      if (src->Opcode == OPCODE_NOP)
+         continue;
+
+      if (!supported_opcode(src->Opcode) ||
+          src->CondUpdate ||
+          dstReg->CondMask != COND_TR ||
+          dstReg->RelAddr)
+         return GL_FALSE;
+
+      inst->Opcode = src->Opcode;
+      for (i = 0; i < _mesa_num_inst_src_regs(src->Opcode); i++) {
+         if (!translate_src(code, tempSlot, src, i, &inst->Src[i]))
+            return GL_FALSE;
+      }
+
+      inst->DstSlot = -1;
+      if (src->Opcode != OPCODE_ARL) {
+         switch (dstReg->File) {
+         case PROGRAM_TEMPORARY:
+            if (dstReg->Index < MAX_PROGRAM_TEMPS) {
+               inst->DstSlot = temp_slot(code, tempSlot, dstReg->Index);
+               if (inst->DstSlot < 0)
+                  return GL_FALSE;
+            }
+            break;
+         case PROGRAM_OUTPUT:
+            inst->DstSlot = code->OutputSlot[dstReg->Index];
+            break;
+         case PROGRAM_WRITE_ONLY:
+            break;
+         default:
+            return GL_FALSE;
+         }
+      }
+      inst->WriteMask = dstReg->WriteMask;
+      inst->Saturate = src->SaturateMode == SATURATE_ZERO_ONE;
+
+      code->NumInst++;
+   }
+
+   return GL_TRUE;
+}
+
+
+static void
+free_code(struct tnl_vp_code *code)
+{
+   if (code->Source)
+      _mesa_free(code->Source);
+   if (code->Inst)
+      _mesa_free(code->Inst);
+   _mesa_free(code);
+}
+
+
+/**
+ * Translate a program.  The result is cached even if the program can't
+ * be translated so we don't try again.
+ */
+static struct tnl_vp_code *
+compile_program(const struct gl_vertex_program *program)
+{
+   const GLuint numInst = program->Base.NumInstructions;
+   struct tnl_vp_code *code = CALLOC_STRUCT(tnl_vp_code);
+   if (!code)
+      return NULL;
+
+   code->Program = program;
+   code->NumSource = numInst;
+   code->Source = (struct prog_instruction *)
+      _mesa_malloc(MAX2(numInst, 1) * sizeof(struct prog_instruction));
+   if (!code->Source) {
+      free_code(code);
+      return NULL;
+   }
+   _mesa_memcpy(code->Source, program->Base.Instructions,
+                numInst * sizeof(struct prog_instruction));
+
+   if (!translate_program(code, program) && code->Inst) {
+      _mesa_free(code->Inst);
+      code->Inst = NULL;
+   }
+
+   return code;
+}
+
+
+static GLboolean
+code_matches(const struct tnl_vp_code *code,
+             const struct gl_vertex_program *program)
+{
+   return code->Program == program &&
+          code->NumSource == program->Base.NumInstructions &&
+          _mesa_memcmp(code->Source, program->Base.Instructions,
+                       code->NumSource * sizeof(struct prog_instruction)) == 0;
+}
+
+
+struct tnl_vp_cache *
+_tnl_create_vp_cache(void)
+{
+   struct tnl_vp_cache *cache = CALLOC_STRUCT(tnl_vp_cache);
+   if (!cache)
+      return NULL;
+
+   cache->Regs = (GLfloat (*)[4][VP_LANES])
+      ALIGN_MALLOC(VP_MAX_SLOTS * sizeof(cache->Regs[0]), 32);
+   if (!cache->Regs) {
+      _mesa_free(cache);
+      return NULL;
+   }
+
+   return cache;
+}
+
+
+void
+_tnl_destroy_vp_cache(struct tnl_vp_cache *cache)
+{
+   GLuint i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < VP_CACHE_SIZE; i++) {
+      if (cache->Entries[i])
+         free_code(cache->Entries[i]);
+   }
+   ALIGN_FREE(cache->Regs);
+   _mesa_free(cache);
+}
+
+
+/**
+ * Find or make the translated code for a program.  Called when state
+ * changes, so the program may have been redefined since it was cached;
+ * the instructions are compared to catch that.
+ * \return the translation, or NULL if out of memory
+ */
+struct tnl_vp_code *
+_tnl_lookup_vp_code(struct tnl_vp_cache *cache,
+                    const struct gl_vertex_program *program)
+{
+   struct tnl_vp_code *code;
+   GLuint i, victim = 0;
+
+   for (i = 0; i < VP_CACHE_SIZE; i++) {
+      code = cache->Entries[i];
+      if (!code) {
+         victim = i;
+         break;
+      }
+      if (code->Program == program) {
+         if (code_matches(code, program)) {
+            code->LastUse = ++cache->Clock;
+            return code;
+         }
+         /* redefined, replace it */
+         victim = i;
+         break;
+      }
+      if (code->LastUse < cache->Entries[victim]->LastUse)
+         victim = i;
+   }
+
+   if (cache->Entries[victim])
+      free_code(cache->Entries[victim]);
+
+   code = compile_program(program);
+   cache->Entries[victim] = code;
+   if (code)
+      code->LastUse = ++cache->Clock;
+   return code;
+}
+
+
+/**********************************************************************
+ * Execution
+ */
+
+/**
+ * Return pointer to a program parameter, or ZeroVec if out of bounds.
+ * As in get_src_register_pointer().
+ */
+static const GLfloat *
+param_pointer(const struct vp_exec *ex, GLuint file, GLint index)
+{
+   const struct gl_program *prog = &ex->program->Base;
+
+   if (index < 0)
+      return ZeroVec;
+
+   switch (file) {
+   case PROGRAM_LOCAL_PARAM:
+      if (index >= MAX_PROGRAM_LOCAL_PARAMS)
+         return ZeroVec;
+      return prog->LocalParams[index];
+   case PROGRAM_ENV_PARAM:
+      if (index >= MAX_PROGRAM_ENV_PARAMS)
+         return ZeroVec;
+      return ex->ctx->VertexProgram.Parameters[index];
+   default:
+      if (index >= (GLint) prog->Parameters->NumParameters)
+         return ZeroVec;
+      return prog->Parameters->ParameterValues[index];
+   }
+}
+
+
+/**
+ * Apply the operand's negation and absolute value, in the same order as
+ * fetch_vector4() does.
+ */
+static INLINE GLfloat
+modify(const struct prog_src_register *reg, GLfloat x)
+{
+   if (reg->NegateBase)
+      x = -x;
+   if (reg->Abs)
+      x = FABSF(x);
+   if (reg->NegateAbs)
+      x = -x;
+   return x;
+}
+
+
+/**
+ * Get one (unswizzled, unmodified) component of an operand for all the
+ * vertices of the group.
+ * \param tmp  storage which may be used for the values
+ */
+static const GLfloat *
+fetch_component(const struct vp_exec *ex, const struct vp_src *src,
+                GLuint comp, GLfloat tmp[VP_LANES])
+{
+   const GLuint n = ex->n;
+   GLuint i;
+
+   switch (src->Kind) {
+   case VP_SRC_REG:
+      return ex->regs[src->Slot][comp];
+   case VP_SRC_CONST_REL:
+      for (i = 0; i < n; i++)
+         tmp[i] = param_pointer(ex, src->Reg.File,
+                                src->Reg.Index + ex->addr[i])[comp];
+      return tmp;
+   default:
+      {
+         const GLfloat value = (src->Kind == VP_SRC_CURRENT)
+            ? ex->ctx->Current.Attrib[src->Reg.Index][comp]
+            : param_pointer(ex, src->Reg.File, src->Reg.Index)[comp];
+         for (i = 0; i < n; i++)
+            tmp[i] = value;
+      }
+      return tmp;
+   }
+}
+
+
+/**
+ * Fetch the first numComps components of an operand, with swizzling,
+ * negation and absolute value applied.
+ */
+static void
+fetch_src(const struct vp_exec *ex, const struct vp_src *src,
+          GLuint numComps, GLfloat tmp[4][VP_LANES], const GLfloat *val[4])
+{
+   const GLuint n = ex->n;
+   GLuint c, i;
+
+   for (c = 0; c < numComps; c++) {
+      const GLfloat *p = fetch_component(ex, src,
+                                         GET_SWZ(src->Reg.Swizzle, c), tmp[c]);
+      if (src->Plain) {
+         val[c] = p;
+      }
+      else {
+         for (i = 0; i < n; i++)
+            tmp[c][i] = modify(&src->Reg, p[i]);
+         val[c] = tmp[c];
+      }
+   }
+}
+
+
+/**
+ * Write an instruction's result to its destination register.
+ * \param scalar  replicate component 0 to all components
+ */
+static void
+store_result(const struct vp_exec *ex, const struct vp_inst *inst,
+             GLfloat result[4][VP_LANES], GLboolean scalar)
+{
+   const GLuint n = ex->n;
+   GLuint c, i;
+
+   if (inst->DstSlot < 0)
+      return;
+
+   for (c = 0; c < 4; c++) {
+      if (inst->WriteMask & (1 << c)) {
+         const GLfloat *res = result[scalar ? 0 : c];
+         GLfloat *dst = ex->regs[inst->DstSlot][c];
+         if (inst->Saturate) {
+            for (i = 0; i < n; i++)
+               dst[i] = CLAMP(res[i], 0.0F, 1.0F);
+         }
+         else {
+            for (i = 0; i < n; i++)
+               dst[i] = res[i];
+         }
+      }
+   }
+}
+
+
+/**
+ * Execute the translated instructions for the current group of vertices.
+ */
+static void
+execute_code(struct vp_exec *ex, const struct tnl_vp_code *code)
+{
+   const GLuint n = ex->n;
+   GLfloat ta[4][VP_LANES], tb[4][VP_LANES], tc[4][VP_LANES];
+   GLfloat result[4][VP_LANES];
+   const GLfloat *a[4], *b[4], *c[4];
+   GLuint pc, i, k;
+
+   for (pc = 0; pc < code->NumInst; pc++) {
+      const struct vp_inst *inst = code->Inst + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = FABSF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_ADD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] + b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_ARL:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            ex->addr[i] = IFLOOR(a[0][i]);
+         break;
+      case OPCODE_CMP:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] < 0.0F ? b[k][i] : c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_COS:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_cos(a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DP2:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DP3:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DP4:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DPH:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = a[0][i] * b[0][i] + a[1][i] * b[1][i]
+               + a[2][i] * b[2][i] + b[3][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_DST:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++) {
+            result[0][i] = 1.0F;
+            result[1][i] = a[1][i] * b[1][i];
+            result[2][i] = a[2][i];
+            result[3][i] = b[3][i];
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_EX2:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_pow(2.0, a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_EXP:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++) {
+            const GLfloat t = a[0][i];
+            const GLfloat floor_t0 = FLOORF(t);
+            if (floor_t0 > FLT_MAX_EXP) {
+               SET_POS_INFINITY(result[0][i]);
+               SET_POS_INFINITY(result[2][i]);
+            }
+            else if (floor_t0 < FLT_MIN_EXP) {
+               result[0][i] = 0.0F;
+               result[2][i] = 0.0F;
+            }
+            else {
+               result[0][i] = LDEXPF(1.0, (int) floor_t0);
+               result[2][i] = (GLfloat) pow(2.0, t);
+            }
+            result[1][i] = t - floor_t0;
+            result[3][i] = 1.0F;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_FLR:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = FLOORF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_FRC:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] - FLOORF(a[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_LG2:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) (log(a[0][i]) * 1.442695F);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_LIT:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            const GLfloat epsilon = 1.0F / 256.0F;
+            GLfloat x = MAX2(a[0][i], 0.0F);
+            GLfloat y = MAX2(a[1][i], 0.0F);
+            GLfloat w = CLAMP(a[3][i], -(128.0F - epsilon), (128.0F - epsilon));
+            result[0][i] = 1.0F;
+            result[1][i] = x;
+            if (x > 0.0F) {
+               if (y == 0.0 && w == 0.0)
+                  result[2][i] = 1.0;
+               else
+                  result[2][i] = EXPF(w * LOGF(y));
+            }
+            else {
+               result[2][i] = 0.0;
+            }
+            result[3][i] = 1.0F;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_LOG:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++) {
+            const GLfloat t = a[0][i];
+            const GLfloat abs_t0 = FABSF(t);
+            if (abs_t0 != 0.0F) {
+#ifdef VMS
+               if (abs_t0 == __MAXFLOAT)
+#else
+               if (IS_INF_OR_NAN(abs_t0))
+#endif
+               {
+                  SET_POS_INFINITY(result[0][i]);
+                  result[1][i] = 1.0F;
+                  SET_POS_INFINITY(result[2][i]);
+               }
+               else {
+                  int exponent;
+                  GLfloat mantissa = FREXPF(t, &exponent);
+                  result[0][i] = (GLfloat) (exponent - 1);
+                  result[1][i] = (GLfloat) (2.0 * mantissa);
+                  result[2][i] = (GLfloat) (log(t) * 1.442695F);
+               }
+            }
+            else {
+               SET_NEG_INFINITY(result[0][i]);
+               result[1][i] = 1.0F;
+               SET_NEG_INFINITY(result[2][i]);
+            }
+            result[3][i] = 1.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_LRP:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i] + (1.0F - a[k][i]) * c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MAD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         fetch_src(ex, &inst->Src[2], 4, tc, c);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i] + c[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MAX:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = MAX2(a[k][i], b[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MIN:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = MIN2(a[k][i], b[k][i]);
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MOV:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_MUL:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] * b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_NRM3:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            GLfloat tmp = a[0][i] * a[0][i] + a[1][i] * a[1][i]
+               + a[2][i] * a[2][i];
+            if (tmp != 0.0F)
+               tmp = INV_SQRTF(tmp);
+            result[0][i] = tmp * a[0][i];
+            result[1][i] = tmp * a[1][i];
+            result[2][i] = tmp * a[2][i];
+            result[3][i] = 0.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_NRM4:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (i = 0; i < n; i++) {
+            GLfloat tmp = a[0][i] * a[0][i] + a[1][i] * a[1][i]
+               + a[2][i] * a[2][i] + a[3][i] * a[3][i];
+            if (tmp != 0.0F)
+               tmp = INV_SQRTF(tmp);
+            result[0][i] = tmp * a[0][i];
+            result[1][i] = tmp * a[1][i];
+            result[2][i] = tmp * a[2][i];
+            result[3][i] = tmp * a[3][i];
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_POW:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         fetch_src(ex, &inst->Src[1], 1, tb, b);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_pow(a[0][i], b[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_RCP:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = 1.0F / a[0][i];
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_RSQ:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = INV_SQRTF(FABSF(a[0][i]));
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SCS:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++) {
+            result[0][i] = (GLfloat) _mesa_cos(a[0][i]);
+            result[1][i] = (GLfloat) _mesa_sin(a[0][i]);
+            result[2][i] = 0.0;
+            result[3][i] = 0.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SEQ:
+      case OPCODE_SGE:
+      case OPCODE_SGT:
+      case OPCODE_SLE:
+      case OPCODE_SLT:
+      case OPCODE_SNE:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++) {
+            const GLfloat *x = a[k], *y = b[k];
+            GLfloat *r = result[k];
+            switch (inst->Opcode) {
+            case OPCODE_SEQ:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] == y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SGE:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] >= y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SGT:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] > y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SLE:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] <= y[i]) ? 1.0F : 0.0F;
+               break;
+            case OPCODE_SLT:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] < y[i]) ? 1.0F : 0.0F;
+               break;
+            default:
+               for (i = 0; i < n; i++)
+                  r[i] = (x[i] != y[i]) ? 1.0F : 0.0F;
+               break;
+            }
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SFL:
+      case OPCODE_STR:
+         {
+            const GLfloat value = (inst->Opcode == OPCODE_STR) ? 1.0F : 0.0F;
+            for (i = 0; i < n; i++)
+               result[0][i] = value;
+         }
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SIN:
+         fetch_src(ex, &inst->Src[0], 1, ta, a);
+         for (i = 0; i < n; i++)
+            result[0][i] = (GLfloat) _mesa_sin(a[0][i]);
+         store_result(ex, inst, result, GL_TRUE);
+         break;
+      case OPCODE_SSG:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = (GLfloat) ((a[k][i] > 0.0F) - (a[k][i] < 0.0F));
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SUB:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = a[k][i] - b[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_SWZ:
+         /* extended swizzle, per-component negation only */
+         {
+            const struct vp_src *src = &inst->Src[0];
+            for (k = 0; k < 4; k++) {
+               const GLuint swz = GET_SWZ(src->Reg.Swizzle, k);
+               const GLboolean neg = (src->Reg.NegateBase & (1 << k)) != 0;
+               if (swz == SWIZZLE_ZERO || swz == SWIZZLE_ONE) {
+                  GLfloat value = (swz == SWIZZLE_ONE) ? 1.0F : 0.0F;
+                  if (neg)
+                     value = -value;
+                  for (i = 0; i < n; i++)
+                     result[k][i] = value;
+               }
+               else {
+                  const GLfloat *p = fetch_component(ex, src, swz, ta[k]);
+                  for (i = 0; i < n; i++)
+                     result[k][i] = neg ? -p[i] : p[i];
+               }
+            }
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_TRUNC:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < n; i++)
+               result[k][i] = (GLfloat) (GLint) a[k][i];
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      case OPCODE_XPD:
+         fetch_src(ex, &inst->Src[0], 4, ta, a);
+         fetch_src(ex, &inst->Src[1], 4, tb, b);
+         for (i = 0; i < n; i++) {
+            result[0][i] = a[1][i] * b[2][i] - a[2][i] * b[1][i];
+            result[1][i] = a[2][i] * b[0][i] - a[0][i] * b[2][i];
+            result[2][i] = a[0][i] * b[1][i] - a[1][i] * b[0][i];
+            result[3][i] = 1.0;
+         }
+         store_result(ex, inst, result, GL_FALSE);
+         break;
+      default:
+         _mesa_problem(ex->ctx, "Bad opcode %d in execute_code",
+                       inst->Opcode);
+         return;
+      }
+   }
+}
+
+
+/**
+ * Load the input registers for vertices [start, start + n) from the
+ * vertex arrays, filling in missing components like COPY_CLEAN_4V.
+ */
+static void
+load_inputs(const struct vp_exec *ex, const struct tnl_vp_code *code,
+            const struct vertex_buffer *VB, GLuint start)
+{
+   const GLuint n = ex->n;
+   GLuint attr, i;
+
+   for (attr = 0; attr < VERT_ATTRIB_MAX; attr++) {
+      if (code->InputSlot[attr] >= 0) {
+         GLfloat (*reg)[VP_LANES] = ex->regs[code->InputSlot[attr]];
+         const GLuint size = VB->AttribPtr[attr]->size;
+         const GLuint stride = VB->AttribPtr[attr]->stride;
+         const GLubyte *ptr = (const GLubyte *) VB->AttribPtr[attr]->data
+            + stride * start;
+
+         for (i = 0; i < n; i++) {
+            const GLfloat *data = (const GLfloat *) (ptr + stride * i);
+            reg[0][i] = data[0];
+            reg[1][i] = size > 1 ? data[1] : 0.0F;
+            reg[2][i] = size > 2 ? data[2] : 0.0F;
+            reg[3][i] = size > 3 ? data[3] : 1.0F;
+         }
+      }
+   }
+}
+
+
+/**
+ * Run the translated program on all the vertices of the vertex buffer
+ * and store the outputs in results[].  Does the same as the per-vertex
+ * loop in run_vp().
+ * \return GL_FALSE if the program has to be interpreted instead
+ */
+GLboolean
+_tnl_run_vp_code(GLcontext *ctx, struct tnl_vp_cache *cache,
+                 const struct tnl_vp_code *code,
+                 struct vertex_buffer *VB, GLvector4f results[])
+{
+   const struct gl_vertex_program *program = code->Program;
+   struct vp_exec ex;
+   GLuint start, i, j;
+
+   if (!code->Inst || program != ctx->VertexProgram._Current)
+      return GL_FALSE;
+
+   ex.ctx = ctx;
+   ex.program = program;
+   ex.regs = cache->Regs;
+
+   _mesa_bzero(ex.regs, code->NumSlots * sizeof(ex.regs[0]));
+   for (i = 0; i < VP_LANES; i++)
+      ex.addr[i] = 0;
+
+   for (start = 0; start < VB->Count; start += VP_LANES) {
+      ex.n = MIN2(VP_LANES, VB->Count - start);
+
+      if (program->IsNVProgram) {
+         /* Output/result regs are initialized to [0,0,0,1] and temps,
+          * address regs to zero for each vertex.
+          */
+         for (j = 0; j < MAX_NV_VERTEX_PROGRAM_OUTPUTS; j++) {
+            if (code->OutputSlot[j] >= 0) {
+               GLfloat (*reg)[VP_LANES] = ex.regs[code->OutputSlot[j]];
+               for (i = 0; i < VP_LANES; i++) {
+                  reg[0][i] = 0.0F;
+                  reg[1][i] = 0.0F;
+                  reg[2][i] = 0.0F;
+                  reg[3][i] = 1.0F;
+               }
+            }
+         }
+         _mesa_bzero(ex.regs[code->FirstTempSlot],
+                     (code->NumSlots - code->FirstTempSlot)
+                     * sizeof(ex.regs[0]));
+         for (i = 0; i < VP_LANES; i++)
+            ex.addr[i] = 0;
+      }
+
+      load_inputs(&ex, code, VB, start);
+
+      execute_code(&ex, code);
+
+      /* copy the output registers into the result arrays */
+      for (j = 0; j < VERT_RESULT_MAX; j++) {
+         if (program->Base.OutputsWritten & (1 << j)) {
+            const GLfloat (*reg)[VP_LANES] =
+               (const GLfloat (*)[VP_LANES]) ex.regs[code->OutputSlot[j]];
+            GLfloat (*out)[4] = results[j].data + start;
+            for (i = 0; i < ex.n; i++) {
+               out[i][0] = reg[0][i];
+               out[i][1] = reg[1][i];
+               out[i][2] = reg[2][i];
+               out[i][3] = reg[3][i];
+            }
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
@@ -0,0 +1,54 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef T_VP_SOA_H
+#define T_VP_SOA_H
+
+
+#include "main/mtypes.h"
+#include "t_context.h"
+
+
+struct tnl_vp_cache;
+struct tnl_vp_code;
+
+
+extern struct tnl_vp_cache *
+_tnl_create_vp_cache(void);
+
+extern void
+_tnl_destroy_vp_cache(struct tnl_vp_cache *cache);
+
+extern struct tnl_vp_code *
+_tnl_lookup_vp_code(struct tnl_vp_cache *cache,
+                    const struct gl_vertex_program *program);
+
+extern GLboolean
+_tnl_run_vp_code(GLcontext *ctx, struct tnl_vp_cache *cache,
+                 const struct tnl_vp_code *code,
+                 struct vertex_buffer *VB, GLvector4f results[]);
+
+
+#endif /* T_VP_SOA_H */
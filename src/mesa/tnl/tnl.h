@@ -66,6 +66,12 @@ _tnl_allow_vertex_fog( GLcontext *ctx, GLboolean value );
 extern void
 _tnl_allow_pixel_fog( GLcontext *ctx, GLboolean value );
 
+/* Let the cliptest accept triangles which extend past the viewport,
+ * which the rasterizer then clips to the window
+ */
+extern void
+_tnl_allow_guard_band( GLcontext *ctx, GLfloat size );
+
 extern void
 _tnl_program_string(GLcontext *ctx, GLenum target, struct gl_program *program);
 
@@ -54,6 +54,7 @@ void vbo_save_init( GLcontext *ctx )
    struct vbo_save_context *save = &vbo->save;
 
    save->ctx = ctx;
+   save->optimize = !_mesa_getenv("MESA_NO_LIST_OPTIMIZE");
 
    vbo_save_api_init( save );
    vbo_save_callback_init(ctx);
@@ -90,6 +91,9 @@ void vbo_save_destroy( GLcontext *ctx )
    for (i = 0; i < VBO_ATTRIB_MAX; i++) {
       _mesa_reference_buffer_object(ctx, &save->arrays[i].BufferObj, NULL);
    }
+
+   if (save->run)
+      _mesa_free(save->run);
 }
 
 
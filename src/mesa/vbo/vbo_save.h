@@ -75,6 +75,26 @@ struct vbo_save_vertex_list {
 
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
+
+   struct vbo_save_optimized_list *opt;
+};
+
+/* Display lists often contain many small, adjacent vertex lists of the
+ * same format.  At the end of a run of those, vbo_save_optimize.c
+ * rewrites their primitives as a few indexed primitives over
+ * deduplicated vertices, all stored in one buffer object.  The first
+ * vertex list of the run draws everything, the others only update the
+ * current values.  The original vertex lists are kept for the cases the
+ * optimized primitives can't handle, like unfilled polygon modes.
+ */
+struct vbo_save_optimized_list {
+   struct vbo_save_vertex_list *first;
+   struct gl_buffer_object *bufferobj;
+   GLuint count;		/* number of vertices */
+   struct _mesa_index_buffer ib;
+   struct _mesa_prim *prim;
+   GLuint prim_count;
+   GLuint refcount;
 };
 
 /* These buffers should be a reasonable size to support upload to
@@ -93,6 +113,9 @@ struct vbo_save_vertex_list {
 
 #define VBO_SAVE_FALLBACK    0x10000000
 
+/* An interesting VBO number/name to help with debugging */
+#define VBO_BUF_ID  12345
+
 /* Storage to be shared among several vertex_lists.
  */
 struct vbo_save_vertex_store {
@@ -140,6 +163,16 @@ struct vbo_save_context {
 
    GLuint opcode_vertex_list;
 
+   /* Run of adjacent vertex lists, see vbo_save_optimize.c:
+    */
+   GLboolean optimize;
+   struct vbo_save_vertex_list **run;
+   GLuint run_count, run_max;
+   GLuint run_verts;
+   const void *run_block;	/* list position following the run */
+   GLuint run_pos;
+   const struct vbo_save_optimized_list *opt_drawn;
+
    struct vbo_save_copied_vtx copied;
    
    GLfloat *current[VBO_ATTRIB_MAX]; /* points into ctx->ListState */
@@ -161,6 +194,16 @@ void vbo_loopback_vertex_list( GLcontext *ctx,
 			       GLuint wrap_count,
 			       GLuint vertex_size);
 
+/* vbo_save_optimize.c:
+ */
+void vbo_save_optimize_add( GLcontext *ctx,
+			    struct vbo_save_vertex_list *node,
+			    const void *block,
+			    GLuint pos );
+void vbo_save_optimize_finish( GLcontext *ctx );
+void vbo_save_optimize_destroy( GLcontext *ctx,
+				struct vbo_save_optimized_list *opt );
+
 /* Callbacks:
  */
 void vbo_save_EndList( GLcontext *ctx );
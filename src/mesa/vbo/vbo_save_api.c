@@ -86,10 +86,6 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 
 
-/* An interesting VBO number/name to help with debugging */
-#define VBO_BUF_ID  12345
-
-
 /*
  * NOTE: Old 'parity' issue is gone, but copying can still be
  * wrong-footed on replay.
@@ -263,6 +259,8 @@ static void _save_compile_vertex_list( GLcontext *ctx )
 {
    struct vbo_save_context *save = &vbo_context(ctx)->save;
    struct vbo_save_vertex_list *node;
+   const void *block = ctx->ListState.CurrentBlock;
+   const GLuint pos = ctx->ListState.CurrentPos;
 
    /* Allocate space for this structure in the display list currently
     * being compiled.
@@ -285,6 +283,7 @@ static void _save_compile_vertex_list( GLcontext *ctx )
    node->prim_count = save->prim_count;
    node->vertex_store = save->vertex_store;
    node->prim_store = save->prim_store;
+   node->opt = NULL;
 
    node->vertex_store->refcount++;
    node->prim_store->refcount++;
@@ -303,6 +302,8 @@ static void _save_compile_vertex_list( GLcontext *ctx )
     */
    save->copied.nr = _save_copy_vertices( ctx, node, save->buffer );
 
+   vbo_save_optimize_add( ctx, node, block, pos );
+
 
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
@@ -1036,6 +1037,8 @@ void vbo_save_NewList( GLcontext *ctx, GLuint list, GLenum mode )
       save->vertex_store = alloc_vertex_store( ctx );
       
    save->vbptr = map_vertex_store( ctx, save->vertex_store );
+   save->run_count = 0;
+   save->run_verts = 0;
    
    _save_reset_vertex( ctx );
    _save_reset_counters( ctx );  
@@ -1071,6 +1074,8 @@ void vbo_save_EndList( GLcontext *ctx )
       _mesa_install_save_vtxfmt( ctx, &ctx->ListState.ListVtxfmt );
    }
 
+   vbo_save_optimize_finish( ctx );
+
    unmap_vertex_store( ctx, save->vertex_store );
 
    assert(save->vertex_size == 0);
@@ -1105,6 +1110,9 @@ static void vbo_destroy_vertex_list( GLcontext *ctx, void *data )
 
    if ( --node->prim_store->refcount == 0 )
       FREE( node->prim_store );
+
+   if (node->opt && --node->opt->refcount == 0)
+      vbo_save_optimize_destroy( ctx, node->opt );
 }
 
 
@@ -1130,6 +1138,12 @@ static void vbo_print_vertex_list( GLcontext *ctx, void *data )
 		  (prim->begin) ? "BEGIN" : "(wrap)",
 		  (prim->end) ? "END" : "(wrap)");
    }
+
+   if (node->opt && node->opt->first == node)
+      _mesa_debug(NULL, "   optimized: %u vertices %u indices %u primitives\n",
+		  node->opt->count,
+		  node->opt->ib.count,
+		  node->opt->prim_count);
 }
 
 
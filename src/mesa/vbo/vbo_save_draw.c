@@ -99,15 +99,18 @@ static void _playback_copy_to_current( GLcontext *ctx,
 
 
 /* Treat the vertex storage as a VBO, define vertex arrays pointing
- * into it:
+ * into it.  The vertices are either the node's ones or the optimized
+ * ones, both with the node's vertex format:
  */
 static void vbo_bind_vertex_list( GLcontext *ctx,
-                                   const struct vbo_save_vertex_list *node )
+                                   const struct vbo_save_vertex_list *node,
+                                   struct gl_buffer_object *bufferobj,
+                                   GLuint data,
+                                   GLuint count )
 {
    struct vbo_context *vbo = vbo_context(ctx);
    struct vbo_save_context *save = &vbo->save;
    struct gl_client_array *arrays = save->arrays;
-   GLuint data = node->buffer_offset;
    const GLuint *map;
    GLuint attr;
 
@@ -153,8 +156,8 @@ static void vbo_bind_vertex_list( GLcontext *ctx,
 	 arrays[attr].Enabled = 1;
          _mesa_reference_buffer_object(ctx,
                                        &arrays[attr].BufferObj,
-                                       node->vertex_store->bufferobj);
-	 arrays[attr]._MaxElement = node->count; /* ??? */
+                                       bufferobj);
+	 arrays[attr]._MaxElement = count; /* ??? */
 	 
 	 assert(arrays[attr].BufferObj->Name);
 
@@ -184,6 +187,17 @@ static void vbo_save_loopback_vertex_list( GLcontext *ctx,
 }
 
 
+/* Can the optimized primitives of a run of vertex lists be drawn
+ * instead of the vertex lists?  Not if the edge flags matter.
+ */
+static GLboolean can_draw_optimized( GLcontext *ctx )
+{
+   return (ctx->RenderMode == GL_RENDER &&
+	   ctx->Polygon.FrontMode == GL_FILL &&
+	   ctx->Polygon.BackMode == GL_FILL);
+}
+
+
 /**
  * Execute the buffer and save copied verts.
  */
@@ -194,6 +208,19 @@ void vbo_save_playback_vertex_list( GLcontext *ctx, void *data )
 
    FLUSH_CURRENT(ctx, 0);
 
+   /* The first vertex list of an optimized run draws the whole run,
+    * the others only update the current values:
+    */
+   if (node->opt) {
+      if (node->opt->first == node) {
+	 save->opt_drawn = NULL;
+      }
+      else if (node->opt == save->opt_drawn) {
+	 _playback_copy_to_current( ctx, node );
+	 return;
+      }
+   }
+
    if (node->prim_count > 0 && node->count > 0) {
 
       if (ctx->Driver.CurrentExecPrimitive != PRIM_OUTSIDE_BEGIN_END &&
@@ -227,15 +254,34 @@ void vbo_save_playback_vertex_list( GLcontext *ctx, void *data )
          return;
       }
 
-      vbo_bind_vertex_list( ctx, node );
+      if (node->opt && node->opt->first == node &&
+	  can_draw_optimized( ctx )) {
+	 const struct vbo_save_optimized_list *opt = node->opt;
+
+	 vbo_bind_vertex_list( ctx, node, opt->bufferobj, 0, opt->count );
 
-      vbo_context(ctx)->draw_prims( ctx, 
-				    save->inputs, 
-				    node->prim, 
-				    node->prim_count,
-				    NULL,
-				    0,	/* Node is a VBO, so this is ok */
-				    node->count - 1);
+	 vbo_context(ctx)->draw_prims( ctx,
+				       save->inputs,
+				       opt->prim,
+				       opt->prim_count,
+				       &opt->ib,
+				       0,
+				       opt->count - 1);
+
+	 save->opt_drawn = opt;
+      }
+      else {
+	 vbo_bind_vertex_list( ctx, node, node->vertex_store->bufferobj,
+			       node->buffer_offset, node->count );
+
+	 vbo_context(ctx)->draw_prims( ctx, 
+				       save->inputs, 
+				       node->prim, 
+				       node->prim_count,
+				       NULL,
+				       0,	/* Node is a VBO, so this is ok */
+				       node->count - 1);
+      }
    }
 
    /* Copy to current?
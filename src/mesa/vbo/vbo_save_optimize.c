@@ -0,0 +1,395 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* Display list optimization: runs of adjacent vertex lists with the
+ * same vertex format are merged into indexed primitives over a single
+ * set of deduplicated vertices.
+ *
+ * Triangles, strips, fans and polygons all become GL_TRIANGLES, listing
+ * the vertices in the order the swtnl render functions pass them to the
+ * triangle function, so the provoking vertex for flat shading and the
+ * winding are unchanged.  Quads aren't split as clipping treats them as
+ * one polygon, but consecutive quads, points and lines are merged.  Line
+ * strips, line loops and quad strips are kept as separate indexed
+ * primitives.
+ */
+
+
+#include "main/glheader.h"
+#include "main/bufferobj.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+
+#include "vbo_context.h"
+
+
+/* Keep the indices of a run in GLushorts, and the vertices few enough
+ * to be drawn without splitting:
+ */
+#define MAX_RUN_VERTS(ctx) MIN2(0xffff, (ctx)->Const.MaxArrayLockSize)
+
+
+struct opt_state {
+   GLuint vertex_size;
+
+   GLfloat *verts;
+   GLuint nr_verts;
+
+   GLuint *hash;		/* vertex index + 1, or zero */
+   GLuint hash_mask;
+
+   GLushort *elts;
+   GLuint nr_elts;
+
+   struct _mesa_prim *prim;
+   GLuint nr_prims;
+};
+
+
+/* Return the index of the vertex, adding it if it isn't there yet.
+ */
+static GLuint add_vertex( struct opt_state *st, const GLfloat *v )
+{
+   const fi_type *w = (const fi_type *) v;
+   const GLuint bytes = st->vertex_size * sizeof(GLfloat);
+   GLuint hash = 2166136261u;
+   GLuint i;
+
+   for (i = 0; i < st->vertex_size; i++)
+      hash = (hash ^ (GLuint) w[i].i) * 16777619u;
+   hash ^= hash >> 16;
+
+   for (i = hash & st->hash_mask; st->hash[i]; i = (i + 1) & st->hash_mask) {
+      const GLuint idx = st->hash[i] - 1;
+      if (_mesa_memcmp(st->verts + idx * st->vertex_size, v, bytes) == 0)
+	 return idx;
+   }
+
+   _mesa_memcpy(st->verts + st->nr_verts * st->vertex_size, v, bytes);
+   st->hash[i] = ++st->nr_verts;
+   return st->nr_verts - 1;
+}
+
+
+/* Start a new output primitive, or continue the previous one if it has
+ * the same mode and is a merged one.
+ */
+static void begin_prim( struct opt_state *st, GLenum mode, GLboolean merge,
+			GLboolean begin, GLboolean end )
+{
+   struct _mesa_prim *prim;
+
+   if (merge && st->nr_prims) {
+      prim = &st->prim[st->nr_prims - 1];
+      if (prim->mode == mode &&
+	  (mode == GL_POINTS || mode == GL_LINES ||
+	   mode == GL_TRIANGLES || mode == GL_QUADS))
+	 return;
+   }
+
+   prim = &st->prim[st->nr_prims++];
+   _mesa_bzero(prim, sizeof(*prim));
+   prim->mode = mode;
+   prim->indexed = 1;
+   prim->begin = begin;
+   prim->end = end;
+   prim->start = st->nr_elts;
+}
+
+
+#define ELT(x)         st->elts[st->nr_elts++] = (GLushort) v[x]
+#define TRI(a, b, c)   do { ELT(a); ELT(b); ELT(c); } while (0)
+
+
+/* Append the indices of one primitive of a vertex list, v[] maps the
+ * vertices of the primitive to the deduplicated ones.
+ */
+static void add_prim( struct opt_state *st, const struct _mesa_prim *in,
+		      const GLuint *v )
+{
+   const GLuint n = in->count;
+   struct _mesa_prim *prim;
+   GLuint j;
+
+   switch (in->mode) {
+   case GL_POINTS:
+      begin_prim(st, GL_POINTS, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 0; j < n; j++)
+	 ELT(j);
+      break;
+   case GL_LINES:
+      begin_prim(st, GL_LINES, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 1; j < n; j += 2) {
+	 ELT(j-1);
+	 ELT(j);
+      }
+      break;
+   case GL_LINE_STRIP:
+   case GL_LINE_LOOP:
+      /* vbo_split_copy() can't handle strips shorter than a line:
+       */
+      begin_prim(st, in->mode, GL_FALSE, in->begin, in->end);
+      for (j = 0; j < n && n >= 2; j++)
+	 ELT(j);
+      break;
+   case GL_TRIANGLES:
+      begin_prim(st, GL_TRIANGLES, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 2; j < n; j += 3)
+	 TRI(j-2, j-1, j);
+      break;
+   case GL_TRIANGLE_STRIP:
+      begin_prim(st, GL_TRIANGLES, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 2; j < n; j++) {
+	 const GLuint parity = j & 1;
+	 TRI(j-2+parity, j-1-parity, j);
+      }
+      break;
+   case GL_TRIANGLE_FAN:
+      begin_prim(st, GL_TRIANGLES, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 2; j < n; j++)
+	 TRI(0, j-1, j);
+      break;
+   case GL_POLYGON:
+      begin_prim(st, GL_TRIANGLES, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 2; j < n; j++)
+	 TRI(j-1, j, 0);
+      break;
+   case GL_QUADS:
+      begin_prim(st, GL_QUADS, GL_TRUE, GL_TRUE, GL_TRUE);
+      for (j = 3; j < n; j += 4) {
+	 ELT(j-3);
+	 ELT(j-2);
+	 ELT(j-1);
+	 ELT(j);
+      }
+      break;
+   case GL_QUAD_STRIP:
+      begin_prim(st, GL_QUAD_STRIP, GL_FALSE, in->begin, in->end);
+      for (j = 0; j < (n & ~1) && n >= 4; j++)
+	 ELT(j);
+      break;
+   default:
+      assert(0);
+      return;
+   }
+
+   prim = &st->prim[st->nr_prims - 1];
+   prim->count = st->nr_elts - prim->start;
+
+   /* Drop primitives which didn't get any vertices, but keep the
+    * begin/end flags of line strips and loops:
+    */
+   if (prim->count == 0 &&
+       prim->mode != GL_LINE_STRIP && prim->mode != GL_LINE_LOOP)
+      st->nr_prims--;
+}
+
+#undef ELT
+#undef TRI
+
+
+static void optimize_run( GLcontext *ctx,
+			  struct vbo_save_vertex_list **run,
+			  GLuint run_count )
+{
+   struct vbo_save_optimized_list *opt;
+   struct opt_state st;
+   GLuint total_verts = 0, total_prims = 0, max_count = 0;
+   GLuint hash_size, vertex_bytes, i, j;
+   GLuint *remap;
+   GLubyte *data;
+
+   for (i = 0; i < run_count; i++) {
+      total_verts += run[i]->count;
+      total_prims += run[i]->prim_count;
+      max_count = MAX2(max_count, run[i]->count);
+   }
+
+   /* Nothing to gain from a single primitive:
+    */
+   if (total_prims < 2)
+      return;
+
+   for (hash_size = 64; hash_size < total_verts * 2; hash_size *= 2)
+      ;
+
+   _mesa_bzero(&st, sizeof(st));
+   st.vertex_size = run[0]->vertex_size;
+   st.verts = (GLfloat *) _mesa_malloc(total_verts * st.vertex_size * sizeof(GLfloat));
+   st.hash = (GLuint *) _mesa_calloc(hash_size * sizeof(GLuint));
+   st.hash_mask = hash_size - 1;
+   st.elts = (GLushort *) _mesa_malloc(total_verts * 3 * sizeof(GLushort));
+   st.prim = (struct _mesa_prim *) _mesa_malloc(total_prims * sizeof(struct _mesa_prim));
+   remap = (GLuint *) _mesa_malloc(max_count * sizeof(GLuint));
+
+   if (!st.verts || !st.hash || !st.elts || !st.prim || !remap)
+      goto out;
+
+   for (i = 0; i < run_count; i++) {
+      const struct vbo_save_vertex_list *node = run[i];
+      struct vbo_save_vertex_store *store = node->vertex_store;
+      const GLubyte *buffer = (const GLubyte *) store->buffer;
+      const GLfloat *src;
+
+      /* The vertex store of the current vertex lists is mapped, older
+       * ones aren't:
+       */
+      if (!buffer)
+	 buffer = ctx->Driver.MapBuffer(ctx, GL_ARRAY_BUFFER_ARB,
+					GL_READ_ONLY, store->bufferobj);
+
+      src = (const GLfloat *) (buffer + node->buffer_offset);
+      for (j = 0; j < node->count; j++)
+	 remap[j] = add_vertex(&st, src + j * st.vertex_size);
+
+      if (!store->buffer)
+	 ctx->Driver.UnmapBuffer(ctx, GL_ARRAY_BUFFER_ARB, store->bufferobj);
+
+      for (j = 0; j < node->prim_count; j++)
+	 add_prim(&st, &node->prim[j], remap + node->prim[j].start);
+   }
+
+   if (st.nr_prims >= total_prims || st.nr_elts == 0)
+      goto out;
+
+   /* Vertices followed by the indices in one buffer object:
+    */
+   vertex_bytes = st.nr_verts * st.vertex_size * sizeof(GLfloat);
+   data = (GLubyte *) _mesa_malloc(vertex_bytes + st.nr_elts * sizeof(GLushort));
+   opt = CALLOC_STRUCT(vbo_save_optimized_list);
+   if (!data || !opt) {
+      _mesa_free(data);
+      _mesa_free(opt);
+      goto out;
+   }
+
+   _mesa_memcpy(data, st.verts, vertex_bytes);
+   _mesa_memcpy(data + vertex_bytes, st.elts, st.nr_elts * sizeof(GLushort));
+
+   opt->bufferobj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID,
+						GL_ARRAY_BUFFER_ARB);
+   ctx->Driver.BufferData(ctx,
+			  GL_ARRAY_BUFFER_ARB,
+			  vertex_bytes + st.nr_elts * sizeof(GLushort),
+			  data,
+			  GL_STATIC_DRAW_ARB,
+			  opt->bufferobj);
+   _mesa_free(data);
+
+   opt->first = run[0];
+   opt->count = st.nr_verts;
+   opt->ib.count = st.nr_elts;
+   opt->ib.type = GL_UNSIGNED_SHORT;
+   opt->ib.obj = opt->bufferobj;
+   opt->ib.ptr = (const void *) (GLintptrARB) vertex_bytes;
+   opt->prim = st.prim;
+   opt->prim_count = st.nr_prims;
+   opt->refcount = run_count;
+   st.prim = NULL;
+
+   for (i = 0; i < run_count; i++)
+      run[i]->opt = opt;
+
+ out:
+   _mesa_free(st.verts);
+   _mesa_free(st.hash);
+   _mesa_free(st.elts);
+   _mesa_free(st.prim);
+   _mesa_free(remap);
+}
+
+
+/**
+ * Called for each vertex list compiled.  block and pos are the display
+ * list position the vertex list was allocated at.
+ */
+void vbo_save_optimize_add( GLcontext *ctx,
+			    struct vbo_save_vertex_list *node,
+			    const void *block,
+			    GLuint pos )
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   const GLboolean ok = (save->optimize &&
+			 node->count > 0 &&
+			 node->count <= MAX_RUN_VERTS(ctx) &&
+			 node->prim_count > 0);
+
+   /* Anything compiled since the last vertex list ends the run:
+    */
+   if (save->run_count) {
+      const struct vbo_save_vertex_list *first = save->run[0];
+
+      if (!ok ||
+	  block != save->run_block ||
+	  pos != save->run_pos ||
+	  node->vertex_size != first->vertex_size ||
+	  _mesa_memcmp(node->attrsz, first->attrsz, sizeof(node->attrsz)) ||
+	  save->run_verts + node->count > MAX_RUN_VERTS(ctx))
+	 vbo_save_optimize_finish( ctx );
+   }
+
+   if (!ok)
+      return;
+
+   if (save->run_count == save->run_max) {
+      const GLuint max = MAX2(save->run_max * 2, 16);
+      save->run = (struct vbo_save_vertex_list **)
+	 _mesa_realloc(save->run,
+		       save->run_max * sizeof(*save->run),
+		       max * sizeof(*save->run));
+      save->run_max = max;
+   }
+
+   save->run[save->run_count++] = node;
+   save->run_verts += node->count;
+   save->run_block = ctx->ListState.CurrentBlock;
+   save->run_pos = ctx->ListState.CurrentPos;
+}
+
+
+/**
+ * Optimize the current run of vertex lists, if there is one.
+ */
+void vbo_save_optimize_finish( GLcontext *ctx )
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+
+   if (save->run_count)
+      optimize_run( ctx, save->run, save->run_count );
+
+   save->run_count = 0;
+   save->run_verts = 0;
+}
+
+
+void vbo_save_optimize_destroy( GLcontext *ctx,
+				struct vbo_save_optimized_list *opt )
+{
+   _mesa_reference_buffer_object(ctx, &opt->bufferobj, NULL);
+   _mesa_free(opt->prim);
+   _mesa_free(opt);
+}
@@ -184,6 +184,8 @@ static void begin( struct copy_context *copy, GLenum mode, GLboolean begin_flag
 		
    prim->mode = mode;
    prim->begin = begin_flag;
+   prim->indexed = 1;
+   prim->start = copy->dstelt_nr;
 }
 
 
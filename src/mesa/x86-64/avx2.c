@@ -0,0 +1,121 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * AVX2/FMA versions of the vertex transformation, normal transformation
+ * and clip test functions.  Two vertices are processed per 256-bit
+ * register.  The functions are compiled for AVX2 with a function
+ * attribute and only plugged in by _mesa_init_all_x86_64_transform_asm()
+ * if the CPU and OS support AVX2 and FMA.
+ *
+ * Note that the fused multiply-adds round differently than the C code.
+ *
+ * Also the RGBA lighting functions, eight vertices per register.  These
+ * are compiled without FMA, to give the same colors as the C code.
+ */
+
+#include "main/glheader.h"
+#include "main/light.h"
+#include "main/macros.h"
+#include "main/simple_list.h"
+#include "math/m_xform.h"
+
+#include "x86-64.h"
+#include "../x86/common_x86_macros.h"
+
+
+#ifdef USE_X86_64_AVX2
+
+#include <immintrin.h>
+#include "simd.h"
+
+#define TAG(x) _mesa_avx2_##x
+#define SIMD_FUNC __attribute__((__target__("avx2,fma")))
+#define LANES 2
+#define VEC __m256
+
+/* the second vertex is the next one, or the last one again at the end */
+#define VDUP(c)								\
+   _mm256_insertf128_ps(_mm256_castps128_ps256(c), c, 1)
+#define VLOAD(load, p, next)						\
+   _mm256_insertf128_ps(_mm256_castps128_ps256(load(p)),		\
+			load((const GLfloat *) ((const GLubyte *) (p) + (next))), 1)
+#define VNEXT(i, count, stride)	((i) + 1 < (count) ? (stride) : 0)
+#define VSTORE(p, v, left)						\
+do {									\
+   if ((left) >= 2)							\
+      _mm256_storeu_ps(p, v);						\
+   else									\
+      _mm_storeu_ps(p, _mm256_castps256_ps128(v));			\
+} while (0)
+#define VSET1(f)		_mm256_set1_ps(f)
+#define VSPLAT(v, k)		_mm256_permute_ps(v, (k) * 0x55)
+#define VSHUF(v, imm)		_mm256_permute_ps(v, imm)
+#define VADD(a, b)		_mm256_add_ps(a, b)
+#define VSUB(a, b)		_mm256_sub_ps(a, b)
+#define VMUL(a, b)		_mm256_mul_ps(a, b)
+#define VDIV(a, b)		_mm256_div_ps(a, b)
+#define VRSQRT(a)		_mm256_rsqrt_ps(a)
+#define VMADD(a, b, c)		_mm256_fmadd_ps(a, b, c)
+#define VAND(a, b)		_mm256_and_ps(a, b)
+#define VANDNOT(a, b)		_mm256_andnot_ps(a, b)
+#define VOR(a, b)		_mm256_or_ps(a, b)
+#define VCMPGT(a, b)		_mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define VCMPLT(a, b)		_mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define VMOVEMASK(a)		((GLuint) _mm256_movemask_ps(a))
+#define VSQRT(a)		_mm256_sqrt_ps(a)
+#define VLOADU(p)		_mm256_loadu_ps(p)
+#define VSTOREU(p, v)		_mm256_storeu_ps(p, v)
+#define VTRUE			_mm256_castsi256_ps(_mm256_set1_epi32(-1))
+
+DECLARE_XFORM_GROUP( avx2, 1 )
+DECLARE_XFORM_GROUP( avx2, 2 )
+DECLARE_XFORM_GROUP( avx2, 3 )
+DECLARE_XFORM_GROUP( avx2, 4 )
+DECLARE_NORM_GROUP( avx2 )
+DECLARE_CLIP_GROUP( avx2 )
+DECLARE_CLIP_GB_GROUP( avx2 )
+
+#define SZ 1
+#include "simd_xform_tmp.h"
+#define SZ 2
+#include "simd_xform_tmp.h"
+#define SZ 3
+#include "simd_xform_tmp.h"
+#define SZ 4
+#include "simd_xform_tmp.h"
+
+#include "simd_norm_tmp.h"
+#include "simd_clip_tmp.h"
+
+/* Without FMA, so that the multiplies and adds can't be contracted.
+ */
+#undef SIMD_FUNC
+#define SIMD_FUNC __attribute__((__target__("avx2")))
+#define SOA_LANES 8
+#include "simd_light_tmp.h"
+
+#endif /* USE_X86_64_AVX2 */
@@ -0,0 +1,138 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/**
+ * Helpers shared by the SSE2 and AVX2 transformation code.
+ */
+
+#ifndef X86_64_SIMD_H
+#define X86_64_SIMD_H
+
+#include <emmintrin.h>
+
+
+/**
+ * Load a vector of 1 to 4 floats into an SSE register, zero-filling the
+ * missing components.  These never read past the last component, so they
+ * can be used on the last element of a tightly packed array.
+ */
+static INLINE __m128
+load_1f(const GLfloat *p)
+{
+   return _mm_load_ss(p);
+}
+
+static INLINE __m128
+load_2f(const GLfloat *p)
+{
+   return _mm_castpd_ps(_mm_load_sd((const double *) p));
+}
+
+static INLINE __m128
+load_3f(const GLfloat *p)
+{
+   return _mm_movelh_ps(load_2f(p), _mm_load_ss(p + 2));
+}
+
+static INLINE __m128
+load_4f(const GLfloat *p)
+{
+   return _mm_loadu_ps(p);
+}
+
+
+/* Extra term of the transformations done by kernel_diag().
+ */
+#define DIAG_ONLY	0
+#define DIAG_SWAP_XY	1
+#define DIAG_Z		2
+
+
+/**
+ * Set up the columns of a transformation matrix of the given type,
+ * with the elements the C functions treat as zero or one set to that.
+ */
+static INLINE void
+get_matrix_columns(__m128 c[4], const GLfloat m[16], enum GLmatrixtype type)
+{
+   switch (type) {
+   case MATRIX_3D:
+      c[0] = _mm_setr_ps(m[0], m[1], m[2], 0);
+      c[1] = _mm_setr_ps(m[4], m[5], m[6], 0);
+      c[2] = _mm_setr_ps(m[8], m[9], m[10], 0);
+      c[3] = _mm_setr_ps(m[12], m[13], m[14], 1);
+      break;
+   default:
+      c[0] = _mm_loadu_ps(m);
+      c[1] = _mm_loadu_ps(m + 4);
+      c[2] = _mm_loadu_ps(m + 8);
+      c[3] = _mm_loadu_ps(m + 12);
+      break;
+   }
+}
+
+
+static INLINE void
+set_vector_size(GLvector4f *vec, GLuint count, GLuint size)
+{
+   static const GLuint size_flags[5] = {
+      0, VEC_SIZE_1, VEC_SIZE_2, VEC_SIZE_3, VEC_SIZE_4
+   };
+   vec->size = size;
+   vec->flags |= size_flags[size];
+   vec->count = count;
+}
+
+
+/**
+ * Clip flags for the x, y, z lanes of a _mm_movemask_ps() result.
+ * clip_pos_bits[] is for coordinates beyond +w (or +1), clip_neg_bits[]
+ * for coordinates beyond -w (or -1).
+ */
+static const GLubyte clip_pos_bits[8] = {
+   0,
+   CLIP_RIGHT_BIT,
+   CLIP_TOP_BIT,
+   CLIP_RIGHT_BIT | CLIP_TOP_BIT,
+   CLIP_FAR_BIT,
+   CLIP_RIGHT_BIT | CLIP_FAR_BIT,
+   CLIP_TOP_BIT | CLIP_FAR_BIT,
+   CLIP_RIGHT_BIT | CLIP_TOP_BIT | CLIP_FAR_BIT
+};
+
+static const GLubyte clip_neg_bits[8] = {
+   0,
+   CLIP_LEFT_BIT,
+   CLIP_BOTTOM_BIT,
+   CLIP_LEFT_BIT | CLIP_BOTTOM_BIT,
+   CLIP_NEAR_BIT,
+   CLIP_LEFT_BIT | CLIP_NEAR_BIT,
+   CLIP_BOTTOM_BIT | CLIP_NEAR_BIT,
+   CLIP_LEFT_BIT | CLIP_BOTTOM_BIT | CLIP_NEAR_BIT
+};
+
+
+#endif /* X86_64_SIMD_H */
@@ -0,0 +1,226 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * Clip tests for sse2.c and avx2.c, matching the C code in
+ * math/m_clip_tmp.h.  The clip flags are computed with vector compares
+ * and looked up from the compare masks with the clip_pos_bits[] and
+ * clip_neg_bits[] tables.  Of the guard band tests only the 4-component
+ * one is done here; the others are rarely used.
+ */
+
+
+/**
+ * Store the clip flags of the vertices in the compare masks pos and neg,
+ * and accumulate them in the or/and masks.
+ */
+#define STORE_CLIP_FLAGS(pos, neg)					\
+do {									\
+   const GLuint p = VMOVEMASK(pos), n = VMOVEMASK(neg);		\
+   GLuint j;								\
+   for (j = 0; j < LANES && i + j < count; j++) {			\
+      const GLubyte mask = clip_pos_bits[(p >> (4 * j)) & 7] |		\
+			   clip_neg_bits[(n >> (4 * j)) & 7];		\
+      clipMask[i + j] = mask;						\
+      tmpOrMask |= mask;						\
+      tmpAndMask &= mask;						\
+   }									\
+} while (0)
+
+
+/**
+ * Clip test and projection of 4-component vertices.  The x, y, z and w
+ * components of scale multiply w for the comparisons, which gives the
+ * guard band test of cliptest_gb_points4().
+ */
+static INLINE GLvector4f * SIMD_FUNC
+TAG(cliptest_scaled_points4)( GLvector4f *clip_vec,
+			      GLvector4f *proj_vec,
+			      GLubyte clipMask[],
+			      GLubyte *orMask,
+			      GLubyte *andMask,
+			      const VEC scale )
+{
+   const GLuint stride = clip_vec->stride;
+   GLfloat *from = clip_vec->start;
+   const GLuint count = clip_vec->count;
+   GLfloat (*vProj)[4] = (GLfloat (*)[4]) proj_vec->start;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   const VEC zero = VSET1(0.0F), one = VSET1(1.0F);
+   const VEC xyz = VDUP(_mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+   const VEC w1 = VDUP(_mm_setr_ps(0, 0, 0, 1));
+   GLuint i;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(load_4f, from, VNEXT(i, count, stride));
+      const VEC w = VSPLAT(v, 3);
+      const VEC ws = VMUL(w, scale);
+      const VEC pos = VAND(VCMPGT(v, ws), xyz);
+      const VEC neg = VAND(VCMPLT(v, VSUB(zero, ws)), xyz);
+      VEC clipped, oow, proj;
+
+      STORE_CLIP_FLAGS(pos, neg);
+
+      /* spread the clip test result to all lanes of each vertex */
+      clipped = VOR(pos, neg);
+      clipped = VOR(clipped, VSHUF(clipped, _MM_SHUFFLE(2, 3, 0, 1)));
+      clipped = VOR(clipped, VSHUF(clipped, _MM_SHUFFLE(1, 0, 3, 2)));
+
+      /* don't divide by the w of clipped vertices */
+      oow = VDIV(one, VOR(VAND(clipped, one), VANDNOT(clipped, w)));
+      proj = VOR(VAND(VMUL(v, oow), xyz), VANDNOT(xyz, oow));
+      proj = VOR(VAND(clipped, w1), VANDNOT(clipped, proj));
+      VSTORE(vProj[i], proj, count - i);
+      STRIDE_F(from, LANES * stride);
+   }
+
+   /* tmpAndMask is zero if any vertex is unclipped */
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+
+   proj_vec->flags |= VEC_SIZE_4;
+   proj_vec->size = 4;
+   proj_vec->count = clip_vec->count;
+   return proj_vec;
+}
+
+
+GLvector4f * _ASMAPI SIMD_FUNC
+TAG(cliptest_points4)( GLvector4f *clip_vec,
+		       GLvector4f *proj_vec,
+		       GLubyte clipMask[],
+		       GLubyte *orMask,
+		       GLubyte *andMask )
+{
+   return TAG(cliptest_scaled_points4)(clip_vec, proj_vec, clipMask,
+				       orMask, andMask, VSET1(1.0F));
+}
+
+
+GLvector4f * _ASMAPI SIMD_FUNC
+TAG(cliptest_gb_points4)( GLvector4f *clip_vec,
+			  GLvector4f *proj_vec,
+			  GLubyte clipMask[],
+			  GLubyte *orMask,
+			  GLubyte *andMask,
+			  const GLfloat guard[2] )
+{
+   const VEC scale = VDUP(_mm_setr_ps(guard[0], guard[1], 1.0F, 1.0F));
+   return TAG(cliptest_scaled_points4)(clip_vec, proj_vec, clipMask,
+				       orMask, andMask, scale);
+}
+
+
+GLvector4f * _ASMAPI SIMD_FUNC
+TAG(cliptest_np_points4)( GLvector4f *clip_vec,
+			  GLvector4f *proj_vec,
+			  GLubyte clipMask[],
+			  GLubyte *orMask,
+			  GLubyte *andMask )
+{
+   const GLuint stride = clip_vec->stride;
+   GLfloat *from = clip_vec->start;
+   const GLuint count = clip_vec->count;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   const VEC zero = VSET1(0.0F);
+   GLuint i;
+
+   (void) proj_vec;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(load_4f, from, VNEXT(i, count, stride));
+      const VEC w = VSPLAT(v, 3);
+      STORE_CLIP_FLAGS(VCMPGT(v, w), VCMPLT(v, VSUB(zero, w)));
+      STRIDE_F(from, LANES * stride);
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+   return clip_vec;
+}
+
+
+GLvector4f * _ASMAPI SIMD_FUNC
+TAG(cliptest_points3)( GLvector4f *clip_vec,
+		       GLvector4f *proj_vec,
+		       GLubyte clipMask[],
+		       GLubyte *orMask,
+		       GLubyte *andMask )
+{
+   const GLuint stride = clip_vec->stride;
+   GLfloat *from = clip_vec->start;
+   const GLuint count = clip_vec->count;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   const VEC one = VSET1(1.0F), minusOne = VSET1(-1.0F);
+   GLuint i;
+
+   (void) proj_vec;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(load_3f, from, VNEXT(i, count, stride));
+      STORE_CLIP_FLAGS(VCMPGT(v, one), VCMPLT(v, minusOne));
+      STRIDE_F(from, LANES * stride);
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+   return clip_vec;
+}
+
+
+GLvector4f * _ASMAPI SIMD_FUNC
+TAG(cliptest_points2)( GLvector4f *clip_vec,
+		       GLvector4f *proj_vec,
+		       GLubyte clipMask[],
+		       GLubyte *orMask,
+		       GLubyte *andMask )
+{
+   const GLuint stride = clip_vec->stride;
+   GLfloat *from = clip_vec->start;
+   const GLuint count = clip_vec->count;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   const VEC one = VSET1(1.0F), minusOne = VSET1(-1.0F);
+   GLuint i;
+
+   (void) proj_vec;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(load_2f, from, VNEXT(i, count, stride));
+      STORE_CLIP_FLAGS(VCMPGT(v, one), VCMPLT(v, minusOne));
+      STRIDE_F(from, LANES * stride);
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+   return clip_vec;
+}
+
+
+#undef STORE_CLIP_FLAGS
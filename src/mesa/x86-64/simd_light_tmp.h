@@ -0,0 +1,446 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+
+/*
+ * Lighting for sse2.c and avx2.c, matching the RGBA functions
+ * light_rgba(), light_rgba_spec() and light_fast_rgba() in
+ * tnl/t_vb_lighttmp.h.  The vertices are lit SOA_LANES at a time: their
+ * normals and coordinates are copied into one register per component,
+ * and each light is applied to all lanes with masks in place of the
+ * branches of the C code.  The spot exponent and shininess table lookups
+ * are done one lane at a time.
+ *
+ * The operations are done in the same order as in the C code and
+ * without fused multiply-adds, so the colors are the same unless the
+ * compiler is allowed to reorder them (-ffast-math).
+ */
+
+
+#define VSEL(mask, a, b)	VOR(VAND(mask, a), VANDNOT(mask, b))
+#define VNEG(a)			VSUB(VSET1(-0.0F), a)
+
+
+static INLINE void SIMD_FUNC
+TAG(splat3)( VEC v[3], const GLfloat *c )
+{
+   v[0] = VSET1(c[0]);
+   v[1] = VSET1(c[1]);
+   v[2] = VSET1(c[2]);
+}
+
+
+static INLINE VEC SIMD_FUNC
+TAG(dot3)( const VEC a[3], const VEC b[3] )
+{
+   return VADD(VADD(VMUL(a[0], b[0]), VMUL(a[1], b[1])), VMUL(a[2], b[2]));
+}
+
+
+/**
+ * Like NORMALIZE_3FV(): vectors of length zero are left alone.
+ */
+static INLINE void SIMD_FUNC
+TAG(normalize3)( VEC v[3] )
+{
+   const VEC len = TAG(dot3)(v, v);
+   const VEC nonzero = VCMPGT(len, VSET1(0.0F));
+   const VEC inv = VDIV(VSET1(1.0F), VSQRT(len));
+   v[0] = VSEL(nonzero, VMUL(v[0], inv), v[0]);
+   v[1] = VSEL(nonzero, VMUL(v[1], inv), v[1]);
+   v[2] = VSEL(nonzero, VMUL(v[2], inv), v[2]);
+}
+
+
+/**
+ * ACC_SCALE_SCALAR_3V(sum, s, c) for the lanes in mask.
+ */
+static INLINE void SIMD_FUNC
+TAG(acc_scale3)( VEC sum[3], VEC mask, VEC s, const VEC c[3] )
+{
+   sum[0] = VADD(sum[0], VAND(mask, VMUL(s, c[0])));
+   sum[1] = VADD(sum[1], VAND(mask, VMUL(s, c[1])));
+   sum[2] = VADD(sum[2], VAND(mask, VMUL(s, c[2])));
+}
+
+
+/**
+ * Return the specular coefficients for the lanes in mask, zero for the
+ * others.  The lanes in back use the back material shininess.
+ */
+static INLINE VEC SIMD_FUNC
+TAG(shine)( GLcontext *ctx, VEC n_dot_h, VEC mask, VEC back )
+{
+   const GLuint m = VMOVEMASK(mask), b = VMOVEMASK(back);
+   GLfloat dp[SOA_LANES], coef[SOA_LANES];
+   GLuint i;
+
+   VSTOREU(dp, n_dot_h);
+   for (i = 0; i < SOA_LANES; i++) {
+      coef[i] = 0.0F;
+      if (m & (1 << i))
+	 GET_SHINE_TAB_ENTRY( ctx->_ShineTable[(b >> i) & 1], dp[i], coef[i] );
+   }
+   return VLOADU(coef);
+}
+
+
+/**
+ * Scale the attenuation by the spot exponent, or set it to zero for the
+ * lanes outside the cone of the spot light.
+ */
+static INLINE VEC SIMD_FUNC
+TAG(spot)( const struct gl_light *light, VEC dot_dir, VEC attenuation )
+{
+   GLfloat dot[SOA_LANES], att[SOA_LANES];
+   GLuint i;
+
+   VSTOREU(dot, dot_dir);
+   VSTOREU(att, attenuation);
+   for (i = 0; i < SOA_LANES; i++) {
+      GLfloat PV_dot_dir = -dot[i];
+
+      if (PV_dot_dir < light->_CosCutoff) {
+	 att[i] = 0.0F;
+      }
+      else {
+	 GLdouble x = PV_dot_dir * (EXP_TABLE_SIZE-1);
+	 GLint k = (GLint) x;
+	 GLfloat spot = (GLfloat) (light->_SpotExpTable[k][0]
+				   + (x-k)*light->_SpotExpTable[k][1]);
+	 att[i] *= spot;
+      }
+   }
+   return VLOADU(att);
+}
+
+
+/**
+ * Add the contribution of an infinite light without attenuation, like
+ * light_fast_rgba().
+ */
+static INLINE void SIMD_FUNC
+TAG(light_infinite)( GLcontext *ctx, const struct gl_light *light,
+		     const VEC normal[3], VEC sum[2][3], GLboolean twoside )
+{
+   const VEC zero = VSET1(0.0F);
+   VEC VP[3], h[3], c[3];
+   VEC n_dot_VP, n_dot_h, front, back, mask;
+
+   sum[0][0] = VADD(sum[0][0], VSET1(light->_MatAmbient[0][0]));
+   sum[0][1] = VADD(sum[0][1], VSET1(light->_MatAmbient[0][1]));
+   sum[0][2] = VADD(sum[0][2], VSET1(light->_MatAmbient[0][2]));
+   if (twoside) {
+      sum[1][0] = VADD(sum[1][0], VSET1(light->_MatAmbient[1][0]));
+      sum[1][1] = VADD(sum[1][1], VSET1(light->_MatAmbient[1][1]));
+      sum[1][2] = VADD(sum[1][2], VSET1(light->_MatAmbient[1][2]));
+   }
+
+   TAG(splat3)(VP, light->_VP_inf_norm);
+   TAG(splat3)(h, light->_h_inf_norm);
+   n_dot_VP = TAG(dot3)(normal, VP);
+   n_dot_h = TAG(dot3)(normal, h);
+   front = VCMPGT(n_dot_VP, zero);
+
+   TAG(splat3)(c, light->_MatDiffuse[0]);
+   TAG(acc_scale3)(sum[0], front, n_dot_VP, c);
+
+   if (twoside) {
+      back = VANDNOT(front, VTRUE);
+      TAG(splat3)(c, light->_MatDiffuse[1]);
+      TAG(acc_scale3)(sum[1], back, VNEG(n_dot_VP), c);
+      n_dot_h = VSEL(back, VNEG(n_dot_h), n_dot_h);
+      mask = VCMPGT(n_dot_h, zero);
+   }
+   else {
+      back = zero;
+      mask = VAND(front, VCMPGT(n_dot_h, zero));
+   }
+
+   if (VMOVEMASK(mask)) {
+      const VEC spec = TAG(shine)(ctx, n_dot_h, mask, back);
+      TAG(splat3)(c, light->_MatSpecular[0]);
+      TAG(acc_scale3)(sum[0], VANDNOT(back, mask), spec, c);
+      if (twoside) {
+	 TAG(splat3)(c, light->_MatSpecular[1]);
+	 TAG(acc_scale3)(sum[1], VAND(back, mask), spec, c);
+      }
+   }
+}
+
+
+/**
+ * Add the contribution of any light, like light_rgba() or, if the
+ * specular color is separate, light_rgba_spec().
+ */
+static INLINE void SIMD_FUNC
+TAG(light_general)( GLcontext *ctx, const struct gl_light *light,
+		    const VEC normal[3], const VEC vertex[3],
+		    VEC sum[2][3], VEC spec[2][3], GLuint flags )
+{
+   const VEC zero = VSET1(0.0F);
+   VEC VP[3], h[3], amb[3], diff[3], specular[3], contrib[3];
+   VEC attenuation, n_dot_VP, n_dot_h, lit, front, back, mask;
+
+   /* compute VP and attenuation */
+   if (!(light->_Flags & LIGHT_POSITIONAL)) {
+      /* directional light */
+      if (light->_VP_inf_spot_attenuation < 1e-3)
+	 return;
+      TAG(splat3)(VP, light->_VP_inf_norm);
+      attenuation = VSET1(light->_VP_inf_spot_attenuation);
+   }
+   else {
+      VEC d, invd, far;
+
+      VP[0] = VSUB(VSET1(light->_Position[0]), vertex[0]);
+      VP[1] = VSUB(VSET1(light->_Position[1]), vertex[1]);
+      VP[2] = VSUB(VSET1(light->_Position[2]), vertex[2]);
+
+      d = VSQRT(TAG(dot3)(VP, VP));
+      far = VCMPGT(d, VSET1(1e-6F));
+      invd = VDIV(VSET1(1.0F), d);
+      VP[0] = VSEL(far, VMUL(VP[0], invd), VP[0]);
+      VP[1] = VSEL(far, VMUL(VP[1], invd), VP[1]);
+      VP[2] = VSEL(far, VMUL(VP[2], invd), VP[2]);
+
+      attenuation =
+	 VDIV(VSET1(1.0F),
+	      VADD(VSET1(light->ConstantAttenuation),
+		   VMUL(d, VADD(VSET1(light->LinearAttenuation),
+				VMUL(d, VSET1(light->QuadraticAttenuation))))));
+
+      /* spotlight attenuation */
+      if (light->_Flags & LIGHT_SPOT) {
+	 TAG(splat3)(h, light->_NormDirection);
+	 attenuation = TAG(spot)(light, TAG(dot3)(VP, h), attenuation);
+      }
+   }
+
+   lit = VANDNOT(VCMPLT(attenuation, VSET1(1e-3F)), VTRUE);
+   if (!VMOVEMASK(lit))
+      return;		/* this light makes no contribution */
+
+   /* Which side gets the diffuse & specular terms? */
+   n_dot_VP = TAG(dot3)(normal, VP);
+   back = VAND(lit, VCMPLT(n_dot_VP, zero));
+   front = VANDNOT(back, lit);
+
+   TAG(splat3)(amb, light->_MatAmbient[0]);
+   TAG(acc_scale3)(sum[0], back, attenuation, amb);
+   TAG(splat3)(diff, light->_MatDiffuse[0]);
+   TAG(splat3)(specular, light->_MatSpecular[0]);
+
+   if (flags & X86_64_LIGHT_TWOSIDE) {
+      VEC c[3];
+
+      TAG(splat3)(c, light->_MatAmbient[1]);
+      TAG(acc_scale3)(sum[1], front, attenuation, c);
+      amb[0] = VSEL(back, c[0], amb[0]);
+      amb[1] = VSEL(back, c[1], amb[1]);
+      amb[2] = VSEL(back, c[2], amb[2]);
+
+      TAG(splat3)(c, light->_MatDiffuse[1]);
+      diff[0] = VSEL(back, c[0], diff[0]);
+      diff[1] = VSEL(back, c[1], diff[1]);
+      diff[2] = VSEL(back, c[2], diff[2]);
+
+      TAG(splat3)(c, light->_MatSpecular[1]);
+      specular[0] = VSEL(back, c[0], specular[0]);
+      specular[1] = VSEL(back, c[1], specular[1]);
+      specular[2] = VSEL(back, c[2], specular[2]);
+
+      n_dot_VP = VSEL(back, VNEG(n_dot_VP), n_dot_VP);
+   }
+   else {
+      lit = front;
+   }
+
+   /* diffuse term */
+   contrib[0] = VADD(amb[0], VMUL(n_dot_VP, diff[0]));
+   contrib[1] = VADD(amb[1], VMUL(n_dot_VP, diff[1]));
+   contrib[2] = VADD(amb[2], VMUL(n_dot_VP, diff[2]));
+
+   if (flags & X86_64_LIGHT_SPEC) {
+      TAG(acc_scale3)(sum[0], front, attenuation, contrib);
+      if (flags & X86_64_LIGHT_TWOSIDE)
+	 TAG(acc_scale3)(sum[1], back, attenuation, contrib);
+   }
+
+   /* specular term - cannibalize VP... */
+   if (ctx->Light.Model.LocalViewer) {
+      VEC v[3];
+      v[0] = vertex[0];
+      v[1] = vertex[1];
+      v[2] = vertex[2];
+      TAG(normalize3)(v);
+      h[0] = VSUB(VP[0], v[0]);
+      h[1] = VSUB(VP[1], v[1]);
+      h[2] = VSUB(VP[2], v[2]);
+      TAG(normalize3)(h);
+   }
+   else if (light->_Flags & LIGHT_POSITIONAL) {
+      h[0] = VADD(VP[0], VSET1(ctx->_EyeZDir[0]));
+      h[1] = VADD(VP[1], VSET1(ctx->_EyeZDir[1]));
+      h[2] = VADD(VP[2], VSET1(ctx->_EyeZDir[2]));
+      TAG(normalize3)(h);
+   }
+   else {
+      TAG(splat3)(h, light->_h_inf_norm);
+   }
+
+   n_dot_h = TAG(dot3)(normal, h);
+   if (flags & X86_64_LIGHT_TWOSIDE)
+      n_dot_h = VSEL(back, VNEG(n_dot_h), n_dot_h);
+
+   mask = VAND(lit, VCMPGT(n_dot_h, zero));
+   if (VMOVEMASK(mask)) {
+      VEC spec_coef = TAG(shine)(ctx, n_dot_h, mask, back);
+
+      if (flags & X86_64_LIGHT_SPEC) {
+	 mask = VAND(mask, VCMPGT(spec_coef, VSET1(1.0e-10F)));
+	 spec_coef = VMUL(spec_coef, attenuation);
+	 TAG(acc_scale3)(spec[0], VANDNOT(back, mask), spec_coef, specular);
+	 if (flags & X86_64_LIGHT_TWOSIDE)
+	    TAG(acc_scale3)(spec[1], VAND(back, mask), spec_coef, specular);
+      }
+      else {
+	 TAG(acc_scale3)(contrib, mask, spec_coef, specular);
+      }
+   }
+
+   if (!(flags & X86_64_LIGHT_SPEC)) {
+      TAG(acc_scale3)(sum[0], front, attenuation, contrib);
+      if (flags & X86_64_LIGHT_TWOSIDE)
+	 TAG(acc_scale3)(sum[1], back, attenuation, contrib);
+   }
+}
+
+
+/**
+ * Copy count (at most SOA_LANES) 3-component vectors from the strided
+ * array src into v, one register per component.  The unused lanes are
+ * set to zero.
+ */
+static INLINE void SIMD_FUNC
+TAG(load_soa3)( VEC v[3], const GLfloat *src, GLuint stride, GLuint count )
+{
+   GLfloat tmp[3][SOA_LANES];
+   GLuint i;
+
+   for (i = 0; i < SOA_LANES; i++) {
+      if (i < count) {
+	 tmp[0][i] = src[0];
+	 tmp[1][i] = src[1];
+	 tmp[2][i] = src[2];
+	 STRIDE_F(src, stride);
+      }
+      else {
+	 tmp[0][i] = tmp[1][i] = tmp[2][i] = 0.0F;
+      }
+   }
+   v[0] = VLOADU(tmp[0]);
+   v[1] = VLOADU(tmp[1]);
+   v[2] = VLOADU(tmp[2]);
+}
+
+
+/**
+ * Copy the first count lanes of v to the RGB components of dst.
+ */
+static INLINE void SIMD_FUNC
+TAG(store_soa3)( GLfloat (*dst)[4], const VEC v[3], GLuint count )
+{
+   GLfloat tmp[3][SOA_LANES];
+   GLuint i;
+
+   VSTOREU(tmp[0], v[0]);
+   VSTOREU(tmp[1], v[1]);
+   VSTOREU(tmp[2], v[2]);
+   for (i = 0; i < count; i++) {
+      dst[i][0] = tmp[0][i];
+      dst[i][1] = tmp[1][i];
+      dst[i][2] = tmp[2][i];
+   }
+}
+
+
+void SIMD_FUNC
+TAG(light_rgba)( GLcontext *ctx,
+		 const GLfloat *vertex, GLuint vstride,
+		 const GLfloat *normal, GLuint nstride, GLuint count,
+		 GLfloat (*color[2])[4], GLfloat (*secondary[2])[4],
+		 GLuint flags )
+{
+   const GLuint sides = (flags & X86_64_LIGHT_TWOSIDE) ? 2 : 1;
+   GLfloat sumA[2];
+   GLuint j, k, side;
+
+   sumA[0] = ctx->Light.Material.Attrib[MAT_ATTRIB_FRONT_DIFFUSE][3];
+   sumA[1] = ctx->Light.Material.Attrib[MAT_ATTRIB_BACK_DIFFUSE][3];
+
+   for (j = 0; j < count; j += SOA_LANES) {
+      const GLuint n = MIN2(count - j, SOA_LANES);
+      VEC norm[3], vert[3], sum[2][3], spec[2][3];
+      struct gl_light *light;
+
+      TAG(load_soa3)(norm, normal, nstride, n);
+      normal = (const GLfloat *) ((const GLubyte *) normal + n * nstride);
+
+      for (side = 0; side < sides; side++) {
+	 TAG(splat3)(sum[side], ctx->Light._BaseColor[side]);
+	 for (k = 0; k < 3; k++)
+	    spec[side][k] = VSET1(0.0F);
+      }
+
+      if (flags & X86_64_LIGHT_INFINITE) {
+	 foreach (light, &ctx->Light.EnabledList)
+	    TAG(light_infinite)(ctx, light, norm, sum, sides == 2);
+      }
+      else {
+	 TAG(load_soa3)(vert, vertex, vstride, n);
+	 vertex = (const GLfloat *) ((const GLubyte *) vertex + n * vstride);
+
+	 foreach (light, &ctx->Light.EnabledList)
+	    TAG(light_general)(ctx, light, norm, vert, sum, spec, flags);
+      }
+
+      for (side = 0; side < sides; side++) {
+	 GLfloat (*out)[4] = color[side] + j;
+
+	 TAG(store_soa3)(out, sum[side], n);
+	 for (k = 0; k < n; k++)
+	    out[k][3] = sumA[side];
+
+	 if (flags & X86_64_LIGHT_SPEC)
+	    TAG(store_soa3)(secondary[side] + j, spec[side], n);
+      }
+   }
+}
+
+
+#undef VSEL
+#undef VNEG
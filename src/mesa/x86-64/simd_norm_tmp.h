@@ -0,0 +1,301 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * Normal transformation for sse2.c and avx2.c, matching the C code in
+ * math/m_norm_tmp.h.  Normals are always 3 components, the fourth
+ * component of the output is set to zero.
+ */
+
+
+/**
+ * Transform the normal u by the (inverse, transposed) matrix with the
+ * columns cx, cy, cz.  For matrices without rotation cx holds the
+ * diagonal of the matrix instead.
+ */
+static INLINE VEC SIMD_FUNC
+TAG(xform_normal)( VEC u, VEC cx, VEC cy, VEC cz, GLboolean no_rot )
+{
+   VEC r;
+   if (no_rot)
+      return VMUL(u, cx);
+   r = VMUL(VSPLAT(u, 0), cx);
+   r = VMADD(VSPLAT(u, 1), cy, r);
+   return VMADD(VSPLAT(u, 2), cz, r);
+}
+
+
+/**
+ * Return the squared length of the 3-component vector t in all lanes.
+ * The w component of t must be zero.
+ */
+static INLINE VEC SIMD_FUNC
+TAG(len_squared)( VEC t )
+{
+   const VEC sq = VMUL(t, t);
+   const VEC s = VADD(sq, VSHUF(sq, _MM_SHUFFLE(2, 3, 0, 1)));
+   return VADD(s, VSHUF(s, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+
+/**
+ * Return 1 / sqrt(a), from the approximate reciprocal square root refined
+ * with a Newton-Raphson step (about 22 bits precision).
+ */
+static INLINE VEC SIMD_FUNC
+TAG(rsqrt)( VEC a )
+{
+   const VEC r = VRSQRT(a);
+   const VEC t = VSUB(VSET1(3.0F), VMUL(VMUL(a, r), r));
+   return VMUL(VMUL(VSET1(0.5F), r), t);
+}
+
+
+/**
+ * Transform, and optionally normalize, the normals of in.
+ * If lengths is non-NULL it holds the precomputed inverse lengths of the
+ * normals.
+ */
+static void SIMD_FUNC
+TAG(normals_kernel)( const __m128 c[3],
+		     GLboolean no_rot,
+		     const GLvector4f *in,
+		     const GLfloat *lengths,
+		     GLboolean normalize,
+		     GLvector4f *dest )
+{
+   const GLuint stride = in->stride;
+   GLfloat *from = in->start;
+   GLfloat (*out)[4] = (GLfloat (*)[4]) dest->start;
+   const GLuint count = in->count;
+   const VEC cx = VDUP(c[0]), cy = VDUP(c[1]), cz = VDUP(c[2]);
+   GLuint i;
+
+   if (!normalize) {
+      for (i = 0; i < count; i += LANES) {
+	 const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+	 VSTORE(out[i], TAG(xform_normal)(u, cx, cy, cz, no_rot), count - i);
+	 STRIDE_F(from, LANES * stride);
+      }
+   }
+   else if (lengths) {
+      for (i = 0; i < count; i += LANES) {
+	 const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+	 const VEC len = VLOAD(_mm_load1_ps, lengths + i,
+			       VNEXT(i, count, sizeof(GLfloat)));
+	 const VEC t = TAG(xform_normal)(u, cx, cy, cz, no_rot);
+	 VSTORE(out[i], VMUL(t, len), count - i);
+	 STRIDE_F(from, LANES * stride);
+      }
+   }
+   else {
+      const VEC minLen = VSET1(1e-20F);
+      for (i = 0; i < count; i += LANES) {
+	 const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+	 const VEC t = TAG(xform_normal)(u, cx, cy, cz, no_rot);
+	 const VEC len = TAG(len_squared)(t);
+	 const VEC scale = TAG(rsqrt)(len);
+	 /* too short normals become zero */
+	 const VEC r = VAND(VCMPGT(len, minLen), VMUL(t, scale));
+	 VSTORE(out[i], r, count - i);
+	 STRIDE_F(from, LANES * stride);
+      }
+   }
+   dest->count = in->count;
+}
+
+
+/**
+ * Set up the columns of the inverse matrix for TAG(xform_normal)(),
+ * multiplied by scale.
+ */
+static INLINE void
+TAG(normal_columns)( __m128 c[3], const GLfloat *m, GLfloat scale,
+		     GLboolean no_rot )
+{
+   if (no_rot) {
+      c[0] = _mm_setr_ps(m[0] * scale, m[5] * scale, m[10] * scale, 0);
+      c[1] = c[2] = _mm_setzero_ps();
+   }
+   else {
+      c[0] = _mm_setr_ps(m[0] * scale, m[4] * scale, m[8] * scale, 0);
+      c[1] = _mm_setr_ps(m[1] * scale, m[5] * scale, m[9] * scale, 0);
+      c[2] = _mm_setr_ps(m[2] * scale, m[6] * scale, m[10] * scale, 0);
+   }
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(transform_normals)( const GLmatrix *mat,
+			GLfloat scale,
+			const GLvector4f *in,
+			const GLfloat *lengths,
+			GLvector4f *dest )
+{
+   __m128 c[3];
+   (void) scale;
+   (void) lengths;
+   TAG(normal_columns)(c, mat->inv, 1.0F, GL_FALSE);
+   TAG(normals_kernel)(c, GL_FALSE, in, NULL, GL_FALSE, dest);
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(transform_normals_no_rot)( const GLmatrix *mat,
+			       GLfloat scale,
+			       const GLvector4f *in,
+			       const GLfloat *lengths,
+			       GLvector4f *dest )
+{
+   __m128 c[3];
+   (void) scale;
+   (void) lengths;
+   TAG(normal_columns)(c, mat->inv, 1.0F, GL_TRUE);
+   TAG(normals_kernel)(c, GL_TRUE, in, NULL, GL_FALSE, dest);
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(transform_rescale_normals)( const GLmatrix *mat,
+				GLfloat scale,
+				const GLvector4f *in,
+				const GLfloat *lengths,
+				GLvector4f *dest )
+{
+   __m128 c[3];
+   (void) lengths;
+   TAG(normal_columns)(c, mat->inv, scale, GL_FALSE);
+   TAG(normals_kernel)(c, GL_FALSE, in, NULL, GL_FALSE, dest);
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(transform_rescale_normals_no_rot)( const GLmatrix *mat,
+				       GLfloat scale,
+				       const GLvector4f *in,
+				       const GLfloat *lengths,
+				       GLvector4f *dest )
+{
+   __m128 c[3];
+   (void) lengths;
+   TAG(normal_columns)(c, mat->inv, scale, GL_TRUE);
+   TAG(normals_kernel)(c, GL_TRUE, in, NULL, GL_FALSE, dest);
+}
+
+
+/* The scale factor only matters with precomputed lengths.
+ */
+void _ASMAPI SIMD_FUNC
+TAG(transform_normalize_normals)( const GLmatrix *mat,
+				  GLfloat scale,
+				  const GLvector4f *in,
+				  const GLfloat *lengths,
+				  GLvector4f *dest )
+{
+   __m128 c[3];
+   TAG(normal_columns)(c, mat->inv, lengths ? scale : 1.0F, GL_FALSE);
+   TAG(normals_kernel)(c, GL_FALSE, in, lengths, GL_TRUE, dest);
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(transform_normalize_normals_no_rot)( const GLmatrix *mat,
+					 GLfloat scale,
+					 const GLvector4f *in,
+					 const GLfloat *lengths,
+					 GLvector4f *dest )
+{
+   __m128 c[3];
+   TAG(normal_columns)(c, mat->inv, lengths ? scale : 1.0F, GL_TRUE);
+   TAG(normals_kernel)(c, GL_TRUE, in, lengths, GL_TRUE, dest);
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(rescale_normals)( const GLmatrix *mat,
+		      GLfloat scale,
+		      const GLvector4f *in,
+		      const GLfloat *lengths,
+		      GLvector4f *dest )
+{
+   const GLuint stride = in->stride;
+   GLfloat *from = in->start;
+   GLfloat (*out)[4] = (GLfloat (*)[4]) dest->start;
+   const GLuint count = in->count;
+   const VEC s = VSET1(scale);
+   GLuint i;
+
+   (void) mat;
+   (void) lengths;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+      VSTORE(out[i], VMUL(u, s), count - i);
+      STRIDE_F(from, LANES * stride);
+   }
+   dest->count = in->count;
+}
+
+
+void _ASMAPI SIMD_FUNC
+TAG(normalize_normals)( const GLmatrix *mat,
+			GLfloat scale,
+			const GLvector4f *in,
+			const GLfloat *lengths,
+			GLvector4f *dest )
+{
+   const GLuint stride = in->stride;
+   GLfloat *from = in->start;
+   GLfloat (*out)[4] = (GLfloat (*)[4]) dest->start;
+   const GLuint count = in->count;
+   GLuint i;
+
+   (void) mat;
+   (void) scale;
+
+   if (lengths) {
+      for (i = 0; i < count; i += LANES) {
+	 const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+	 const VEC len = VLOAD(_mm_load1_ps, lengths + i,
+			       VNEXT(i, count, sizeof(GLfloat)));
+	 VSTORE(out[i], VMUL(u, len), count - i);
+	 STRIDE_F(from, LANES * stride);
+      }
+   }
+   else {
+      const VEC zero = VSET1(0.0F);
+      for (i = 0; i < count; i += LANES) {
+	 const VEC u = VLOAD(load_3f, from, VNEXT(i, count, stride));
+	 const VEC len = TAG(len_squared)(u);
+	 const VEC n = VMUL(u, TAG(rsqrt)(len));
+	 /* zero length normals are left alone */
+	 const VEC mask = VCMPGT(len, zero);
+	 VSTORE(out[i], VOR(VAND(mask, n), VANDNOT(mask, u)), count - i);
+	 STRIDE_F(from, LANES * stride);
+      }
+   }
+   dest->count = in->count;
+}
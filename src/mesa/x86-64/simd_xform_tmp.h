@@ -0,0 +1,243 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * Vertex transformation for sse2.c and avx2.c.  This file is included
+ * once for each input vector size, with SZ defined as 1, 2, 3 or 4.
+ *
+ * Most functions multiply the vertices by a full 4x4 matrix, with the
+ * missing input components taken as (x, 0, 0, 1).  The matrix columns are
+ * set up with the same zeros and ones for each matrix type that the C code
+ * in math/m_xform_tmp.h assumes, so the results are the same.  The
+ * sparse 2D, perspective and no rotation matrices are done with fewer
+ * operations by TAG(kernel_diag)().  All four
+ * components of the output are stored, to_vec->size is set like the C
+ * code does.
+ */
+
+
+#if SZ == 1
+#define NAME(x) TAG(transform_points1_##x)
+#define LOAD_VERTEX load_1f
+#elif SZ == 2
+#define NAME(x) TAG(transform_points2_##x)
+#define LOAD_VERTEX load_2f
+#elif SZ == 3
+#define NAME(x) TAG(transform_points3_##x)
+#define LOAD_VERTEX load_3f
+#elif SZ == 4
+#define NAME(x) TAG(transform_points4_##x)
+#define LOAD_VERTEX load_4f
+#else
+#error "SZ must be 1, 2, 3 or 4"
+#endif
+
+#define SIZE_2D (SZ > 2 ? SZ : 2)
+#define SIZE_3D (SZ > 3 ? SZ : 3)
+
+
+/**
+ * Transform all vertices of from_vec by the matrix with the columns c[].
+ */
+static void SIMD_FUNC
+NAME(kernel)( GLvector4f *to_vec, const GLvector4f *from_vec,
+	      const __m128 c[4] )
+{
+   const GLuint stride = from_vec->stride;
+   GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;
+   const GLuint count = from_vec->count;
+   const VEC c0 = VDUP(c[0]), c1 = VDUP(c[1]);
+   const VEC c2 = VDUP(c[2]), c3 = VDUP(c[3]);
+   GLuint i;
+
+   (void) c1;
+   (void) c2;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(LOAD_VERTEX, from, VNEXT(i, count, stride));
+      VEC r = VMUL(VSPLAT(v, 0), c0);
+#if SZ >= 2
+      r = VMADD(VSPLAT(v, 1), c1, r);
+#endif
+#if SZ >= 3
+      r = VMADD(VSPLAT(v, 2), c2, r);
+#endif
+#if SZ == 4
+      r = VMADD(VSPLAT(v, 3), c3, r);
+#else
+      r = VADD(r, c3);
+#endif
+      VSTORE(to[i], r, count - i);
+      STRIDE_F(from, LANES * stride);
+   }
+}
+
+
+/**
+ * Transform all vertices of from_vec by v * d + e * c + w * t, where e is
+ * nothing (DIAG_ONLY), the vertex with x and y swapped (DIAG_SWAP_XY) or
+ * z in all components (DIAG_Z).  The w component of the vertices is taken
+ * as one for SZ < 4.
+ */
+static void SIMD_FUNC
+NAME(kernel_diag)( GLvector4f *to_vec, const GLvector4f *from_vec,
+		   __m128 d, __m128 c, __m128 t, GLuint extra )
+{
+   const GLuint stride = from_vec->stride;
+   GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;
+   const GLuint count = from_vec->count;
+   const VEC vd = VDUP(d), vc = VDUP(c), vt = VDUP(t);
+   GLuint i;
+
+   for (i = 0; i < count; i += LANES) {
+      const VEC v = VLOAD(LOAD_VERTEX, from, VNEXT(i, count, stride));
+      VEC r = VMUL(v, vd);
+      if (extra == DIAG_SWAP_XY)
+	 r = VMADD(VSHUF(v, _MM_SHUFFLE(3, 2, 0, 1)), vc, r);
+#if SZ >= 3
+      else if (extra == DIAG_Z)
+	 r = VMADD(VSPLAT(v, 2), vc, r);
+#endif
+#if SZ == 4
+      r = VMADD(VSPLAT(v, 3), vt, r);
+#else
+      r = VADD(r, vt);
+#endif
+      VSTORE(to[i], r, count - i);
+      STRIDE_F(from, LANES * stride);
+   }
+}
+
+
+#define XFORM_FUNC(type, mtype, size)					\
+void _ASMAPI SIMD_FUNC						\
+NAME(type)( GLvector4f *to_vec,						\
+	    const GLfloat m[16],					\
+	    const GLvector4f *from_vec )				\
+{									\
+   __m128 c[4];								\
+   get_matrix_columns(c, m, mtype);					\
+   NAME(kernel)(to_vec, from_vec, c);					\
+   set_vector_size(to_vec, from_vec->count, size);			\
+}
+
+XFORM_FUNC(general, MATRIX_GENERAL, 4)
+XFORM_FUNC(3d, MATRIX_3D, SIZE_3D)
+
+
+void _ASMAPI SIMD_FUNC
+NAME(2d)( GLvector4f *to_vec,
+	  const GLfloat m[16],
+	  const GLvector4f *from_vec )
+{
+   const __m128 d = _mm_setr_ps(m[0], m[5], 1, 1);
+   const __m128 c = _mm_setr_ps(m[4], m[1], 0, 0);
+   const __m128 t = _mm_setr_ps(m[12], m[13], 0, SZ < 4);
+   NAME(kernel_diag)(to_vec, from_vec, d, c, t, DIAG_SWAP_XY);
+   set_vector_size(to_vec, from_vec->count, SIZE_2D);
+}
+
+
+void _ASMAPI SIMD_FUNC
+NAME(perspective)( GLvector4f *to_vec,
+		   const GLfloat m[16],
+		   const GLvector4f *from_vec )
+{
+   const __m128 d = _mm_setr_ps(m[0], m[5], m[10], 0);
+   const __m128 cz = _mm_setr_ps(m[8], m[9], 0, -1);
+   const __m128 t = _mm_setr_ps(0, 0, m[14], 0);
+   NAME(kernel_diag)(to_vec, from_vec, d, cz, t, DIAG_Z);
+   set_vector_size(to_vec, from_vec->count, 4);
+}
+
+
+void _ASMAPI SIMD_FUNC
+NAME(2d_no_rot)( GLvector4f *to_vec,
+		 const GLfloat m[16],
+		 const GLvector4f *from_vec )
+{
+   const __m128 d = _mm_setr_ps(m[0], m[5], 1, 1);
+   const __m128 t = _mm_setr_ps(m[12], m[13], 0, SZ < 4);
+   NAME(kernel_diag)(to_vec, from_vec, d, d, t, DIAG_ONLY);
+   set_vector_size(to_vec, from_vec->count, SIZE_2D);
+}
+
+
+void _ASMAPI SIMD_FUNC
+NAME(3d_no_rot)( GLvector4f *to_vec,
+		 const GLfloat m[16],
+		 const GLvector4f *from_vec )
+{
+   const __m128 d = _mm_setr_ps(m[0], m[5], m[10], 1);
+   const __m128 t = _mm_setr_ps(m[12], m[13], m[14], SZ < 4);
+   NAME(kernel_diag)(to_vec, from_vec, d, d, t, DIAG_ONLY);
+#if SZ == 2
+   /* the z component is m14, and only part of the result if non-zero */
+   set_vector_size(to_vec, from_vec->count, m[14] == 0 ? 2 : 3);
+#else
+   set_vector_size(to_vec, from_vec->count, SIZE_3D);
+#endif
+}
+
+
+void _ASMAPI SIMD_FUNC
+NAME(identity)( GLvector4f *to_vec,
+		const GLfloat m[16],
+		const GLvector4f *from_vec )
+{
+   const GLuint stride = from_vec->stride;
+   GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;
+   const GLuint count = from_vec->count;
+#if SZ < 4
+   const __m128 w = _mm_setr_ps(0, 0, 0, 1);
+#endif
+   GLuint i;
+
+   (void) m;
+   if (to_vec == from_vec)
+      return;
+
+   for (i = 0; i < count; i++) {
+#if SZ < 4
+      _mm_storeu_ps(to[i], _mm_or_ps(LOAD_VERTEX(from), w));
+#else
+      _mm_storeu_ps(to[i], LOAD_VERTEX(from));
+#endif
+      STRIDE_F(from, stride);
+   }
+   set_vector_size(to_vec, count, SZ);
+}
+
+
+#undef XFORM_FUNC
+#undef SIZE_2D
+#undef SIZE_3D
+#undef LOAD_VERTEX
+#undef NAME
+#undef SZ
@@ -0,0 +1,528 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.3
+ *
+ * Copyright (C) 2009  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/*
+ * SSE2 versions of the vertex transformation, normal transformation and
+ * clip test functions, and of the RGBA lighting functions.  SSE2 is
+ * always available on x86-64, these are plugged in by
+ * _mesa_init_all_x86_64_transform_asm().
+ *
+ * Also vertex array conversions used directly by tnl/t_draw.c, and
+ * helpers for the mipmap generation, texture compression and pixel
+ * conversion code.
+ */
+
+#include "main/glheader.h"
+#include "main/light.h"
+#include "main/macros.h"
+#include "main/simple_list.h"
+#include "math/m_xform.h"
+
+#include "x86-64.h"
+#include "../x86/common_x86_macros.h"
+
+
+#ifdef USE_X86_64_ASM
+
+#include "simd.h"
+
+#define TAG(x) _mesa_sse2_##x
+#define SIMD_FUNC
+#define LANES 1
+#define VEC __m128
+
+#define VDUP(c)			(c)
+#define VLOAD(load, p, next)	load(p)
+#define VNEXT(i, count, stride)	0
+#define VSTORE(p, v, left)	_mm_storeu_ps(p, v)
+#define VSET1(f)		_mm_set1_ps(f)
+#define VSPLAT(v, k)		_mm_shuffle_ps(v, v, (k) * 0x55)
+#define VSHUF(v, imm)		_mm_shuffle_ps(v, v, imm)
+#define VADD(a, b)		_mm_add_ps(a, b)
+#define VSUB(a, b)		_mm_sub_ps(a, b)
+#define VMUL(a, b)		_mm_mul_ps(a, b)
+#define VDIV(a, b)		_mm_div_ps(a, b)
+#define VRSQRT(a)		_mm_rsqrt_ps(a)
+#define VMADD(a, b, c)		_mm_add_ps(_mm_mul_ps(a, b), c)
+#define VAND(a, b)		_mm_and_ps(a, b)
+#define VANDNOT(a, b)		_mm_andnot_ps(a, b)
+#define VOR(a, b)		_mm_or_ps(a, b)
+#define VCMPGT(a, b)		_mm_cmpgt_ps(a, b)
+#define VCMPLT(a, b)		_mm_cmplt_ps(a, b)
+#define VMOVEMASK(a)		((GLuint) _mm_movemask_ps(a))
+#define VSQRT(a)		_mm_sqrt_ps(a)
+#define VLOADU(p)		_mm_loadu_ps(p)
+#define VSTOREU(p, v)		_mm_storeu_ps(p, v)
+#define VTRUE			_mm_castsi128_ps(_mm_set1_epi32(-1))
+
+/* vertices per register in the lighting code */
+#define SOA_LANES 4
+
+DECLARE_XFORM_GROUP( sse2, 1 )
+DECLARE_XFORM_GROUP( sse2, 2 )
+DECLARE_XFORM_GROUP( sse2, 3 )
+DECLARE_XFORM_GROUP( sse2, 4 )
+DECLARE_NORM_GROUP( sse2 )
+DECLARE_CLIP_GROUP( sse2 )
+DECLARE_CLIP_GB_GROUP( sse2 )
+
+#define SZ 1
+#include "simd_xform_tmp.h"
+#define SZ 2
+#include "simd_xform_tmp.h"
+#define SZ 3
+#include "simd_xform_tmp.h"
+#define SZ 4
+#include "simd_xform_tmp.h"
+
+#include "simd_norm_tmp.h"
+#include "simd_clip_tmp.h"
+#include "simd_light_tmp.h"
+
+
+/*
+ * Vertex array conversion to floats.  Each element is converted with a
+ * four component load and store, which may touch the following element
+ * but never goes past the end of the arrays; the last element is
+ * converted one component at a time.
+ */
+
+void
+_mesa_sse2_convert_ubyte_norm( GLfloat *dst, const GLubyte *src,
+                               GLuint stride, GLuint size, GLuint count )
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(255.0F);
+   GLuint i;
+
+   ASSERT(size >= 3);
+
+   for (i = 0; i < count - 1; i++, src += stride, dst += size) {
+      GLint bytes;
+      __m128i v;
+
+      memcpy(&bytes, src, 4);
+      v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+      v = _mm_unpacklo_epi16(v, zero);
+      /* divide rather than multiply, to get the same values as
+       * UBYTE_TO_FLOAT()
+       */
+      _mm_storeu_ps(dst, _mm_div_ps(_mm_cvtepi32_ps(v), scale));
+   }
+
+   for (i = 0; i < size; i++)
+      dst[i] = UBYTE_TO_FLOAT(src[i]);
+}
+
+
+void
+_mesa_sse2_convert_short( GLfloat *dst, const GLubyte *src,
+                          GLuint stride, GLuint size, GLuint count,
+                          GLboolean normalized )
+{
+   const __m128 two = _mm_set1_ps(normalized ? 2.0F : 1.0F);
+   const __m128 one = _mm_set1_ps(normalized ? 1.0F : 0.0F);
+   const __m128 scale = _mm_set1_ps(normalized ? 1.0F / 65535.0F : 1.0F);
+   const GLshort *s;
+   GLuint i;
+
+   ASSERT(size >= 2);
+
+   for (i = 0; i < count - 1; i++, src += stride, dst += size) {
+      __m128i v;
+      __m128 f;
+
+      if (size == 2) {
+         GLint shorts;
+         memcpy(&shorts, src, 4);
+         v = _mm_cvtsi32_si128(shorts);
+      }
+      else {
+         v = _mm_loadl_epi64((const __m128i *) src);
+      }
+
+      v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      f = _mm_cvtepi32_ps(v);
+      /* (2 * s + 1) / 65535 like SHORT_TO_FLOAT(), exact for both */
+      f = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(f, two), one), scale);
+      _mm_storeu_ps(dst, f);
+   }
+
+   s = (const GLshort *) src;
+   for (i = 0; i < size; i++)
+      dst[i] = normalized ? SHORT_TO_FLOAT(s[i]) : (GLfloat) s[i];
+}
+
+
+/*
+ * 2x2 box filter for mipmap generation.  These average pixels 2i and
+ * 2i+1 of two source rows into destination pixel i, with the same
+ * rounding as do_row() in main/mipmap.c.  They return the number of
+ * destination pixels written; the caller does the rest.
+ */
+
+GLuint
+_mesa_sse2_reduce_ubyte_row( GLuint comps, const GLubyte *rowA,
+                             const GLubyte *rowB, GLuint dstWidth,
+                             GLubyte *dst )
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i ones = _mm_set1_epi16(1);
+   GLuint i = 0;
+
+   switch (comps) {
+   case 1:
+      for (; i + 8 <= dstWidth; i += 8, rowA += 16, rowB += 16, dst += 8) {
+         const __m128i a = _mm_loadu_si128((const __m128i *) rowA);
+         const __m128i b = _mm_loadu_si128((const __m128i *) rowB);
+         __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                    _mm_unpacklo_epi8(b, zero));
+         __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                    _mm_unpackhi_epi8(b, zero));
+         /* add neighbouring texels */
+         lo = _mm_madd_epi16(lo, ones);
+         hi = _mm_madd_epi16(hi, ones);
+         lo = _mm_srli_epi16(_mm_packs_epi32(lo, hi), 2);
+         _mm_storel_epi64((__m128i *) dst, _mm_packus_epi16(lo, lo));
+      }
+      break;
+   case 2:
+      for (; i + 4 <= dstWidth; i += 4, rowA += 16, rowB += 16, dst += 8) {
+         const __m128i a = _mm_loadu_si128((const __m128i *) rowA);
+         const __m128i b = _mm_loadu_si128((const __m128i *) rowB);
+         __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                    _mm_unpacklo_epi8(b, zero));
+         __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                    _mm_unpackhi_epi8(b, zero));
+         /* add neighbouring texels into the even dwords, then gather */
+         lo = _mm_add_epi16(lo, _mm_srli_epi64(lo, 32));
+         hi = _mm_add_epi16(hi, _mm_srli_epi64(hi, 32));
+         lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+         hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+         lo = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+         _mm_storel_epi64((__m128i *) dst, _mm_packus_epi16(lo, lo));
+      }
+      break;
+   case 3:
+   case 4:
+      /* RGB texels are expanded to RGBX with 32-bit loads, which read
+       * the first byte of the next texel; stop before the last one.
+       */
+      for (; i + 2 + (comps == 3) <= dstWidth;
+           i += 2, rowA += 4 * comps, rowB += 4 * comps, dst += 2 * comps) {
+         __m128i a, b, lo, hi;
+         if (comps == 4) {
+            a = _mm_loadu_si128((const __m128i *) rowA);
+            b = _mm_loadu_si128((const __m128i *) rowB);
+         }
+         else {
+            GLint ta[4], tb[4];
+            GLuint k;
+            for (k = 0; k < 4; k++) {
+               memcpy(&ta[k], rowA + 3 * k, 4);
+               memcpy(&tb[k], rowB + 3 * k, 4);
+            }
+            a = _mm_setr_epi32(ta[0], ta[1], ta[2], ta[3]);
+            b = _mm_setr_epi32(tb[0], tb[1], tb[2], tb[3]);
+         }
+         lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                            _mm_unpacklo_epi8(b, zero));
+         hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                            _mm_unpackhi_epi8(b, zero));
+         lo = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                            _mm_unpackhi_epi64(lo, hi));
+         lo = _mm_srli_epi16(lo, 2);
+         lo = _mm_packus_epi16(lo, lo);
+         if (comps == 4) {
+            _mm_storel_epi64((__m128i *) dst, lo);
+         }
+         else {
+            GLint t[2];
+            _mm_storel_epi64((__m128i *) t, lo);
+            memcpy(dst, &t[0], 3);
+            memcpy(dst + 3, &t[1], 3);
+         }
+      }
+      break;
+   }
+
+   return i;
+}
+
+
+GLuint
+_mesa_sse2_reduce_float_row( GLuint comps, const GLfloat *rowA,
+                             const GLfloat *rowB, GLuint dstWidth,
+                             GLfloat *dst )
+{
+   const __m128 quarter = _mm_set1_ps(0.25F);
+   GLuint i = 0;
+
+   switch (comps) {
+   case 1:
+   case 2:
+      /* four or two texels per iteration, added in do_row()'s order */
+      for (; i + 4 / comps <= dstWidth;
+           i += 4 / comps, rowA += 8, rowB += 8, dst += 4) {
+         const __m128 a0 = _mm_loadu_ps(rowA), a1 = _mm_loadu_ps(rowA + 4);
+         const __m128 b0 = _mm_loadu_ps(rowB), b1 = _mm_loadu_ps(rowB + 4);
+         __m128 aj, ak, bj, bk;
+         if (comps == 1) {
+            aj = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+            ak = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+            bj = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0));
+            bk = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1));
+         }
+         else {
+            aj = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 0, 1, 0));
+            ak = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 2, 3, 2));
+            bj = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(1, 0, 1, 0));
+            bk = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 2, 3, 2));
+         }
+         _mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(aj, ak),
+                                                             bj), bk),
+                                       quarter));
+      }
+      break;
+   case 4:
+      for (; i < dstWidth; i++, rowA += 8, rowB += 8, dst += 4) {
+         const __m128 aj = _mm_loadu_ps(rowA), ak = _mm_loadu_ps(rowA + 4);
+         const __m128 bj = _mm_loadu_ps(rowB), bk = _mm_loadu_ps(rowB + 4);
+         _mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(aj, ak),
+                                                             bj), bk),
+                                       quarter));
+      }
+      break;
+   }
+
+   return i;
+}
+
+
+/*
+ * Nearest palette color search for the texture compressors: for each of
+ * n texels (a multiple of four) the palette entry with the least squared
+ * RGBA distance, four texels at a time.  Ties go to the lower index.
+ * Returns the sum of the distances.
+ */
+
+GLuint
+_mesa_sse2_nearest_colors( const GLubyte *texels, GLuint n,
+                           const GLubyte *palette, GLuint np,
+                           GLubyte *index )
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i pal[16];
+   GLuint total = 0, i, p;
+
+   ASSERT(np <= 16);
+
+   for (p = 0; p < np; p++) {
+      GLint c;
+      memcpy(&c, palette + 4 * p, 4);
+      pal[p] = _mm_unpacklo_epi8(_mm_set1_epi32(c), zero);
+   }
+
+   for (i = 0; i < n; i += 4, texels += 16) {
+      const __m128i t = _mm_loadu_si128((const __m128i *) texels);
+      const __m128i tlo = _mm_unpacklo_epi8(t, zero);
+      const __m128i thi = _mm_unpackhi_epi8(t, zero);
+      __m128i best = _mm_set1_epi32(0x7fffffff);
+      __m128i bestIndex = zero;
+      GLint e[4], k[4];
+
+      for (p = 0; p < np; p++) {
+         __m128i dlo = _mm_sub_epi16(tlo, pal[p]);
+         __m128i dhi = _mm_sub_epi16(thi, pal[p]);
+         __m128 rg, ba;
+         __m128i d, less;
+         /* squares of RG and BA of each texel, then add them */
+         dlo = _mm_madd_epi16(dlo, dlo);
+         dhi = _mm_madd_epi16(dhi, dhi);
+         rg = _mm_shuffle_ps(_mm_castsi128_ps(dlo), _mm_castsi128_ps(dhi),
+                             _MM_SHUFFLE(2, 0, 2, 0));
+         ba = _mm_shuffle_ps(_mm_castsi128_ps(dlo), _mm_castsi128_ps(dhi),
+                             _MM_SHUFFLE(3, 1, 3, 1));
+         d = _mm_add_epi32(_mm_castps_si128(rg), _mm_castps_si128(ba));
+         less = _mm_cmplt_epi32(d, best);
+         best = _mm_or_si128(_mm_and_si128(less, d),
+                             _mm_andnot_si128(less, best));
+         bestIndex = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(p)),
+                                  _mm_andnot_si128(less, bestIndex));
+      }
+
+      _mm_storeu_si128((__m128i *) e, best);
+      _mm_storeu_si128((__m128i *) k, bestIndex);
+      index[i + 0] = k[0];
+      index[i + 1] = k[1];
+      index[i + 2] = k[2];
+      index[i + 3] = k[3];
+      total += e[0] + e[1] + e[2] + e[3];
+   }
+
+   return total;
+}
+
+
+/*
+ * Direct conversions between GLubyte RGBA and client pixel layouts for
+ * main/image.c, with the same rounding as its C code.  Channel c of the
+ * GLushort layouts is at bit shift[c] and has bits[c] bits, or isn't
+ * stored if that's zero.  They return the number of pixels converted;
+ * the caller does the rest.
+ */
+
+/* multiplier, bias and shift expanding N bits to 8 */
+static const GLushort expand_ubyte[9][3] = {
+   { 0, 0, 0 },
+   { 255, 0, 0 },
+   { 85, 0, 0 },
+   { 73, 0, 1 },
+   { 17, 0, 0 },
+   { 527, 23, 6 },
+   { 259, 33, 6 },
+   { 129, 0, 6 },
+   { 1, 0, 0 }
+};
+
+GLuint
+_mesa_sse2_unpack_ushort_rgba( GLuint n, const GLushort *src,
+                               GLboolean swap, const GLuint shift[4],
+                               const GLuint bits[4], GLubyte *dst )
+{
+   __m128i count[4], mask[4], mul[4], bias[4], scale[4];
+   GLuint i, c;
+
+   for (c = 0; c < 4; c++) {
+      ASSERT(bits[c] <= 8);
+      count[c] = _mm_cvtsi32_si128(shift[c]);
+      mask[c] = _mm_set1_epi16((1 << bits[c]) - 1);
+      mul[c] = _mm_set1_epi16(expand_ubyte[bits[c]][0]);
+      bias[c] = _mm_set1_epi16(expand_ubyte[bits[c]][1]);
+      scale[c] = _mm_cvtsi32_si128(expand_ubyte[bits[c]][2]);
+   }
+
+   for (i = 0; i + 8 <= n; i += 8, src += 8, dst += 32) {
+      __m128i p = _mm_loadu_si128((const __m128i *) src);
+      __m128i v[4], rg, ba;
+      if (swap)
+         p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+      for (c = 0; c < 4; c++) {
+         if (bits[c]) {
+            v[c] = _mm_and_si128(_mm_srl_epi16(p, count[c]), mask[c]);
+            v[c] = _mm_add_epi16(_mm_mullo_epi16(v[c], mul[c]), bias[c]);
+            v[c] = _mm_srl_epi16(v[c], scale[c]);
+         }
+         else {
+            v[c] = _mm_set1_epi16(255);
+         }
+      }
+      rg = _mm_or_si128(v[0], _mm_slli_epi16(v[1], 8));
+      ba = _mm_or_si128(v[2], _mm_slli_epi16(v[3], 8));
+      _mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi16(rg, ba));
+   }
+
+   return i;
+}
+
+
+GLuint
+_mesa_sse2_pack_ushort_rgba( GLuint n, const GLubyte *src,
+                             const GLuint shift[4], const GLuint bits[4],
+                             GLboolean swap, GLushort *dst )
+{
+   const __m128i byteMask = _mm_set1_epi32(0xff);
+   const __m128i one = _mm_set1_epi16(1);
+   const __m128i div255 = _mm_set1_epi16(257);
+   __m128i count[4], max[4];
+   GLuint i, c;
+
+   for (c = 0; c < 4; c++) {
+      count[c] = _mm_cvtsi32_si128(shift[c]);
+      max[c] = _mm_set1_epi16((1 << bits[c]) - 1);
+   }
+
+   for (i = 0; i + 8 <= n; i += 8, src += 32, dst += 8) {
+      const __m128i a = _mm_loadu_si128((const __m128i *) src);
+      const __m128i b = _mm_loadu_si128((const __m128i *) (src + 16));
+      __m128i p = _mm_setzero_si128();
+      for (c = 0; c < 4; c++) {
+         if (bits[c]) {
+            /* channel c of the 8 pixels, times the field's maximum,
+             * divided by 255: x / 255 == ((x + 1) * 257) >> 16
+             */
+            const __m128i count8 = _mm_cvtsi32_si128(8 * c);
+            __m128i v = _mm_packs_epi32(
+               _mm_and_si128(_mm_srl_epi32(a, count8), byteMask),
+               _mm_and_si128(_mm_srl_epi32(b, count8), byteMask));
+            v = _mm_add_epi16(_mm_mullo_epi16(v, max[c]), one);
+            v = _mm_mulhi_epu16(v, div255);
+            p = _mm_or_si128(p, _mm_sll_epi16(v, count[c]));
+         }
+      }
+      if (swap)
+         p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+      _mm_storeu_si128((__m128i *) dst, p);
+   }
+
+   return i;
+}
+
+
+/*
+ * Byte swizzle of 4-byte pixels: byte k of each destination pixel is
+ * byte map[k] of the source pixel.
+ */
+
+GLuint
+_mesa_sse2_swizzle_ubyte4( GLuint n, const GLubyte *src,
+                           const GLuint map[4], GLubyte *dst )
+{
+   const __m128i byteMask = _mm_set1_epi32(0xff);
+   const __m128i c0 = _mm_cvtsi32_si128(8 * map[0]);
+   const __m128i c1 = _mm_cvtsi32_si128(8 * map[1]);
+   const __m128i c2 = _mm_cvtsi32_si128(8 * map[2]);
+   const __m128i c3 = _mm_cvtsi32_si128(8 * map[3]);
+   GLuint i;
+
+   for (i = 0; i + 4 <= n; i += 4, src += 16, dst += 16) {
+      const __m128i p = _mm_loadu_si128((const __m128i *) src);
+      __m128i d;
+      d = _mm_and_si128(_mm_srl_epi32(p, c0), byteMask);
+      d = _mm_or_si128(d, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p, c1),
+                                                       byteMask), 8));
+      d = _mm_or_si128(d, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p, c2),
+                                                       byteMask), 16));
+      d = _mm_or_si128(d, _mm_slli_epi32(_mm_srl_epi32(p, c3), 24));
+      _mm_storeu_si128((__m128i *) dst, d);
+   }
+
+   return i;
+}
+
+
+#endif /* USE_X86_64_ASM */
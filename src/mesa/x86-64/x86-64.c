@@ -37,15 +37,34 @@
 #include "x86-64.h"
 #include "../x86/common_x86_macros.h"
 
-#ifdef DEBUG
+#ifdef DEBUG_MATH
 #include "math/m_debug.h"
 #endif
 
 extern void _mesa_x86_64_cpuid(unsigned int *regs);
+extern unsigned int _mesa_x86_64_xgetbv(unsigned int index);
 
 DECLARE_XFORM_GROUP( x86_64, 4 )
 DECLARE_XFORM_GROUP( 3dnow, 4 )
 
+DECLARE_XFORM_GROUP( sse2, 1 )
+DECLARE_XFORM_GROUP( sse2, 2 )
+DECLARE_XFORM_GROUP( sse2, 3 )
+DECLARE_XFORM_GROUP( sse2, 4 )
+DECLARE_NORM_GROUP( sse2 )
+DECLARE_CLIP_GROUP( sse2 )
+DECLARE_CLIP_GB_GROUP( sse2 )
+
+#ifdef USE_X86_64_AVX2
+DECLARE_XFORM_GROUP( avx2, 1 )
+DECLARE_XFORM_GROUP( avx2, 2 )
+DECLARE_XFORM_GROUP( avx2, 3 )
+DECLARE_XFORM_GROUP( avx2, 4 )
+DECLARE_NORM_GROUP( avx2 )
+DECLARE_CLIP_GROUP( avx2 )
+DECLARE_CLIP_GB_GROUP( avx2 )
+#endif
+
 #else
 /* just to silence warning below */
 #include "x86-64.h"
@@ -78,6 +97,41 @@ static void message( const char *msg )
       _mesa_debug( NULL, "%s", msg );
    }
 }
+
+x86_64_light_func _mesa_x86_64_light_rgba = NULL;
+
+#ifdef USE_X86_64_AVX2
+/**
+ * Check for AVX2 and FMA, and that the OS saves the AVX registers.
+ */
+static GLboolean cpu_has_avx2( void )
+{
+   const unsigned int avx_fma = (1 << 12) | (1 << 27) | (1 << 28);
+   unsigned int regs[4];
+
+   regs[0] = 0x00000000;
+   regs[2] = 0x00000000;
+   _mesa_x86_64_cpuid(regs);
+   if (regs[0] < 7)
+      return GL_FALSE;
+
+   /* FMA, OSXSAVE and AVX */
+   regs[0] = 0x00000001;
+   regs[2] = 0x00000000;
+   _mesa_x86_64_cpuid(regs);
+   if ((regs[2] & avx_fma) != avx_fma)
+      return GL_FALSE;
+
+   /* XMM and YMM state enabled by the OS */
+   if ((_mesa_x86_64_xgetbv(0) & 0x6) != 0x6)
+      return GL_FALSE;
+
+   regs[0] = 0x00000007;
+   regs[2] = 0x00000000;
+   _mesa_x86_64_cpuid(regs);
+   return (regs[1] & (1 << 5)) ? GL_TRUE : GL_FALSE;
+}
+#endif
 #endif
 
 
@@ -92,6 +146,22 @@ void _mesa_init_all_x86_64_transform_asm(void)
 
    message("Initializing x86-64 optimizations\n");
 
+   if ( !_mesa_getenv( "MESA_NO_SSE" ) ) {
+      ASSIGN_XFORM_GROUP( sse2, 1 );
+      ASSIGN_XFORM_GROUP( sse2, 2 );
+      ASSIGN_XFORM_GROUP( sse2, 3 );
+      ASSIGN_XFORM_GROUP( sse2, 4 );
+      ASSIGN_NORM_GROUP( sse2 );
+      ASSIGN_CLIP_GROUP( sse2 );
+      ASSIGN_CLIP_GB_GROUP( sse2 );
+      _mesa_x86_64_light_rgba = _mesa_sse2_light_rgba;
+
+#ifdef DEBUG_MATH
+      _math_test_all_transform_functions("SSE2");
+      _math_test_all_cliptest_functions("SSE2");
+      _math_test_all_normal_transform_functions("SSE2");
+#endif
+   }
 
    _mesa_transform_tab[4][MATRIX_GENERAL] =
       _mesa_x86_64_transform_points4_general;
@@ -118,12 +188,33 @@ void _mesa_init_all_x86_64_transform_asm(void)
 
    }
 
-   
 #ifdef DEBUG_MATH
    _math_test_all_transform_functions("x86_64");
    _math_test_all_cliptest_functions("x86_64");
    _math_test_all_normal_transform_functions("x86_64");
 #endif
 
+#ifdef USE_X86_64_AVX2
+   /* AVX2 replaces the SSE2 code, so MESA_NO_SSE disables it, too */
+   if ( cpu_has_avx2() && !_mesa_getenv( "MESA_NO_SSE" ) &&
+        !_mesa_getenv( "MESA_NO_AVX2" ) ) {
+      message("AVX2 detected\n");
+      ASSIGN_XFORM_GROUP( avx2, 1 );
+      ASSIGN_XFORM_GROUP( avx2, 2 );
+      ASSIGN_XFORM_GROUP( avx2, 3 );
+      ASSIGN_XFORM_GROUP( avx2, 4 );
+      ASSIGN_NORM_GROUP( avx2 );
+      ASSIGN_CLIP_GROUP( avx2 );
+      ASSIGN_CLIP_GB_GROUP( avx2 );
+      _mesa_x86_64_light_rgba = _mesa_avx2_light_rgba;
+
+#ifdef DEBUG_MATH
+      _math_test_all_transform_functions("AVX2");
+      _math_test_all_cliptest_functions("AVX2");
+      _math_test_all_normal_transform_functions("AVX2");
+#endif
+   }
+#endif
+
 #endif
 }
@@ -26,6 +26,87 @@
 #ifndef __X86_64_ASM_H__
 #define __X86_64_ASM_H__
 
+#include "main/glheader.h"
+#include "main/mtypes.h"
+
+/* The AVX2 functions need the target function attribute (gcc 4.9).
+ */
+#if defined(USE_X86_64_ASM) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define USE_X86_64_AVX2
+#endif
+
 extern void _mesa_init_all_x86_64_transform_asm( void );
 
+extern void _mesa_sse2_convert_ubyte_norm( GLfloat *dst, const GLubyte *src,
+                                           GLuint stride, GLuint size,
+                                           GLuint count );
+
+extern void _mesa_sse2_convert_short( GLfloat *dst, const GLubyte *src,
+                                      GLuint stride, GLuint size,
+                                      GLuint count, GLboolean normalized );
+
+extern GLuint _mesa_sse2_reduce_ubyte_row( GLuint comps, const GLubyte *rowA,
+                                           const GLubyte *rowB,
+                                           GLuint dstWidth, GLubyte *dst );
+
+extern GLuint _mesa_sse2_reduce_float_row( GLuint comps, const GLfloat *rowA,
+                                           const GLfloat *rowB,
+                                           GLuint dstWidth, GLfloat *dst );
+
+extern GLuint _mesa_sse2_nearest_colors( const GLubyte *texels, GLuint n,
+                                         const GLubyte *palette, GLuint np,
+                                         GLubyte *index );
+
+extern GLuint _mesa_sse2_unpack_ushort_rgba( GLuint n, const GLushort *src,
+                                             GLboolean swap,
+                                             const GLuint shift[4],
+                                             const GLuint bits[4],
+                                             GLubyte *dst );
+
+extern GLuint _mesa_sse2_pack_ushort_rgba( GLuint n, const GLubyte *src,
+                                           const GLuint shift[4],
+                                           const GLuint bits[4],
+                                           GLboolean swap, GLushort *dst );
+
+extern GLuint _mesa_sse2_swizzle_ubyte4( GLuint n, const GLubyte *src,
+                                         const GLuint map[4], GLubyte *dst );
+
+
+/* Flags for the SoA lighting functions.
+ */
+#define X86_64_LIGHT_TWOSIDE	0x1	/**< light front and back colors */
+#define X86_64_LIGHT_SPEC	0x2	/**< separate specular color */
+#define X86_64_LIGHT_INFINITE	0x4	/**< infinite lights only, as in
+					 *   light_fast_rgba() */
+
+typedef void (*x86_64_light_func)( GLcontext *ctx,
+                                   const GLfloat *vertex, GLuint vstride,
+                                   const GLfloat *normal, GLuint nstride,
+                                   GLuint count,
+                                   GLfloat (*color[2])[4],
+                                   GLfloat (*secondary[2])[4],
+                                   GLuint flags );
+
+/** The SoA lighting function for tnl/t_vb_light.c, NULL if none. */
+extern x86_64_light_func _mesa_x86_64_light_rgba;
+
+extern void _mesa_sse2_light_rgba( GLcontext *ctx,
+                                   const GLfloat *vertex, GLuint vstride,
+                                   const GLfloat *normal, GLuint nstride,
+                                   GLuint count,
+                                   GLfloat (*color[2])[4],
+                                   GLfloat (*secondary[2])[4],
+                                   GLuint flags );
+
+#ifdef USE_X86_64_AVX2
+extern void _mesa_avx2_light_rgba( GLcontext *ctx,
+                                   const GLfloat *vertex, GLuint vstride,
+                                   const GLfloat *normal, GLuint nstride,
+                                   GLuint count,
+                                   GLfloat (*color[2])[4],
+                                   GLfloat (*secondary[2])[4],
+                                   GLuint flags );
+#endif
+
 #endif
@@ -103,4 +103,38 @@ extern void _ASMAPI _mesa_##pfx##_transform_normalize_normals_no_rot( NORM_ARGS
       _mesa_##pfx##_transform_normalize_normals_no_rot;
 
 
+/* =============================================================
+ * Clip test function declarations:
+ */
+
+#define CLIP_ARGS	GLvector4f *clip_vec,				\
+			GLvector4f *proj_vec,				\
+			GLubyte clipMask[],				\
+			GLubyte *orMask,				\
+			GLubyte *andMask
+
+#define DECLARE_CLIP_GROUP( pfx ) \
+extern GLvector4f * _ASMAPI _mesa_##pfx##_cliptest_points4( CLIP_ARGS );	\
+extern GLvector4f * _ASMAPI _mesa_##pfx##_cliptest_np_points4( CLIP_ARGS );	\
+extern GLvector4f * _ASMAPI _mesa_##pfx##_cliptest_points3( CLIP_ARGS );	\
+extern GLvector4f * _ASMAPI _mesa_##pfx##_cliptest_points2( CLIP_ARGS );
+
+#define ASSIGN_CLIP_GROUP( pfx )					\
+   _mesa_clip_tab[4] = _mesa_##pfx##_cliptest_points4;			\
+   _mesa_clip_tab[3] = _mesa_##pfx##_cliptest_points3;			\
+   _mesa_clip_tab[2] = _mesa_##pfx##_cliptest_points2;			\
+   _mesa_clip_np_tab[4] = _mesa_##pfx##_cliptest_np_points4;		\
+   _mesa_clip_np_tab[3] = _mesa_##pfx##_cliptest_points3;		\
+   _mesa_clip_np_tab[2] = _mesa_##pfx##_cliptest_points2;
+
+#define CLIP_GB_ARGS	CLIP_ARGS,					\
+			const GLfloat guard[2]
+
+#define DECLARE_CLIP_GB_GROUP( pfx ) \
+extern GLvector4f * _ASMAPI _mesa_##pfx##_cliptest_gb_points4( CLIP_GB_ARGS );
+
+#define ASSIGN_CLIP_GB_GROUP( pfx )					\
+   _mesa_clip_gb_tab[4] = _mesa_##pfx##_cliptest_gb_points4;
+
+
 #endif